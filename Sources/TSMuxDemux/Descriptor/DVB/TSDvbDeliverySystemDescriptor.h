@@ -0,0 +1,66 @@
+//
+//  TSDvbDeliverySystemDescriptor.h
+//  TSMuxDemux
+//
+//  DVB delivery system descriptors (EN 300 468 6.2.13): where and how a transport stream is broadcast.
+//
+
+#import <Foundation/Foundation.h>
+#import "../TSDescriptor.h"
+
+/// Common base of the satellite, cable and terrestrial delivery system descriptors.
+@interface TSDvbDeliverySystemDescriptor: TSDescriptor
+@property(nonatomic, readonly) uint64_t frequencyHz;
+@end
+
+/// satellite_delivery_system_descriptor (tag 0x43).
+@interface TSDvbSatelliteDeliverySystemDescriptor: TSDvbDeliverySystemDescriptor
+/// In tenths of a degree, e.g. 192 for 19.2°.
+@property(nonatomic, readonly) uint16_t orbitalPosition;
+@property(nonatomic, readonly) BOOL isEastPosition;
+/// 0: linear horizontal, 1: linear vertical, 2: circular left, 3: circular right.
+@property(nonatomic, readonly) uint8_t polarization;
+/// NO for DVB-S, YES for DVB-S2.
+@property(nonatomic, readonly) BOOL isS2;
+/// 0: auto, 1: QPSK, 2: 8PSK, 3: 16-QAM.
+@property(nonatomic, readonly) uint8_t modulationType;
+@property(nonatomic, readonly) uint32_t symbolRate;
+@property(nonatomic, readonly) uint8_t fecInner;
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData * _Nullable)payload
+                              length:(NSUInteger)length;
+@end
+
+/// cable_delivery_system_descriptor (tag 0x44).
+@interface TSDvbCableDeliverySystemDescriptor: TSDvbDeliverySystemDescriptor
+@property(nonatomic, readonly) uint8_t fecOuter;
+/// 1: 16-QAM, 2: 32-QAM, 3: 64-QAM, 4: 128-QAM, 5: 256-QAM.
+@property(nonatomic, readonly) uint8_t modulation;
+@property(nonatomic, readonly) uint32_t symbolRate;
+@property(nonatomic, readonly) uint8_t fecInner;
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData * _Nullable)payload
+                              length:(NSUInteger)length;
+@end
+
+/// terrestrial_delivery_system_descriptor (tag 0x5A).
+@interface TSDvbTerrestrialDeliverySystemDescriptor: TSDvbDeliverySystemDescriptor
+/// 0: 8 MHz, 1: 7 MHz, 2: 6 MHz, 3: 5 MHz.
+@property(nonatomic, readonly) uint8_t bandwidth;
+/// 0: QPSK, 1: 16-QAM, 2: 64-QAM.
+@property(nonatomic, readonly) uint8_t constellation;
+@property(nonatomic, readonly) uint8_t hierarchyInformation;
+@property(nonatomic, readonly) uint8_t codeRateHpStream;
+@property(nonatomic, readonly) uint8_t codeRateLpStream;
+/// 0: 1/32, 1: 1/16, 2: 1/8, 3: 1/4.
+@property(nonatomic, readonly) uint8_t guardInterval;
+/// 0: 2k, 1: 8k, 2: 4k.
+@property(nonatomic, readonly) uint8_t transmissionMode;
+@property(nonatomic, readonly) BOOL otherFrequencyFlag;
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData * _Nullable)payload
+                              length:(NSUInteger)length;
+@end
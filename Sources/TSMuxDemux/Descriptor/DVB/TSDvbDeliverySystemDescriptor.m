@@ -0,0 +1,179 @@
+//
+//  TSDvbDeliverySystemDescriptor.m
+//  TSMuxDemux
+//
+//  DVB delivery system descriptors (EN 300 468 6.2.13): where and how a transport stream is broadcast.
+//
+
+#import "TSDvbDeliverySystemDescriptor.h"
+#import "../../TSLog.h"
+
+#define SATELLITE_DELIVERY_SYSTEM_LENGTH 11
+#define CABLE_DELIVERY_SYSTEM_LENGTH 11
+#define TERRESTRIAL_DELIVERY_SYSTEM_LENGTH 11
+
+/// Decodes `digitCount` BCD digits starting at the high nibble of `bytes`. Returns NO if a nibble is not a digit.
+static inline BOOL bcdValue(const uint8_t *bytes, NSUInteger digitCount, uint64_t *outValue)
+{
+    uint64_t value = 0;
+    for (NSUInteger i = 0; i < digitCount; ++i) {
+        const uint8_t digit = (i % 2 == 0) ? (bytes[i / 2] >> 4) : (bytes[i / 2] & 0x0F);
+        if (digit > 9) {
+            return NO;
+        }
+        value = value * 10 + digit;
+    }
+    *outValue = value;
+    return YES;
+}
+
+@interface TSDvbDeliverySystemDescriptor()
+@property(nonatomic, readwrite) uint64_t frequencyHz;
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData *)payload
+                              length:(NSUInteger)length
+                      requiredLength:(NSUInteger)requiredLength;
+@end
+
+@implementation TSDvbDeliverySystemDescriptor
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData *)payload
+                              length:(NSUInteger)length
+                      requiredLength:(NSUInteger)requiredLength
+{
+    self = [super initWithTag:tag length:length];
+    if (self) {
+        if (length < requiredLength || payload.length < requiredLength) {
+            TSLogWarn(@"DVB delivery system descriptor 0x%02x truncated: %lu bytes, expected %lu",
+                      tag, (unsigned long)MIN(length, payload.length), (unsigned long)requiredLength);
+            return nil;
+        }
+    }
+    return self;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if ([self class] != [object class]) {
+        return NO;
+    }
+    return [super isEqual:object] && self.frequencyHz == ((TSDvbDeliverySystemDescriptor*)object).frequencyHz;
+}
+
+-(NSUInteger)hash
+{
+    return [super hash] ^ (NSUInteger)self.frequencyHz;
+}
+
+-(NSString*)description
+{
+    return [self tagDescription];
+}
+
+@end
+
+@implementation TSDvbSatelliteDeliverySystemDescriptor
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData *)payload
+                              length:(NSUInteger)length
+{
+    self = [super initWithTag:tag payload:payload length:length requiredLength:SATELLITE_DELIVERY_SYSTEM_LENGTH];
+    if (self) {
+        const uint8_t *bytes = payload.bytes;
+        uint64_t frequency = 0, orbitalPosition = 0, symbolRate = 0;
+        // Frequency: 8 digits in GHz with the decimal point after the third, i.e. units of 10 kHz.
+        // Symbol rate: 7 digits in Msymbol/s with the decimal point after the third, i.e. units of 100 symbol/s.
+        if (!bcdValue(bytes, 8, &frequency) || !bcdValue(bytes + 4, 4, &orbitalPosition)
+            || !bcdValue(bytes + 7, 7, &symbolRate)) {
+            TSLogWarn(@"DVB satellite delivery system descriptor has invalid BCD");
+            return nil;
+        }
+        self.frequencyHz = frequency * 10000;
+        _orbitalPosition = (uint16_t)orbitalPosition;
+        _isEastPosition = (bytes[6] >> 7) & 0x01;
+        _polarization = (bytes[6] >> 5) & 0x03;
+        _isS2 = (bytes[6] >> 2) & 0x01;
+        _modulationType = bytes[6] & 0x03;
+        _symbolRate = (uint32_t)symbolRate * 100;
+        _fecInner = bytes[10] & 0x0F;
+    }
+    return self;
+}
+
+-(NSString*)tagDescription
+{
+    return [NSString stringWithFormat:@"Satellite: %.2f MHz, %u.%u°%@, %u sym/s",
+            self.frequencyHz / 1e6, self.orbitalPosition / 10, self.orbitalPosition % 10,
+            self.isEastPosition ? @"E" : @"W", self.symbolRate];
+}
+
+@end
+
+@implementation TSDvbCableDeliverySystemDescriptor
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData *)payload
+                              length:(NSUInteger)length
+{
+    self = [super initWithTag:tag payload:payload length:length requiredLength:CABLE_DELIVERY_SYSTEM_LENGTH];
+    if (self) {
+        const uint8_t *bytes = payload.bytes;
+        uint64_t frequency = 0, symbolRate = 0;
+        // Frequency: 8 digits in MHz with the decimal point after the fourth, i.e. units of 100 Hz.
+        if (!bcdValue(bytes, 8, &frequency) || !bcdValue(bytes + 7, 7, &symbolRate)) {
+            TSLogWarn(@"DVB cable delivery system descriptor has invalid BCD");
+            return nil;
+        }
+        self.frequencyHz = frequency * 100;
+        _fecOuter = bytes[5] & 0x0F;
+        _modulation = bytes[6];
+        _symbolRate = (uint32_t)symbolRate * 100;
+        _fecInner = bytes[10] & 0x0F;
+    }
+    return self;
+}
+
+-(NSString*)tagDescription
+{
+    return [NSString stringWithFormat:@"Cable: %.1f MHz, modulation %u, %u sym/s",
+            self.frequencyHz / 1e6, self.modulation, self.symbolRate];
+}
+
+@end
+
+@implementation TSDvbTerrestrialDeliverySystemDescriptor
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData *)payload
+                              length:(NSUInteger)length
+{
+    self = [super initWithTag:tag payload:payload length:length requiredLength:TERRESTRIAL_DELIVERY_SYSTEM_LENGTH];
+    if (self) {
+        const uint8_t *bytes = payload.bytes;
+        // centre_frequency is binary, in units of 10 Hz
+        const uint32_t centreFrequency = ((uint32_t)bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+        self.frequencyHz = (uint64_t)centreFrequency * 10;
+        _bandwidth = (bytes[4] >> 5) & 0x07;
+        _constellation = (bytes[5] >> 6) & 0x03;
+        _hierarchyInformation = (bytes[5] >> 3) & 0x07;
+        _codeRateHpStream = bytes[5] & 0x07;
+        _codeRateLpStream = (bytes[6] >> 5) & 0x07;
+        _guardInterval = (bytes[6] >> 3) & 0x03;
+        _transmissionMode = (bytes[6] >> 1) & 0x03;
+        _otherFrequencyFlag = bytes[6] & 0x01;
+    }
+    return self;
+}
+
+-(NSString*)tagDescription
+{
+    return [NSString stringWithFormat:@"Terrestrial: %.3f MHz, bandwidth %u, constellation %u",
+            self.frequencyHz / 1e6, self.bandwidth, self.constellation];
+}
+
+@end
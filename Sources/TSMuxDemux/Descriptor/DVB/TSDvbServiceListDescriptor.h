@@ -0,0 +1,25 @@
+//
+//  TSDvbServiceListDescriptor.h
+//  TSMuxDemux
+//
+//  DVB service_list_descriptor (EN 300 468 6.2.35): the services of a transport stream, as listed in the NIT.
+//
+
+#import <Foundation/Foundation.h>
+#import "../TSDescriptor.h"
+
+@interface TSDvbServiceListEntry : NSObject
+@property(nonatomic, readonly) uint16_t serviceId;
+/// See TSDvbServiceDescriptorServiceType.
+@property(nonatomic, readonly) uint8_t serviceType;
+@end
+
+@interface TSDvbServiceListDescriptor: TSDescriptor
+
+@property(nonatomic, readonly, nonnull) NSArray<TSDvbServiceListEntry*> *services;
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData * _Nullable)payload
+                              length:(NSUInteger)length;
+
+@end
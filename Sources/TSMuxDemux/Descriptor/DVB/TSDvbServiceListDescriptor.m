@@ -0,0 +1,113 @@
+//
+//  TSDvbServiceListDescriptor.m
+//  TSMuxDemux
+//
+//  DVB service_list_descriptor (EN 300 468 6.2.35): the services of a transport stream, as listed in the NIT.
+//
+
+#import "TSDvbServiceListDescriptor.h"
+#import "../../TSLog.h"
+
+// service_id:2 + service_type:1
+#define SERVICE_LIST_ENTRY_LENGTH 3
+
+@interface TSDvbServiceListEntry()
+-(instancetype)initWithServiceId:(uint16_t)serviceId serviceType:(uint8_t)serviceType;
+@end
+
+@implementation TSDvbServiceListEntry
+
+-(instancetype)initWithServiceId:(uint16_t)serviceId serviceType:(uint8_t)serviceType
+{
+    self = [super init];
+    if (self) {
+        _serviceId = serviceId;
+        _serviceType = serviceType;
+    }
+    return self;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[TSDvbServiceListEntry class]]) {
+        return NO;
+    }
+    TSDvbServiceListEntry *other = (TSDvbServiceListEntry*)object;
+    return self.serviceId == other.serviceId && self.serviceType == other.serviceType;
+}
+
+-(NSUInteger)hash
+{
+    return self.serviceId ^ (self.serviceType << 16);
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ serviceId: %hu, type: 0x%02x }", self.serviceId, self.serviceType];
+}
+
+@end
+
+@implementation TSDvbServiceListDescriptor
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData *)payload
+                              length:(NSUInteger)length
+{
+    self = [super initWithTag:tag length:length];
+    if (self) {
+        if (length > 0 && payload.length < length) {
+            TSLogWarn(@"DVB service list descriptor truncated: %lu of %lu bytes",
+                      (unsigned long)payload.length, (unsigned long)length);
+            return nil;
+        }
+        if (length % SERVICE_LIST_ENTRY_LENGTH != 0) {
+            TSLogWarn(@"DVB service list descriptor length %lu is not a multiple of %d",
+                      (unsigned long)length, SERVICE_LIST_ENTRY_LENGTH);
+        }
+        const uint8_t *bytes = payload.bytes;
+        const NSUInteger count = length / SERVICE_LIST_ENTRY_LENGTH;
+        NSMutableArray<TSDvbServiceListEntry*> *services = [NSMutableArray arrayWithCapacity:count];
+        for (NSUInteger i = 0; i < count; ++i) {
+            const uint8_t *entry = bytes + i * SERVICE_LIST_ENTRY_LENGTH;
+            [services addObject:[[TSDvbServiceListEntry alloc] initWithServiceId:(entry[0] << 8) | entry[1]
+                                                                     serviceType:entry[2]]];
+        }
+        _services = services;
+    }
+    return self;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if ([self class] != [object class]) {
+        return NO;
+    }
+    if (![super isEqual:object]) {
+        return NO;
+    }
+    return [self.services isEqualToArray:((TSDvbServiceListDescriptor*)object).services];
+}
+
+-(NSUInteger)hash
+{
+    return [super hash] ^ self.services.count;
+}
+
+-(NSString*)description
+{
+    return [self tagDescription];
+}
+
+-(NSString*)tagDescription
+{
+    return [NSString stringWithFormat:@"Service list: %lu services", (unsigned long)self.services.count];
+}
+
+@end
@@ -0,0 +1,23 @@
+//
+//  TSDvbShortEventDescriptor.h
+//  TSMuxDemux
+//
+//  DVB short_event_descriptor (EN 300 468 6.2.37): event name and a short description.
+//
+
+#import <Foundation/Foundation.h>
+#import "../TSDescriptor.h"
+
+@interface TSDvbShortEventDescriptor: TSDescriptor
+
+/// ISO 639-2 language code of the name and text, e.g. "eng".
+@property(nonatomic, readonly, nonnull) NSString *languageCode;
+/// Encoded as described in EN 300 468 Annex A. Decode with TSStringEncodingUtil.
+@property(nonatomic, readonly, nullable) NSData *eventName;
+@property(nonatomic, readonly, nullable) NSData *text;
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData * _Nullable)payload
+                              length:(NSUInteger)length;
+
+@end
@@ -0,0 +1,89 @@
+//
+//  TSDvbShortEventDescriptor.m
+//  TSMuxDemux
+//
+//  DVB short_event_descriptor (EN 300 468 6.2.37): event name and a short description.
+//
+
+#import "TSDvbShortEventDescriptor.h"
+#import "../../TSStringEncodingUtil.h"
+#import "../../TSLog.h"
+#import "../../TSBitReader.h"
+
+@implementation TSDvbShortEventDescriptor
+
+-(instancetype _Nullable)initWithTag:(uint8_t)tag
+                             payload:(NSData *)payload
+                              length:(NSUInteger)length
+{
+    self = [super initWithTag:tag length:length];
+    if (self) {
+        if (!payload.length || length == 0) {
+            TSLogWarn(@"Received DVB short event descriptor with no payload");
+            return nil;
+        }
+        TSBitReader reader = TSBitReaderMake(payload);
+
+        NSData *languageCode = TSBitReaderReadData(&reader, 3);
+        if (reader.error) {
+            TSLogWarn(@"DVB short event descriptor truncated: missing ISO_639_language_code");
+            return nil;
+        }
+        _languageCode = [[NSString alloc] initWithData:languageCode encoding:NSISOLatin1StringEncoding] ?: @"???";
+
+        uint8_t eventNameLength = TSBitReaderReadUInt8(&reader);
+        if (eventNameLength > 0) {
+            _eventName = TSBitReaderReadData(&reader, eventNameLength);
+        }
+        if (reader.error) {
+            TSLogWarn(@"DVB short event descriptor truncated: event_name needs %u bytes", eventNameLength);
+            return nil;
+        }
+
+        uint8_t textLength = TSBitReaderReadUInt8(&reader);
+        if (textLength > 0) {
+            _text = TSBitReaderReadData(&reader, textLength);
+        }
+        if (reader.error) {
+            TSLogWarn(@"DVB short event descriptor truncated: text needs %u bytes", textLength);
+            return nil;
+        }
+    }
+    return self;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if ([self class] != [object class]) {
+        return NO;
+    }
+    if (![super isEqual:object]) {
+        return NO;
+    }
+    TSDvbShortEventDescriptor *other = (TSDvbShortEventDescriptor*)object;
+    return [self.languageCode isEqualToString:other.languageCode]
+        && (self.eventName == other.eventName || [self.eventName isEqual:other.eventName])
+        && (self.text == other.text || [self.text isEqual:other.text]);
+}
+
+-(NSUInteger)hash
+{
+    return [super hash] ^ self.languageCode.hash ^ self.eventName.hash;
+}
+
+-(NSString*)description
+{
+    return [self tagDescription];
+}
+
+-(NSString*)tagDescription
+{
+    return [NSString stringWithFormat:@"%@: %@",
+            self.languageCode,
+            [TSStringEncodingUtil dvbStringFromCharData:self.eventName]];
+}
+
+@end
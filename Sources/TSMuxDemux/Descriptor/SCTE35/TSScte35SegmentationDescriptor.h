@@ -0,0 +1,96 @@
+//
+//  TSScte35SegmentationDescriptor.h
+//  TSMuxDemux
+//
+//  ANSI/SCTE 35 segmentation_descriptor() (10.3.3), carried in the descriptor loop of a
+//  splice_info_section.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreMedia/CoreMedia.h>
+
+/// splice_descriptor_tag values (SCTE 35 Table 16). Splice descriptors have their own tag space,
+/// separate from the PSI descriptors (see TSDescriptor).
+typedef NS_ENUM(uint8_t, TSScte35SpliceDescriptorTag) {
+    TSScte35SpliceDescriptorTagAvail                    = 0x00,
+    TSScte35SpliceDescriptorTagDtmf                     = 0x01,
+    TSScte35SpliceDescriptorTagSegmentation             = 0x02,
+    TSScte35SpliceDescriptorTagTime                     = 0x03,
+    TSScte35SpliceDescriptorTagAudio                    = 0x04,
+};
+
+/// segmentation_type_id values (SCTE 35 Table 23), the most common ones.
+typedef NS_ENUM(uint8_t, TSScte35SegmentationType) {
+    TSScte35SegmentationTypeNotIndicated                            = 0x00,
+    TSScte35SegmentationTypeContentIdentification                   = 0x01,
+    TSScte35SegmentationTypeProgramStart                            = 0x10,
+    TSScte35SegmentationTypeProgramEnd                              = 0x11,
+    TSScte35SegmentationTypeProgramEarlyTermination                 = 0x12,
+    TSScte35SegmentationTypeProgramBreakaway                        = 0x13,
+    TSScte35SegmentationTypeProgramResumption                       = 0x14,
+    TSScte35SegmentationTypeChapterStart                            = 0x20,
+    TSScte35SegmentationTypeChapterEnd                              = 0x21,
+    TSScte35SegmentationTypeBreakStart                              = 0x22,
+    TSScte35SegmentationTypeBreakEnd                                = 0x23,
+    TSScte35SegmentationTypeProviderAdvertisementStart              = 0x30,
+    TSScte35SegmentationTypeProviderAdvertisementEnd                = 0x31,
+    TSScte35SegmentationTypeDistributorAdvertisementStart           = 0x32,
+    TSScte35SegmentationTypeDistributorAdvertisementEnd             = 0x33,
+    TSScte35SegmentationTypeProviderPlacementOpportunityStart       = 0x34,
+    TSScte35SegmentationTypeProviderPlacementOpportunityEnd         = 0x35,
+    TSScte35SegmentationTypeDistributorPlacementOpportunityStart    = 0x36,
+    TSScte35SegmentationTypeDistributorPlacementOpportunityEnd      = 0x37,
+    TSScte35SegmentationTypeProviderOverlayPlacementOpportunityStart    = 0x38,
+    TSScte35SegmentationTypeProviderOverlayPlacementOpportunityEnd      = 0x39,
+    TSScte35SegmentationTypeDistributorOverlayPlacementOpportunityStart = 0x3A,
+    TSScte35SegmentationTypeDistributorOverlayPlacementOpportunityEnd   = 0x3B,
+};
+
+/// Marks the start or end of a segment (program, chapter, break, placement opportunity...), with the
+/// identifier (UPID) of its content.
+@interface TSScte35SegmentationDescriptor : NSObject
+
+@property(nonatomic, readonly) uint32_t segmentationEventId;
+/// YES if a previously sent event with this id is cancelled; no other field is then set.
+@property(nonatomic, readonly) BOOL isCancel;
+/// YES if the whole program is segmented; otherwise only the components in `componentTags`.
+@property(nonatomic, readonly) BOOL isProgramSegmentation;
+@property(nonatomic, readonly, nonnull) NSArray<NSNumber*> *componentTags;
+/// Duration of the segment (90 kHz), or kCMTimeInvalid if not signalled.
+@property(nonatomic, readonly) CMTime segmentationDuration;
+
+/// Delivery restrictions; when `isDeliveryNotRestricted`, the other four are not signalled.
+@property(nonatomic, readonly) BOOL isDeliveryNotRestricted;
+@property(nonatomic, readonly) BOOL webDeliveryAllowed;
+@property(nonatomic, readonly) BOOL noRegionalBlackout;
+@property(nonatomic, readonly) BOOL archiveAllowed;
+@property(nonatomic, readonly) uint8_t deviceRestrictions;
+
+/// segmentation_upid_type and the UPID bytes (e.g. an ADI or EIDR identifier), empty if none.
+@property(nonatomic, readonly) uint8_t upidType;
+@property(nonatomic, readonly, nonnull) NSData *upid;
+
+/// A TSScte35SegmentationType (or another value of SCTE 35 Table 23).
+@property(nonatomic, readonly) uint8_t segmentationTypeId;
+@property(nonatomic, readonly) uint8_t segmentNum;
+@property(nonatomic, readonly) uint8_t segmentsExpected;
+/// Placement opportunity starts only, when present; otherwise 0.
+@property(nonatomic, readonly) uint8_t subSegmentNum;
+@property(nonatomic, readonly) uint8_t subSegmentsExpected;
+
+/// A complete segmentation_descriptor() (tag and length included), for the `spliceDescriptors` of a
+/// muxed splice_info_section: a program segmentation without delivery restrictions. The duration
+/// (90 kHz) is only signalled when > 0. `upid` is cut to fit the 255-byte descriptor.
++(NSData * _Nonnull)makeDescriptorWithEventId:(uint32_t)segmentationEventId
+                           segmentationTypeId:(uint8_t)segmentationTypeId
+                                     duration:(uint64_t)duration
+                                     upidType:(uint8_t)upidType
+                                         upid:(NSData * _Nullable)upid
+                                   segmentNum:(uint8_t)segmentNum
+                             segmentsExpected:(uint8_t)segmentsExpected;
+
+/// `bytes` are the descriptor after splice_descriptor_tag and descriptor_length, starting with
+/// the "CUEI" identifier. Returns nil if truncated or of another identifier.
+-(instancetype _Nullable)initWithBytes:(const uint8_t * _Nonnull)bytes length:(NSUInteger)length;
+
+@end
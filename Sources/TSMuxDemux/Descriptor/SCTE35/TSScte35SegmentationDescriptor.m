@@ -0,0 +1,154 @@
+//
+//  TSScte35SegmentationDescriptor.m
+//  TSMuxDemux
+//
+//  ANSI/SCTE 35 segmentation_descriptor() (10.3.3).
+//
+
+#import "TSScte35SegmentationDescriptor.h"
+#import "../../TSBitReader.h"
+#import "../../TSLog.h"
+
+// "CUEI": the identifier of the splice descriptors defined by SCTE 35
+#define SCTE35_SPLICE_DESCRIPTOR_IDENTIFIER 0x43554549
+
+@implementation TSScte35SegmentationDescriptor
+
+/// The placement opportunity starts carry sub_segment_num and sub_segments_expected.
+static inline BOOL hasSubSegments(uint8_t segmentationTypeId)
+{
+    return segmentationTypeId == TSScte35SegmentationTypeProviderPlacementOpportunityStart
+        || segmentationTypeId == TSScte35SegmentationTypeDistributorPlacementOpportunityStart
+        || segmentationTypeId == TSScte35SegmentationTypeProviderOverlayPlacementOpportunityStart
+        || segmentationTypeId == TSScte35SegmentationTypeDistributorOverlayPlacementOpportunityStart;
+}
+
++(NSData * _Nonnull)makeDescriptorWithEventId:(uint32_t)segmentationEventId
+                           segmentationTypeId:(uint8_t)segmentationTypeId
+                                     duration:(uint64_t)duration
+                                     upidType:(uint8_t)upidType
+                                         upid:(NSData * _Nullable)upid
+                                   segmentNum:(uint8_t)segmentNum
+                             segmentsExpected:(uint8_t)segmentsExpected
+{
+    const BOOL hasDuration = duration > 0;
+    const BOOL hasSubSegmentFields = hasSubSegments(segmentationTypeId);
+    const NSUInteger lengthWithoutUpid = 4 + 4 + 1 + 1 + (hasDuration ? 5 : 0) + 2 + 3 + (hasSubSegmentFields ? 2 : 0);
+    const uint8_t upidLength = (uint8_t)MIN(upid.length, UINT8_MAX - lengthWithoutUpid);
+    const NSUInteger length = lengthWithoutUpid + upidLength;
+
+    NSMutableData *descriptor = [NSMutableData dataWithCapacity:2 + length];
+    const uint8_t header[] = {
+        TSScte35SpliceDescriptorTagSegmentation,
+        (uint8_t)length,
+        (SCTE35_SPLICE_DESCRIPTOR_IDENTIFIER >> 24) & 0xFF,
+        (SCTE35_SPLICE_DESCRIPTOR_IDENTIFIER >> 16) & 0xFF,
+        (SCTE35_SPLICE_DESCRIPTOR_IDENTIFIER >> 8) & 0xFF,
+        SCTE35_SPLICE_DESCRIPTOR_IDENTIFIER & 0xFF,
+        (segmentationEventId >> 24) & 0xFF,
+        (segmentationEventId >> 16) & 0xFF,
+        (segmentationEventId >> 8) & 0xFF,
+        segmentationEventId & 0xFF,
+        // segmentation_event_cancel_indicator = '0', segmentation_event_id_compliance_indicator = '1', reserved
+        0x7F,
+        // program_segmentation_flag = '1', segmentation_duration_flag, delivery_not_restricted_flag = '1', reserved
+        0x80 | (hasDuration ? 0x40 : 0x00) | 0x20 | 0x1F,
+    };
+    [descriptor appendBytes:header length:sizeof(header)];
+    if (hasDuration) {
+        const uint8_t durationBytes[] = {
+            (duration >> 32) & 0xFF, (duration >> 24) & 0xFF, (duration >> 16) & 0xFF, (duration >> 8) & 0xFF, duration & 0xFF,
+        };
+        [descriptor appendBytes:durationBytes length:sizeof(durationBytes)];
+    }
+    const uint8_t upidHeader[] = { upidType, upidLength };
+    [descriptor appendBytes:upidHeader length:sizeof(upidHeader)];
+    if (upidLength > 0) {
+        [descriptor appendBytes:upid.bytes length:upidLength];
+    }
+    const uint8_t segment[] = { segmentationTypeId, segmentNum, segmentsExpected };
+    [descriptor appendBytes:segment length:sizeof(segment)];
+    if (hasSubSegmentFields) {
+        // sub_segment_num, sub_segments_expected: not used
+        const uint8_t subSegment[] = { 0x00, 0x00 };
+        [descriptor appendBytes:subSegment length:sizeof(subSegment)];
+    }
+    return descriptor;
+}
+
+-(instancetype _Nullable)initWithBytes:(const uint8_t *)bytes length:(NSUInteger)length
+{
+    TSBitReader reader = TSBitReaderMakeWithBytes(bytes, length);
+    if (TSBitReaderReadUInt32BE(&reader) != SCTE35_SPLICE_DESCRIPTOR_IDENTIFIER) {
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _componentTags = @[];
+        _segmentationDuration = kCMTimeInvalid;
+        _upid = [NSData data];
+
+        _segmentationEventId = TSBitReaderReadUInt32BE(&reader);
+        _isCancel = TSBitReaderReadBits(&reader, 1);
+        TSBitReaderSkipBits(&reader, 7);  // segmentation_event_id_compliance_indicator, reserved
+        if (!_isCancel) {
+            _isProgramSegmentation = TSBitReaderReadBits(&reader, 1);
+            const BOOL hasDuration = TSBitReaderReadBits(&reader, 1);
+            _isDeliveryNotRestricted = TSBitReaderReadBits(&reader, 1);
+            if (_isDeliveryNotRestricted) {
+                TSBitReaderSkipBits(&reader, 5);
+            } else {
+                _webDeliveryAllowed = TSBitReaderReadBits(&reader, 1);
+                _noRegionalBlackout = TSBitReaderReadBits(&reader, 1);
+                _archiveAllowed = TSBitReaderReadBits(&reader, 1);
+                _deviceRestrictions = TSBitReaderReadBits(&reader, 2);
+            }
+
+            if (!_isProgramSegmentation) {
+                const uint8_t componentCount = TSBitReaderReadUInt8(&reader);
+                NSMutableArray<NSNumber*> *componentTags = [NSMutableArray arrayWithCapacity:componentCount];
+                for (uint8_t i = 0; i < componentCount && !reader.error; i++) {
+                    [componentTags addObject:@(TSBitReaderReadUInt8(&reader))];
+                    TSBitReaderSkip(&reader, 5);  // reserved, pts_offset
+                }
+                _componentTags = componentTags;
+            }
+            if (hasDuration) {
+                const uint64_t high = TSBitReaderReadUInt8(&reader);
+                const uint64_t duration = (high << 32) | TSBitReaderReadUInt32BE(&reader);
+                _segmentationDuration = CMTimeMake((int64_t)duration, 90000);
+            }
+
+            _upidType = TSBitReaderReadUInt8(&reader);
+            const uint8_t upidLength = TSBitReaderReadUInt8(&reader);
+            _upid = [TSBitReaderReadData(&reader, upidLength) copy] ?: [NSData data];
+            _segmentationTypeId = TSBitReaderReadUInt8(&reader);
+            _segmentNum = TSBitReaderReadUInt8(&reader);
+            _segmentsExpected = TSBitReaderReadUInt8(&reader);
+            // Absent in streams following SCTE 35 versions before 2016
+            if (hasSubSegments(_segmentationTypeId) && TSBitReaderRemainingBytes(&reader) >= 2) {
+                _subSegmentNum = TSBitReaderReadUInt8(&reader);
+                _subSegmentsExpected = TSBitReaderReadUInt8(&reader);
+            }
+        }
+        if (reader.error) {
+            TSLogWarn(@"Received truncated SCTE-35 segmentation descriptor");
+            return nil;
+        }
+    }
+    return self;
+}
+
+-(NSString*)description
+{
+    if (self.isCancel) {
+        return [NSString stringWithFormat:@"{ segmentation event %u cancelled }", self.segmentationEventId];
+    }
+    return [NSString stringWithFormat:@"{ segmentation event %u, type: 0x%02X, segment %u/%u, duration: %.3f s, upid type: 0x%02X }",
+            self.segmentationEventId, self.segmentationTypeId, self.segmentNum, self.segmentsExpected,
+            CMTIME_IS_VALID(self.segmentationDuration) ? CMTimeGetSeconds(self.segmentationDuration) : 0.0,
+            self.upidType];
+}
+
+@end
@@ -184,6 +184,10 @@ typedef NS_ENUM(uint8_t, TSAtscDescriptorTag) {
                               length:(uint8_t)length
                                 data:(NSData * _Nullable)payload;
 
+/// Decodes a descriptor loop (tag, length, payload, ...). Stops at the first truncated descriptor.
++(NSArray<TSDescriptor*> * _Nonnull)descriptorsFromLoopBytes:(const uint8_t * _Nonnull)bytes
+                                                       length:(NSUInteger)length;
+
 -(instancetype _Nonnull)initWithTag:(uint8_t)tag
                              length:(uint8_t)length;
 
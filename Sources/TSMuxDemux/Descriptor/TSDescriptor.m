@@ -7,10 +7,15 @@
 //
 
 #import "TSDescriptor.h"
+#import "../TSBitReader.h"
+#import "../TSLog.h"
 
 #import "TSRegistrationDescriptor.h"
 #import "TSISO639LanguageDescriptor.h"
 #import "DVB/TSDvbServiceDescriptor.h"
+#import "DVB/TSDvbShortEventDescriptor.h"
+#import "DVB/TSDvbServiceListDescriptor.h"
+#import "DVB/TSDvbDeliverySystemDescriptor.h"
 #import "SCTE35/TSScte35CueIdentifierDescriptor.h"
 #import "ATSC/TSAtscServiceLocationDescriptor.h"
 
@@ -35,6 +40,21 @@
         case TSDvbDescriptorTagService:
             descriptorClass = [TSDvbServiceDescriptor class];
             break;
+        case TSDvbDescriptorTagShortEvent:
+            descriptorClass = [TSDvbShortEventDescriptor class];
+            break;
+        case TSDvbDescriptorTagServiceList:
+            descriptorClass = [TSDvbServiceListDescriptor class];
+            break;
+        case TSDvbDescriptorTagSatelliteDeliverySystem:
+            descriptorClass = [TSDvbSatelliteDeliverySystemDescriptor class];
+            break;
+        case TSDvbDescriptorTagCableDeliverySystem:
+            descriptorClass = [TSDvbCableDeliverySystemDescriptor class];
+            break;
+        case TSDvbDescriptorTagTerrestrialDeliverySystem:
+            descriptorClass = [TSDvbTerrestrialDeliverySystemDescriptor class];
+            break;
         case TSScte35DescriptorTagCueIdentifier:
             descriptorClass = [TSScte35CueIdentifierDescriptor class];
             break;
@@ -52,6 +72,36 @@
     return [[TSDescriptor alloc] initWithTag:tag length:length];
 }
 
++(NSArray<TSDescriptor*> * _Nonnull)descriptorsFromLoopBytes:(const uint8_t * _Nonnull)bytes
+                                                       length:(NSUInteger)length
+{
+    NSMutableArray<TSDescriptor*> *descriptors = [NSMutableArray array];
+    TSBitReader reader = TSBitReaderMakeWithBytes(bytes, length);
+
+    // Each descriptor requires at minimum 2 bytes (tag + length)
+    while (TSBitReaderRemainingBytes(&reader) >= 2) {
+        uint8_t descriptorTag = TSBitReaderReadUInt8(&reader);
+        uint8_t descriptorLength = TSBitReaderReadUInt8(&reader);
+
+        if (reader.error || TSBitReaderRemainingBytes(&reader) < descriptorLength) {
+            TSLogWarn(@"Descriptor 0x%02X truncated: need %u bytes, but only %lu available",
+                      descriptorTag, descriptorLength, (unsigned long)TSBitReaderRemainingBytes(&reader));
+            break;
+        }
+
+        NSData *descriptorPayload = descriptorLength > 0
+            ? TSBitReaderReadData(&reader, descriptorLength)
+            : nil;
+        TSDescriptor *descriptor = [TSDescriptor makeWithTag:descriptorTag
+                                                      length:descriptorLength
+                                                        data:descriptorPayload];
+        if (descriptor) {
+            [descriptors addObject:descriptor];
+        }
+    }
+    return descriptors;
+}
+
 -(instancetype)initWithTag:(uint8_t)tag
                     length:(uint8_t)length
 {
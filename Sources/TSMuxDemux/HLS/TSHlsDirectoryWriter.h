@@ -0,0 +1,30 @@
+//
+//  TSHlsDirectoryWriter.h
+//  TSMuxDemux
+//
+//  Publishes the output of a TSHlsSegmenter to a local directory.
+//
+
+#import <Foundation/Foundation.h>
+#import "TSHlsSegmenter.h"
+
+/// A TSHlsSegmenter delegate that writes segments, parts and the media playlist to a directory,
+/// e.g. one served by an HTTP server. Files are written on a serial queue, off the muxer's thread,
+/// in publication order: a segment or part is on disk before the playlist listing it is replaced
+/// (atomically). The file of a segment or part removed from the playlist is deleted once it has
+/// been available for its duration plus that of the playlist (RFC 8216 6.2.2), counted in media
+/// published since, which a live stream publishes in real time. Files still in that window when
+/// the segmenter finishes are kept.
+@interface TSHlsDirectoryWriter : NSObject <TSHlsSegmenterDelegate>
+
+@property(nonatomic, readonly, nonnull) NSURL *directoryURL;
+@property(nonatomic, readonly, nonnull) NSString *playlistName;
+
+/// Creates the directory if needed.
+-(instancetype _Nonnull)initWithDirectoryURL:(NSURL * _Nonnull)directoryURL
+                                playlistName:(NSString * _Nonnull)playlistName;
+
+/// Blocks until the writes queued so far are done.
+-(void)waitUntilWritten;
+
+@end
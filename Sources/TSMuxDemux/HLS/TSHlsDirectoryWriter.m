@@ -0,0 +1,136 @@
+//
+//  TSHlsDirectoryWriter.m
+//  TSMuxDemux
+//
+//  Publishes the output of a TSHlsSegmenter to a local directory.
+//
+
+#import "TSHlsDirectoryWriter.h"
+#import "../TSLog.h"
+
+#pragma mark - TSHlsExpiringFile
+
+/// The file of a segment or part removed from the playlist, kept while clients may still request it.
+@interface TSHlsExpiringFile : NSObject
+@property(nonatomic, copy, nonnull) NSString *name;
+/// Published duration, in seconds, from which the file can be deleted.
+@property(nonatomic) double expiry;
+@end
+
+@implementation TSHlsExpiringFile
+@end
+
+#pragma mark - TSHlsDirectoryWriter
+
+@implementation TSHlsDirectoryWriter
+{
+    dispatch_queue_t _queue;
+    // Media published so far, in seconds: the clock removed files expire on
+    double _publishedDuration;
+    NSMutableArray<TSHlsExpiringFile*> *_expiringFiles;
+}
+
+-(instancetype _Nonnull)initWithDirectoryURL:(NSURL * _Nonnull)directoryURL
+                                playlistName:(NSString * _Nonnull)playlistName
+{
+    self = [super init];
+    if (self) {
+        _directoryURL = directoryURL;
+        _playlistName = [playlistName copy];
+        _queue = dispatch_queue_create("TSHlsDirectoryWriter", DISPATCH_QUEUE_SERIAL);
+        _expiringFiles = [NSMutableArray array];
+
+        NSError *error = nil;
+        if (![[NSFileManager defaultManager] createDirectoryAtURL:directoryURL
+                                      withIntermediateDirectories:YES
+                                                       attributes:nil
+                                                            error:&error]) {
+            TSLogError(@"Failed to create HLS directory %@: %@", directoryURL.path, error);
+        }
+    }
+    return self;
+}
+
+-(void)waitUntilWritten
+{
+    dispatch_sync(_queue, ^{});
+}
+
+-(void)writeData:(NSData *)data name:(NSString *)name atomically:(BOOL)atomically
+{
+    NSURL *url = [self.directoryURL URLByAppendingPathComponent:name];
+    dispatch_async(_queue, ^{
+        NSError *error = nil;
+        if (![data writeToURL:url options:(atomically ? NSDataWritingAtomic : 0) error:&error]) {
+            TSLogError(@"Failed to write %@: %@", url.path, error);
+        }
+    });
+}
+
+-(void)removeFileWithName:(NSString *)name
+{
+    NSURL *url = [self.directoryURL URLByAppendingPathComponent:name];
+    dispatch_async(_queue, ^{
+        [[NSFileManager defaultManager] removeItemAtURL:url error:nil];
+    });
+}
+
+/// A file removed from a playlist stays available for its duration plus that of the playlist
+/// (RFC 8216 6.2.2), so that a client which loaded the previous playlist can still fetch it.
+-(void)expireFileWithName:(NSString *)name duration:(double)duration segmenter:(TSHlsSegmenter *)segmenter
+{
+    double playlistDuration = 0;
+    for (TSHlsSegment *segment in segmenter.segments) {
+        playlistDuration += segment.duration;
+    }
+    TSHlsExpiringFile *file = [[TSHlsExpiringFile alloc] init];
+    file.name = name;
+    file.expiry = _publishedDuration + duration + playlistDuration;
+    [_expiringFiles addObject:file];
+}
+
+-(void)removeExpiredFiles
+{
+    NSUInteger kept = 0;
+    for (NSUInteger i = 0; i < _expiringFiles.count; i++) {
+        TSHlsExpiringFile *file = _expiringFiles[i];
+        if (file.expiry <= _publishedDuration) {
+            [self removeFileWithName:file.name];
+        } else {
+            _expiringFiles[kept++] = file;
+        }
+    }
+    [_expiringFiles removeObjectsInRange:NSMakeRange(kept, _expiringFiles.count - kept)];
+}
+
+#pragma mark - TSHlsSegmenterDelegate
+
+-(void)segmenter:(TSHlsSegmenter *)segmenter didCompleteSegment:(TSHlsSegment *)segment
+{
+    // Not atomic: clients only see the file once the playlist lists it
+    [self writeData:segment.data name:segment.uri atomically:NO];
+    _publishedDuration += segment.duration;
+    [self removeExpiredFiles];
+}
+
+-(void)segmenter:(TSHlsSegmenter *)segmenter didCompletePartialSegment:(TSHlsPartialSegment *)part
+{
+    [self writeData:part.data name:part.uri atomically:NO];
+}
+
+-(void)segmenter:(TSHlsSegmenter *)segmenter didUpdatePlaylist:(NSString *)playlist
+{
+    [self writeData:[playlist dataUsingEncoding:NSUTF8StringEncoding] name:self.playlistName atomically:YES];
+}
+
+-(void)segmenter:(TSHlsSegmenter *)segmenter didRemoveSegment:(TSHlsSegment *)segment
+{
+    [self expireFileWithName:segment.uri duration:segment.duration segmenter:segmenter];
+}
+
+-(void)segmenter:(TSHlsSegmenter *)segmenter didRemovePartialSegment:(TSHlsPartialSegment *)part
+{
+    [self expireFileWithName:part.uri duration:part.duration segmenter:segmenter];
+}
+
+@end
@@ -0,0 +1,112 @@
+//
+//  TSHlsSegmenter.h
+//  TSMuxDemux
+//
+//  HLS and Low-Latency HLS segmentation of the TSMuxer output.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreMedia/CoreMedia.h>
+#import "../TSMuxer.h"
+@class TSHlsSegmenter;
+
+/// A partial segment (LL-HLS EXT-X-PART) of a segment being built.
+@interface TSHlsPartialSegment : NSObject
+/// Media sequence number of the segment the part belongs to.
+@property(nonatomic, readonly) uint64_t segmentSequenceNumber;
+/// Index of the part within its segment, from 0.
+@property(nonatomic, readonly) NSUInteger index;
+@property(nonatomic, readonly, nonnull) NSString *uri;
+/// Duration in seconds.
+@property(nonatomic, readonly) double duration;
+/// YES if the part starts with a video random access point.
+@property(nonatomic, readonly) BOOL isIndependent;
+/// The TS packets of the part. Not modified once the part is completed.
+@property(nonatomic, readonly, nonnull) NSData *data;
+@end
+
+/// A segment (EXTINF). Starts with the PAT and PMT followed by a video random access point,
+/// unless cut early to stay within the target duration.
+@interface TSHlsSegment : NSObject
+@property(nonatomic, readonly) uint64_t sequenceNumber;
+@property(nonatomic, readonly, nonnull) NSString *uri;
+/// Duration in seconds.
+@property(nonatomic, readonly) double duration;
+/// YES if the segment starts with a video random access point. EXT-X-INDEPENDENT-SEGMENTS is
+/// only listed while every segment of the playlist is.
+@property(nonatomic, readonly) BOOL isIndependent;
+/// The TS packets of the segment. Not modified once the segment is completed.
+@property(nonatomic, readonly, nonnull) NSData *data;
+/// The parts of the segment, empty without partial segments.
+@property(nonatomic, readonly, nonnull) NSArray<TSHlsPartialSegment*> *parts;
+@end
+
+/// Called on the thread feeding the segmenter, i.e. the muxer's tick or pacing thread: return quickly.
+@protocol TSHlsSegmenterDelegate <NSObject>
+-(void)segmenter:(TSHlsSegmenter * _Nonnull)segmenter didCompleteSegment:(TSHlsSegment * _Nonnull)segment;
+/// The media playlist, after every completed segment or part. Published after the segment or part it adds.
+-(void)segmenter:(TSHlsSegmenter * _Nonnull)segmenter didUpdatePlaylist:(NSString * _Nonnull)playlist;
+
+@optional
+-(void)segmenter:(TSHlsSegmenter * _Nonnull)segmenter didCompletePartialSegment:(TSHlsPartialSegment * _Nonnull)part;
+/// The segment slid out of the playlist.
+-(void)segmenter:(TSHlsSegmenter * _Nonnull)segmenter didRemoveSegment:(TSHlsSegment * _Nonnull)segment;
+/// The part is no longer listed in the playlist.
+-(void)segmenter:(TSHlsSegmenter * _Nonnull)segmenter didRemovePartialSegment:(TSHlsPartialSegment * _Nonnull)part;
+@end
+
+@interface TSHlsSegmenterSettings : NSObject <NSCopying>
+
+/// Segments are cut at the first video random access point at least this long after the start of
+/// the segment, in milliseconds. Must be > 0. The EXT-X-TARGETDURATION is this value rounded up
+/// to seconds, so the encoder's key frame interval should divide it. Without a random access point in
+/// time, a segment is cut at another access unit before its rounded duration would exceed it.
+@property(nonatomic) NSUInteger targetDurationMs;
+
+/// LL-HLS part target duration in milliseconds, or 0 for no partial segments. Otherwise must be
+/// below targetDurationMs. Parts are cut at video access unit boundaries, before the part would
+/// exceed this duration, and always at segment boundaries.
+@property(nonatomic) NSUInteger partTargetDurationMs;
+
+/// Number of segments listed in the playlist. Must be > 0. Older segments are removed.
+@property(nonatomic) NSUInteger playlistLength;
+
+/// Segment URIs are "<prefix><sequence number>.ts", part URIs "<prefix><sequence number>.<index>.ts".
+@property(nonatomic, copy, nonnull) NSString *uriPrefix;
+
+@end
+
+/// Cuts the output of a TSMuxer into HLS segments, and LL-HLS partial segments, and maintains
+/// the media playlist.
+///
+/// Set it as the muxer's delegate, or forward both TSMuxerDelegate callbacks to it: the access
+/// unit callback tells where each access unit starts, so segments are cut at access unit
+/// boundaries without parsing the packets. A segment is cut at the first video random access point
+/// reaching the target duration or, without one in time, at the access unit that would take it to
+/// the target duration (rounded up to seconds) + 0.5 s; such a segment is not independent, and the
+/// next one ends at the following random access point. A segment or part is published as soon as
+/// the first packet of the access unit following it is muxed. Packets before the first video
+/// random access point are dropped.
+///
+/// Each segment and part gets its own buffer, handed over to the delegate with the segment or part.
+/// Not thread safe: feed it from one thread (the muxer's tick or pacing thread).
+@interface TSHlsSegmenter : NSObject <TSMuxerDelegate>
+
+@property(nonatomic, weak, nullable) id<TSHlsSegmenterDelegate> delegate;
+@property(nonatomic, readonly, nonnull) TSHlsSegmenterSettings *settings;
+
+/// Segments currently listed in the playlist, oldest first.
+@property(nonatomic, readonly, nonnull) NSArray<TSHlsSegment*> *segments;
+/// The last playlist published, nil before the first segment or part.
+@property(nonatomic, readonly, nullable) NSString *playlist;
+
+/// Throws upon invalid settings. Only the PAT/PMT and video PIDs of `muxerSettings` are used.
+-(instancetype _Nonnull)initWithSettings:(TSHlsSegmenterSettings * _Nonnull)settings
+                           muxerSettings:(TSMuxerSettings * _Nonnull)muxerSettings
+                                delegate:(id<TSHlsSegmenterDelegate> _Nullable)delegate;
+
+/// Completes the segment in progress and publishes the playlist with EXT-X-ENDLIST.
+/// Later packets are ignored.
+-(void)finish;
+
+@end
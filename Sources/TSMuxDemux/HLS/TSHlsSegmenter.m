@@ -0,0 +1,452 @@
+//
+//  TSHlsSegmenter.m
+//  TSMuxDemux
+//
+//  HLS and Low-Latency HLS segmentation of the TSMuxer output.
+//
+
+#import "TSHlsSegmenter.h"
+#import "../TSConstants.h"
+#import "../TSPacket.h"
+#import "../TSLog.h"
+
+/// Parts are listed for the segments ending less than this many target durations before the end
+/// of the playlist (RFC 8216bis 6.2.2), and released after.
+#define PART_LISTING_TARGET_DURATIONS 3
+/// PART-HOLD-BACK, in part target durations (at least 2, 3 recommended).
+#define PART_HOLD_BACK_PART_TARGETS 3
+
+#pragma mark - TSHlsPartialSegment
+
+@interface TSHlsPartialSegment ()
+@property(nonatomic, readwrite) uint64_t segmentSequenceNumber;
+@property(nonatomic, readwrite) NSUInteger index;
+@property(nonatomic, readwrite, nonnull) NSString *uri;
+@property(nonatomic, readwrite) double duration;
+@property(nonatomic, readwrite) BOOL isIndependent;
+@property(nonatomic, strong, nonnull) NSMutableData *buffer;
+@end
+
+@implementation TSHlsPartialSegment
+
+-(NSData *)data
+{
+    return self.buffer;
+}
+
+@end
+
+#pragma mark - TSHlsSegment
+
+@interface TSHlsSegment ()
+@property(nonatomic, readwrite) uint64_t sequenceNumber;
+@property(nonatomic, readwrite, nonnull) NSString *uri;
+@property(nonatomic, readwrite) double duration;
+@property(nonatomic, readwrite) BOOL isIndependent;
+@property(nonatomic, strong, nonnull) NSMutableData *buffer;
+/// Completed parts, until released.
+@property(nonatomic, strong, nonnull) NSMutableArray<TSHlsPartialSegment*> *completedParts;
+@end
+
+@implementation TSHlsSegment
+
+-(NSData *)data
+{
+    return self.buffer;
+}
+
+-(NSArray<TSHlsPartialSegment *> *)parts
+{
+    return [self.completedParts copy];
+}
+
+@end
+
+#pragma mark - TSHlsSegmenterSettings
+
+@implementation TSHlsSegmenterSettings
+
+-(instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _uriPrefix = @"segment";
+    }
+    return self;
+}
+
+-(instancetype)copyWithZone:(NSZone *)zone
+{
+    TSHlsSegmenterSettings *copy = [[self class] allocWithZone:zone];
+    copy.targetDurationMs = self.targetDurationMs;
+    copy.partTargetDurationMs = self.partTargetDurationMs;
+    copy.playlistLength = self.playlistLength;
+    copy.uriPrefix = self.uriPrefix;
+    return copy;
+}
+
+@end
+
+#pragma mark - TSHlsSegmenter
+
+@implementation TSHlsSegmenter
+{
+    uint16_t _pmtPid;
+    uint16_t _videoPid;
+    CMTime _targetDuration;
+    CMTime _partTargetDuration;
+    // A segment must end before this, for its rounded duration not to exceed EXT-X-TARGETDURATION
+    CMTime _maxSegmentDuration;
+
+    NSMutableArray<TSHlsSegment*> *_segments;
+    // Segment and part being collected. nil before the first video random access point,
+    // and the part also without partial segments.
+    TSHlsSegment *_currentSegment;
+    TSHlsPartialSegment *_currentPart;
+    CMTime _segmentStartTime;
+    CMTime _partStartTime;
+    uint64_t _nextSequenceNumber;
+
+    // Decode time of the last video access unit, and the interval to the one before it
+    CMTime _lastVideoTime;
+    CMTime _frameDuration;
+
+    // Packets of the last PAT and PMT, repeated at the start of every segment
+    NSMutableArray<NSData*> *_patPackets;
+    NSMutableArray<NSData*> *_pmtPackets;
+
+    // Largest segment and part so far: new buffers are allocated with this capacity
+    NSUInteger _segmentCapacity;
+    NSUInteger _partCapacity;
+    BOOL _isFinished;
+    BOOL _hasWarnedForcedCut;
+}
+
++(void)validateSettings:(TSHlsSegmenterSettings *)settings
+{
+    if (settings.targetDurationMs == 0) {
+        [NSException raise:@"TSHlsSegmenterInvalidSettingsException" format:@"Target duration must be > 0"];
+    }
+    if (settings.partTargetDurationMs >= settings.targetDurationMs) {
+        [NSException raise:@"TSHlsSegmenterInvalidSettingsException" format:@"Part target duration must be below the target duration"];
+    }
+    if (settings.playlistLength == 0) {
+        [NSException raise:@"TSHlsSegmenterInvalidSettingsException" format:@"Playlist length must be > 0"];
+    }
+}
+
+-(instancetype _Nonnull)initWithSettings:(TSHlsSegmenterSettings * _Nonnull)settings
+                           muxerSettings:(TSMuxerSettings * _Nonnull)muxerSettings
+                                delegate:(id<TSHlsSegmenterDelegate> _Nullable)delegate
+{
+    self = [super init];
+    if (self) {
+        [TSHlsSegmenter validateSettings:settings];
+        _settings = [settings copy];
+        _delegate = delegate;
+        _pmtPid = muxerSettings.pmtPid;
+        _videoPid = muxerSettings.videoPid;
+        _targetDuration = CMTimeMake(settings.targetDurationMs, 1000);
+        _partTargetDuration = CMTimeMake(settings.partTargetDurationMs, 1000);
+        _maxSegmentDuration = CMTimeMake([self targetDurationSeconds] * 1000 + 500, 1000);
+
+        _segments = [NSMutableArray arrayWithCapacity:settings.playlistLength + 1];
+        _segmentStartTime = kCMTimeInvalid;
+        _partStartTime = kCMTimeInvalid;
+        _nextSequenceNumber = 0;
+        _lastVideoTime = kCMTimeInvalid;
+        _frameDuration = kCMTimeZero;
+        _patPackets = [NSMutableArray array];
+        _pmtPackets = [NSMutableArray array];
+    }
+    return self;
+}
+
+-(NSArray<TSHlsSegment *> *)segments
+{
+    return [_segments copy];
+}
+
+-(void)finish
+{
+    if (_isFinished) {
+        return;
+    }
+    _isFinished = YES;
+    if (_currentSegment) {
+        [self completeSegmentAtTime:CMTimeAdd(_lastVideoTime, _frameDuration)];
+    }
+    if (_segments.count > 0) {
+        [self publishPlaylist];
+    }
+}
+
+#pragma mark - TSMuxerDelegate
+
+-(void)muxer:(TSMuxer *)muxer willMuxAccessUnit:(TSAccessUnit *)accessUnit
+{
+    if (_isFinished || accessUnit.pid != _videoPid) {
+        return;
+    }
+    // Decode order: the DTS increases from one access unit to the next, the PTS not with B-frames
+    const CMTime time = CMTIME_IS_VALID(accessUnit.dts) ? accessUnit.dts : accessUnit.pts;
+    if (!CMTIME_IS_VALID(time)) {
+        return;
+    }
+    if (CMTIME_IS_VALID(_lastVideoTime) && CMTimeCompare(time, _lastVideoTime) > 0) {
+        _frameDuration = CMTimeSubtract(time, _lastVideoTime);
+    }
+    _lastVideoTime = time;
+
+    // A segment cut early ends at the next random access point, to be independent again
+    if (accessUnit.isRandomAccessPoint
+        && (!_currentSegment || !_currentSegment.isIndependent
+            || CMTimeCompare(CMTimeSubtract(time, _segmentStartTime), _targetDuration) >= 0)) {
+        [self completeSegmentAtTime:time];
+        [self startSegmentAtTime:time isIndependent:YES];
+        if (_segments.count > 0) {
+            [self publishPlaylist];
+        }
+        return;
+    }
+
+    // No random access point in time: cut before this access unit would make the rounded EXTINF
+    // exceed EXT-X-TARGETDURATION (RFC 8216 4.3.3.1)
+    if (_currentSegment) {
+        const CMTime elapsed = CMTimeSubtract(time, _segmentStartTime);
+        if (CMTimeCompare(elapsed, kCMTimeZero) > 0
+            && CMTimeCompare(CMTimeAdd(elapsed, _frameDuration), _maxSegmentDuration) >= 0) {
+            if (!_hasWarnedForcedCut) {
+                _hasWarnedForcedCut = YES;
+                TSLogWarn(@"No random access point within the target duration: cutting a segment at %.3f s, "
+                          "the key frame interval should divide %lu ms",
+                          CMTimeGetSeconds(elapsed), (unsigned long)_settings.targetDurationMs);
+            }
+            [self completeSegmentAtTime:time];
+            [self startSegmentAtTime:time isIndependent:accessUnit.isRandomAccessPoint];
+            [self publishPlaylist];
+            return;
+        }
+    }
+
+    // Cut the part before this access unit would make it longer than the part target
+    if (_currentPart) {
+        const CMTime elapsed = CMTimeSubtract(time, _partStartTime);
+        if (CMTimeCompare(elapsed, kCMTimeZero) > 0
+            && CMTimeCompare(CMTimeAdd(elapsed, _frameDuration), _partTargetDuration) > 0) {
+            [self completePartAtTime:time];
+            [self startPartAtTime:time isIndependent:accessUnit.isRandomAccessPoint];
+            [self publishPlaylist];
+        }
+    }
+}
+
+-(void)muxer:(TSMuxer *)muxer didMuxTSPacketData:(NSData *)tsPacketData
+{
+    if (_isFinished) {
+        return;
+    }
+    const uint8_t *bytes = tsPacketData.bytes;
+    const uint16_t pid = TSPacketHeaderPid(bytes);
+    if (pid == PID_PAT || pid == _pmtPid) {
+        NSMutableArray<NSData*> *packets = pid == PID_PAT ? _patPackets : _pmtPackets;
+        if (bytes[1] & 0x40) {
+            // payload_unit_start_indicator: a new section
+            [packets removeAllObjects];
+        }
+        [packets addObject:tsPacketData];
+    }
+    [self appendPacket:tsPacketData];
+}
+
+#pragma mark - Segments
+
+-(void)appendPacket:(NSData *)tsPacketData
+{
+    [_currentSegment.buffer appendData:tsPacketData];
+    [_currentPart.buffer appendData:tsPacketData];
+}
+
+-(void)startSegmentAtTime:(CMTime)time isIndependent:(BOOL)isIndependent
+{
+    TSHlsSegment *segment = [[TSHlsSegment alloc] init];
+    segment.sequenceNumber = _nextSequenceNumber++;
+    segment.uri = [NSString stringWithFormat:@"%@%llu.ts", _settings.uriPrefix, segment.sequenceNumber];
+    segment.isIndependent = isIndependent;
+    segment.buffer = [NSMutableData dataWithCapacity:_segmentCapacity];
+    segment.completedParts = [NSMutableArray array];
+    _currentSegment = segment;
+    _segmentStartTime = time;
+
+    if (_settings.partTargetDurationMs > 0) {
+        [self startPartAtTime:time isIndependent:isIndependent];
+    }
+    // Decodable on its own: the PAT and PMT first, repeating the last ones sent (same CC)
+    for (NSData *packet in _patPackets) {
+        [self appendPacket:packet];
+    }
+    for (NSData *packet in _pmtPackets) {
+        [self appendPacket:packet];
+    }
+}
+
+-(void)completeSegmentAtTime:(CMTime)time
+{
+    TSHlsSegment *segment = _currentSegment;
+    if (!segment) {
+        return;
+    }
+    [self completePartAtTime:time];
+    segment.duration = MAX(0.0, CMTimeGetSeconds(CMTimeSubtract(time, _segmentStartTime)));
+    _segmentCapacity = MAX(_segmentCapacity, segment.buffer.length);
+    _currentSegment = nil;
+
+    [_segments addObject:segment];
+    [self.delegate segmenter:self didCompleteSegment:segment];
+}
+
+-(void)startPartAtTime:(CMTime)time isIndependent:(BOOL)isIndependent
+{
+    TSHlsPartialSegment *part = [[TSHlsPartialSegment alloc] init];
+    part.segmentSequenceNumber = _currentSegment.sequenceNumber;
+    part.index = _currentSegment.completedParts.count;
+    part.uri = [NSString stringWithFormat:@"%@%llu.%lu.ts", _settings.uriPrefix,
+                part.segmentSequenceNumber, (unsigned long)part.index];
+    part.isIndependent = isIndependent;
+    part.buffer = [NSMutableData dataWithCapacity:_partCapacity];
+    _currentPart = part;
+    _partStartTime = time;
+}
+
+-(void)completePartAtTime:(CMTime)time
+{
+    TSHlsPartialSegment *part = _currentPart;
+    if (!part) {
+        return;
+    }
+    part.duration = MAX(0.0, CMTimeGetSeconds(CMTimeSubtract(time, _partStartTime)));
+    _partCapacity = MAX(_partCapacity, part.buffer.length);
+    _currentPart = nil;
+
+    [_currentSegment.completedParts addObject:part];
+    id<TSHlsSegmenterDelegate> delegate = self.delegate;
+    if ([delegate respondsToSelector:@selector(segmenter:didCompletePartialSegment:)]) {
+        [delegate segmenter:self didCompletePartialSegment:part];
+    }
+}
+
+-(void)releasePartsOfSegment:(TSHlsSegment *)segment
+{
+    id<TSHlsSegmenterDelegate> delegate = self.delegate;
+    const BOOL notifies = [delegate respondsToSelector:@selector(segmenter:didRemovePartialSegment:)];
+    for (TSHlsPartialSegment *part in segment.completedParts) {
+        if (notifies) {
+            [delegate segmenter:self didRemovePartialSegment:part];
+        }
+    }
+    [segment.completedParts removeAllObjects];
+}
+
+-(void)releaseSegment:(TSHlsSegment *)segment
+{
+    [self releasePartsOfSegment:segment];
+    id<TSHlsSegmenterDelegate> delegate = self.delegate;
+    if ([delegate respondsToSelector:@selector(segmenter:didRemoveSegment:)]) {
+        [delegate segmenter:self didRemoveSegment:segment];
+    }
+}
+
+#pragma mark - Playlist
+
+-(NSUInteger)targetDurationSeconds
+{
+    return (_settings.targetDurationMs + 999) / 1000;
+}
+
+/// Index of the first segment in `_segments` whose parts are listed.
+-(NSUInteger)firstSegmentIndexListingParts
+{
+    if (_settings.partTargetDurationMs == 0) {
+        return _segments.count;
+    }
+    const double limit = PART_LISTING_TARGET_DURATIONS * [self targetDurationSeconds];
+    double age = 0;
+    for (TSHlsPartialSegment *part in _currentSegment.completedParts) {
+        age += part.duration;
+    }
+    NSUInteger index = _segments.count;
+    while (index > 0 && age < limit) {
+        index--;
+        age += _segments[index].duration;
+    }
+    return index;
+}
+
+static inline void appendParts(NSMutableString *playlist, NSArray<TSHlsPartialSegment*> *parts)
+{
+    for (TSHlsPartialSegment *part in parts) {
+        [playlist appendFormat:@"#EXT-X-PART:DURATION=%.3f,URI=\"%@\"%@\n",
+         part.duration, part.uri, part.isIndependent ? @",INDEPENDENT=YES" : @""];
+    }
+}
+
+static inline BOOL areIndependent(NSArray<TSHlsSegment*> *segments)
+{
+    for (TSHlsSegment *segment in segments) {
+        if (!segment.isIndependent) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+/// Publishes the playlist, then releases what it no longer lists.
+-(void)publishPlaylist
+{
+    NSMutableArray<TSHlsSegment*> *removedSegments = [NSMutableArray array];
+    while (_segments.count > _settings.playlistLength) {
+        [removedSegments addObject:_segments.firstObject];
+        [_segments removeObjectAtIndex:0];
+    }
+    const NSUInteger firstSegmentWithParts = [self firstSegmentIndexListingParts];
+    const uint64_t mediaSequence = _segments.count > 0
+        ? _segments.firstObject.sequenceNumber : _currentSegment.sequenceNumber;
+
+    NSMutableString *playlist = [NSMutableString stringWithCapacity:256 + 64 * _settings.playlistLength];
+    [playlist appendString:@"#EXTM3U\n#EXT-X-VERSION:6\n"];
+    [playlist appendFormat:@"#EXT-X-TARGETDURATION:%lu\n", (unsigned long)[self targetDurationSeconds]];
+    if (_settings.partTargetDurationMs > 0) {
+        const double partTarget = _settings.partTargetDurationMs / 1000.0;
+        [playlist appendFormat:@"#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%.3f\n", PART_HOLD_BACK_PART_TARGETS * partTarget];
+        [playlist appendFormat:@"#EXT-X-PART-INF:PART-TARGET=%.3f\n", partTarget];
+    }
+    [playlist appendFormat:@"#EXT-X-MEDIA-SEQUENCE:%llu\n", mediaSequence];
+    if (areIndependent(_segments) && (!_currentSegment || _currentSegment.isIndependent)) {
+        [playlist appendString:@"#EXT-X-INDEPENDENT-SEGMENTS\n"];
+    }
+    for (NSUInteger i = 0; i < _segments.count; i++) {
+        TSHlsSegment *segment = _segments[i];
+        if (i >= firstSegmentWithParts) {
+            appendParts(playlist, segment.completedParts);
+        }
+        [playlist appendFormat:@"#EXTINF:%.3f,\n%@\n", segment.duration, segment.uri];
+    }
+    if (_currentSegment) {
+        appendParts(playlist, _currentSegment.completedParts);
+    }
+    if (_isFinished) {
+        [playlist appendString:@"#EXT-X-ENDLIST\n"];
+    }
+
+    _playlist = [playlist copy];
+    [self.delegate segmenter:self didUpdatePlaylist:_playlist];
+
+    for (TSHlsSegment *segment in removedSegments) {
+        [self releaseSegment:segment];
+    }
+    for (NSUInteger i = 0; i < firstSegmentWithParts; i++) {
+        [self releasePartsOfSegment:_segments[i]];
+    }
+}
+
+@end
@@ -0,0 +1,168 @@
+//
+//  TSRandomAccessIndex.h
+//  TSMuxDemux
+//
+//  Sidecar random access index for recorded transport streams.
+//
+
+#import <Foundation/Foundation.h>
+#import "../TSConstants.h"
+@class TSDemuxer;
+
+NS_ASSUME_NONNULL_BEGIN
+
+#pragma mark - Binary Format
+
+/// The index is a flat file in the byte order of the host that wrote it, so that it can be memory
+/// mapped and read in place:
+///
+///     TSRandomAccessIndexHeader
+///     TSRandomAccessIndexPsiEntry[psiCount]   - PAT/PMT versions, in file order
+///     TSRandomAccessIndexPidEntry[pidCount]   - one per indexed ES PID, pointing into the RAP table
+///     TSRandomAccessIndexRapEntry[rapCount]   - grouped by PID, in file order within a PID
+///     TSRandomAccessIndexPcrEntry[pcrCount]   - in file order
+///
+/// All records are 8-byte aligned so they can be accessed directly from the mapped bytes.
+/// `byteOrderMark` holds TS_RANDOM_ACCESS_INDEX_BYTE_ORDER_MARK in the writer's byte order: an index
+/// written on a host of the other byte order is rejected rather than misread.
+
+FOUNDATION_EXPORT uint32_t const TS_RANDOM_ACCESS_INDEX_MAGIC;   // 'TSRX'
+FOUNDATION_EXPORT uint16_t const TS_RANDOM_ACCESS_INDEX_VERSION;
+FOUNDATION_EXPORT uint32_t const TS_RANDOM_ACCESS_INDEX_BYTE_ORDER_MARK;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t packetSize;        ///< 188, 192 (M2TS) or 204. Offsets are of whole packets.
+    uint64_t indexedLength;     ///< Number of bytes of the transport stream that were indexed.
+    uint32_t psiCount;
+    uint32_t pidCount;
+    uint32_t rapCount;
+    uint32_t pcrCount;
+    uint32_t byteOrderMark;     ///< TS_RANDOM_ACCESS_INDEX_BYTE_ORDER_MARK.
+    uint32_t reserved;
+} TSRandomAccessIndexHeader;
+
+typedef struct {
+    uint64_t offset;            ///< Offset of the first packet of the section (PUSI).
+    uint64_t endOffset;         ///< Offset just past the packet completing the section.
+    uint16_t pid;
+    uint8_t tableId;            ///< TABLE_ID_PAT or TABLE_ID_PMT.
+    uint8_t versionNumber;
+    uint16_t programNumber;     ///< 0 for PAT.
+    uint16_t reserved;
+} TSRandomAccessIndexPsiEntry;
+
+typedef struct {
+    uint16_t pid;
+    uint8_t streamType;         ///< Raw PMT stream_type.
+    uint8_t reserved;
+    uint32_t firstRap;          ///< Index of the first RAP entry for this PID.
+    uint32_t rapCount;
+    uint32_t reserved2;
+} TSRandomAccessIndexPidEntry;
+
+typedef NS_OPTIONS(uint32_t, TSRandomAccessPointFlags) {
+    /// The adaptation field random_access_indicator was set.
+    TSRandomAccessPointFlagRai = 1 << 0,
+    /// An IDR (H.264) or IRAP (HEVC) picture was found at the start of the PES.
+    TSRandomAccessPointFlagKeyframe = 1 << 1,
+};
+
+typedef struct {
+    uint64_t offset;            ///< Offset of the TS packet starting the PES.
+    uint64_t pts;               ///< Raw 33-bit 90 kHz PTS.
+    uint32_t flags;             ///< TSRandomAccessPointFlags.
+    uint32_t reserved;
+} TSRandomAccessIndexRapEntry;
+
+typedef struct {
+    uint64_t offset;            ///< Offset of the TS packet carrying the PCR.
+    uint64_t pcr;               ///< 27 MHz PCR (base * 300 + ext).
+    int64_t timelineValue;      ///< Position of the PCR base on the program's TSProgramTimeline.
+    uint16_t pid;
+    uint16_t reserved[3];
+} TSRandomAccessIndexPcrEntry;
+
+#pragma mark - TSRandomAccessIndex
+
+/// Read-only view of a serialized index. Entries are read in place from `data`, so an index
+/// created with `+indexWithContentsOfFile:` stays memory mapped.
+///
+/// PTS lookups assume timestamps increase through the recording (no 33-bit wrap).
+@interface TSRandomAccessIndex : NSObject
+
+@property(nonatomic, readonly) NSData *data;
+@property(nonatomic, readonly) NSUInteger packetSize;
+@property(nonatomic, readonly) uint64_t indexedLength;
+
+@property(nonatomic, readonly) NSUInteger psiCount;
+@property(nonatomic, readonly) NSUInteger pidCount;
+@property(nonatomic, readonly) NSUInteger pcrCount;
+
+-(const TSRandomAccessIndexPsiEntry *)psiEntries NS_RETURNS_INNER_POINTER;
+-(const TSRandomAccessIndexPidEntry *)pidEntries NS_RETURNS_INNER_POINTER;
+-(const TSRandomAccessIndexPcrEntry *)pcrEntries NS_RETURNS_INNER_POINTER;
+
+/// Returns nil if `data` is not a valid index.
++(instancetype _Nullable)indexWithData:(NSData *)data;
+
+/// Memory maps the index file. Returns nil if it cannot be read or is not a valid index.
++(instancetype _Nullable)indexWithContentsOfFile:(NSString *)path;
+
+/// Number of random access points indexed for `pid` (0 if the PID is not indexed).
+-(NSUInteger)rapCountForPid:(uint16_t)pid;
+
+/// Pointer to the `rapCountForPid:` entries of `pid`, or NULL if the PID is not indexed.
+-(const TSRandomAccessIndexRapEntry * _Nullable)rapEntriesForPid:(uint16_t)pid NS_RETURNS_INNER_POINTER;
+
+/// The last random access point on `pid` with PTS <= `pts`, or the first one if all are later.
+/// Returns NULL if the PID has no random access points.
+-(const TSRandomAccessIndexRapEntry * _Nullable)rapEntryForPid:(uint16_t)pid
+                                                 atOrBeforePts:(uint64_t)pts;
+
+/// Feeds `demuxer` the most recent PAT and PMT versions that completed before `offset`,
+/// read from `tsData` (the indexed transport stream, typically memory mapped), and resumes each
+/// program's timeline at the last PCR sample before `offset`.
+/// After this the demuxer can be fed data starting at `offset` with PSI already in place, and
+/// reports the timeline timestamps a demuxer fed from the start would.
+-(void)warmUpDemuxer:(TSDemuxer *)demuxer fromData:(NSData *)tsData beforeOffset:(uint64_t)offset;
+
+/// Looks up the random access point for `pid` at or before `pts`, warms up the demuxer and
+/// returns the byte offset demuxing should continue from. Returns NSNotFound if `pid` has no
+/// random access points.
+-(NSUInteger)seekDemuxer:(TSDemuxer *)demuxer
+                fromData:(NSData *)tsData
+                     pid:(uint16_t)pid
+                     pts:(uint64_t)pts;
+
+@end
+
+#pragma mark - TSRandomAccessIndexBuilder
+
+/// Builds a TSRandomAccessIndex in a single streaming pass over a transport stream.
+///
+/// Only PSI packets are passed to an internal TSDemuxer. Elementary stream packets are
+/// inspected at header level (PUSI, PES header, adaptation field), plus a start code scan of
+/// the first bytes of each video PES, so indexing is bound by I/O rather than parsing.
+@interface TSRandomAccessIndexBuilder : NSObject
+
+/// Minimum spacing between recorded PCR samples per PID. Default 1000 ms. 0 records every PCR.
+/// The first PCR of each timeline epoch (after a discontinuity) is always recorded.
+@property(nonatomic) uint32_t pcrSampleIntervalMs;
+
+-(instancetype)initWithMode:(TSDemuxerMode)mode;
+
+/// Feeds the next chunk of the stream. Like -[TSDemuxer demux:], chunks must contain whole packets.
+-(void)addData:(NSData *)chunk;
+
+/// Returns the serialized index.
+-(NSData *)finish;
+
+/// Indexes the file at `path` (memory mapped) and returns the serialized index, or nil if the
+/// file could not be read.
++(NSData * _Nullable)indexDataForFileAtPath:(NSString *)path mode:(TSDemuxerMode)mode;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,610 @@
+//
+//  TSRandomAccessIndex.m
+//  TSMuxDemux
+//
+//  Sidecar random access index for recorded transport streams.
+//
+
+#import "TSRandomAccessIndex.h"
+#import "../TSDemuxer.h"
+#import "../TSElementaryStream.h"
+#import "../TSPacket.h"
+#import "../TSPesHeader.h"
+#import "../TSProgramTimeline.h"
+#import "../TSNalUnitIndex.h"
+#import "../TSStartCodeScanner.h"
+#import "../TSStreamType.h"
+#import "../TSLog.h"
+
+uint32_t const TS_RANDOM_ACCESS_INDEX_MAGIC = 0x58525354; // 'TSRX' on little-endian hosts
+uint16_t const TS_RANDOM_ACCESS_INDEX_VERSION = 3;
+uint32_t const TS_RANDOM_ACCESS_INDEX_BYTE_ORDER_MARK = 0x01020304;
+
+_Static_assert(sizeof(TSRandomAccessIndexHeader) == 40, "index header layout");
+_Static_assert(sizeof(TSRandomAccessIndexPsiEntry) == 24, "index PSI entry layout");
+_Static_assert(sizeof(TSRandomAccessIndexPidEntry) == 16, "index PID entry layout");
+_Static_assert(sizeof(TSRandomAccessIndexRapEntry) == 24, "index RAP entry layout");
+_Static_assert(sizeof(TSRandomAccessIndexPcrEntry) == 32, "index PCR entry layout");
+
+#define PID_COUNT 8192
+
+/// Number of packets per chunk (and autorelease pool) when indexing a file.
+static const NSUInteger FILE_CHUNK_NUM_PACKETS = 32 * 1024;
+
+/// A video PES is inspected for its first VCL NAL unit for at most this many packets.
+static const uint8_t MAX_RAP_SCAN_PACKETS = 8;
+
+#pragma mark - TSRandomAccessIndex
+
+@implementation TSRandomAccessIndex
+{
+    const TSRandomAccessIndexHeader *_header;
+}
+
++(instancetype _Nullable)indexWithData:(NSData *)data
+{
+    if (data.length < sizeof(TSRandomAccessIndexHeader)) {
+        TSLogError(@"Index too short (%lu bytes)", (unsigned long)data.length);
+        return nil;
+    }
+    const TSRandomAccessIndexHeader *header = data.bytes;
+    if (header->byteOrderMark == CFSwapInt32(TS_RANDOM_ACCESS_INDEX_BYTE_ORDER_MARK)) {
+        TSLogError(@"Random access index written with the other byte order");
+        return nil;
+    }
+    if (header->byteOrderMark != TS_RANDOM_ACCESS_INDEX_BYTE_ORDER_MARK
+        || header->magic != TS_RANDOM_ACCESS_INDEX_MAGIC || header->version != TS_RANDOM_ACCESS_INDEX_VERSION) {
+        TSLogError(@"Not a random access index (magic 0x%08X, version %u)", header->magic, header->version);
+        return nil;
+    }
+    const uint64_t expectedLength = sizeof(TSRandomAccessIndexHeader)
+        + (uint64_t)header->psiCount * sizeof(TSRandomAccessIndexPsiEntry)
+        + (uint64_t)header->pidCount * sizeof(TSRandomAccessIndexPidEntry)
+        + (uint64_t)header->rapCount * sizeof(TSRandomAccessIndexRapEntry)
+        + (uint64_t)header->pcrCount * sizeof(TSRandomAccessIndexPcrEntry);
+    if (data.length < expectedLength) {
+        TSLogError(@"Index truncated (%lu bytes, expected %llu)", (unsigned long)data.length, expectedLength);
+        return nil;
+    }
+
+    const TSRandomAccessIndexPidEntry *pids = (const TSRandomAccessIndexPidEntry *)
+        ((const uint8_t *)data.bytes + sizeof(TSRandomAccessIndexHeader)
+         + header->psiCount * sizeof(TSRandomAccessIndexPsiEntry));
+    for (uint32_t i = 0; i < header->pidCount; i++) {
+        if ((uint64_t)pids[i].firstRap + pids[i].rapCount > header->rapCount) {
+            TSLogError(@"Index PID entry %u references RAPs out of range", i);
+            return nil;
+        }
+    }
+
+    TSRandomAccessIndex *index = [[TSRandomAccessIndex alloc] init];
+    index->_data = data;
+    index->_header = header;
+    return index;
+}
+
++(instancetype _Nullable)indexWithContentsOfFile:(NSString *)path
+{
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    if (!data) {
+        TSLogError(@"Failed to read index file %@", path);
+        return nil;
+    }
+    return [self indexWithData:data];
+}
+
+-(NSUInteger)packetSize
+{
+    return _header->packetSize;
+}
+
+-(uint64_t)indexedLength
+{
+    return _header->indexedLength;
+}
+
+-(NSUInteger)psiCount
+{
+    return _header->psiCount;
+}
+
+-(NSUInteger)pidCount
+{
+    return _header->pidCount;
+}
+
+-(NSUInteger)pcrCount
+{
+    return _header->pcrCount;
+}
+
+-(const TSRandomAccessIndexPsiEntry *)psiEntries
+{
+    return (const TSRandomAccessIndexPsiEntry *)(_header + 1);
+}
+
+-(const TSRandomAccessIndexPidEntry *)pidEntries
+{
+    return (const TSRandomAccessIndexPidEntry *)(self.psiEntries + _header->psiCount);
+}
+
+-(const TSRandomAccessIndexRapEntry *)rapEntries
+{
+    return (const TSRandomAccessIndexRapEntry *)(self.pidEntries + _header->pidCount);
+}
+
+-(const TSRandomAccessIndexPcrEntry *)pcrEntries
+{
+    return (const TSRandomAccessIndexPcrEntry *)(self.rapEntries + _header->rapCount);
+}
+
+-(const TSRandomAccessIndexPidEntry * _Nullable)pidEntryForPid:(uint16_t)pid
+{
+    const TSRandomAccessIndexPidEntry *pids = self.pidEntries;
+    for (uint32_t i = 0; i < _header->pidCount; i++) {
+        if (pids[i].pid == pid) {
+            return &pids[i];
+        }
+    }
+    return NULL;
+}
+
+-(NSUInteger)rapCountForPid:(uint16_t)pid
+{
+    const TSRandomAccessIndexPidEntry *entry = [self pidEntryForPid:pid];
+    return entry ? entry->rapCount : 0;
+}
+
+-(const TSRandomAccessIndexRapEntry * _Nullable)rapEntriesForPid:(uint16_t)pid
+{
+    const TSRandomAccessIndexPidEntry *entry = [self pidEntryForPid:pid];
+    if (!entry || entry->rapCount == 0) {
+        return NULL;
+    }
+    return self.rapEntries + entry->firstRap;
+}
+
+-(const TSRandomAccessIndexRapEntry * _Nullable)rapEntryForPid:(uint16_t)pid atOrBeforePts:(uint64_t)pts
+{
+    const TSRandomAccessIndexRapEntry *raps = [self rapEntriesForPid:pid];
+    if (!raps) {
+        return NULL;
+    }
+    const NSUInteger count = [self rapCountForPid:pid];
+
+    // Binary search for the first entry with PTS > pts, then step back one.
+    NSUInteger lo = 0;
+    NSUInteger hi = count;
+    while (lo < hi) {
+        const NSUInteger mid = lo + (hi - lo) / 2;
+        if (raps[mid].pts <= pts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo > 0 ? &raps[lo - 1] : &raps[0];
+}
+
+-(void)warmUpDemuxer:(TSDemuxer *)demuxer fromData:(NSData *)tsData beforeOffset:(uint64_t)offset
+{
+    // Latest completed version per PSI PID (PAT first, then PMTs in file order).
+    const TSRandomAccessIndexPsiEntry *psi = self.psiEntries;
+    NSMutableDictionary<Pid, NSNumber*> *latestByPid = [NSMutableDictionary dictionary];
+    for (uint32_t i = 0; i < _header->psiCount; i++) {
+        if (psi[i].endOffset > offset) {
+            break;
+        }
+        latestByPid[@(psi[i].pid)] = @(i);
+    }
+
+    NSArray<NSNumber*> *entryIndices = [latestByPid.allValues sortedArrayUsingComparator:^NSComparisonResult(NSNumber *a, NSNumber *b) {
+        const BOOL aIsPat = psi[a.unsignedIntValue].tableId == TABLE_ID_PAT;
+        const BOOL bIsPat = psi[b.unsignedIntValue].tableId == TABLE_ID_PAT;
+        if (aIsPat != bIsPat) {
+            return aIsPat ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return [a compare:b];
+    }];
+
+    const NSUInteger packetSize = _header->packetSize;
+    const NSUInteger syncOffset = TSPacketSyncOffset(packetSize);
+    const uint8_t *bytes = tsData.bytes;
+    for (NSNumber *entryIndex in entryIndices) {
+        const TSRandomAccessIndexPsiEntry *entry = &psi[entryIndex.unsignedIntValue];
+        for (uint64_t pos = entry->offset; pos + packetSize <= MIN(entry->endOffset, tsData.length); pos += packetSize) {
+            if (TSPacketHeaderPid(bytes + pos + syncOffset) != entry->pid) {
+                continue;
+            }
+            NSData *packetData = [NSData dataWithBytesNoCopy:(void *)(bytes + pos) length:packetSize freeWhenDone:NO];
+            [demuxer demux:packetData dataArrivalHostTimeNanos:0];
+        }
+    }
+
+    // Latest PCR sample per PID, to continue the timelines where a pass from the start would be
+    const TSRandomAccessIndexPcrEntry *pcrs = self.pcrEntries;
+    NSMutableDictionary<Pid, NSNumber*> *latestPcrByPid = [NSMutableDictionary dictionary];
+    for (uint32_t i = 0; i < _header->pcrCount && pcrs[i].offset < offset; i++) {
+        latestPcrByPid[@(pcrs[i].pid)] = @(i);
+    }
+    for (TSProgramMapTable *pmt in demuxer.pmts.allValues) {
+        NSNumber *entryIndex = latestPcrByPid[@(pmt.pcrPid)];
+        if (entryIndex) {
+            const TSRandomAccessIndexPcrEntry *entry = &pcrs[entryIndex.unsignedIntValue];
+            [[demuxer timelineForProgram:pmt.programNumber] resumeAtPcrBase:entry->pcr / 300
+                                                              timelineValue:entry->timelineValue];
+        }
+    }
+}
+
+-(NSUInteger)seekDemuxer:(TSDemuxer *)demuxer fromData:(NSData *)tsData pid:(uint16_t)pid pts:(uint64_t)pts
+{
+    const TSRandomAccessIndexRapEntry *rap = [self rapEntryForPid:pid atOrBeforePts:pts];
+    if (!rap) {
+        return NSNotFound;
+    }
+    [self warmUpDemuxer:demuxer fromData:tsData beforeOffset:rap->offset];
+    return (NSUInteger)rap->offset;
+}
+
+@end
+
+#pragma mark - TSRandomAccessIndexBuilder
+
+typedef NS_ENUM(uint8_t, TSIndexPidKind) {
+    TSIndexPidKindNone = 0,
+    TSIndexPidKindPsi,
+    /// H.264/HEVC - random access points confirmed by NAL unit type.
+    TSIndexPidKindNalVideo,
+    /// Other elementary streams - random access points signalled by RAI only.
+    TSIndexPidKindEs,
+};
+
+typedef struct {
+    uint64_t psiSectionStart;
+    uint64_t lastPcrSample;
+    uint64_t rapOffset;
+    uint64_t rapPts;
+    uint32_t rapFlags;
+    TSIndexPidKind kind;
+    TSNalUnitCodec codec;
+    uint8_t streamType;
+    BOOL isPcrPid;
+    BOOL rapPending;
+    uint8_t rapPacketsScanned;
+} TSIndexPidState;
+
+/// Result of scanning a payload for the first VCL NAL unit.
+typedef NS_ENUM(int8_t, TSVclScanResult) {
+    TSVclScanResultNotFound = -1,
+    TSVclScanResultNonKeyframe = 0,
+    TSVclScanResultKeyframe = 1,
+};
+
+static TSVclScanResult scanForFirstVcl(const uint8_t *bytes, NSUInteger length, TSNalUnitCodec codec)
+{
+    NSUInteger offset = 0;
+    while (offset < length) {
+        const NSUInteger startCode = TSFindStartCodeFromOffset(bytes, length, offset);
+        if (startCode == NSNotFound || startCode + 3 >= length) {
+            return TSVclScanResultNotFound;
+        }
+        const uint8_t type = TSNalUnitTypeFromHeader(codec, bytes[startCode + 3]);
+        if (TSNalUnitTypeIsVcl(codec, type)) {
+            return TSNalUnitTypeIsKeyframe(codec, type) ? TSVclScanResultKeyframe : TSVclScanResultNonKeyframe;
+        }
+        offset = startCode + 3;
+    }
+    return TSVclScanResultNotFound;
+}
+
+@interface TSRandomAccessIndexBuilder() <TSDemuxerDelegate>
+@end
+
+@implementation TSRandomAccessIndexBuilder
+{
+    TSDemuxer *_demuxer;
+    NSUInteger _packetSize;
+    uint64_t _streamOffset;
+
+    // Context for demuxer callbacks, which fire synchronously while a PSI packet is demuxed.
+    uint64_t _currentPacketOffset;
+    uint16_t _currentPid;
+
+    TSIndexPidState *_pids;
+    NSMutableData *_psiEntries;
+    NSMutableData *_pcrEntries;
+    // Timeline of each PCR PID, fed every PCR as TSDemuxer does
+    NSMutableDictionary<Pid, TSProgramTimeline*> *_pcrTimelines;
+    NSMutableDictionary<Pid, NSMutableData*> *_rapsByPid;
+}
+
+-(instancetype)initWithMode:(TSDemuxerMode)mode
+{
+    self = [super init];
+    if (self) {
+        _demuxer = [[TSDemuxer alloc] initWithDelegate:self mode:mode];
+        _pcrSampleIntervalMs = 1000;
+        _pids = calloc(PID_COUNT, sizeof(TSIndexPidState));
+        for (NSUInteger pid = 0; pid < PID_COUNT; pid++) {
+            _pids[pid].lastPcrSample = kNoPcr;
+        }
+        _pids[PID_PAT].kind = TSIndexPidKindPsi;
+        _psiEntries = [NSMutableData data];
+        _pcrEntries = [NSMutableData data];
+        _pcrTimelines = [NSMutableDictionary dictionary];
+        _rapsByPid = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+-(void)dealloc
+{
+    free(_pids);
+}
+
+-(void)addData:(NSData *)chunk
+{
+    if (_packetSize == 0) {
+        _packetSize = TSPacketDetectSizeOfChunk(chunk.bytes, chunk.length);
+    }
+
+    const uint8_t *bytes = chunk.bytes;
+    const NSUInteger length = chunk.length;
+    const NSUInteger syncOffset = TSPacketSyncOffset(_packetSize);
+    const uint64_t pcrIntervalTicks = (uint64_t)_pcrSampleIntervalMs * 27000;
+
+    for (NSUInteger pos = 0; pos + _packetSize <= length; pos += _packetSize) {
+        // Offsets are those of the whole packet, M2TS prefix included; the header follows the prefix
+        const uint8_t *packet = bytes + pos + syncOffset;
+        if (packet[0] != TS_PACKET_HEADER_SYNC_BYTE || (packet[1] & 0x80)) {
+            continue; // Sync loss or transport error
+        }
+        const uint16_t pid = TSPacketHeaderPid(packet);
+        TSIndexPidState *state = &_pids[pid];
+        if (state->kind == TSIndexPidKindNone && !state->isPcrPid) {
+            continue;
+        }
+        const uint64_t packetOffset = _streamOffset + pos;
+        const BOOL pusi = (packet[1] & 0x40) != 0;
+
+        if (state->kind == TSIndexPidKindPsi) {
+            if (pusi) {
+                state->psiSectionStart = packetOffset;
+            }
+            _currentPacketOffset = packetOffset;
+            _currentPid = pid;
+            NSData *packetData = [NSData dataWithBytesNoCopy:(void *)(bytes + pos) length:_packetSize freeWhenDone:NO];
+            [_demuxer demux:packetData dataArrivalHostTimeNanos:0];
+            continue;
+        }
+
+        const uint8_t adaptationControl = (packet[3] >> 4) & 0x03;
+        uint8_t adaptationFlags = 0;
+        NSUInteger payloadStart = TS_PACKET_HEADER_SIZE;
+        if (adaptationControl & 0x02) {
+            const uint8_t adaptationLength = packet[4];
+            if (adaptationLength > 0) {
+                adaptationFlags = packet[5];
+            }
+            payloadStart = TS_PACKET_HEADER_SIZE + 1 + adaptationLength;
+
+            if (state->isPcrPid && (adaptationFlags & 0x10) && adaptationLength >= 7) {
+                const uint64_t pcrBase = ((uint64_t)packet[6] << 25) | ((uint64_t)packet[7] << 17)
+                    | ((uint64_t)packet[8] << 9) | ((uint64_t)packet[9] << 1) | (packet[10] >> 7);
+                const uint16_t pcrExt = ((packet[10] & 0x01) << 8) | packet[11];
+                const uint64_t pcr = pcrBase * 300 + pcrExt;
+                TSProgramTimeline *timeline = _pcrTimelines[@(pid)];
+                const NSUInteger epochCount = timeline.discontinuityCount;
+                [timeline addPcrBase:pcrBase isDiscontinuous:(adaptationFlags & 0x80) != 0];
+                // A new epoch is always sampled, so a sample and the PCRs after it share an epoch
+                if (state->lastPcrSample == kNoPcr || pcr < state->lastPcrSample
+                    || pcr - state->lastPcrSample >= pcrIntervalTicks || timeline.discontinuityCount != epochCount) {
+                    TSRandomAccessIndexPcrEntry entry = {
+                        .offset = packetOffset,
+                        .pcr = pcr,
+                        .timelineValue = [timeline projectedValueForTimestamp:pcrBase],
+                        .pid = pid,
+                    };
+                    [_pcrEntries appendBytes:&entry length:sizeof(entry)];
+                    state->lastPcrSample = pcr;
+                }
+            }
+        }
+        if (!(adaptationControl & 0x01) || payloadStart >= TS_PACKET_SIZE_188) {
+            continue;
+        }
+        const uint8_t *payload = packet + payloadStart;
+        NSUInteger payloadLength = TS_PACKET_SIZE_188 - payloadStart;
+
+        if (pusi && state->kind != TSIndexPidKindNone) {
+            // A pending video RAP whose first VCL NAL was never found - keep it only if RAI said so.
+            if (state->rapPending && (state->rapFlags & TSRandomAccessPointFlagRai)) {
+                [self appendRapForPid:pid state:state];
+            }
+            state->rapPending = NO;
+
+            TSPesHeaderInfo pesInfo;
+            if (!TSPesHeaderParse(payload, payloadLength, &pesInfo) || !pesInfo.hasPts) {
+                continue;
+            }
+            state->rapOffset = packetOffset;
+            state->rapPts = pesInfo.pts;
+            state->rapFlags = (adaptationFlags & 0x40) ? TSRandomAccessPointFlagRai : 0;
+
+            if (state->kind == TSIndexPidKindNalVideo) {
+                state->rapPending = YES;
+                state->rapPacketsScanned = 0;
+                payload += pesInfo.payloadOffset;
+                payloadLength -= pesInfo.payloadOffset;
+            } else if (state->rapFlags) {
+                [self appendRapForPid:pid state:state];
+                continue;
+            }
+        }
+
+        if (state->rapPending) {
+            const TSVclScanResult result = scanForFirstVcl(payload, payloadLength, state->codec);
+            if (result == TSVclScanResultKeyframe) {
+                state->rapFlags |= TSRandomAccessPointFlagKeyframe;
+            }
+            if (result != TSVclScanResultNotFound || ++state->rapPacketsScanned >= MAX_RAP_SCAN_PACKETS) {
+                state->rapPending = NO;
+                if (state->rapFlags) {
+                    [self appendRapForPid:pid state:state];
+                }
+            }
+        }
+    }
+
+    _streamOffset += length;
+}
+
+-(void)appendRapForPid:(uint16_t)pid state:(TSIndexPidState *)state
+{
+    NSMutableData *raps = _rapsByPid[@(pid)];
+    if (!raps) {
+        raps = [NSMutableData data];
+        _rapsByPid[@(pid)] = raps;
+    }
+    TSRandomAccessIndexRapEntry entry = { .offset = state->rapOffset, .pts = state->rapPts, .flags = state->rapFlags };
+    [raps appendBytes:&entry length:sizeof(entry)];
+}
+
+-(NSData *)finish
+{
+    // Flush PES packets still waiting for their first VCL NAL unit.
+    for (NSUInteger pid = 0; pid < PID_COUNT; pid++) {
+        TSIndexPidState *state = &_pids[pid];
+        if (state->rapPending && state->rapFlags) {
+            [self appendRapForPid:pid state:state];
+        }
+        state->rapPending = NO;
+    }
+
+    NSArray<Pid> *pids = [_rapsByPid.allKeys sortedArrayUsingSelector:@selector(compare:)];
+
+    NSMutableData *pidEntries = [NSMutableData data];
+    NSMutableData *rapEntries = [NSMutableData data];
+    for (Pid pid in pids) {
+        NSData *raps = _rapsByPid[pid];
+        TSRandomAccessIndexPidEntry entry = {
+            .pid = pid.unsignedShortValue,
+            .streamType = _pids[pid.unsignedShortValue].streamType,
+            .firstRap = (uint32_t)(rapEntries.length / sizeof(TSRandomAccessIndexRapEntry)),
+            .rapCount = (uint32_t)(raps.length / sizeof(TSRandomAccessIndexRapEntry)),
+        };
+        [pidEntries appendBytes:&entry length:sizeof(entry)];
+        [rapEntries appendData:raps];
+    }
+
+    TSRandomAccessIndexHeader header = {
+        .magic = TS_RANDOM_ACCESS_INDEX_MAGIC,
+        .version = TS_RANDOM_ACCESS_INDEX_VERSION,
+        .packetSize = (uint16_t)_packetSize,
+        .indexedLength = _streamOffset,
+        .psiCount = (uint32_t)(_psiEntries.length / sizeof(TSRandomAccessIndexPsiEntry)),
+        .pidCount = (uint32_t)pids.count,
+        .rapCount = (uint32_t)(rapEntries.length / sizeof(TSRandomAccessIndexRapEntry)),
+        .pcrCount = (uint32_t)(_pcrEntries.length / sizeof(TSRandomAccessIndexPcrEntry)),
+        .byteOrderMark = TS_RANDOM_ACCESS_INDEX_BYTE_ORDER_MARK,
+    };
+
+    NSMutableData *index = [NSMutableData dataWithCapacity:sizeof(header) + _psiEntries.length
+                            + pidEntries.length + rapEntries.length + _pcrEntries.length];
+    [index appendBytes:&header length:sizeof(header)];
+    [index appendData:_psiEntries];
+    [index appendData:pidEntries];
+    [index appendData:rapEntries];
+    [index appendData:_pcrEntries];
+
+    TSLogInfo(@"Indexed %llu bytes: %u PSI versions, %u PIDs, %u RAPs, %u PCR samples",
+              _streamOffset, header.psiCount, header.pidCount, header.rapCount, header.pcrCount);
+    return index;
+}
+
++(NSData * _Nullable)indexDataForFileAtPath:(NSString *)path mode:(TSDemuxerMode)mode
+{
+    NSData *file = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    if (!file) {
+        TSLogError(@"Failed to read %@", path);
+        return nil;
+    }
+
+    TSRandomAccessIndexBuilder *builder = [[TSRandomAccessIndexBuilder alloc] initWithMode:mode];
+    const NSUInteger packetSize = TSPacketDetectSizeOfChunk(file.bytes, file.length);
+    const NSUInteger chunkSize = FILE_CHUNK_NUM_PACKETS * packetSize;
+    const uint8_t *bytes = file.bytes;
+
+    for (NSUInteger pos = 0; pos < file.length; pos += chunkSize) {
+        @autoreleasepool {
+            const NSUInteger length = MIN(chunkSize, file.length - pos);
+            NSData *chunk = [NSData dataWithBytesNoCopy:(void *)(bytes + pos) length:length freeWhenDone:NO];
+            [builder addData:chunk];
+        }
+    }
+    return [builder finish];
+}
+
+#pragma mark TSDemuxerDelegate
+
+-(void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat
+{
+    TSRandomAccessIndexPsiEntry entry = {
+        .offset = _pids[_currentPid].psiSectionStart,
+        .endOffset = _currentPacketOffset + _packetSize,
+        .pid = _currentPid,
+        .tableId = TABLE_ID_PAT,
+        .versionNumber = pat.psi.versionNumber,
+    };
+    [_psiEntries appendBytes:&entry length:sizeof(entry)];
+
+    NSDictionary<ProgramNumber, PmtPid> *programmes = pat.programmes;
+    for (ProgramNumber programNumber in programmes) {
+        if (programNumber.unsignedShortValue == PROGRAM_NUMBER_NETWORK_INFO) {
+            continue;
+        }
+        _pids[programmes[programNumber].unsignedShortValue].kind = TSIndexPidKindPsi;
+    }
+}
+
+-(void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt
+{
+    TSRandomAccessIndexPsiEntry entry = {
+        .offset = _pids[_currentPid].psiSectionStart,
+        .endOffset = _currentPacketOffset + _packetSize,
+        .pid = _currentPid,
+        .tableId = TABLE_ID_PMT,
+        .versionNumber = pmt.psi.versionNumber,
+        .programNumber = pmt.programNumber,
+    };
+    [_psiEntries appendBytes:&entry length:sizeof(entry)];
+
+    for (TSElementaryStream *es in pmt.elementaryStreams) {
+        TSIndexPidState *state = &_pids[es.pid];
+        if (state->kind == TSIndexPidKindPsi) {
+            continue;
+        }
+        state->streamType = es.streamType;
+        const TSResolvedStreamType resolved = es.resolvedStreamType;
+        if (resolved == TSResolvedStreamTypeH264 || resolved == TSResolvedStreamTypeH265) {
+            state->kind = TSIndexPidKindNalVideo;
+            state->codec = resolved == TSResolvedStreamTypeH265 ? TSNalUnitCodecH265 : TSNalUnitCodecH264;
+        } else {
+            state->kind = TSIndexPidKindEs;
+        }
+    }
+    if (pmt.pcrPid < PID_NULL_PACKET) {
+        _pids[pmt.pcrPid].isPcrPid = YES;
+        if (!_pcrTimelines[@(pmt.pcrPid)]) {
+            _pcrTimelines[@(pmt.pcrPid)] = [TSProgramTimeline new];
+        }
+    }
+}
+
+-(void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit
+{
+    // Elementary stream packets are never passed to the demuxer.
+}
+
+@end
@@ -6,6 +6,7 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "../TSContinuityState.h"
 @class TSPacket;
 @class TSTr101290Statistics;
 @class TSTr101290AnalyzeContext;
@@ -14,9 +15,16 @@
 
 @property(nonatomic, strong, readonly) TSTr101290Statistics * _Nonnull stats;
 
+/// Checks the continuity counter against the last packet analyzed on its PID.
 -(void)analyzeTsPacket:(TSPacket* _Nonnull)tsPacket
                context:(TSTr101290AnalyzeContext* _Nonnull)context;
 
+/// Analyzes a packet whose continuity counter was already checked, e.g. by the demuxer while
+/// feeding its stream builders, so that both agree on it.
+-(void)analyzeTsPacket:(TSPacket* _Nonnull)tsPacket
+            continuity:(TSContinuityVerdict)continuity
+               context:(TSTr101290AnalyzeContext* _Nonnull)context;
+
 /// Resets CC and last-seen state for PIDs transitioning from excluded to included.
 /// Call when esPidFilter changes to prevent false positives from stale state.
 -(void)handleFilterChangeFromOldFilter:(NSSet<NSNumber*>* _Nullable)oldFilter
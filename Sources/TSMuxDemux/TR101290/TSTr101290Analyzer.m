@@ -14,83 +14,10 @@
 #import "../Table/TSProgramMapTable.h"
 #import "../Table/TSProgramSpecificInformationTable.h"
 #import "../TSPacket.h"
+#import "../TSContinuityState.h"
 #import "../TSElementaryStream.h"
 #import "../Descriptor/TSISO639LanguageDescriptor.h"
 
-#pragma mark - TSContinuityCounter
-
-@interface TSContinuityCounter: NSObject
--(NSString* _Nullable)validateContinuityCounter:(TSPacket* _Nonnull)currentPacket;
-@end
-
-@implementation TSContinuityCounter
-{
-    BOOL mHasLastCC;
-    BOOL mHasSecondLastCC;
-    uint8_t mLastCC;
-    uint8_t mSecondLastCC;
-}
-
--(NSString* _Nullable)validateContinuityCounter:(TSPacket* _Nonnull)currentPacket
-{
-    NSString *error = [self validateCurrentPacket:currentPacket];
-
-    // Start over on discontinuity
-    if (currentPacket.adaptationField.discontinuityFlag) {
-        mHasSecondLastCC = NO;
-    } else {
-        mHasSecondLastCC = mHasLastCC;
-        mSecondLastCC = mLastCC;
-    }
-    mHasLastCC = YES;
-    mLastCC = currentPacket.header.continuityCounter;
-
-    return error;
-}
-
--(NSString* _Nullable)validateCurrentPacket:(TSPacket*)currentPacket
-{
-    if (!mHasLastCC || currentPacket.adaptationField.discontinuityFlag) {
-        // The continuity counter may be discontinuous when the discontinuity_indicator is set to '1' (refer to 2.4.3.4).
-        return nil;
-    }
-
-    // The continuity_counter shall not be incremented when the adaptation_field_control of the packet equals '00' or '10'.
-    BOOL isExpectingIncrementedCC =
-        currentPacket.header.adaptationMode != TSAdaptationModeReserved &&
-        currentPacket.header.adaptationMode != TSAdaptationModeAdaptationOnly;
-    BOOL isDuplicate = currentPacket.header.continuityCounter == mLastCC;
-    uint8_t nextExpectedCc = [self nextContinuityCounter:mLastCC];
-
-    if (isExpectingIncrementedCC && currentPacket.header.continuityCounter != nextExpectedCc) {
-        BOOL tooManyDuplicates = mHasSecondLastCC && mSecondLastCC == mLastCC;
-        if (!isDuplicate) {
-            return [NSString stringWithFormat:@"Got %u but expected incremented (%u) or duplicate CC (%u)",
-                    currentPacket.header.continuityCounter,
-                    nextExpectedCc,
-                    mLastCC
-            ];
-        } else if (tooManyDuplicates) {
-            return [NSString stringWithFormat:@"Too many packets (>= 3) with same CC (%u)", currentPacket.header.continuityCounter];
-        }
-    } else if (!isExpectingIncrementedCC && !isDuplicate) {
-        return [NSString stringWithFormat:@"Got %u but expected duplicate/not-incremented CC (%u)",
-                currentPacket.header.continuityCounter,
-                mLastCC
-        ];
-    }
-    return nil;
-}
-
--(uint8_t)nextContinuityCounter:(uint8_t)currentContinuityCounter
-{
-    static const NSUInteger MAX_VALUE = 16;
-    return (currentContinuityCounter + 1) % MAX_VALUE;
-}
-
-@end
-
-
 #pragma mark - TSTr101290Analyzer
 
 @implementation TSTr101290Analyzer
@@ -109,8 +36,8 @@
     // Key = pid, Value = timestamp when this PID was last seen (for PID error check)
     NSMutableDictionary<NSNumber*, NSNumber*> * _Nonnull mPidLastSeenMsMap;
 
-    // Key = pid, Value = cc validator
-    NSMutableDictionary<NSNumber*, TSContinuityCounter*> * _Nonnull mPidCcValidatorMap;
+    // CC state per PID, used when packets are analyzed without a verdict from the demuxer
+    TSContinuityStates * _Nonnull mCcStates;
 
     // Timestamp of last interval check (throttle to every 200ms for efficiency)
     uint64_t mLastIntervalCheckMs;
@@ -126,18 +53,33 @@
         mSectionLastSeenMsMap = [NSMutableDictionary dictionary];
         mIntervalErrorLastReportedMsMap = [NSMutableDictionary dictionary];
         mPidLastSeenMsMap = [NSMutableDictionary dictionary];
-        mPidCcValidatorMap = [NSMutableDictionary dictionary];
+        mCcStates = calloc(1, sizeof(TSContinuityStates));
     }
     return self;
 }
 
+-(void)dealloc
+{
+    free(mCcStates);
+}
+
+-(void)analyzeTsPacket:(TSPacket* _Nonnull)tsPacket
+               context:(TSTr101290AnalyzeContext* _Nonnull)context
+{
+    [self analyzeTsPacket:tsPacket
+               continuity:TSContinuityStatesCheckPacket(mCcStates, tsPacket)
+                  context:context];
+}
+
 -(void)analyzeTsPacket:(TSPacket* _Nonnull)tsPacket
+            continuity:(TSContinuityVerdict)continuity
                context:(TSTr101290AnalyzeContext* _Nonnull)context
 {
-    [self performPrio1Analysis:tsPacket context:context];
+    [self performPrio1Analysis:tsPacket continuity:continuity context:context];
 }
 
 -(void)performPrio1Analysis:(TSPacket* _Nonnull)tsPacket
+                 continuity:(TSContinuityVerdict)continuity
                     context:(TSTr101290AnalyzeContext* _Nonnull)context
 {
     [self checkTsSyncLoss:tsPacket];
@@ -156,7 +98,7 @@
         [self checkSyncByteError:tsPacket];
         [self checkPatError:tsPacket context:context checkIntervalError:checkIntervalError];
         [self checkPmtError:tsPacket context:context checkIntervalError:checkIntervalError];
-        [self checkCcError:tsPacket];
+        [self checkCcError:continuity];
         [self checkPidError:tsPacket context:context checkIntervalError:checkIntervalError];
 
         mPidLastSeenMsMap[@(tsPacket.header.pid)] = @(context.nowMs);
@@ -226,16 +168,11 @@
     }
 }
 
--(void)checkCcError:(TSPacket * _Nonnull)tsPacket
+-(void)checkCcError:(TSContinuityVerdict)continuity
 {
-    NSNumber *key = @(tsPacket.header.pid);
-    TSContinuityCounter *validator = mPidCcValidatorMap[key];
-    if (!validator) {
-        validator = [TSContinuityCounter new];
-        mPidCcValidatorMap[key] = validator;
-    }
-    
-    if ([validator validateContinuityCounter:tsPacket]) {
+    // Incorrect packet order, a packet occurring more than twice or a lost packet.
+    // Adaptation-only packets keep the CC of the packet before, so their duplicates are fine.
+    if (continuity.result == TSContinuityCheckResultGap || continuity.isRepeatedDuplicate) {
         _stats.prio1.ccError++;
     }
 }
@@ -407,19 +344,17 @@
     // 3) Filter = {256} (re-include), next packet has CC=7
     // Without reset, CC jump from 2->7 would be flagged as error
 
-    NSMutableArray<NSNumber*> *pidsToReset = [NSMutableArray array];
-
-    // Reset CC validators for newly included PIDs
-    for (NSNumber *pid in mPidCcValidatorMap) {
-        if ([self wasPid:pid excludedByFilter:oldFilter] &&
-            [self willPid:pid beIncludedByFilter:newFilter]) {
-            [pidsToReset addObject:pid];
+    // Reset CC state for newly included PIDs
+    for (uint16_t pid = 0; pid < TS_PID_COUNT; pid++) {
+        if (mCcStates->pids[pid] != 0 &&
+            [self wasPid:@(pid) excludedByFilter:oldFilter] &&
+            [self willPid:@(pid) beIncludedByFilter:newFilter]) {
+            TSContinuityStatesReset(mCcStates, pid);
         }
     }
-    [mPidCcValidatorMap removeObjectsForKeys:pidsToReset];
 
     // Reset last-seen timestamps for newly included PIDs
-    [pidsToReset removeAllObjects];
+    NSMutableArray<NSNumber*> *pidsToReset = [NSMutableArray array];
     for (NSNumber *pid in mPidLastSeenMsMap) {
         if ([self wasPid:pid excludedByFilter:oldFilter] &&
             [self willPid:pid beIncludedByFilter:newFilter]) {
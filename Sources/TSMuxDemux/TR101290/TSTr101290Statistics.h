@@ -50,4 +50,17 @@
 
 @property(nonatomic, strong, readonly) TSTr10129Prio1 * _Nullable prio1;
 
+/**
+ 204-byte packets corrected with their RS(204,188) parity (TSDemuxer.reedSolomonCorrection),
+ and the number of bytes corrected in them.
+ */
+@property(nonatomic) uint64_t rsCorrectedPackets;
+@property(nonatomic) uint64_t rsCorrectedBytes;
+
+/**
+ 204-byte packets with more errors than the parity can correct. They get the transport error indicator
+ set, as a demodulator would, and are dropped.
+ */
+@property(nonatomic) uint64_t rsUncorrectablePackets;
+
 @end
@@ -10,6 +10,7 @@
 #import <CoreMedia/CoreMedia.h>
 #import "TSStreamType.h"
 @class TSDescriptor;
+@class TSNalUnitIndex;
 
 /// See "Rec. ITU-T H.222.0 (03/2017)"
 /// section "2.4.3.6 PES packet" page 37
@@ -23,6 +24,13 @@
 /// Set to kCMTimeInvalid to represent "No DTS".
 @property(nonatomic, readonly) CMTime dts;
 
+/// PTS/DTS on the program's continuous 64-bit timeline (see `TSProgramTimeline`): unlike `pts`/`dts`,
+/// they do not wrap after 26.5 hours and continue across discontinuities, aligned between the
+/// program's streams. Set by the demuxer; equal to `pts`/`dts` otherwise. Use `pts`/`dts` with the
+/// program clocks (`TSPcrUtcClock`, `TSPcrClockRecovery`), which work on the raw values.
+@property(nonatomic, readonly) CMTime timelinePts;
+@property(nonatomic, readonly) CMTime timelineDts;
+
 /// Set to true if the ts packet is flagged as discontinuous. Should be used as a hint to e.g. reset PTS-anchors etc.
 @property(nonatomic, readonly) BOOL isDiscontinuous;
 
@@ -36,6 +44,15 @@
 
 @property(nonatomic, readonly, nonnull) NSData *compressedData;
 
+/// NAL unit table for H.264/HEVC access units. Only set by the demuxer when NAL indexing is
+/// enabled for the PID (see `TSDemuxer.nalIndexingPids`), nil otherwise.
+@property(nonatomic, readonly, nullable) TSNalUnitIndex *nalUnitIndex;
+
+/// Set by the demuxer when the access unit exceeded its buffering limit and was delivered with
+/// only the bytes collected up to the limit (see `TSDemuxer.overflowPolicy`).
+@property(nonatomic, readonly) BOOL isTruncated;
+
+/// An access unit to mux: the timeline timestamps equal `pts`/`dts`, without NAL unit index.
 -(instancetype _Nonnull)initWithPid:(uint16_t)pid
                                 pts:(CMTime)pts
                                 dts:(CMTime)dts
@@ -45,6 +62,20 @@
                          descriptors:(NSArray<TSDescriptor*>* _Nullable)descriptors
                      compressedData:(NSData* _Nonnull)compressedData;
 
+/// Designated initializer, with the fields set by the demuxer.
+-(instancetype _Nonnull)initWithPid:(uint16_t)pid
+                                pts:(CMTime)pts
+                                dts:(CMTime)dts
+                        timelinePts:(CMTime)timelinePts
+                        timelineDts:(CMTime)timelineDts
+                    isDiscontinuous:(BOOL)isDiscontinuous
+                 isRandomAccessPoint:(BOOL)isRandomAccessPoint
+                         streamType:(uint8_t)streamType
+                         descriptors:(NSArray<TSDescriptor*>* _Nullable)descriptors
+                     compressedData:(NSData* _Nonnull)compressedData
+                       nalUnitIndex:(TSNalUnitIndex* _Nullable)nalUnitIndex
+                        isTruncated:(BOOL)isTruncated;
+
 /// Creates a PES-packet from the access unit.
 /// PTS/DTS are converted to the MPEG-TS 90 kHz timescale, relative to epoch.
 /// When epoch is valid, PTS/DTS are offset by the epoch (subtracted) so that timestamps
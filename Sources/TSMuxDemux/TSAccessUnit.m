@@ -24,17 +24,48 @@
                          streamType:(uint8_t)streamType
                         descriptors:(NSArray<TSDescriptor *> * _Nullable)descriptors
                      compressedData:(NSData * _Nonnull)compressedData
+{
+    return [self initWithPid:pid
+                         pts:pts
+                         dts:dts
+                 timelinePts:pts
+                 timelineDts:dts
+             isDiscontinuous:isDiscontinuous
+          isRandomAccessPoint:isRandomAccessPoint
+                  streamType:streamType
+                 descriptors:descriptors
+              compressedData:compressedData
+                nalUnitIndex:nil
+                 isTruncated:NO];
+}
+
+-(instancetype _Nonnull)initWithPid:(uint16_t)pid
+                                pts:(CMTime)pts
+                                dts:(CMTime)dts
+                        timelinePts:(CMTime)timelinePts
+                        timelineDts:(CMTime)timelineDts
+                    isDiscontinuous:(BOOL)isDiscontinuous
+                 isRandomAccessPoint:(BOOL)isRandomAccessPoint
+                         streamType:(uint8_t)streamType
+                        descriptors:(NSArray<TSDescriptor *> * _Nullable)descriptors
+                     compressedData:(NSData * _Nonnull)compressedData
+                       nalUnitIndex:(TSNalUnitIndex * _Nullable)nalUnitIndex
+                        isTruncated:(BOOL)isTruncated
 {
     self = [super init];
     if (self) {
         _pid = pid;
         _pts = pts;
         _dts = dts;
+        _timelinePts = timelinePts;
+        _timelineDts = timelineDts;
         _isDiscontinuous = isDiscontinuous;
         _isRandomAccessPoint = isRandomAccessPoint;
         _streamType = streamType;
         _descriptors = descriptors;
         _compressedData = compressedData;
+        _nalUnitIndex = nalUnitIndex;
+        _isTruncated = isTruncated;
     }
     return self;
 }
@@ -27,8 +27,15 @@ FOUNDATION_EXPORT uint32_t const TS_TIMESTAMP_TIMESCALE;
 /// Safe because pcrBase is a 33-bit field (max legitimate value is 2^33-1).
 FOUNDATION_EXPORT uint64_t const kNoPcr;
 
+/// Sentinel value meaning "no splicing point".
+/// Safe because splice_countdown is an 8-bit signed field.
+FOUNDATION_EXPORT int16_t const kNoSpliceCountdown;
+
 FOUNDATION_EXPORT uint8_t const TS_PACKET_SIZE_188;
+FOUNDATION_EXPORT uint8_t const TS_PACKET_SIZE_192;
 FOUNDATION_EXPORT uint8_t const TS_PACKET_SIZE_204;
+/// TP_extra_header before each 188-byte packet of 192-byte M2TS/BDAV packets.
+FOUNDATION_EXPORT uint8_t const TS_M2TS_HEADER_SIZE;
 FOUNDATION_EXPORT uint8_t const TS_RS_PARITY_SIZE;
 FOUNDATION_EXPORT uint8_t const TS_PACKET_HEADER_SIZE;
 FOUNDATION_EXPORT uint8_t const TS_PACKET_HEADER_SYNC_BYTE;
@@ -50,8 +57,18 @@ FOUNDATION_EXPORT NSUInteger const PID_NULL_PACKET;
 FOUNDATION_EXPORT NSUInteger const PROGRAM_NUMBER_NETWORK_INFO;
 
 // DVB EN 300 468 Service Information (SI)
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_NIT_ACTUAL_NETWORK;
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_NIT_OTHER_NETWORK;
 FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_SDT_ACTUAL_TS;
 FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_SDT_OTHER_TS;
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_EIT_PF_ACTUAL_TS;
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_EIT_PF_OTHER_TS;
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_EIT_SCHEDULE_ACTUAL_TS_FIRST;
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_EIT_SCHEDULE_ACTUAL_TS_LAST;
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_EIT_SCHEDULE_OTHER_TS_FIRST;
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_EIT_SCHEDULE_OTHER_TS_LAST;
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_TDT;
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_DVB_TOT;
 FOUNDATION_EXPORT NSUInteger const PID_DVB_NIT_ST;
 FOUNDATION_EXPORT NSUInteger const PID_DVB_SDT_BAT_ST;
 FOUNDATION_EXPORT NSUInteger const PID_DVB_EIT_ST_CIT;
@@ -79,6 +96,9 @@ FOUNDATION_EXPORT NSUInteger const TABLE_ID_ATSC_ETT;   // Extended Text Table
 FOUNDATION_EXPORT NSUInteger const TABLE_ID_ATSC_STT;   // System Time Table
 FOUNDATION_EXPORT NSUInteger const PID_ATSC_PSIP;       // PSIP base PID
 
+// ANSI/SCTE 35 Digital Program Insertion Cueing Message
+FOUNDATION_EXPORT NSUInteger const TABLE_ID_SCTE35_SPLICE_INFO;
+
 // ETSI TR 101 290 - DVB Measurement guidelines for DVB systems
 // https://www.etsi.org/deliver/etsi_tr/101200_101299/101290/01.05.01_60/tr_101290v010501p.pdf
 FOUNDATION_EXPORT uint64_t const TR101290_PAT_PMT_INTERVAL_MS;  // PAT/PMT must occur every 500ms
@@ -10,9 +10,12 @@
 
 uint32_t const TS_TIMESTAMP_TIMESCALE = 90000;
 uint64_t const kNoPcr = UINT64_MAX;
+int16_t const kNoSpliceCountdown = INT16_MAX;
 
 uint8_t const TS_PACKET_SIZE_188 = 188;
+uint8_t const TS_PACKET_SIZE_192 = 192;
 uint8_t const TS_PACKET_SIZE_204 = 204;
+uint8_t const TS_M2TS_HEADER_SIZE = 4;
 uint8_t const TS_RS_PARITY_SIZE = 16;
 uint8_t const TS_PACKET_HEADER_SIZE = 4;
 uint8_t const TS_PACKET_HEADER_SYNC_BYTE = 0x47;
@@ -32,8 +35,18 @@ NSUInteger const PID_NULL_PACKET = 0x1FFF;
 NSUInteger const PROGRAM_NUMBER_NETWORK_INFO = 0x00;
 
 // DVB EN 300 468 Service Information (SI)
+NSUInteger const TABLE_ID_DVB_NIT_ACTUAL_NETWORK = 0x40;
+NSUInteger const TABLE_ID_DVB_NIT_OTHER_NETWORK = 0x41;
 NSUInteger const TABLE_ID_DVB_SDT_ACTUAL_TS = 0x42;
 NSUInteger const TABLE_ID_DVB_SDT_OTHER_TS = 0x46;
+NSUInteger const TABLE_ID_DVB_EIT_PF_ACTUAL_TS = 0x4E;
+NSUInteger const TABLE_ID_DVB_EIT_PF_OTHER_TS = 0x4F;
+NSUInteger const TABLE_ID_DVB_EIT_SCHEDULE_ACTUAL_TS_FIRST = 0x50;
+NSUInteger const TABLE_ID_DVB_EIT_SCHEDULE_ACTUAL_TS_LAST = 0x5F;
+NSUInteger const TABLE_ID_DVB_EIT_SCHEDULE_OTHER_TS_FIRST = 0x60;
+NSUInteger const TABLE_ID_DVB_EIT_SCHEDULE_OTHER_TS_LAST = 0x6F;
+NSUInteger const TABLE_ID_DVB_TDT = 0x70;
+NSUInteger const TABLE_ID_DVB_TOT = 0x73;
 NSUInteger const PID_DVB_NIT_ST = 0x10;
 NSUInteger const PID_DVB_SDT_BAT_ST = 0x11;
 NSUInteger const PID_DVB_EIT_ST_CIT = 0x12;
@@ -61,6 +74,9 @@ NSUInteger const TABLE_ID_ATSC_ETT  = 0xCC;
 NSUInteger const TABLE_ID_ATSC_STT  = 0xCD;
 NSUInteger const PID_ATSC_PSIP = 0x1FFB;
 
+// ANSI/SCTE 35 Digital Program Insertion Cueing Message
+NSUInteger const TABLE_ID_SCTE35_SPLICE_INFO = 0xFC;
+
 // ETSI TR 101 290 - DVB Measurement guidelines for DVB systems
 uint64_t const TR101290_PAT_PMT_INTERVAL_MS = 500;
 uint64_t const TR101290_PID_INTERVAL_MS = 5000;
@@ -6,20 +6,13 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "TSContinuityState.h"
 @class TSPacket;
 
-/// Result of continuity counter validation
-typedef NS_ENUM(NSUInteger, TSContinuityCheckResult) {
-    /// Normal packet - continue processing
-    TSContinuityCheckResultOK,
-    /// Duplicate CC (retransmission) - skip this packet
-    TSContinuityCheckResultDuplicate,
-    /// CC gap detected (packets were lost) - discard in-progress data
-    TSContinuityCheckResultGap,
-};
-
 /// Tracks and validates continuity counter for a single PID.
 /// Create one instance per PID being tracked.
+/// A wrapper of a TSContinuityState, which the demuxer now checks once per packet for all consumers.
+__attribute__((deprecated("Use TSContinuityState and TSContinuityStateCheckPacket")))
 @interface TSContinuityChecker : NSObject
 
 /// Validates the continuity counter of the given packet.
@@ -0,0 +1,101 @@
+//
+//  TSContinuityState.h
+//  TSMuxDemux
+//
+//  Validates TS packet continuity counter per ITU-T H.222.0 §2.4.3.3
+//
+
+#import <Foundation/Foundation.h>
+#import "TSPidBitmap.h"
+#import "TSPacket.h"
+
+/// Result of continuity counter validation
+typedef NS_ENUM(NSUInteger, TSContinuityCheckResult) {
+    /// Normal packet - continue processing
+    TSContinuityCheckResultOK,
+    /// Duplicate CC (retransmission) - skip this packet
+    TSContinuityCheckResultDuplicate,
+    /// CC gap detected (packets were lost) - discard in-progress data
+    TSContinuityCheckResultGap,
+};
+
+/// Outcome of the continuity check of one packet, shared by the stream builders and the TR 101 290 analyzer.
+typedef struct {
+    TSContinuityCheckResult result;
+    /// The discontinuity_indicator was set: the CC was not checked.
+    BOOL isDiscontinuity;
+    /// A packet with payload and the same CC as the two packets before it. More than one duplicate
+    /// is not allowed (TR 101 290 1.4).
+    BOOL isRepeatedDuplicate;
+} TSContinuityVerdict;
+
+/// Continuity state of one PID: the last CC (bits 0-3) and flags.
+typedef uint8_t TSContinuityState;
+
+#define TS_CONTINUITY_HAS_LAST_CC       0x10
+#define TS_CONTINUITY_LAST_WAS_REPEAT   0x20
+
+/// Continuity state of every PID, indexed by PID. Zeroed = nothing seen yet.
+typedef struct {
+    TSContinuityState pids[TS_PID_COUNT];
+} TSContinuityStates;
+
+/// Validates `cc` against `state` and updates it.
+static inline TSContinuityVerdict TSContinuityStateCheck(TSContinuityState *state,
+                                                         uint8_t cc,
+                                                         TSAdaptationMode adaptationMode,
+                                                         BOOL discontinuityFlag)
+{
+    TSContinuityVerdict verdict = { TSContinuityCheckResultOK, discontinuityFlag, NO };
+
+    // Per ITU-T H.222.0 §2.4.3.3:
+    // - CC increments only when packet contains payload (not adaptation-only)
+    // - Discontinuity flag allows CC to be discontinuous
+    // - Duplicate packets (same CC) are allowed for retransmission
+    const BOOL isExpectingIncrementedCC =
+        adaptationMode != TSAdaptationModeReserved &&
+        adaptationMode != TSAdaptationModeAdaptationOnly;
+    const BOOL hasLastCC = (*state & TS_CONTINUITY_HAS_LAST_CC) != 0;
+    const uint8_t lastCC = *state & 0x0F;
+    const BOOL isDuplicate = hasLastCC && cc == lastCC;
+
+    if (hasLastCC && !discontinuityFlag) {
+        if (isExpectingIncrementedCC) {
+            // Packet has payload: expect incremented CC or duplicate (retransmission)
+            if (isDuplicate) {
+                verdict.result = TSContinuityCheckResultDuplicate;
+                verdict.isRepeatedDuplicate = (*state & TS_CONTINUITY_LAST_WAS_REPEAT) != 0;
+            } else if (cc != ((lastCC + 1) & 0x0F)) {
+                verdict.result = TSContinuityCheckResultGap;
+            }
+        } else {
+            // Adaptation only (no payload): CC should not change
+            verdict.result = isDuplicate ? TSContinuityCheckResultDuplicate : TSContinuityCheckResultGap;
+        }
+    }
+
+    // Duplicates are counted again from a discontinuity
+    const BOOL isRepeat = isDuplicate && !discontinuityFlag;
+    *state = (cc & 0x0F) | TS_CONTINUITY_HAS_LAST_CC | (isRepeat ? TS_CONTINUITY_LAST_WAS_REPEAT : 0);
+    return verdict;
+}
+
+static inline TSContinuityVerdict TSContinuityStateCheckPacket(TSContinuityState *state, TSPacket * _Nonnull packet)
+{
+    TSPacketHeader *header = packet.header;
+    return TSContinuityStateCheck(state,
+                                  header.continuityCounter,
+                                  header.adaptationMode,
+                                  packet.adaptationField.discontinuityFlag);
+}
+
+static inline TSContinuityVerdict TSContinuityStatesCheckPacket(TSContinuityStates *states, TSPacket * _Nonnull packet)
+{
+    return TSContinuityStateCheckPacket(&states->pids[packet.header.pid & (TS_PID_COUNT - 1)], packet);
+}
+
+/// Forgets the last CC of `pid`, e.g. when its packets were not followed for a while.
+static inline void TSContinuityStatesReset(TSContinuityStates *states, uint16_t pid)
+{
+    states->pids[pid & (TS_PID_COUNT - 1)] = 0;
+}
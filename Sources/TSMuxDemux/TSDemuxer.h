@@ -9,29 +9,47 @@
 #import <Foundation/Foundation.h>
 #import "TSConstants.h"
 #import "TSAccessUnit.h"
+#import "TSElementaryStreamBuilder.h"
 #import "Table/TSProgramMapTable.h"
 #import "Table/TSProgramAssociationTable.h"
 #import "Table/DVB/TSDvbServiceDescriptionTable.h"
+#import "Table/DVB/TSDvbEpgStore.h"
+#import "Table/DVB/TSDvbNetworkInformationTable.h"
+#import "Table/DVB/TSDvbTimeTable.h"
 #import "Table/ATSC/TSAtscVirtualChannelTable.h"
+#import "Table/ATSC/TSAtscMasterGuideTable.h"
+#import "Table/ATSC/TSAtscSystemTimeTable.h"
+#import "Table/ATSC/TSAtscEventInformationTable.h"
+#import "Table/ATSC/TSAtscExtendedTextTable.h"
+#import "Table/SCTE35/TSScte35SpliceInfoSection.h"
 #import "TR101290/TSTr101290Statistics.h"
+#import "TSPcrUtcClock.h"
+#import "TSPcrClockRecovery.h"
+#import "TSProgramTimeline.h"
 
 @class TSDemuxer;
 
 /**
  * DVB Mode Support:
  * - SDT (Service Description Table): IMPLEMENTED
- * - NIT (Network Information): PID defined, parsing NOT IMPLEMENTED
- * - EIT (Event Information): PID defined, parsing NOT IMPLEMENTED
- * - TDT/TOT (Time tables): PID defined, parsing NOT IMPLEMENTED
- * - DVB Descriptors: Tags defined, only 0x48 (Service) parsed
+ * - NIT (Network Information): IMPLEMENTED (actual and other networks, on PID 0x10 or the PAT network PID)
+ * - EIT (Event Information): IMPLEMENTED (present/following and schedule, collected in dvb.epg)
+ * - TDT/TOT (Time tables): IMPLEMENTED (also drive the PCR-to-UTC clocks)
+ * - DVB Descriptors: Tags defined, 0x41 (Service List), 0x43/0x44/0x5A (Delivery System), 0x48 (Service)
+ *   and 0x4D (Short Event) parsed
  * - DVB String Encoding: IMPLEMENTED (ISO 6937, ISO 8859-x, UTF-8)
  *
  * ATSC Mode Support:
- * - VCT (Virtual Channel Table): STUB (header only)
- * - MGT (Master Guide Table): NOT IMPLEMENTED
- * - STT (System Time Table): NOT IMPLEMENTED
- * - RRT/EIT/ETT: NOT IMPLEMENTED
+ * - VCT (Virtual Channel Table): IMPLEMENTED (TVCT and CVCT, with service location descriptors)
+ * - MGT (Master Guide Table): IMPLEMENTED (drives which EIT/ETT PIDs are collected)
+ * - STT (System Time Table): IMPLEMENTED (also drives the PCR-to-UTC clocks)
+ * - EIT/ETT: IMPLEMENTED (sections delivered once per version)
+ * - RRT (Rating Region Table): IGNORED (recognised, not parsed)
  * - Stream types 0x81/0x87: IMPLEMENTED (AC-3/E-AC-3)
+ *
+ * Both modes:
+ * - SCTE-35 splice_info_section (stream type 0x86): IMPLEMENTED (splice_insert, time_signal and
+ *   segmentation descriptors)
  */
 
 #pragma mark - Delegate Protocol
@@ -47,17 +65,48 @@
 
 /// DVB-specific callback (only called in TSDemuxerModeDVB)
 -(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveSdt:(TSDvbServiceDescriptionTable* _Nonnull)sdt previousSdt:(TSDvbServiceDescriptionTable* _Nullable)previousSdt;
+/// Called when the NIT of the actual network, or of another network, is new or has changed.
+-(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveNit:(TSDvbNetworkInformationTable* _Nonnull)nit previousNit:(TSDvbNetworkInformationTable* _Nullable)previousNit;
+/// Called for every TDT and TOT received.
+-(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveTimeTable:(TSDvbTimeTable* _Nonnull)timeTable;
 
 /// ATSC-specific callback (only called in TSDemuxerModeATSC)
 -(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveVct:(TSAtscVirtualChannelTable* _Nonnull)vct previousVct:(TSAtscVirtualChannelTable* _Nullable)previousVct;
+-(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveMgt:(TSAtscMasterGuideTable* _Nonnull)mgt previousMgt:(TSAtscMasterGuideTable* _Nullable)previousMgt;
+/// Called for every STT received (typically once per second).
+-(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveStt:(TSAtscSystemTimeTable* _Nonnull)stt;
+/// Called once per EIT/ETT section and version, on the PIDs listed in the MGT.
+-(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveEit:(TSAtscEventInformationTable* _Nonnull)eit;
+-(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveEtt:(TSAtscExtendedTextTable* _Nonnull)ett;
+
+/// Called for every SCTE-35 section received on a PID of stream type 0x86, as soon as its last packet
+/// has been demuxed (repeats included). Cue PIDs are processed regardless of `esPidFilter`.
+-(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveSpliceInfo:(TSScte35SpliceInfoSection* _Nonnull)spliceInfo
+           pid:(uint16_t)pid
+ programNumber:(uint16_t)programNumber;
 
 @end
 
+#pragma mark - PID Subscriber Protocol
+
+/// Receives the access units of the PIDs it is subscribed to. See -[TSDemuxer addSubscriber:forPid:].
+@protocol TSDemuxerPidSubscriber <NSObject>
+-(void)demuxer:(TSDemuxer * _Nonnull)demuxer didReceiveAccessUnit:(TSAccessUnit* _Nonnull)accessUnit;
+@end
+
 #pragma mark - DVB State Wrapper
 
 /// DVB-specific state - accessed via demuxer.dvb
 @interface TSDemuxerDVBState : NSObject
 @property(nonatomic, readonly, nullable) TSDvbServiceDescriptionTable *sdt;
+/// NIT of the network the stream belongs to (table id 0x40).
+@property(nonatomic, readonly, nullable) TSDvbNetworkInformationTable *nit;
+/// NITs of other networks (table id 0x41), keyed by network_id.
+@property(nonatomic, readonly, nonnull) NSDictionary<NSNumber*, TSDvbNetworkInformationTable*> *otherNetworkNits;
+/// The most recent TDT or TOT.
+@property(nonatomic, readonly, nullable) TSDvbTimeTable *timeTable;
+/// Program guide from the EIT sections received so far. Set its delegate for change notifications.
+@property(nonatomic, readonly, nonnull) TSDvbEpgStore *epg;
 @end
 
 #pragma mark - ATSC State Wrapper
@@ -65,6 +114,9 @@
 /// ATSC-specific state - accessed via demuxer.atsc
 @interface TSDemuxerATSCState : NSObject
 @property(nonatomic, readonly, nullable) TSAtscVirtualChannelTable *vct;
+@property(nonatomic, readonly, nullable) TSAtscMasterGuideTable *mgt;
+/// The most recent STT.
+@property(nonatomic, readonly, nullable) TSAtscSystemTimeTable *stt;
 @end
 
 #pragma mark - TSDemuxer
@@ -73,13 +125,45 @@
 
 @property(nonatomic, weak, nullable) id<TSDemuxerDelegate> delegate;
 @property(nonatomic, readonly) TSDemuxerMode mode;
-/// Auto-detected packet size (188 or 204). Returns 0 until detection completes.
+/// Auto-detected packet size (188, 192 or 204), from the periodicity of the sync bytes of the first
+/// chunk. Detected again when two consecutive packets have no sync byte. Returns 0 until detection completes.
 @property(nonatomic, readonly) NSUInteger packetSize;
 
+/// Arrival time of the packet being demuxed, e.g. when called back. For 192-byte M2TS/BDAV packets,
+/// their arrival time stamp unwrapped to a continuous clock (an accurate arrival clock for captures
+/// without host timestamping); otherwise `dataArrivalHostTimeNanos`. Drives the clock recovery and
+/// the TR 101 290 timing.
+@property(nonatomic, readonly) uint64_t arrivalTimeNanos;
+
 /// Elementary stream PIDs to process (whitelist). If nil, all ES PIDs are processed.
 /// PSI PIDs (PAT/PMT/etc) are always processed regardless of this setting.
+/// Packets on excluded PIDs are dropped after reading the PID, before any other parsing.
 @property(nonatomic, copy, nullable) NSSet<NSNumber*> *esPidFilter;
 
+/// H.264/HEVC PIDs for which NAL units are indexed during access unit assembly.
+/// Access units on these PIDs carry a `nalUnitIndex`, and IDR/IRAP access units are flagged
+/// as random access points regardless of the adaptation field. If nil, no indexing is done.
+@property(nonatomic, copy, nullable) NSSet<NSNumber*> *nalIndexingPids;
+
+/// Maximum bytes buffered for one access unit in progress, per ES PID. 0 = unlimited (default).
+/// Guards against PES packets that never end (missing PUSI, corrupt pesPacketLength).
+@property(nonatomic) NSUInteger maxBufferedBytesPerPid;
+
+/// Maximum bytes buffered for access units in progress across all ES PIDs. 0 = unlimited (default).
+@property(nonatomic) NSUInteger maxBufferedBytes;
+
+/// What happens to an access unit that hits either limit. Default TSAssemblyOverflowPolicyTruncate.
+@property(nonatomic) TSAssemblyOverflowPolicy overflowPolicy;
+
+/// Corrects 204-byte packets with their RS(204,188) parity before parsing, instead of ignoring it.
+/// Up to 8 erroneous bytes per packet are corrected; packets with more are dropped. Both are counted
+/// in `statistics`. Default NO.
+@property(nonatomic) BOOL reedSolomonCorrection;
+
+/// Bytes currently buffered for access units in progress, in total and per ES PID.
+@property(nonatomic, readonly) NSUInteger bufferedBytes;
+-(NSDictionary<Pid, NSNumber*>* _Nonnull)bufferedBytesByPid;
+
 @property(nonatomic, readonly, nullable) TSProgramAssociationTable *pat;
 @property(nonatomic, readonly, nonnull) NSDictionary<ProgramNumber,TSProgramMapTable*> *pmts;
 
@@ -99,4 +183,49 @@
 
 -(TSTr101290Statistics* _Nonnull)statistics;
 
+/// Maps the PTS/DTS of a program to UTC, once a time table (DVB TDT/TOT, ATSC STT) has been received.
+/// Programs sharing a PCR PID share a clock. Returns nil until the program's PMT has been received.
+/// The PCR is read regardless of `esPidFilter` and the subscriptions: a PCR PID outside them only feeds the clocks.
+-(TSPcrUtcClock* _Nullable)utcClockForProgram:(uint16_t)programNumber;
+
+/// Relates the PCR of a program to `arrivalTimeNanos`: drift, arrival jitter and a smoothed
+/// mapping from PTS/DTS to host time, e.g. to size a playout buffer. Same lifetime as
+/// `utcClockForProgram:`, and likewise fed regardless of `esPidFilter`.
+-(TSPcrClockRecovery* _Nullable)clockRecoveryForProgram:(uint16_t)programNumber;
+
+/// The continuous timeline of a program's access units (`timelinePts`/`timelineDts`).
+/// Programs sharing a PCR PID share a timeline. Returns nil until the program's PMT has been received.
+-(TSProgramTimeline* _Nullable)timelineForProgram:(uint16_t)programNumber;
+
+/// Number of PCRs the clock recovery fits its line to. Longer windows estimate the drift more
+/// precisely but follow changes more slowly. Default 512 (about 20 s at the usual 40 ms PCR
+/// interval). Changing it restarts the clock recoveries. Raises if < 2.
+@property(nonatomic) NSUInteger clockRecoveryWindowSize;
+
+/// Serialises the PSI state in a compact binary form: the PAT, the PMTs, the DVB SDT and NITs or
+/// the ATSC VCT and MGT, and the configuration (`esPidFilter`, `nalIndexingPids`, buffering limits,
+/// `overflowPolicy`, `reedSolomonCorrection`, `clockRecoveryWindowSize`). Time tables, the EPG,
+/// clocks and access units in progress are not included.
+-(NSData* _Nonnull)psiSnapshot;
+
+/// Warm start: seeds a new demuxer with a `psiSnapshot`, e.g. of the demuxer it replaces after a
+/// restart or an input switch. The configuration is applied and the tables are delivered to the
+/// delegate as if received, so the stream builders are armed from the first packet instead of after
+/// the PAT and every PMT have been received. Live tables replace them when received (with callbacks
+/// only when they differ). Call before the first `demux:`. Returns NO, changing nothing, when the
+/// snapshot is malformed or was taken in another mode.
+-(BOOL)restorePsiSnapshot:(NSData* _Nonnull)snapshot;
+
+/// Subscribes to the access units of an elementary stream PID. Subscribers are held weakly.
+///
+/// Subscribed PIDs are processed in addition to `esPidFilter`. Without `esPidFilter`, subscriptions
+/// only narrow the processed PIDs when the subscribers are the sole consumers, i.e. the demuxer has
+/// no delegate: then only subscribed PIDs are processed, so consumers of different PIDs can share a
+/// demuxer without maintaining a global whitelist. With a delegate, every ES PID is still processed
+/// for it. The delegate receives every access unit that is assembled.
+-(void)addSubscriber:(id<TSDemuxerPidSubscriber> _Nonnull)subscriber forPid:(uint16_t)pid;
+-(void)removeSubscriber:(id<TSDemuxerPidSubscriber> _Nonnull)subscriber forPid:(uint16_t)pid;
+/// Removes the subscriber from all PIDs.
+-(void)removeSubscriber:(id<TSDemuxerPidSubscriber> _Nonnull)subscriber;
+
 @end
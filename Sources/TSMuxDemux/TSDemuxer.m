@@ -9,6 +9,8 @@
 #import "TSDemuxer.h"
 #import "TSConstants.h"
 #import "TSPacket.h"
+#import "TSPidBitmap.h"
+#import "TSContinuityState.h"
 #import "TSLog.h"
 #import "TR101290/TSTr101290Analyzer.h"
 #import "TR101290/TSTr101290AnalyzeContext.h"
@@ -17,25 +19,60 @@
 #import "Table/TSProgramMapTable.h"
 #import "Table/TSProgramSpecificInformationTable.h"
 #import "Table/DVB/TSDvbServiceDescriptionTable.h"
+#import "Table/DVB/TSDvbEventInformationTable.h"
+#import "Table/DVB/TSDvbNetworkInformationTable.h"
+#import "Table/DVB/TSDvbTimeTable.h"
 #import "Table/ATSC/TSAtscVirtualChannelTable.h"
+#import "Table/SCTE35/TSScte35SpliceInfoSection.h"
 #import "TSAccessUnit.h"
 #import "TSElementaryStream.h"
 #import "TSElementaryStreamBuilder.h"
 #import "Table/TSPsiTableBuilder.h"
+#import "TSPcrUtcClock.h"
+#import "TSPcrClockRecovery.h"
+#import "TSProgramTimeline.h"
+#import "TSReedSolomon.h"
+#import "TSBitReader.h"
+
+// About 20 s of PCRs at the usual 40 ms interval
+#define DEFAULT_CLOCK_RECOVERY_WINDOW 512
+// Consecutive packets without sync byte before the packet size is detected again (TR 101 290 TS_sync_loss)
+#define SYNC_LOSS_PACKETS 2
+#define ARRIVAL_TIMESTAMP_MASK ((1U << 30) - 1)
+// PSI snapshot: "TSPS", then the format version. A PID set count of 0xFFFF stands for nil.
+#define PSI_SNAPSHOT_MAGIC 0x54535053
+#define PSI_SNAPSHOT_VERSION 1
+#define PSI_SNAPSHOT_NO_PIDS 0xFFFF
 
 #pragma mark - DVB State Wrapper
 
 @interface TSDemuxerDVBState()
 @property(nonatomic, readwrite, nullable) TSDvbServiceDescriptionTable *sdt;
+@property(nonatomic, readwrite, nullable) TSDvbNetworkInformationTable *nit;
+@property(nonatomic, readwrite, nonnull) NSMutableDictionary<NSNumber*, TSDvbNetworkInformationTable*> *otherNetworkNits;
+@property(nonatomic, readwrite, nullable) TSDvbTimeTable *timeTable;
 @end
 
 @implementation TSDemuxerDVBState
+
+-(instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _epg = [TSDvbEpgStore new];
+        _otherNetworkNits = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
 @end
 
 #pragma mark - ATSC State Wrapper
 
 @interface TSDemuxerATSCState()
 @property(nonatomic, readwrite, nullable) TSAtscVirtualChannelTable *vct;
+@property(nonatomic, readwrite, nullable) TSAtscMasterGuideTable *mgt;
+@property(nonatomic, readwrite, nullable) TSAtscSystemTimeTable *stt;
 @end
 
 @implementation TSDemuxerATSCState
@@ -62,6 +99,43 @@
 
     // Packet format auto-detection (0 = not yet detected)
     NSUInteger _packetSize;
+    NSUInteger _consecutiveSyncErrors;
+    // Arrival clock of 192-byte packets: the 30-bit arrival time stamps, unwrapped
+    BOOL _hasArrivalTimestamp;
+    uint32_t _lastArrivalTimestamp;
+    uint64_t _arrivalTicks;
+
+    // ES PIDs selected by esPidFilter and subscriptions. nil = all.
+    NSSet<NSNumber*> *_selectedEsPids;
+    // PIDs whose packets are parsed at all: PSI PIDs, the selected ES PIDs and the PCR PIDs.
+    // Checked against the raw header so unselected packets are dropped before TSPacket creation.
+    TSPidBitmap _acceptedPids;
+    // Accepted PCR PIDs that are not otherwise selected: their packets only feed the clocks
+    TSPidBitmap _pcrOnlyPids;
+    NSMutableDictionary<Pid, NSHashTable<id<TSDemuxerPidSubscriber>>*> *_subscribers;
+
+    // Shared by all stream builders
+    TSAssemblyBudget *_budget;
+
+    // ATSC: PIDs of the EIT/ETT tables listed in the current MGT
+    TSPidBitmap _atscEventTextPids;
+
+    // SCTE-35 cue PIDs of the current programs, and the PMT of each
+    TSPidBitmap _scte35Pids;
+    NSDictionary<Pid, TSProgramMapTable*> *_scte35Pmts;
+
+    // PCR PIDs of the current programs, and their clocks
+    TSPidBitmap _pcrPids;
+    NSMutableDictionary<Pid, TSPcrUtcClock*> *_utcClocks;
+    NSMutableDictionary<Pid, TSPcrClockRecovery*> *_clockRecoveries;
+    // Keyed by PCR PID, or TS_PID_COUNT + program number for programs without PCR
+    NSMutableDictionary<NSNumber*, TSProgramTimeline*> *_timelines;
+    // Index of the packet being processed, counting every packet received
+    uint64_t _packetIndex;
+    // CC state of every PID, checked once per packet for the builders and the TR 101 290 analyzer,
+    // and the verdict of the packet being processed
+    TSContinuityStates _ccStates;
+    TSContinuityVerdict _continuity;
 }
 
 -(instancetype)initWithDelegate:(id<TSDemuxerDelegate>)delegate mode:(TSDemuxerMode)mode
@@ -69,7 +143,7 @@
     self = [super init];
     if (self) {
         _mode = mode;
-        self.delegate = delegate;
+        _delegate = delegate;
         self.streamBuilders = [NSMutableDictionary dictionary];
         self.tsPacketAnalyzer = [TSTr101290Analyzer new];
         self.pendingCompletedSections = [NSMutableArray array];
@@ -77,6 +151,19 @@
         _pmts = [NSMutableDictionary dictionary];
         _dvb = [TSDemuxerDVBState new];
         _atsc = [TSDemuxerATSCState new];
+        _subscribers = [NSMutableDictionary dictionary];
+        TSPidBitmapFill(&_acceptedPids, YES);
+        TSPidBitmapFill(&_pcrOnlyPids, NO);
+        _budget = [TSAssemblyBudget new];
+        TSPidBitmapFill(&_atscEventTextPids, NO);
+        TSPidBitmapFill(&_scte35Pids, NO);
+        _scte35Pmts = @{};
+        TSPidBitmapFill(&_pcrPids, NO);
+        _utcClocks = [NSMutableDictionary dictionary];
+        _clockRecoveries = [NSMutableDictionary dictionary];
+        _timelines = [NSMutableDictionary dictionary];
+        _clockRecoveryWindowSize = DEFAULT_CLOCK_RECOVERY_WINDOW;
+        _overflowPolicy = TSAssemblyOverflowPolicyTruncate;
 
         self.tableBuilders = [NSMutableDictionary dictionary];
     }
@@ -91,6 +178,7 @@
     }
     _pat = pat;
     _pmtsByPid = nil;
+    [self updateAcceptedPids];
     [self.delegate demuxer:self didReceivePat:pat previousPat:prevPat];
 }
 
@@ -106,6 +194,24 @@
     }
 }
 
+-(void)setNit:(TSDvbNetworkInformationTable*)nit
+{
+    TSDvbNetworkInformationTable *prevNit = nit.isActualNetwork
+        ? self.dvb.nit
+        : self.dvb.otherNetworkNits[@(nit.networkId)];
+    if ([nit isEqual:prevNit]) {
+        return;
+    }
+    if (nit.isActualNetwork) {
+        self.dvb.nit = nit;
+    } else {
+        self.dvb.otherNetworkNits[@(nit.networkId)] = nit;
+    }
+    if ([self.delegate respondsToSelector:@selector(demuxer:didReceiveNit:previousNit:)]) {
+        [self.delegate demuxer:self didReceiveNit:nit previousNit:prevNit];
+    }
+}
+
 -(void)setVct:(TSAtscVirtualChannelTable*)vct
 {
     TSAtscVirtualChannelTable *prevVct = self.atsc.vct;
@@ -118,9 +224,43 @@
     }
 }
 
+-(void)setMgt:(TSAtscMasterGuideTable*)mgt
+{
+    TSAtscMasterGuideTable *prevMgt = self.atsc.mgt;
+    if ([mgt isEqual:prevMgt]) {
+        return;
+    }
+    self.atsc.mgt = mgt;
+
+    // Drop the builders of PIDs no longer listed. Tables with a new version are delivered anyway
+    // (sections are only skipped at the version already delivered), but what the builder remembers
+    // of the old version is no longer needed.
+    NSSet<NSNumber*> *pids = mgt.eventAndTextTablePids;
+    for (NSNumber *pid in prevMgt.eventAndTextTablePids) {
+        if (![pids containsObject:pid]) {
+            [self.tableBuilders removeObjectForKey:pid];
+        }
+    }
+    for (TSAtscMasterGuideTableEntry *entry in mgt.entries) {
+        TSAtscMasterGuideTableEntry *prevEntry = [prevMgt entryForTableType:entry.tableType];
+        if (entry.isEventOrTextTable && prevEntry && prevEntry.versionNumber != entry.versionNumber) {
+            [[self.tableBuilders objectForKey:@(entry.pid)] forgetDeliveredSections];
+        }
+    }
+
+    TSPidBitmapFill(&_atscEventTextPids, NO);
+    for (NSNumber *pid in pids) {
+        TSPidBitmapAdd(&_atscEventTextPids, pid.unsignedShortValue);
+    }
+    [self updateAcceptedPids];
+
+    if ([self.delegate respondsToSelector:@selector(demuxer:didReceiveMgt:previousMgt:)]) {
+        [self.delegate demuxer:self didReceiveMgt:mgt previousMgt:prevMgt];
+    }
+}
+
 -(void)setEsPidFilter:(NSSet<NSNumber*>*)esPidFilter
 {
-    NSSet<NSNumber*> *oldFilter = _esPidFilter;
     _esPidFilter = [esPidFilter copy];
 
     if (_esPidFilter.count == 0) {
@@ -129,28 +269,183 @@
         TSLogDebug(@"ES PID filter: %@", _esPidFilter);
     }
 
+    [self updateSelectedEsPids];
+}
+
+-(void)setDelegate:(id<TSDemuxerDelegate>)delegate
+{
+    const BOOL hadDelegate = _delegate != nil;
+    _delegate = delegate;
+    if (hadDelegate != (delegate != nil)) {
+        [self updateSelectedEsPids];
+    }
+}
+
+/// Recomputes the selected ES PIDs from esPidFilter and the subscriptions. Subscriptions narrow
+/// the selection without esPidFilter only when they are the sole consumers, i.e. without a delegate:
+/// otherwise the delegate keeps receiving every ES PID.
+-(void)updateSelectedEsPids
+{
+    NSSet<NSNumber*> *oldSelection = _selectedEsPids;
+    NSSet<NSNumber*> *newSelection = nil;
+    const BOOL subscribersOnly = _subscribers.count > 0 && !self.delegate;
+    if (_esPidFilter.count > 0 || subscribersOnly) {
+        NSMutableSet<NSNumber*> *pids = [NSMutableSet setWithArray:_subscribers.allKeys];
+        if (_esPidFilter) {
+            [pids unionSet:_esPidFilter];
+        }
+        newSelection = pids;
+    }
+    _selectedEsPids = newSelection;
+
     // Reset TR101290 state for PIDs transitioning from excluded to included
-    [self.tsPacketAnalyzer handleFilterChangeFromOldFilter:oldFilter toNewFilter:_esPidFilter];
+    [self.tsPacketAnalyzer handleFilterChangeFromOldFilter:oldSelection toNewFilter:newSelection];
 
-    // Remove stream builders for PIDs no longer in the filter
-    if (_esPidFilter.count > 0) {
+    // Remove stream builders for PIDs no longer selected
+    if (newSelection) {
         NSMutableArray *pidsToRemove = [NSMutableArray array];
         for (NSNumber *pid in self.streamBuilders) {
-            if (![_esPidFilter containsObject:pid]) {
+            if (![newSelection containsObject:pid]) {
                 [pidsToRemove addObject:pid];
             }
         }
         [self.streamBuilders removeObjectsForKeys:pidsToRemove];
     }
+
+    [self updateAcceptedPids];
+
+    // Create stream builders for newly selected PIDs of the current programs
+    for (TSProgramMapTable *pmt in _pmts.allValues) {
+        [self addStreamBuildersForPmt:pmt];
+    }
+}
+
+/// Rebuilds the accepted PID bitmap. Called when the ES selection, the PAT or the PCR PIDs change.
+-(void)updateAcceptedPids
+{
+    const TSPidBitmap previous = _acceptedPids;
+    const TSPidBitmap previousPcrOnly = _pcrOnlyPids;
+    [self fillAcceptedPids];
+
+    // The packets of newly accepted PIDs were dropped (or only read for their PCR) unchecked:
+    // restart their CC check
+    for (NSUInteger word = 0; word < TS_PID_COUNT / 64; word++) {
+        const uint64_t checked = _acceptedPids.words[word] & ~_pcrOnlyPids.words[word];
+        const uint64_t previouslyChecked = previous.words[word] & ~previousPcrOnly.words[word];
+        uint64_t added = checked & ~previouslyChecked;
+        while (added) {
+            const uint16_t bit = __builtin_ctzll(added);
+            TSContinuityStatesReset(&_ccStates, (uint16_t)(word * 64 + bit));
+            added &= added - 1;
+        }
+    }
+}
+
+-(void)fillAcceptedPids
+{
+    TSPidBitmapFill(&_pcrOnlyPids, NO);
+    if (!_selectedEsPids) {
+        TSPidBitmapFill(&_acceptedPids, YES);
+        return;
+    }
+    TSPidBitmapFill(&_acceptedPids, NO);
+    for (NSNumber *pid in [TSPidUtil reservedPids]) {
+        TSPidBitmapAdd(&_acceptedPids, pid.unsignedShortValue);
+    }
+    for (PmtPid pmtPid in self.pat.programmes.allValues) {
+        TSPidBitmapAdd(&_acceptedPids, pmtPid.unsignedShortValue);
+    }
+    for (NSNumber *pid in self.atsc.mgt.eventAndTextTablePids) {
+        TSPidBitmapAdd(&_acceptedPids, pid.unsignedShortValue);
+    }
+    for (Pid pid in _scte35Pmts) {
+        TSPidBitmapAdd(&_acceptedPids, pid.unsignedShortValue);
+    }
+    for (NSNumber *pid in _selectedEsPids) {
+        TSPidBitmapAdd(&_acceptedPids, pid.unsignedShortValue);
+    }
+    // The clocks need the PCR even when its PID is not selected
+    for (NSUInteger word = 0; word < TS_PID_COUNT / 64; word++) {
+        _pcrOnlyPids.words[word] = _pcrPids.words[word] & ~_acceptedPids.words[word];
+        _acceptedPids.words[word] |= _pcrOnlyPids.words[word];
+    }
+}
+
+-(void)setNalIndexingPids:(NSSet<NSNumber*>*)nalIndexingPids
+{
+    _nalIndexingPids = [nalIndexingPids copy];
+    for (Pid pid in self.streamBuilders) {
+        self.streamBuilders[pid].nalIndexingEnabled = [_nalIndexingPids containsObject:pid];
+    }
+}
+
+-(void)setMaxBufferedBytesPerPid:(NSUInteger)maxBufferedBytesPerPid
+{
+    _maxBufferedBytesPerPid = maxBufferedBytesPerPid;
+    for (TSElementaryStreamBuilder *builder in self.streamBuilders.allValues) {
+        builder.maxBytes = maxBufferedBytesPerPid;
+    }
+}
+
+-(NSUInteger)maxBufferedBytes
+{
+    return _budget.limit;
+}
+
+-(void)setMaxBufferedBytes:(NSUInteger)maxBufferedBytes
+{
+    _budget.limit = maxBufferedBytes;
+}
+
+-(void)setOverflowPolicy:(TSAssemblyOverflowPolicy)overflowPolicy
+{
+    _overflowPolicy = overflowPolicy;
+    for (TSElementaryStreamBuilder *builder in self.streamBuilders.allValues) {
+        builder.overflowPolicy = overflowPolicy;
+    }
+}
+
+-(NSUInteger)bufferedBytes
+{
+    return _budget.usedBytes;
+}
+
+-(NSDictionary<Pid, NSNumber*>*)bufferedBytesByPid
+{
+    NSMutableDictionary<Pid, NSNumber*> *result = [NSMutableDictionary dictionaryWithCapacity:self.streamBuilders.count];
+    for (Pid pid in self.streamBuilders) {
+        result[pid] = @(self.streamBuilders[pid].bufferedBytes);
+    }
+    return result;
 }
 
 /// Returns YES if this elementary stream PID should be processed.
 -(BOOL)shouldProcessEsPid:(uint16_t)pid
 {
-    if (!_esPidFilter || _esPidFilter.count == 0) {
-        return YES;
+    return !_selectedEsPids || [_selectedEsPids containsObject:@(pid)];
+}
+
+/// Creates stream builders for the selected elementary streams of `pmt` that have none yet.
+-(void)addStreamBuildersForPmt:(TSProgramMapTable*)pmt
+{
+    for (TSElementaryStream *stream in pmt.elementaryStreams) {
+        if (![self shouldProcessEsPid:stream.pid] || self.streamBuilders[@(stream.pid)]) {
+            continue;
+        }
+        if (stream.resolvedStreamType == TSResolvedStreamTypeSCTE35) {
+            continue;  // Sections, not PES: see updateScte35Pids
+        }
+        TSElementaryStreamBuilder *builder = [[TSElementaryStreamBuilder alloc] initWithDelegate:self
+                                                                                             pid:stream.pid
+                                                                                      streamType:stream.streamType
+                                                                                     descriptors:stream.descriptors];
+        builder.nalIndexingEnabled = [_nalIndexingPids containsObject:@(stream.pid)];
+        builder.maxBytes = _maxBufferedBytesPerPid;
+        builder.overflowPolicy = _overflowPolicy;
+        builder.budget = _budget;
+        builder.timeline = [self timelineForPmt:pmt];
+        [self.streamBuilders setObject:builder forKey:@(stream.pid)];
     }
-    return [_esPidFilter containsObject:@(pid)];
 }
 
 -(void)updatePmt:(TSProgramMapTable*)pmt
@@ -171,19 +466,10 @@
         if (![self shouldProcessEsPid:stream.pid]) {
             continue;
         }
-        
         // Keep pid if still present in new PMT
         [pidsToRemove removeObject:@(stream.pid)];
-
-        TSElementaryStreamBuilder *builder = [self.streamBuilders objectForKey:@(stream.pid)];
-        if (!builder) {
-            builder = [[TSElementaryStreamBuilder alloc] initWithDelegate:self
-                                                                      pid:stream.pid
-                                                               streamType:stream.streamType
-                                                              descriptors:stream.descriptors];
-            [self.streamBuilders setObject:builder forKey:@(stream.pid)];
-        }
     }
+    [self addStreamBuildersForPmt:pmt];
     
     
     if (pidsToRemove.count > 0) {
@@ -203,6 +489,9 @@
 
     _pmts[programNumber] = pmt;
     _pmtsByPid = nil;
+    // Also on a new stream list, as a PID can move between programs
+    [self updatePcrPids];
+    [self updateScte35Pids];
     [self.delegate demuxer:self didReceivePmt:pmt previousPmt:prevPmt];
 }
 
@@ -211,6 +500,121 @@
     return self.tsPacketAnalyzer.stats;
 }
 
+/// Rebuilds the SCTE-35 cue PIDs from the current PMTs. Cue PIDs are accepted like PSI PIDs.
+-(void)updateScte35Pids
+{
+    NSMutableDictionary<Pid, TSProgramMapTable*> *pmts = [NSMutableDictionary dictionary];
+    for (TSProgramMapTable *pmt in _pmts.allValues) {
+        for (TSElementaryStream *es in pmt.elementaryStreams) {
+            if (es.resolvedStreamType == TSResolvedStreamTypeSCTE35) {
+                pmts[@(es.pid)] = pmt;
+            }
+        }
+    }
+    if ([pmts isEqualToDictionary:_scte35Pmts]) {
+        return;
+    }
+    for (Pid pid in _scte35Pmts) {
+        if (!pmts[pid]) {
+            [self.tableBuilders removeObjectForKey:pid];
+        }
+    }
+    _scte35Pmts = pmts;
+    TSPidBitmapFill(&_scte35Pids, NO);
+    for (Pid pid in pmts) {
+        TSPidBitmapAdd(&_scte35Pids, pid.unsignedShortValue);
+    }
+    [self updateAcceptedPids];
+}
+
+#pragma mark - Program Clocks
+
+/// Programs sharing a PCR PID share a system time clock, and so a timeline.
+static inline NSNumber *timelineKeyForPmt(TSProgramMapTable *pmt)
+{
+    return pmt.pcrPid == PID_NULL_PACKET ? @(TS_PID_COUNT + pmt.programNumber) : @(pmt.pcrPid);
+}
+
+-(TSProgramTimeline* _Nonnull)timelineForPmt:(TSProgramMapTable*)pmt
+{
+    NSNumber *key = timelineKeyForPmt(pmt);
+    TSProgramTimeline *timeline = _timelines[key];
+    if (!timeline) {
+        timeline = [TSProgramTimeline new];
+        _timelines[key] = timeline;
+    }
+    return timeline;
+}
+
+/// Rebuilds the PCR PID bitmap from the current PMTs, keeping the clocks and timelines still in use,
+/// and moves the stream builders to the timeline of their program.
+-(void)updatePcrPids
+{
+    NSMutableDictionary<Pid, TSPcrUtcClock*> *clocks = [NSMutableDictionary dictionaryWithCapacity:_pmts.count];
+    NSMutableDictionary<Pid, TSPcrClockRecovery*> *recoveries = [NSMutableDictionary dictionaryWithCapacity:_pmts.count];
+    NSMutableDictionary<NSNumber*, TSProgramTimeline*> *timelines = [NSMutableDictionary dictionaryWithCapacity:_pmts.count];
+    TSPidBitmapFill(&_pcrPids, NO);
+    for (TSProgramMapTable *pmt in _pmts.allValues) {
+        TSProgramTimeline *timeline = [self timelineForPmt:pmt];
+        timelines[timelineKeyForPmt(pmt)] = timeline;
+        for (TSElementaryStream *es in pmt.elementaryStreams) {
+            self.streamBuilders[@(es.pid)].timeline = timeline;
+        }
+
+        const uint16_t pcrPid = pmt.pcrPid;
+        if (pcrPid == PID_NULL_PACKET) {
+            continue;  // No PCR (e.g. a data-only program)
+        }
+        TSPidBitmapAdd(&_pcrPids, pcrPid);
+        clocks[@(pcrPid)] = _utcClocks[@(pcrPid)] ?: [[TSPcrUtcClock alloc] initWithPcrPid:pcrPid];
+        recoveries[@(pcrPid)] = _clockRecoveries[@(pcrPid)]
+            ?: [[TSPcrClockRecovery alloc] initWithPcrPid:pcrPid windowSize:_clockRecoveryWindowSize];
+    }
+    _utcClocks = clocks;
+    _clockRecoveries = recoveries;
+    _timelines = timelines;
+    [self updateAcceptedPids];
+}
+
+-(void)setClockRecoveryWindowSize:(NSUInteger)clockRecoveryWindowSize
+{
+    if (clockRecoveryWindowSize < 2) {
+        [NSException raise:@"TSDemuxerInvalidSettingsException" format:@"Clock recovery window size must be >= 2"];
+    }
+    if (clockRecoveryWindowSize == _clockRecoveryWindowSize) {
+        return;
+    }
+    _clockRecoveryWindowSize = clockRecoveryWindowSize;
+    // Existing clocks start over with the new window
+    [_clockRecoveries removeAllObjects];
+    [self updatePcrPids];
+}
+
+-(TSPcrClockRecovery* _Nullable)clockRecoveryForProgram:(uint16_t)programNumber
+{
+    TSProgramMapTable *pmt = _pmts[@(programNumber)];
+    return pmt ? _clockRecoveries[@(pmt.pcrPid)] : nil;
+}
+
+-(TSProgramTimeline* _Nullable)timelineForProgram:(uint16_t)programNumber
+{
+    TSProgramMapTable *pmt = _pmts[@(programNumber)];
+    return pmt ? _timelines[timelineKeyForPmt(pmt)] : nil;
+}
+
+-(TSPcrUtcClock* _Nullable)utcClockForProgram:(uint16_t)programNumber
+{
+    TSProgramMapTable *pmt = _pmts[@(programNumber)];
+    return pmt ? _utcClocks[@(pmt.pcrPid)] : nil;
+}
+
+-(void)addUtcTimeToClocks:(int64_t)unixSeconds
+{
+    for (TSPcrUtcClock *clock in _utcClocks.allValues) {
+        [clock addUtcTime:unixSeconds packetIndex:_packetIndex];
+    }
+}
+
 /// Returns PMTs keyed by their PID (for TR101290 analysis).
 /// Result is cached and invalidated when PAT or PMT changes.
 -(NSDictionary<PmtPid, TSProgramMapTable*>*)pmtsByPid
@@ -234,17 +638,40 @@
 
 #pragma mark - Packet Routing Helpers
 
-/// Adds a TS packet to the appropriate PSI table builder, creating one if needed.
--(void)addPacketToPsiTableBuilder:(TSPacket *)tsPacket forPid:(uint16_t)pid
+/// Returns the PSI table builder of `pid`, creating one with the given settings if needed.
+-(TSPsiTableBuilder *)tableBuilderForPid:(uint16_t)pid
+                      aggregatesSections:(BOOL)aggregatesSections
+                   skipsRepeatedSections:(BOOL)skipsRepeatedSections
 {
     TSPsiTableBuilder *builder = [self.tableBuilders objectForKey:@(pid)];
     if (!builder) {
         builder = [[TSPsiTableBuilder alloc] initWithDelegate:self pid:pid];
+        builder.aggregatesSections = aggregatesSections;
+        builder.skipsRepeatedSections = skipsRepeatedSections;
         [self.tableBuilders setObject:builder forKey:@(pid)];
     }
-    [builder addTsPacket:tsPacket];
+    return builder;
 }
 
+/// Adds a TS packet to the appropriate PSI table builder, creating one if needed.
+-(void)addPacketToPsiTableBuilder:(TSPacket *)tsPacket forPid:(uint16_t)pid
+{
+    [[self tableBuilderForPid:pid aggregatesSections:YES skipsRepeatedSections:NO] addTsPacket:tsPacket continuity:_continuity];
+}
+
+/// For PIDs where the sub-tables of many services or channels are interleaved (DVB EIT, ATSC EIT/ETT):
+/// sections are delivered one by one rather than aggregated per table.
+-(void)addPacketToSectionBuilder:(TSPacket *)tsPacket forPid:(uint16_t)pid skipsRepeatedSections:(BOOL)skipsRepeatedSections
+{
+    [[self tableBuilderForPid:pid aggregatesSections:NO skipsRepeatedSections:skipsRepeatedSections] addTsPacket:tsPacket continuity:_continuity];
+}
+
+/// NIT sub-tables (actual and other networks) are aggregated separately. Once a NIT has been
+/// delivered, its repeats are skipped until the version changes.
+-(void)addPacketToNitBuilder:(TSPacket *)tsPacket forPid:(uint16_t)pid
+{
+    [[self tableBuilderForPid:pid aggregatesSections:YES skipsRepeatedSections:YES] addTsPacket:tsPacket continuity:_continuity];
+}
 
 /// Routes a single TS packet to appropriate handler. Returns YES if packet is PES data.
 -(BOOL)routeTsPacket:(TSPacket *)tsPacket
@@ -268,6 +695,20 @@
             [self addPacketToPsiTableBuilder:tsPacket forPid:pid];
             return NO;
         }
+        if (pid == PID_DVB_NIT_ST) {
+            [self addPacketToNitBuilder:tsPacket forPid:pid];
+            return NO;
+        }
+        if (pid == PID_DVB_TDT_TOT_ST) {
+            // TDT/TOT have no table_id_extension/section_number: never aggregated
+            [self addPacketToSectionBuilder:tsPacket forPid:pid skipsRepeatedSections:NO];
+            return NO;
+        }
+        if (pid == PID_DVB_EIT_ST_CIT) {
+            // Not skipped in the builder: the EPG store skips repeats itself, and must see them again after removeAllEvents.
+            [self addPacketToSectionBuilder:tsPacket forPid:pid skipsRepeatedSections:NO];
+            return NO;
+        }
         if (pid >= PID_DVB_NIT_ST && pid <= PID_DVB_SIT) {
             return NO;  // Other DVB reserved PIDs - not yet implemented
         }
@@ -283,6 +724,10 @@
             [self addPacketToPsiTableBuilder:tsPacket forPid:pid];
             return NO;
         }
+        if (TSPidBitmapContains(&_atscEventTextPids, pid)) {
+            [self addPacketToSectionBuilder:tsPacket forPid:pid skipsRepeatedSections:YES];
+            return NO;
+        }
         if ([TSPidUtil isDvbReservedPid:pid]) {
             TSLogWarn(@"Received DVB PID 0x%04X in ATSC mode - possible mode mismatch", pid);
             return NO;
@@ -293,12 +738,22 @@
     ProgramNumber programNumber = [self.pat programNumberFromPid:pid];
     if (programNumber != nil) {
         if ([programNumber isEqualToNumber:@(PROGRAM_NUMBER_NETWORK_INFO)]) {
-            return NO;  // TODO: Parse Network Info table
+            // Network PID other than 0x10 (handled above). The NIT content is only defined for DVB.
+            if (self.mode == TSDemuxerModeDVB) {
+                [self addPacketToNitBuilder:tsPacket forPid:pid];
+            }
+            return NO;
         }
         [self addPacketToPsiTableBuilder:tsPacket forPid:pid];  // PMT
         return NO;
     }
 
+    // SCTE-35 cues: one section per cue, each delivered as soon as it completes
+    if (TSPidBitmapContains(&_scte35Pids, pid)) {
+        [self addPacketToSectionBuilder:tsPacket forPid:pid skipsRepeatedSections:NO];
+        return NO;
+    }
+
     // Not a reserved PID and not in PAT - treat as PES
     return ![TSPidUtil isReservedPid:pid];
 }
@@ -308,46 +763,154 @@
     return _packetSize;
 }
 
-/// Detects packet size using buffer length modulo arithmetic.
-/// Assumes input is packet-aligned (starts at packet boundary).
-/// BTS (204-byte) is detected only when unambiguous: divisible by 204 but not by 188.
-/// When ambiguous (divisible by both), defaults to standard 188-byte TS packets.
--(NSUInteger)detectPacketSizeFromLength:(NSUInteger)length
+/// YES if the first two packets of `packetSize` in the chunk (as far as present) have a sync byte.
+static inline BOOL hasLeadingSyncBytes(const uint8_t *bytes, NSUInteger length, NSUInteger packetSize)
+{
+    const NSUInteger syncOffset = TSPacketSyncOffset(packetSize);
+    for (NSUInteger offset = syncOffset; offset < MIN(length, 2 * packetSize); offset += packetSize) {
+        if (bytes[offset] != TS_PACKET_HEADER_SYNC_BYTE) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+/// Position of a 192-byte packet on the arrival clock, from its 30-bit arrival time stamp.
+-(uint64_t)arrivalTimeNanosForPacket:(const uint8_t*)bytes
 {
-    BOOL isBts = (length % TS_PACKET_SIZE_204 == 0) && (length % TS_PACKET_SIZE_188 != 0);
-    return isBts ? TS_PACKET_SIZE_204 : TS_PACKET_SIZE_188;
+    const uint32_t arrivalTimestamp = TSPacketArrivalTimestamp(bytes);
+    if (_hasArrivalTimestamp) {
+        _arrivalTicks += (arrivalTimestamp - _lastArrivalTimestamp) & ARRIVAL_TIMESTAMP_MASK;
+    } else {
+        _hasArrivalTimestamp = YES;
+        _arrivalTicks = arrivalTimestamp;
+    }
+    _lastArrivalTimestamp = arrivalTimestamp;
+    return _arrivalTicks * 1000 / 27;
 }
 
 -(void)demux:(NSData* _Nonnull)chunk dataArrivalHostTimeNanos:(uint64_t)dataArrivalHostTimeNanos
 {
-    // Auto-detect packet size on first call
+    const uint8_t *bytes = chunk.bytes;
+    // Auto-detect packet size on first call, and again when a chunk does not start with packets of it
     if (_packetSize == 0) {
-        _packetSize = [self detectPacketSizeFromLength:chunk.length];
+        _packetSize = TSPacketDetectSizeOfChunk(bytes, chunk.length);
         TSLogInfo(@"Detected %lu-byte TS packets", (unsigned long)_packetSize);
+    } else if (chunk.length % _packetSize != 0 || !hasLeadingSyncBytes(bytes, chunk.length, _packetSize)) {
+        [self redetectPacketSizeFromBytes:bytes length:chunk.length];
     }
 
-    NSArray<TSPacket*> *tsPackets = [TSPacket packetsFromChunkedTsData:chunk packetSize:_packetSize];
-    for (TSPacket *tsPacket in tsPackets) {
+    if (chunk.length % _packetSize != 0) {
+        TSLogError(@"Received non-integer number of ts packets: %lu (expected multiple of %lu)",
+                   (unsigned long)chunk.length, (unsigned long)_packetSize);
+        return;
+    }
+
+    // Corrected copies of packets, which must live as long as `chunk`
+    NSMutableArray<NSData*> *correctedPackets = nil;
+    for (NSUInteger offset = 0, stride; offset < chunk.length; offset += stride, _packetIndex++) {
+        stride = _packetSize;
+        const BOOL isM2ts = _packetSize == TS_PACKET_SIZE_192;
+        const uint8_t *packetBytes = bytes + offset + TSPacketSyncOffset(_packetSize);
+        if (self.reedSolomonCorrection && _packetSize == TS_PACKET_SIZE_204 && TSReedSolomonHasErrors204(packetBytes)) {
+            NSMutableData *corrected = [NSMutableData dataWithBytes:packetBytes length:TS_PACKET_SIZE_204];
+            packetBytes = [self correctPacket:corrected.mutableBytes];
+            if (!correctedPackets) {
+                correctedPackets = [NSMutableArray array];
+            }
+            [correctedPackets addObject:corrected];
+        }
+
+        if (packetBytes[0] != TS_PACKET_HEADER_SYNC_BYTE) {
+            if (++_consecutiveSyncErrors >= SYNC_LOSS_PACKETS
+                && [self redetectPacketSizeFromBytes:bytes + offset length:chunk.length - offset]) {
+                // Demux this packet again, with the new size
+                stride = 0;
+                _packetIndex--;
+                continue;
+            }
+        } else {
+            _consecutiveSyncErrors = 0;
+        }
+        _arrivalTimeNanos = isM2ts ? [self arrivalTimeNanosForPacket:bytes + offset] : dataArrivalHostTimeNanos;
+
+        // Drop unselected PIDs from the raw header, before any parsing or allocation.
+        // Checked per packet since a PAT earlier in this chunk can add PMT PIDs.
+        const uint16_t pid = TSPacketHeaderPid(packetBytes);
+        if (!TSPidBitmapContains(&_acceptedPids, pid)) {
+            continue;
+        }
+        TSPacket *tsPacket = isM2ts
+            ? [TSPacket packetWithM2tsPacketBytes:bytes + offset]
+            : [TSPacket packetWithTsPacketBytes:packetBytes];
+        if (!tsPacket) {
+            continue;
+        }
+        if (TSPidBitmapContains(&_pcrPids, pid) && tsPacket.adaptationField.pcrFlag) {
+            TSAdaptationField *af = tsPacket.adaptationField;
+            [_timelines[@(pid)] addPcrBase:af.pcrBase isDiscontinuous:af.discontinuityFlag];
+            [_utcClocks[@(pid)] addPcrBase:af.pcrBase
+                                    pcrExt:af.pcrExt
+                               packetIndex:_packetIndex
+                           isDiscontinuous:af.discontinuityFlag];
+            [_clockRecoveries[@(pid)] addPcrBase:af.pcrBase
+                                          pcrExt:af.pcrExt
+                                arrivalHostNanos:_arrivalTimeNanos
+                                 isDiscontinuous:af.discontinuityFlag];
+        }
+        if (TSPidBitmapContains(&_pcrOnlyPids, pid)) {
+            continue;
+        }
+        _continuity = TSContinuityStatesCheckPacket(&_ccStates, tsPacket);
         BOOL isPes = [self routeTsPacket:tsPacket];
-        uint16_t pid = tsPacket.header.pid;
-        if (isPes && ![self shouldProcessEsPid:pid]) continue;
         
         TSTr101290AnalyzeContext *context = [[TSTr101290AnalyzeContext alloc]
                                              initWithPat:self.pat
                                              pmts:self.pmtsByPid
-                                             nowMs:dataArrivalHostTimeNanos / 1000000
+                                             nowMs:_arrivalTimeNanos / 1000000
                                              completedSections:self.pendingCompletedSections
-                                             esPidFilter:_esPidFilter];
-        [self.tsPacketAnalyzer analyzeTsPacket:tsPacket context:context];
+                                             esPidFilter:_selectedEsPids];
+        [self.tsPacketAnalyzer analyzeTsPacket:tsPacket continuity:_continuity context:context];
         [self.pendingCompletedSections removeAllObjects];
         
         if (isPes) {
             TSElementaryStreamBuilder *esBuilder = [self.streamBuilders objectForKey:@(pid)];
-            [esBuilder addTsPacket:tsPacket];
+            [esBuilder addTsPacket:tsPacket continuity:_continuity];
         }
     }
 }
 
+/// Detects the packet size again from the packets at `bytes`, after a sync loss. Only switches to
+/// a size `length` divides into, e.g. for a capture switching format. Returns YES if it switched.
+-(BOOL)redetectPacketSizeFromBytes:(const uint8_t*)bytes length:(NSUInteger)length
+{
+    _consecutiveSyncErrors = 0;
+    const NSUInteger packetSize = TSPacketDetectSize(bytes, length);
+    if (packetSize == 0 || packetSize == _packetSize || length % packetSize != 0) {
+        return NO;
+    }
+    TSLogWarn(@"Sync lost, detected %lu-byte TS packets (was %lu)", (unsigned long)packetSize, (unsigned long)_packetSize);
+    _packetSize = packetSize;
+    _hasArrivalTimestamp = NO;
+    return YES;
+}
+
+/// Corrects a 204-byte packet in place with its RS parity, or flags it with the transport error
+/// indicator if it has too many errors.
+-(const uint8_t*)correctPacket:(uint8_t*)packet
+{
+    TSTr101290Statistics *stats = self.statistics;
+    NSUInteger correctedBytes = 0;
+    if (TSReedSolomonDecode204(packet, &correctedBytes) == TSReedSolomonResultUncorrectable) {
+        stats.rsUncorrectablePackets++;
+        packet[1] |= 0x80;
+    } else {
+        stats.rsCorrectedPackets++;
+        stats.rsCorrectedBytes += correctedBytes;
+    }
+    return packet;
+}
+
 -(void)tableBuilder:(TSPsiTableBuilder *)builder didBuildTable:(TSProgramSpecificInformationTable *)table
 {
     // Store completed section for TR101290 analysis (multiple sections can complete per packet)
@@ -364,28 +927,338 @@
     else if (self.mode == TSDemuxerModeDVB && table.tableId == TABLE_ID_DVB_SDT_ACTUAL_TS) {
         [self setSdt:[[TSDvbServiceDescriptionTable alloc] initWithPSI:table]];
     }
+    else if (self.mode == TSDemuxerModeDVB && [TSDvbNetworkInformationTable isNitTableId:table.tableId]) {
+        TSDvbNetworkInformationTable *nit = [[TSDvbNetworkInformationTable alloc] initWithPSI:table];
+        if (nit) {
+            [self setNit:nit];
+        }
+    }
+    else if (self.mode == TSDemuxerModeDVB && [TSDvbTimeTable isTimeTableId:table.tableId]) {
+        TSDvbTimeTable *timeTable = [[TSDvbTimeTable alloc] initWithPSI:table];
+        if (timeTable) {
+            self.dvb.timeTable = timeTable;
+            [self addUtcTimeToClocks:timeTable.unixSeconds];
+            if ([self.delegate respondsToSelector:@selector(demuxer:didReceiveTimeTable:)]) {
+                [self.delegate demuxer:self didReceiveTimeTable:timeTable];
+            }
+        }
+    }
+    else if (self.mode == TSDemuxerModeDVB && [TSDvbEventInformationTable isEitTableId:table.tableId]) {
+        TSDvbEventInformationTable *eit = [[TSDvbEventInformationTable alloc] initWithPSI:table];
+        if (eit) {
+            [self.dvb.epg addSection:eit];
+        }
+    }
     // ATSC tables (only in ATSC mode)
     else if (self.mode == TSDemuxerModeATSC &&
              (table.tableId == TABLE_ID_ATSC_TVCT || table.tableId == TABLE_ID_ATSC_CVCT)) {
         [self setVct:[[TSAtscVirtualChannelTable alloc] initWithPSI:table]];
     }
-    // ATSC tables we acknowledge but don't parse (MGT, STT, RRT, EIT, ETT)
-    else if (self.mode == TSDemuxerModeATSC &&
-             (table.tableId == TABLE_ID_ATSC_MGT ||
-              table.tableId == TABLE_ID_ATSC_STT ||
-              table.tableId == TABLE_ID_ATSC_RRT ||
-              table.tableId == TABLE_ID_ATSC_EIT ||
-              table.tableId == TABLE_ID_ATSC_ETT)) {
-        // TODO Parse...
+    else if (self.mode == TSDemuxerModeATSC && table.tableId == TABLE_ID_ATSC_MGT) {
+        TSAtscMasterGuideTable *mgt = [[TSAtscMasterGuideTable alloc] initWithPSI:table];
+        if (mgt) {
+            [self setMgt:mgt];
+        }
+    }
+    else if (self.mode == TSDemuxerModeATSC && table.tableId == TABLE_ID_ATSC_STT) {
+        TSAtscSystemTimeTable *stt = [[TSAtscSystemTimeTable alloc] initWithPSI:table];
+        if (stt) {
+            self.atsc.stt = stt;
+            [self addUtcTimeToClocks:stt.unixSeconds];
+            if ([self.delegate respondsToSelector:@selector(demuxer:didReceiveStt:)]) {
+                [self.delegate demuxer:self didReceiveStt:stt];
+            }
+        }
+    }
+    else if (self.mode == TSDemuxerModeATSC && table.tableId == TABLE_ID_ATSC_EIT) {
+        TSAtscEventInformationTable *eit = [[TSAtscEventInformationTable alloc] initWithPSI:table];
+        if (eit && [self.delegate respondsToSelector:@selector(demuxer:didReceiveEit:)]) {
+            [self.delegate demuxer:self didReceiveEit:eit];
+        }
+    }
+    else if (self.mode == TSDemuxerModeATSC && table.tableId == TABLE_ID_ATSC_ETT) {
+        TSAtscExtendedTextTable *ett = [[TSAtscExtendedTextTable alloc] initWithPSI:table];
+        if (ett && [self.delegate respondsToSelector:@selector(demuxer:didReceiveEtt:)]) {
+            [self.delegate demuxer:self didReceiveEtt:ett];
+        }
+    }
+    // SCTE-35 (both modes)
+    else if (table.tableId == TABLE_ID_SCTE35_SPLICE_INFO && TSPidBitmapContains(&_scte35Pids, builder.pid)) {
+        [self didReceiveSpliceInfoSection:table pid:builder.pid];
+    }
+    // Content advisory ratings are not supported: the RRT is recognised and ignored, not logged as unhandled
+    else if (self.mode == TSDemuxerModeATSC && table.tableId == TABLE_ID_ATSC_RRT) {
     }
     else {
         TSLogDebug(@"Received unhandled PSI table pid: %u, tableId: 0x%02X", builder.pid, table.tableId);
     }
 }
 
+-(void)didReceiveSpliceInfoSection:(TSProgramSpecificInformationTable *)table pid:(uint16_t)pid
+{
+    if (![self.delegate respondsToSelector:@selector(demuxer:didReceiveSpliceInfo:pid:programNumber:)]) {
+        return;
+    }
+    TSProgramMapTable *pmt = _scte35Pmts[@(pid)];
+    // The program's timeline, so that the splice time is comparable with the timelinePts of its access units
+    TSScte35SpliceInfoSection *spliceInfo = [[TSScte35SpliceInfoSection alloc] initWithPSI:table
+                                                                                  timeline:_timelines[timelineKeyForPmt(pmt)]];
+    if (spliceInfo) {
+        [self.delegate demuxer:self didReceiveSpliceInfo:spliceInfo pid:pid programNumber:pmt.programNumber];
+    }
+}
+
 -(void)streamBuilder:(TSElementaryStreamBuilder *)builder didBuildAccessUnit:(TSAccessUnit *)accessUnit
 {
     [self.delegate demuxer:self didReceiveAccessUnit:accessUnit];
+    if (_subscribers.count > 0) {
+        for (id<TSDemuxerPidSubscriber> subscriber in _subscribers[@(accessUnit.pid)].allObjects) {
+            [subscriber demuxer:self didReceiveAccessUnit:accessUnit];
+        }
+    }
+}
+
+#pragma mark - PSI Snapshot
+
+static inline void appendUInt8(NSMutableData *data, uint8_t value)
+{
+    [data appendBytes:&value length:1];
+}
+
+static inline void appendUInt16(NSMutableData *data, uint16_t value)
+{
+    value = CFSwapInt16HostToBig(value);
+    [data appendBytes:&value length:2];
+}
+
+static inline void appendUInt32(NSMutableData *data, uint32_t value)
+{
+    value = CFSwapInt32HostToBig(value);
+    [data appendBytes:&value length:4];
+}
+
+static void appendPidSet(NSMutableData *data, NSSet<NSNumber*> *pids)
+{
+    if (!pids) {
+        appendUInt16(data, PSI_SNAPSHOT_NO_PIDS);
+        return;
+    }
+    appendUInt16(data, (uint16_t)pids.count);
+    for (NSNumber *pid in [pids.allObjects sortedArrayUsingSelector:@selector(compare:)]) {
+        appendUInt16(data, pid.unsignedShortValue);
+    }
+}
+
+static NSSet<NSNumber*> *readPidSet(TSBitReader *reader)
+{
+    const uint16_t count = TSBitReaderReadUInt16BE(reader);
+    if (reader->error || count == PSI_SNAPSHOT_NO_PIDS) {
+        return nil;
+    }
+    NSMutableSet<NSNumber*> *pids = [NSMutableSet setWithCapacity:count];
+    for (uint16_t i = 0; i < count && !reader->error; i++) {
+        [pids addObject:@(TSBitReaderReadUInt16BE(reader))];
+    }
+    return pids;
+}
+
+/// A table as received: its header fields, the CRC and the (possibly aggregated) section data.
+static void appendTable(NSMutableData *data, TSProgramSpecificInformationTable *psi)
+{
+    appendUInt8(data, psi.tableId);
+    appendUInt8(data, (uint8_t)((psi.sectionSyntaxIndicator << 7) | (psi.reservedBit1 << 6) | (psi.reservedBits2 << 4)));
+    appendUInt16(data, psi.sectionLength);
+    appendUInt32(data, psi.crc);
+    appendUInt32(data, (uint32_t)psi.sectionDataExcludingCrc.length);
+    if (psi.sectionDataExcludingCrc) {
+        [data appendData:psi.sectionDataExcludingCrc];
+    }
+}
+
+static TSProgramSpecificInformationTable *readTable(TSBitReader *reader)
+{
+    const uint8_t tableId = TSBitReaderReadUInt8(reader);
+    const uint8_t bits = TSBitReaderReadUInt8(reader);
+    const uint16_t sectionLength = TSBitReaderReadUInt16BE(reader);
+    const uint32_t crc = TSBitReaderReadUInt32BE(reader);
+    const uint32_t length = TSBitReaderReadUInt32BE(reader);
+    NSData *sectionData = TSBitReaderReadData(reader, length);
+    if (reader->error) {
+        return nil;
+    }
+    return [[TSProgramSpecificInformationTable alloc] initWithTableId:tableId
+                                               sectionSyntaxIndicator:(bits >> 7) & 0x01
+                                                         reservedBit1:(bits >> 6) & 0x01
+                                                        reservedBits2:(bits >> 4) & 0x03
+                                                        sectionLength:sectionLength
+                                              sectionDataExcludingCrc:[sectionData copy]
+                                                                  crc:crc];
+}
+
+-(NSData*)psiSnapshot
+{
+    NSMutableData *data = [NSMutableData data];
+    appendUInt32(data, PSI_SNAPSHOT_MAGIC);
+    appendUInt8(data, PSI_SNAPSHOT_VERSION);
+    appendUInt8(data, (uint8_t)self.mode);
+
+    appendUInt8(data, (uint8_t)self.overflowPolicy);
+    appendUInt8(data, self.reedSolomonCorrection ? 1 : 0);
+    appendUInt32(data, (uint32_t)MIN(self.maxBufferedBytesPerPid, UINT32_MAX));
+    appendUInt32(data, (uint32_t)MIN(self.maxBufferedBytes, UINT32_MAX));
+    appendUInt32(data, (uint32_t)MIN(self.clockRecoveryWindowSize, UINT32_MAX));
+    appendPidSet(data, self.esPidFilter);
+    appendPidSet(data, self.nalIndexingPids);
+
+    // The PAT first, so that the PMTs are restored into known programs
+    NSMutableArray<TSProgramSpecificInformationTable*> *tables = [NSMutableArray array];
+    if (self.pat) {
+        [tables addObject:self.pat.psi];
+    }
+    for (ProgramNumber programNumber in [_pmts.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        [tables addObject:_pmts[programNumber].psi];
+    }
+    if (self.dvb.sdt) {
+        [tables addObject:self.dvb.sdt.psi];
+    }
+    if (self.dvb.nit) {
+        [tables addObject:self.dvb.nit.psi];
+    }
+    for (NSNumber *networkId in [self.dvb.otherNetworkNits.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        [tables addObject:self.dvb.otherNetworkNits[networkId].psi];
+    }
+    if (self.atsc.vct) {
+        [tables addObject:self.atsc.vct.psi];
+    }
+    if (self.atsc.mgt) {
+        [tables addObject:self.atsc.mgt.psi];
+    }
+
+    appendUInt16(data, (uint16_t)tables.count);
+    for (TSProgramSpecificInformationTable *psi in tables) {
+        appendTable(data, psi);
+    }
+    return data;
+}
+
+-(BOOL)restorePsiSnapshot:(NSData*)snapshot
+{
+    TSBitReader reader = TSBitReaderMake(snapshot);
+    const uint32_t magic = TSBitReaderReadUInt32BE(&reader);
+    const uint8_t version = TSBitReaderReadUInt8(&reader);
+    const uint8_t mode = TSBitReaderReadUInt8(&reader);
+    if (reader.error || magic != PSI_SNAPSHOT_MAGIC || version != PSI_SNAPSHOT_VERSION) {
+        TSLogWarn(@"Not a PSI snapshot (or of an unsupported version)");
+        return NO;
+    }
+    if (mode != self.mode) {
+        TSLogWarn(@"PSI snapshot of mode %u cannot seed a demuxer of mode %lu", mode, (unsigned long)self.mode);
+        return NO;
+    }
+
+    const uint8_t overflowPolicy = TSBitReaderReadUInt8(&reader);
+    const BOOL reedSolomonCorrection = TSBitReaderReadUInt8(&reader) != 0;
+    const uint32_t maxBufferedBytesPerPid = TSBitReaderReadUInt32BE(&reader);
+    const uint32_t maxBufferedBytes = TSBitReaderReadUInt32BE(&reader);
+    const uint32_t clockRecoveryWindowSize = TSBitReaderReadUInt32BE(&reader);
+    NSSet<NSNumber*> *esPidFilter = readPidSet(&reader);
+    NSSet<NSNumber*> *nalIndexingPids = readPidSet(&reader);
+    const uint16_t tableCount = TSBitReaderReadUInt16BE(&reader);
+    NSMutableArray<TSProgramSpecificInformationTable*> *tables = [NSMutableArray arrayWithCapacity:tableCount];
+    for (uint16_t i = 0; i < tableCount && !reader.error; i++) {
+        TSProgramSpecificInformationTable *psi = readTable(&reader);
+        if (psi) {
+            [tables addObject:psi];
+        }
+    }
+    if (reader.error || overflowPolicy > TSAssemblyOverflowPolicyDrop || clockRecoveryWindowSize < 2) {
+        TSLogWarn(@"Malformed PSI snapshot");
+        return NO;
+    }
+
+    self.overflowPolicy = overflowPolicy;
+    self.reedSolomonCorrection = reedSolomonCorrection;
+    self.maxBufferedBytesPerPid = maxBufferedBytesPerPid;
+    self.maxBufferedBytes = maxBufferedBytes;
+    self.clockRecoveryWindowSize = clockRecoveryWindowSize;
+    self.nalIndexingPids = nalIndexingPids;
+    self.esPidFilter = esPidFilter;
+
+    for (TSProgramSpecificInformationTable *psi in tables) {
+        [self restoreTable:psi];
+    }
+    TSLogDebug(@"Restored %lu PSI tables from snapshot", (unsigned long)tables.count);
+    return YES;
+}
+
+/// Applies a table of a snapshot as if received, without TR 101 290 analysis.
+-(void)restoreTable:(TSProgramSpecificInformationTable *)table
+{
+    if (table.tableId == TABLE_ID_PAT) {
+        TSProgramAssociationTable *pat = [[TSProgramAssociationTable alloc] initWithPSI:table];
+        if (pat) {
+            self.pat = pat;
+        }
+    } else if (table.tableId == TABLE_ID_PMT) {
+        TSProgramMapTable *pmt = [[TSProgramMapTable alloc] initWithPSI:table];
+        if (pmt) {
+            [self updatePmt:pmt];
+        }
+    } else if (self.mode == TSDemuxerModeDVB && table.tableId == TABLE_ID_DVB_SDT_ACTUAL_TS) {
+        TSDvbServiceDescriptionTable *sdt = [[TSDvbServiceDescriptionTable alloc] initWithPSI:table];
+        if (sdt) {
+            [self setSdt:sdt];
+        }
+    } else if (self.mode == TSDemuxerModeDVB && [TSDvbNetworkInformationTable isNitTableId:table.tableId]) {
+        TSDvbNetworkInformationTable *nit = [[TSDvbNetworkInformationTable alloc] initWithPSI:table];
+        if (nit) {
+            [self setNit:nit];
+        }
+    } else if (self.mode == TSDemuxerModeATSC &&
+               (table.tableId == TABLE_ID_ATSC_TVCT || table.tableId == TABLE_ID_ATSC_CVCT)) {
+        TSAtscVirtualChannelTable *vct = [[TSAtscVirtualChannelTable alloc] initWithPSI:table];
+        if (vct) {
+            [self setVct:vct];
+        }
+    } else if (self.mode == TSDemuxerModeATSC && table.tableId == TABLE_ID_ATSC_MGT) {
+        TSAtscMasterGuideTable *mgt = [[TSAtscMasterGuideTable alloc] initWithPSI:table];
+        if (mgt) {
+            [self setMgt:mgt];
+        }
+    }
+}
+
+#pragma mark - PID Subscriptions
+
+-(void)addSubscriber:(id<TSDemuxerPidSubscriber>)subscriber forPid:(uint16_t)pid
+{
+    NSHashTable<id<TSDemuxerPidSubscriber>> *subscribers = _subscribers[@(pid)];
+    if (!subscribers) {
+        subscribers = [NSHashTable weakObjectsHashTable];
+        _subscribers[@(pid)] = subscribers;
+    }
+    [subscribers addObject:subscriber];
+    [self updateSelectedEsPids];
+}
+
+-(void)removeSubscriber:(id<TSDemuxerPidSubscriber>)subscriber forPid:(uint16_t)pid
+{
+    NSHashTable<id<TSDemuxerPidSubscriber>> *subscribers = _subscribers[@(pid)];
+    if (!subscribers) {
+        return;
+    }
+    [subscribers removeObject:subscriber];
+    if (subscribers.allObjects.count == 0) {
+        [_subscribers removeObjectForKey:@(pid)];
+    }
+    [self updateSelectedEsPids];
+}
+
+-(void)removeSubscriber:(id<TSDemuxerPidSubscriber>)subscriber
+{
+    for (Pid pid in _subscribers.allKeys) {
+        [self removeSubscriber:subscriber forPid:pid.unsignedShortValue];
+    }
 }
 
 @end
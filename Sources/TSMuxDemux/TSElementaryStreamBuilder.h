@@ -8,9 +8,30 @@
 
 #import <Foundation/Foundation.h>
 #import "TSAccessUnit.h"
+#import "TSContinuityState.h"
 @class TSPacket;
 @class TSDescriptor;
 @class TSElementaryStreamBuilder;
+@class TSProgramTimeline;
+
+/// What a stream builder does when an access unit in progress exceeds its byte limit.
+typedef NS_ENUM(NSUInteger, TSAssemblyOverflowPolicy) {
+    /// Deliver the bytes collected so far with `isTruncated` set, then drop data until the next PUSI.
+    TSAssemblyOverflowPolicyTruncate,
+    /// Discard the access unit and drop data until the next PUSI.
+    TSAssemblyOverflowPolicyDrop,
+};
+
+/// Byte budget shared by the stream builders of one demuxer. Covers access units being
+/// assembled only - delivered access units are owned by the receiver.
+@interface TSAssemblyBudget : NSObject
+/// Maximum total bytes. 0 = unlimited.
+@property(nonatomic) NSUInteger limit;
+@property(nonatomic, readonly) NSUInteger usedBytes;
+/// Returns NO (and reserves nothing) if `bytes` do not fit within the limit.
+-(BOOL)reserveBytes:(NSUInteger)bytes;
+-(void)releaseBytes:(NSUInteger)bytes;
+@end
 
 @protocol TSElementaryStreamBuilderDelegate
 -(void)streamBuilder:(TSElementaryStreamBuilder* _Nonnull)builder didBuildAccessUnit:(TSAccessUnit* _Nonnull)accessUnit;
@@ -26,11 +47,33 @@
 @property(nonatomic, readonly) uint8_t streamType;
 @property(nonatomic, readonly, nullable) NSArray<TSDescriptor*>* descriptors;
 
+/// When YES (and the stream is H.264 or HEVC), NAL units are indexed while the payload is
+/// accumulated and delivered access units carry a `nalUnitIndex`. Access units containing
+/// an IDR/IRAP picture are then flagged as random access points even if the adaptation
+/// field random_access_indicator is not set. Ignored for other stream types.
+@property(nonatomic) BOOL nalIndexingEnabled;
+
+/// Maximum bytes collected for one access unit. 0 = unlimited (default).
+@property(nonatomic) NSUInteger maxBytes;
+/// Optional budget shared with other builders, charged for every collected byte.
+@property(nonatomic, strong, nullable) TSAssemblyBudget *budget;
+@property(nonatomic) TSAssemblyOverflowPolicy overflowPolicy;
+/// Bytes collected for the access unit in progress.
+@property(nonatomic, readonly) NSUInteger bufferedBytes;
+/// Number of access units truncated or dropped because a limit was hit.
+@property(nonatomic, readonly) NSUInteger overflowCount;
+/// Timeline of the program, shared with its other streams, that places the timestamps of delivered
+/// access units (`timelinePts`/`timelineDts`). If nil, they equal the raw `pts`/`dts`.
+@property(nonatomic, strong, nullable) TSProgramTimeline *timeline;
+
 -(instancetype _Nonnull)initWithDelegate:(id<TSElementaryStreamBuilderDelegate> _Nullable)delegate
                                      pid:(uint16_t)pid
                               streamType:(uint8_t)streamType
                              descriptors:(NSArray<TSDescriptor*>* _Nullable) descriptors;
 
+/// Checks the continuity counter against the last packet added.
 -(void)addTsPacket:(TSPacket* _Nonnull)tsPacket;
+/// Adds a packet whose continuity counter was already checked, e.g. by the demuxer for all PIDs at once.
+-(void)addTsPacket:(TSPacket* _Nonnull)tsPacket continuity:(TSContinuityVerdict)continuity;
 
 @end
@@ -10,24 +10,51 @@
 #import "TSPacket.h"
 #import "TSPesHeader.h"
 #import "TSStreamType.h"
-#import "TSContinuityChecker.h"
+#import "TSNalUnitIndex.h"
+#import "TSProgramTimeline.h"
 #import "TSLog.h"
 #import <CoreMedia/CoreMedia.h>
 
 @interface TSElementaryStreamBuilder()
 
-@property(nonatomic) CMTime pts;
-@property(nonatomic) CMTime dts;
+/// Raw header of the first PES packet of the access unit being collected.
+/// Timestamps are converted to CMTime only when the access unit is delivered.
+@property(nonatomic) TSPesHeaderInfo pesInfo;
 @property(nonatomic) BOOL isDiscontinuous;
 @property(nonatomic) BOOL isRandomAccessPoint;
 @property(nonatomic, strong) NSMutableData *collectedData;
 @property(nonatomic) TSResolvedStreamType resolvedStreamType;
 @property(nonatomic) BOOL isVideo;
-@property(nonatomic, strong) TSContinuityChecker *ccChecker;
+@property(nonatomic, strong, nullable) TSNalUnitIndexer *nalIndexer;
 
 @end
 
+#pragma mark - TSAssemblyBudget
+
+@implementation TSAssemblyBudget
+
+-(BOOL)reserveBytes:(NSUInteger)bytes
+{
+    if (self.limit > 0 && _usedBytes + bytes > self.limit) {
+        return NO;
+    }
+    _usedBytes += bytes;
+    return YES;
+}
+
+-(void)releaseBytes:(NSUInteger)bytes
+{
+    _usedBytes -= MIN(bytes, _usedBytes);
+}
+
+@end
+
+#pragma mark - TSElementaryStreamBuilder
+
 @implementation TSElementaryStreamBuilder
+{
+    TSContinuityState _ccState;
+}
 
 -(instancetype _Nonnull)initWithDelegate:(id<TSElementaryStreamBuilderDelegate>)delegate
                                      pid:(uint16_t)pid
@@ -41,14 +68,125 @@
         _streamType = streamType;
         _descriptors = descriptors;
         _collectedData = nil;
-        _ccChecker = [[TSContinuityChecker alloc] init];
         _resolvedStreamType = [TSStreamType resolveStreamType:streamType descriptors:descriptors];
         _isVideo = [TSStreamType isVideo:_resolvedStreamType];
     }
     return self;
 }
 
+-(void)dealloc
+{
+    [_budget releaseBytes:_collectedData.length];
+}
+
+-(void)setBudget:(TSAssemblyBudget *)budget
+{
+    // Move the bytes already collected over to the new budget
+    [_budget releaseBytes:self.collectedData.length];
+    _budget = budget;
+    if (![_budget reserveBytes:self.collectedData.length]) {
+        [self discardCollectedData];
+    }
+}
+
+-(NSUInteger)bufferedBytes
+{
+    return self.collectedData.length;
+}
+
+-(BOOL)nalIndexingEnabled
+{
+    return self.nalIndexer != nil;
+}
+
+-(void)setNalIndexingEnabled:(BOOL)nalIndexingEnabled
+{
+    if (!nalIndexingEnabled) {
+        self.nalIndexer = nil;
+        return;
+    }
+    if (self.nalIndexer) {
+        return;
+    }
+    if (self.resolvedStreamType == TSResolvedStreamTypeH264) {
+        self.nalIndexer = [[TSNalUnitIndexer alloc] initWithCodec:TSNalUnitCodecH264];
+    } else if (self.resolvedStreamType == TSResolvedStreamTypeH265) {
+        self.nalIndexer = [[TSNalUnitIndexer alloc] initWithCodec:TSNalUnitCodecH265];
+    }
+    // The indexer scans from offset 0 of the collected data, so enabling mid access unit
+    // is fine - the already collected bytes are picked up on the next scan.
+}
+
+-(void)deliverAccessUnit
+{
+    [self deliverAccessUnitTruncated:NO];
+}
+
+-(void)deliverAccessUnitTruncated:(BOOL)isTruncated
+{
+    TSNalUnitIndex *nalUnitIndex = [self.nalIndexer finishWithData:self.collectedData];
+    const CMTime pts = TSPesHeaderInfoPtsTime(&_pesInfo);
+    const CMTime dts = TSPesHeaderInfoDtsTime(&_pesInfo);
+    CMTime timelinePts = pts;
+    CMTime timelineDts = dts;
+    if (self.timeline) {
+        // In decoding order: DTS first
+        if (_pesInfo.hasDts) {
+            timelineDts = CMTimeMake([self.timeline timelineValueForTimestamp:_pesInfo.dts isDiscontinuous:self.isDiscontinuous],
+                                     TS_TIMESTAMP_TIMESCALE);
+        }
+        if (_pesInfo.hasPts) {
+            timelinePts = CMTimeMake([self.timeline timelineValueForTimestamp:_pesInfo.pts isDiscontinuous:self.isDiscontinuous],
+                                     TS_TIMESTAMP_TIMESCALE);
+        }
+    }
+    TSAccessUnit *accessUnit = [[TSAccessUnit alloc] initWithPid:self.pid
+                                                             pts:pts
+                                                             dts:dts
+                                                     timelinePts:timelinePts
+                                                     timelineDts:timelineDts
+                                                 isDiscontinuous:self.isDiscontinuous
+                                              isRandomAccessPoint:self.isRandomAccessPoint || nalUnitIndex.isKeyframe
+                                                      streamType:self.streamType
+                                                     descriptors:self.descriptors
+                                                  compressedData:self.collectedData
+                                                    nalUnitIndex:nalUnitIndex
+                                                     isTruncated:isTruncated];
+    [self.budget releaseBytes:self.collectedData.length];
+    self.collectedData = nil;
+    [self.delegate streamBuilder:self didBuildAccessUnit:accessUnit];
+}
+
+-(void)discardCollectedData
+{
+    [self.budget releaseBytes:self.collectedData.length];
+    self.collectedData = nil;
+    [self.nalIndexer reset];
+}
 
+/// Appends payload bytes to the access unit in progress, enforcing maxBytes and the budget.
+-(void)appendBytes:(const void *)bytes length:(NSUInteger)length
+{
+    const BOOL exceedsMaxBytes = self.maxBytes > 0 && self.collectedData.length + length > self.maxBytes;
+    if (exceedsMaxBytes || (self.budget && ![self.budget reserveBytes:length])) {
+        _overflowCount++;
+        if (self.overflowPolicy == TSAssemblyOverflowPolicyTruncate && self.collectedData.length > 0) {
+            TSLogWarn(@"Access unit on PID %u exceeds %@, truncating at %lu bytes",
+                      self.pid, exceedsMaxBytes ? @"per-PID limit" : @"demuxer budget",
+                      (unsigned long)self.collectedData.length);
+            [self deliverAccessUnitTruncated:YES];
+        } else {
+            TSLogWarn(@"Access unit on PID %u exceeds %@, dropping %lu bytes until next PUSI",
+                      self.pid, exceedsMaxBytes ? @"per-PID limit" : @"demuxer budget",
+                      (unsigned long)self.collectedData.length);
+        }
+        // Either way nothing more is collected until the next PUSI
+        [self discardCollectedData];
+        return;
+    }
+    [self.collectedData appendBytes:bytes length:length];
+    [self.nalIndexer scanData:self.collectedData];
+}
 
 -(void)addTsPacket:(TSPacket* _Nonnull)tsPacket
 {
@@ -56,33 +194,39 @@
         TSLogWarn(@"PID mismatch (got %u, expected %u)", tsPacket.header.pid, self.pid);
         return;
     }
+    [self addTsPacket:tsPacket continuity:TSContinuityStateCheckPacket(&_ccState, tsPacket)];
+}
 
-    TSContinuityCheckResult ccResult = [self.ccChecker checkPacket:tsPacket];
+-(void)addTsPacket:(TSPacket* _Nonnull)tsPacket continuity:(TSContinuityVerdict)continuity
+{
+    if (tsPacket.header.pid != self.pid) {
+        TSLogWarn(@"PID mismatch (got %u, expected %u)", tsPacket.header.pid, self.pid);
+        return;
+    }
 
-    if (ccResult == TSContinuityCheckResultGap) {
+    if (continuity.result == TSContinuityCheckResultGap) {
         // Packets were lost - discard in-progress data to avoid delivering corrupted access unit
         if (self.collectedData.length > 0) {
             TSLogWarn(@"CC gap on PID %u (packets lost), discarding %lu bytes",
                   self.pid, (unsigned long)self.collectedData.length);
         }
-        self.collectedData = nil;
-        self.pts = kCMTimeInvalid;
-        self.dts = kCMTimeInvalid;
+        [self discardCollectedData];
+        self.pesInfo = (TSPesHeaderInfo){0};
         return;
     }
 
-    if (ccResult == TSContinuityCheckResultDuplicate) {
+    if (continuity.result == TSContinuityCheckResultDuplicate) {
         return;
     }
 
     if (tsPacket.header.payloadUnitStartIndicator) {
-        // New PES packet starting - parse header only (no data copy)
-        TSPesHeader *pesHeader = [TSPesHeader parseFromPacket:tsPacket];
-        if (!pesHeader) {
+        // New PES packet starting - parse header only (no data copy, no allocation)
+        TSPesHeaderInfo pesInfo;
+        if (!TSPesHeaderParse(tsPacket.payload.bytes, tsPacket.payload.length, &pesInfo)) {
             return;
         }
 
-        const NSUInteger payloadLength = tsPacket.payload.length - pesHeader.payloadOffset;
+        const NSUInteger payloadLength = tsPacket.payload.length - pesInfo.payloadOffset;
 
         // Check if this PES packet belongs to the same access unit (same PTS).
         // This handles interlaced video where top and bottom fields are sent in separate
@@ -91,43 +235,33 @@
         // By aggregating PES packets with matching PTS, we ensure the decoder receives
         // complete frames/field-pairs rather than incomplete data.
         BOOL isSameAccessUnit = NO;
-        if (self.collectedData.length > 0 && CMTIME_IS_VALID(self.pts) && CMTIME_IS_VALID(pesHeader.pts)) {
-            isSameAccessUnit = CMTimeCompare(self.pts, pesHeader.pts) == 0;
+        if (self.collectedData.length > 0 && _pesInfo.hasPts && pesInfo.hasPts) {
+            isSameAccessUnit = _pesInfo.pts == pesInfo.pts;
         }
 
         if (isSameAccessUnit) {
             // Same PTS - this is a continuation of the same frame (e.g., another slice)
             // Append directly to accumulator - single copy
-            [self.collectedData appendBytes:tsPacket.payload.bytes + pesHeader.payloadOffset
-                                     length:payloadLength];
             // Preserve the original DTS and discontinuity flag from the first PES
+            [self appendBytes:tsPacket.payload.bytes + pesInfo.payloadOffset length:payloadLength];
         } else {
             // Different PTS - deliver the previous access unit if we have one
             if (self.collectedData.length > 0) {
-                TSAccessUnit *accessUnit = [[TSAccessUnit alloc] initWithPid:self.pid
-                                                                         pts:self.pts
-                                                                         dts:self.dts
-                                                             isDiscontinuous:self.isDiscontinuous
-                                                          isRandomAccessPoint:self.isRandomAccessPoint
-                                                                  streamType:self.streamType
-                                                                 descriptors:self.descriptors
-                                                              compressedData:self.collectedData];
-                [self.delegate streamBuilder:self didBuildAccessUnit:accessUnit];
-                self.collectedData = nil;
+                [self deliverAccessUnit];
             }
+            [self.nalIndexer reset];
 
             // Start collecting the new access unit - single copy directly to accumulator
-            self.pts = pesHeader.pts;
-            self.dts = pesHeader.dts;
-            self.isDiscontinuous = pesHeader.isDiscontinuous;
+            self.pesInfo = pesInfo;
+            self.isDiscontinuous = tsPacket.adaptationField.discontinuityFlag;
             self.isRandomAccessPoint = tsPacket.adaptationField.randomAccessFlag;
 
             // Estimate capacity to minimize reallocations during accumulation.
             NSUInteger capacity;
-            if (pesHeader.pesPacketLength != 0) {
+            if (pesInfo.pesPacketLength != 0) {
                 // pesPacketLength (num bytes remaining after the pesPacketLength field) is known - use it
                 // (including optional PES header field - slight over-allocation is fine).
-                capacity = pesHeader.pesPacketLength;
+                capacity = pesInfo.pesPacketLength;
             } else if (self.isVideo) {
                 // Unbounded PES (length=0) is common for video.
                 // HEVC uses larger CTUs (up to 64x64) vs H.264's 16x16 macroblocks,
@@ -148,9 +282,12 @@
                 capacity = 8 * 1024;
             }
 
+            if (self.maxBytes > 0) {
+                capacity = MIN(capacity, self.maxBytes);
+            }
+
             self.collectedData = [NSMutableData dataWithCapacity:capacity];
-            [self.collectedData appendBytes:tsPacket.payload.bytes + pesHeader.payloadOffset
-                                     length:payloadLength];
+            [self appendBytes:tsPacket.payload.bytes + pesInfo.payloadOffset length:payloadLength];
         }
     } else {
         // Continuation of PES packet
@@ -160,8 +297,7 @@
         }
         // Entire payload is PES continuation data - append directly
         if (tsPacket.payload.length > 0) {
-            [self.collectedData appendBytes:tsPacket.payload.bytes
-                                     length:tsPacket.payload.length];
+            [self appendBytes:tsPacket.payload.bytes length:tsPacket.payload.length];
         }
     }
 }
@@ -19,6 +19,12 @@ typedef NS_ENUM(NSInteger, TSLogLevel) {
 
 typedef void (^TSLogSinkBlock)(TSLogLevel level, NSString *className, NSString *message, NSTimeInterval timestamp);
 
+/// Rate limiting state of one logging call site. Zero-initialized `static` storage, declared by the
+/// logging macros - not for direct use.
+typedef struct {
+    uint64_t opaque[6];
+} TSLogSite;
+
 /**
  * TSLog provides centralized logging for TSMuxDemux.
  *
@@ -29,21 +35,52 @@ typedef void (^TSLogSinkBlock)(TSLogLevel level, NSString *className, NSString *
  *
  * Log format:
  *   [2024-01-15T10:30:45.123Z] [TS] [INFO] [TSDemuxer] Message here
+ *
+ * Messages are asynchronous by default: the calling thread only copies the format arguments into
+ * a binary record in a lock-free ring buffer, and a background thread formats, prints and passes
+ * them to the sink block. `%@` arguments are described on the calling thread, so they may be mutable. If the buffer is full, messages are dropped and counted.
+ *
+ * Each call site of the logging macros is rate limited by a token bucket (see
+ * `setRateLimitBurst:perSecond:`), so a burst of errors (e.g. one per packet of a degraded input)
+ * does not slow down the demuxer. Suppressed messages are summarized as
+ * "N messages suppressed" once the site logs again, or (when asynchronous) after at most a second.
  */
 @interface TSLog : NSObject
 
 +(void)setLevel:(TSLogLevel)level;
 
+/// Called on the logging thread when asynchronous.
 +(void)setLogSinkBlock:(TSLogSinkBlock _Nullable)block;
 
 +(TSLogLevel)currentLevel;
 
 +(NSString*)levelName:(TSLogLevel)level;
 
+/// YES (default): format on a background thread. NO: format and print on the calling thread. Suppressed
+/// messages are then only summarized when their site logs again, or by `flush`.
++(void)setAsynchronous:(BOOL)asynchronous;
+
+/// Each call site may log `burst` messages at once, refilled at `perSecond` messages per second.
+/// Defaults: 20 and 10. A `perSecond` of 0 disables rate limiting.
++(void)setRateLimitBurst:(NSUInteger)burst perSecond:(double)perSecond;
+
+/// Formats and prints all messages logged so far, including pending suppression summaries,
+/// before returning. E.g. before exiting, or before inspecting the sink in tests.
++(void)flush;
+
+/// Not rate limited.
 +(void)logWithLevel:(TSLogLevel)level
           className:(NSString*)className
              format:(NSString*)format, ... NS_FORMAT_FUNCTION(3,4);
 
+/// Used by the logging macros. The class name (from `cls`, or else the last path component of
+/// `file`) is only resolved when the message is formatted.
++(void)logWithLevel:(TSLogLevel)level
+              class:(Class _Nullable)cls
+               file:(const char * _Nullable)file
+               site:(TSLogSite * _Nullable)site
+             format:(NSString*)format, ... NS_FORMAT_FUNCTION(5,6);
+
 @end
 
 
@@ -58,12 +95,16 @@ typedef void (^TSLogSinkBlock)(TSLogLevel level, NSString *className, NSString *
 /**
  * Internal macro for generating log calls in ObjC method context.
  * Short-circuits to avoid format string evaluation when level disabled.
+ * Each expansion has its own rate limiting state.
  */
 #define _TSLogInternal(lvl, fmt, ...) \
     do { \
         if (TSLogIsLevelEnabled(lvl)) { \
+            static TSLogSite _tsLogSite; \
             [TSLog logWithLevel:(lvl) \
-                      className:NSStringFromClass([self class]) \
+                          class:[self class] \
+                           file:NULL \
+                           site:&_tsLogSite \
                          format:(fmt), ##__VA_ARGS__]; \
         } \
     } while(0)
@@ -75,8 +116,11 @@ typedef void (^TSLogSinkBlock)(TSLogLevel level, NSString *className, NSString *
 #define _TSLogInternalC(lvl, fmt, ...) \
     do { \
         if (TSLogIsLevelEnabled(lvl)) { \
+            static TSLogSite _tsLogSite; \
             [TSLog logWithLevel:(lvl) \
-                      className:[[NSString stringWithUTF8String:__FILE__] lastPathComponent] \
+                          class:Nil \
+                           file:__FILE__ \
+                           site:&_tsLogSite \
                          format:(fmt), ##__VA_ARGS__]; \
         } \
     } while(0)
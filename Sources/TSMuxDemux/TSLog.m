@@ -8,6 +8,17 @@
 #import "TSLog.h"
 #import <stdatomic.h>
 #import <os/lock.h>
+#import <pthread.h>
+#import <sched.h>
+
+// Records in the ring buffer (power of two)
+#define LOG_RING_SIZE 1024
+// Arguments copied per record (including '*' widths); messages with more are formatted on the calling thread
+#define LOG_MAX_ARGS 12
+// How often the suppression summaries of quiet call sites are printed
+#define LOG_SUMMARY_INTERVAL_SECONDS 1.0
+// Records taken out of the ring buffer at a time, to print them without holding sConsumerLock
+#define LOG_DRAIN_BATCH 32
 
 // Thread-safe storage for log level using atomic operations
 static _Atomic TSLogLevel sCurrentLogLevel = TSLogLevelInfo;
@@ -19,8 +30,612 @@ static os_unfair_lock sLogSinkLock = OS_UNFAIR_LOCK_INIT;
 // Key for thread-local date formatter cache
 static NSString* const kTSLogDateFormatKey = @"TSLogDateFormatter";
 
+static _Atomic bool sAsynchronous = true;
+static _Atomic double sRateLimitBurst = 20;
+static _Atomic double sRateLimitPerSecond = 10;
+
+#pragma mark - Records
+
+typedef NS_ENUM(uint8_t, TSLogArgKind) {
+    TSLogArgKindInt,
+    TSLogArgKindDouble,
+    TSLogArgKindObject,     // Retained, may be NULL
+    TSLogArgKindCString,    // Copied with strdup, may be NULL
+    TSLogArgKindPointer,
+};
+
+typedef union {
+    int64_t i;
+    double d;
+    const void *p;
+} TSLogArg;
+
+/// A message as logged: the format and a copy of its arguments, formatted on the logging thread.
+typedef struct {
+    _Atomic size_t sequence;
+    TSLogLevel level;
+    NSTimeInterval timestamp;
+    const void *cls;            // Class, resolved to a name when formatting
+    const char *file;           // __FILE__ of C call sites
+    CFTypeRef className;        // Retained, when logged with an explicit class name
+    CFTypeRef format;           // Retained
+    CFTypeRef message;          // Retained, when formatted on the calling thread instead
+    uint32_t suppressedCount;   // Messages of the call site suppressed before this one
+    uint8_t argCount;
+    TSLogArgKind kinds[LOG_MAX_ARGS];
+    TSLogArg args[LOG_MAX_ARGS];
+} TSLogRecord;
+
+// Bounded multi-producer queue (D. Vyukov): a slot is free for position `pos` when its sequence
+// is `pos`, and holds a record for it when its sequence is `pos + 1`.
+static TSLogRecord sRing[LOG_RING_SIZE];
+static _Atomic size_t sEnqueuePos = 0;
+static size_t sDequeuePos = 0;          // Guarded by sConsumerLock
+static _Atomic uint64_t sDroppedCount = 0;
+static os_unfair_lock sConsumerLock = OS_UNFAIR_LOCK_INIT;
+static dispatch_semaphore_t sRecordsAvailable;
+// Batches taken out of the ring buffer and not yet printed, in total and by the current thread
+static _Atomic uint32_t sBatchesInFlight = 0;
+static _Thread_local uint32_t sOwnBatchesInFlight = 0;
+
+#pragma mark - Call Sites
+
+/// What a suppression summary needs to know about its call site.
+typedef struct {
+    TSLogLevel level;
+    CFTypeRef format;
+    const void *cls;
+    const char *file;
+} TSLogSiteInfo;
+
+/// Internal layout of TSLogSite: a token bucket, and the count of messages suppressed since the
+/// last one that got through. Sites that ever suppressed are linked into sSuppressingSites.
+typedef struct TSLogSiteState {
+    os_unfair_lock lock;
+    _Atomic uint32_t suppressedCount;
+    double tokens;
+    double lastRefill;
+    _Atomic(struct TSLogSiteState *) next;
+    _Atomic(TSLogSiteInfo *) info;
+} TSLogSiteState;
+
+_Static_assert(sizeof(TSLogSiteState) <= sizeof(TSLogSite), "TSLogSite is too small");
+
+static _Atomic(TSLogSiteState *) sSuppressingSites = NULL;
+static NSTimeInterval sLastSummaryTime = 0;   // Guarded by sConsumerLock, 0 until the first drain
+
+static inline NSTimeInterval TSLogNow(void)
+{
+    return CFAbsoluteTimeGetCurrent() + kCFAbsoluteTimeIntervalSince1970;
+}
+
+/// Takes a token from the site's bucket. Returns NO if the message is to be suppressed, else the
+/// number of messages suppressed since the last one in `outSuppressedCount`.
+static BOOL TSLogSiteAdmit(TSLogSite *site, TSLogLevel level, NSString *format, const void *cls, const char *file,
+                           NSTimeInterval now, uint32_t *outSuppressedCount)
+{
+    const double perSecond = atomic_load_explicit(&sRateLimitPerSecond, memory_order_relaxed);
+    TSLogSiteState *state = (TSLogSiteState *)site;
+    if (perSecond > 0) {
+        const double burst = atomic_load_explicit(&sRateLimitBurst, memory_order_relaxed);
+        os_unfair_lock_lock(&state->lock);
+        state->tokens = state->lastRefill == 0 ? burst : MIN(burst, state->tokens + (now - state->lastRefill) * perSecond);
+        state->lastRefill = now;
+        const BOOL admitted = state->tokens >= 1.0;
+        if (admitted) {
+            state->tokens -= 1.0;
+        }
+        os_unfair_lock_unlock(&state->lock);
+
+        if (!admitted) {
+            atomic_fetch_add_explicit(&state->suppressedCount, 1, memory_order_relaxed);
+            if (!atomic_load_explicit(&state->info, memory_order_acquire)) {
+                // First suppression: register the site for the periodic summaries
+                TSLogSiteInfo *info = malloc(sizeof(TSLogSiteInfo));
+                *info = (TSLogSiteInfo){ .level = level, .format = CFBridgingRetain(format), .cls = cls, .file = file };
+                TSLogSiteInfo *expected = NULL;
+                if (atomic_compare_exchange_strong(&state->info, &expected, info)) {
+                    TSLogSiteState *head = atomic_load(&sSuppressingSites);
+                    do {
+                        atomic_store_explicit(&state->next, head, memory_order_relaxed);
+                    } while (!atomic_compare_exchange_weak(&sSuppressingSites, &head, state));
+                } else {
+                    CFRelease(info->format);
+                    free(info);
+                }
+            }
+            return NO;
+        }
+    }
+    *outSuppressedCount = atomic_exchange_explicit(&state->suppressedCount, 0, memory_order_relaxed);
+    return YES;
+}
+
+#pragma mark - Format Arguments
+
+/// One conversion specification of a format string, e.g. "%-8.3lu".
+typedef struct {
+    const char *body;       // Flags, width and precision, e.g. "-8.3" or "*"
+    size_t bodyLength;
+    char lengthModifier[3]; // "", "hh", "h", "l", "ll", "q", "L", "z", "t" or "j"
+    char conversion;
+    size_t length;          // From '%' through the conversion character
+} TSLogSpec;
+
+/// Parses the conversion specification starting at the '%' at `fmt`.
+/// Returns NO for those not supported by the deferred formatting (positional, wide strings, %n).
+static BOOL TSLogParseSpec(const char *fmt, TSLogSpec *spec)
+{
+    const char *p = fmt + 1;
+    spec->body = p;
+    while (*p && strchr("-+ #0'", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    if (*p == '$') {
+        return NO;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+    }
+    spec->bodyLength = (size_t)(p - spec->body);
+
+    size_t modifierLength = 0;
+    if ((p[0] == 'h' && p[1] == 'h') || (p[0] == 'l' && p[1] == 'l')) {
+        modifierLength = 2;
+    } else if (*p && strchr("hlqLztj", *p)) {
+        modifierLength = 1;
+    }
+    memcpy(spec->lengthModifier, p, modifierLength);
+    spec->lengthModifier[modifierLength] = '\0';
+    p += modifierLength;
+
+    if (!*p || !strchr("diouxXcCfFeEgGaAs@p%", *p)) {
+        return NO;
+    }
+    spec->conversion = *p;
+    spec->length = (size_t)(p + 1 - fmt);
+    if ((spec->conversion == 's' || spec->conversion == 'c') && spec->lengthModifier[0] == 'l') {
+        return NO;
+    }
+    return YES;
+}
+
+static int64_t TSLogReadSigned(const char *modifier, va_list *ap)
+{
+    if (modifier[0] == '\0') return va_arg(*ap, int);
+    if (!strcmp(modifier, "hh")) return (signed char)va_arg(*ap, int);
+    if (!strcmp(modifier, "h")) return (short)va_arg(*ap, int);
+    if (!strcmp(modifier, "l")) return va_arg(*ap, long);
+    if (!strcmp(modifier, "z")) return (int64_t)va_arg(*ap, size_t);
+    if (!strcmp(modifier, "t")) return va_arg(*ap, ptrdiff_t);
+    if (!strcmp(modifier, "j")) return va_arg(*ap, intmax_t);
+    return va_arg(*ap, long long);
+}
+
+static uint64_t TSLogReadUnsigned(const char *modifier, va_list *ap)
+{
+    if (modifier[0] == '\0') return va_arg(*ap, unsigned int);
+    if (!strcmp(modifier, "hh")) return (unsigned char)va_arg(*ap, int);
+    if (!strcmp(modifier, "h")) return (unsigned short)va_arg(*ap, int);
+    if (!strcmp(modifier, "l")) return va_arg(*ap, unsigned long);
+    if (!strcmp(modifier, "z")) return va_arg(*ap, size_t);
+    if (!strcmp(modifier, "t")) return (uint64_t)va_arg(*ap, ptrdiff_t);
+    if (!strcmp(modifier, "j")) return va_arg(*ap, uintmax_t);
+    return va_arg(*ap, unsigned long long);
+}
+
+static void TSLogReleaseArgs(TSLogRecord *record)
+{
+    for (uint8_t i = 0; i < record->argCount; i++) {
+        if (record->kinds[i] == TSLogArgKindObject && record->args[i].p) {
+            CFRelease(record->args[i].p);
+        } else if (record->kinds[i] == TSLogArgKindCString) {
+            free((void *)record->args[i].p);
+        }
+    }
+    record->argCount = 0;
+}
+
+/// Copies the arguments of `fmt` into the record, without formatting them, except objects: their
+/// description is taken now, as the caller may mutate them once the record is queued.
+/// Returns NO (with nothing retained) if the format is not supported.
+static BOOL TSLogCaptureArgs(const char *fmt, va_list *ap, TSLogRecord *record)
+{
+    record->argCount = 0;
+    for (const char *p = fmt; *p; ) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        TSLogSpec spec;
+        if (!TSLogParseSpec(p, &spec)) {
+            TSLogReleaseArgs(record);
+            return NO;
+        }
+        p += spec.length;
+        if (spec.conversion == '%') {
+            continue;
+        }
+        for (size_t i = 0; i <= spec.bodyLength; i++) {
+            const BOOL isStar = i < spec.bodyLength && spec.body[i] == '*';
+            if (!isStar && i < spec.bodyLength) {
+                continue;
+            }
+            if (record->argCount == LOG_MAX_ARGS) {
+                TSLogReleaseArgs(record);
+                return NO;
+            }
+            const uint8_t index = record->argCount++;
+            TSLogArg *arg = &record->args[index];
+            TSLogArgKind *kind = &record->kinds[index];
+            if (isStar) {
+                *kind = TSLogArgKindInt;
+                arg->i = va_arg(*ap, int);
+                continue;
+            }
+            switch (spec.conversion) {
+                case 'd': case 'i':
+                    *kind = TSLogArgKindInt;
+                    arg->i = TSLogReadSigned(spec.lengthModifier, ap);
+                    break;
+                case 'o': case 'u': case 'x': case 'X':
+                    *kind = TSLogArgKindInt;
+                    arg->i = (int64_t)TSLogReadUnsigned(spec.lengthModifier, ap);
+                    break;
+                case 'c': case 'C':
+                    *kind = TSLogArgKindInt;
+                    arg->i = va_arg(*ap, int);
+                    break;
+                case 's': {
+                    const char *string = va_arg(*ap, const char *);
+                    *kind = TSLogArgKindCString;
+                    arg->p = string ? strdup(string) : NULL;
+                    break;
+                }
+                case '@': {
+                    __unsafe_unretained id object = va_arg(*ap, id);
+                    *kind = TSLogArgKindObject;
+                    // A retain for immutable strings
+                    arg->p = object ? CFBridgingRetain([[object description] copy]) : NULL;
+                    break;
+                }
+                case 'p':
+                    *kind = TSLogArgKindPointer;
+                    arg->p = va_arg(*ap, void *);
+                    break;
+                default:
+                    *kind = TSLogArgKindDouble;
+                    arg->d = spec.lengthModifier[0] == 'L' ? (double)va_arg(*ap, long double) : va_arg(*ap, double);
+                    break;
+            }
+        }
+    }
+    return YES;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wformat-nonliteral"
+
+/// Formats one conversion with its captured argument(s), starting at `*argIndex`.
+static NSString *TSLogFormatSpec(const TSLogSpec *spec, const TSLogRecord *record, uint8_t *argIndex)
+{
+    char buffer[64];
+    size_t n = 0;
+    buffer[n++] = '%';
+    for (size_t i = 0; i < spec->bodyLength && n < sizeof(buffer) - 24; i++) {
+        if (spec->body[i] != '*') {
+            buffer[n++] = spec->body[i];
+            continue;
+        }
+        const int64_t value = record->args[(*argIndex)++].i;
+        if (value < 0 && n > 0 && buffer[n - 1] == '.') {
+            n--;  // A negative precision is taken as omitted
+            continue;
+        }
+        n += (size_t)snprintf(buffer + n, sizeof(buffer) - n, "%lld", (long long)value);
+    }
+    const TSLogArg arg = record->args[(*argIndex)++];
+    switch (spec->conversion) {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            buffer[n++] = 'l';
+            buffer[n++] = 'l';
+            break;
+        default:
+            break;
+    }
+    buffer[n++] = spec->conversion;
+    buffer[n] = '\0';
+
+    NSString *format = [[NSString alloc] initWithUTF8String:buffer];
+    switch (spec->conversion) {
+        case 'd': case 'i':
+            return [[NSString alloc] initWithFormat:format, (long long)arg.i];
+        case 'o': case 'u': case 'x': case 'X':
+            return [[NSString alloc] initWithFormat:format, (unsigned long long)arg.i];
+        case 'c': case 'C':
+            return [[NSString alloc] initWithFormat:format, (int)arg.i];
+        case 's':
+            return [[NSString alloc] initWithFormat:format, (const char *)arg.p];
+        case '@':
+            return [[NSString alloc] initWithFormat:format, (__bridge id)arg.p];
+        case 'p':
+            return [[NSString alloc] initWithFormat:format, arg.p];
+        default:
+            return [[NSString alloc] initWithFormat:format, arg.d];
+    }
+}
+
+#pragma clang diagnostic pop
+
+/// The format string as UTF-8, without a copy for constant strings.
+static const char *TSLogFormatCString(NSString *format)
+{
+    const char *fmt = CFStringGetCStringPtr((__bridge CFStringRef)format, kCFStringEncodingUTF8);
+    return fmt ?: format.UTF8String;
+}
+
+static NSString *TSLogFormatRecord(const TSLogRecord *record)
+{
+    if (record->message) {
+        return (__bridge NSString *)record->message;
+    }
+    const char *fmt = TSLogFormatCString((__bridge NSString *)record->format);
+    NSMutableString *message = [NSMutableString string];
+    const char *literal = fmt;
+    uint8_t argIndex = 0;
+    for (const char *p = fmt; ; ) {
+        if (*p != '%' && *p != '\0') {
+            p++;
+            continue;
+        }
+        if (p > literal) {
+            [message appendString:[[NSString alloc] initWithBytes:literal length:(NSUInteger)(p - literal)
+                                                         encoding:NSUTF8StringEncoding] ?: @""];
+        }
+        if (*p == '\0') {
+            break;
+        }
+        TSLogSpec spec;
+        TSLogParseSpec(p, &spec);   // Succeeded when the arguments were captured
+        if (spec.conversion == '%') {
+            [message appendString:@"%"];
+        } else {
+            [message appendString:TSLogFormatSpec(&spec, record, &argIndex)];
+        }
+        p += spec.length;
+        literal = p;
+    }
+    return message;
+}
+
+#pragma mark - Output
+
+static NSString *TSLogClassName(const void *cls, const char *file, CFTypeRef className)
+{
+    if (className) {
+        return (__bridge NSString *)className;
+    }
+    if (cls) {
+        return NSStringFromClass((__bridge Class)cls);
+    }
+    return file ? [[NSString stringWithUTF8String:file] lastPathComponent] : @"?";
+}
+
+@interface TSLog ()
++(NSString*)utcTimestampFromDate:(NSDate*)date;
+@end
+
+static void TSLogEmit(TSLogLevel level, NSString *className, NSString *message, NSTimeInterval timestamp)
+{
+    // Format final log line: [timestamp] [TS] [LEVEL] [ClassName] Message
+    NSString *timestampString = [TSLog utcTimestampFromDate:[NSDate dateWithTimeIntervalSince1970:timestamp]];
+    NSLog(@"[%@] [TS] [%@] [%@] %@", timestampString, [TSLog levelName:level], className, message);
+
+    // Call sink block if set
+    os_unfair_lock_lock(&sLogSinkLock);
+    TSLogSinkBlock lBlock = sLogSinkBlock;
+    os_unfair_lock_unlock(&sLogSinkLock);
+
+    if (lBlock) {
+        lBlock(level, className, message, timestamp);
+    }
+}
+
+static NSString *TSLogAppendSuppressed(NSString *message, uint32_t suppressedCount)
+{
+    return suppressedCount == 0 ? message
+        : [message stringByAppendingFormat:@" (%u similar messages suppressed)", suppressedCount];
+}
+
+/// Formats and prints a record taken out of the ring buffer, then releases what it retained.
+static void TSLogEmitRecord(TSLogRecord *record)
+{
+    @autoreleasepool {
+        NSString *message = TSLogAppendSuppressed(TSLogFormatRecord(record), record->suppressedCount);
+        TSLogEmit(record->level, TSLogClassName(record->cls, record->file, record->className), message, record->timestamp);
+    }
+    TSLogReleaseArgs(record);
+    if (record->format) CFRelease(record->format);
+    if (record->message) CFRelease(record->message);
+    if (record->className) CFRelease(record->className);
+}
+
+/// Prints the records in the ring buffer, then the summaries of call sites that are still
+/// suppressing if it is time (or `forceSummaries`). The records are moved out in batches under
+/// sConsumerLock and printed without it, so a slow sink does not hold up other drains, and a sink
+/// that logs or flushes does not deadlock.
+static void TSLogDrain(BOOL forceSummaries)
+{
+    TSLogRecord batch[LOG_DRAIN_BATCH];
+    size_t count;
+    do {
+        count = 0;
+        os_unfair_lock_lock(&sConsumerLock);
+        while (count < LOG_DRAIN_BATCH) {
+            TSLogRecord *record = &sRing[sDequeuePos & (LOG_RING_SIZE - 1)];
+            if (atomic_load_explicit(&record->sequence, memory_order_acquire) != sDequeuePos + 1) {
+                break;
+            }
+            // The copy takes over what the record retained
+            memcpy(&batch[count++], record, sizeof(TSLogRecord));
+            record->format = record->message = record->className = NULL;
+            record->argCount = 0;
+            atomic_store_explicit(&record->sequence, sDequeuePos + LOG_RING_SIZE, memory_order_release);
+            sDequeuePos++;
+        }
+        if (count > 0) {
+            atomic_fetch_add(&sBatchesInFlight, 1);
+            sOwnBatchesInFlight++;
+        }
+        os_unfair_lock_unlock(&sConsumerLock);
+
+        for (size_t i = 0; i < count; i++) {
+            TSLogEmitRecord(&batch[i]);
+        }
+        if (count > 0) {
+            sOwnBatchesInFlight--;
+            atomic_fetch_sub(&sBatchesInFlight, 1);
+        }
+    } while (count == LOG_DRAIN_BATCH);
+
+    os_unfair_lock_lock(&sConsumerLock);
+    const NSTimeInterval now = TSLogNow();
+    if (sLastSummaryTime == 0) {
+        // The first interval starts with the first drain
+        sLastSummaryTime = now;
+    }
+    const BOOL summarize = forceSummaries || now - sLastSummaryTime >= LOG_SUMMARY_INTERVAL_SECONDS;
+    if (summarize) {
+        sLastSummaryTime = now;
+    }
+    os_unfair_lock_unlock(&sConsumerLock);
+
+    const uint64_t droppedCount = atomic_exchange(&sDroppedCount, 0);
+    @autoreleasepool {
+        if (droppedCount > 0) {
+            TSLogEmit(TSLogLevelWarn, @"TSLog",
+                      [NSString stringWithFormat:@"%llu messages dropped (log buffer full)", droppedCount], now);
+        }
+        if (summarize) {
+            for (TSLogSiteState *site = atomic_load(&sSuppressingSites); site; site = atomic_load_explicit(&site->next, memory_order_relaxed)) {
+                const uint32_t suppressedCount = atomic_exchange_explicit(&site->suppressedCount, 0, memory_order_relaxed);
+                if (suppressedCount == 0) {
+                    continue;
+                }
+                const TSLogSiteInfo *info = atomic_load_explicit(&site->info, memory_order_acquire);
+                NSString *message = [NSString stringWithFormat:@"%u messages suppressed: \"%@\"",
+                                     suppressedCount, (__bridge NSString *)info->format];
+                TSLogEmit(info->level, TSLogClassName(info->cls, info->file, NULL), message, now);
+            }
+        }
+    }
+}
+
+static void *TSLogThreadMain(void *context)
+{
+    pthread_setname_np("TSLog");
+    for (;;) {
+        const dispatch_time_t timeout = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(LOG_SUMMARY_INTERVAL_SECONDS * NSEC_PER_SEC));
+        dispatch_semaphore_wait(sRecordsAvailable, timeout);
+        // When synchronous, nothing is queued and summaries wait for the site to log again or a flush
+        if (atomic_load_explicit(&sAsynchronous, memory_order_relaxed)) {
+            TSLogDrain(NO);
+        }
+    }
+    return NULL;
+}
+
+/// Logs on the calling thread (not asynchronous, or a format the ring buffer cannot carry).
+static void TSLogFormatNow(TSLogLevel level, const void *cls, const char *file, NSString *className,
+                           uint32_t suppressedCount, NSTimeInterval timestamp, NSString *format, va_list args)
+{
+    NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
+    TSLogEmit(level, className ?: TSLogClassName(cls, file, NULL), TSLogAppendSuppressed(message, suppressedCount), timestamp);
+}
+
+static void TSLogSubmit(TSLogLevel level, const void *cls, const char *file, NSString *className,
+                        uint32_t suppressedCount, NSTimeInterval timestamp, NSString *format, va_list args)
+{
+    if (!atomic_load_explicit(&sAsynchronous, memory_order_relaxed)) {
+        TSLogFormatNow(level, cls, file, className, suppressedCount, timestamp, format, args);
+        return;
+    }
+
+    // Claim a slot
+    TSLogRecord *record;
+    size_t pos = atomic_load_explicit(&sEnqueuePos, memory_order_relaxed);
+    for (;;) {
+        record = &sRing[pos & (LOG_RING_SIZE - 1)];
+        const size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+        const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&sEnqueuePos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&sDroppedCount, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&sEnqueuePos, memory_order_relaxed);
+        }
+    }
+
+    record->level = level;
+    record->timestamp = timestamp;
+    record->cls = cls;
+    record->file = file;
+    record->className = className ? CFBridgingRetain(className) : NULL;
+    record->suppressedCount = suppressedCount;
+    record->format = NULL;
+    record->message = NULL;
+    va_list capture;
+    va_copy(capture, args);
+    if (TSLogCaptureArgs(TSLogFormatCString(format), &capture, record)) {
+        record->format = CFBridgingRetain(format);
+    } else {
+        record->message = CFBridgingRetain([[NSString alloc] initWithFormat:format arguments:args]);
+    }
+    va_end(capture);
+    atomic_store_explicit(&record->sequence, pos + 1, memory_order_release);
+    dispatch_semaphore_signal(sRecordsAvailable);
+}
+
 @implementation TSLog
 
++(void)initialize
+{
+    if (self != [TSLog class]) {
+        return;
+    }
+    for (size_t i = 0; i < LOG_RING_SIZE; i++) {
+        atomic_init(&sRing[i].sequence, i);
+    }
+    sRecordsAvailable = dispatch_semaphore_create(0);
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    pthread_attr_set_qos_class_np(&attributes, QOS_CLASS_UTILITY, 0);
+    pthread_t thread;
+    pthread_create(&thread, &attributes, TSLogThreadMain, NULL);
+    pthread_attr_destroy(&attributes);
+}
+
 #pragma mark - Public Class Methods
 
 +(void)setLevel:(TSLogLevel)level
@@ -62,30 +677,55 @@ static NSString* const kTSLogDateFormatKey = @"TSLogDateFormatter";
     }
 }
 
++(void)setAsynchronous:(BOOL)asynchronous
+{
+    atomic_store(&sAsynchronous, asynchronous);
+    if (!asynchronous) {
+        // Keep the order: what was logged before goes out first
+        TSLogDrain(NO);
+    }
+}
+
++(void)setRateLimitBurst:(NSUInteger)burst perSecond:(double)perSecond
+{
+    atomic_store(&sRateLimitBurst, (double)burst);
+    atomic_store(&sRateLimitPerSecond, perSecond);
+}
+
++(void)flush
+{
+    TSLogDrain(YES);
+    // Another thread may still be printing records it took out before
+    while (atomic_load(&sBatchesInFlight) > sOwnBatchesInFlight) {
+        sched_yield();
+    }
+}
+
 +(void)logWithLevel:(TSLogLevel)level
           className:(NSString*)className
              format:(NSString*)format, ...
 {
-    // Format the user message
     va_list args;
     va_start(args, format);
-    NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
+    TSLogSubmit(level, NULL, NULL, className, 0, TSLogNow(), format, args);
     va_end(args);
+}
 
-    // Format final log line: [timestamp] [TS] [LEVEL] [ClassName] Message
-    NSDate *now = [NSDate date];
-    NSString *timestamp = [self utcTimestampFromDate:now];
-    NSString *levelName = [self levelName:level];
-    NSLog(@"[%@] [TS] [%@] [%@] %@", timestamp, levelName, className, message);
-
-    // Call sink block if set
-    os_unfair_lock_lock(&sLogSinkLock);
-    TSLogSinkBlock lBlock = sLogSinkBlock;
-    os_unfair_lock_unlock(&sLogSinkLock);
-
-    if (lBlock) {
-        lBlock(level, className, message, [now timeIntervalSince1970]);
++(void)logWithLevel:(TSLogLevel)level
+              class:(Class _Nullable)cls
+               file:(const char * _Nullable)file
+               site:(TSLogSite * _Nullable)site
+             format:(NSString*)format, ...
+{
+    const NSTimeInterval now = TSLogNow();
+    uint32_t suppressedCount = 0;
+    if (site && !TSLogSiteAdmit(site, level, format, (__bridge const void *)cls, file, now, &suppressedCount)) {
+        return;
     }
+    va_list args;
+    va_start(args, format);
+    TSLogSubmit(level, (__bridge const void *)cls, file, nil, suppressedCount, now, format, args);
+    va_end(args);
 }
 
 #pragma mark - Private Helpers
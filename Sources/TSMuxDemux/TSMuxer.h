@@ -11,8 +11,36 @@
 #import "TSAccessUnit.h"
 @class TSMuxer;
 
-@protocol TSMuxerDelegate
+@protocol TSMuxerDelegate <NSObject>
 -(void)muxer:(TSMuxer * _Nonnull)muxer didMuxTSPacketData:(NSData* _Nonnull)tsPacketData;
+
+@optional
+/// Called right before the first TS packet of `accessUnit` (a whole PES: a pack of audio access
+/// units is passed as one, with the timestamps and flags of its first frame) is passed to
+/// muxer:didMuxTSPacketData:, on the same thread. Lets a consumer find access unit boundaries
+/// and random access points in the packet flow without parsing it (see TSHlsSegmenter).
+-(void)muxer:(TSMuxer * _Nonnull)muxer willMuxAccessUnit:(TSAccessUnit * _Nonnull)accessUnit;
+@end
+
+/// How consecutive audio access units of one PID are packed into a single PES packet.
+///
+/// Every PES ends in a mostly stuffed TS packet, which for short audio frames (e.g. ~300 byte AAC
+/// frames) costs about as much as the frame itself. Packing several frames per PES removes most of
+/// that overhead. The PES carries the PTS of its first frame.
+@interface TSAudioPackingPolicy : NSObject <NSCopying>
+
+/// Maximum PTS span of the frames in one PES, and maximum time a frame is held back waiting for
+/// the next ones, in milliseconds. Must be > 0. Frames are released when the span is reached, or
+/// by the first `tick` this long after the first frame was enqueued, so the added latency is
+/// bounded by this value (plus the tick interval).
+@property(nonatomic) NSUInteger maxDurationMs;
+
+/// Maximum number of payload bytes in one PES. When 0, limited by the PES_packet_length field only.
+@property(nonatomic) NSUInteger maxPayloadBytes;
+
++(instancetype _Nonnull)policyWithMaxDurationMs:(NSUInteger)maxDurationMs
+                                maxPayloadBytes:(NSUInteger)maxPayloadBytes;
+
 @end
 
 @interface TSMuxerSettings : NSObject <NSCopying>
@@ -50,9 +78,42 @@
 @property(nonatomic) NSUInteger targetBitrateKbps;
 
 /// Maximum number of queued access units before oldest are dropped.
-/// When 0, the queue is unlimited.
+/// When 0, the queue is unlimited. Applies to submitted access units when tick takes them in.
 @property(nonatomic) NSUInteger maxNumQueuedAccessUnits;
 
+/// Audio packing policies, keyed by PID. Audio access units on other PIDs get one PES each.
+@property(nonatomic, copy, nullable) NSDictionary<NSNumber*, TSAudioPackingPolicy*> *audioPackingPolicies;
+
+/// PID for SCTE-35 cues (stream type 0x86), listed in the PMT. When 0, cues cannot be scheduled.
+/// Otherwise must be a valid custom PID, not used by the other streams.
+@property(nonatomic) uint16_t scte35Pid;
+
+/// How often a scheduled cue is sent again until its splice point, in milliseconds.
+/// When 0, each cue is sent once.
+@property(nonatomic) NSUInteger scte35RepeatIntervalMs;
+
+@end
+
+/// Timing of the batches sent by the pacing thread (see `-[TSMuxer startPacingWithPacketsPerBatch:]`).
+/// Times are in nanoseconds of the muxer's wall clock.
+@interface TSMuxerPacingStatistics : NSObject
+
+@property(nonatomic, readonly) uint64_t numBatches;
+@property(nonatomic, readonly) uint64_t numPackets;
+
+/// Largest number of packets sent in one batch. Above packetsPerBatch when the thread fell behind
+/// and caught up with a burst.
+@property(nonatomic, readonly) NSUInteger maxPacketsPerBatch;
+
+/// Deviation of the interval between consecutive batches from its nominal value (packetsPerBatch
+/// packet durations at the target bitrate): root mean square and largest absolute value.
+@property(nonatomic, readonly) double rmsJitterNanos;
+@property(nonatomic, readonly) uint64_t maxJitterNanos;
+
+/// Delay of the batches after their due time: mean and largest.
+@property(nonatomic, readonly) double meanLatenessNanos;
+@property(nonatomic, readonly) uint64_t maxLatenessNanos;
+
 @end
 
 /// A (basic) "single program" transport stream muxer.
@@ -77,15 +138,87 @@
                                delegate:(id<TSMuxerDelegate> _Nullable)delegate;
 
 /// Enqueue an access unit. Does NOT emit any packets.
+/// Audio access units on a PID with an audio packing policy are held back and combined with the
+/// following ones (see `TSAudioPackingPolicy`).
 /// The PTS and DTS should be in the local/host timescale (i.e. do NOT convert to MPEGTS timescale).
 /// Not thread safe — call from the same thread/queue as tick.
 -(void)enqueueAccessUnit:(TSAccessUnit* _Nonnull)accessUnit;
 
+/// Submit an access unit from any thread, e.g. directly from encoder callbacks. Lock free: the
+/// access unit is pushed on a multi-producer queue that the next tick drains, in submission order,
+/// as if passed to enqueueAccessUnit: (DTS ordering, audio packing and the overflow drop policy
+/// apply then). Raises on an invalid PID like enqueueAccessUnit:.
+-(void)submitAccessUnit:(TSAccessUnit* _Nonnull)accessUnit;
+
+/// Schedules an SCTE-35 splice_insert() of a program splice at `spliceTime`, in the local/host
+/// timescale of the access units, on settings.scte35Pid. `breakDuration` (kCMTimeInvalid if none)
+/// makes the splicer return to the network by itself.
+///
+/// The cue is sent ahead of the splice point: by the next tick, then every scte35RepeatIntervalMs,
+/// taking the place of content or null packets so that CBR output keeps its bitrate. The splice
+/// point is the first video access unit with a PTS at or after `spliceTime` that is a random access
+/// point, so the encoder should force an IDR frame at `spliceTime`. Its first TS packet has the
+/// splicing_point_flag set with splice_countdown -1, and the last TS packet of the video access
+/// unit before it splice_countdown 0 when that one is packetized while the splice point is queued.
+/// The cue is retired once the splice point is packetized, and sent first if it was not yet.
+///
+/// Raises when settings.scte35Pid is 0 or `spliceTime` is invalid. Not thread safe — call from the
+/// same thread/queue as tick (so not while pacing).
+-(void)scheduleSpliceInsertWithEventId:(uint32_t)spliceEventId
+                        isOutOfNetwork:(BOOL)isOutOfNetwork
+                            spliceTime:(CMTime)spliceTime
+                         breakDuration:(CMTime)breakDuration;
+
+/// Schedules an SCTE-35 time_signal() at `spliceTime` with `spliceDescriptors`, complete
+/// splice_descriptor()s (see `+[TSScte35SegmentationDescriptor makeDescriptorWithEventId:...]`)
+/// or nil. Sent and spliced like `scheduleSpliceInsertWithEventId:...`. Also raises when the
+/// descriptors do not fit in a section.
+-(void)scheduleTimeSignalAtTime:(CMTime)spliceTime
+              spliceDescriptors:(NSData* _Nullable)spliceDescriptors;
+
+/// Cues scheduled and not yet retired by their splice point.
+@property(nonatomic, readonly) NSUInteger scheduledSpliceCueCount;
+
+/// Access units submitted with submitAccessUnit: and not yet taken in by tick. Any thread.
+@property(readonly) NSUInteger submittedAccessUnitCount;
+
+/// Access units waiting to be packetized, as of the last enqueue or tick. Any thread.
+@property(readonly) NSUInteger queuedAccessUnitCount;
+
+/// Total number of access units dropped because the queue overflowed. Any thread.
+@property(readonly) uint64_t droppedAccessUnitCount;
+
 /// Emit packets up to the current wall-clock time.
 /// In CBR mode: paces content + null packets to maintain targetBitrateKbps.
 /// In VBR mode: flushes all queued access units immediately.
 /// The caller is responsible for calling this at a regular interval (e.g. every 10ms).
 /// Not thread safe — call from the same thread/queue as enqueueAccessUnit:.
+/// Only submitAccessUnit: and the counters may be used concurrently with it.
 -(void)tick;
 
+/// CBR only: start a dedicated thread that calls tick each time `packetsPerBatch` packets are due,
+/// instead of the caller calling it every few milliseconds and getting bursts of all packets due
+/// since the last call. The thread sleeps until shortly before the due time and spins the rest,
+/// adapting the spin to the observed wake-up latency, so batches leave within microseconds of
+/// their due time. wallClockNanos must then advance in real time, or with `pacingSleepNanos`.
+/// While pacing, the delegate is called on the pacing thread and access units must be passed with
+/// submitAccessUnit:; do not call enqueueAccessUnit: or tick. Raises in VBR mode or when
+/// `packetsPerBatch` is 0. Typically 7 (1316 bytes, one UDP datagram).
+-(void)startPacingWithPacketsPerBatch:(NSUInteger)packetsPerBatch;
+
+/// Stops the pacing thread and waits for it to exit. Must not be called from the delegate.
+/// The muxer is retained by the pacing thread until then.
+-(void)stopPacing;
+
+@property(readonly) BOOL isPacing;
+
+/// Sleeps the pacing thread for the given number of nanoseconds. nil (default): nanosleep.
+/// Together with a simulated wallClockNanos, e.g. to run the pacing loop in simulated time in
+/// tests: the clock must then also advance while the thread spins, i.e. as it is read.
+/// Read when pacing starts.
+@property(nonatomic, copy, nullable) void (^pacingSleepNanos)(uint64_t nanos);
+
+/// Statistics of the current (or last) pacing run. Any thread.
+-(TSMuxerPacingStatistics * _Nonnull)pacingStatistics;
+
 @end
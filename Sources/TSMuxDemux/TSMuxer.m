@@ -12,12 +12,16 @@
 #import "TSPacket.h"
 #import "Table/TSProgramAssociationTable.h"
 #import "Table/TSProgramMapTable.h"
+#import "Table/SCTE35/TSScte35SpliceInfoSection.h"
+#import "TSTimeUtil.h"
 #import "TSLog.h"
+#import <stdatomic.h>
+#import <os/lock.h>
+#import <pthread.h>
+#import <time.h>
 
 #pragma mark - TSMuxerSettings
 
-#define STATS_LOG_INTERVAL_MS 10000
-
 @implementation TSMuxerSettings
 
 -(instancetype)copyWithZone:(NSZone *)zone
@@ -31,11 +35,63 @@
     copy.pcrIntervalMs = self.pcrIntervalMs;
     copy.targetBitrateKbps = self.targetBitrateKbps;
     copy.maxNumQueuedAccessUnits = self.maxNumQueuedAccessUnits;
+    if (self.audioPackingPolicies) {
+        copy.audioPackingPolicies = [[NSDictionary alloc] initWithDictionary:self.audioPackingPolicies copyItems:YES];
+    }
+    copy.scte35Pid = self.scte35Pid;
+    copy.scte35RepeatIntervalMs = self.scte35RepeatIntervalMs;
     return copy;
 }
 
 @end
 
+#pragma mark - TSAudioPackingPolicy
+
+/// Largest payload whose PES_packet_length still fits 16 bits: the length also counts the
+/// flags, the header data length and the PTS/DTS (3 + 2 * 5 bytes).
+#define MAX_PACKED_PES_PAYLOAD_SIZE (UINT16_MAX - 13)
+
+@implementation TSAudioPackingPolicy
+
++(instancetype)policyWithMaxDurationMs:(NSUInteger)maxDurationMs maxPayloadBytes:(NSUInteger)maxPayloadBytes
+{
+    TSAudioPackingPolicy *policy = [[TSAudioPackingPolicy alloc] init];
+    policy.maxDurationMs = maxDurationMs;
+    policy.maxPayloadBytes = maxPayloadBytes;
+    return policy;
+}
+
+-(instancetype)copyWithZone:(NSZone *)zone
+{
+    TSAudioPackingPolicy *copy = [[self class] allocWithZone:zone];
+    copy.maxDurationMs = self.maxDurationMs;
+    copy.maxPayloadBytes = self.maxPayloadBytes;
+    return copy;
+}
+
+@end
+
+static inline NSUInteger packedPayloadLimit(TSAudioPackingPolicy *policy)
+{
+    return (policy.maxPayloadBytes == 0 || policy.maxPayloadBytes > MAX_PACKED_PES_PAYLOAD_SIZE)
+        ? MAX_PACKED_PES_PAYLOAD_SIZE : policy.maxPayloadBytes;
+}
+
+#pragma mark - TSMuxerPacingStatistics
+
+@interface TSMuxerPacingStatistics ()
+@property(nonatomic, readwrite) uint64_t numBatches;
+@property(nonatomic, readwrite) uint64_t numPackets;
+@property(nonatomic, readwrite) NSUInteger maxPacketsPerBatch;
+@property(nonatomic, readwrite) double rmsJitterNanos;
+@property(nonatomic, readwrite) uint64_t maxJitterNanos;
+@property(nonatomic, readwrite) double meanLatenessNanos;
+@property(nonatomic, readwrite) uint64_t maxLatenessNanos;
+@end
+
+@implementation TSMuxerPacingStatistics
+@end
+
 #pragma mark - TSMuxer
 
 /// The number of the (one and only) program carried in this ts-stream.
@@ -47,6 +103,12 @@
 
 static const uint64_t kNeverSent = UINT64_MAX;
 
+#define STATS_LOG_INTERVAL_MS 10000
+
+/// Bounds of the time the pacing thread spins before a due time instead of sleeping.
+#define PACING_MIN_SPIN_NANOS 20000
+#define PACING_MAX_SPIN_NANOS 2000000
+
 
 /// PCR state.
 /// Value: transport-time-driven (virtual in CBR, wall-clock in VBR).
@@ -70,6 +132,8 @@ typedef struct {
 @property(nonatomic, readonly, nonnull) NSData *data;
 @property(nonatomic, readonly) uint16_t pid;
 @property(nonatomic, readonly) uint8_t cc;
+/// Set on the first packet of an access unit.
+@property(nonatomic, strong, nullable) TSAccessUnit *accessUnit;
 +(instancetype _Nonnull)packetWithData:(NSData * _Nonnull)data pid:(uint16_t)pid cc:(uint8_t)cc;
 @end
 
@@ -83,11 +147,82 @@ typedef struct {
 }
 @end
 
+/// Node of the submitted access unit queue. Holds a +1 reference to the access unit.
+typedef struct TSSubmittedNode {
+    struct TSSubmittedNode *_Atomic next;
+    CFTypeRef accessUnit;
+} TSSubmittedNode;
+
+/// Accumulated timing of the pacing thread's batches.
+typedef struct {
+    uint64_t numBatches;
+    uint64_t numPackets;
+    NSUInteger maxPacketsPerBatch;
+    uint64_t numIntervals;
+    double sumSquaredJitter;
+    uint64_t maxJitterNanos;
+    double sumLateness;
+    uint64_t maxLatenessNanos;
+} TSPacingStats;
+
+/// Audio access units of one PID waiting to be sent as one PES.
+@interface TSAudioPack : NSObject
+@property(nonatomic, readonly, nonnull) NSMutableArray<TSAccessUnit*> *accessUnits;
+@property(nonatomic) NSUInteger payloadSize;
+/// Wall clock time when the first access unit was enqueued.
+@property(nonatomic) uint64_t startNanos;
+@end
+
+@implementation TSAudioPack
+-(instancetype)init {
+    self = [super init];
+    if (self) {
+        _accessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+@end
+
+/// An SCTE-35 cue waiting for its splice point.
+@interface TSSpliceCue : NSObject
+@property(nonatomic) uint8_t spliceCommandType;
+@property(nonatomic) uint32_t spliceEventId;
+@property(nonatomic) BOOL isOutOfNetwork;
+/// Local/host timescale, like the access units.
+@property(nonatomic) CMTime spliceTime;
+@property(nonatomic) CMTime breakDuration;
+@property(nonatomic, nullable) NSData *spliceDescriptors;
+/// Transport time when the cue was last sent. kNeverSent = not yet sent.
+@property(nonatomic) uint64_t sendTimeNanos;
+/// Set once warned that the video access unit at the splice time is not a random access point.
+@property(nonatomic) BOOL isSplicePointDeferred;
+@end
+
+@implementation TSSpliceCue
+@end
+
 @interface TSMuxer() {
     TSPcrState _pcr;
     /// DTS/PTS of the first access unit — subtracted from all DTS/PTS so that timestamps
     /// start from zero, aligning them with the PCR clock (which also starts from zero).
     CMTime _ptsAnchor;
+
+    // Intrusive multi-producer single-consumer queue (D. Vyukov) of access units submitted from
+    // any thread: producers swap themselves in at the head, tick pops from the tail. The stub
+    // node keeps the list non-empty.
+    TSSubmittedNode *_Atomic _submittedHead;
+    TSSubmittedNode *_submittedTail;
+    TSSubmittedNode _submittedStub;
+    _Atomic NSUInteger _submittedCount;
+    _Atomic NSUInteger _queuedCount;
+    _Atomic uint64_t _droppedCount;
+
+    // Pacing thread
+    _Atomic BOOL _pacing;
+    pthread_t _pacingThread;
+    NSUInteger _packetsPerBatch;
+    os_unfair_lock _pacingStatsLock;
+    TSPacingStats _pacingStats;
 }
 
 @property(nonatomic, readonly, nonnull) TSProgramAssociationTable *pat;
@@ -108,12 +243,23 @@ typedef struct {
 @property(nonatomic) uint64_t startTimeWallClockNanos;
 
 /// TS packets waiting to be paced out at the CBR rate. Contains packets from at most
-/// one AU at a time (single PID) — fully drained before the next AU is packetized.
+/// one AU at a time (single PID, preceded by the cues of its splice point that were not sent yet)
+/// — fully drained before the next AU is packetized.
 @property(nonatomic, readonly, nonnull) NSMutableArray<TSPacketizedPacket*> *pendingTsPackets;
 
 /// PIDs that need their next emitted packet to carry the discontinuity flag.
 @property(nonatomic, readonly, nonnull) NSMutableSet<NSNumber*> *discontinuousPids;
 
+/// Audio access units being packed, per PID with an audio packing policy.
+@property(nonatomic, readonly, nonnull) NSMutableDictionary<NSNumber*, TSAudioPack*> *audioPacks;
+
+/// Track of the SCTE-35 cue PID, nil without one.
+@property(nonatomic, readonly, nullable) TSElementaryStream *cueTrack;
+/// Scheduled SCTE-35 cues, in splice time order.
+@property(nonatomic, readonly, nonnull) NSMutableArray<TSSpliceCue*> *spliceCues;
+
+-(void)runPacingLoop;
+
 /// Stats
 @property(nonatomic) uint64_t statsLastLogTimeMs;
 @property(nonatomic) uint64_t statsTsPacketCount;
@@ -156,6 +302,24 @@ typedef struct {
     if (settings.pcrIntervalMs == 0) {
         [NSException raise:@"TSMuxerInvalidSettingsException" format:@"PCR interval must be > 0"];
     }
+    if (settings.scte35Pid != 0) {
+        if ([TSPidUtil isCustomPidInvalid:settings.scte35Pid]) {
+            [NSException raise:@"TSMuxerInvalidPidException" format:@"SCTE-35 PID is reserved/out of valid range"];
+        }
+        if (settings.scte35Pid == settings.pmtPid || settings.scte35Pid == settings.pcrPid
+            || settings.scte35Pid == settings.videoPid || settings.scte35Pid == settings.audioPid
+            || settings.audioPackingPolicies[@(settings.scte35Pid)]) {
+            [NSException raise:@"TSMuxerInvalidPidException" format:@"SCTE-35 PID must not be used by another stream"];
+        }
+    }
+    for (NSNumber *pid in settings.audioPackingPolicies) {
+        if ([TSPidUtil isCustomPidInvalid:pid.unsignedShortValue] || pid.unsignedShortValue == settings.pmtPid) {
+            [NSException raise:@"TSMuxerInvalidPidException" format:@"Audio packing PID %@ is reserved/occupied/out of valid range", pid];
+        }
+        if (settings.audioPackingPolicies[pid].maxDurationMs == 0) {
+            [NSException raise:@"TSMuxerInvalidSettingsException" format:@"Audio packing duration must be > 0"];
+        }
+    }
 }
 
 -(instancetype _Nonnull)initWithSettings:(TSMuxerSettings * _Nonnull)settings
@@ -186,12 +350,35 @@ typedef struct {
         _accessUnits = [NSMutableArray array];
         _pendingTsPackets = [NSMutableArray array];
         _discontinuousPids = [NSMutableSet set];
+        _audioPacks = [NSMutableDictionary dictionary];
+        _spliceCues = [NSMutableArray array];
+        if (_settings.scte35Pid != 0) {
+            _cueTrack = [[TSElementaryStream alloc] initWithPid:_settings.scte35Pid
+                                                     streamType:kRawStreamTypeSCTE35
+                                                    descriptors:nil];
+            [self addElementaryStream:_cueTrack];
+        }
         _wallClockNanos = [wallClockNanos copy];
+
+        atomic_init(&_submittedStub.next, NULL);
+        atomic_init(&_submittedHead, &_submittedStub);
+        _submittedTail = &_submittedStub;
+        atomic_init(&_pacing, NO);
+        _pacingStatsLock = OS_UNFAIR_LOCK_INIT;
     }
     
     return self;
 }
 
+-(void)dealloc
+{
+    TSSubmittedNode *node;
+    while ((node = [self popSubmittedNode])) {
+        CFRelease(node->accessUnit);
+        free(node);
+    }
+}
+
 -(TSMuxerSettings*)settings
 {
     return [_settings copy];
@@ -225,11 +412,17 @@ typedef struct {
     return nil;
 }
 
--(void)enqueueAccessUnit:(TSAccessUnit *)accessUnit
+-(void)validateAccessUnit:(TSAccessUnit *)accessUnit
 {
-    if ([TSPidUtil isCustomPidInvalid:accessUnit.pid] || accessUnit.pid == _settings.pmtPid) {
+    if ([TSPidUtil isCustomPidInvalid:accessUnit.pid] || accessUnit.pid == _settings.pmtPid
+        || (self.cueTrack && accessUnit.pid == self.cueTrack.pid)) {
         [NSException raise:@"TSMuxerInvalidPidException" format:@"Pid is reserved/occupied/out of valid range"];
     }
+}
+
+-(void)enqueueAccessUnit:(TSAccessUnit *)accessUnit
+{
+    [self validateAccessUnit:accessUnit];
     
     TSElementaryStream *track = [self elementaryStreamWithPid:accessUnit.pid];
     if (!track) {
@@ -239,12 +432,24 @@ typedef struct {
         [self addElementaryStream:track];
     }
     
+    TSAudioPackingPolicy *packingPolicy = accessUnit.isAudio ? _settings.audioPackingPolicies[@(accessUnit.pid)] : nil;
+    if (packingPolicy) {
+        [self packAudioAccessUnit:accessUnit policy:packingPolicy];
+    } else {
+        [self queueAccessUnit:accessUnit];
+    }
+    self.statsAccessUnitCount++;
+}
+
+-(void)queueAccessUnit:(TSAccessUnit *)accessUnit
+{
     // Drop oldest access unit during backpressure to make room
     if (_settings.maxNumQueuedAccessUnits > 0 && self.accessUnits.count >= _settings.maxNumQueuedAccessUnits) {
         TSAccessUnit *dropped = self.accessUnits[0];
         [self.accessUnits removeObjectAtIndex:0];
         [self.discontinuousPids addObject:@(dropped.pid)];
         self.statsDroppedAccessUnitCount++;
+        atomic_fetch_add_explicit(&_droppedCount, 1, memory_order_relaxed);
         TSLogWarn(@"Queue overflow: dropped oldest access unit (PID: %u)", dropped.pid);
     }
     
@@ -263,20 +468,176 @@ typedef struct {
         }
     }
     [self.accessUnits insertObject:accessUnit atIndex:insertIndex];
-    self.statsAccessUnitCount++;
+    atomic_store_explicit(&_queuedCount, self.accessUnits.count, memory_order_relaxed);
 }
 
 -(void)tick
 {
+    [self drainSubmittedAccessUnits];
+    [self flushExpiredAudioPacks:self.wallClockNanos()];
+
     if (_settings.targetBitrateKbps > 0) {
         [self doMuxCBR];
     } else {
         [self doMuxVBR];
     }
+    atomic_store_explicit(&_queuedCount, self.accessUnits.count, memory_order_relaxed);
     
     [self maybeLogStats];
 }
 
+#pragma mark - Concurrent Submission
+
+-(void)submitAccessUnit:(TSAccessUnit *)accessUnit
+{
+    [self validateAccessUnit:accessUnit];
+
+    TSSubmittedNode *node = malloc(sizeof(TSSubmittedNode));
+    atomic_init(&node->next, NULL);
+    node->accessUnit = CFBridgingRetain(accessUnit);
+    atomic_fetch_add_explicit(&_submittedCount, 1, memory_order_relaxed);
+
+    TSSubmittedNode *prev = atomic_exchange_explicit(&_submittedHead, node, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+/// Consumer side of the submitted queue. Returns NULL when empty, or when the next producer has
+/// swapped in its node but not linked it yet (it is then taken by the next call).
+-(TSSubmittedNode *)popSubmittedNode
+{
+    TSSubmittedNode *tail = _submittedTail;
+    TSSubmittedNode *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (tail == &_submittedStub) {
+        if (!next) return NULL;
+        _submittedTail = next;
+        tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+    if (next) {
+        _submittedTail = next;
+        return tail;
+    }
+    if (tail != atomic_load_explicit(&_submittedHead, memory_order_acquire)) {
+        return NULL;
+    }
+    // `tail` is the last node: put the stub behind it so it can be unlinked
+    atomic_store_explicit(&_submittedStub.next, NULL, memory_order_relaxed);
+    TSSubmittedNode *prev = atomic_exchange_explicit(&_submittedHead, &_submittedStub, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, &_submittedStub, memory_order_release);
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next) {
+        _submittedTail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+/// Moves the submitted access units, in submission order, into the DTS-ordered queue.
+-(void)drainSubmittedAccessUnits
+{
+    TSSubmittedNode *node;
+    while ((node = [self popSubmittedNode])) {
+        TSAccessUnit *accessUnit = CFBridgingRelease(node->accessUnit);
+        free(node);
+        atomic_fetch_sub_explicit(&_submittedCount, 1, memory_order_relaxed);
+        [self enqueueAccessUnit:accessUnit];
+    }
+}
+
+-(NSUInteger)submittedAccessUnitCount
+{
+    return atomic_load_explicit(&_submittedCount, memory_order_relaxed);
+}
+
+-(NSUInteger)queuedAccessUnitCount
+{
+    return atomic_load_explicit(&_queuedCount, memory_order_relaxed);
+}
+
+-(uint64_t)droppedAccessUnitCount
+{
+    return atomic_load_explicit(&_droppedCount, memory_order_relaxed);
+}
+
+#pragma mark - Audio Packing
+
+/// Whether the access unit can join the pack: it continues the pack's timestamps within the
+/// policy's duration, fits the payload limit, and does not start a discontinuity.
+static BOOL canAppendToAudioPack(TSAudioPack *pack, TSAccessUnit *accessUnit, TSAudioPackingPolicy *policy)
+{
+    TSAccessUnit *first = pack.accessUnits.firstObject;
+    TSAccessUnit *last = pack.accessUnits.lastObject;
+    if (accessUnit.isDiscontinuous || accessUnit.streamType != first.streamType) {
+        return NO;
+    }
+    if (CMTIME_IS_INVALID(first.pts) || CMTIME_IS_INVALID(accessUnit.pts)
+        || CMTimeCompare(accessUnit.pts, last.pts) <= 0) {
+        return NO;
+    }
+    const CMTime span = CMTimeSubtract(accessUnit.pts, first.pts);
+    if (CMTimeCompare(span, CMTimeMake((int64_t)policy.maxDurationMs, 1000)) >= 0) {
+        return NO;
+    }
+    return pack.payloadSize + accessUnit.compressedData.length <= packedPayloadLimit(policy);
+}
+
+-(void)packAudioAccessUnit:(TSAccessUnit *)accessUnit policy:(TSAudioPackingPolicy *)policy
+{
+    NSNumber *pidKey = @(accessUnit.pid);
+    TSAudioPack *pack = self.audioPacks[pidKey];
+    if (pack && !canAppendToAudioPack(pack, accessUnit, policy)) {
+        [self flushAudioPackForPid:pidKey];
+        pack = nil;
+    }
+    if (!pack) {
+        pack = [[TSAudioPack alloc] init];
+        pack.startNanos = self.wallClockNanos();
+        self.audioPacks[pidKey] = pack;
+    }
+    [pack.accessUnits addObject:accessUnit];
+    pack.payloadSize += accessUnit.compressedData.length;
+
+    if (pack.payloadSize >= packedPayloadLimit(policy)) {
+        [self flushAudioPackForPid:pidKey];
+    }
+}
+
+/// Queues the pack as one access unit with the timestamps and flags of its first frame.
+-(void)flushAudioPackForPid:(NSNumber *)pidKey
+{
+    TSAudioPack *pack = self.audioPacks[pidKey];
+    if (!pack) return;
+    [self.audioPacks removeObjectForKey:pidKey];
+
+    TSAccessUnit *first = pack.accessUnits.firstObject;
+    if (pack.accessUnits.count == 1) {
+        [self queueAccessUnit:first];
+        return;
+    }
+    NSMutableData *payload = [NSMutableData dataWithCapacity:pack.payloadSize];
+    for (TSAccessUnit *au in pack.accessUnits) {
+        [payload appendData:au.compressedData];
+    }
+    [self queueAccessUnit:[[TSAccessUnit alloc] initWithPid:first.pid
+                                                        pts:first.pts
+                                                        dts:first.dts
+                                            isDiscontinuous:first.isDiscontinuous
+                                         isRandomAccessPoint:first.isRandomAccessPoint
+                                                 streamType:first.streamType
+                                                 descriptors:first.descriptors
+                                             compressedData:payload]];
+}
+
+-(void)flushExpiredAudioPacks:(uint64_t)nowNanos
+{
+    for (NSNumber *pidKey in self.audioPacks.allKeys) {
+        const uint64_t maxDurationNanos = _settings.audioPackingPolicies[pidKey].maxDurationMs * 1000000ULL;
+        if (nowNanos - self.audioPacks[pidKey].startNanos >= maxDurationNanos) {
+            [self flushAudioPackForPid:pidKey];
+        }
+    }
+}
+
 #pragma mark - Stats
 
 -(void)maybeLogStats
@@ -371,15 +732,51 @@ static inline BOOL isIntervalElapsed(uint64_t lastTimeNanos, uint64_t intervalNa
     }
 
     NSMutableArray<TSPacketizedPacket*> *packets = [NSMutableArray array];
+    OnTsPacketDataCallback addPacket = ^(NSData *tsPacketData, uint16_t pid, uint8_t cc) {
+        [packets addObject:[TSPacketizedPacket packetWithData:tsPacketData pid:pid cc:cc]];
+    };
+
+    // Splice points of the scheduled cues (video only)
+    int16_t firstPacketSpliceCountdown = kNoSpliceCountdown;
+    int16_t lastPacketSpliceCountdown = kNoSpliceCountdown;
+    TSSpliceCue *cue = self.spliceCues.firstObject;
+    if (cue && accessUnit.pid == _settings.videoPid) {
+        if ([self isSplicePoint:accessUnit forCue:cue]) {
+            firstPacketSpliceCountdown = -1;
+            // Retire the cues spliced here, sending those that were scheduled too late to be sent yet
+            while ((cue = self.spliceCues.firstObject) && [self isSplicePoint:accessUnit forCue:cue]) {
+                if (cue.sendTimeNanos == kNeverSent) {
+                    [self packetizeSpliceCue:cue nowNanos:nowNanos onTsPacketData:addPacket];
+                }
+                [self.spliceCues removeObjectAtIndex:0];
+            }
+        } else {
+            if (!cue.isSplicePointDeferred && CMTIME_IS_VALID(accessUnit.pts)
+                && CMTimeCompare(accessUnit.pts, cue.spliceTime) >= 0) {
+                cue.isSplicePointDeferred = YES;
+                TSLogWarn(@"No random access point at splice time %.3f s: splicing at the next one",
+                          CMTimeGetSeconds(cue.spliceTime));
+            }
+            TSAccessUnit *next = [self nextQueuedAccessUnitWithPid:accessUnit.pid];
+            if (next && [self isSplicePoint:next forCue:cue]) {
+                lastPacketSpliceCountdown = 0;
+            }
+        }
+    }
+
+    const NSUInteger firstPacketIndex = packets.count;
     [TSPacket packetizePayload:pesPacket
                          track:track
                        pcrBase:pcrBase
                         pcrExt:pcrExt
              discontinuityFlag:discontinuity
               randomAccessFlag:accessUnit.isRandomAccessPoint
-                onTsPacketData:^(NSData *tsPacketData, uint16_t pid, uint8_t cc) {
-        [packets addObject:[TSPacketizedPacket packetWithData:tsPacketData pid:pid cc:cc]];
-    }];
+    firstPacketSpliceCountdown:firstPacketSpliceCountdown
+     lastPacketSpliceCountdown:lastPacketSpliceCountdown
+                onTsPacketData:addPacket];
+    if (packets.count > firstPacketIndex) {
+        packets[firstPacketIndex].accessUnit = accessUnit;
+    }
     return packets;
 }
 
@@ -396,7 +793,147 @@ static inline BOOL isIntervalElapsed(uint64_t lastTimeNanos, uint64_t intervalNa
     if (packet.pid == _pcr.pid) {
         _pcr.lastEmittedCc = packet.cc;
     }
-    [self.delegate muxer:self didMuxTSPacketData:packet.data];
+    id<TSMuxerDelegate> delegate = self.delegate;
+    if (packet.accessUnit && [delegate respondsToSelector:@selector(muxer:willMuxAccessUnit:)]) {
+        [delegate muxer:self willMuxAccessUnit:packet.accessUnit];
+    }
+    [delegate muxer:self didMuxTSPacketData:packet.data];
+}
+
+#pragma mark - SCTE-35
+
+-(void)scheduleSpliceInsertWithEventId:(uint32_t)spliceEventId
+                        isOutOfNetwork:(BOOL)isOutOfNetwork
+                            spliceTime:(CMTime)spliceTime
+                         breakDuration:(CMTime)breakDuration
+{
+    TSSpliceCue *cue = [self spliceCueWithCommandType:TSScte35SpliceCommandTypeSpliceInsert spliceTime:spliceTime];
+    cue.spliceEventId = spliceEventId;
+    cue.isOutOfNetwork = isOutOfNetwork;
+    cue.breakDuration = breakDuration;
+    [self addSpliceCue:cue];
+}
+
+-(void)scheduleTimeSignalAtTime:(CMTime)spliceTime
+              spliceDescriptors:(NSData *)spliceDescriptors
+{
+    TSSpliceCue *cue = [self spliceCueWithCommandType:TSScte35SpliceCommandTypeTimeSignal spliceTime:spliceTime];
+    cue.spliceDescriptors = [spliceDescriptors copy];
+    if (![self spliceInfoSectionForCue:cue]) {
+        [NSException raise:@"TSMuxerInvalidSettingsException" format:@"Splice descriptors do not fit in a splice_info_section"];
+    }
+    [self addSpliceCue:cue];
+}
+
+-(NSUInteger)scheduledSpliceCueCount
+{
+    return self.spliceCues.count;
+}
+
+-(TSSpliceCue *)spliceCueWithCommandType:(uint8_t)spliceCommandType spliceTime:(CMTime)spliceTime
+{
+    if (!self.cueTrack) {
+        [NSException raise:@"TSMuxerInvalidSettingsException" format:@"SCTE-35 cues require an SCTE-35 PID"];
+    }
+    if (CMTIME_IS_INVALID(spliceTime)) {
+        [NSException raise:@"TSMuxerInvalidSettingsException" format:@"Splice time must be valid"];
+    }
+    TSSpliceCue *cue = [[TSSpliceCue alloc] init];
+    cue.spliceCommandType = spliceCommandType;
+    cue.spliceTime = spliceTime;
+    cue.breakDuration = kCMTimeInvalid;
+    cue.sendTimeNanos = kNeverSent;
+    return cue;
+}
+
+-(void)addSpliceCue:(TSSpliceCue *)cue
+{
+    NSUInteger insertIndex = self.spliceCues.count;
+    while (insertIndex > 0 && CMTimeCompare(self.spliceCues[insertIndex - 1].spliceTime, cue.spliceTime) > 0) {
+        insertIndex--;
+    }
+    [self.spliceCues insertObject:cue atIndex:insertIndex];
+}
+
+/// The cue's section, with its times relative to the PTS epoch like the access units.
+-(TSScte35SpliceInfoSection *)spliceInfoSectionForCue:(TSSpliceCue *)cue
+{
+    const CMTime epoch = CMTIME_IS_VALID(_ptsAnchor) ? _ptsAnchor : kCMTimeZero;
+    const uint64_t ptsTime = [TSTimeUtil convertTimeToUIntTime:CMTimeSubtract(cue.spliceTime, epoch)
+                                              withNewTimescale:TS_TIMESTAMP_TIMESCALE];
+    NSData *command;
+    if (cue.spliceCommandType == TSScte35SpliceCommandTypeSpliceInsert) {
+        const uint64_t breakDuration = CMTIME_IS_VALID(cue.breakDuration)
+            ? [TSTimeUtil convertTimeToUIntTime:cue.breakDuration withNewTimescale:TS_TIMESTAMP_TIMESCALE] : 0;
+        command = [TSScte35SpliceInfoSection makeSpliceInsertWithEventId:cue.spliceEventId
+                                                          isOutOfNetwork:cue.isOutOfNetwork
+                                                                 ptsTime:ptsTime
+                                                           breakDuration:breakDuration
+                                                            isAutoReturn:breakDuration > 0
+                                                         uniqueProgramId:PROGRAM_NUMBER];
+    } else {
+        command = [TSScte35SpliceInfoSection makeTimeSignalWithPtsTime:ptsTime];
+    }
+    return [[TSScte35SpliceInfoSection alloc] initWithSpliceCommandType:cue.spliceCommandType
+                                                          spliceCommand:command
+                                                      spliceDescriptors:cue.spliceDescriptors];
+}
+
+-(void)packetizeSpliceCue:(TSSpliceCue *)cue nowNanos:(uint64_t)nowNanos onTsPacketData:(OnTsPacketDataCallback)onTsPacketCb
+{
+    [TSPacket packetizePayload:[[self spliceInfoSectionForCue:cue] toTsPacketPayload]
+                         track:self.cueTrack
+                       pcrBase:kNoPcr
+                        pcrExt:0
+             discontinuityFlag:NO
+              randomAccessFlag:NO
+                onTsPacketData:onTsPacketCb];
+    cue.sendTimeNanos = nowNanos;
+}
+
+-(BOOL)isTimeToSendSpliceCue:(TSSpliceCue *)cue nowNanos:(uint64_t)nowNanos
+{
+    if (cue.sendTimeNanos == kNeverSent) {
+        return YES;
+    }
+    return _settings.scte35RepeatIntervalMs > 0
+        && isIntervalElapsed(cue.sendTimeNanos, _settings.scte35RepeatIntervalMs * 1000000ULL, nowNanos);
+}
+
+/// Sends the cues that are due. Not before the first access unit, which sets the epoch of their
+/// splice times. Returns whether any was sent.
+-(BOOL)packetizeDueSpliceCues:(uint64_t)nowNanos onTsPacketData:(OnTsPacketDataCallback)onTsPacketCb
+{
+    if (CMTIME_IS_INVALID(_ptsAnchor)) {
+        return NO;
+    }
+    BOOL didSend = NO;
+    for (TSSpliceCue *cue in self.spliceCues) {
+        if ([self isTimeToSendSpliceCue:cue nowNanos:nowNanos]) {
+            [self packetizeSpliceCue:cue nowNanos:nowNanos onTsPacketData:onTsPacketCb];
+            didSend = YES;
+        }
+    }
+    return didSend;
+}
+
+/// Whether the access unit is the splice point of `cue`: the first video random access point at or
+/// after the splice time.
+-(BOOL)isSplicePoint:(TSAccessUnit *)accessUnit forCue:(TSSpliceCue *)cue
+{
+    return accessUnit.pid == _settings.videoPid
+        && accessUnit.isRandomAccessPoint
+        && CMTIME_IS_VALID(accessUnit.pts)
+        && CMTimeCompare(accessUnit.pts, cue.spliceTime) >= 0;
+}
+
+/// The next queued access unit on the PID, or nil.
+-(TSAccessUnit *)nextQueuedAccessUnitWithPid:(uint16_t)pid
+{
+    for (TSAccessUnit *accessUnit in self.accessUnits) {
+        if (accessUnit.pid == pid) return accessUnit;
+    }
+    return nil;
 }
 
 #pragma mark - VBR
@@ -414,6 +951,10 @@ static inline BOOL isIntervalElapsed(uint64_t lastTimeNanos, uint64_t intervalNa
             self.psiSendTimeNanos = nowNanos;
         }
 
+        [self packetizeDueSpliceCues:nowNanos onTsPacketData:^(NSData *tsPacketData, uint16_t pid, uint8_t cc) {
+            [self emitPacket:[TSPacketizedPacket packetWithData:tsPacketData pid:pid cc:cc]];
+        }];
+
         if (self.accessUnits.count) {
             TSAccessUnit *au = self.accessUnits[0];
             [self.accessUnits removeObjectAtIndex:0];
@@ -472,6 +1013,7 @@ static inline BOOL isIntervalElapsed(uint64_t lastTimeNanos, uint64_t intervalNa
     // Paced output loop.
     // Each iteration emits one packet, except:
     // - PSI: emits 2 packets (PAT + PMT)
+    // - SCTE-35: emits the packets of the due cues (typically 1 each)
     // - packetizeAccessUnit: emits zero packets (enqueues into pendingTsPackets for subsequent iterations).
     while (self.numTsPacketsEmitted < expectedNumTsPacketsEmitted) {
         const uint64_t nowNanos = [self cbrNanosElapsed];
@@ -493,6 +1035,12 @@ static inline BOOL isIntervalElapsed(uint64_t lastTimeNanos, uint64_t intervalNa
             continue;
         }
 
+        if ([self packetizeDueSpliceCues:nowNanos onTsPacketData:^(NSData *tsPacketData, uint16_t pid, uint8_t cc) {
+            [self emitPacket:[TSPacketizedPacket packetWithData:tsPacketData pid:pid cc:cc]];
+        }]) {
+            continue;
+        }
+
         if (self.pendingTsPackets.count > 0) {
             TSPacketizedPacket *packet = self.pendingTsPackets[0];
             [self.pendingTsPackets removeObjectAtIndex:0];
@@ -510,6 +1058,136 @@ static inline BOOL isIntervalElapsed(uint64_t lastTimeNanos, uint64_t intervalNa
     }
 }
 
+#pragma mark - Pacing
+// startPacingWithPacketsPerBatch: → pacing thread: sleep + spin until the next batch is due → tick.
+
+static void *TSMuxerPacingThreadMain(void *context)
+{
+    TSMuxer *muxer = CFBridgingRelease(context);
+    [muxer runPacingLoop];
+    return NULL;
+}
+
+-(void)startPacingWithPacketsPerBatch:(NSUInteger)packetsPerBatch
+{
+    if (_settings.targetBitrateKbps == 0) {
+        [NSException raise:@"TSMuxerInvalidSettingsException" format:@"Pacing requires CBR mode (targetBitrateKbps > 0)"];
+    }
+    if (packetsPerBatch == 0) {
+        [NSException raise:@"TSMuxerInvalidSettingsException" format:@"Packets per batch must be > 0"];
+    }
+    if (self.isPacing) return;
+
+    _packetsPerBatch = packetsPerBatch;
+    os_unfair_lock_lock(&_pacingStatsLock);
+    _pacingStats = (TSPacingStats){ 0 };
+    os_unfair_lock_unlock(&_pacingStatsLock);
+    atomic_store_explicit(&_pacing, YES, memory_order_release);
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_set_qos_class_np(&attributes, QOS_CLASS_USER_INTERACTIVE, 0);
+    pthread_create(&_pacingThread, &attributes, TSMuxerPacingThreadMain, (void *)CFBridgingRetain(self));
+    pthread_attr_destroy(&attributes);
+}
+
+-(void)stopPacing
+{
+    if (!atomic_exchange_explicit(&_pacing, NO, memory_order_acq_rel)) return;
+    pthread_join(_pacingThread, NULL);
+}
+
+-(BOOL)isPacing
+{
+    return atomic_load_explicit(&_pacing, memory_order_acquire);
+}
+
+/// Wall clock time at which `count` packets are due since the CBR start (inverse of expectedPacketCount:).
+-(uint64_t)dueTimeForPacketCount:(uint64_t)count
+{
+    const double targetPacketsPerSecond = (double)_settings.targetBitrateKbps * 1e3 / 8.0 / (double)TS_PACKET_SIZE_188;
+    return self.startTimeWallClockNanos + (uint64_t)ceil((double)count / targetPacketsPerSecond * 1e9);
+}
+
+-(void)runPacingLoop
+{
+    pthread_setname_np("TSMuxer pacing");
+    const double batchNanos = (double)_packetsPerBatch * TS_PACKET_SIZE_188 * 8.0 * 1e6 / (double)_settings.targetBitrateKbps;
+    void (^sleepNanos)(uint64_t) = self.pacingSleepNanos;
+    double averageOversleepNanos = 0;
+    uint64_t spinNanos = PACING_MIN_SPIN_NANOS;
+    uint64_t previousWakeNanos = 0;
+
+    while (atomic_load_explicit(&_pacing, memory_order_acquire)) {
+        @autoreleasepool {
+            const uint64_t emittedBefore = self.numTsPacketsEmitted;
+            uint64_t nowNanos = self.wallClockNanos();
+            const uint64_t dueNanos = self.startTimeWallClockNanos == 0
+                ? nowNanos
+                : [self dueTimeForPacketCount:emittedBefore + _packetsPerBatch];
+
+            // Sleep until shortly before the due time, then spin the rest. The spin covers twice
+            // the average oversleep, so a late wake-up rarely makes the batch late.
+            if (dueNanos > nowNanos + spinNanos) {
+                const uint64_t requestedNanos = dueNanos - nowNanos - spinNanos;
+                if (sleepNanos) {
+                    sleepNanos(requestedNanos);
+                } else {
+                    const struct timespec duration = { .tv_sec = (time_t)(requestedNanos / 1000000000ULL),
+                                                       .tv_nsec = (long)(requestedNanos % 1000000000ULL) };
+                    nanosleep(&duration, NULL);
+                }
+                const uint64_t wakeNanos = self.wallClockNanos();
+                const double oversleepNanos = (double)(int64_t)(wakeNanos - nowNanos - requestedNanos);
+                averageOversleepNanos += (oversleepNanos - averageOversleepNanos) / 8.0;
+                spinNanos = (uint64_t)MIN(MAX(2.0 * averageOversleepNanos, PACING_MIN_SPIN_NANOS), PACING_MAX_SPIN_NANOS);
+            }
+            while ((nowNanos = self.wallClockNanos()) < dueNanos) {
+                // Spin
+            }
+
+            [self tick];
+
+            const uint64_t numPackets = self.numTsPacketsEmitted - emittedBefore;
+            os_unfair_lock_lock(&_pacingStatsLock);
+            TSPacingStats *stats = &_pacingStats;
+            if (numPackets > 0) {
+                stats->numBatches++;
+                stats->numPackets += numPackets;
+                stats->maxPacketsPerBatch = MAX(stats->maxPacketsPerBatch, (NSUInteger)numPackets);
+                const uint64_t latenessNanos = nowNanos - dueNanos;
+                stats->sumLateness += latenessNanos;
+                stats->maxLatenessNanos = MAX(stats->maxLatenessNanos, latenessNanos);
+                if (previousWakeNanos != 0) {
+                    const double jitterNanos = (double)(nowNanos - previousWakeNanos) - batchNanos;
+                    stats->numIntervals++;
+                    stats->sumSquaredJitter += jitterNanos * jitterNanos;
+                    stats->maxJitterNanos = MAX(stats->maxJitterNanos, (uint64_t)fabs(jitterNanos));
+                }
+                previousWakeNanos = nowNanos;
+            }
+            os_unfair_lock_unlock(&_pacingStatsLock);
+        }
+    }
+}
+
+-(TSMuxerPacingStatistics *)pacingStatistics
+{
+    os_unfair_lock_lock(&_pacingStatsLock);
+    const TSPacingStats stats = _pacingStats;
+    os_unfair_lock_unlock(&_pacingStatsLock);
+
+    TSMuxerPacingStatistics *statistics = [[TSMuxerPacingStatistics alloc] init];
+    statistics.numBatches = stats.numBatches;
+    statistics.numPackets = stats.numPackets;
+    statistics.maxPacketsPerBatch = stats.maxPacketsPerBatch;
+    statistics.rmsJitterNanos = stats.numIntervals ? sqrt(stats.sumSquaredJitter / stats.numIntervals) : 0;
+    statistics.maxJitterNanos = stats.maxJitterNanos;
+    statistics.meanLatenessNanos = stats.numBatches ? stats.sumLateness / stats.numBatches : 0;
+    statistics.maxLatenessNanos = stats.maxLatenessNanos;
+    return statistics;
+}
+
 #pragma mark - PCR
 
 /// Whether a standalone PCR should be emitted now.
@@ -0,0 +1,78 @@
+//
+//  TSNalUnitIndex.h
+//  TSMuxDemux
+//
+//  NAL unit indexing of H.264/HEVC access units, built during PES payload accumulation.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(uint8_t, TSNalUnitCodec) {
+    TSNalUnitCodecH264,
+    TSNalUnitCodecH265,
+};
+
+/// One NAL unit within an access unit's compressedData.
+typedef struct {
+    uint32_t offset;    ///< Offset of the NAL unit header (first byte after the start code).
+    uint32_t length;    ///< NAL unit length in bytes, including header, excluding start code and trailing zeros.
+    uint8_t type;       ///< nal_unit_type (5 bits for H.264, 6 bits for HEVC).
+} TSNalUnitEntry;
+
+/// Extracts nal_unit_type from the first NAL unit header byte.
+FOUNDATION_EXPORT uint8_t TSNalUnitTypeFromHeader(TSNalUnitCodec codec, uint8_t header);
+
+/// YES for VCL (coded slice) NAL unit types.
+FOUNDATION_EXPORT BOOL TSNalUnitTypeIsVcl(TSNalUnitCodec codec, uint8_t type);
+
+/// YES for IDR (H.264) or IRAP (HEVC) NAL unit types.
+FOUNDATION_EXPORT BOOL TSNalUnitTypeIsKeyframe(TSNalUnitCodec codec, uint8_t type);
+
+#pragma mark - TSNalUnitIndex
+
+/// Immutable table of the NAL units found in one access unit.
+@interface TSNalUnitIndex : NSObject
+
+@property(nonatomic, readonly) TSNalUnitCodec codec;
+@property(nonatomic, readonly) NSUInteger count;
+
+/// H.264: contains an IDR slice (type 5). HEVC: contains an IRAP picture (types 16-23).
+@property(nonatomic, readonly) BOOL isKeyframe;
+/// HEVC only. Always NO for H.264.
+@property(nonatomic, readonly) BOOL hasVps;
+@property(nonatomic, readonly) BOOL hasSps;
+@property(nonatomic, readonly) BOOL hasPps;
+
+/// Pointer to `count` entries, valid for the lifetime of the index.
+-(const TSNalUnitEntry *)entries NS_RETURNS_INNER_POINTER;
+
+-(TSNalUnitEntry)entryAtIndex:(NSUInteger)index;
+
+@end
+
+#pragma mark - TSNalUnitIndexer
+
+/// Incrementally indexes Annex B NAL units in a growing buffer.
+///
+/// Call `-scanData:` after each append; only bytes not seen before are scanned (plus a
+/// 3-byte overlap for start codes straddling appends), so the data is traversed once.
+@interface TSNalUnitIndexer : NSObject
+
+@property(nonatomic, readonly) TSNalUnitCodec codec;
+
+-(instancetype)initWithCodec:(TSNalUnitCodec)codec;
+
+/// Scans the bytes of `data` appended since the previous call.
+-(void)scanData:(NSData *)data;
+
+/// Completes the index for `data` (the full access unit) and resets the indexer.
+-(TSNalUnitIndex *)finishWithData:(NSData *)data;
+
+/// Discards all collected state.
+-(void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
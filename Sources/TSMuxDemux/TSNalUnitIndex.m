@@ -0,0 +1,219 @@
+//
+//  TSNalUnitIndex.m
+//  TSMuxDemux
+//
+//  NAL unit indexing of H.264/HEVC access units, built during PES payload accumulation.
+//
+
+#import "TSNalUnitIndex.h"
+#import "TSStartCodeScanner.h"
+
+// H.264 nal_unit_type values. See "Rec. ITU-T H.264" Table 7-1.
+static const uint8_t H264_NAL_SLICE = 1;
+static const uint8_t H264_NAL_IDR = 5;
+static const uint8_t H264_NAL_SPS = 7;
+static const uint8_t H264_NAL_PPS = 8;
+
+// HEVC nal_unit_type values. See "Rec. ITU-T H.265" Table 7-1.
+static const uint8_t HEVC_NAL_BLA_W_LP = 16;
+static const uint8_t HEVC_NAL_RSV_IRAP_VCL23 = 23;
+static const uint8_t HEVC_NAL_RSV_VCL31 = 31;
+static const uint8_t HEVC_NAL_VPS = 32;
+static const uint8_t HEVC_NAL_SPS = 33;
+static const uint8_t HEVC_NAL_PPS = 34;
+
+uint8_t TSNalUnitTypeFromHeader(TSNalUnitCodec codec, uint8_t header)
+{
+    return codec == TSNalUnitCodecH265 ? (header >> 1) & 0x3F : header & 0x1F;
+}
+
+BOOL TSNalUnitTypeIsVcl(TSNalUnitCodec codec, uint8_t type)
+{
+    if (codec == TSNalUnitCodecH265) {
+        return type <= HEVC_NAL_RSV_VCL31;
+    }
+    return type >= H264_NAL_SLICE && type <= H264_NAL_IDR;
+}
+
+BOOL TSNalUnitTypeIsKeyframe(TSNalUnitCodec codec, uint8_t type)
+{
+    if (codec == TSNalUnitCodecH265) {
+        return type >= HEVC_NAL_BLA_W_LP && type <= HEVC_NAL_RSV_IRAP_VCL23;
+    }
+    return type == H264_NAL_IDR;
+}
+
+#pragma mark - TSNalUnitIndex
+
+@interface TSNalUnitIndex()
+-(instancetype)initWithCodec:(TSNalUnitCodec)codec
+                     entries:(NSData *)entries
+                  isKeyframe:(BOOL)isKeyframe
+                      hasVps:(BOOL)hasVps
+                      hasSps:(BOOL)hasSps
+                      hasPps:(BOOL)hasPps;
+@end
+
+@implementation TSNalUnitIndex
+{
+    NSData *_entries;
+}
+
+-(instancetype)initWithCodec:(TSNalUnitCodec)codec
+                     entries:(NSData *)entries
+                  isKeyframe:(BOOL)isKeyframe
+                      hasVps:(BOOL)hasVps
+                      hasSps:(BOOL)hasSps
+                      hasPps:(BOOL)hasPps
+{
+    self = [super init];
+    if (self) {
+        _codec = codec;
+        _entries = entries;
+        _count = entries.length / sizeof(TSNalUnitEntry);
+        _isKeyframe = isKeyframe;
+        _hasVps = hasVps;
+        _hasSps = hasSps;
+        _hasPps = hasPps;
+    }
+    return self;
+}
+
+-(const TSNalUnitEntry *)entries
+{
+    return (const TSNalUnitEntry *)_entries.bytes;
+}
+
+-(TSNalUnitEntry)entryAtIndex:(NSUInteger)index
+{
+    if (index >= _count) {
+        [NSException raise:NSRangeException format:@"NAL unit index %lu out of bounds (count %lu)",
+         (unsigned long)index, (unsigned long)_count];
+    }
+    return self.entries[index];
+}
+
+-(NSString*)description
+{
+    NSMutableString *types = [NSMutableString string];
+    for (NSUInteger i = 0; i < _count; i++) {
+        [types appendFormat:@"%s%u", i > 0 ? "," : "", self.entries[i].type];
+    }
+    return [NSString stringWithFormat:@"{ codec: %@, keyframe: %@, nalTypes: [%@] }",
+            _codec == TSNalUnitCodecH265 ? @"HEVC" : @"H.264",
+            _isKeyframe ? @"YES" : @"NO",
+            types];
+}
+
+@end
+
+#pragma mark - TSNalUnitIndexer
+
+@implementation TSNalUnitIndexer
+{
+    NSMutableData *_entries;
+    /// Next byte offset to resume start code scanning from.
+    NSUInteger _scanOffset;
+    BOOL _isKeyframe;
+    BOOL _hasVps;
+    BOOL _hasSps;
+    BOOL _hasPps;
+}
+
+-(instancetype)initWithCodec:(TSNalUnitCodec)codec
+{
+    self = [super init];
+    if (self) {
+        _codec = codec;
+        [self reset];
+    }
+    return self;
+}
+
+-(void)reset
+{
+    _entries = [NSMutableData data];
+    _scanOffset = 0;
+    _isKeyframe = NO;
+    _hasVps = NO;
+    _hasSps = NO;
+    _hasPps = NO;
+}
+
+/// Length from `offset` to `end`, excluding trailing zero bytes (trailing_zero_8bits / the
+/// leading zero of a following 4-byte start code).
+static inline uint32_t nalLength(const uint8_t *bytes, NSUInteger offset, NSUInteger end)
+{
+    while (end > offset + 1 && bytes[end - 1] == 0x00) {
+        end--;
+    }
+    return (uint32_t)(end - offset);
+}
+
+-(void)addNalUnitAtOffset:(NSUInteger)offset header:(uint8_t)header
+{
+    const uint8_t type = TSNalUnitTypeFromHeader(_codec, header);
+    _isKeyframe |= TSNalUnitTypeIsKeyframe(_codec, type);
+    if (_codec == TSNalUnitCodecH265) {
+        _hasVps |= (type == HEVC_NAL_VPS);
+        _hasSps |= (type == HEVC_NAL_SPS);
+        _hasPps |= (type == HEVC_NAL_PPS);
+    } else {
+        _hasSps |= (type == H264_NAL_SPS);
+        _hasPps |= (type == H264_NAL_PPS);
+    }
+
+    TSNalUnitEntry entry = { .offset = (uint32_t)offset, .length = 0, .type = type };
+    [_entries appendBytes:&entry length:sizeof(entry)];
+}
+
+-(void)scanData:(NSData *)data
+{
+    const uint8_t *bytes = data.bytes;
+    const NSUInteger length = data.length;
+
+    while (_scanOffset < length) {
+        const NSUInteger startCode = TSFindStartCodeFromOffset(bytes, length, _scanOffset);
+        if (startCode == NSNotFound) {
+            // The last 2 bytes may be the beginning of a start code completed by the next append.
+            _scanOffset = MAX(_scanOffset, length >= 2 ? length - 2 : 0);
+            return;
+        }
+        const NSUInteger headerOffset = startCode + 3;
+        if (headerOffset >= length) {
+            // NAL header byte not received yet - resume from this start code next time.
+            _scanOffset = startCode;
+            return;
+        }
+
+        const NSUInteger count = _entries.length / sizeof(TSNalUnitEntry);
+        if (count > 0) {
+            TSNalUnitEntry *prev = (TSNalUnitEntry *)_entries.mutableBytes + (count - 1);
+            prev->length = nalLength(bytes, prev->offset, startCode);
+        }
+        [self addNalUnitAtOffset:headerOffset header:bytes[headerOffset]];
+        _scanOffset = headerOffset;
+    }
+}
+
+-(TSNalUnitIndex *)finishWithData:(NSData *)data
+{
+    [self scanData:data];
+
+    const NSUInteger count = _entries.length / sizeof(TSNalUnitEntry);
+    if (count > 0) {
+        TSNalUnitEntry *last = (TSNalUnitEntry *)_entries.mutableBytes + (count - 1);
+        last->length = nalLength(data.bytes, last->offset, data.length);
+    }
+
+    TSNalUnitIndex *index = [[TSNalUnitIndex alloc] initWithCodec:_codec
+                                                          entries:_entries
+                                                       isKeyframe:_isKeyframe
+                                                           hasVps:_hasVps
+                                                           hasSps:_hasSps
+                                                           hasPps:_hasPps];
+    [self reset];
+    return index;
+}
+
+@end
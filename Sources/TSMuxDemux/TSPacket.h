@@ -14,6 +14,35 @@
 
 #pragma mark - TSPacketHeader
 
+/// The 13-bit PID of the raw packet at `bytes`, read without decoding the rest of the header.
+static inline uint16_t TSPacketHeaderPid(const uint8_t * _Nonnull bytes)
+{
+    return (uint16_t)(((bytes[1] & 0x1F) << 8) | bytes[2]);
+}
+
+/// Offset of the 188-byte packet (its sync byte) in packets of `packetSize` bytes: after the
+/// 4-byte TP_extra_header of 192-byte M2TS packets, else 0.
+static inline NSUInteger TSPacketSyncOffset(NSUInteger packetSize)
+{
+    return packetSize == 192 ? 4 : 0;
+}
+
+/// The 30-bit arrival time stamp (27 MHz) of the 192-byte M2TS packet at `bytes`.
+static inline uint32_t TSPacketArrivalTimestamp(const uint8_t * _Nonnull bytes)
+{
+    return ((uint32_t)(bytes[0] & 0x3F) << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+/// Detects the packet size (188, 192 or 204) of packet-aligned data from the periodicity of its
+/// sync bytes: the size whose sync positions hold 0x47 for the most packets wins, if at least 3/4
+/// of them do. Looks at up to 64 packets. Returns 0 if undecided (e.g. fewer than two packets).
+FOUNDATION_EXPORT NSUInteger TSPacketDetectSize(const uint8_t * _Nonnull bytes, NSUInteger length);
+
+/// TSPacketDetectSize, falling back to the length alone when there are too few packets to tell
+/// (e.g. a single packet): 204 or 192 only when unambiguous, i.e. not divisible by 188, else 188.
+/// Assumes input is packet-aligned (starts at packet boundary).
+FOUNDATION_EXPORT NSUInteger TSPacketDetectSizeOfChunk(const uint8_t * _Nonnull bytes, NSUInteger length);
+
 typedef NS_ENUM(uint8_t, TSAdaptationMode) {
     TSAdaptationModeReserved = 0x00,
     TSAdaptationModePayloadOnly = 0x01,
@@ -65,7 +94,9 @@ typedef NS_ENUM(uint8_t, TSAdaptationMode) {
 @property(nonatomic, readonly) BOOL transportPrivateDataFlag;
 @property(nonatomic, readonly) BOOL adaptationFieldExtensionFlag;
 @property(nonatomic, readonly) NSUInteger numberOfStuffedBytes;
-
+/// Packets of this PID until the splicing point when `splicingPointFlag` is set: 0 in the last
+/// packet before it, -1 in the first packet after it.
+@property(nonatomic, readonly) int8_t spliceCountdown;
 
 @property(nonatomic, readonly) uint64_t pcrBase;
 @property(nonatomic, readonly) uint16_t pcrExt;
@@ -76,6 +107,13 @@ typedef NS_ENUM(uint8_t, TSAdaptationMode) {
                        randomAccessFlag:(BOOL)randomAccessFlag
                    remainingPayloadSize:(NSUInteger)remainingPayloadSize;
 
+/// As above, with the splicing_point_flag set and `spliceCountdown` coded unless it is kNoSpliceCountdown.
++(instancetype _Nonnull)initWithPcrBase:(uint64_t)pcrBase
+                                 pcrExt:(uint16_t)pcrExt
+                      discontinuityFlag:(BOOL)discontinuityFlag
+                       randomAccessFlag:(BOOL)randomAccessFlag
+                        spliceCountdown:(int16_t)spliceCountdown
+                   remainingPayloadSize:(NSUInteger)remainingPayloadSize;
 
 -(instancetype _Nonnull)initWithAdaptationFieldLength:(uint8_t)adaptationFieldLength
                                     discontinuityFlag:(BOOL)discontinuityFlag
@@ -106,9 +144,13 @@ typedef void (^OnTsPacketDataCallback)(NSData * _Nonnull, uint16_t pid, uint8_t
 @property(nonatomic, nullable, readonly) TSAdaptationField *adaptationField;
 // Does not copy the data.
 @property(nonatomic, nullable, readonly) NSData *payload;
+/// 30-bit arrival time stamp (27 MHz, wrapping after about 40 s) from the TP_extra_header of
+/// 192-byte M2TS/BDAV packets. 0 for other packet sizes.
+@property(nonatomic, readonly) uint32_t arrivalTimestamp;
 
-/// Creates TSPackets from the received raw ts packet data.
+/// Creates TSPackets from the received raw ts packet data (188, 192 or 204-byte packets).
 /// For 204-byte packets, the 16-byte RS parity suffix is stripped from each packet.
+/// For 192-byte packets, the 4-byte prefix is read into `arrivalTimestamp`.
 ///
 /// @warning Memory ownership: The returned TSPacket objects reference memory owned by `chunk`.
 /// Callers must ensure `chunk` remains valid for the lifetime of the returned packets.
@@ -116,6 +158,15 @@ typedef void (^OnTsPacketDataCallback)(NSData * _Nonnull, uint16_t pid, uint8_t
 +(NSArray<TSPacket*>* _Nonnull)packetsFromChunkedTsData:(NSData* _Nonnull)chunk
                                              packetSize:(NSUInteger)packetSize;
 
+/// Creates a TSPacket from the first 188 bytes at `bytes`. Returns nil for packets that cannot be
+/// used (transport error indicator set, invalid adaptation field length).
+///
+/// @warning Memory ownership: as with `packetsFromChunkedTsData:packetSize:`, the packet references `bytes`.
++(TSPacket* _Nullable)packetWithTsPacketBytes:(const uint8_t* _Nonnull)bytes;
+
+/// Same as `packetWithTsPacketBytes:` for the 192-byte M2TS packet at `bytes`.
++(TSPacket* _Nullable)packetWithM2tsPacketBytes:(const uint8_t* _Nonnull)bytes;
+
 /// Packetizes the received payload in N 188-byte long raw ts-data chunks and passes each chunk individually to the callback.
 /// @param discontinuityFlag If YES, the discontinuity_indicator will be set in the adaptation field of the first TS packet.
 /// @param randomAccessFlag If YES, the random_access_indicator will be set in the adaptation field of the first TS packet.
@@ -127,6 +178,20 @@ typedef void (^OnTsPacketDataCallback)(NSData * _Nonnull, uint16_t pid, uint8_t
        randomAccessFlag:(BOOL)randomAccessFlag
          onTsPacketData:(OnTsPacketDataCallback _Nonnull)onTsPacketDataCb;
 
+/// As above, marking a splicing point (splicing_point_flag and splice_countdown, see ISO/IEC 13818-1
+/// 2.4.3.5) unless the countdown is kNoSpliceCountdown.
+/// @param firstPacketSpliceCountdown Coded in the first TS packet, e.g. -1 when the payload starts right after a splicing point.
+/// @param lastPacketSpliceCountdown Coded in the last TS packet, e.g. 0 when the payload ends right before a splicing point.
++(void)packetizePayload:(NSData* _Nonnull)payload
+                  track:(TSElementaryStream* _Nonnull)track
+                pcrBase:(uint64_t)pcrBase
+                 pcrExt:(uint16_t)pcrExt
+      discontinuityFlag:(BOOL)discontinuityFlag
+       randomAccessFlag:(BOOL)randomAccessFlag
+firstPacketSpliceCountdown:(int16_t)firstPacketSpliceCountdown
+ lastPacketSpliceCountdown:(int16_t)lastPacketSpliceCountdown
+         onTsPacketData:(OnTsPacketDataCallback _Nonnull)onTsPacketDataCb;
+
 /// Returns a pre-built 188-byte null packet (PID 0x1FFF, payload-only, all-0xFF payload).
 /// The returned NSData is a singleton — safe to call repeatedly without allocation overhead.
 +(NSData* _Nonnull)nullPacketData;
@@ -12,6 +12,53 @@
 #import "TSLog.h"
 #import "TSBitReader.h"
 
+// Packets looked at to detect the packet size
+#define SIZE_DETECTION_MAX_PACKETS 64
+
+NSUInteger TSPacketDetectSize(const uint8_t *bytes, NSUInteger length)
+{
+    const NSUInteger candidates[] = { TS_PACKET_SIZE_188, TS_PACKET_SIZE_192, TS_PACKET_SIZE_204 };
+    NSUInteger bestSize = 0;
+    NSUInteger bestHits = 0;
+    NSUInteger bestCount = 1;
+    for (NSUInteger c = 0; c < sizeof(candidates) / sizeof(candidates[0]); c++) {
+        const NSUInteger size = candidates[c];
+        const NSUInteger count = MIN(length / size, SIZE_DETECTION_MAX_PACKETS);
+        if (count < 2) {
+            continue;
+        }
+        const NSUInteger syncOffset = TSPacketSyncOffset(size);
+        NSUInteger hits = 0;
+        for (NSUInteger i = 0; i < count; i++) {
+            hits += bytes[i * size + syncOffset] == TS_PACKET_HEADER_SYNC_BYTE;
+        }
+        // Best ratio; on a tie, the smaller size
+        if (hits * 4 >= count * 3 && hits * bestCount > bestHits * count) {
+            bestSize = size;
+            bestHits = hits;
+            bestCount = count;
+        }
+    }
+    return bestSize;
+}
+
+NSUInteger TSPacketDetectSizeOfChunk(const uint8_t *bytes, NSUInteger length)
+{
+    const NSUInteger packetSize = TSPacketDetectSize(bytes, length);
+    if (packetSize != 0) {
+        return packetSize;
+    }
+    if (length % TS_PACKET_SIZE_188 != 0) {
+        if (length % TS_PACKET_SIZE_204 == 0) {
+            return TS_PACKET_SIZE_204;
+        }
+        if (length % TS_PACKET_SIZE_192 == 0) {
+            return TS_PACKET_SIZE_192;
+        }
+    }
+    return TS_PACKET_SIZE_188;
+}
+
 
 #pragma mark - TSPacketHeader
 
@@ -165,9 +212,25 @@
                       discontinuityFlag:(BOOL)discontinuityFlag
                        randomAccessFlag:(BOOL)randomAccessFlag
                    remainingPayloadSize:(NSUInteger)remainingPayloadSize
+{
+    return [self initWithPcrBase:pcrBase
+                          pcrExt:pcrExt
+               discontinuityFlag:discontinuityFlag
+                randomAccessFlag:randomAccessFlag
+                 spliceCountdown:kNoSpliceCountdown
+            remainingPayloadSize:remainingPayloadSize];
+}
+
++(instancetype _Nonnull)initWithPcrBase:(uint64_t)pcrBase
+                                 pcrExt:(uint16_t)pcrExt
+                      discontinuityFlag:(BOOL)discontinuityFlag
+                       randomAccessFlag:(BOOL)randomAccessFlag
+                        spliceCountdown:(int16_t)spliceCountdown
+                   remainingPayloadSize:(NSUInteger)remainingPayloadSize
 {
     const BOOL hasPcr = pcrBase != kNoPcr;
-    const BOOL shouldIncludeHeaderByte2 = hasPcr || discontinuityFlag || randomAccessFlag;
+    const BOOL hasSplicingPoint = spliceCountdown != kNoSpliceCountdown;
+    const BOOL shouldIncludeHeaderByte2 = hasPcr || discontinuityFlag || randomAccessFlag || hasSplicingPoint;
     const BOOL singleByteStuffing = !shouldIncludeHeaderByte2 && remainingPayloadSize == 183;
     
     uint64_t numberOfBytesToStuff;
@@ -176,7 +239,7 @@
         numberOfBytesToStuff = 0;
         adaptationFieldTotalSize = 1;
     } else {
-        const NSUInteger adaptationHeaderSize = 1 + 1 + (hasPcr ? 6 : 0);
+        const NSUInteger adaptationHeaderSize = 1 + 1 + (hasPcr ? 6 : 0) + (hasSplicingPoint ? 1 : 0);
         const NSUInteger remainingPacketSpace = TS_PACKET_SIZE_188 - TS_PACKET_HEADER_SIZE - adaptationHeaderSize;
         const NSUInteger packetPayloadSize = MIN(remainingPacketSpace, remainingPayloadSize);
         numberOfBytesToStuff = remainingPacketSpace - packetPayloadSize;
@@ -184,18 +247,20 @@
     }
     
     const uint8_t adaptationFieldLength = adaptationFieldTotalSize - 1;
-    return [[TSAdaptationField alloc] initWithAdaptationFieldLength:adaptationFieldLength
-                                                  discontinuityFlag:discontinuityFlag
-                                                   randomAccessFlag:randomAccessFlag
-                                                     esPriorityFlag:NO
-                                                            pcrFlag:hasPcr
-                                                           oPcrFlag:NO
-                                                  splicingPointFlag:NO
-                                           transportPrivateDataFlag:NO
-                                       adaptationFieldExtensionFlag:NO
-                                                            pcrBase:pcrBase
-                                                             pcrExt:pcrExt
-                                               numberOfStuffedBytes:numberOfBytesToStuff];
+    TSAdaptationField *adaptationField = [[TSAdaptationField alloc] initWithAdaptationFieldLength:adaptationFieldLength
+                                                                                discontinuityFlag:discontinuityFlag
+                                                                                 randomAccessFlag:randomAccessFlag
+                                                                                   esPriorityFlag:NO
+                                                                                          pcrFlag:hasPcr
+                                                                                         oPcrFlag:NO
+                                                                                splicingPointFlag:hasSplicingPoint
+                                                                         transportPrivateDataFlag:NO
+                                                                     adaptationFieldExtensionFlag:NO
+                                                                                          pcrBase:pcrBase
+                                                                                           pcrExt:pcrExt
+                                                                             numberOfStuffedBytes:numberOfBytesToStuff];
+    adaptationField->_spliceCountdown = hasSplicingPoint ? (int8_t)spliceCountdown : 0;
+    return adaptationField;
 }
 
 +(instancetype)initWithTsPacketData:(NSData*)tsPacketData
@@ -215,6 +280,7 @@
     BOOL adaptationFieldExtensionFlag = NO;
     uint64_t pcrBase = 0;
     uint16_t pcrExt = 0;
+    int8_t spliceCountdown = 0;
     
     if (adaptationFieldLength > 0) {
         // Flags byte (8 single-bit flags)
@@ -239,9 +305,8 @@
             TSBitReaderSkipBits(&reader, 48);
         }
         
-        // Skip splice_countdown (8 bits) if present
         if (splicingPointFlag) {
-            TSBitReaderSkipBits(&reader, 8);
+            spliceCountdown = (int8_t)TSBitReaderReadUInt8(&reader);
         }
         
         // Skip transport_private_data if present (length byte + data)
@@ -281,6 +346,7 @@
                                                                                           pcrBase:pcrBase
                                                                                            pcrExt:pcrExt
                                                                              numberOfStuffedBytes:numberOfStuffedBytes];
+    adaptationField->_spliceCountdown = spliceCountdown;
     
     return adaptationField;
 }
@@ -337,6 +403,12 @@
             [data appendBytes:pcr length:6];
         }
         
+        if (self.splicingPointFlag) {
+            // splice_countdown: an 8-bit two's complement value
+            const uint8_t spliceCountdown = (uint8_t)self.spliceCountdown;
+            [data appendBytes:&spliceCountdown length:1];
+        }
+        
         // Stuffing (N bytes)
         const uint8_t stuffing = 0xFF; // 1111 1111
         for (int j = 0; j < self.numberOfStuffedBytes; j++) {
@@ -382,9 +454,9 @@
 +(NSArray<TSPacket*>*)packetsFromChunkedTsData:(NSData* _Nonnull)chunk
                                     packetSize:(NSUInteger)packetSize
 {
-    if (packetSize != TS_PACKET_SIZE_188 && packetSize != TS_PACKET_SIZE_204) {
-        TSLogError(@"Invalid packet size: %lu (expected %u or %u)",
-                   (unsigned long)packetSize, TS_PACKET_SIZE_188, TS_PACKET_SIZE_204);
+    if (packetSize != TS_PACKET_SIZE_188 && packetSize != TS_PACKET_SIZE_192 && packetSize != TS_PACKET_SIZE_204) {
+        TSLogError(@"Invalid packet size: %lu (expected %u, %u or %u)",
+                   (unsigned long)packetSize, TS_PACKET_SIZE_188, TS_PACKET_SIZE_192, TS_PACKET_SIZE_204);
         return @[];
     }
     if (chunk.length % packetSize != 0) {
@@ -397,56 +469,75 @@
     NSMutableArray *packets = [NSMutableArray arrayWithCapacity:numberOfPackets];
     for (NSUInteger i = 0; i < numberOfPackets; ++i) {
         // Stride by packetSize but only read 188 bytes (RS parity at bytes 188-203 is ignored)
-        NSData *tsPacketData = [NSData dataWithBytesNoCopy:(void*)chunk.bytes + (i * packetSize)
-                                                    length:TS_PACKET_SIZE_188
-                                              freeWhenDone:NO];
-        const TSPacketHeader *header = [TSPacketHeader initWithTsPacketData:tsPacketData];
-        if (!header) {
-            return nil;
-        }
-        
-        // Skip packets with transport error indicator set - payload is unreliable
-        if (header.transportErrorIndicator) {
-            TSLogError(@"Skipping TS packet with transport error indicator set (PID=%u)", header.pid);
-            continue;
-        }
-        
-        TSAdaptationField *adaptationField = nil;
-        NSData *payload = nil;
-        
-        const BOOL hasAdaptationField =
-        header.adaptationMode == TSAdaptationModeAdaptationOnly
-        || header.adaptationMode == TSAdaptationModeAdaptationAndPayload;
-        if (hasAdaptationField) {
-            adaptationField = [TSAdaptationField initWithTsPacketData:tsPacketData];
+        const uint8_t *bytes = (const uint8_t*)chunk.bytes + (i * packetSize);
+        TSPacket *packet = packetSize == TS_PACKET_SIZE_192
+            ? [TSPacket packetWithM2tsPacketBytes:bytes]
+            : [TSPacket packetWithTsPacketBytes:bytes];
+        if (packet) {
+            [packets addObject:packet];
         }
-        
-        const BOOL hasPayload = header.adaptationMode != TSAdaptationModeAdaptationOnly;
-        if (hasPayload) {
-            const NSUInteger payloadOffset =
-            TS_PACKET_HEADER_SIZE
-            + (hasAdaptationField ? 1 : 0) // + 1 for the first byte of the adaptation header itself
-            + (adaptationField.adaptationFieldLength ?: 0);
-            if (payloadOffset >= TS_PACKET_SIZE_188) {
-                TSLogError(@"Invalid TS packet: payloadOffset %lu exceeds packet size (adaptation_field_length=%u)",
-                           (unsigned long)payloadOffset, adaptationField.adaptationFieldLength);
-                continue;
-            }
-            const NSUInteger payloadLength = TS_PACKET_SIZE_188 - payloadOffset;
-            payload = [NSData dataWithBytesNoCopy:(void*)tsPacketData.bytes + payloadOffset
-                                           length:payloadLength
-                                     freeWhenDone:NO];
-        }
-        
-        TSPacket *packet = [[TSPacket alloc] initWithHeader:(TSPacketHeader* _Nonnull)header
-                                            adaptationField:adaptationField
-                                                    payload:payload];
-        [packets addObject:packet];
     }
     
     return packets;
 }
 
++(TSPacket* _Nullable)packetWithM2tsPacketBytes:(const uint8_t* _Nonnull)bytes
+{
+    TSPacket *packet = [self packetWithTsPacketBytes:bytes + TS_M2TS_HEADER_SIZE];
+    if (packet) {
+        packet->_arrivalTimestamp = TSPacketArrivalTimestamp(bytes);
+    }
+    return packet;
+}
+
++(TSPacket* _Nullable)packetWithTsPacketBytes:(const uint8_t* _Nonnull)bytes
+{
+    NSData *tsPacketData = [NSData dataWithBytesNoCopy:(void*)bytes
+                                                length:TS_PACKET_SIZE_188
+                                          freeWhenDone:NO];
+    const TSPacketHeader *header = [TSPacketHeader initWithTsPacketData:tsPacketData];
+    if (!header) {
+        return nil;
+    }
+    
+    // Skip packets with transport error indicator set - payload is unreliable
+    if (header.transportErrorIndicator) {
+        TSLogError(@"Skipping TS packet with transport error indicator set (PID=%u)", header.pid);
+        return nil;
+    }
+    
+    TSAdaptationField *adaptationField = nil;
+    NSData *payload = nil;
+    
+    const BOOL hasAdaptationField =
+    header.adaptationMode == TSAdaptationModeAdaptationOnly
+    || header.adaptationMode == TSAdaptationModeAdaptationAndPayload;
+    if (hasAdaptationField) {
+        adaptationField = [TSAdaptationField initWithTsPacketData:tsPacketData];
+    }
+    
+    const BOOL hasPayload = header.adaptationMode != TSAdaptationModeAdaptationOnly;
+    if (hasPayload) {
+        const NSUInteger payloadOffset =
+        TS_PACKET_HEADER_SIZE
+        + (hasAdaptationField ? 1 : 0) // + 1 for the first byte of the adaptation header itself
+        + (adaptationField.adaptationFieldLength ?: 0);
+        if (payloadOffset >= TS_PACKET_SIZE_188) {
+            TSLogError(@"Invalid TS packet: payloadOffset %lu exceeds packet size (adaptation_field_length=%u)",
+                       (unsigned long)payloadOffset, adaptationField.adaptationFieldLength);
+            return nil;
+        }
+        const NSUInteger payloadLength = TS_PACKET_SIZE_188 - payloadOffset;
+        payload = [NSData dataWithBytesNoCopy:(void*)tsPacketData.bytes + payloadOffset
+                                       length:payloadLength
+                                 freeWhenDone:NO];
+    }
+    
+    return [[TSPacket alloc] initWithHeader:(TSPacketHeader* _Nonnull)header
+                            adaptationField:adaptationField
+                                    payload:payload];
+}
+
 +(void)packetizePayload:(NSData* _Nonnull)payload
                   track:(TSElementaryStream* _Nonnull)track
                 pcrBase:(uint64_t)pcrBase
@@ -454,8 +545,30 @@
       discontinuityFlag:(BOOL)discontinuityFlag
        randomAccessFlag:(BOOL)randomAccessFlag
          onTsPacketData:(OnTsPacketDataCallback _Nonnull)onTsPacketCb
+{
+    [self packetizePayload:payload
+                     track:track
+                   pcrBase:pcrBase
+                    pcrExt:pcrExt
+         discontinuityFlag:discontinuityFlag
+          randomAccessFlag:randomAccessFlag
+firstPacketSpliceCountdown:kNoSpliceCountdown
+ lastPacketSpliceCountdown:kNoSpliceCountdown
+            onTsPacketData:onTsPacketCb];
+}
+
++(void)packetizePayload:(NSData* _Nonnull)payload
+                  track:(TSElementaryStream* _Nonnull)track
+                pcrBase:(uint64_t)pcrBase
+                 pcrExt:(uint16_t)pcrExt
+      discontinuityFlag:(BOOL)discontinuityFlag
+       randomAccessFlag:(BOOL)randomAccessFlag
+firstPacketSpliceCountdown:(int16_t)firstPacketSpliceCountdown
+ lastPacketSpliceCountdown:(int16_t)lastPacketSpliceCountdown
+         onTsPacketData:(OnTsPacketDataCallback _Nonnull)onTsPacketCb
 {
     const BOOL hasPcr = pcrBase != kNoPcr;
+    const NSUInteger maxPacketPayloadSize = TS_PACKET_SIZE_188 - TS_PACKET_HEADER_SIZE;
     NSUInteger packetNumber = 0;
     NSUInteger remainingPayloadLength = payload.length;
     
@@ -467,18 +580,33 @@
         // transport stream packet [...] contain some information to aid random access at this point."
         const BOOL shouldSetRai = randomAccessFlag && isFirstPacket;
         const BOOL shouldSetDiscontinuity = discontinuityFlag && isFirstPacket;
-        const BOOL needsStuffing = remainingPayloadLength < (TS_PACKET_SIZE_188 - TS_PACKET_HEADER_SIZE);
-        BOOL shouldIncludeAdaptationField = shouldSendPcr || shouldSetRai || shouldSetDiscontinuity || needsStuffing;
+        
+        int16_t spliceCountdown = isFirstPacket ? firstPacketSpliceCountdown : kNoSpliceCountdown;
+        NSUInteger packetizedPayloadLength = remainingPayloadLength;
+        if (lastPacketSpliceCountdown != kNoSpliceCountdown) {
+            // The last packet needs room for an adaptation field with the countdown. If the rest of
+            // the payload would end in this packet without that room, one byte is left for a last packet.
+            const NSUInteger lastAdaptationFieldSize = 1 + 1 + (shouldSendPcr ? 6 : 0) + 1;
+            if (remainingPayloadLength + lastAdaptationFieldSize <= maxPacketPayloadSize) {
+                spliceCountdown = lastPacketSpliceCountdown;
+            } else if (remainingPayloadLength <= maxPacketPayloadSize) {
+                packetizedPayloadLength = remainingPayloadLength - 1;
+            }
+        }
+        const BOOL needsStuffing = packetizedPayloadLength < maxPacketPayloadSize;
+        BOOL shouldIncludeAdaptationField = shouldSendPcr || shouldSetRai || shouldSetDiscontinuity || needsStuffing
+            || spliceCountdown != kNoSpliceCountdown;
         
         NSData *adaptationField = shouldIncludeAdaptationField ? [[TSAdaptationField initWithPcrBase:shouldSendPcr ? pcrBase : kNoPcr
                                                                                               pcrExt:shouldSendPcr ? pcrExt : 0
                                                                                    discontinuityFlag:shouldSetDiscontinuity
                                                                                     randomAccessFlag:shouldSetRai
-                                                                                remainingPayloadSize:remainingPayloadLength]
+                                                                                     spliceCountdown:spliceCountdown
+                                                                                remainingPayloadSize:packetizedPayloadLength]
                                                                   getBytes] : nil;
         
-        const NSUInteger remainingSpaceInPacket = TS_PACKET_SIZE_188 - TS_PACKET_HEADER_SIZE - adaptationField.length;
-        const NSUInteger packetPayloadSize = MIN(remainingSpaceInPacket, remainingPayloadLength);
+        const NSUInteger remainingSpaceInPacket = maxPacketPayloadSize - adaptationField.length;
+        const NSUInteger packetPayloadSize = MIN(remainingSpaceInPacket, packetizedPayloadLength);
         const NSUInteger payloadOffset = payload.length - remainingPayloadLength;
         
         TSPacketHeader *header = [[TSPacketHeader alloc] initWithSyncByte:TS_PACKET_HEADER_SYNC_BYTE
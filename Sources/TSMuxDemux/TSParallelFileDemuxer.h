@@ -0,0 +1,54 @@
+//
+//  TSParallelFileDemuxer.h
+//  TSMuxDemux
+//
+//  Demuxes a recorded transport stream file on multiple cores.
+//
+
+#import <Foundation/Foundation.h>
+#import "TSConstants.h"
+#import "TSAccessUnit.h"
+@class TSParallelFileDemuxer;
+@class TSRandomAccessIndex;
+
+@protocol TSParallelFileDemuxerDelegate <NSObject>
+/// Called on the thread that invoked `-demuxFileAtPath:`. Access units of each PID arrive in file order.
+-(void)parallelDemuxer:(TSParallelFileDemuxer * _Nonnull)demuxer didReceiveAccessUnit:(TSAccessUnit * _Nonnull)accessUnit;
+@end
+
+/// Splits a file into packet-aligned byte ranges that are demuxed concurrently, each by its own
+/// TSDemuxer.
+///
+/// PSI is harvested first with a TSRandomAccessIndexBuilder pass so every range starts with the
+/// PAT/PMT that were in effect at its start offset. An access unit belongs to the range holding
+/// its first (PUSI) packet: a range drops the partial access units it starts in the middle of,
+/// and reads past its end, on the PIDs still in progress only, until each has seen its next PUSI.
+/// Each range's program timelines resume from the index's PCR samples, so `timelinePts` and
+/// `timelineDts` continue across ranges, through wraps and discontinuities, as in a serial pass.
+///
+/// Limitations: only access units are reported (PSI is available from the index), the last
+/// access unit of each PID in the file is never delivered (as with TSDemuxer), and same-PTS PES
+/// packets straddling a range boundary are delivered as separate access units.
+@interface TSParallelFileDemuxer : NSObject
+
+@property(nonatomic, weak, nullable) id<TSParallelFileDemuxerDelegate> delegate;
+@property(nonatomic, readonly) TSDemuxerMode mode;
+
+/// Size of each range in bytes (rounded down to whole packets). Default 64 MB.
+@property(nonatomic) NSUInteger rangeSize;
+
+/// Maximum number of ranges demuxed (and buffered) at once. Default: active processor count.
+@property(nonatomic) NSUInteger maxConcurrentRanges;
+
+/// Forwarded to each range's TSDemuxer. See TSDemuxer.
+@property(nonatomic, copy, nullable) NSSet<NSNumber*> *esPidFilter;
+@property(nonatomic, copy, nullable) NSSet<NSNumber*> *nalIndexingPids;
+
+-(instancetype _Nonnull)initWithDelegate:(id<TSParallelFileDemuxerDelegate> _Nullable)delegate
+                                    mode:(TSDemuxerMode)mode;
+
+/// Demuxes the file synchronously. Returns NO if the file cannot be read.
+/// @param index A previously built index for the file, or nil to build one first.
+-(BOOL)demuxFileAtPath:(NSString * _Nonnull)path index:(TSRandomAccessIndex * _Nullable)index;
+
+@end
@@ -0,0 +1,208 @@
+//
+//  TSParallelFileDemuxer.m
+//  TSMuxDemux
+//
+//  Demuxes a recorded transport stream file on multiple cores.
+//
+
+#import "TSParallelFileDemuxer.h"
+#import "TSDemuxer.h"
+#import "TSElementaryStream.h"
+#import "TSPacket.h"
+#import "TSLog.h"
+#import "Index/TSRandomAccessIndex.h"
+
+#define PID_COUNT 8192
+
+/// Packets fed to a range's demuxer per call. The demuxer detects the packet size (188, 192 or
+/// 204 bytes) from the periodicity of the sync bytes, not from the chunk length, so the count
+/// only bounds the work per autorelease pool.
+static const NSUInteger CHUNK_NUM_PACKETS = 4096;
+
+static const NSUInteger DEFAULT_RANGE_SIZE = 64 * 1024 * 1024;
+
+#pragma mark - TSParallelDemuxRange
+
+/// Demuxes one byte range with its own TSDemuxer. Runs on a worker thread.
+@interface TSParallelDemuxRange : NSObject <TSDemuxerDelegate>
+@property(nonatomic, readonly) NSUInteger start;
+@property(nonatomic, readonly) NSUInteger end;
+@property(nonatomic, readonly, nonnull) NSMutableArray<TSAccessUnit*> *accessUnits;
+@property(nonatomic, readonly, nonnull) dispatch_semaphore_t done;
+@end
+
+@implementation TSParallelDemuxRange
+{
+    TSDemuxer *_demuxer;
+    BOOL _pidHadPusi[PID_COUNT];
+}
+
+-(instancetype)initWithStart:(NSUInteger)start end:(NSUInteger)end
+{
+    self = [super init];
+    if (self) {
+        _start = start;
+        _end = end;
+        _accessUnits = [NSMutableArray array];
+        _done = dispatch_semaphore_create(0);
+    }
+    return self;
+}
+
+-(void)demuxData:(NSData *)file
+           index:(TSRandomAccessIndex *)index
+            mode:(TSDemuxerMode)mode
+     esPidFilter:(NSSet<NSNumber*> *)esPidFilter
+ nalIndexingPids:(NSSet<NSNumber*> *)nalIndexingPids
+{
+    _demuxer = [[TSDemuxer alloc] initWithDelegate:self mode:mode];
+    _demuxer.esPidFilter = esPidFilter;
+    _demuxer.nalIndexingPids = nalIndexingPids;
+    [index warmUpDemuxer:_demuxer fromData:file beforeOffset:_start];
+
+    const NSUInteger packetSize = index.packetSize;
+    const NSUInteger syncOffset = TSPacketSyncOffset(packetSize);
+    const uint8_t *bytes = file.bytes;
+
+    // The range itself. Builders discard data until their first PUSI, which drops the tail of
+    // any access unit started in the previous range.
+    const NSUInteger chunkSize = CHUNK_NUM_PACKETS * packetSize;
+    for (NSUInteger pos = _start; pos < _end; pos += chunkSize) {
+        @autoreleasepool {
+            const NSUInteger length = MIN(chunkSize, _end - pos);
+            for (NSUInteger p = pos; p + packetSize <= pos + length; p += packetSize) {
+                const uint8_t *header = bytes + p + syncOffset;
+                if (header[1] & 0x40) {
+                    _pidHadPusi[TSPacketHeaderPid(header)] = YES;
+                }
+            }
+            NSData *chunk = [NSData dataWithBytesNoCopy:(void *)(bytes + pos) length:length freeWhenDone:NO];
+            [_demuxer demux:chunk dataArrivalHostTimeNanos:0];
+        }
+    }
+
+    // Past the end: complete the access units still in progress. Only packets of elementary
+    // streams with an unfinished access unit are fed, each PID up to and including its next
+    // PUSI, which is what delivers the pending access unit.
+    BOOL pending[PID_COUNT] = {0};
+    NSUInteger numPending = 0;
+    for (TSProgramMapTable *pmt in _demuxer.pmts.allValues) {
+        for (TSElementaryStream *es in pmt.elementaryStreams) {
+            if (esPidFilter.count > 0 && ![esPidFilter containsObject:@(es.pid)]) {
+                continue;
+            }
+            if (_pidHadPusi[es.pid] && !pending[es.pid]) {
+                pending[es.pid] = YES;
+                numPending++;
+            }
+        }
+    }
+
+    // Bounded so a PID that stops carrying data cannot make the range read to the end of the file.
+    const NSUInteger tailLimit = MIN(file.length, _end + (_end - _start));
+    for (NSUInteger pos = _end; numPending > 0 && pos + packetSize <= tailLimit; pos += packetSize) {
+        const uint8_t *header = bytes + pos + syncOffset;
+        const uint16_t pid = TSPacketHeaderPid(header);
+        if (!pending[pid]) {
+            continue;
+        }
+        @autoreleasepool {
+            NSData *packetData = [NSData dataWithBytesNoCopy:(void *)(bytes + pos) length:packetSize freeWhenDone:NO];
+            [_demuxer demux:packetData dataArrivalHostTimeNanos:0];
+        }
+        if (header[1] & 0x40) {
+            pending[pid] = NO;
+            numPending--;
+        }
+    }
+
+    _demuxer = nil;
+}
+
+-(void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+-(void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+-(void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit
+{
+    [_accessUnits addObject:accessUnit];
+}
+
+@end
+
+#pragma mark - TSParallelFileDemuxer
+
+@implementation TSParallelFileDemuxer
+
+-(instancetype _Nonnull)initWithDelegate:(id<TSParallelFileDemuxerDelegate> _Nullable)delegate
+                                    mode:(TSDemuxerMode)mode
+{
+    self = [super init];
+    if (self) {
+        _delegate = delegate;
+        _mode = mode;
+        _rangeSize = DEFAULT_RANGE_SIZE;
+        _maxConcurrentRanges = [NSProcessInfo processInfo].activeProcessorCount;
+    }
+    return self;
+}
+
+-(BOOL)demuxFileAtPath:(NSString * _Nonnull)path index:(TSRandomAccessIndex * _Nullable)index
+{
+    NSData *file = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    if (!file) {
+        TSLogError(@"Failed to read %@", path);
+        return NO;
+    }
+
+    if (!index) {
+        NSData *indexData = [TSRandomAccessIndexBuilder indexDataForFileAtPath:path mode:self.mode];
+        index = indexData ? [TSRandomAccessIndex indexWithData:indexData] : nil;
+        if (!index) {
+            return NO;
+        }
+    }
+
+    const NSUInteger packetSize = index.packetSize;
+    const NSUInteger rangeSize = MAX(packetSize, self.rangeSize - self.rangeSize % packetSize);
+    const NSUInteger fileLength = file.length - file.length % packetSize;
+
+    NSMutableArray<TSParallelDemuxRange*> *ranges = [NSMutableArray array];
+    for (NSUInteger start = 0; start < fileLength; start += rangeSize) {
+        [ranges addObject:[[TSParallelDemuxRange alloc] initWithStart:start end:MIN(start + rangeSize, fileLength)]];
+    }
+    TSLogInfo(@"Demuxing %@ in %lu ranges", path.lastPathComponent, (unsigned long)ranges.count);
+
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+    const NSUInteger maxInFlight = MAX(1, self.maxConcurrentRanges);
+    const TSDemuxerMode mode = self.mode;
+    NSSet<NSNumber*> *esPidFilter = self.esPidFilter;
+    NSSet<NSNumber*> *nalIndexingPids = self.nalIndexingPids;
+
+    // Ranges are emitted strictly in order; at most maxInFlight are demuxed or buffered at once.
+    NSUInteger nextToEmit = 0;
+    for (NSUInteger i = 0; i < ranges.count; i++) {
+        if (i >= maxInFlight) {
+            [self emitRange:ranges[nextToEmit++]];
+        }
+        TSParallelDemuxRange *range = ranges[i];
+        dispatch_async(queue, ^{
+            [range demuxData:file index:index mode:mode esPidFilter:esPidFilter nalIndexingPids:nalIndexingPids];
+            dispatch_semaphore_signal(range.done);
+        });
+    }
+    while (nextToEmit < ranges.count) {
+        [self emitRange:ranges[nextToEmit++]];
+    }
+    return YES;
+}
+
+-(void)emitRange:(TSParallelDemuxRange *)range
+{
+    dispatch_semaphore_wait(range.done, DISPATCH_TIME_FOREVER);
+    for (TSAccessUnit *accessUnit in range.accessUnits) {
+        [self.delegate parallelDemuxer:self didReceiveAccessUnit:accessUnit];
+    }
+    [range.accessUnits removeAllObjects];
+}
+
+@end
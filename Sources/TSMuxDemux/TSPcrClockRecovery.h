@@ -0,0 +1,54 @@
+//
+//  TSPcrClockRecovery.h
+//  TSMuxDemux
+//
+//  Recovers one program's clock (PCR) against the host clock of the receiver.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreMedia/CoreMedia.h>
+
+/// Relates the PCR of the program carried on `pcrPid` to the host time the packets arrived at
+/// (`dataArrivalHostTimeNanos` of `-[TSDemuxer demux:dataArrivalHostTimeNanos:]`).
+///
+/// A least-squares line is fitted to the last `windowSize` (PCR, arrival time) samples. Its slope
+/// is the rate of the encoder clock relative to the host clock (`driftPpm`), and the line is a
+/// smoothed mapping from stream time to host time, free of the arrival jitter of single packets.
+/// Each sample costs O(1): the fit is kept as running sums, rebased once per window.
+///
+/// All packets of a chunk share its arrival time, so the smaller the chunks the lower the jitter.
+/// A PCR discontinuity, or a sample far off the line (e.g. the input stalled), starts over.
+/// Not thread safe: use it on the thread that demuxes.
+@interface TSPcrClockRecovery : NSObject
+
+@property(nonatomic, readonly) uint16_t pcrPid;
+/// Number of samples the line is fitted to.
+@property(nonatomic, readonly) NSUInteger windowSize;
+/// Samples in the window since the last discontinuity.
+@property(nonatomic, readonly) NSUInteger sampleCount;
+/// YES once enough samples have been received since the last discontinuity for a stable fit.
+@property(nonatomic, readonly) BOOL isLocked;
+/// Rate of the host clock relative to the stream clock, minus one, in parts per million.
+/// Negative when the encoder clock runs fast compared to the host clock. 0 until locked.
+@property(nonatomic, readonly) double driftPpm;
+/// Interarrival jitter of the PCR packets in nanoseconds, smoothed as in RFC 3550 6.4.1.
+@property(nonatomic, readonly) double jitterNanos;
+/// RMS distance of the samples in the window from the fitted line, in nanoseconds.
+@property(nonatomic, readonly) double residualNanos;
+
+/// Host time at which a 90 kHz timestamp (33 bits, wrapping), e.g. a PES PTS, arrives on average.
+/// The timestamp must be within ±13 hours of the last PCR. Returns 0 if not locked.
+-(uint64_t)hostTimeNanosForTimestamp:(uint64_t)timestamp90kHz;
+/// The same for an access unit PTS/DTS. Returns 0 if not locked or the time is invalid.
+-(uint64_t)hostTimeNanosForTime:(CMTime)time;
+
+#pragma mark Demuxer
+
+-(instancetype _Nonnull)initWithPcrPid:(uint16_t)pcrPid windowSize:(NSUInteger)windowSize;
+
+-(void)addPcrBase:(uint64_t)pcrBase
+           pcrExt:(uint16_t)pcrExt
+ arrivalHostNanos:(uint64_t)arrivalHostNanos
+  isDiscontinuous:(BOOL)isDiscontinuous;
+
+@end
@@ -0,0 +1,210 @@
+//
+//  TSPcrClockRecovery.m
+//  TSMuxDemux
+//
+//  Recovers one program's clock (PCR) against the host clock of the receiver.
+//
+
+#import "TSPcrClockRecovery.h"
+#import "TSProgramTimeline.h"
+#import "TSLog.h"
+
+#define NANOS_PER_SECOND 1000000000.0
+// Samples needed before the fit is trusted (fewer if the window is smaller)
+#define LOCK_MIN_SAMPLES 16
+// A sample further than this from the line means the input stalled or the clock jumped
+#define MAX_RESIDUAL_SECONDS 1.0
+// RFC 3550 6.4.1
+#define JITTER_GAIN (1.0 / 16.0)
+
+@implementation TSPcrClockRecovery
+{
+    // Ring buffer of the samples in the window: unwrapped PCR (27 MHz) and arrival host time
+    int64_t *_pcrs;
+    uint64_t *_hostNanos;
+    NSUInteger _next;
+
+    // PCR timeline, unwrapped, restarted at discontinuities
+    TSPcrUnwrapper _pcr;
+    uint64_t _lastHostNanos;
+
+    // The fit is done in seconds relative to a reference sample, moved to the oldest sample once per
+    // window so the running sums stay small and do not accumulate rounding errors.
+    int64_t _refPcr;
+    uint64_t _refHostNanos;
+    double _sumX;
+    double _sumY;
+    double _sumXX;
+    double _sumXY;
+    double _sumYY;
+
+    // host seconds = _intercept + _slope * stream seconds, relative to the reference sample
+    double _slope;
+    double _intercept;
+}
+
+-(instancetype _Nonnull)initWithPcrPid:(uint16_t)pcrPid windowSize:(NSUInteger)windowSize
+{
+    if (windowSize < 2) {
+        [NSException raise:@"TSPcrClockRecoveryInvalidSettingsException" format:@"Window size must be >= 2"];
+    }
+    self = [super init];
+    if (self) {
+        _pcrPid = pcrPid;
+        _windowSize = windowSize;
+        _pcrs = calloc(windowSize, sizeof(int64_t));
+        _hostNanos = calloc(windowSize, sizeof(uint64_t));
+        _slope = 1.0;
+    }
+    return self;
+}
+
+-(void)dealloc
+{
+    free(_pcrs);
+    free(_hostNanos);
+}
+
+-(void)addPcrBase:(uint64_t)pcrBase
+           pcrExt:(uint16_t)pcrExt
+ arrivalHostNanos:(uint64_t)arrivalHostNanos
+  isDiscontinuous:(BOOL)isDiscontinuous
+{
+    const int64_t step = TSPcrUnwrapperStep(&_pcr, pcrBase, pcrExt, isDiscontinuous);
+    if (step == TS_PCR_UNWRAPPER_RESTART) {
+        if (_pcr.hasPcr && _isLocked) {
+            TSLogDebug(@"PCR discontinuity on PID 0x%04x, clock recovery restarts", _pcrPid);
+        }
+        [self restartWithPcrBase:pcrBase pcrExt:pcrExt arrivalHostNanos:arrivalHostNanos];
+        return;
+    }
+    const int64_t pcr = _pcr.pcr + step;
+
+    if (_isLocked) {
+        const double x = (double)(pcr - _refPcr) / TS_PCR_HZ;
+        const double y = (double)(int64_t)(arrivalHostNanos - _refHostNanos) / NANOS_PER_SECOND;
+        const double residual = y - (_intercept + _slope * x);
+        if (fabs(residual) > MAX_RESIDUAL_SECONDS) {
+            TSLogDebug(@"PCR on PID 0x%04x arrived %.3f s off the recovered clock, clock recovery restarts",
+                       _pcrPid, residual);
+            [self restartWithPcrBase:pcrBase pcrExt:pcrExt arrivalHostNanos:arrivalHostNanos];
+            return;
+        }
+    }
+
+    // Difference between the arrival interval and the PCR interval of consecutive samples
+    const double transitDelta = (double)(int64_t)(arrivalHostNanos - _lastHostNanos)
+        - (double)step * (NANOS_PER_SECOND / TS_PCR_HZ);
+    _jitterNanos += (fabs(transitDelta) - _jitterNanos) * JITTER_GAIN;
+
+    TSPcrUnwrapperAdvance(&_pcr, pcrBase, step);
+    _lastHostNanos = arrivalHostNanos;
+    [self addSample];
+}
+
+-(void)restartWithPcrBase:(uint64_t)pcrBase pcrExt:(uint16_t)pcrExt arrivalHostNanos:(uint64_t)arrivalHostNanos
+{
+    TSPcrUnwrapperRestart(&_pcr, pcrBase, pcrExt);
+    _lastHostNanos = arrivalHostNanos;
+    _refPcr = _pcr.pcr;
+    _refHostNanos = arrivalHostNanos;
+    _sampleCount = 0;
+    _next = 0;
+    _sumX = _sumY = _sumXX = _sumXY = _sumYY = 0;
+    _jitterNanos = 0;
+    [self addSample];
+}
+
+#pragma mark Fit
+
+/// Adds the last PCR to the window, evicting the oldest sample once the window is full.
+-(void)addSample
+{
+    if (_sampleCount == _windowSize) {
+        [self accumulateSampleAtIndex:_next sign:-1.0];
+    } else {
+        _sampleCount++;
+    }
+    _pcrs[_next] = _pcr.pcr;
+    _hostNanos[_next] = _lastHostNanos;
+    [self accumulateSampleAtIndex:_next sign:1.0];
+
+    _next = (_next + 1) % _windowSize;
+    if (_next == 0) {
+        // Once per window: O(windowSize), i.e. O(1) per sample
+        [self rebase];
+    }
+    [self fit];
+}
+
+-(void)accumulateSampleAtIndex:(NSUInteger)index sign:(double)sign
+{
+    const double x = (double)(_pcrs[index] - _refPcr) / TS_PCR_HZ;
+    const double y = (double)(int64_t)(_hostNanos[index] - _refHostNanos) / NANOS_PER_SECOND;
+    _sumX += sign * x;
+    _sumY += sign * y;
+    _sumXX += sign * x * x;
+    _sumXY += sign * x * y;
+    _sumYY += sign * y * y;
+}
+
+/// Moves the reference to the oldest sample and recomputes the sums.
+-(void)rebase
+{
+    // The window is full whenever the ring wraps, so the oldest sample is at _next
+    _refPcr = _pcrs[_next];
+    _refHostNanos = _hostNanos[_next];
+    _sumX = _sumY = _sumXX = _sumXY = _sumYY = 0;
+    for (NSUInteger i = 0; i < _sampleCount; i++) {
+        [self accumulateSampleAtIndex:i sign:1.0];
+    }
+}
+
+-(void)fit
+{
+    const double n = (double)_sampleCount;
+    const double sxx = _sumXX - _sumX * _sumX / n;
+    if (_sampleCount < 2 || sxx <= 0) {
+        // Not enough spread in the PCR to fit a slope: assume both clocks run at the same rate
+        _slope = 1.0;
+        _intercept = (_sumY - _sumX) / n;
+    } else {
+        _slope = (_sumXY - _sumX * _sumY / n) / sxx;
+        _intercept = (_sumY - _slope * _sumX) / n;
+    }
+    const double sse = _sumYY - _intercept * _sumY - _slope * _sumXY;
+    _residualNanos = sqrt(MAX(sse, 0.0) / n) * NANOS_PER_SECOND;
+    _isLocked = _sampleCount >= MIN((NSUInteger)LOCK_MIN_SAMPLES, _windowSize);
+    _driftPpm = _isLocked ? (_slope - 1.0) * 1e6 : 0.0;
+}
+
+#pragma mark Mapping
+
+-(uint64_t)hostTimeNanosForTimestamp:(uint64_t)timestamp90kHz
+{
+    if (!_isLocked) {
+        return 0;
+    }
+    const int64_t pcr = TSPcrUnwrapperTimestampValue(&_pcr, timestamp90kHz) * 300;
+    const double x = (double)(pcr - _refPcr) / TS_PCR_HZ;
+    const int64_t hostNanos = (int64_t)_refHostNanos + llround((_intercept + _slope * x) * NANOS_PER_SECOND);
+    return hostNanos > 0 ? (uint64_t)hostNanos : 0;
+}
+
+-(uint64_t)hostTimeNanosForTime:(CMTime)time
+{
+    if (!_isLocked || !CMTIME_IS_NUMERIC(time)) {
+        return 0;
+    }
+    return [self hostTimeNanosForTimestamp:TSTimestampFromTime(time)];
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ PCR PID 0x%04x, %@ }", _pcrPid,
+            _isLocked ? [NSString stringWithFormat:@"drift %.1f ppm, jitter %.3f ms, residual %.3f ms",
+                         _driftPpm, _jitterNanos / 1e6, _residualNanos / 1e6]
+                      : [NSString stringWithFormat:@"not locked (%lu samples)", (unsigned long)_sampleCount]];
+}
+
+@end
@@ -0,0 +1,46 @@
+//
+//  TSPcrUtcClock.h
+//  TSMuxDemux
+//
+//  Maps the timestamps of one program's clock (PCR/PTS/DTS) to UTC.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreMedia/CoreMedia.h>
+
+/// Maps the 90 kHz timestamps of the program whose PCR is carried on `pcrPid` to UTC, using the
+/// time tables of the stream (DVB TDT/TOT, ATSC STT).
+///
+/// Each time table anchors the PCR timeline to UTC. The broadcast time only has one second
+/// resolution, so each table narrows the range in which the true offset lies, and the estimate
+/// improves as tables arrive. A PCR discontinuity, or a table that no longer agrees with the others
+/// (e.g. a clock jump at the encoder), starts over.
+///
+/// The demuxer keeps the clock up to date. Converting a timestamp is a few arithmetic operations,
+/// so it can be done for every access unit. Not thread safe: use it on the thread that demuxes.
+@interface TSPcrUtcClock : NSObject
+
+@property(nonatomic, readonly) uint16_t pcrPid;
+/// YES once a time table has been received since the last discontinuity.
+@property(nonatomic, readonly) BOOL isValid;
+/// Width of the range the true offset lies in, in seconds. 1 after the first time table.
+@property(nonatomic, readonly) double uncertainty;
+
+/// Seconds since 1970-01-01 UTC of a 90 kHz timestamp (33 bits, wrapping), e.g. a PES PTS.
+/// The timestamp must be within ±13 hours of the last PCR. Returns NAN if not valid.
+-(double)unixSecondsForTimestamp:(uint64_t)timestamp90kHz;
+/// The same for an access unit PTS/DTS. Returns nil if not valid or the time is invalid.
+-(NSDate * _Nullable)utcDateForTime:(CMTime)time;
+
+#pragma mark Demuxer
+
+-(instancetype _Nonnull)initWithPcrPid:(uint16_t)pcrPid;
+
+/// `packetIndex` counts all packets of the stream; it places the time tables between PCRs.
+-(void)addPcrBase:(uint64_t)pcrBase
+           pcrExt:(uint16_t)pcrExt
+      packetIndex:(uint64_t)packetIndex
+  isDiscontinuous:(BOOL)isDiscontinuous;
+-(void)addUtcTime:(int64_t)unixSeconds packetIndex:(uint64_t)packetIndex;
+
+@end
@@ -0,0 +1,112 @@
+//
+//  TSPcrUtcClock.m
+//  TSMuxDemux
+//
+//  Maps the timestamps of one program's clock (PCR/PTS/DTS) to UTC.
+//
+
+#import "TSPcrUtcClock.h"
+#import "TSProgramTimeline.h"
+#import "TSLog.h"
+
+@implementation TSPcrUtcClock
+{
+    // PCR timeline, unwrapped, restarted at discontinuities
+    TSPcrUnwrapper _pcr;
+    uint64_t _lastPcrPacketIndex;
+    BOOL _hasPreviousPcr;
+    int64_t _previousPcr;
+    uint64_t _previousPcrPacketIndex;
+
+    // UTC = PCR seconds + offset, with the offset known to lie in [_minOffset, _maxOffset]
+    double _minOffset;
+    double _maxOffset;
+    double _offset;
+}
+
+-(instancetype _Nonnull)initWithPcrPid:(uint16_t)pcrPid
+{
+    self = [super init];
+    if (self) {
+        _pcrPid = pcrPid;
+    }
+    return self;
+}
+
+-(void)addPcrBase:(uint64_t)pcrBase
+           pcrExt:(uint16_t)pcrExt
+      packetIndex:(uint64_t)packetIndex
+  isDiscontinuous:(BOOL)isDiscontinuous
+{
+    const int64_t step = TSPcrUnwrapperStep(&_pcr, pcrBase, pcrExt, isDiscontinuous);
+    if (step == TS_PCR_UNWRAPPER_RESTART) {
+        if (_pcr.hasPcr && _isValid) {
+            TSLogDebug(@"PCR discontinuity on PID 0x%04x, UTC mapping restarts", _pcrPid);
+        }
+        TSPcrUnwrapperRestart(&_pcr, pcrBase, pcrExt);
+        _hasPreviousPcr = NO;
+        _isValid = NO;
+        _lastPcrPacketIndex = packetIndex;
+        return;
+    }
+    _hasPreviousPcr = YES;
+    _previousPcr = _pcr.pcr;
+    _previousPcrPacketIndex = _lastPcrPacketIndex;
+    TSPcrUnwrapperAdvance(&_pcr, pcrBase, step);
+    _lastPcrPacketIndex = packetIndex;
+}
+
+-(void)addUtcTime:(int64_t)unixSeconds packetIndex:(uint64_t)packetIndex
+{
+    if (!_pcr.hasPcr) {
+        return;
+    }
+    // PCR at the time table's packet, interpolated from the rate of the last two PCRs (ISO/IEC 13818-1 2.4.2.2)
+    double pcr = (double)_pcr.pcr;
+    if (_hasPreviousPcr && _lastPcrPacketIndex > _previousPcrPacketIndex) {
+        const double ticksPerPacket = (double)(_pcr.pcr - _previousPcr) / (double)(_lastPcrPacketIndex - _previousPcrPacketIndex);
+        pcr += ticksPerPacket * ((double)packetIndex - (double)_lastPcrPacketIndex);
+    }
+
+    // The table was sent at some time in [unixSeconds, unixSeconds + 1)
+    const double minOffset = (double)unixSeconds - pcr / TS_PCR_HZ;
+    const double maxOffset = minOffset + 1.0;
+    if (_isValid && minOffset <= _maxOffset && maxOffset >= _minOffset) {
+        _minOffset = MAX(_minOffset, minOffset);
+        _maxOffset = MIN(_maxOffset, maxOffset);
+    } else {
+        if (_isValid) {
+            TSLogDebug(@"UTC time on PID 0x%04x no longer agrees with the PCR (%.3f s off), UTC mapping restarts",
+                       _pcrPid, minOffset > _maxOffset ? minOffset - _maxOffset : _minOffset - maxOffset);
+        }
+        _minOffset = minOffset;
+        _maxOffset = maxOffset;
+        _isValid = YES;
+    }
+    _offset = (_minOffset + _maxOffset) / 2.0;
+    _uncertainty = _maxOffset - _minOffset;
+}
+
+-(double)unixSecondsForTimestamp:(uint64_t)timestamp90kHz
+{
+    if (!_isValid) {
+        return NAN;
+    }
+    return (double)TSPcrUnwrapperTimestampValue(&_pcr, timestamp90kHz) / TS_TIMESTAMP_HZ + _offset;
+}
+
+-(NSDate * _Nullable)utcDateForTime:(CMTime)time
+{
+    if (!_isValid || !CMTIME_IS_NUMERIC(time)) {
+        return nil;
+    }
+    return [NSDate dateWithTimeIntervalSince1970:[self unixSecondsForTimestamp:TSTimestampFromTime(time)]];
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ PCR PID 0x%04x, %@ }", _pcrPid,
+            _isValid ? [NSString stringWithFormat:@"offset %.3f s ± %.3f s", _offset, _uncertainty / 2.0] : @"not valid"];
+}
+
+@end
@@ -8,14 +8,54 @@
 
 #import <Foundation/Foundation.h>
 #import <CoreMedia/CoreMedia.h>
+#import "TSConstants.h"
 @class TSPacket;
 
+#pragma mark - TSPesHeaderInfo
+
+/// Allocation-free result of parsing a PES header.
+///
+/// Timestamps are kept as raw 33-bit 90 kHz values; use `TSPesHeaderInfoPtsTime()` /
+/// `TSPesHeaderInfoDtsTime()` to convert to CMTime only when needed.
+typedef struct {
+    uint64_t pts;               ///< Raw 33-bit PTS. Only meaningful if hasPts.
+    uint64_t dts;               ///< Raw 33-bit DTS. Only meaningful if hasDts.
+    BOOL hasPts;                ///< PTS was present with a valid prefix and marker bits.
+    BOOL hasDts;                ///< DTS was present with a valid prefix and marker bits.
+    BOOL dataAlignment;         ///< data_alignment_indicator (always NO for streams without optional header).
+    uint8_t streamId;           ///< PES stream_id.
+    uint16_t pesPacketLength;   ///< PES packet length from header. 0 means unbounded.
+    uint16_t payloadOffset;     ///< Offset from the start code to the PES payload.
+} TSPesHeaderInfo;
+
+/// Parses a PES header starting at `bytes` (which must point at the 00 00 01 start code).
+/// Does not allocate.
+/// @return YES if a valid PES header was parsed into `outInfo`.
+FOUNDATION_EXPORT BOOL TSPesHeaderParse(const uint8_t * _Nonnull bytes,
+                                        NSUInteger length,
+                                        TSPesHeaderInfo * _Nonnull outInfo);
+
+/// Returns the PTS as CMTime, or kCMTimeInvalid if not present.
+static inline CMTime TSPesHeaderInfoPtsTime(const TSPesHeaderInfo * _Nonnull info) {
+    return info->hasPts ? CMTimeMake((int64_t)info->pts, TS_TIMESTAMP_TIMESCALE) : kCMTimeInvalid;
+}
+
+/// Returns the DTS as CMTime, or kCMTimeInvalid if not present.
+static inline CMTime TSPesHeaderInfoDtsTime(const TSPesHeaderInfo * _Nonnull info) {
+    return info->hasDts ? CMTimeMake((int64_t)info->dts, TS_TIMESTAMP_TIMESCALE) : kCMTimeInvalid;
+}
+
+#pragma mark - TSPesHeader
+
 /// Lightweight PES header parser that extracts timestamps and payload offset
 /// without copying the payload data.
 ///
 /// See "Rec. ITU-T H.222.0 (03/2017)" section "2.4.3.6 PES packet" page 37
 @interface TSPesHeader : NSObject
 
+/// Raw header fields as parsed by `TSPesHeaderParse()`.
+@property (nonatomic, readonly) TSPesHeaderInfo info;
+
 /// Presentation timestamp. Set to kCMTimeInvalid if not present.
 @property (nonatomic, readonly) CMTime pts;
 
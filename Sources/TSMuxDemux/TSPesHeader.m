@@ -65,50 +65,48 @@ static inline BOOL parseTimestamp(TSBitReader *reader, uint8_t expectedPrefix, u
     return YES;
 }
 
-@implementation TSPesHeader
-
-+ (instancetype _Nullable)parseFromPacket:(TSPacket * _Nonnull)packet
+BOOL TSPesHeaderParse(const uint8_t * _Nonnull bytes,
+                      NSUInteger length,
+                      TSPesHeaderInfo * _Nonnull outInfo)
 {
-    NSData *payload = packet.payload;
-
     // Minimum PES header: start code (3) + stream_id (1) + length (2) = 6 bytes
-    if (payload.length < 6) {
-        return nil;
+    if (length < 6) {
+        return NO;
     }
 
-    TSBitReader reader = TSBitReaderMake(payload);
+    TSBitReader reader = TSBitReaderMakeWithBytes(bytes, length);
 
     // Validate PES start code (0x00 0x00 0x01)
     if (TSBitReaderReadUInt8(&reader) != 0x00 ||
         TSBitReaderReadUInt8(&reader) != 0x00 ||
         TSBitReaderReadUInt8(&reader) != 0x01) {
-        return nil;
+        return NO;
     }
 
+    TSPesHeaderInfo info = {0};
+
     // Byte 4: stream_id
-    const uint8_t streamId = TSBitReaderReadUInt8(&reader);
+    info.streamId = TSBitReaderReadUInt8(&reader);
 
     // Bytes 5-6: PES packet length (0 = unbounded, common for video)
-    const uint16_t pesPacketLength = TSBitReaderReadUInt16BE(&reader);
+    info.pesPacketLength = TSBitReaderReadUInt16BE(&reader);
 
     // Check stream_id for alternate PES format (no optional header, payload at byte 6)
-    if (streamIdHasNoOptionalHeader(streamId)) {
-        TSPesHeader *header = [[TSPesHeader alloc] init];
-        header->_pts = kCMTimeInvalid;
-        header->_dts = kCMTimeInvalid;
-        header->_isDiscontinuous = packet.adaptationField.discontinuityFlag;
-        header->_payloadOffset = 6;
-        header->_pesPacketLength = pesPacketLength;
-        return header;
+    if (streamIdHasNoOptionalHeader(info.streamId)) {
+        info.payloadOffset = 6;
+        *outInfo = info;
+        return YES;
     }
 
     // Normal PES format requires at least 9 bytes (6 + flags1 + flags2 + header_data_length)
-    if (payload.length < 9) {
-        return nil;
+    if (length < 9) {
+        return NO;
     }
 
-    // Byte 7: flags1 (skip - contains marker bits and scrambling control)
-    TSBitReaderSkip(&reader, 1);
+    // Byte 7: flags1 - '10' marker, scrambling control (2), priority, data_alignment_indicator, ...
+    TSBitReaderSkipBits(&reader, 5);
+    info.dataAlignment = TSBitReaderReadBits(&reader, 1) != 0;
+    TSBitReaderSkipBits(&reader, 2);
 
     // Byte 8: flags2 - PTS/DTS flags are the top 2 bits
     const BOOL hasPts = TSBitReaderReadBits(&reader, 1) != 0;
@@ -119,48 +117,75 @@ static inline BOOL parseTimestamp(TSBitReader *reader, uint8_t expectedPrefix, u
     const uint8_t pesHeaderDataLength = TSBitReaderReadUInt8(&reader);
 
     if (reader.error) {
-        TSLogWarn(@"PES header truncated while reading header fields");
-        return nil;
+        TSLogWarnC(@"PES header truncated while reading header fields");
+        return NO;
     }
 
     // Validate payload has enough bytes for header + declared header data
     const NSUInteger payloadOffset = 9 + pesHeaderDataLength;
-    if (payloadOffset > payload.length) {
-        return nil;
+    if (payloadOffset > length) {
+        return NO;
     }
 
     // Validate payload has enough bytes for timestamps if present
-    if (hasPts && payload.length < 9 + TIMESTAMP_LENGTH) {
-        return nil;
+    if (hasPts && length < 9 + TIMESTAMP_LENGTH) {
+        return NO;
     }
-    if (hasDts && payload.length < 9 + 2 * TIMESTAMP_LENGTH) {
-        return nil;
+    if (hasDts && length < 9 + 2 * TIMESTAMP_LENGTH) {
+        return NO;
     }
 
-    BOOL ptsValid = NO;
-    BOOL dtsValid = NO;
-    uint64_t pts = 0;
-    uint64_t dts = 0;
-
     if (hasPts) {
         // PTS prefix: 0010 for PTS-only, 0011 for PTS+DTS
         uint8_t expectedPtsPrefix = hasDts ? 0x3 : 0x2;
-        ptsValid = parseTimestamp(&reader, expectedPtsPrefix, &pts);
+        info.hasPts = parseTimestamp(&reader, expectedPtsPrefix, &info.pts);
 
         if (hasDts) {
             // DTS prefix: 0001
-            dtsValid = parseTimestamp(&reader, 0x1, &dts);
+            info.hasDts = parseTimestamp(&reader, 0x1, &info.dts);
         }
     }
 
+    info.payloadOffset = (uint16_t)payloadOffset;
+    *outInfo = info;
+    return YES;
+}
+
+@implementation TSPesHeader
+
++ (instancetype _Nullable)parseFromPacket:(TSPacket * _Nonnull)packet
+{
+    NSData *payload = packet.payload;
+
+    TSPesHeaderInfo info;
+    if (!TSPesHeaderParse(payload.bytes, payload.length, &info)) {
+        return nil;
+    }
+
     TSPesHeader *header = [[TSPesHeader alloc] init];
-    header->_pts = ptsValid ? CMTimeMake(pts, TS_TIMESTAMP_TIMESCALE) : kCMTimeInvalid;
-    header->_dts = dtsValid ? CMTimeMake(dts, TS_TIMESTAMP_TIMESCALE) : kCMTimeInvalid;
+    header->_info = info;
     header->_isDiscontinuous = packet.adaptationField.discontinuityFlag;
-    header->_payloadOffset = payloadOffset;
-    header->_pesPacketLength = pesPacketLength;
-
     return header;
 }
 
+-(CMTime)pts
+{
+    return TSPesHeaderInfoPtsTime(&_info);
+}
+
+-(CMTime)dts
+{
+    return TSPesHeaderInfoDtsTime(&_info);
+}
+
+-(NSUInteger)payloadOffset
+{
+    return _info.payloadOffset;
+}
+
+-(uint16_t)pesPacketLength
+{
+    return _info.pesPacketLength;
+}
+
 @end
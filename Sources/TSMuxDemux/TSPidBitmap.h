@@ -0,0 +1,37 @@
+//
+//  TSPidBitmap.h
+//  TSMuxDemux
+//
+//  Fixed-size set of 13-bit PIDs, checked with a single load per packet.
+//
+
+#import <Foundation/Foundation.h>
+
+#define TS_PID_COUNT 8192
+
+typedef struct {
+    uint64_t words[TS_PID_COUNT / 64];
+} TSPidBitmap;
+
+static inline void TSPidBitmapFill(TSPidBitmap *bitmap, BOOL value)
+{
+    memset(bitmap->words, value ? 0xFF : 0x00, sizeof(bitmap->words));
+}
+
+static inline void TSPidBitmapAdd(TSPidBitmap *bitmap, uint16_t pid)
+{
+    pid &= TS_PID_COUNT - 1;
+    bitmap->words[pid >> 6] |= (uint64_t)1 << (pid & 63);
+}
+
+static inline void TSPidBitmapRemove(TSPidBitmap *bitmap, uint16_t pid)
+{
+    pid &= TS_PID_COUNT - 1;
+    bitmap->words[pid >> 6] &= ~((uint64_t)1 << (pid & 63));
+}
+
+static inline BOOL TSPidBitmapContains(const TSPidBitmap *bitmap, uint16_t pid)
+{
+    pid &= TS_PID_COUNT - 1;
+    return (bitmap->words[pid >> 6] >> (pid & 63)) & 1;
+}
@@ -0,0 +1,54 @@
+//
+//  TSProgramExtractor.h
+//  TSMuxDemux
+//
+//  Packet-level extraction of programs from a multi program transport stream.
+//
+
+#import <Foundation/Foundation.h>
+#import "TSConstants.h"
+@class TSProgramExtractor;
+
+@protocol TSProgramExtractorDelegate <NSObject>
+/// One 188-byte output packet.
+///
+/// @warning Forwarded packets reference the memory of the chunk passed to `-extract:` (no copy).
+/// Copy the data if it needs to outlive the callback.
+-(void)programExtractor:(TSProgramExtractor * _Nonnull)extractor didOutputTsPacketData:(NSData * _Nonnull)tsPacketData;
+@end
+
+/// Extracts one or more programs from an MPTS into an SPTS/MPTS without reassembling access units.
+///
+/// PAT and the selected programs' PMTs are parsed; elementary stream and PCR packets of the
+/// selected programs are forwarded untouched (same bytes, same continuity counters), and all
+/// other PIDs are dropped. A rewritten PAT listing only the selected programs is emitted
+/// each time the source PAT repeats, with its own version number that is bumped whenever the
+/// set of output programs changes.
+///
+/// PMT packets are forwarded as-is unless a PID is remapped, or the PMT PID also carries the
+/// PMT of a program that is not selected. In those cases the PMT section is re-emitted with the
+/// PIDs rewritten (descriptors and version preserved) each time the source PMT repeats.
+///
+/// PAT and PMT version changes take effect at the packet where the new table completes.
+/// Input may use 188, 192 (M2TS) or 204-byte packets (detected from the first chunk, as TSDemuxer
+/// does); output packets are always 188 bytes.
+@interface TSProgramExtractor : NSObject
+
+@property(nonatomic, weak, nullable) id<TSProgramExtractorDelegate> delegate;
+@property(nonatomic, readonly, nonnull) NSSet<ProgramNumber> *programNumbers;
+@property(nonatomic, readonly, nonnull) NSDictionary<Pid, Pid> *pidRemap;
+
+/// If YES (the default), null packets are dropped. Otherwise they are forwarded.
+@property(nonatomic) BOOL removeNullPackets;
+
+/// Throws if `programNumbers` is empty or contains the network program (0), or if `pidRemap`
+/// maps from or to a reserved PID, or maps two PIDs to the same output PID.
+/// @param pidRemap Source PID -> output PID for PMT, PCR and ES PIDs. Unmapped PIDs keep their value.
+-(instancetype _Nonnull)initWithProgramNumbers:(NSSet<ProgramNumber> * _Nonnull)programNumbers
+                                      pidRemap:(NSDictionary<Pid, Pid> * _Nullable)pidRemap
+                                      delegate:(id<TSProgramExtractorDelegate> _Nullable)delegate;
+
+/// Feeds the next chunk of the source stream. Like -[TSDemuxer demux:], chunks must contain whole packets.
+-(void)extract:(NSData * _Nonnull)chunk;
+
+@end
@@ -0,0 +1,311 @@
+//
+//  TSProgramExtractor.m
+//  TSMuxDemux
+//
+//  Packet-level extraction of programs from a multi program transport stream.
+//
+
+#import "TSProgramExtractor.h"
+#import "TSPacket.h"
+#import "TSPidBitmap.h"
+#import "TSElementaryStream.h"
+#import "TSLog.h"
+#import "Table/TSPsiTableBuilder.h"
+#import "Table/TSProgramSpecificInformationTable.h"
+#import "Table/TSProgramAssociationTable.h"
+#import "Table/TSProgramMapTable.h"
+
+/// Rewrites the 13-bit PID of a two-byte '111X XXXX XXXX XXXX' field, keeping the 3 leading bits.
+static inline void remapPidField(uint8_t *field, const uint16_t *remap)
+{
+    const uint16_t pid = remap[((field[0] & 0x1F) << 8) | field[1]];
+    field[0] = (field[0] & 0xE0) | ((pid >> 8) & 0x1F);
+    field[1] = pid & 0xFF;
+}
+
+@interface TSProgramExtractor() <TSPsiTableBuilderDelegate>
+@end
+
+@implementation TSProgramExtractor
+{
+    NSUInteger _packetSize;
+
+    uint16_t _remap[TS_PID_COUNT];
+    BOOL _hasRemap;
+
+    // PMT PIDs of the selected programs, and the subset whose packets are forwarded untouched.
+    TSPidBitmap _pmtPids;
+    TSPidBitmap _pmtPassthroughPids;
+    // ES and PCR PIDs of the selected programs.
+    TSPidBitmap _forwardPids;
+
+    TSPsiTableBuilder *_patBuilder;
+    NSMutableDictionary<Pid, TSPsiTableBuilder*> *_pmtBuilders;
+    NSDictionary<ProgramNumber, PmtPid> *_selectedProgrammes;
+    NSMutableDictionary<ProgramNumber, TSProgramMapTable*> *_pmts;
+
+    // Output PAT/PMT state (continuity counters live in the tracks).
+    NSDictionary<ProgramNumber, PmtPid> *_outputProgrammes;
+    uint8_t _patVersion;
+    TSElementaryStream *_patTrack;
+    NSMutableDictionary<Pid, TSElementaryStream*> *_pmtTracks;
+}
+
+-(instancetype _Nonnull)initWithProgramNumbers:(NSSet<ProgramNumber> * _Nonnull)programNumbers
+                                      pidRemap:(NSDictionary<Pid, Pid> * _Nullable)pidRemap
+                                      delegate:(id<TSProgramExtractorDelegate> _Nullable)delegate
+{
+    if (programNumbers.count == 0) {
+        [NSException raise:@"TSProgramExtractorInvalidSettingsException" format:@"At least one program must be selected"];
+    }
+    if ([programNumbers containsObject:@(PROGRAM_NUMBER_NETWORK_INFO)]) {
+        [NSException raise:@"TSProgramExtractorInvalidSettingsException" format:@"The network program cannot be extracted"];
+    }
+    NSMutableSet<Pid> *outputPids = [NSMutableSet set];
+    for (Pid sourcePid in pidRemap) {
+        Pid outputPid = pidRemap[sourcePid];
+        if ([TSPidUtil isCustomPidInvalid:sourcePid.unsignedShortValue] ||
+            [TSPidUtil isCustomPidInvalid:outputPid.unsignedShortValue]) {
+            [NSException raise:@"TSProgramExtractorInvalidPidException" format:@"Remapped PID is reserved/out of valid range"];
+        }
+        if ([outputPids containsObject:outputPid]) {
+            [NSException raise:@"TSProgramExtractorInvalidPidException" format:@"Two PIDs are remapped to the same PID"];
+        }
+        [outputPids addObject:outputPid];
+    }
+
+    self = [super init];
+    if (self) {
+        _delegate = delegate;
+        _programNumbers = [programNumbers copy];
+        _pidRemap = [pidRemap copy] ?: @{};
+        _removeNullPackets = YES;
+
+        for (NSUInteger pid = 0; pid < TS_PID_COUNT; pid++) {
+            _remap[pid] = (uint16_t)pid;
+        }
+        for (Pid sourcePid in _pidRemap) {
+            const uint16_t from = sourcePid.unsignedShortValue;
+            _remap[from] = _pidRemap[sourcePid].unsignedShortValue;
+            _hasRemap = _hasRemap || _remap[from] != from;
+        }
+
+        TSPidBitmapFill(&_pmtPids, NO);
+        TSPidBitmapFill(&_pmtPassthroughPids, NO);
+        TSPidBitmapFill(&_forwardPids, NO);
+
+        _patBuilder = [[TSPsiTableBuilder alloc] initWithDelegate:self pid:PID_PAT];
+        _pmtBuilders = [NSMutableDictionary dictionary];
+        _selectedProgrammes = @{};
+        _pmts = [NSMutableDictionary dictionary];
+
+        const uint8_t streamTypeNotApplicable = 0;
+        _patTrack = [[TSElementaryStream alloc] initWithPid:PID_PAT
+                                                 streamType:streamTypeNotApplicable
+                                                descriptors:nil];
+        _pmtTracks = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+-(void)extract:(NSData * _Nonnull)chunk
+{
+    if (_packetSize == 0) {
+        _packetSize = TSPacketDetectSizeOfChunk(chunk.bytes, chunk.length);
+    }
+    if (chunk.length % _packetSize != 0) {
+        TSLogError(@"Received non-integer number of ts packets: %lu (expected multiple of %lu)",
+                   (unsigned long)chunk.length, (unsigned long)_packetSize);
+        return;
+    }
+
+    // The 188-byte packets, after the TP_extra_header of M2TS packets
+    const uint8_t *bytes = (const uint8_t *)chunk.bytes + TSPacketSyncOffset(_packetSize);
+    for (NSUInteger offset = 0; offset < chunk.length; offset += _packetSize) {
+        const uint8_t *packet = bytes + offset;
+        const uint16_t pid = TSPacketHeaderPid(packet);
+
+        if (pid == PID_PAT) {
+            [self addPacket:packet toPsiBuilder:_patBuilder];
+        } else if (TSPidBitmapContains(&_pmtPids, pid)) {
+            if (TSPidBitmapContains(&_pmtPassthroughPids, pid)) {
+                [self forwardPacket:packet pid:pid];
+            }
+            [self addPacket:packet toPsiBuilder:_pmtBuilders[@(pid)]];
+        } else if (TSPidBitmapContains(&_forwardPids, pid)) {
+            [self forwardPacket:packet pid:pid];
+        } else if (pid == PID_NULL_PACKET && !_removeNullPackets) {
+            [self forwardPacket:packet pid:pid];
+        }
+    }
+}
+
+#pragma mark - Output
+
+-(void)forwardPacket:(const uint8_t *)packet pid:(uint16_t)pid
+{
+    NSData *packetData;
+    if (_remap[pid] == pid) {
+        packetData = [NSData dataWithBytesNoCopy:(void *)packet length:TS_PACKET_SIZE_188 freeWhenDone:NO];
+    } else {
+        NSMutableData *remapped = [NSMutableData dataWithBytes:packet length:TS_PACKET_SIZE_188];
+        remapPidField((uint8_t *)remapped.mutableBytes + 1, _remap);
+        packetData = remapped;
+    }
+    [self.delegate programExtractor:self didOutputTsPacketData:packetData];
+}
+
+-(void)emitPsiPayload:(NSData *)payload track:(TSElementaryStream *)track
+{
+    [TSPacket packetizePayload:payload
+                         track:track
+                       pcrBase:kNoPcr
+                        pcrExt:0
+             discontinuityFlag:NO
+              randomAccessFlag:NO
+                onTsPacketData:^(NSData *tsPacketData, uint16_t pid, uint8_t cc) {
+        [self.delegate programExtractor:self didOutputTsPacketData:tsPacketData];
+    }];
+}
+
+/// Emits the PMT section with PCR and ES PIDs remapped. Descriptors are copied verbatim.
+-(void)emitRewrittenPmt:(TSProgramMapTable *)pmt pid:(uint16_t)pid
+{
+    NSMutableData *section = [pmt.psi.sectionDataExcludingCrc mutableCopy];
+    uint8_t *bytes = section.mutableBytes;
+    const NSUInteger length = section.length;
+
+    // program_number(2) version(1) section_number(1) last_section_number(1) PCR_PID(2) program_info_length(2)
+    if (length < 9) {
+        return;
+    }
+    remapPidField(bytes + 5, _remap);
+    NSUInteger offset = 9 + (((bytes[7] & 0x0F) << 8) | bytes[8]);
+    // stream_type(1) elementary_PID(2) ES_info_length(2)
+    while (offset + 5 <= length) {
+        remapPidField(bytes + offset + 1, _remap);
+        offset += 5 + (((bytes[offset + 3] & 0x0F) << 8) | bytes[offset + 4]);
+    }
+
+    const uint16_t outputPid = _remap[pid];
+    TSElementaryStream *track = _pmtTracks[@(outputPid)];
+    if (!track) {
+        track = [[TSElementaryStream alloc] initWithPid:outputPid streamType:0 descriptors:nil];
+        _pmtTracks[@(outputPid)] = track;
+    }
+    [self emitPsiPayload:[pmt.psi toTsPacketPayload:section] track:track];
+}
+
+#pragma mark - PSI
+
+-(void)addPacket:(const uint8_t *)packet toPsiBuilder:(TSPsiTableBuilder *)builder
+{
+    TSPacket *tsPacket = [TSPacket packetWithTsPacketBytes:packet];
+    if (tsPacket) {
+        [builder addTsPacket:tsPacket];
+    }
+}
+
+-(void)tableBuilder:(TSPsiTableBuilder *)builder didBuildTable:(TSProgramSpecificInformationTable *)table
+{
+    if (builder.pid == PID_PAT && table.tableId == TABLE_ID_PAT) {
+        TSProgramAssociationTable *pat = [[TSProgramAssociationTable alloc] initWithPSI:table];
+        if (pat) {
+            [self handlePat:pat];
+        }
+    } else if (table.tableId == TABLE_ID_PMT) {
+        TSProgramMapTable *pmt = [[TSProgramMapTable alloc] initWithPSI:table];
+        if (pmt) {
+            [self handlePmt:pmt pid:builder.pid];
+        }
+    }
+}
+
+-(void)handlePat:(TSProgramAssociationTable *)pat
+{
+    NSMutableDictionary<ProgramNumber, PmtPid> *selected = [NSMutableDictionary dictionary];
+    for (ProgramNumber programNumber in _programNumbers) {
+        PmtPid pmtPid = pat.programmes[programNumber];
+        if (pmtPid) {
+            selected[programNumber] = pmtPid;
+        }
+    }
+
+    if (![selected isEqualToDictionary:_selectedProgrammes]) {
+        TSLogInfo(@"Extracting programs %@", selected);
+        // Programs that left the PAT or moved their PMT wait for their (new) PMT
+        for (ProgramNumber programNumber in _selectedProgrammes) {
+            if (![selected[programNumber] isEqualToNumber:_selectedProgrammes[programNumber]]) {
+                [_pmts removeObjectForKey:programNumber];
+            }
+        }
+        NSMutableDictionary<Pid, TSPsiTableBuilder*> *pmtBuilders = [NSMutableDictionary dictionary];
+        for (PmtPid pmtPid in selected.allValues) {
+            pmtBuilders[pmtPid] = _pmtBuilders[pmtPid] ?: [[TSPsiTableBuilder alloc] initWithDelegate:self
+                                                                                                  pid:pmtPid.unsignedShortValue];
+        }
+        _pmtBuilders = pmtBuilders;
+        _selectedProgrammes = selected;
+        [self updateForwardPids];
+    }
+
+    // A PMT PID is passed through only if its PMTs need no rewriting and all belong to selected programs
+    TSPidBitmapFill(&_pmtPids, NO);
+    TSPidBitmapFill(&_pmtPassthroughPids, NO);
+    for (PmtPid pmtPid in selected.allValues) {
+        TSPidBitmapAdd(&_pmtPids, pmtPid.unsignedShortValue);
+        if (!_hasRemap) {
+            TSPidBitmapAdd(&_pmtPassthroughPids, pmtPid.unsignedShortValue);
+        }
+    }
+    for (ProgramNumber programNumber in pat.programmes) {
+        if (!selected[programNumber]) {
+            TSPidBitmapRemove(&_pmtPassthroughPids, pat.programmes[programNumber].unsignedShortValue);
+        }
+    }
+
+    NSMutableDictionary<ProgramNumber, PmtPid> *outputProgrammes = [NSMutableDictionary dictionary];
+    for (ProgramNumber programNumber in selected) {
+        outputProgrammes[programNumber] = @(_remap[selected[programNumber].unsignedShortValue]);
+    }
+    if (_outputProgrammes && ![outputProgrammes isEqualToDictionary:_outputProgrammes]) {
+        _patVersion = (_patVersion + 1) % 32;
+    }
+    _outputProgrammes = outputProgrammes;
+
+    TSProgramAssociationTable *outputPat = [[TSProgramAssociationTable alloc] initWithTransportStreamId:pat.transportStreamId
+                                                                                          versionNumber:_patVersion
+                                                                                             programmes:outputProgrammes];
+    [self emitPsiPayload:[outputPat toTsPacketPayload] track:_patTrack];
+}
+
+-(void)handlePmt:(TSProgramMapTable *)pmt pid:(uint16_t)pid
+{
+    ProgramNumber programNumber = @(pmt.programNumber);
+    // The PID may also carry PMTs of programs that are not extracted
+    if (_selectedProgrammes[programNumber].unsignedShortValue != pid) {
+        return;
+    }
+    if (![pmt isEqual:_pmts[programNumber]]) {
+        _pmts[programNumber] = pmt;
+        [self updateForwardPids];
+    }
+    if (!TSPidBitmapContains(&_pmtPassthroughPids, pid)) {
+        [self emitRewrittenPmt:pmt pid:pid];
+    }
+}
+
+-(void)updateForwardPids
+{
+    TSPidBitmapFill(&_forwardPids, NO);
+    for (TSProgramMapTable *pmt in _pmts.allValues) {
+        if (pmt.pcrPid != PID_NULL_PACKET) {
+            TSPidBitmapAdd(&_forwardPids, pmt.pcrPid);
+        }
+        for (TSElementaryStream *es in pmt.elementaryStreams) {
+            TSPidBitmapAdd(&_forwardPids, es.pid);
+        }
+    }
+}
+
+@end
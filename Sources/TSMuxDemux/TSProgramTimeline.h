@@ -0,0 +1,108 @@
+//
+//  TSProgramTimeline.h
+//  TSMuxDemux
+//
+//  Continuous 64-bit timeline of one program's 33-bit PCR/PTS/DTS.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreMedia/CoreMedia.h>
+
+/// Period of the 33-bit 90 kHz timestamps (PCR base, PTS, DTS): about 26.5 hours.
+#define TS_TIMESTAMP_WRAP (1ULL << 33)
+#define TS_TIMESTAMP_HZ 90000
+#define TS_PCR_HZ 27000000
+/// PCRs are at most 100 ms apart (ISO/IEC 13818-1 2.7.2), but lost packets or a stalled input leave
+/// longer gaps in a clock that is still continuous. A step further ahead than this is a jump of the
+/// clock (splice, encoder restart), the same limit as the timeline's.
+#define TS_PCR_MAX_STEP_27MHZ ((int64_t)10 * TS_PCR_HZ)
+
+/// Difference a - b of two 33-bit timestamps, in [-2^32, 2^32), i.e. across a wrap.
+static inline int64_t TSTimestampDelta(uint64_t a, uint64_t b) {
+    const int64_t delta = (int64_t)((a - b) & (TS_TIMESTAMP_WRAP - 1));
+    return delta >= (int64_t)(TS_TIMESTAMP_WRAP / 2) ? delta - (int64_t)TS_TIMESTAMP_WRAP : delta;
+}
+
+/// A numeric CMTime as a 90 kHz timestamp.
+static inline uint64_t TSTimestampFromTime(CMTime time) {
+    return time.timescale == TS_TIMESTAMP_HZ
+        ? (uint64_t)time.value
+        : (uint64_t)CMTimeConvertScale(time, TS_TIMESTAMP_HZ, kCMTimeRoundingMethod_Default).value;
+}
+
+/// The PCRs of one program unwrapped into a 27 MHz count since the first PCR after a discontinuity.
+/// Zeroed = no PCR yet.
+typedef struct {
+    BOOL hasPcr;
+    /// Last PCR, unwrapped.
+    int64_t pcr;
+    /// Last PCR base, as received.
+    uint64_t pcrBase;
+} TSPcrUnwrapper;
+
+/// Returned by TSPcrUnwrapperStep when the PCR does not continue the count.
+#define TS_PCR_UNWRAPPER_RESTART ((int64_t)-1)
+
+/// Ticks from the last PCR to this one, without adding it, or TS_PCR_UNWRAPPER_RESTART for the first
+/// PCR, a discontinuity indicator, or a PCR going back or jumping ahead more than TS_PCR_MAX_STEP_27MHZ.
+static inline int64_t TSPcrUnwrapperStep(const TSPcrUnwrapper *unwrapper, uint64_t pcrBase, uint16_t pcrExt,
+                                         BOOL isDiscontinuous) {
+    if (!unwrapper->hasPcr || isDiscontinuous) {
+        return TS_PCR_UNWRAPPER_RESTART;
+    }
+    const int64_t step = TSTimestampDelta(pcrBase, unwrapper->pcrBase) * 300 + (int64_t)pcrExt - (unwrapper->pcr % 300);
+    return step < 0 || step > TS_PCR_MAX_STEP_27MHZ ? TS_PCR_UNWRAPPER_RESTART : step;
+}
+
+/// Adds a PCR `step` ticks after the last one, as returned by TSPcrUnwrapperStep.
+static inline void TSPcrUnwrapperAdvance(TSPcrUnwrapper *unwrapper, uint64_t pcrBase, int64_t step) {
+    unwrapper->pcr += step;
+    unwrapper->pcrBase = pcrBase;
+}
+
+/// Starts the count again at this PCR.
+static inline void TSPcrUnwrapperRestart(TSPcrUnwrapper *unwrapper, uint64_t pcrBase, uint16_t pcrExt) {
+    unwrapper->hasPcr = YES;
+    unwrapper->pcr = (int64_t)pcrExt;
+    unwrapper->pcrBase = pcrBase;
+}
+
+/// A 33-bit timestamp near the last PCR on the unwrapped count, in 90 kHz ticks.
+static inline int64_t TSPcrUnwrapperTimestampValue(const TSPcrUnwrapper *unwrapper, uint64_t timestamp90kHz) {
+    return unwrapper->pcr / 300 + TSTimestampDelta(timestamp90kHz, unwrapper->pcrBase);
+}
+
+/// Places the 33-bit timestamps of a program on one continuous, 64-bit 90 kHz timeline, shared by
+/// all its elementary streams so they stay aligned.
+///
+/// The timeline is anchored to the PCR when one is received (otherwise to the timestamps themselves)
+/// and starts at the first raw value, so timestamps only differ from the raw ones after a wrap or a
+/// discontinuity. A discontinuity (the discontinuity indicator on the PCR, or a PCR going back or
+/// jumping ahead more than 10 s) starts a new epoch that continues where the previous one ended; timestamps still on
+/// the previous epoch (access units sent before the jump) are placed on it. Without PCR, a jump of
+/// the timestamps of more than 10 s (1 s if the access unit is flagged discontinuous) starts it.
+///
+/// Each call is O(1). Not thread safe: use it on the thread that demuxes.
+@interface TSProgramTimeline : NSObject
+
+/// YES once a PCR has anchored the timeline.
+@property(nonatomic, readonly) BOOL hasPcr;
+/// Number of epochs started after the first.
+@property(nonatomic, readonly) NSUInteger discontinuityCount;
+
+-(void)addPcrBase:(uint64_t)pcrBase isDiscontinuous:(BOOL)isDiscontinuous;
+
+/// Position of a 33-bit PTS/DTS on the timeline, in 90 kHz ticks. `isDiscontinuous` is the
+/// discontinuity indicator of the access unit; only used when the program has no PCR.
+-(int64_t)timelineValueForTimestamp:(uint64_t)timestamp90kHz isDiscontinuous:(BOOL)isDiscontinuous;
+
+/// Position of a 33-bit timestamp relative to the current epoch, without moving the timeline: for
+/// timestamps that are not those of access units, e.g. SCTE-35 splice times, which may lie well ahead.
+/// Before any PCR or timestamp has been received, the raw value.
+-(int64_t)projectedValueForTimestamp:(uint64_t)timestamp90kHz;
+
+/// Continues a timeline built by an earlier pass over the same stream, e.g. from the PCR samples of
+/// a TSRandomAccessIndex when demuxing starts mid-recording: `pcrBase` is at `timelineValue`.
+-(void)resumeAtPcrBase:(uint64_t)pcrBase timelineValue:(int64_t)timelineValue;
+
+@end
@@ -0,0 +1,136 @@
+//
+//  TSProgramTimeline.m
+//  TSMuxDemux
+//
+//  Continuous 64-bit timeline of one program's 33-bit PCR/PTS/DTS.
+//
+
+#import "TSProgramTimeline.h"
+#import "TSLog.h"
+
+// Further than this from the anchor is a jump, not jitter, reordering or PTS-to-PCR delay
+#define MAX_DISTANCE_90KHZ (TS_PCR_MAX_STEP_27MHZ / 300)
+// Without PCR, a flagged discontinuity moving the timestamps further than this starts a new epoch
+#define MAX_FLAGGED_STEP_90KHZ ((int64_t)90000)
+
+/// A raw 33-bit value and its position on the timeline.
+typedef struct {
+    uint64_t raw;
+    int64_t value;
+} TSTimelineAnchor;
+
+@implementation TSProgramTimeline
+{
+    BOOL _hasAnchor;
+    // Last PCR (or, without PCR, the latest timestamp) of the current epoch
+    TSTimelineAnchor _anchor;
+    // Last anchor of the previous epoch, for access units sent before the discontinuity
+    BOOL _hasPreviousAnchor;
+    TSTimelineAnchor _previousAnchor;
+    // Last forward step of the anchor: a new epoch starts this far after the previous one
+    int64_t _lastStep;
+}
+
+-(void)addPcrBase:(uint64_t)pcrBase isDiscontinuous:(BOOL)isDiscontinuous
+{
+    if (!_hasAnchor) {
+        [self startAt:pcrBase];
+        _hasPcr = YES;
+        return;
+    }
+    const int64_t delta = TSTimestampDelta(pcrBase, _anchor.raw);
+    // Before the first PCR the anchor is a timestamp, which may be ahead of the PCR
+    const BOOL isContinuous = !isDiscontinuous && delta <= MAX_DISTANCE_90KHZ && (_hasPcr ? delta >= 0 : delta >= -MAX_DISTANCE_90KHZ);
+    _hasPcr = YES;
+    if (!isContinuous) {
+        [self startEpochAt:pcrBase];
+        return;
+    }
+    [self advanceBy:delta toRaw:pcrBase];
+}
+
+-(int64_t)timelineValueForTimestamp:(uint64_t)timestamp90kHz isDiscontinuous:(BOOL)isDiscontinuous
+{
+    if (!_hasAnchor) {
+        [self startAt:timestamp90kHz];
+        return _anchor.value;
+    }
+    const int64_t delta = TSTimestampDelta(timestamp90kHz, _anchor.raw);
+    if (_hasPcr) {
+        if (llabs(delta) > MAX_DISTANCE_90KHZ && _hasPreviousAnchor) {
+            const int64_t previousDelta = TSTimestampDelta(timestamp90kHz, _previousAnchor.raw);
+            if (llabs(previousDelta) <= MAX_DISTANCE_90KHZ) {
+                return _previousAnchor.value + previousDelta;
+            }
+        }
+        // Far from both epochs there is no better reference than the PCR
+        return _anchor.value + delta;
+    }
+
+    // No PCR: the timestamps are the reference
+    const BOOL isJump = llabs(delta) > MAX_DISTANCE_90KHZ
+        || (isDiscontinuous && llabs(delta) > MAX_FLAGGED_STEP_90KHZ);
+    if (isJump) {
+        if (_hasPreviousAnchor) {
+            // An access unit of another stream sent before the jump
+            const int64_t previousDelta = TSTimestampDelta(timestamp90kHz, _previousAnchor.raw);
+            if (!isDiscontinuous && llabs(previousDelta) <= MAX_DISTANCE_90KHZ) {
+                return _previousAnchor.value + previousDelta;
+            }
+        }
+        [self startEpochAt:timestamp90kHz];
+        return _anchor.value;
+    }
+    const int64_t value = _anchor.value + delta;
+    if (delta > 0) {
+        // Only forwards, so B-frame reordering does not move the anchor back and forth
+        [self advanceBy:delta toRaw:timestamp90kHz];
+    }
+    return value;
+}
+
+-(int64_t)projectedValueForTimestamp:(uint64_t)timestamp90kHz
+{
+    if (!_hasAnchor) {
+        return (int64_t)timestamp90kHz;
+    }
+    return _anchor.value + TSTimestampDelta(timestamp90kHz, _anchor.raw);
+}
+
+-(void)resumeAtPcrBase:(uint64_t)pcrBase timelineValue:(int64_t)timelineValue
+{
+    _hasAnchor = YES;
+    _hasPcr = YES;
+    _anchor = (TSTimelineAnchor){ .raw = pcrBase, .value = timelineValue };
+    _hasPreviousAnchor = NO;
+}
+
+#pragma mark Anchor
+
+-(void)startAt:(uint64_t)raw
+{
+    _hasAnchor = YES;
+    _anchor = (TSTimelineAnchor){ .raw = raw, .value = (int64_t)raw };
+}
+
+-(void)advanceBy:(int64_t)delta toRaw:(uint64_t)raw
+{
+    if (delta > 0) {
+        _lastStep = delta;
+    }
+    _anchor.raw = raw;
+    _anchor.value += delta;
+}
+
+/// Continues the timeline at `raw`, one step after the current anchor.
+-(void)startEpochAt:(uint64_t)raw
+{
+    TSLogDebug(@"Timestamp discontinuity (%lld -> %llu), new epoch at %lld",
+               (long long)_anchor.raw, (unsigned long long)raw, (long long)(_anchor.value + _lastStep));
+    _hasPreviousAnchor = YES;
+    _previousAnchor = _anchor;
+    _anchor = (TSTimelineAnchor){ .raw = raw, .value = _anchor.value + _lastStep };
+    _discontinuityCount++;
+}
+
+@end
@@ -0,0 +1,35 @@
+//
+//  TSReedSolomon.h
+//  TSMuxDemux
+//
+//  RS(204,188) error correction of 204-byte packets.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, TSReedSolomonResult) {
+    TSReedSolomonResultNoErrors,
+    TSReedSolomonResultCorrected,
+    /// More than 8 erroneous bytes. The packet is left unchanged.
+    TSReedSolomonResultUncorrectable,
+};
+
+/// YES if the 16 parity bytes of a 204-byte packet do not match its first 188 bytes.
+///
+/// The code is the DVB RS(204,188): RS(255,239) over GF(2^8) (field polynomial x^8+x^4+x^3+x^2+1),
+/// shortened, computed over the 188 bytes including the 0x47 sync byte. The 16 syndromes are
+/// computed at once as a matrix product, with a table-driven GF multiply of 16 bytes per
+/// instruction (SSSE3 or NEON where available, scalar otherwise).
+FOUNDATION_EXPORT BOOL TSReedSolomonHasErrors204(const uint8_t *packet);
+
+/// Corrects up to 8 erroneous bytes of a 204-byte packet in place (Berlekamp-Massey, Chien search,
+/// Forney). Error-free packets return after the syndrome check. `outCorrectedBytes` is the number of
+/// bytes corrected, parity bytes included.
+FOUNDATION_EXPORT TSReedSolomonResult TSReedSolomonDecode204(uint8_t *packet, NSUInteger * _Nullable outCorrectedBytes);
+
+/// Writes the 16 parity bytes of the first 188 bytes of `packet` to its bytes 188-203.
+FOUNDATION_EXPORT void TSReedSolomonEncode204(uint8_t *packet);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,257 @@
+//
+//  TSReedSolomon.m
+//  TSMuxDemux
+//
+//  RS(204,188) error correction of 204-byte packets.
+//
+
+#import "TSReedSolomon.h"
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define RS_PACKET_SIZE 204
+#define RS_DATA_SIZE 188
+#define RS_PARITY_SIZE 16
+#define RS_MAX_ERRORS 8
+// x^8 + x^4 + x^3 + x^2 + 1
+#define RS_FIELD_POLYNOMIAL 0x11D
+
+static uint8_t sExp[512];
+static uint8_t sLog[256];
+// r·x and r·(x << 4) for x < 16: a product is the XOR of both, looked up by the nibbles of x
+static uint8_t sMulLow[256][16] __attribute__((aligned(16)));
+static uint8_t sMulHigh[256][16] __attribute__((aligned(16)));
+// Column of the syndrome matrix for byte k (the coefficient of x^(203-k)): α^(j·(203-k)) for
+// syndrome j, split into nibbles
+static uint8_t sColumnLow[RS_PACKET_SIZE][RS_PARITY_SIZE] __attribute__((aligned(16)));
+static uint8_t sColumnHigh[RS_PACKET_SIZE][RS_PARITY_SIZE] __attribute__((aligned(16)));
+// Generator polynomial (x - α^0)...(x - α^15), lowest degree first
+static uint8_t sGenerator[RS_PARITY_SIZE + 1];
+
+static inline uint8_t gfMul(uint8_t a, uint8_t b)
+{
+    return (a && b) ? sExp[sLog[a] + sLog[b]] : 0;
+}
+
+static inline uint8_t gfDiv(uint8_t a, uint8_t b)
+{
+    return a ? sExp[sLog[a] + 255 - sLog[b]] : 0;
+}
+
+/// α^e for e >= 0.
+static inline uint8_t gfPow(unsigned e)
+{
+    return sExp[e % 255];
+}
+
+static void initTables(void)
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        unsigned x = 1;
+        for (unsigned i = 0; i < 255; i++) {
+            sExp[i] = (uint8_t)x;
+            sLog[x] = (uint8_t)i;
+            x <<= 1;
+            if (x & 0x100) {
+                x ^= RS_FIELD_POLYNOMIAL;
+            }
+        }
+        for (unsigned i = 255; i < 512; i++) {
+            sExp[i] = sExp[i - 255];
+        }
+        for (unsigned r = 0; r < 256; r++) {
+            for (unsigned n = 0; n < 16; n++) {
+                sMulLow[r][n] = gfMul((uint8_t)r, (uint8_t)n);
+                sMulHigh[r][n] = gfMul((uint8_t)r, (uint8_t)(n << 4));
+            }
+        }
+        for (unsigned k = 0; k < RS_PACKET_SIZE; k++) {
+            for (unsigned j = 0; j < RS_PARITY_SIZE; j++) {
+                const uint8_t c = gfPow(j * (RS_PACKET_SIZE - 1 - k));
+                sColumnLow[k][j] = c & 0x0F;
+                sColumnHigh[k][j] = c >> 4;
+            }
+        }
+        sGenerator[0] = 1;
+        for (unsigned i = 0; i < RS_PARITY_SIZE; i++) {
+            // Multiply by (x + α^i)
+            const uint8_t root = gfPow(i);
+            sGenerator[i + 1] = sGenerator[i];
+            for (unsigned j = i; j > 0; j--) {
+                sGenerator[j] = sGenerator[j - 1] ^ gfMul(sGenerator[j], root);
+            }
+            sGenerator[0] = gfMul(sGenerator[0], root);
+        }
+    });
+}
+
+/// Syndromes S_j = c(α^j), j = 0..15, of the packet as c(x) = Σ packet[k]·x^(203-k).
+/// Returns NO if all are zero, i.e. the packet is a codeword.
+static BOOL computeSyndromes(const uint8_t *packet, uint8_t syndromes[RS_PARITY_SIZE])
+{
+#if defined(__SSSE3__)
+    __m128i acc = _mm_setzero_si128();
+    for (unsigned k = 0; k < RS_PACKET_SIZE; k++) {
+        const uint8_t r = packet[k];
+        const __m128i low = _mm_shuffle_epi8(_mm_load_si128((const __m128i *)sMulLow[r]),
+                                             _mm_load_si128((const __m128i *)sColumnLow[k]));
+        const __m128i high = _mm_shuffle_epi8(_mm_load_si128((const __m128i *)sMulHigh[r]),
+                                              _mm_load_si128((const __m128i *)sColumnHigh[k]));
+        acc = _mm_xor_si128(acc, _mm_xor_si128(low, high));
+    }
+    _mm_storeu_si128((__m128i *)syndromes, acc);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16_t acc = vdupq_n_u8(0);
+    for (unsigned k = 0; k < RS_PACKET_SIZE; k++) {
+        const uint8_t r = packet[k];
+        const uint8x16_t low = vqtbl1q_u8(vld1q_u8(sMulLow[r]), vld1q_u8(sColumnLow[k]));
+        const uint8x16_t high = vqtbl1q_u8(vld1q_u8(sMulHigh[r]), vld1q_u8(sColumnHigh[k]));
+        acc = veorq_u8(acc, veorq_u8(low, high));
+    }
+    vst1q_u8(syndromes, acc);
+    return vmaxvq_u8(acc) != 0;
+#else
+    memset(syndromes, 0, RS_PARITY_SIZE);
+    for (unsigned k = 0; k < RS_PACKET_SIZE; k++) {
+        const uint8_t r = packet[k];
+        if (r == 0) {
+            continue;
+        }
+        for (unsigned j = 0; j < RS_PARITY_SIZE; j++) {
+            syndromes[j] ^= sMulLow[r][sColumnLow[k][j]] ^ sMulHigh[r][sColumnHigh[k][j]];
+        }
+    }
+    uint8_t any = 0;
+    for (unsigned j = 0; j < RS_PARITY_SIZE; j++) {
+        any |= syndromes[j];
+    }
+    return any != 0;
+#endif
+}
+
+BOOL TSReedSolomonHasErrors204(const uint8_t *packet)
+{
+    initTables();
+    uint8_t syndromes[RS_PARITY_SIZE];
+    return computeSyndromes(packet, syndromes);
+}
+
+TSReedSolomonResult TSReedSolomonDecode204(uint8_t *packet, NSUInteger *outCorrectedBytes)
+{
+    initTables();
+    if (outCorrectedBytes) {
+        *outCorrectedBytes = 0;
+    }
+    uint8_t s[RS_PARITY_SIZE];
+    if (!computeSyndromes(packet, s)) {
+        return TSReedSolomonResultNoErrors;
+    }
+
+    // Berlekamp-Massey: error locator Λ(x), whose roots are the inverse error locations
+    uint8_t lambda[RS_PARITY_SIZE + 1] = { 1 };
+    uint8_t previous[RS_PARITY_SIZE + 1] = { 1 };
+    uint8_t saved[RS_PARITY_SIZE + 1];
+    unsigned degree = 0;
+    unsigned shift = 1;
+    uint8_t previousDiscrepancy = 1;
+    for (unsigned n = 0; n < RS_PARITY_SIZE; n++) {
+        uint8_t discrepancy = s[n];
+        for (unsigned i = 1; i <= degree; i++) {
+            discrepancy ^= gfMul(lambda[i], s[n - i]);
+        }
+        if (discrepancy == 0) {
+            shift++;
+            continue;
+        }
+        const uint8_t scale = gfDiv(discrepancy, previousDiscrepancy);
+        memcpy(saved, lambda, sizeof(lambda));
+        for (unsigned i = 0; i + shift <= RS_PARITY_SIZE; i++) {
+            lambda[i + shift] ^= gfMul(scale, previous[i]);
+        }
+        if (2 * degree <= n) {
+            degree = n + 1 - degree;
+            memcpy(previous, saved, sizeof(previous));
+            previousDiscrepancy = discrepancy;
+            shift = 1;
+        } else {
+            shift++;
+        }
+    }
+    if (degree > RS_MAX_ERRORS) {
+        return TSReedSolomonResultUncorrectable;
+    }
+
+    // Chien search, over the 204 positions of the shortened code only
+    unsigned positions[RS_MAX_ERRORS];
+    unsigned count = 0;
+    for (unsigned p = 0; p < RS_PACKET_SIZE; p++) {
+        uint8_t sum = 0;
+        for (unsigned i = 0; i <= degree; i++) {
+            sum ^= gfMul(lambda[i], gfPow(i * (255 - p)));
+        }
+        if (sum == 0) {
+            if (count == degree) {
+                return TSReedSolomonResultUncorrectable;
+            }
+            positions[count++] = p;
+        }
+    }
+    if (count != degree) {
+        return TSReedSolomonResultUncorrectable;
+    }
+
+    // Forney, for first consecutive root α^0: e = X·Ω(X^-1) / Λ'(X^-1), with Ω(x) = S(x)Λ(x) mod x^16
+    uint8_t omega[RS_PARITY_SIZE] = { 0 };
+    for (unsigned i = 0; i < RS_PARITY_SIZE; i++) {
+        for (unsigned j = 0; j <= MIN(i, degree); j++) {
+            omega[i] ^= gfMul(lambda[j], s[i - j]);
+        }
+    }
+    uint8_t values[RS_MAX_ERRORS];
+    for (unsigned e = 0; e < count; e++) {
+        const unsigned inverse = 255 - positions[e];
+        uint8_t numerator = 0;
+        for (unsigned i = 0; i < RS_PARITY_SIZE; i++) {
+            numerator ^= gfMul(omega[i], gfPow(i * inverse));
+        }
+        uint8_t denominator = 0;
+        for (unsigned i = 1; i <= degree; i += 2) {
+            denominator ^= gfMul(lambda[i], gfPow((i - 1) * inverse));
+        }
+        if (denominator == 0) {
+            return TSReedSolomonResultUncorrectable;
+        }
+        values[e] = gfMul(gfPow(positions[e]), gfDiv(numerator, denominator));
+    }
+    for (unsigned e = 0; e < count; e++) {
+        packet[RS_PACKET_SIZE - 1 - positions[e]] ^= values[e];
+    }
+    if (outCorrectedBytes) {
+        *outCorrectedBytes = count;
+    }
+    return TSReedSolomonResultCorrected;
+}
+
+void TSReedSolomonEncode204(uint8_t *packet)
+{
+    initTables();
+    // Remainder of data(x)·x^16 / g(x), highest degree first
+    uint8_t parity[RS_PARITY_SIZE] = { 0 };
+    for (unsigned k = 0; k < RS_DATA_SIZE; k++) {
+        const uint8_t feedback = packet[k] ^ parity[0];
+        memmove(parity, parity + 1, RS_PARITY_SIZE - 1);
+        parity[RS_PARITY_SIZE - 1] = 0;
+        if (feedback) {
+            for (unsigned j = 0; j < RS_PARITY_SIZE; j++) {
+                parity[j] ^= gfMul(feedback, sGenerator[RS_PARITY_SIZE - 1 - j]);
+            }
+        }
+    }
+    memcpy(packet + RS_DATA_SIZE, parity, RS_PARITY_SIZE);
+}
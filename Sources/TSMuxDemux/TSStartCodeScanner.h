@@ -0,0 +1,26 @@
+//
+//  TSStartCodeScanner.h
+//  TSMuxDemux
+//
+//  Vectorised scanner for 0x00 0x00 0x01 start code prefixes.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Returns the offset of the first 0x00 0x00 0x01 start code prefix in `bytes`, or NSNotFound.
+///
+/// Used for locating PES and NAL unit boundaries inside payloads. Scans 16 bytes per
+/// iteration using SSE2 or NEON where available, falling back to a scalar loop otherwise.
+/// The returned offset points at the first 0x00 of the prefix; a 4-byte start code
+/// (00 00 00 01) is therefore reported at offset + 1.
+FOUNDATION_EXPORT NSUInteger TSFindStartCode(const uint8_t *bytes, NSUInteger length);
+
+/// Same as `TSFindStartCode()` but starts scanning at `fromOffset`. The returned offset is
+/// relative to `bytes`.
+FOUNDATION_EXPORT NSUInteger TSFindStartCodeFromOffset(const uint8_t *bytes,
+                                                       NSUInteger length,
+                                                       NSUInteger fromOffset);
+
+NS_ASSUME_NONNULL_END
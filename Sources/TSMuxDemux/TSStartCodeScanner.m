@@ -0,0 +1,78 @@
+//
+//  TSStartCodeScanner.m
+//  TSMuxDemux
+//
+//  Vectorised scanner for 0x00 0x00 0x01 start code prefixes.
+//
+
+#import "TSStartCodeScanner.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static inline NSUInteger scanScalar(const uint8_t *bytes, NSUInteger start, NSUInteger length)
+{
+    for (NSUInteger i = start; i + 2 < length; i++) {
+        // Most bytes are non-zero in compressed payloads, so the third byte is the cheapest
+        // rejection: a start code can only be present if bytes[i + 2] <= 1.
+        if (bytes[i + 2] > 1) {
+            i += 2;
+            continue;
+        }
+        if (bytes[i] == 0x00 && bytes[i + 1] == 0x00 && bytes[i + 2] == 0x01) {
+            return i;
+        }
+    }
+    return NSNotFound;
+}
+
+NSUInteger TSFindStartCodeFromOffset(const uint8_t *bytes, NSUInteger length, NSUInteger fromOffset)
+{
+    if (fromOffset >= length || length - fromOffset < 3) {
+        return NSNotFound;
+    }
+
+    NSUInteger i = fromOffset;
+
+#if defined(__SSE2__)
+    // Each iteration tests the 16 candidate positions i..i+15, which needs bytes i..i+17.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    for (; i + 18 <= length; i += 16) {
+        const __m128i b0 = _mm_loadu_si128((const __m128i *)(bytes + i));
+        const __m128i b1 = _mm_loadu_si128((const __m128i *)(bytes + i + 1));
+        const __m128i b2 = _mm_loadu_si128((const __m128i *)(bytes + i + 2));
+        const __m128i hit = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero),
+                                                        _mm_cmpeq_epi8(b1, zero)),
+                                          _mm_cmpeq_epi8(b2, one));
+        const int mask = _mm_movemask_epi8(hit);
+        if (mask != 0) {
+            return i + (NSUInteger)__builtin_ctz((unsigned)mask);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    for (; i + 18 <= length; i += 16) {
+        const uint8x16_t b0 = vld1q_u8(bytes + i);
+        const uint8x16_t b1 = vld1q_u8(bytes + i + 1);
+        const uint8x16_t b2 = vld1q_u8(bytes + i + 2);
+        const uint8x16_t hit = vandq_u8(vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero)),
+                                        vceqq_u8(b2, one));
+        if (vmaxvq_u8(hit) != 0) {
+            // Rare path - locate the exact lane with the scalar scanner.
+            return scanScalar(bytes, i, i + 18);
+        }
+    }
+#endif
+
+    return scanScalar(bytes, i, length);
+}
+
+NSUInteger TSFindStartCode(const uint8_t *bytes, NSUInteger length)
+{
+    return TSFindStartCodeFromOffset(bytes, length, 0);
+}
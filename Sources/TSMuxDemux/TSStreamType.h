@@ -14,6 +14,7 @@
 extern const uint8_t kRawStreamTypeH264;      // 0x1B - ITU-T H.264 / AVC
 extern const uint8_t kRawStreamTypeH265;      // 0x24 - ITU-T H.265 / HEVC
 extern const uint8_t kRawStreamTypeADTSAAC;   // 0x0F - ISO/IEC 13818-7 AAC with ADTS
+extern const uint8_t kRawStreamTypeSCTE35;    // 0x86 - ANSI/SCTE 35 splice info
 
 /// Resolved elementary stream content format, derived from raw PMT stream_type and descriptors.
 /// Identifies what format/codec the stream contains, regardless of signaling method
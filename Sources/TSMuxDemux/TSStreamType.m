@@ -17,6 +17,7 @@
 const uint8_t kRawStreamTypeH264    = 0x1B; // ITU-T H.264 / AVC
 const uint8_t kRawStreamTypeH265    = 0x24; // ITU-T H.265 / HEVC
 const uint8_t kRawStreamTypeADTSAAC = 0x0F; // ISO/IEC 13818-7 AAC with ADTS
+const uint8_t kRawStreamTypeSCTE35  = 0x86; // ANSI/SCTE 35 splice info (user private range)
 
 // ISO/IEC 13818-1 / ITU-T H.222.0 stream types (shared by DVB and ATSC)
 static const uint8_t kRawStreamTypeMPEG2Video   = 0x02; // ISO/IEC 13818-2
@@ -29,9 +30,6 @@ static const uint8_t kRawStreamTypeLATMAAC      = 0x11; // ISO/IEC 14496-3
 static const uint8_t kRawStreamTypeATSC_AC3     = 0x81; // ATSC A/52 Dolby Digital
 static const uint8_t kRawStreamTypeATSC_EAC3    = 0x87; // ATSC A/52 Dolby Digital Plus
 
-// SCTE-35 stream types (user private range)
-static const uint8_t kRawStreamTypeSCTE35       = 0x86; // Splice info
-
 // Registration descriptor format identifiers (SMPTE RA registered)
 static const uint32_t kFormatIdentifierBSSD     = 0x42535344; // ASCII: "BSSD" (AES3/SMPTE 302M)
 
@@ -11,5 +11,16 @@
 // DVB ETSI-EN-300-468 Annex A.2 Selection of character table - Table A.3: Character coding tables
 +(NSString*)dvbStringFromCharData:(NSData*)data;
 
+/// Same as `dvbStringFromCharData:` but decodes straight from the bytes, without an intermediate NSData.
+///
+/// Results are interned in a bounded, thread-safe cache keyed on the raw encoded bytes (including
+/// the character table prefix), so a name that repeats with every SDT/EIT costs a hash and a memcmp.
++(NSString* _Nullable)dvbStringFromBytes:(const uint8_t* _Nullable)bytes length:(NSUInteger)length;
+
+// ATSC A/65 6.10 Multiple String Structure
+/// Returns the first string of the structure, or nil if there is none. Only uncompressed segments
+/// in a Unicode page mode (0x00-0x33) or UTF-16 (0x3F) are decoded; Huffman-compressed segments are skipped.
++(NSString* _Nullable)atscStringFromMultipleStringBytes:(const uint8_t* _Nullable)bytes length:(NSUInteger)length;
+
 
 @end
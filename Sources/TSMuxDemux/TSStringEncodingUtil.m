@@ -4,141 +4,262 @@
 //
 
 #import "TSStringEncodingUtil.h"
-#import "TSBitReader.h"
 #import "TSLog.h"
 #import <CoreFoundation/CoreFoundation.h>
+#import <os/lock.h>
+
+/// Direct-mapped: a colliding string simply replaces the previous occupant of its slot.
+#define STRING_CACHE_SLOT_COUNT 1024
+/// Descriptor text fields are at most 255 bytes; longer input is decoded without caching.
+#define STRING_CACHE_MAX_KEY_LENGTH 255
+
+typedef struct {
+    uint32_t hash;
+    CFDataRef key;      // Raw encoded bytes, retained
+    CFStringRef value;  // Retained
+} TSStringCacheSlot;
+
+static TSStringCacheSlot sStringCache[STRING_CACHE_SLOT_COUNT];
+static os_unfair_lock sStringCacheLock = OS_UNFAIR_LOCK_INIT;
+
+static CFStringEncoding TSDvbStringEncoding(const uint8_t *bytes, NSUInteger length, NSUInteger *ioOffset);
+static CFStringEncoding TSDvbDynamicallySelectedPartISOIEC8859(const uint8_t *bytes, NSUInteger length, NSUInteger *ioOffset);
+
+// FNV-1a
+static inline uint32_t TSStringCacheHash(const uint8_t *bytes, NSUInteger length)
+{
+    uint32_t hash = 2166136261u;
+    for (NSUInteger i = 0; i < length; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
 
 @implementation TSStringEncodingUtil
 
 +(NSString*)dvbStringFromCharData:(NSData*)data
+{
+    return [self dvbStringFromBytes:data.bytes length:data.length];
+}
+
++(NSString* _Nullable)dvbStringFromBytes:(const uint8_t* _Nullable)bytes length:(NSUInteger)length
+{
+    if (!bytes || length == 0) {
+        return @"";
+    }
+    if (length > STRING_CACHE_MAX_KEY_LENGTH) {
+        return [self decodeDvbStringFromBytes:bytes length:length];
+    }
+
+    const uint32_t hash = TSStringCacheHash(bytes, length);
+    TSStringCacheSlot *slot = &sStringCache[hash % STRING_CACHE_SLOT_COUNT];
+
+    os_unfair_lock_lock(&sStringCacheLock);
+    if (slot->key
+        && slot->hash == hash
+        && (NSUInteger)CFDataGetLength(slot->key) == length
+        && memcmp(CFDataGetBytePtr(slot->key), bytes, length) == 0) {
+        NSString *cached = (__bridge NSString *)slot->value;
+        os_unfair_lock_unlock(&sStringCacheLock);
+        return cached;
+    }
+    os_unfair_lock_unlock(&sStringCacheLock);
+
+    NSString *string = [self decodeDvbStringFromBytes:bytes length:length];
+    if (!string) {
+        return nil;
+    }
+
+    CFDataRef key = CFDataCreate(kCFAllocatorDefault, bytes, length);
+    CFStringRef value = CFBridgingRetain(string);
+    os_unfair_lock_lock(&sStringCacheLock);
+    CFDataRef oldKey = slot->key;
+    CFStringRef oldValue = slot->value;
+    slot->hash = hash;
+    slot->key = key;
+    slot->value = value;
+    os_unfair_lock_unlock(&sStringCacheLock);
+    if (oldKey) CFRelease(oldKey);
+    if (oldValue) CFRelease(oldValue);
+
+    return string;
+}
+
++(NSString* _Nullable)decodeDvbStringFromBytes:(const uint8_t*)bytes length:(NSUInteger)length
 {
     NSUInteger payloadOffset = 0;
-    NSNumber *encodingWrapper = [self dvbStringEncoding:data ioOffset:&payloadOffset];
-    NSStringEncoding encoding = encodingWrapper ? [encodingWrapper unsignedIntegerValue] : NSUTF8StringEncoding;
-    if (!encodingWrapper) payloadOffset = 0;
-    return [[NSString alloc] initWithData:[NSData dataWithBytes:data.bytes + payloadOffset
-                                                         length:data.length - payloadOffset]
-                                 encoding:encoding];
+    CFStringEncoding encoding = TSDvbStringEncoding(bytes, length, &payloadOffset);
+    if (encoding == kCFStringEncodingInvalidId) {
+        // No (supported) character table selection - default table.
+        encoding = kCFStringEncodingUTF8;
+        payloadOffset = 0;
+    }
+    if (payloadOffset > length) {
+        payloadOffset = length;
+    }
+    return CFBridgingRelease(CFStringCreateWithBytes(kCFAllocatorDefault,
+                                                     bytes + payloadOffset,
+                                                     (CFIndex)(length - payloadOffset),
+                                                     encoding,
+                                                     false));
 }
 
+#pragma mark - ATSC
 
-+(NSNumber* _Nullable)dvbStringEncoding:(NSData * _Nullable)data
-                               ioOffset:(NSUInteger*)ioOffset
++(NSString* _Nullable)atscStringFromMultipleStringBytes:(const uint8_t* _Nullable)bytes length:(NSUInteger)length
 {
-    if (!data || data.length == 0) {
+    // number_strings:1, then per string ISO_639_language_code:3 + number_segments:1
+    if (!bytes || length < 5 || bytes[0] == 0) {
         return nil;
     }
+    const uint8_t numberSegments = bytes[4];
+    NSMutableString *string = [NSMutableString string];
+    NSUInteger offset = 5;
 
-    TSBitReader reader = TSBitReaderMake(data);
-    uint8_t firstByte = TSBitReaderReadUInt8(&reader);
-    if (reader.error) {
-        TSLogWarn(@"DVB string encoding: failed to read first byte");
-        return nil;
+    for (uint8_t i = 0; i < numberSegments; i++) {
+        // compression_type:1 + mode:1 + number_bytes:1
+        if (offset + 3 > length) {
+            TSLogWarn(@"ATSC multiple string structure truncated in segment %u", i);
+            break;
+        }
+        const uint8_t compressionType = bytes[offset];
+        const uint8_t mode = bytes[offset + 1];
+        const uint8_t numberBytes = bytes[offset + 2];
+        offset += 3;
+        if (offset + numberBytes > length) {
+            TSLogWarn(@"ATSC multiple string structure truncated in segment %u", i);
+            break;
+        }
+        const uint8_t *segment = bytes + offset;
+        offset += numberBytes;
+
+        if (compressionType != 0) {
+            TSLogDebug(@"ATSC string segment with compression type 0x%02X not supported", compressionType);
+            continue;
+        }
+        if (mode == 0x3F) {
+            NSString *utf16 = [[NSString alloc] initWithBytes:segment
+                                                       length:numberBytes & ~1
+                                                     encoding:NSUTF16BigEndianStringEncoding];
+            if (utf16) {
+                [string appendString:utf16];
+            }
+        } else if (mode <= 0x33) {
+            // The mode selects the Unicode page, each byte the character within it.
+            unichar characters[UINT8_MAX];
+            for (uint8_t j = 0; j < numberBytes; j++) {
+                characters[j] = (unichar)((mode << 8) | segment[j]);
+            }
+            [string appendString:[NSString stringWithCharacters:characters length:numberBytes]];
+        } else {
+            TSLogDebug(@"ATSC string segment with mode 0x%02X not supported", mode);
+        }
+    }
+    return string;
+}
+
+@end
+
+static CFStringEncoding TSDvbStringEncoding(const uint8_t *bytes, NSUInteger length, NSUInteger *ioOffset)
+{
+    if (!bytes || length == 0) {
+        return kCFStringEncodingInvalidId;
     }
 
+    const uint8_t firstByte = bytes[0];
     *ioOffset += 1;
 
     switch (firstByte) {
         case 0x01:// ISO/IEC 8859-5
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinCyrillic));
+            return kCFStringEncodingISOLatinCyrillic;
         case 0x02:// ISO/IEC 8859-6
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinArabic));
+            return kCFStringEncodingISOLatinArabic;
         case 0x03:// ISO/IEC 8859-7
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinGreek));
+            return kCFStringEncodingISOLatinGreek;
         case 0x04:// ISO/IEC 8859-8
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinHebrew));
+            return kCFStringEncodingISOLatinHebrew;
         case 0x05:// ISO/IEC 8859-9
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin5));
+            return kCFStringEncodingISOLatin5;
         case 0x06:// ISO/IEC 8859-10
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin6));
+            return kCFStringEncodingISOLatin6;
         case 0x07:// ISO/IEC 8859-11
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinThai));
+            return kCFStringEncodingISOLatinThai;
         case 0x08: // Reserved for future use
-            return nil;
+            return kCFStringEncodingInvalidId;
         case 0x09:// ISO/IEC 8859-13
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin7));
+            return kCFStringEncodingISOLatin7;
         case 0x0A:// ISO/IEC 8859-14
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin8));
+            return kCFStringEncodingISOLatin8;
         case 0x0B:// ISO/IEC 8859-15
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin9));
+            return kCFStringEncodingISOLatin9;
         // 0x0C - 0x0F - reserved for future use
         case 0x10:
-            return [self dynamicallySelectedPartISOIEC8859:data ioOffset:ioOffset];
+            return TSDvbDynamicallySelectedPartISOIEC8859(bytes, length, ioOffset);
         case 0x11: // ISO/IEC 10646
-            return @(NSUTF16StringEncoding);
+            return kCFStringEncodingUnicode;
         case 0x12: // KS X 1001-2014
             // kCFStringEncodingEUC_KR represents the EUC-KR encoding based on KS X 1001.
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingEUC_KR));
+            return kCFStringEncodingEUC_KR;
         case 0x13: // GB-2312-1980
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingGB_2312_80));
+            return kCFStringEncodingGB_2312_80;
         case 0x14: // Big5 subset of ISO/IEC 10646
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingBig5));
+            return kCFStringEncodingBig5;
         case 0x15: // UTF-8 encoding of ISO/IEC 10646
-            return @(NSUTF8StringEncoding);
+            return kCFStringEncodingUTF8;
         
         default:
-            return nil;
+            return kCFStringEncodingInvalidId;
     }
-    
 }
 
 // Table A.4: Character Coding Tables for first byte 0x10
-+ (NSNumber * _Nullable)dynamicallySelectedPartISOIEC8859:(NSData * _Nullable)data
-                                                 ioOffset:(NSUInteger*)ioOffset
+static CFStringEncoding TSDvbDynamicallySelectedPartISOIEC8859(const uint8_t *bytes, NSUInteger length, NSUInteger *ioOffset)
 {
-    if (!data || data.length < 3) {
-        return nil;
-    }
-
-    // Read bytes at offset 1 (first byte was already processed by caller)
-    TSBitReader reader = TSBitReaderMake(data);
-    TSBitReaderSkip(&reader, 1);  // Skip first byte (0x10)
-    uint16_t encodingID = TSBitReaderReadUInt16BE(&reader);
-    if (reader.error) {
+    if (length < 3) {
         TSLogWarn(@"DVB string encoding: failed to read ISO 8859 encoding ID");
-        return nil;
+        return kCFStringEncodingInvalidId;
     }
 
+    // Bytes 1-2 (first byte 0x10 was already processed by caller)
+    const uint16_t encodingID = (bytes[1] << 8) | bytes[2];
     *ioOffset += 2;
     
     switch (encodingID) {
         // 0x0000, 0x0001, 0x0002 --> ISO/IEC 8859-2 (East European)
         case 0x0000: // Reserved
-            return nil;
+            return kCFStringEncodingInvalidId;
         case 0x0001: // ISO/IEC 8859-1
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin1));
+            return kCFStringEncodingISOLatin1;
         case 0x0002: // ISO/IEC 8859-2
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin2));
+            return kCFStringEncodingISOLatin2;
         case 0x0003: // ISO/IEC 8859-3
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin3));
+            return kCFStringEncodingISOLatin3;
         case 0x0004: // ISO/IEC 8859-4
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin4));
+            return kCFStringEncodingISOLatin4;
         case 0x0005: // ISO/IEC 8859-5
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinCyrillic));
+            return kCFStringEncodingISOLatinCyrillic;
         case 0x0006: // ISO/IEC 8859-6
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinArabic));
+            return kCFStringEncodingISOLatinArabic;
         case 0x0007: // ISO/IEC 8859-7
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinGreek));
+            return kCFStringEncodingISOLatinGreek;
         case 0x0008: // ISO/IEC 8859-8
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinHebrew));
+            return kCFStringEncodingISOLatinHebrew;
         case 0x0009: // ISO/IEC 8859-9
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin5));
+            return kCFStringEncodingISOLatin5;
         case 0x000A: // ISO/IEC 8859-10
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin6));
+            return kCFStringEncodingISOLatin6;
         case 0x000B: // ISO/IEC 8859-11
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatinThai));
+            return kCFStringEncodingISOLatinThai;
         case 0x000C: // reserved
-            return nil;
+            return kCFStringEncodingInvalidId;
         case 0x000D: // ISO/IEC 8859-13
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin7));
+            return kCFStringEncodingISOLatin7;
         case 0x000E: // ISO/IEC 8859-14
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin8));
+            return kCFStringEncodingISOLatin8;
         case 0x000F: // ISO/IEC 8859-15
-            return @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin9));
+            return kCFStringEncodingISOLatin9;
         default:
             // Other values (including reserved ones) are not supported
-            return nil;
+            return kCFStringEncodingInvalidId;
     }
 }
-
-@end
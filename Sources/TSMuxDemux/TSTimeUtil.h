@@ -23,4 +23,15 @@
 +(uint64_t)convertTimeToUIntTime:(CMTime)time withNewTimescale:(uint32_t)newTimescale;
 +(CMTime)convertUIntTimeToCMTime:(uint64_t)timeAsUInt withNewTimescale:(uint32_t)newTimescale;
 
+/// DVB UTC_time (EN 300 468 Annex C): 16-bit Modified Julian Date followed by 6 BCD digits (hhmmss).
+/// Returns seconds since 1970-01-01 UTC, or -1 if the field is undefined (all bits set) or not valid BCD.
++(int64_t)unixSecondsFromDvbUtcTime:(const uint8_t * _Nonnull)bytes;
+
+/// 6 BCD digits (hhmmss), e.g. an EIT duration. Returns -1 if not valid BCD.
++(int32_t)secondsFromDvbBcdTime:(const uint8_t * _Nonnull)bytes;
+
+/// ATSC system_time / start_time (A/65 6.1): seconds since the GPS epoch (1980-01-06 00:00:00 UTC).
+/// `gpsUtcOffset` is the leap second count from the STT. Returns seconds since 1970-01-01 UTC.
++(int64_t)unixSecondsFromGpsSeconds:(uint32_t)gpsSeconds gpsUtcOffset:(uint8_t)gpsUtcOffset;
+
 @end
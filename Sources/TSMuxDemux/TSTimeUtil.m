@@ -87,4 +87,48 @@ static const uint64_t ONE_SECOND_NANOS = 1000000000;
     return CMTimeMake(timeAsUInt, newTimescale);
 }
 
+#pragma mark - DVB
+
+static inline int TSBcdByteValue(uint8_t byte)
+{
+    const int high = byte >> 4;
+    const int low = byte & 0x0F;
+    return (high > 9 || low > 9) ? -1 : high * 10 + low;
+}
+
++(int32_t)secondsFromDvbBcdTime:(const uint8_t * _Nonnull)bytes
+{
+    const int hours = TSBcdByteValue(bytes[0]);
+    const int minutes = TSBcdByteValue(bytes[1]);
+    const int seconds = TSBcdByteValue(bytes[2]);
+    if (hours < 0 || minutes < 0 || minutes > 59 || seconds < 0 || seconds > 59) {
+        return -1;
+    }
+    return hours * 3600 + minutes * 60 + seconds;
+}
+
++(int64_t)unixSecondsFromDvbUtcTime:(const uint8_t * _Nonnull)bytes
+{
+    static const uint8_t undefined[5] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    if (memcmp(bytes, undefined, sizeof(undefined)) == 0) {
+        return -1;
+    }
+    const int32_t secondsOfDay = [self secondsFromDvbBcdTime:bytes + 2];
+    if (secondsOfDay < 0 || secondsOfDay >= 86400) {
+        return -1;
+    }
+    // MJD 40587 = 1970-01-01
+    const int64_t mjd = (bytes[0] << 8) | bytes[1];
+    return (mjd - 40587) * 86400 + secondsOfDay;
+}
+
+#pragma mark - ATSC
+
++(int64_t)unixSecondsFromGpsSeconds:(uint32_t)gpsSeconds gpsUtcOffset:(uint8_t)gpsUtcOffset
+{
+    // 1980-01-06 00:00:00 UTC
+    static const int64_t GPS_EPOCH_UNIX_SECONDS = 315964800;
+    return GPS_EPOCH_UNIX_SECONDS + (int64_t)gpsSeconds - gpsUtcOffset;
+}
+
 @end
@@ -0,0 +1,46 @@
+//
+//  TSAtscEventInformationTable.h
+//  TSMuxDemux
+//
+//  ATSC A/65 Event Information Table (EIT-k) - Table ID 0xCB
+//  Carried on the PIDs announced by the MGT, one instance per virtual channel (source_id).
+//
+
+#import <Foundation/Foundation.h>
+
+@class TSProgramSpecificInformationTable;
+@class TSDescriptor;
+
+/// A single event in an EIT instance
+@interface TSAtscEvent : NSObject
+
+@property(nonatomic, readonly) uint16_t eventId;
+/// GPS seconds. Convert with -[TSAtscSystemTimeTable utcDateFromGpsSeconds:].
+@property(nonatomic, readonly) uint32_t startTime;
+@property(nonatomic, readonly) uint32_t lengthInSeconds;
+/// 0 = no ETM, 1 = ETM in the PTC carrying this EIT, 2 = ETM in the PTC of the channel.
+@property(nonatomic, readonly) uint8_t etmLocation;
+/// First string of title_text, or nil if it could not be decoded.
+@property(nonatomic, readonly, nullable) NSString *title;
+/// Decoded on first access.
+@property(nonatomic, readonly, nullable) NSArray<TSDescriptor*> *descriptors;
+
+@end
+
+/// One section of an ATSC EIT instance. Events are decoded one at a time as they are requested.
+/// Equality compares the section bytes.
+@interface TSAtscEventInformationTable : NSObject
+
+@property(nonatomic, readonly, nonnull) TSProgramSpecificInformationTable *psi;
+
+/// Virtual channel (see -[TSAtscVirtualChannel sourceId]).
+@property(nonatomic, readonly) uint16_t sourceId;
+@property(nonatomic, readonly) uint8_t protocolVersion;
+
+@property(nonatomic, readonly, nonnull) NSArray<TSAtscEvent*> *events;
+-(NSUInteger)eventCount;
+-(TSAtscEvent * _Nullable)eventAtIndex:(NSUInteger)index;
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi;
+
+@end
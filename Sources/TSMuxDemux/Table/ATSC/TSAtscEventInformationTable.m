@@ -0,0 +1,208 @@
+//
+//  TSAtscEventInformationTable.m
+//  TSMuxDemux
+//
+//  ATSC A/65 Event Information Table (EIT-k) - Table ID 0xCB
+//
+
+#import "TSAtscEventInformationTable.h"
+#import "../TSProgramSpecificInformationTable.h"
+#import "../TSSectionEntryIndex.h"
+#import "../../Descriptor/TSDescriptor.h"
+#import "../../TSStringEncodingUtil.h"
+#import "../../TSLog.h"
+#import <os/lock.h>
+
+// event_id:2 + start_time:4 + ETM_location/length_in_seconds:3 + title_length:1
+#define EIT_EVENT_HEADER_LENGTH 10
+// Common section bytes + protocol_version + num_events_in_section
+#define EIT_EVENTS_OFFSET 7
+
+#pragma mark - TSAtscEvent
+
+@interface TSAtscEvent()
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range;
+@end
+
+@implementation TSAtscEvent
+{
+    NSData *_sectionData;
+    NSRange _range;
+    os_unfair_lock _lock;
+    BOOL _descriptorsDecoded;
+    NSArray<TSDescriptor*> *_descriptors;
+}
+
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range
+{
+    self = [super init];
+    if (self) {
+        _sectionData = sectionData;
+        _range = range;
+        _lock = OS_UNFAIR_LOCK_INIT;
+
+        const uint8_t *bytes = (const uint8_t *)sectionData.bytes + range.location;
+        _eventId = ((bytes[0] & 0x3F) << 8) | bytes[1];
+        _startTime = ((uint32_t)bytes[2] << 24) | (bytes[3] << 16) | (bytes[4] << 8) | bytes[5];
+        _etmLocation = (bytes[6] >> 4) & 0x03;
+        _lengthInSeconds = ((bytes[6] & 0x0F) << 16) | (bytes[7] << 8) | bytes[8];
+        const uint8_t titleLength = bytes[9];
+        _title = [TSStringEncodingUtil atscStringFromMultipleStringBytes:bytes + EIT_EVENT_HEADER_LENGTH
+                                                                  length:titleLength];
+    }
+    return self;
+}
+
+-(NSArray<TSDescriptor*> *)descriptors
+{
+    os_unfair_lock_lock(&_lock);
+    if (!_descriptorsDecoded) {
+        // The range was validated when indexed: header + title + descriptors_length:2 + descriptors
+        const uint8_t *bytes = (const uint8_t *)_sectionData.bytes + _range.location;
+        const NSUInteger descriptorsOffset = EIT_EVENT_HEADER_LENGTH + bytes[9] + 2;
+        if (_range.length > descriptorsOffset) {
+            _descriptors = [TSDescriptor descriptorsFromLoopBytes:bytes + descriptorsOffset
+                                                           length:_range.length - descriptorsOffset];
+        }
+        _descriptorsDecoded = YES;
+    }
+    NSArray<TSDescriptor*> *descriptors = _descriptors;
+    os_unfair_lock_unlock(&_lock);
+    return descriptors;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) return YES;
+    if (![object isKindOfClass:[TSAtscEvent class]]) return NO;
+    TSAtscEvent *other = (TSAtscEvent *)object;
+    return _range.length == other->_range.length
+        && memcmp((const uint8_t *)_sectionData.bytes + _range.location,
+                  (const uint8_t *)other->_sectionData.bytes + other->_range.location,
+                  _range.length) == 0;
+}
+
+-(NSUInteger)hash
+{
+    return (self.eventId << 16) ^ self.startTime;
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ eventId: %u, start: %u, length: %u, etm: %u, title: %@ }",
+            self.eventId, self.startTime, self.lengthInSeconds, self.etmLocation, self.title];
+}
+
+@end
+
+#pragma mark - TSAtscEventInformationTable
+
+@implementation TSAtscEventInformationTable
+{
+    os_unfair_lock _lock;
+    TSSectionEntryIndex<TSAtscEvent*> *_eventIndex;
+}
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi
+{
+    NSData *data = psi.sectionDataExcludingCrc;
+    if (!data || data.length < EIT_EVENTS_OFFSET) {
+        TSLogWarn(@"ATSC EIT received PSI with insufficient data");
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _psi = psi;
+        _sourceId = [psi byte4And5];
+        _protocolVersion = ((const uint8_t *)data.bytes)[5];
+        _lock = OS_UNFAIR_LOCK_INIT;
+    }
+    return self;
+}
+
+-(TSSectionEntryIndex<TSAtscEvent*> *)eventIndex
+{
+    os_unfair_lock_lock(&_lock);
+    if (!_eventIndex) {
+        _eventIndex = [TSAtscEventInformationTable makeEventIndexWithSectionData:self.psi.sectionDataExcludingCrc];
+    }
+    TSSectionEntryIndex *eventIndex = _eventIndex;
+    os_unfair_lock_unlock(&_lock);
+    return eventIndex;
+}
+
++(TSSectionEntryIndex<TSAtscEvent*> *)makeEventIndexWithSectionData:(NSData *)data
+{
+    NSMutableData *ranges = [NSMutableData data];
+    NSUInteger count = 0;
+    const uint8_t *bytes = data.bytes;
+    const uint8_t numEvents = bytes[6];
+    NSUInteger offset = EIT_EVENTS_OFFSET;
+
+    for (uint8_t i = 0; i < numEvents; i++) {
+        if (offset + EIT_EVENT_HEADER_LENGTH > data.length) {
+            TSLogWarn(@"ATSC EIT: insufficient data for event %u", i);
+            break;
+        }
+        // title_text, then reserved (4) + descriptors_length (12)
+        const NSUInteger descriptorsLengthOffset = offset + EIT_EVENT_HEADER_LENGTH + bytes[offset + 9];
+        if (descriptorsLengthOffset + 2 > data.length) {
+            TSLogWarn(@"ATSC EIT: title truncated for event %u", i);
+            break;
+        }
+        const uint16_t descriptorsLength = ((bytes[descriptorsLengthOffset] & 0x0F) << 8) | bytes[descriptorsLengthOffset + 1];
+        const NSRange range = NSMakeRange(offset, descriptorsLengthOffset + 2 + descriptorsLength - offset);
+        if (NSMaxRange(range) > data.length) {
+            TSLogWarn(@"ATSC EIT: descriptors truncated for event %u", i);
+            break;
+        }
+        [ranges appendBytes:&range length:sizeof(range)];
+        count++;
+        offset = NSMaxRange(range);
+    }
+
+    return [[TSSectionEntryIndex alloc] initWithSectionData:data
+                                                     ranges:ranges.bytes
+                                                      count:count
+                                                    decoder:^id(NSData *sectionData, NSRange range) {
+        return [[TSAtscEvent alloc] initWithSectionData:sectionData range:range];
+    }];
+}
+
+-(NSArray<TSAtscEvent*> *)events
+{
+    return [self.eventIndex allObjects];
+}
+
+-(NSUInteger)eventCount
+{
+    return self.eventIndex.count;
+}
+
+-(TSAtscEvent *)eventAtIndex:(NSUInteger)index
+{
+    TSSectionEntryIndex<TSAtscEvent*> *eventIndex = self.eventIndex;
+    return index < eventIndex.count ? [eventIndex objectAtIndex:index] : nil;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) return YES;
+    if (![object isKindOfClass:[TSAtscEventInformationTable class]]) return NO;
+    TSAtscEventInformationTable *other = (TSAtscEventInformationTable *)object;
+    return [self.psi.sectionDataExcludingCrc isEqualToData:other.psi.sectionDataExcludingCrc];
+}
+
+-(NSUInteger)hash
+{
+    return (self.sourceId << 8) ^ self.psi.sectionNumber;
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ ATSC EIT sourceId: %u, v: %u, section: %u/%u, events: %@ }",
+            self.sourceId, self.psi.versionNumber, self.psi.sectionNumber, self.psi.lastSectionNumber, self.events];
+}
+
+@end
@@ -0,0 +1,30 @@
+//
+//  TSAtscExtendedTextTable.h
+//  TSMuxDemux
+//
+//  ATSC A/65 Extended Text Table (ETT) - Table ID 0xCC
+//  Long descriptions of virtual channels (channel ETT) and events (ETT-k).
+//
+
+#import <Foundation/Foundation.h>
+
+@class TSProgramSpecificInformationTable;
+
+@interface TSAtscExtendedTextTable : NSObject
+
+@property(nonatomic, readonly, nonnull) TSProgramSpecificInformationTable *psi;
+@property(nonatomic, readonly) uint8_t protocolVersion;
+
+/// source_id (16) + event_id (14) + 2 bits, 0b10 for an event and 0b00 for a channel.
+@property(nonatomic, readonly) uint32_t etmId;
+@property(nonatomic, readonly) uint16_t sourceId;
+/// Only meaningful if isEventText.
+@property(nonatomic, readonly) uint16_t eventId;
+@property(nonatomic, readonly) BOOL isEventText;
+
+/// First string of extended_text_message, or nil if it could not be decoded.
+@property(nonatomic, readonly, nullable) NSString *text;
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi;
+
+@end
@@ -0,0 +1,64 @@
+//
+//  TSAtscExtendedTextTable.m
+//  TSMuxDemux
+//
+//  ATSC A/65 Extended Text Table (ETT) - Table ID 0xCC
+//
+
+#import "TSAtscExtendedTextTable.h"
+#import "../TSProgramSpecificInformationTable.h"
+#import "../../TSStringEncodingUtil.h"
+#import "../../TSLog.h"
+
+// Common section bytes + protocol_version:1 + ETM_id:4
+#define ETT_TEXT_OFFSET 10
+
+@implementation TSAtscExtendedTextTable
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi
+{
+    NSData *data = psi.sectionDataExcludingCrc;
+    if (!data || data.length < ETT_TEXT_OFFSET) {
+        TSLogWarn(@"ETT received PSI with insufficient data");
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _psi = psi;
+
+        // Bytes 0-1: ETT_table_id_extension, 2-4: version/section bytes
+        const uint8_t *bytes = data.bytes;
+        _protocolVersion = bytes[5];
+        _etmId = ((uint32_t)bytes[6] << 24) | (bytes[7] << 16) | (bytes[8] << 8) | bytes[9];
+        _sourceId = _etmId >> 16;
+        _eventId = (_etmId >> 2) & 0x3FFF;
+        _isEventText = (_etmId & 0x03) == 0x02;
+        _text = [TSStringEncodingUtil atscStringFromMultipleStringBytes:bytes + ETT_TEXT_OFFSET
+                                                                 length:data.length - ETT_TEXT_OFFSET];
+    }
+    return self;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) return YES;
+    if (![object isKindOfClass:[TSAtscExtendedTextTable class]]) return NO;
+    TSAtscExtendedTextTable *other = (TSAtscExtendedTextTable *)object;
+    return [self.psi.sectionDataExcludingCrc isEqualToData:other.psi.sectionDataExcludingCrc];
+}
+
+-(NSUInteger)hash
+{
+    return self.etmId;
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ ETT sourceId: %u%@, text: %@ }",
+            self.sourceId,
+            self.isEventText ? [NSString stringWithFormat:@", eventId: %u", self.eventId] : @"",
+            self.text];
+}
+
+@end
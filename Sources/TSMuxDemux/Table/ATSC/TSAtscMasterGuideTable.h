@@ -0,0 +1,61 @@
+//
+//  TSAtscMasterGuideTable.h
+//  TSMuxDemux
+//
+//  ATSC A/65 Master Guide Table (MGT) - Table ID 0xC7
+//  Lists the PSIP tables of the transport stream with their PIDs and versions.
+//
+
+#import <Foundation/Foundation.h>
+
+@class TSProgramSpecificInformationTable;
+
+/// MGT table_type values (A/65 Table 6.3)
+typedef NS_ENUM(uint16_t, TSAtscTableType) {
+    TSAtscTableTypeTvctCurrent      = 0x0000,
+    TSAtscTableTypeTvctNext         = 0x0001,
+    TSAtscTableTypeCvctCurrent      = 0x0002,
+    TSAtscTableTypeCvctNext         = 0x0003,
+    TSAtscTableTypeChannelEtt       = 0x0004,
+    TSAtscTableTypeDccsct           = 0x0005,
+    TSAtscTableTypeEitFirst         = 0x0100,   // EIT-0
+    TSAtscTableTypeEitLast          = 0x017F,   // EIT-127
+    TSAtscTableTypeEventEttFirst    = 0x0200,   // ETT-0
+    TSAtscTableTypeEventEttLast     = 0x027F,   // ETT-127
+    TSAtscTableTypeRrtFirst         = 0x0301,   // RRT, rating_region 1
+    TSAtscTableTypeRrtLast          = 0x03FF,   // RRT, rating_region 255
+    TSAtscTableTypeDcctFirst        = 0x1400,
+    TSAtscTableTypeDcctLast         = 0x14FF,
+};
+
+/// One table listed in the MGT
+@interface TSAtscMasterGuideTableEntry : NSObject
+
+@property(nonatomic, readonly) uint16_t tableType;
+@property(nonatomic, readonly) uint16_t pid;
+/// Version of the listed table. For EIT-k and ETT-k, shared by all their instances.
+@property(nonatomic, readonly) uint8_t versionNumber;
+/// Total size in bytes of all sections of the listed table.
+@property(nonatomic, readonly) uint32_t numberBytes;
+
+/// YES for EIT-k, event ETT-k and the channel ETT - the tables carried on PIDs announced by the MGT.
+-(BOOL)isEventOrTextTable;
+
+@end
+
+/// ATSC Master Guide Table. Always carried on the PSIP base PID (0x1FFB), single section.
+/// Equality compares the section bytes.
+@interface TSAtscMasterGuideTable : NSObject
+
+@property(nonatomic, readonly, nonnull) TSProgramSpecificInformationTable *psi;
+@property(nonatomic, readonly) uint8_t protocolVersion;
+@property(nonatomic, readonly, nonnull) NSArray<TSAtscMasterGuideTableEntry*> *entries;
+
+-(TSAtscMasterGuideTableEntry * _Nullable)entryForTableType:(uint16_t)tableType;
+
+/// PIDs carrying EIT-k, event ETT-k or the channel ETT.
+-(NSSet<NSNumber*> * _Nonnull)eventAndTextTablePids;
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi;
+
+@end
@@ -0,0 +1,147 @@
+//
+//  TSAtscMasterGuideTable.m
+//  TSMuxDemux
+//
+//  ATSC A/65 Master Guide Table (MGT) - Table ID 0xC7
+//
+
+#import "TSAtscMasterGuideTable.h"
+#import "../TSProgramSpecificInformationTable.h"
+#import "../../TSLog.h"
+
+// Common section bytes + protocol_version + tables_defined
+#define MGT_TABLES_OFFSET 8
+// table_type:2 + PID:2 + version:1 + number_bytes:4 + table_type_descriptors_length:2
+#define MGT_TABLE_HEADER_LENGTH 11
+
+#pragma mark - TSAtscMasterGuideTableEntry
+
+@implementation TSAtscMasterGuideTableEntry
+
+-(instancetype)initWithBytes:(const uint8_t *)bytes
+{
+    self = [super init];
+    if (self) {
+        _tableType = (bytes[0] << 8) | bytes[1];
+        _pid = ((bytes[2] & 0x1F) << 8) | bytes[3];
+        _versionNumber = bytes[4] & 0x1F;
+        _numberBytes = ((uint32_t)bytes[5] << 24) | (bytes[6] << 16) | (bytes[7] << 8) | bytes[8];
+    }
+    return self;
+}
+
+-(BOOL)isEventOrTextTable
+{
+    return (self.tableType >= TSAtscTableTypeEitFirst && self.tableType <= TSAtscTableTypeEitLast)
+    || (self.tableType >= TSAtscTableTypeEventEttFirst && self.tableType <= TSAtscTableTypeEventEttLast)
+    || self.tableType == TSAtscTableTypeChannelEtt;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) return YES;
+    if (![object isKindOfClass:[TSAtscMasterGuideTableEntry class]]) return NO;
+    TSAtscMasterGuideTableEntry *other = (TSAtscMasterGuideTableEntry *)object;
+    return self.tableType == other.tableType
+        && self.pid == other.pid
+        && self.versionNumber == other.versionNumber
+        && self.numberBytes == other.numberBytes;
+}
+
+-(NSUInteger)hash
+{
+    return (self.tableType << 16) ^ self.pid ^ (self.versionNumber << 13);
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ type: 0x%04X, pid: 0x%04X, v: %u, bytes: %u }",
+            self.tableType, self.pid, self.versionNumber, self.numberBytes];
+}
+
+@end
+
+#pragma mark - TSAtscMasterGuideTable
+
+@implementation TSAtscMasterGuideTable
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi
+{
+    NSData *data = psi.sectionDataExcludingCrc;
+    if (!data || data.length < MGT_TABLES_OFFSET) {
+        TSLogWarn(@"MGT received PSI with insufficient data");
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _psi = psi;
+
+        // sectionDataExcludingCrc layout:
+        // Bytes 0-1: table_id_extension (0x0000)
+        // Byte 2: reserved (2) + version_number (5) + current_next_indicator (1)
+        // Byte 3: section_number
+        // Byte 4: last_section_number
+        // Byte 5: protocol_version
+        // Bytes 6-7: tables_defined
+        // Bytes 8+: table loop, then reserved (4) + descriptors_length (12) + descriptors
+        const uint8_t *bytes = data.bytes;
+        _protocolVersion = bytes[5];
+        const uint16_t tablesDefined = (bytes[6] << 8) | bytes[7];
+
+        NSMutableArray<TSAtscMasterGuideTableEntry*> *entries = [NSMutableArray arrayWithCapacity:tablesDefined];
+        NSUInteger offset = MGT_TABLES_OFFSET;
+        for (uint16_t i = 0; i < tablesDefined; i++) {
+            if (offset + MGT_TABLE_HEADER_LENGTH > data.length) {
+                TSLogWarn(@"MGT: insufficient data for table %u of %u", i, tablesDefined);
+                break;
+            }
+            [entries addObject:[[TSAtscMasterGuideTableEntry alloc] initWithBytes:bytes + offset]];
+            const uint16_t descriptorsLength = ((bytes[offset + 9] & 0x0F) << 8) | bytes[offset + 10];
+            offset += MGT_TABLE_HEADER_LENGTH + descriptorsLength;
+        }
+        _entries = entries;
+    }
+    return self;
+}
+
+-(TSAtscMasterGuideTableEntry * _Nullable)entryForTableType:(uint16_t)tableType
+{
+    for (TSAtscMasterGuideTableEntry *entry in self.entries) {
+        if (entry.tableType == tableType) {
+            return entry;
+        }
+    }
+    return nil;
+}
+
+-(NSSet<NSNumber*> * _Nonnull)eventAndTextTablePids
+{
+    NSMutableSet<NSNumber*> *pids = [NSMutableSet set];
+    for (TSAtscMasterGuideTableEntry *entry in self.entries) {
+        if (entry.isEventOrTextTable) {
+            [pids addObject:@(entry.pid)];
+        }
+    }
+    return pids;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) return YES;
+    if (![object isKindOfClass:[TSAtscMasterGuideTable class]]) return NO;
+    TSAtscMasterGuideTable *other = (TSAtscMasterGuideTable *)object;
+    return [self.psi.sectionDataExcludingCrc isEqualToData:other.psi.sectionDataExcludingCrc];
+}
+
+-(NSUInteger)hash
+{
+    return self.psi.sectionDataExcludingCrc.hash;
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ MGT v: %u, tables: %@ }", self.psi.versionNumber, self.entries];
+}
+
+@end
@@ -0,0 +1,34 @@
+//
+//  TSAtscSystemTimeTable.h
+//  TSMuxDemux
+//
+//  ATSC A/65 System Time Table (STT) - Table ID 0xCD
+//
+
+#import <Foundation/Foundation.h>
+
+@class TSProgramSpecificInformationTable;
+
+/// Current time as broadcast on the PSIP base PID, typically once per second.
+@interface TSAtscSystemTimeTable : NSObject
+
+@property(nonatomic, readonly, nonnull) TSProgramSpecificInformationTable *psi;
+@property(nonatomic, readonly) uint8_t protocolVersion;
+/// Seconds since 1980-01-06 00:00:00 UTC (GPS epoch), leap seconds included.
+@property(nonatomic, readonly) uint32_t systemTime;
+/// Leap seconds between GPS and UTC.
+@property(nonatomic, readonly) uint8_t gpsUtcOffset;
+@property(nonatomic, readonly) BOOL daylightSavingStatus;
+@property(nonatomic, readonly) uint8_t daylightSavingDayOfMonth;
+@property(nonatomic, readonly) uint8_t daylightSavingHour;
+
+/// Seconds since 1970-01-01 UTC.
+-(int64_t)unixSeconds;
+-(NSDate * _Nonnull)utcDate;
+
+/// Converts another GPS time of the same stream (e.g. an EIT start_time) using this table's GPS_UTC_offset.
+-(NSDate * _Nonnull)utcDateFromGpsSeconds:(uint32_t)gpsSeconds;
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi;
+
+@end
@@ -0,0 +1,77 @@
+//
+//  TSAtscSystemTimeTable.m
+//  TSMuxDemux
+//
+//  ATSC A/65 System Time Table (STT) - Table ID 0xCD
+//
+
+#import "TSAtscSystemTimeTable.h"
+#import "../TSProgramSpecificInformationTable.h"
+#import "../../TSTimeUtil.h"
+#import "../../TSLog.h"
+
+// Common section bytes + protocol_version:1 + system_time:4 + GPS_UTC_offset:1 + daylight_saving:2
+#define STT_MIN_LENGTH 13
+
+@implementation TSAtscSystemTimeTable
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi
+{
+    NSData *data = psi.sectionDataExcludingCrc;
+    if (!data || data.length < STT_MIN_LENGTH) {
+        TSLogWarn(@"STT received PSI with insufficient data");
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _psi = psi;
+
+        // Bytes 0-4: common section bytes (table_id_extension 0x0000, version 0, section 0/0)
+        const uint8_t *bytes = data.bytes;
+        _protocolVersion = bytes[5];
+        _systemTime = ((uint32_t)bytes[6] << 24) | (bytes[7] << 16) | (bytes[8] << 8) | bytes[9];
+        _gpsUtcOffset = bytes[10];
+        _daylightSavingStatus = (bytes[11] >> 7) & 0x01;
+        _daylightSavingDayOfMonth = bytes[11] & 0x1F;
+        _daylightSavingHour = bytes[12];
+    }
+    return self;
+}
+
+-(int64_t)unixSeconds
+{
+    return [TSTimeUtil unixSecondsFromGpsSeconds:self.systemTime gpsUtcOffset:self.gpsUtcOffset];
+}
+
+-(NSDate * _Nonnull)utcDate
+{
+    return [NSDate dateWithTimeIntervalSince1970:self.unixSeconds];
+}
+
+-(NSDate * _Nonnull)utcDateFromGpsSeconds:(uint32_t)gpsSeconds
+{
+    return [NSDate dateWithTimeIntervalSince1970:[TSTimeUtil unixSecondsFromGpsSeconds:gpsSeconds
+                                                                          gpsUtcOffset:self.gpsUtcOffset]];
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) return YES;
+    if (![object isKindOfClass:[TSAtscSystemTimeTable class]]) return NO;
+    TSAtscSystemTimeTable *other = (TSAtscSystemTimeTable *)object;
+    return [self.psi.sectionDataExcludingCrc isEqualToData:other.psi.sectionDataExcludingCrc];
+}
+
+-(NSUInteger)hash
+{
+    return self.systemTime;
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ STT %@ (GPS %u, offset %u)%@ }",
+            self.utcDate, self.systemTime, self.gpsUtcOffset, self.daylightSavingStatus ? @" [DST]" : @""];
+}
+
+@end
@@ -51,7 +51,7 @@ typedef NS_ENUM(uint8_t, TSAtscServiceType) {
 /// YES if channel should be hidden from guide
 @property(nonatomic, readonly) BOOL hideGuide;
 
-/// Service location descriptor (provides A/V PID mappings), or nil if not present
+/// Service location descriptor (provides A/V PID mappings), or nil if not present. Decoded on first access.
 @property(nonatomic, readonly, nullable) TSAtscServiceLocationDescriptor *serviceLocation;
 
 /// Formatted channel number string (e.g., "5.1")
@@ -59,7 +59,9 @@ typedef NS_ENUM(uint8_t, TSAtscServiceType) {
 
 @end
 
-/// ATSC Virtual Channel Table - contains channel name/number mappings
+/// ATSC Virtual Channel Table - contains channel name/number mappings.
+/// Channels are located on first access and decoded one at a time as they are requested.
+/// Equality compares the section bytes.
 @interface TSAtscVirtualChannelTable : NSObject
 
 /// The underlying PSI table
@@ -77,7 +79,10 @@ typedef NS_ENUM(uint8_t, TSAtscServiceType) {
 /// Channels in this VCT section
 @property(nonatomic, readonly, nonnull) NSArray<TSAtscVirtualChannel*> *channels;
 
-/// Find channel by program number
+-(NSUInteger)channelCount;
+-(TSAtscVirtualChannel* _Nullable)channelAtIndex:(NSUInteger)index;
+
+/// Find channel by program number. Only the matching channel is decoded.
 -(TSAtscVirtualChannel* _Nullable)channelForProgramNumber:(uint16_t)programNumber;
 
 -(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable* _Nonnull)psi;
@@ -12,23 +12,102 @@
 #import "../../Descriptor/ATSC/TSAtscServiceLocationDescriptor.h"
 #import "../../TSLog.h"
 #import "../../TSBitReader.h"
+#import "../TSSectionEntryIndex.h"
+#import <os/lock.h>
+
+// Fixed part of a channel entry, up to and including descriptors_length.
+#define VCT_CHANNEL_HEADER_LENGTH 32
+// Byte offset of the first channel: common section bytes + protocol_version + num_channels_in_section.
+#define VCT_CHANNELS_OFFSET 7
 
 #pragma mark - TSAtscVirtualChannel
 
 @interface TSAtscVirtualChannel()
-@property(nonatomic, readwrite, nonnull) NSString *shortName;
-@property(nonatomic, readwrite) uint16_t majorChannelNumber;
-@property(nonatomic, readwrite) uint16_t minorChannelNumber;
-@property(nonatomic, readwrite) uint16_t programNumber;
-@property(nonatomic, readwrite) TSAtscServiceType serviceType;
-@property(nonatomic, readwrite) uint16_t sourceId;
-@property(nonatomic, readwrite) BOOL accessControlled;
-@property(nonatomic, readwrite) BOOL hidden;
-@property(nonatomic, readwrite) BOOL hideGuide;
-@property(nonatomic, readwrite, nullable) TSAtscServiceLocationDescriptor *serviceLocation;
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range;
 @end
 
 @implementation TSAtscVirtualChannel
+{
+    NSData *_sectionData;
+    NSRange _range;
+    os_unfair_lock _lock;
+    BOOL _descriptorsDecoded;
+    TSAtscServiceLocationDescriptor *_serviceLocation;
+}
+
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range
+{
+    self = [super init];
+    if (self) {
+        _sectionData = sectionData;
+        _range = range;
+        _lock = OS_UNFAIR_LOCK_INIT;
+
+        TSBitReader reader = TSBitReaderMakeWithBytes((const uint8_t *)sectionData.bytes + range.location,
+                                                      VCT_CHANNEL_HEADER_LENGTH);
+
+        // short_name: 7 x 16-bit UTF-16BE characters (14 bytes)
+        NSData *nameData = TSBitReaderReadData(&reader, 14);
+        NSString *name = [[NSString alloc] initWithData:nameData encoding:NSUTF16BigEndianStringEncoding];
+        // Trim to remove padded null chars, e.g. "XYZ\0\0\0\0" --> "XYZ".
+        _shortName = [name stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"\0"]] ?: @"";
+
+        // 4 bytes containing major/minor channel numbers and modulation
+        // Bits: rrrr(4) + major_channel_number(10) + minor_channel_number(10) + modulation_mode(8)
+        TSBitReaderReadBits(&reader, 4);  // reserved
+        _majorChannelNumber = TSBitReaderReadBits(&reader, 10);
+        _minorChannelNumber = TSBitReaderReadBits(&reader, 10);
+        TSBitReaderReadBits(&reader, 8);  // modulation_mode (unused)
+
+        // carrier_frequency (32 bits) - deprecated, skip
+        TSBitReaderSkip(&reader, 4);
+
+        // channel_TSID (16 bits) - skip
+        TSBitReaderSkip(&reader, 2);
+
+        // program_number (16 bits)
+        _programNumber = TSBitReaderReadUInt16BE(&reader);
+
+        // Flags byte 1: ETM_location (2), access_controlled (1), hidden (1),
+        //               path_select (1), out_of_band (1), hide_guide (1), reserved (1)
+        TSBitReaderReadBits(&reader, 2);  // ETM_location
+        _accessControlled = TSBitReaderReadBits(&reader, 1) != 0;
+        _hidden = TSBitReaderReadBits(&reader, 1) != 0;
+        TSBitReaderReadBits(&reader, 2);  // path_select, out_of_band
+        _hideGuide = TSBitReaderReadBits(&reader, 1) != 0;
+        TSBitReaderReadBits(&reader, 1);  // reserved
+
+        // Flags byte 2: reserved (2), service_type (6)
+        TSBitReaderReadBits(&reader, 2);  // reserved
+        _serviceType = TSBitReaderReadBits(&reader, 6);
+
+        // source_id (16 bits)
+        _sourceId = TSBitReaderReadUInt16BE(&reader);
+    }
+    return self;
+}
+
+-(TSAtscServiceLocationDescriptor *)serviceLocation
+{
+    os_unfair_lock_lock(&_lock);
+    if (!_descriptorsDecoded) {
+        const NSUInteger descriptorsLength = _range.length - VCT_CHANNEL_HEADER_LENGTH;
+        if (descriptorsLength > 0) {
+            const uint8_t *bytes = (const uint8_t *)_sectionData.bytes + _range.location;
+            NSArray<TSDescriptor*> *descriptors = [TSDescriptor descriptorsFromLoopBytes:bytes + VCT_CHANNEL_HEADER_LENGTH
+                                                                                  length:descriptorsLength];
+            for (TSDescriptor *descriptor in descriptors) {
+                if ([descriptor isKindOfClass:[TSAtscServiceLocationDescriptor class]]) {
+                    _serviceLocation = (TSAtscServiceLocationDescriptor *)descriptor;
+                }
+            }
+        }
+        _descriptorsDecoded = YES;
+    }
+    TSAtscServiceLocationDescriptor *serviceLocation = _serviceLocation;
+    os_unfair_lock_unlock(&_lock);
+    return serviceLocation;
+}
 
 -(NSString*)channelNumberString
 {
@@ -40,17 +119,10 @@
     if (self == object) return YES;
     if (![object isKindOfClass:[TSAtscVirtualChannel class]]) return NO;
     TSAtscVirtualChannel *other = (TSAtscVirtualChannel *)object;
-    return self.majorChannelNumber == other.majorChannelNumber
-        && self.minorChannelNumber == other.minorChannelNumber
-        && self.programNumber == other.programNumber
-        && self.sourceId == other.sourceId
-        && self.serviceType == other.serviceType
-        && self.accessControlled == other.accessControlled
-        && self.hidden == other.hidden
-        && self.hideGuide == other.hideGuide
-        && [self.shortName isEqualToString:other.shortName]
-        && (self.serviceLocation == other.serviceLocation ||
-            [self.serviceLocation isEqual:other.serviceLocation]);
+    return _range.length == other->_range.length
+        && memcmp((const uint8_t *)_sectionData.bytes + _range.location,
+                  (const uint8_t *)other->_sectionData.bytes + other->_range.location,
+                  _range.length) == 0;
 }
 
 -(NSUInteger)hash
@@ -77,6 +149,10 @@
 #pragma mark - TSAtscVirtualChannelTable
 
 @implementation TSAtscVirtualChannelTable
+{
+    os_unfair_lock _lock;
+    TSSectionEntryIndex<TSAtscVirtualChannel*> *_channelIndex;
+}
 
 -(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable* _Nonnull)psi
 {
@@ -92,138 +168,92 @@
         _tableId = psi.tableId;
         _isTerrestrial = (psi.tableId == TABLE_ID_ATSC_TVCT);
         _transportStreamId = [psi byte4And5];
+        _lock = OS_UNFAIR_LOCK_INIT;
+    }
+    return self;
+}
 
-        TSBitReader reader = TSBitReaderMake(data);
-
-        // sectionDataExcludingCrc layout:
-        // Bytes 0-1: transport_stream_id (accessed via psi.byte4And5)
-        // Byte 2: reserved (2) + version_number (5) + current_next_indicator (1)
-        // Byte 3: section_number
-        // Byte 4: last_section_number
-        // Byte 5: protocol_version (VCT-specific)
-        // Byte 6: num_channels_in_section
-        // Bytes 7+: channel loop
-
-        // Skip to protocol_version at offset 5
-        TSBitReaderSkip(&reader, 5);
-        if (reader.error) {
-            TSLogWarn(@"VCT: section data truncated before protocol_version");
-            _channels = @[];
-            return self;
-        }
-
-        // protocol_version (8 bits)
-        TSBitReaderReadUInt8(&reader);  // Skip protocol version
-
-        // num_channels_in_section (8 bits)
-        uint8_t numChannels = TSBitReaderReadUInt8(&reader);
-        if (reader.error) {
-            TSLogWarn(@"VCT: section data truncated before num_channels");
-            _channels = @[];
-            return self;
-        }
+-(TSSectionEntryIndex<TSAtscVirtualChannel*> *)channelIndex
+{
+    os_unfair_lock_lock(&_lock);
+    if (!_channelIndex) {
+        _channelIndex = [TSAtscVirtualChannelTable makeChannelIndexWithSectionData:self.psi.sectionDataExcludingCrc];
+    }
+    TSSectionEntryIndex *channelIndex = _channelIndex;
+    os_unfair_lock_unlock(&_lock);
+    return channelIndex;
+}
 
-        NSMutableArray<TSAtscVirtualChannel*> *channels = [NSMutableArray arrayWithCapacity:numChannels];
++(TSSectionEntryIndex<TSAtscVirtualChannel*> *)makeChannelIndexWithSectionData:(NSData *)data
+{
+    // sectionDataExcludingCrc layout:
+    // Bytes 0-1: transport_stream_id (accessed via psi.byte4And5)
+    // Byte 2: reserved (2) + version_number (5) + current_next_indicator (1)
+    // Byte 3: section_number
+    // Byte 4: last_section_number
+    // Byte 5: protocol_version (VCT-specific)
+    // Byte 6: num_channels_in_section
+    // Bytes 7+: channel loop
+    NSMutableData *ranges = [NSMutableData data];
+    NSUInteger count = 0;
+    const uint8_t *bytes = data.bytes;
+
+    if (data.length < VCT_CHANNELS_OFFSET) {
+        TSLogWarn(@"VCT: section data truncated before num_channels");
+    } else {
+        const uint8_t numChannels = bytes[6];
+        NSUInteger offset = VCT_CHANNELS_OFFSET;
 
         for (uint8_t i = 0; i < numChannels; i++) {
-            // Each channel entry is at least 32 bytes (fixed part)
-            if (TSBitReaderRemainingBytes(&reader) < 32) {
+            if (offset + VCT_CHANNEL_HEADER_LENGTH > data.length) {
                 TSLogWarn(@"VCT: insufficient data for channel %u", i);
                 break;
             }
-
-            TSAtscVirtualChannel *channel = [TSAtscVirtualChannel new];
-
-            // short_name: 7 x 16-bit UTF-16BE characters (14 bytes)
-            NSData *nameData = TSBitReaderReadData(&reader, 14);
-            NSString *name = [[NSString alloc] initWithData:nameData encoding:NSUTF16BigEndianStringEncoding];
-            // Trim to remove padded null chars, e.g. "XYZ\0\0\0\0" --> "XYZ".
-            channel.shortName = [name stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"\0"]] ?: @"";
-
-            // 4 bytes containing major/minor channel numbers and modulation
-            // Bits: rrrr(4) + major_channel_number(10) + minor_channel_number(10) + modulation_mode(8)
-            TSBitReaderReadBits(&reader, 4);  // reserved
-            channel.majorChannelNumber = TSBitReaderReadBits(&reader, 10);
-            channel.minorChannelNumber = TSBitReaderReadBits(&reader, 10);
-            TSBitReaderReadBits(&reader, 8);  // modulation_mode (unused)
-
-            // carrier_frequency (32 bits) - deprecated, skip
-            TSBitReaderSkip(&reader, 4);
-
-            // channel_TSID (16 bits) - skip
-            TSBitReaderSkip(&reader, 2);
-
-            // program_number (16 bits)
-            channel.programNumber = TSBitReaderReadUInt16BE(&reader);
-
-            // Flags byte 1: ETM_location (2), access_controlled (1), hidden (1),
-            //               path_select (1), out_of_band (1), hide_guide (1), reserved (1)
-            TSBitReaderReadBits(&reader, 2);  // ETM_location
-            channel.accessControlled = TSBitReaderReadBits(&reader, 1) != 0;
-            channel.hidden = TSBitReaderReadBits(&reader, 1) != 0;
-            TSBitReaderReadBits(&reader, 2);  // path_select, out_of_band
-            channel.hideGuide = TSBitReaderReadBits(&reader, 1) != 0;
-            TSBitReaderReadBits(&reader, 1);  // reserved
-
-            // Flags byte 2: reserved (2), service_type (6)
-            TSBitReaderReadBits(&reader, 2);  // reserved
-            channel.serviceType = TSBitReaderReadBits(&reader, 6);
-
-            // source_id (16 bits)
-            channel.sourceId = TSBitReaderReadUInt16BE(&reader);
-
             // descriptors_length (6 reserved + 10 bits length)
-            TSBitReaderReadBits(&reader, 6);  // reserved
-            uint16_t descriptorsLength = TSBitReaderReadBits(&reader, 10);
-
-            if (reader.error) {
-                TSLogWarn(@"VCT: read error while parsing channel %u", i);
+            const uint16_t descriptorsLength = ((bytes[offset + 30] & 0x03) << 8) | bytes[offset + 31];
+            const NSRange range = NSMakeRange(offset, VCT_CHANNEL_HEADER_LENGTH + descriptorsLength);
+            if (NSMaxRange(range) > data.length) {
+                TSLogWarn(@"VCT: descriptors truncated for channel %u", i);
                 break;
             }
+            [ranges appendBytes:&range length:sizeof(range)];
+            count++;
+            offset = NSMaxRange(range);
+        }
+    }
 
-            // Parse descriptors using a sub-reader
-            if (descriptorsLength > 0 && TSBitReaderRemainingBytes(&reader) >= descriptorsLength) {
-                TSBitReader descReader = TSBitReaderSubReader(&reader, descriptorsLength);
-
-                while (TSBitReaderRemainingBytes(&descReader) >= 2) {
-                    uint8_t descriptorTag = TSBitReaderReadUInt8(&descReader);
-                    uint8_t descriptorLen = TSBitReaderReadUInt8(&descReader);
-
-                    if (descReader.error || TSBitReaderRemainingBytes(&descReader) < descriptorLen) {
-                        TSLogWarn(@"VCT: descriptor truncated for channel %u", i);
-                        break;
-                    }
-
-                    NSData *descriptorPayload = descriptorLen > 0
-                        ? TSBitReaderReadData(&descReader, descriptorLen)
-                        : nil;
-
-                    TSDescriptor *descriptor = [TSDescriptor makeWithTag:descriptorTag
-                                                                  length:descriptorLen
-                                                                    data:descriptorPayload];
+    return [[TSSectionEntryIndex alloc] initWithSectionData:data
+                                                     ranges:ranges.bytes
+                                                      count:count
+                                                    decoder:^id(NSData *sectionData, NSRange range) {
+        return [[TSAtscVirtualChannel alloc] initWithSectionData:sectionData range:range];
+    }];
+}
 
-                    if ([descriptor isKindOfClass:[TSAtscServiceLocationDescriptor class]]) {
-                        channel.serviceLocation = (TSAtscServiceLocationDescriptor *)descriptor;
-                    }
-                }
-            } else if (descriptorsLength > 0) {
-                // Skip remaining if not enough data
-                break;
-            }
+-(NSArray<TSAtscVirtualChannel*> *)channels
+{
+    return [self.channelIndex allObjects];
+}
 
-            [channels addObject:channel];
-        }
+-(NSUInteger)channelCount
+{
+    return self.channelIndex.count;
+}
 
-        _channels = [channels copy];
-    }
-    return self;
+-(TSAtscVirtualChannel*)channelAtIndex:(NSUInteger)index
+{
+    TSSectionEntryIndex<TSAtscVirtualChannel*> *channelIndex = self.channelIndex;
+    return index < channelIndex.count ? [channelIndex objectAtIndex:index] : nil;
 }
 
 -(TSAtscVirtualChannel*)channelForProgramNumber:(uint16_t)programNumber
 {
-    for (TSAtscVirtualChannel *channel in self.channels) {
-        if (channel.programNumber == programNumber) {
-            return channel;
+    // program_number sits at a fixed offset in each channel, so no channel is decoded to find it.
+    TSSectionEntryIndex<TSAtscVirtualChannel*> *channelIndex = self.channelIndex;
+    for (NSUInteger i = 0; i < channelIndex.count; ++i) {
+        const uint8_t *channel = [channelIndex bytesAtIndex:i];
+        if (((channel[24] << 8) | channel[25]) == programNumber) {
+            return [channelIndex objectAtIndex:i];
         }
     }
     return nil;
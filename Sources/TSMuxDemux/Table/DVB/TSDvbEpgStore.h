@@ -0,0 +1,91 @@
+//
+//  TSDvbEpgStore.h
+//  TSMuxDemux
+//
+//  Incremental electronic program guide built from DVB EIT sections.
+//
+
+#import <Foundation/Foundation.h>
+@class TSDvbEpgStore;
+@class TSDvbEventInformationTable;
+
+/// One event of the program guide. A snapshot - later EIT updates do not change it.
+@interface TSDvbEpgEvent : NSObject
+
+@property(nonatomic, readonly) uint16_t originalNetworkId;
+@property(nonatomic, readonly) uint16_t transportStreamId;
+@property(nonatomic, readonly) uint16_t serviceId;
+@property(nonatomic, readonly) uint16_t eventId;
+
+@property(nonatomic, readonly, nonnull) NSDate *startDate;
+/// Seconds. 0 if the EIT left it undefined.
+@property(nonatomic, readonly) NSTimeInterval duration;
+@property(nonatomic, readonly, nonnull) NSDate *endDate;
+@property(nonatomic, readonly) uint8_t runningStatus;
+@property(nonatomic, readonly) BOOL freeCaMode;
+/// YES if the event was last described by the present/following table rather than a schedule.
+@property(nonatomic, readonly) BOOL isPresentFollowing;
+
+/// From the short_event_descriptor. nil if the event has none.
+@property(nonatomic, readonly, nullable) NSString *name;
+@property(nonatomic, readonly, nullable) NSString *text;
+@property(nonatomic, readonly, nullable) NSString *languageCode;
+
+@end
+
+@protocol TSDvbEpgStoreDelegate <NSObject>
+/// Events of the service were added, replaced or removed by an EIT section. Called on the
+/// thread that added the section, after the store has been updated.
+-(void)epgStore:(TSDvbEpgStore * _Nonnull)store didUpdateEventsForServiceId:(uint16_t)serviceId
+transportStreamId:(uint16_t)transportStreamId
+originalNetworkId:(uint16_t)originalNetworkId;
+@end
+
+/// Program guide assembled from EIT present/following and schedule sections.
+///
+/// Each sub-table (service + table_id) remembers its version and which sections it has seen,
+/// so a section repeated by the carousel is skipped after reading its header. A new version
+/// replaces the events of the whole sub-table. Events are kept per service in columns sorted by
+/// start time, with names and texts stored once in a shared string pool, so a week of schedule
+/// for hundreds of services stays small and "what is on at time T" is a binary search.
+///
+/// When present/following and schedule describe the same event, present/following wins. Thread safe.
+@interface TSDvbEpgStore : NSObject
+
+@property(nonatomic, weak, nullable) id<TSDvbEpgStoreDelegate> delegate;
+
+/// ISO 639-2 code (e.g. "eng") of the short_event_descriptor to prefer when an event carries
+/// several languages. If nil, or no descriptor matches, the first one is used. Applies to
+/// sections added after it is set.
+@property(nonatomic, copy, nullable) NSString *preferredLanguageCode;
+
+@property(nonatomic, readonly) NSUInteger eventCount;
+/// Sections ignored because the same version had already been added.
+@property(nonatomic, readonly) NSUInteger skippedSectionCount;
+
+/// Returns YES if the section changed the store.
+-(BOOL)addSection:(TSDvbEventInformationTable * _Nonnull)eit;
+
+/// Event on air at `date`. The service is looked up in the actual transport stream first.
+-(TSDvbEpgEvent * _Nullable)eventForServiceId:(uint16_t)serviceId atDate:(NSDate * _Nonnull)date;
+-(TSDvbEpgEvent * _Nullable)eventForOriginalNetworkId:(uint16_t)originalNetworkId
+                                    transportStreamId:(uint16_t)transportStreamId
+                                            serviceId:(uint16_t)serviceId
+                                               atDate:(NSDate * _Nonnull)date;
+
+/// Events overlapping [fromDate, toDate), ordered by start.
+-(NSArray<TSDvbEpgEvent*> * _Nonnull)eventsForServiceId:(uint16_t)serviceId
+                                               fromDate:(NSDate * _Nonnull)fromDate
+                                                 toDate:(NSDate * _Nonnull)toDate;
+-(NSArray<TSDvbEpgEvent*> * _Nonnull)eventsForOriginalNetworkId:(uint16_t)originalNetworkId
+                                              transportStreamId:(uint16_t)transportStreamId
+                                                      serviceId:(uint16_t)serviceId
+                                                       fromDate:(NSDate * _Nonnull)fromDate
+                                                         toDate:(NSDate * _Nonnull)toDate;
+
+/// Drops events that ended before `date` and the strings only they used.
+-(void)pruneEventsEndingBefore:(NSDate * _Nonnull)date;
+/// Drops all events and forgets all sub-table versions.
+-(void)removeAllEvents;
+
+@end
@@ -0,0 +1,745 @@
+//
+//  TSDvbEpgStore.m
+//  TSMuxDemux
+//
+//  Incremental electronic program guide built from DVB EIT sections.
+//
+
+#import "TSDvbEpgStore.h"
+#import "TSDvbEventInformationTable.h"
+#import "../../TSConstants.h"
+#import "../../Descriptor/TSDescriptor.h"
+#import "../../TSStringEncodingUtil.h"
+#import "../../TSTimeUtil.h"
+#import "../../TSLog.h"
+#import <os/lock.h>
+
+// eventId:2 + startTime:5 + duration:3 + runningStatus/freeCaMode/descriptorsLoopLength:2
+#define EIT_EVENT_HEADER_LENGTH 12
+#define EIT_EVENTS_OFFSET 11
+
+#define EPG_NO_STRING UINT32_MAX
+
+static inline BOOL isPresentFollowingTableId(uint8_t tableId)
+{
+    return tableId == TABLE_ID_DVB_EIT_PF_ACTUAL_TS || tableId == TABLE_ID_DVB_EIT_PF_OTHER_TS;
+}
+
+static inline uint64_t serviceKey(uint16_t onid, uint16_t tsid, uint16_t sid)
+{
+    return ((uint64_t)onid << 32) | ((uint64_t)tsid << 16) | sid;
+}
+
+#pragma mark - TSDvbEpgEvent
+
+@implementation TSDvbEpgEvent
+
+-(instancetype)initWithOriginalNetworkId:(uint16_t)originalNetworkId
+                       transportStreamId:(uint16_t)transportStreamId
+                               serviceId:(uint16_t)serviceId
+                                 eventId:(uint16_t)eventId
+                               startTime:(int64_t)startTime
+                                duration:(int32_t)duration
+                                   flags:(uint8_t)flags
+                      isPresentFollowing:(BOOL)isPresentFollowing
+                                    name:(NSString *)name
+                                    text:(NSString *)text
+                            languageCode:(NSString *)languageCode
+{
+    self = [super init];
+    if (self) {
+        _originalNetworkId = originalNetworkId;
+        _transportStreamId = transportStreamId;
+        _serviceId = serviceId;
+        _eventId = eventId;
+        _startDate = [NSDate dateWithTimeIntervalSince1970:startTime];
+        _duration = MAX(duration, 0);
+        _endDate = [_startDate dateByAddingTimeInterval:_duration];
+        _runningStatus = flags & 0x07;
+        _freeCaMode = (flags >> 3) & 0x01;
+        _isPresentFollowing = isPresentFollowing;
+        _name = name;
+        _text = text;
+        _languageCode = languageCode;
+    }
+    return self;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[TSDvbEpgEvent class]]) {
+        return NO;
+    }
+    TSDvbEpgEvent *other = (TSDvbEpgEvent*)object;
+    return self.originalNetworkId == other.originalNetworkId
+    && self.transportStreamId == other.transportStreamId
+    && self.serviceId == other.serviceId
+    && self.eventId == other.eventId
+    && [self.startDate isEqualToDate:other.startDate]
+    && self.duration == other.duration
+    && self.runningStatus == other.runningStatus
+    && self.freeCaMode == other.freeCaMode
+    && (self.name == other.name || [self.name isEqualToString:other.name])
+    && (self.text == other.text || [self.text isEqualToString:other.text])
+    && (self.languageCode == other.languageCode || [self.languageCode isEqualToString:other.languageCode]);
+}
+
+-(NSUInteger)hash
+{
+    return (self.serviceId << 16) ^ self.eventId ^ (NSUInteger)self.startDate.timeIntervalSince1970;
+}
+
+-(NSString *)description
+{
+    return [NSString stringWithFormat:@"{ serviceId: %hu, eventId: %hu, start: %@, duration: %.0f, name: %@ }",
+            self.serviceId, self.eventId, self.startDate, self.duration, self.name];
+}
+
+@end
+
+#pragma mark - Sub-table state
+
+/// Version and received sections of one sub-table (service + table_id).
+@interface TSDvbEpgSubTable : NSObject
+@property(nonatomic) uint8_t versionNumber;
+@end
+
+@implementation TSDvbEpgSubTable
+{
+    uint64_t _sectionMask[4];
+}
+
+-(BOOL)hasSection:(uint8_t)sectionNumber
+{
+    return (_sectionMask[sectionNumber >> 6] >> (sectionNumber & 63)) & 1;
+}
+
+-(void)addSection:(uint8_t)sectionNumber
+{
+    _sectionMask[sectionNumber >> 6] |= 1ULL << (sectionNumber & 63);
+}
+
+-(void)removeAllSections
+{
+    memset(_sectionMask, 0, sizeof(_sectionMask));
+}
+
+@end
+
+#pragma mark - Per-service columns
+
+/// The events of one service, one column per field, rows sorted by start time. Rows with the same
+/// start are ordered by descending table_id, so a present/following row comes after the schedule
+/// row for the same event.
+@interface TSDvbEpgServiceEvents : NSObject
+{
+@public
+    uint16_t _onid;
+    uint16_t _tsid;
+    uint16_t _sid;
+    BOOL _isActual;
+    NSUInteger _count;
+    // Longest duration stored, bounds how far back a query at time T has to look.
+    int32_t _maxDuration;
+
+    NSMutableData *_starts;     // int64_t, seconds since 1970
+    NSMutableData *_durations;  // int32_t, seconds, -1 = undefined
+    NSMutableData *_eventIds;   // uint16_t
+    NSMutableData *_flags;      // uint8_t, runningStatus | freeCaMode << 3
+    NSMutableData *_sources;    // uint16_t, tableId << 8 | sectionNumber
+    NSMutableData *_names;      // uint32_t, string pool index
+    NSMutableData *_texts;      // uint32_t, string pool index
+    NSMutableData *_languages;  // uint32_t, string pool index
+}
+@end
+
+@implementation TSDvbEpgServiceEvents
+
+-(instancetype)initWithOnid:(uint16_t)onid tsid:(uint16_t)tsid sid:(uint16_t)sid
+{
+    self = [super init];
+    if (self) {
+        _onid = onid;
+        _tsid = tsid;
+        _sid = sid;
+        _starts = [NSMutableData data];
+        _durations = [NSMutableData data];
+        _eventIds = [NSMutableData data];
+        _flags = [NSMutableData data];
+        _sources = [NSMutableData data];
+        _names = [NSMutableData data];
+        _texts = [NSMutableData data];
+        _languages = [NSMutableData data];
+    }
+    return self;
+}
+
+static void insertElement(NSMutableData *column, NSUInteger index, NSUInteger count, const void *value, size_t size)
+{
+    [column increaseLengthBy:size];
+    uint8_t *bytes = column.mutableBytes;
+    memmove(bytes + (index + 1) * size, bytes + index * size, (count - index) * size);
+    memcpy(bytes + index * size, value, size);
+}
+
+static void compactColumn(NSMutableData *column, size_t size, const BOOL *keep, NSUInteger count)
+{
+    uint8_t *bytes = column.mutableBytes;
+    NSUInteger kept = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        if (keep[i]) {
+            if (kept != i) {
+                memcpy(bytes + kept * size, bytes + i * size, size);
+            }
+            kept++;
+        }
+    }
+    column.length = kept * size;
+}
+
+-(void)insertEventId:(uint16_t)eventId
+               start:(int64_t)start
+            duration:(int32_t)duration
+               flags:(uint8_t)flags
+              source:(uint16_t)source
+                name:(uint32_t)name
+                text:(uint32_t)text
+            language:(uint32_t)language
+{
+    // Upper bound of (start ascending, tableId descending)
+    const int64_t *starts = _starts.bytes;
+    const uint16_t *sources = _sources.bytes;
+    const uint8_t tableId = source >> 8;
+    NSUInteger lo = 0, hi = _count;
+    while (lo < hi) {
+        const NSUInteger mid = (lo + hi) / 2;
+        if (starts[mid] < start || (starts[mid] == start && (sources[mid] >> 8) >= tableId)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    insertElement(_starts, lo, _count, &start, sizeof(start));
+    insertElement(_durations, lo, _count, &duration, sizeof(duration));
+    insertElement(_eventIds, lo, _count, &eventId, sizeof(eventId));
+    insertElement(_flags, lo, _count, &flags, sizeof(flags));
+    insertElement(_sources, lo, _count, &source, sizeof(source));
+    insertElement(_names, lo, _count, &name, sizeof(name));
+    insertElement(_texts, lo, _count, &text, sizeof(text));
+    insertElement(_languages, lo, _count, &language, sizeof(language));
+    _count++;
+    _maxDuration = MAX(_maxDuration, duration);
+}
+
+/// Removes the rows for which `keep` is NO. Returns the number of rows removed.
+-(NSUInteger)removeRowsKeeping:(const BOOL *)keep
+{
+    const NSUInteger count = _count;
+    compactColumn(_starts, sizeof(int64_t), keep, count);
+    compactColumn(_durations, sizeof(int32_t), keep, count);
+    compactColumn(_eventIds, sizeof(uint16_t), keep, count);
+    compactColumn(_flags, sizeof(uint8_t), keep, count);
+    compactColumn(_sources, sizeof(uint16_t), keep, count);
+    compactColumn(_names, sizeof(uint32_t), keep, count);
+    compactColumn(_texts, sizeof(uint32_t), keep, count);
+    compactColumn(_languages, sizeof(uint32_t), keep, count);
+    _count = _starts.length / sizeof(int64_t);
+    return count - _count;
+}
+
+/// Removes all rows of a sub-table.
+-(NSUInteger)removeRowsOfTableId:(uint8_t)tableId
+{
+    if (_count == 0) {
+        return 0;
+    }
+    const uint16_t *sources = _sources.bytes;
+    BOOL *keep = malloc(_count * sizeof(BOOL));
+    BOOL any = NO;
+    for (NSUInteger i = 0; i < _count; i++) {
+        const BOOL match = (sources[i] >> 8) == tableId;
+        keep[i] = !match;
+        any |= match;
+    }
+    const NSUInteger removed = any ? [self removeRowsKeeping:keep] : 0;
+    free(keep);
+    return removed;
+}
+
+/// Row on air at `t`, or NSNotFound.
+-(NSUInteger)rowAtTime:(int64_t)t
+{
+    const int64_t *starts = _starts.bytes;
+    const int32_t *durations = _durations.bytes;
+
+    // First row starting after t
+    NSUInteger lo = 0, hi = _count;
+    while (lo < hi) {
+        const NSUInteger mid = (lo + hi) / 2;
+        if (starts[mid] <= t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (NSUInteger i = lo; i > 0; i--) {
+        const NSUInteger row = i - 1;
+        if (starts[row] < t - _maxDuration) {
+            break;
+        }
+        if (durations[row] > 0 && starts[row] + durations[row] > t) {
+            return row;
+        }
+    }
+    return NSNotFound;
+}
+
+/// First row that may overlap `t`, i.e. the first row starting at or after t - maxDuration.
+-(NSUInteger)firstRowOverlappingTime:(int64_t)t
+{
+    const int64_t *starts = _starts.bytes;
+    const int64_t from = t - _maxDuration;
+    NSUInteger lo = 0, hi = _count;
+    while (lo < hi) {
+        const NSUInteger mid = (lo + hi) / 2;
+        if (starts[mid] < from) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+@end
+
+#pragma mark - TSDvbEpgStore
+
+@implementation TSDvbEpgStore
+{
+    os_unfair_lock _lock;
+    NSMutableDictionary<NSNumber*, TSDvbEpgServiceEvents*> *_services;
+    // Key: serviceKey << 8 | tableId
+    NSMutableDictionary<NSNumber*, TSDvbEpgSubTable*> *_subTables;
+
+    // String pool shared by all services. Names and texts repeat across events and services.
+    NSMutableArray<NSString*> *_strings;
+    NSMutableDictionary<NSString*, NSNumber*> *_stringIndexes;
+
+    uint32_t _preferredLanguage;
+}
+
+-(instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _services = [NSMutableDictionary dictionary];
+        _subTables = [NSMutableDictionary dictionary];
+        _strings = [NSMutableArray array];
+        _stringIndexes = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+-(void)setPreferredLanguageCode:(NSString *)preferredLanguageCode
+{
+    os_unfair_lock_lock(&_lock);
+    _preferredLanguageCode = [preferredLanguageCode copy];
+    _preferredLanguage = 0;
+    NSData *ascii = [preferredLanguageCode.lowercaseString dataUsingEncoding:NSASCIIStringEncoding];
+    if (ascii.length == 3) {
+        const uint8_t *b = ascii.bytes;
+        _preferredLanguage = (b[0] << 16) | (b[1] << 8) | b[2];
+    }
+    os_unfair_lock_unlock(&_lock);
+}
+
+-(NSUInteger)eventCount
+{
+    os_unfair_lock_lock(&_lock);
+    NSUInteger count = 0;
+    for (TSDvbEpgServiceEvents *service in _services.objectEnumerator) {
+        count += service->_count;
+    }
+    os_unfair_lock_unlock(&_lock);
+    return count;
+}
+
+#pragma mark Adding sections
+
+-(BOOL)addSection:(TSDvbEventInformationTable * _Nonnull)eit
+{
+    TSProgramSpecificInformationTable *psi = eit.psi;
+    if (!psi.currentNextIndicator) {
+        return NO;
+    }
+    const uint8_t tableId = psi.tableId;
+    const uint8_t version = psi.versionNumber;
+    const uint8_t sectionNumber = psi.sectionNumber;
+    const uint16_t sid = eit.serviceId;
+    const uint16_t tsid = eit.transportStreamId;
+    const uint16_t onid = eit.originalNetworkId;
+    const uint64_t key = serviceKey(onid, tsid, sid);
+
+    os_unfair_lock_lock(&_lock);
+
+    NSNumber *subTableKey = @((key << 8) | tableId);
+    TSDvbEpgSubTable *subTable = _subTables[subTableKey];
+    if (subTable && subTable.versionNumber == version && [subTable hasSection:sectionNumber]) {
+        _skippedSectionCount++;
+        os_unfair_lock_unlock(&_lock);
+        return NO;
+    }
+
+    TSDvbEpgServiceEvents *service = _services[@(key)];
+    if (!service) {
+        service = [[TSDvbEpgServiceEvents alloc] initWithOnid:onid tsid:tsid sid:sid];
+        _services[@(key)] = service;
+    }
+    service->_isActual |= eit.isActualTransportStream;
+
+    NSUInteger removed = 0;
+    if (!subTable) {
+        subTable = [TSDvbEpgSubTable new];
+        subTable.versionNumber = version;
+        _subTables[subTableKey] = subTable;
+    } else if (subTable.versionNumber != version) {
+        // The events of the previous version are stale, including sections not yet repeated.
+        removed = [service removeRowsOfTableId:tableId];
+        [subTable removeAllSections];
+        subTable.versionNumber = version;
+    }
+    [subTable addSection:sectionNumber];
+
+    const NSUInteger added = [self addEventsOfSection:psi.sectionDataExcludingCrc
+                                              tableId:tableId
+                                        sectionNumber:sectionNumber
+                                            toService:service];
+    os_unfair_lock_unlock(&_lock);
+
+    if (removed == 0 && added == 0) {
+        return NO;
+    }
+    [self.delegate epgStore:self didUpdateEventsForServiceId:sid transportStreamId:tsid originalNetworkId:onid];
+    return YES;
+}
+
+/// Called with the lock held.
+-(NSUInteger)addEventsOfSection:(NSData *)sectionData
+                        tableId:(uint8_t)tableId
+                  sectionNumber:(uint8_t)sectionNumber
+                      toService:(TSDvbEpgServiceEvents *)service
+{
+    const uint8_t *bytes = sectionData.bytes;
+    const NSUInteger length = sectionData.length;
+    const uint16_t source = (tableId << 8) | sectionNumber;
+    NSUInteger added = 0;
+
+    NSUInteger offset = EIT_EVENTS_OFFSET;
+    while (offset + EIT_EVENT_HEADER_LENGTH <= length) {
+        const uint8_t *event = bytes + offset;
+        const uint16_t descriptorsLength = ((event[10] & 0x0F) << 8) | event[11];
+        const NSUInteger descriptorsEnd = MIN(length, offset + EIT_EVENT_HEADER_LENGTH + descriptorsLength);
+
+        const int64_t start = [TSTimeUtil unixSecondsFromDvbUtcTime:event + 2];
+        if (start >= 0) {
+            uint32_t name = EPG_NO_STRING, text = EPG_NO_STRING, language = EPG_NO_STRING;
+            [self readShortEventFrom:event + EIT_EVENT_HEADER_LENGTH
+                                  to:bytes + descriptorsEnd
+                                name:&name
+                                text:&text
+                            language:&language];
+            [service insertEventId:(event[0] << 8) | event[1]
+                             start:start
+                          duration:[TSTimeUtil secondsFromDvbBcdTime:event + 7]
+                             flags:((event[10] >> 5) & 0x07) | (((event[10] >> 4) & 0x01) << 3)
+                            source:source
+                              name:name
+                              text:text
+                          language:language];
+            added++;
+        } else {
+            // NVOD reference events have no start time and nothing to schedule
+            TSLogDebug(@"EIT: skipping event 0x%04X of service %hu without start time",
+                       (event[0] << 8) | event[1], service->_sid);
+        }
+        offset = descriptorsEnd;
+    }
+    return added;
+}
+
+/// Scans the raw descriptor loop for short_event_descriptors, without creating descriptor objects.
+-(void)readShortEventFrom:(const uint8_t *)p
+                       to:(const uint8_t *)end
+                     name:(uint32_t *)outName
+                     text:(uint32_t *)outText
+                 language:(uint32_t *)outLanguage
+{
+    const uint8_t *chosen = NULL;
+    while (p + 2 <= end) {
+        const uint8_t tag = p[0];
+        const uint8_t descriptorLength = p[1];
+        const uint8_t *payload = p + 2;
+        if (payload + descriptorLength > end) {
+            break;
+        }
+        // ISO_639_language_code:3 + event_name_length:1 + text_length:1
+        if (tag == TSDvbDescriptorTagShortEvent && descriptorLength >= 5) {
+            const uint32_t language = ((payload[0] | 0x20) << 16) | ((payload[1] | 0x20) << 8) | (payload[2] | 0x20);
+            if (!chosen || (language == _preferredLanguage && _preferredLanguage != 0)) {
+                chosen = p;
+                if (!_preferredLanguage || language == _preferredLanguage) {
+                    break;
+                }
+            }
+        }
+        p = payload + descriptorLength;
+    }
+    if (!chosen) {
+        return;
+    }
+
+    const uint8_t descriptorLength = chosen[1];
+    const uint8_t *payload = chosen + 2;
+    const uint8_t *payloadEnd = payload + descriptorLength;
+
+    *outLanguage = [self poolString:[[NSString alloc] initWithBytes:payload length:3 encoding:NSISOLatin1StringEncoding]];
+
+    const uint8_t nameLength = payload[3];
+    const uint8_t *name = payload + 4;
+    if (name + nameLength > payloadEnd) {
+        return;
+    }
+    *outName = [self poolString:[TSStringEncodingUtil dvbStringFromBytes:name length:nameLength]];
+
+    if (name + nameLength + 1 > payloadEnd) {
+        return;
+    }
+    const uint8_t textLength = name[nameLength];
+    const uint8_t *text = name + nameLength + 1;
+    if (text + textLength > payloadEnd) {
+        return;
+    }
+    *outText = [self poolString:[TSStringEncodingUtil dvbStringFromBytes:text length:textLength]];
+}
+
+/// Called with the lock held.
+-(uint32_t)poolString:(NSString *)string
+{
+    if (string.length == 0) {
+        return EPG_NO_STRING;
+    }
+    NSNumber *index = _stringIndexes[string];
+    if (index) {
+        return index.unsignedIntValue;
+    }
+    const uint32_t newIndex = (uint32_t)_strings.count;
+    [_strings addObject:string];
+    _stringIndexes[string] = @(newIndex);
+    return newIndex;
+}
+
+#pragma mark Queries
+
+/// Called with the lock held. Prefers the service in the actual transport stream.
+-(TSDvbEpgServiceEvents *)serviceWithId:(uint16_t)serviceId
+{
+    TSDvbEpgServiceEvents *found = nil;
+    for (TSDvbEpgServiceEvents *service in _services.objectEnumerator) {
+        if (service->_sid == serviceId) {
+            if (service->_isActual) {
+                return service;
+            }
+            found = found ?: service;
+        }
+    }
+    return found;
+}
+
+/// Called with the lock held.
+-(TSDvbEpgEvent *)eventAtRow:(NSUInteger)row ofService:(TSDvbEpgServiceEvents *)service
+{
+    const uint32_t name = ((const uint32_t *)service->_names.bytes)[row];
+    const uint32_t text = ((const uint32_t *)service->_texts.bytes)[row];
+    const uint32_t language = ((const uint32_t *)service->_languages.bytes)[row];
+    return [[TSDvbEpgEvent alloc] initWithOriginalNetworkId:service->_onid
+                                          transportStreamId:service->_tsid
+                                                  serviceId:service->_sid
+                                                    eventId:((const uint16_t *)service->_eventIds.bytes)[row]
+                                                  startTime:((const int64_t *)service->_starts.bytes)[row]
+                                                   duration:((const int32_t *)service->_durations.bytes)[row]
+                                                      flags:((const uint8_t *)service->_flags.bytes)[row]
+                                         isPresentFollowing:isPresentFollowingTableId(((const uint16_t *)service->_sources.bytes)[row] >> 8)
+                                                       name:name == EPG_NO_STRING ? nil : _strings[name]
+                                                       text:text == EPG_NO_STRING ? nil : _strings[text]
+                                               languageCode:language == EPG_NO_STRING ? nil : _strings[language]];
+}
+
+/// Called with the lock held.
+-(TSDvbEpgEvent *)eventOfService:(TSDvbEpgServiceEvents *)service atDate:(NSDate *)date
+{
+    if (!service) {
+        return nil;
+    }
+    const NSUInteger row = [service rowAtTime:(int64_t)floor(date.timeIntervalSince1970)];
+    return row == NSNotFound ? nil : [self eventAtRow:row ofService:service];
+}
+
+/// Called with the lock held.
+-(NSArray<TSDvbEpgEvent*> *)eventsOfService:(TSDvbEpgServiceEvents *)service fromDate:(NSDate *)fromDate toDate:(NSDate *)toDate
+{
+    NSMutableArray<TSDvbEpgEvent*> *events = [NSMutableArray array];
+    if (!service) {
+        return events;
+    }
+    const int64_t from = (int64_t)floor(fromDate.timeIntervalSince1970);
+    const int64_t to = (int64_t)ceil(toDate.timeIntervalSince1970);
+    const int64_t *starts = service->_starts.bytes;
+    const int32_t *durations = service->_durations.bytes;
+    const uint16_t *eventIds = service->_eventIds.bytes;
+    const uint16_t *sources = service->_sources.bytes;
+
+    // Event id -> index in `events`, to keep one entry per event (present/following wins)
+    NSMutableDictionary<NSNumber*, NSNumber*> *indexByEventId = [NSMutableDictionary dictionary];
+    for (NSUInteger row = [service firstRowOverlappingTime:from]; row < service->_count && starts[row] < to; row++) {
+        const int64_t end = starts[row] + MAX(durations[row], 0);
+        if (end <= from && !(end == starts[row] && starts[row] >= from)) {
+            continue;
+        }
+        NSNumber *existing = indexByEventId[@(eventIds[row])];
+        if (existing) {
+            if (isPresentFollowingTableId(sources[row] >> 8)) {
+                events[existing.unsignedIntegerValue] = [self eventAtRow:row ofService:service];
+            }
+            continue;
+        }
+        indexByEventId[@(eventIds[row])] = @(events.count);
+        [events addObject:[self eventAtRow:row ofService:service]];
+    }
+    return events;
+}
+
+-(TSDvbEpgEvent * _Nullable)eventForServiceId:(uint16_t)serviceId atDate:(NSDate * _Nonnull)date
+{
+    os_unfair_lock_lock(&_lock);
+    TSDvbEpgEvent *event = [self eventOfService:[self serviceWithId:serviceId] atDate:date];
+    os_unfair_lock_unlock(&_lock);
+    return event;
+}
+
+-(TSDvbEpgEvent * _Nullable)eventForOriginalNetworkId:(uint16_t)originalNetworkId
+                                    transportStreamId:(uint16_t)transportStreamId
+                                            serviceId:(uint16_t)serviceId
+                                               atDate:(NSDate * _Nonnull)date
+{
+    os_unfair_lock_lock(&_lock);
+    TSDvbEpgServiceEvents *service = _services[@(serviceKey(originalNetworkId, transportStreamId, serviceId))];
+    TSDvbEpgEvent *event = [self eventOfService:service atDate:date];
+    os_unfair_lock_unlock(&_lock);
+    return event;
+}
+
+-(NSArray<TSDvbEpgEvent*> * _Nonnull)eventsForServiceId:(uint16_t)serviceId
+                                               fromDate:(NSDate * _Nonnull)fromDate
+                                                 toDate:(NSDate * _Nonnull)toDate
+{
+    os_unfair_lock_lock(&_lock);
+    NSArray<TSDvbEpgEvent*> *events = [self eventsOfService:[self serviceWithId:serviceId] fromDate:fromDate toDate:toDate];
+    os_unfair_lock_unlock(&_lock);
+    return events;
+}
+
+-(NSArray<TSDvbEpgEvent*> * _Nonnull)eventsForOriginalNetworkId:(uint16_t)originalNetworkId
+                                              transportStreamId:(uint16_t)transportStreamId
+                                                      serviceId:(uint16_t)serviceId
+                                                       fromDate:(NSDate * _Nonnull)fromDate
+                                                         toDate:(NSDate * _Nonnull)toDate
+{
+    os_unfair_lock_lock(&_lock);
+    TSDvbEpgServiceEvents *service = _services[@(serviceKey(originalNetworkId, transportStreamId, serviceId))];
+    NSArray<TSDvbEpgEvent*> *events = [self eventsOfService:service fromDate:fromDate toDate:toDate];
+    os_unfair_lock_unlock(&_lock);
+    return events;
+}
+
+#pragma mark Maintenance
+
+-(void)pruneEventsEndingBefore:(NSDate * _Nonnull)date
+{
+    const int64_t t = (int64_t)floor(date.timeIntervalSince1970);
+
+    os_unfair_lock_lock(&_lock);
+    BOOL *used = calloc(MAX(_strings.count, 1), sizeof(BOOL));
+    NSMutableArray<TSDvbEpgServiceEvents*> *emptied = [NSMutableArray array];
+
+    for (TSDvbEpgServiceEvents *service in _services.objectEnumerator) {
+        const int64_t *starts = service->_starts.bytes;
+        const int32_t *durations = service->_durations.bytes;
+        BOOL *keep = malloc(MAX(service->_count, 1) * sizeof(BOOL));
+        for (NSUInteger i = 0; i < service->_count; i++) {
+            keep[i] = starts[i] + MAX(durations[i], 0) >= t;
+        }
+        [service removeRowsKeeping:keep];
+        free(keep);
+
+        if (service->_count == 0) {
+            [emptied addObject:service];
+            continue;
+        }
+        const uint32_t *columns[] = { service->_names.bytes, service->_texts.bytes, service->_languages.bytes };
+        for (int c = 0; c < 3; c++) {
+            for (NSUInteger i = 0; i < service->_count; i++) {
+                if (columns[c][i] != EPG_NO_STRING) {
+                    used[columns[c][i]] = YES;
+                }
+            }
+        }
+    }
+    for (TSDvbEpgServiceEvents *service in emptied) {
+        [_services removeObjectForKey:@(serviceKey(service->_onid, service->_tsid, service->_sid))];
+    }
+
+    // Rebuild the string pool with only the strings still referenced
+    uint32_t *remap = malloc(MAX(_strings.count, 1) * sizeof(uint32_t));
+    NSMutableArray<NSString*> *strings = [NSMutableArray array];
+    [_stringIndexes removeAllObjects];
+    for (NSUInteger i = 0; i < _strings.count; i++) {
+        remap[i] = EPG_NO_STRING;
+        if (used[i]) {
+            remap[i] = (uint32_t)strings.count;
+            _stringIndexes[_strings[i]] = @(strings.count);
+            [strings addObject:_strings[i]];
+        }
+    }
+    _strings = strings;
+    for (TSDvbEpgServiceEvents *service in _services.objectEnumerator) {
+        uint32_t *columns[] = { service->_names.mutableBytes, service->_texts.mutableBytes, service->_languages.mutableBytes };
+        for (int c = 0; c < 3; c++) {
+            for (NSUInteger i = 0; i < service->_count; i++) {
+                if (columns[c][i] != EPG_NO_STRING) {
+                    columns[c][i] = remap[columns[c][i]];
+                }
+            }
+        }
+    }
+    free(remap);
+    free(used);
+    os_unfair_lock_unlock(&_lock);
+}
+
+-(void)removeAllEvents
+{
+    os_unfair_lock_lock(&_lock);
+    [_services removeAllObjects];
+    [_subTables removeAllObjects];
+    [_strings removeAllObjects];
+    [_stringIndexes removeAllObjects];
+    os_unfair_lock_unlock(&_lock);
+}
+
+@end
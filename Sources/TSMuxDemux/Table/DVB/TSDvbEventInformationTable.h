@@ -0,0 +1,53 @@
+//
+//  TSDvbEventInformationTable.h
+//  TSMuxDemux
+//
+//  DVB Event Information Table (EN 300 468 5.2.4), present/following and schedule.
+//
+
+#import "../TSProgramSpecificInformationTable.h"
+#import "../../TSConstants.h"
+@class TSDescriptor;
+
+@interface TSDvbEventInformationEntry : NSObject
+@property(nonatomic, readonly) uint16_t eventId;
+/// Seconds since 1970-01-01 UTC, or -1 if undefined (e.g. an NVOD reference event).
+@property(nonatomic, readonly) int64_t startTime;
+/// Seconds, or -1 if undefined.
+@property(nonatomic, readonly) int32_t duration;
+@property(nonatomic, readonly) uint8_t runningStatus;
+@property(nonatomic, readonly) BOOL freeCaMode;
+/// Decoded on first access.
+@property(nonatomic, readonly) NSArray<TSDescriptor*> * _Nullable descriptors;
+@end
+
+/// One EIT section. Unlike other tables, EIT sections are handled one at a time rather than
+/// aggregated per table, since the sections of many services and segments are interleaved on
+/// PID 0x12. Events are located on first access and decoded as they are requested.
+@interface TSDvbEventInformationTable : NSObject
+
+@property(nonatomic, readonly) TSProgramSpecificInformationTable * _Nonnull psi;
+
+-(uint16_t)serviceId;
+-(uint16_t)transportStreamId;
+-(uint16_t)originalNetworkId;
+-(uint8_t)segmentLastSectionNumber;
+-(uint8_t)lastTableId;
+
+/// Table id 0x4E/0x4F. Otherwise a schedule section (0x50-0x6F).
+-(BOOL)isPresentFollowing;
+/// Describes the actual transport stream (0x4E, 0x50-0x5F), as opposed to another one.
+-(BOOL)isActualTransportStream;
+
+-(NSArray<TSDvbEventInformationEntry*> * _Nonnull)entries;
+-(NSUInteger)entryCount;
+-(TSDvbEventInformationEntry * _Nullable)entryAtIndex:(NSUInteger)index;
+
++(BOOL)isEitTableId:(uint8_t)tableId;
+
+#pragma mark Demuxer
+
+/// Returns nil if the section is too short for the EIT header.
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable* _Nonnull)psi;
+
+@end
@@ -0,0 +1,258 @@
+//
+//  TSDvbEventInformationTable.m
+//  TSMuxDemux
+//
+//  DVB Event Information Table (EN 300 468 5.2.4), present/following and schedule.
+//
+
+#import "TSDvbEventInformationTable.h"
+#import "../TSSectionEntryIndex.h"
+#import "../../Descriptor/TSDescriptor.h"
+#import "../../TSTimeUtil.h"
+#import "../../TSLog.h"
+#import <os/lock.h>
+
+// eventId:2 + startTime:5 + duration:3 + runningStatus/freeCaMode/descriptorsLoopLength:2
+#define EIT_EVENT_HEADER_LENGTH 12
+// serviceId:2 + version:1 + sectionNumber:1 + lastSectionNumber:1 + transportStreamId:2
+// + originalNetworkId:2 + segmentLastSectionNumber:1 + lastTableId:1
+#define EIT_EVENTS_OFFSET 11
+
+@interface TSDvbEventInformationEntry()
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range;
+@end
+
+@implementation TSDvbEventInformationEntry
+{
+    NSData *_sectionData;
+    NSRange _range;
+    os_unfair_lock _lock;
+    BOOL _descriptorsDecoded;
+    NSArray<TSDescriptor*> *_descriptors;
+}
+
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range
+{
+    self = [super init];
+    if (self) {
+        _sectionData = sectionData;
+        _range = range;
+        _lock = OS_UNFAIR_LOCK_INIT;
+
+        const uint8_t *bytes = (const uint8_t *)sectionData.bytes + range.location;
+        _eventId = (bytes[0] << 8) | bytes[1];
+        _startTime = [TSTimeUtil unixSecondsFromDvbUtcTime:bytes + 2];
+        // An all-ones duration is undefined, which is also invalid BCD
+        _duration = [TSTimeUtil secondsFromDvbBcdTime:bytes + 7];
+        _runningStatus = (bytes[10] >> 5) & 0x07;
+        _freeCaMode = (bytes[10] >> 4) & 0x01;
+    }
+    return self;
+}
+
+-(NSArray<TSDescriptor*> * _Nullable)descriptors
+{
+    os_unfair_lock_lock(&_lock);
+    if (!_descriptorsDecoded) {
+        const NSUInteger descriptorsLength = _range.length - EIT_EVENT_HEADER_LENGTH;
+        if (descriptorsLength > 0) {
+            const uint8_t *bytes = (const uint8_t *)_sectionData.bytes + _range.location;
+            _descriptors = [TSDescriptor descriptorsFromLoopBytes:bytes + EIT_EVENT_HEADER_LENGTH
+                                                           length:descriptorsLength];
+        }
+        _descriptorsDecoded = YES;
+    }
+    NSArray<TSDescriptor*> *descriptors = _descriptors;
+    os_unfair_lock_unlock(&_lock);
+    return descriptors;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[TSDvbEventInformationEntry class]]) {
+        return NO;
+    }
+    TSDvbEventInformationEntry *other = (TSDvbEventInformationEntry*)object;
+    return _range.length == other->_range.length
+    && memcmp((const uint8_t *)_sectionData.bytes + _range.location,
+              (const uint8_t *)other->_sectionData.bytes + other->_range.location,
+              _range.length) == 0;
+}
+
+-(NSUInteger)hash
+{
+    return _eventId;
+}
+
+-(NSString *)description
+{
+    return [NSString stringWithFormat:@"{ eventId: %hu, start: %lld, duration: %d, runningStatus: %u, freeCaMode: %hhd, descriptors: %@ }",
+            _eventId,
+            _startTime,
+            _duration,
+            _runningStatus,
+            _freeCaMode,
+            self.descriptors];
+}
+
+@end
+
+@implementation TSDvbEventInformationTable
+{
+    os_unfair_lock _lock;
+    TSSectionEntryIndex<TSDvbEventInformationEntry*> *_entryIndex;
+}
+
++(BOOL)isEitTableId:(uint8_t)tableId
+{
+    return tableId >= TABLE_ID_DVB_EIT_PF_ACTUAL_TS && tableId <= TABLE_ID_DVB_EIT_SCHEDULE_OTHER_TS_LAST;
+}
+
+#pragma mark - Demuxer
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable* _Nonnull)psi
+{
+    if (psi.sectionDataExcludingCrc.length < EIT_EVENTS_OFFSET) {
+        TSLogWarn(@"EIT received PSI with %lu bytes of section data, expected at least %d",
+                  (unsigned long)psi.sectionDataExcludingCrc.length, EIT_EVENTS_OFFSET);
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _psi = psi;
+        _lock = OS_UNFAIR_LOCK_INIT;
+    }
+    return self;
+}
+
+-(uint16_t)serviceId
+{
+    return self.psi.byte4And5;
+}
+
+-(uint16_t)transportStreamId
+{
+    const uint8_t *bytes = self.psi.sectionDataExcludingCrc.bytes;
+    return (bytes[5] << 8) | bytes[6];
+}
+
+-(uint16_t)originalNetworkId
+{
+    const uint8_t *bytes = self.psi.sectionDataExcludingCrc.bytes;
+    return (bytes[7] << 8) | bytes[8];
+}
+
+-(uint8_t)segmentLastSectionNumber
+{
+    return ((const uint8_t *)self.psi.sectionDataExcludingCrc.bytes)[9];
+}
+
+-(uint8_t)lastTableId
+{
+    return ((const uint8_t *)self.psi.sectionDataExcludingCrc.bytes)[10];
+}
+
+-(BOOL)isPresentFollowing
+{
+    return self.psi.tableId == TABLE_ID_DVB_EIT_PF_ACTUAL_TS || self.psi.tableId == TABLE_ID_DVB_EIT_PF_OTHER_TS;
+}
+
+-(BOOL)isActualTransportStream
+{
+    return self.psi.tableId == TABLE_ID_DVB_EIT_PF_ACTUAL_TS
+    || (self.psi.tableId >= TABLE_ID_DVB_EIT_SCHEDULE_ACTUAL_TS_FIRST && self.psi.tableId <= TABLE_ID_DVB_EIT_SCHEDULE_ACTUAL_TS_LAST);
+}
+
+-(TSSectionEntryIndex<TSDvbEventInformationEntry*> *)entryIndex
+{
+    os_unfair_lock_lock(&_lock);
+    if (!_entryIndex) {
+        _entryIndex = [TSDvbEventInformationTable makeEntryIndexWithSectionData:self.psi.sectionDataExcludingCrc];
+    }
+    TSSectionEntryIndex *entryIndex = _entryIndex;
+    os_unfair_lock_unlock(&_lock);
+    return entryIndex;
+}
+
++(TSSectionEntryIndex<TSDvbEventInformationEntry*> *)makeEntryIndexWithSectionData:(NSData *)data
+{
+    NSMutableData *ranges = [NSMutableData data];
+    NSUInteger count = 0;
+    const uint8_t *bytes = data.bytes;
+    NSUInteger offset = EIT_EVENTS_OFFSET;
+
+    while (offset + EIT_EVENT_HEADER_LENGTH <= data.length) {
+        const uint16_t descriptorsLength = ((bytes[offset + 10] & 0x0F) << 8) | bytes[offset + 11];
+        NSRange range = NSMakeRange(offset, EIT_EVENT_HEADER_LENGTH + descriptorsLength);
+        if (NSMaxRange(range) > data.length) {
+            TSLogWarn(@"EIT: descriptors truncated for event 0x%04X", (bytes[offset] << 8) | bytes[offset + 1]);
+            range.length = data.length - offset;
+        }
+        [ranges appendBytes:&range length:sizeof(range)];
+        count++;
+        offset = NSMaxRange(range);
+    }
+
+    return [[TSSectionEntryIndex alloc] initWithSectionData:data
+                                                     ranges:ranges.bytes
+                                                      count:count
+                                                    decoder:^id(NSData *sectionData, NSRange range) {
+        return [[TSDvbEventInformationEntry alloc] initWithSectionData:sectionData range:range];
+    }];
+}
+
+-(NSArray<TSDvbEventInformationEntry*> * _Nonnull)entries
+{
+    return [self.entryIndex allObjects];
+}
+
+-(NSUInteger)entryCount
+{
+    return self.entryIndex.count;
+}
+
+-(TSDvbEventInformationEntry * _Nullable)entryAtIndex:(NSUInteger)index
+{
+    TSSectionEntryIndex<TSDvbEventInformationEntry*> *entryIndex = self.entryIndex;
+    return index < entryIndex.count ? [entryIndex objectAtIndex:index] : nil;
+}
+
+#pragma mark - Overridden
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[TSDvbEventInformationTable class]]) {
+        return NO;
+    }
+    TSDvbEventInformationTable *eit = (TSDvbEventInformationTable*)object;
+    return self.psi.tableId == eit.psi.tableId
+    && [self.psi.sectionDataExcludingCrc isEqualToData:eit.psi.sectionDataExcludingCrc];
+}
+
+-(NSUInteger)hash
+{
+    return self.serviceId ^ (self.psi.tableId << 16) ^ (self.psi.sectionNumber << 24);
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:
+                @"{ tableId: 0x%02X, v: %u, section: %u/%u, serviceId: %hu, tsId: %hu, oni: %hu, events: %@ }",
+            self.psi.tableId,
+            self.psi.versionNumber,
+            self.psi.sectionNumber,
+            self.psi.lastSectionNumber,
+            self.serviceId,
+            self.transportStreamId,
+            self.originalNetworkId,
+            self.entries];
+}
+
+@end
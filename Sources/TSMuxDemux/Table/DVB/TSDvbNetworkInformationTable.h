@@ -0,0 +1,51 @@
+//
+//  TSDvbNetworkInformationTable.h
+//  TSMuxDemux
+//
+//  DVB Network Information Table (EN 300 468 5.2.1): the transport streams of a network.
+//
+
+#import "../TSProgramSpecificInformationTable.h"
+#import "../../TSConstants.h"
+@class TSDescriptor;
+@class TSDvbServiceListEntry;
+@class TSDvbDeliverySystemDescriptor;
+
+@interface TSDvbNetworkTransportStream : NSObject
+@property(nonatomic, readonly) uint16_t transportStreamId;
+@property(nonatomic, readonly) uint16_t originalNetworkId;
+/// Decoded on first access.
+@property(nonatomic, readonly) NSArray<TSDescriptor*> * _Nullable descriptors;
+/// The services listed in the service_list_descriptor(s). Empty if there is none.
+-(NSArray<TSDvbServiceListEntry*> * _Nonnull)services;
+/// The satellite, cable or terrestrial delivery system descriptor, if any.
+-(TSDvbDeliverySystemDescriptor * _Nullable)deliverySystem;
+@end
+
+/// A complete NIT, aggregated from all of its sections. Transport streams are located on first
+/// access and decoded as they are requested. Two tables are equal when their section bytes are.
+@interface TSDvbNetworkInformationTable : NSObject
+
+@property(nonatomic, readonly) TSProgramSpecificInformationTable * _Nonnull psi;
+
+-(uint16_t)networkId;
+/// Table id 0x40, as opposed to 0x41 (NIT of another network).
+-(BOOL)isActualNetwork;
+/// From the network_name_descriptor, nil if there is none.
+-(NSString * _Nullable)networkName;
+-(NSArray<TSDescriptor*> * _Nonnull)networkDescriptors;
+
+-(NSArray<TSDvbNetworkTransportStream*> * _Nonnull)transportStreams;
+-(NSUInteger)transportStreamCount;
+-(TSDvbNetworkTransportStream * _Nullable)transportStreamAtIndex:(NSUInteger)index;
+/// Found by reading ids from the raw entries; only the matching entry is decoded.
+-(TSDvbNetworkTransportStream * _Nullable)transportStreamWithId:(uint16_t)transportStreamId
+                                              originalNetworkId:(uint16_t)originalNetworkId;
+
++(BOOL)isNitTableId:(uint8_t)tableId;
+
+#pragma mark Demuxer
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable* _Nonnull)psi;
+
+@end
@@ -0,0 +1,330 @@
+//
+//  TSDvbNetworkInformationTable.m
+//  TSMuxDemux
+//
+//  DVB Network Information Table (EN 300 468 5.2.1): the transport streams of a network.
+//
+
+#import "TSDvbNetworkInformationTable.h"
+#import "../TSSectionEntryIndex.h"
+#import "../../Descriptor/TSDescriptor.h"
+#import "../../Descriptor/DVB/TSDvbServiceListDescriptor.h"
+#import "../../Descriptor/DVB/TSDvbDeliverySystemDescriptor.h"
+#import "../../TSStringEncodingUtil.h"
+#import "../../TSLog.h"
+#import <os/lock.h>
+
+// transportStreamId:2 + originalNetworkId:2 + transportDescriptorsLength:2
+#define NIT_TS_ENTRY_HEADER_LENGTH 6
+// networkId:2 + version:1 + sectionNumber:1 + lastSectionNumber:1
+#define NIT_LOOPS_OFFSET 5
+
+@interface TSDvbNetworkTransportStream()
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range;
+@end
+
+@implementation TSDvbNetworkTransportStream
+{
+    NSData *_sectionData;
+    NSRange _range;
+    os_unfair_lock _lock;
+    BOOL _descriptorsDecoded;
+    NSArray<TSDescriptor*> *_descriptors;
+}
+
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range
+{
+    self = [super init];
+    if (self) {
+        _sectionData = sectionData;
+        _range = range;
+        _lock = OS_UNFAIR_LOCK_INIT;
+
+        const uint8_t *bytes = (const uint8_t *)sectionData.bytes + range.location;
+        _transportStreamId = (bytes[0] << 8) | bytes[1];
+        _originalNetworkId = (bytes[2] << 8) | bytes[3];
+    }
+    return self;
+}
+
+-(NSArray<TSDescriptor*> * _Nullable)descriptors
+{
+    os_unfair_lock_lock(&_lock);
+    if (!_descriptorsDecoded) {
+        // The range was clamped to the transport stream loop when indexed, so it bounds the descriptor loop.
+        const NSUInteger descriptorsLength = _range.length - NIT_TS_ENTRY_HEADER_LENGTH;
+        if (descriptorsLength > 0) {
+            const uint8_t *bytes = (const uint8_t *)_sectionData.bytes + _range.location;
+            _descriptors = [TSDescriptor descriptorsFromLoopBytes:bytes + NIT_TS_ENTRY_HEADER_LENGTH
+                                                           length:descriptorsLength];
+        }
+        _descriptorsDecoded = YES;
+    }
+    NSArray<TSDescriptor*> *descriptors = _descriptors;
+    os_unfair_lock_unlock(&_lock);
+    return descriptors;
+}
+
+-(NSArray<TSDvbServiceListEntry*> * _Nonnull)services
+{
+    NSMutableArray<TSDvbServiceListEntry*> *services = [NSMutableArray array];
+    for (TSDescriptor *descriptor in self.descriptors) {
+        if ([descriptor isKindOfClass:[TSDvbServiceListDescriptor class]]) {
+            [services addObjectsFromArray:((TSDvbServiceListDescriptor*)descriptor).services];
+        }
+    }
+    return services;
+}
+
+-(TSDvbDeliverySystemDescriptor * _Nullable)deliverySystem
+{
+    for (TSDescriptor *descriptor in self.descriptors) {
+        if ([descriptor isKindOfClass:[TSDvbDeliverySystemDescriptor class]]) {
+            return (TSDvbDeliverySystemDescriptor*)descriptor;
+        }
+    }
+    return nil;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[TSDvbNetworkTransportStream class]]) {
+        return NO;
+    }
+    TSDvbNetworkTransportStream *other = (TSDvbNetworkTransportStream*)object;
+    return _range.length == other->_range.length
+    && memcmp((const uint8_t *)_sectionData.bytes + _range.location,
+              (const uint8_t *)other->_sectionData.bytes + other->_range.location,
+              _range.length) == 0;
+}
+
+-(NSUInteger)hash
+{
+    return _transportStreamId ^ (_originalNetworkId << 16);
+}
+
+-(NSString *)description
+{
+    return [NSString stringWithFormat:@"{ tsId: %hu, onid: %hu, services: %lu, deliverySystem: %@ }",
+            _transportStreamId,
+            _originalNetworkId,
+            (unsigned long)self.services.count,
+            self.deliverySystem];
+}
+
+@end
+
+@implementation TSDvbNetworkInformationTable
+{
+    os_unfair_lock _lock;
+    BOOL _indexed;
+    TSSectionEntryIndex<TSDvbNetworkTransportStream*> *_entryIndex;
+    // Network descriptor loops, one per section of the aggregated table
+    NSData *_networkDescriptorRanges;
+    NSArray<TSDescriptor*> *_networkDescriptors;
+}
+
++(BOOL)isNitTableId:(uint8_t)tableId
+{
+    return tableId == TABLE_ID_DVB_NIT_ACTUAL_NETWORK || tableId == TABLE_ID_DVB_NIT_OTHER_NETWORK;
+}
+
+#pragma mark - Demuxer
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable* _Nonnull)psi
+{
+    if (psi.sectionDataExcludingCrc.length < NIT_LOOPS_OFFSET + 2) {
+        TSLogWarn(@"NIT received PSI with insufficient data");
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _psi = psi;
+        _lock = OS_UNFAIR_LOCK_INIT;
+    }
+    return self;
+}
+
+-(uint16_t)networkId
+{
+    return self.psi.byte4And5;
+}
+
+-(BOOL)isActualNetwork
+{
+    return self.psi.tableId == TABLE_ID_DVB_NIT_ACTUAL_NETWORK;
+}
+
+/// Indexes the network descriptor loops and the transport stream entries in one pass. An aggregated
+/// table holds each section's two loops one after the other, so the loops are read until the data ends.
+-(void)indexIfNeeded
+{
+    os_unfair_lock_lock(&_lock);
+    if (_indexed) {
+        os_unfair_lock_unlock(&_lock);
+        return;
+    }
+    NSData *data = self.psi.sectionDataExcludingCrc;
+    const uint8_t *bytes = data.bytes;
+    NSMutableData *descriptorRanges = [NSMutableData data];
+    NSMutableData *entryRanges = [NSMutableData data];
+    NSUInteger entryCount = 0;
+    NSUInteger offset = NIT_LOOPS_OFFSET;
+
+    while (offset + 2 <= data.length) {
+        const uint16_t networkDescriptorsLength = ((bytes[offset] & 0x0F) << 8) | bytes[offset + 1];
+        offset += 2;
+        NSRange descriptorRange = NSMakeRange(offset, MIN(networkDescriptorsLength, data.length - offset));
+        if (descriptorRange.length < networkDescriptorsLength) {
+            TSLogWarn(@"NIT: network descriptors truncated for network 0x%04X", self.networkId);
+        }
+        [descriptorRanges appendBytes:&descriptorRange length:sizeof(descriptorRange)];
+        offset = NSMaxRange(descriptorRange);
+
+        if (offset + 2 > data.length) {
+            break;
+        }
+        const uint16_t transportStreamLoopLength = ((bytes[offset] & 0x0F) << 8) | bytes[offset + 1];
+        offset += 2;
+        const NSUInteger loopEnd = MIN(offset + transportStreamLoopLength, data.length);
+        while (offset + NIT_TS_ENTRY_HEADER_LENGTH <= loopEnd) {
+            const uint16_t descriptorsLength = ((bytes[offset + 4] & 0x0F) << 8) | bytes[offset + 5];
+            NSRange range = NSMakeRange(offset, NIT_TS_ENTRY_HEADER_LENGTH + descriptorsLength);
+            if (NSMaxRange(range) > loopEnd) {
+                TSLogWarn(@"NIT: descriptors truncated for transport stream 0x%04X", (bytes[offset] << 8) | bytes[offset + 1]);
+                range.length = loopEnd - offset;
+            }
+            [entryRanges appendBytes:&range length:sizeof(range)];
+            entryCount++;
+            offset = NSMaxRange(range);
+        }
+        offset = loopEnd;
+    }
+
+    _networkDescriptorRanges = descriptorRanges;
+    _entryIndex = [[TSSectionEntryIndex alloc] initWithSectionData:data
+                                                            ranges:entryRanges.bytes
+                                                             count:entryCount
+                                                           decoder:^id(NSData *sectionData, NSRange range) {
+        return [[TSDvbNetworkTransportStream alloc] initWithSectionData:sectionData range:range];
+    }];
+    _indexed = YES;
+    os_unfair_lock_unlock(&_lock);
+}
+
+-(TSSectionEntryIndex<TSDvbNetworkTransportStream*> *)entryIndex
+{
+    [self indexIfNeeded];
+    return _entryIndex;
+}
+
+-(NSArray<TSDescriptor*> * _Nonnull)networkDescriptors
+{
+    [self indexIfNeeded];
+    os_unfair_lock_lock(&_lock);
+    if (!_networkDescriptors) {
+        NSMutableArray<TSDescriptor*> *descriptors = [NSMutableArray array];
+        const NSRange *ranges = _networkDescriptorRanges.bytes;
+        const uint8_t *bytes = self.psi.sectionDataExcludingCrc.bytes;
+        for (NSUInteger i = 0; i < _networkDescriptorRanges.length / sizeof(NSRange); ++i) {
+            if (ranges[i].length > 0) {
+                [descriptors addObjectsFromArray:[TSDescriptor descriptorsFromLoopBytes:bytes + ranges[i].location
+                                                                                 length:ranges[i].length]];
+            }
+        }
+        _networkDescriptors = descriptors;
+    }
+    NSArray<TSDescriptor*> *networkDescriptors = _networkDescriptors;
+    os_unfair_lock_unlock(&_lock);
+    return networkDescriptors;
+}
+
+-(NSString * _Nullable)networkName
+{
+    [self indexIfNeeded];
+    // Read from the raw loops: the network name has no descriptor class of its own
+    const NSRange *ranges = _networkDescriptorRanges.bytes;
+    const uint8_t *bytes = self.psi.sectionDataExcludingCrc.bytes;
+    for (NSUInteger i = 0; i < _networkDescriptorRanges.length / sizeof(NSRange); ++i) {
+        NSUInteger offset = ranges[i].location;
+        const NSUInteger end = NSMaxRange(ranges[i]);
+        while (offset + 2 <= end) {
+            const uint8_t tag = bytes[offset];
+            const uint8_t length = bytes[offset + 1];
+            if (offset + 2 + length > end) {
+                break;
+            }
+            if (tag == TSDvbDescriptorTagNetworkName) {
+                return [TSStringEncodingUtil dvbStringFromBytes:bytes + offset + 2 length:length];
+            }
+            offset += 2 + length;
+        }
+    }
+    return nil;
+}
+
+-(NSArray<TSDvbNetworkTransportStream*> * _Nonnull)transportStreams
+{
+    return [self.entryIndex allObjects];
+}
+
+-(NSUInteger)transportStreamCount
+{
+    return self.entryIndex.count;
+}
+
+-(TSDvbNetworkTransportStream * _Nullable)transportStreamAtIndex:(NSUInteger)index
+{
+    TSSectionEntryIndex<TSDvbNetworkTransportStream*> *entryIndex = self.entryIndex;
+    return index < entryIndex.count ? [entryIndex objectAtIndex:index] : nil;
+}
+
+-(TSDvbNetworkTransportStream * _Nullable)transportStreamWithId:(uint16_t)transportStreamId
+                                              originalNetworkId:(uint16_t)originalNetworkId
+{
+    TSSectionEntryIndex<TSDvbNetworkTransportStream*> *entryIndex = self.entryIndex;
+    for (NSUInteger i = 0; i < entryIndex.count; ++i) {
+        const uint8_t *entry = [entryIndex bytesAtIndex:i];
+        if (((entry[0] << 8) | entry[1]) == transportStreamId && ((entry[2] << 8) | entry[3]) == originalNetworkId) {
+            return [entryIndex objectAtIndex:i];
+        }
+    }
+    return nil;
+}
+
+#pragma mark - Overridden
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[TSDvbNetworkInformationTable class]]) {
+        return NO;
+    }
+    TSDvbNetworkInformationTable *other = (TSDvbNetworkInformationTable*)object;
+    // The section bytes cover networkId, version, both descriptor loops and every transport stream.
+    return self.psi.tableId == other.psi.tableId
+    && [self.psi.sectionDataExcludingCrc isEqualToData:other.psi.sectionDataExcludingCrc];
+}
+
+-(NSUInteger)hash
+{
+    return self.networkId ^ (self.psi.versionNumber << 16) ^ (self.psi.tableId << 24);
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ %@ v: %u, networkId: %hu, name: %@, transportStreams: %@ }",
+            self.isActualNetwork ? @"NIT" : @"NIT other",
+            self.psi.versionNumber,
+            self.networkId,
+            self.networkName,
+            self.transportStreams];
+}
+
+@end
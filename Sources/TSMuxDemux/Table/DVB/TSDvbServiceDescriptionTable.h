@@ -16,9 +16,13 @@
 @property(nonatomic, readonly) BOOL eitPresentFollowingFlag;
 @property(nonatomic, readonly) uint8_t runningStatus;
 @property(nonatomic, readonly) BOOL freeCaMode;
+/// Decoded on first access.
 @property(nonatomic, readonly) NSArray<TSDescriptor*> * _Nullable descriptors;
 @end
 
+/// Entries are located with a single pass over the section on first access and decoded one at a
+/// time as they are requested. Two tables are equal when their section bytes are, so comparing a
+/// repeated table against the previous one never decodes anything.
 @interface TSDvbServiceDescriptionTable : NSObject
 
 @property(nonatomic, readonly) TSProgramSpecificInformationTable * _Nonnull psi;
@@ -26,6 +30,10 @@
 
 -(uint16_t)originalNetworkId;
 -(NSArray<TSDvbServiceDescriptionEntry*> * _Nullable)entries;
+-(NSUInteger)entryCount;
+-(TSDvbServiceDescriptionEntry * _Nullable)entryAtIndex:(NSUInteger)index;
+/// Found by reading service ids from the raw entries; only the matching entry is decoded.
+-(TSDvbServiceDescriptionEntry * _Nullable)entryWithServiceId:(uint16_t)serviceId;
 
 #pragma mark Demuxer
 
@@ -7,42 +7,67 @@
 //
 
 #import "TSDvbServiceDescriptionTable.h"
+#import "../TSSectionEntryIndex.h"
 #import "../../TSBitReader.h"
 #import "../../TSElementaryStream.h"
 #import "../../Descriptor/TSDescriptor.h"
 #import "../../Descriptor/TSRegistrationDescriptor.h"
 #import "../../TSLog.h"
+#import <os/lock.h>
+
+// serviceId:2 + flags:1 + runningStatus/freeCaMode/descriptorsLength:2
+#define SDT_ENTRY_HEADER_LENGTH 5
+// transportStreamId:2 + version:1 + sectionNumber:1 + lastSectionNumber:1 + originalNetworkId:2 + reserved:1
+#define SDT_ENTRIES_OFFSET 8
 
 @interface TSDvbServiceDescriptionEntry()
--(instancetype)initWithServiceId:(uint16_t)serviceId
-                 eitScheduleFlag:(BOOL)eitScheduleFlag
-         eitPresentFollowingFlag:(BOOL)eitPresentFollowingFlag
-                   runningStatus:(uint8_t)runningStatus
-                      freeCaMode:(BOOL)freeCaMode
-                     descriptors:(NSArray<TSDescriptor*> * _Nullable)descriptors;
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range;
 @end
 
 @implementation TSDvbServiceDescriptionEntry
+{
+    NSData *_sectionData;
+    NSRange _range;
+    os_unfair_lock _lock;
+    BOOL _descriptorsDecoded;
+    NSArray<TSDescriptor*> *_descriptors;
+}
 
--(instancetype)initWithServiceId:(uint16_t)serviceId
-                 eitScheduleFlag:(BOOL)eitScheduleFlag
-         eitPresentFollowingFlag:(BOOL)eitPresentFollowingFlag
-                   runningStatus:(uint8_t)runningStatus
-                      freeCaMode:(BOOL)freeCaMode
-                     descriptors:(NSArray<TSDescriptor*> * _Nullable)descriptors
+-(instancetype)initWithSectionData:(NSData * _Nonnull)sectionData range:(NSRange)range
 {
     self = [super init];
     if (self) {
-        _serviceId = serviceId;
-        _eitScheduleFlag = eitScheduleFlag;
-        _eitPresentFollowingFlag = eitPresentFollowingFlag;
-        _runningStatus = runningStatus;
-        _freeCaMode = freeCaMode;
-        _descriptors = descriptors;
+        _sectionData = sectionData;
+        _range = range;
+        _lock = OS_UNFAIR_LOCK_INIT;
+
+        const uint8_t *bytes = (const uint8_t *)sectionData.bytes + range.location;
+        _serviceId = (bytes[0] << 8) | bytes[1];
+        _eitScheduleFlag = (bytes[2] >> 1) & 0x01;
+        _eitPresentFollowingFlag = bytes[2] & 0x01;
+        _runningStatus = (bytes[3] >> 5) & 0b00000111;
+        _freeCaMode = (bytes[3] >> 4) & 0b00000001;
     }
     return self;
 }
 
+-(NSArray<TSDescriptor*> * _Nullable)descriptors
+{
+    os_unfair_lock_lock(&_lock);
+    if (!_descriptorsDecoded) {
+        // The range was clamped to the section when indexed, so it bounds the descriptor loop.
+        const NSUInteger descriptorsLength = _range.length - SDT_ENTRY_HEADER_LENGTH;
+        if (descriptorsLength > 0) {
+            const uint8_t *bytes = (const uint8_t *)_sectionData.bytes + _range.location;
+            _descriptors = [TSDescriptor descriptorsFromLoopBytes:bytes + SDT_ENTRY_HEADER_LENGTH
+                                                           length:descriptorsLength];
+        }
+        _descriptorsDecoded = YES;
+    }
+    NSArray<TSDescriptor*> *descriptors = _descriptors;
+    os_unfair_lock_unlock(&_lock);
+    return descriptors;
+}
 
 -(BOOL)isEqual:(id)object
 {
@@ -57,32 +82,10 @@
 
 -(BOOL)isEqualToDvbSDTEntry:(TSDvbServiceDescriptionEntry*)e
 {
-    if (self.serviceId != e.serviceId) {
-        return NO;
-    }
-    if (self.eitScheduleFlag != e.eitScheduleFlag) {
-        return NO;
-    }
-    if (self.eitPresentFollowingFlag != e.eitPresentFollowingFlag) {
-        return NO;
-    }
-    if (self.runningStatus != e.runningStatus) {
-        return NO;
-    }
-    if (self.freeCaMode != e.freeCaMode) {
-        return NO;
-    }
-    if (self.descriptors.count != e.descriptors.count) {
-        return NO;
-    }
-    for (NSUInteger i=0; i < self.descriptors.count; ++i) {
-        TSDescriptor *d1 = self.descriptors[i];
-        TSDescriptor *d2 = e.descriptors[i];
-        if (![d1 isEqual:d2]) {
-            return NO;
-        }
-    }
-    return YES;
+    return _range.length == e->_range.length
+    && memcmp((const uint8_t *)_sectionData.bytes + _range.location,
+              (const uint8_t *)e->_sectionData.bytes + e->_range.location,
+              _range.length) == 0;
 }
 
 -(NSUInteger)hash
@@ -116,6 +119,10 @@
 @end
 
 @implementation TSDvbServiceDescriptionTable
+{
+    os_unfair_lock _lock;
+    TSSectionEntryIndex<TSDvbServiceDescriptionEntry*> *_entryIndex;
+}
 
 #pragma mark - Demuxer
 
@@ -129,6 +136,7 @@
     self = [super init];
     if (self) {
         _psi = psi;
+        _lock = OS_UNFAIR_LOCK_INIT;
     }
     return self;
 }
@@ -145,80 +153,70 @@
     return TSBitReaderReadUInt16BE(&reader);
 }
 
--(NSArray<TSDvbServiceDescriptionEntry*> * _Nullable)entries
+-(TSSectionEntryIndex<TSDvbServiceDescriptionEntry*> *)entryIndex
 {
-    NSData *data = self.psi.sectionDataExcludingCrc;
-    if (data.length < 8) {
-        return @[];
+    os_unfair_lock_lock(&_lock);
+    if (!_entryIndex) {
+        _entryIndex = [TSDvbServiceDescriptionTable makeEntryIndexWithSectionData:self.psi.sectionDataExcludingCrc];
     }
+    TSSectionEntryIndex *entryIndex = _entryIndex;
+    os_unfair_lock_unlock(&_lock);
+    return entryIndex;
+}
 
-    TSBitReader reader = TSBitReaderMake(data);
-    TSBitReaderSkip(&reader, 8);  // Skip header bytes
-
-    NSMutableArray<TSDvbServiceDescriptionEntry*> *entries = [NSMutableArray array];
++(TSSectionEntryIndex<TSDvbServiceDescriptionEntry*> *)makeEntryIndexWithSectionData:(NSData *)data
+{
+    NSMutableData *ranges = [NSMutableData data];
+    NSUInteger count = 0;
+    const uint8_t *bytes = data.bytes;
+    NSUInteger offset = SDT_ENTRIES_OFFSET;
+
+    while (offset + SDT_ENTRY_HEADER_LENGTH <= data.length) {
+        const uint16_t descriptorsLength = ((bytes[offset + 3] & 0x0F) << 8) | bytes[offset + 4];
+        NSRange range = NSMakeRange(offset, SDT_ENTRY_HEADER_LENGTH + descriptorsLength);
+        if (NSMaxRange(range) > data.length) {
+            TSLogWarn(@"SDT: descriptors truncated for service 0x%04X", (bytes[offset] << 8) | bytes[offset + 1]);
+            range.length = data.length - offset;
+        }
+        [ranges appendBytes:&range length:sizeof(range)];
+        count++;
+        offset = NSMaxRange(range);
+    }
 
-    // Each SDT entry requires at minimum 5 bytes (serviceId:2 + flags:1 + descriptorsLength:2)
-    while (TSBitReaderRemainingBytes(&reader) >= 5) {
-        uint16_t serviceId = TSBitReaderReadUInt16BE(&reader);
+    return [[TSSectionEntryIndex alloc] initWithSectionData:data
+                                                     ranges:ranges.bytes
+                                                      count:count
+                                                    decoder:^id(NSData *sectionData, NSRange range) {
+        return [[TSDvbServiceDescriptionEntry alloc] initWithSectionData:sectionData range:range];
+    }];
+}
 
-        uint8_t byte3 = TSBitReaderReadUInt8(&reader);
-        BOOL eitScheduleFlag = (byte3 >> 1) & 0x01;
-        BOOL eitPresentFollowingFlag = byte3 & 0x01;
+-(NSArray<TSDvbServiceDescriptionEntry*> * _Nullable)entries
+{
+    return [self.entryIndex allObjects];
+}
 
-        uint16_t bytes4And5 = TSBitReaderReadUInt16BE(&reader);
-        const uint8_t runningStatus = (bytes4And5 >> 13) & 0b00000111;
-        const BOOL freeCAMode = (bytes4And5 >> 12) & 0b00000001;
-        const uint16_t descriptorsLength = bytes4And5 & 0x0FFF;
+-(NSUInteger)entryCount
+{
+    return self.entryIndex.count;
+}
 
-        if (reader.error) {
-            TSLogWarn(@"SDT: read error while parsing entry for service 0x%04X", serviceId);
-            break;
-        }
+-(TSDvbServiceDescriptionEntry * _Nullable)entryAtIndex:(NSUInteger)index
+{
+    TSSectionEntryIndex<TSDvbServiceDescriptionEntry*> *entryIndex = self.entryIndex;
+    return index < entryIndex.count ? [entryIndex objectAtIndex:index] : nil;
+}
 
-        NSMutableArray<TSDescriptor*> *descriptors = nil;
-        if (descriptorsLength > 0) {
-            descriptors = [NSMutableArray array];
-            NSUInteger descriptorsEndOffset = reader.byteOffset + descriptorsLength;
-
-            // Each descriptor requires at minimum 2 bytes (tag + length)
-            while (TSBitReaderRemainingBytes(&reader) >= 2 && reader.byteOffset < descriptorsEndOffset) {
-                uint8_t descriptorTag = TSBitReaderReadUInt8(&reader);
-                uint8_t descriptorLength = TSBitReaderReadUInt8(&reader);
-
-                if (reader.error) {
-                    TSLogWarn(@"SDT: descriptor header truncated for service 0x%04X", serviceId);
-                    break;
-                }
-
-                // Bounds check: ensure descriptor payload fits
-                if (TSBitReaderRemainingBytes(&reader) < descriptorLength) {
-                    TSLogError(@"SDT descriptor payload truncated: need %u bytes, but only %lu available",
-                               descriptorLength, (unsigned long)TSBitReaderRemainingBytes(&reader));
-                    break;
-                }
-
-                NSData *descriptorPayload = descriptorLength > 0
-                    ? TSBitReaderReadData(&reader, descriptorLength)
-                    : nil;
-                TSDescriptor *esDescriptor = [TSDescriptor makeWithTag:descriptorTag
-                                                                length:descriptorLength
-                                                                  data:descriptorPayload];
-                if (esDescriptor) {
-                    [descriptors addObject:esDescriptor];
-                }
-            }
+-(TSDvbServiceDescriptionEntry * _Nullable)entryWithServiceId:(uint16_t)serviceId
+{
+    TSSectionEntryIndex<TSDvbServiceDescriptionEntry*> *entryIndex = self.entryIndex;
+    for (NSUInteger i = 0; i < entryIndex.count; ++i) {
+        const uint8_t *entry = [entryIndex bytesAtIndex:i];
+        if (((entry[0] << 8) | entry[1]) == serviceId) {
+            return [entryIndex objectAtIndex:i];
         }
-
-        TSDvbServiceDescriptionEntry *entry = [[TSDvbServiceDescriptionEntry alloc] initWithServiceId:serviceId
-                                                                                      eitScheduleFlag:eitScheduleFlag
-                                                                              eitPresentFollowingFlag:eitPresentFollowingFlag
-                                                                                        runningStatus:runningStatus
-                                                                                           freeCaMode:freeCAMode
-                                                                                          descriptors:descriptors];
-        [entries addObject:entry];
     }
-
-    return entries;
+    return nil;
 }
 
 
@@ -237,10 +235,9 @@
 
 -(BOOL)isEqualToDvbSDT:(TSDvbServiceDescriptionTable*)sdt
 {
-    return self.transportStreamId == sdt.transportStreamId
-    && self.originalNetworkId == sdt.originalNetworkId
-    && self.psi.versionNumber == sdt.psi.versionNumber
-    && [self.entries isEqual:sdt.entries];
+    // The section bytes cover tsId, version, originalNetworkId and every entry.
+    return self.psi.tableId == sdt.psi.tableId
+    && [self.psi.sectionDataExcludingCrc isEqualToData:sdt.psi.sectionDataExcludingCrc];
 }
 
 -(NSUInteger)hash
@@ -0,0 +1,31 @@
+//
+//  TSDvbTimeTable.h
+//  TSMuxDemux
+//
+//  DVB Time and Date Table (EN 300 468 5.2.5) and Time Offset Table (5.2.6).
+//
+
+#import <Foundation/Foundation.h>
+@class TSProgramSpecificInformationTable;
+@class TSDescriptor;
+
+/// Current UTC time as broadcast on PID 0x14, by a TDT (table id 0x70) or a TOT (0x73).
+/// Both are sent every few seconds; the time has one second resolution.
+@interface TSDvbTimeTable : NSObject
+
+@property(nonatomic, readonly, nonnull) TSProgramSpecificInformationTable *psi;
+/// Seconds since 1970-01-01 UTC.
+@property(nonatomic, readonly) int64_t unixSeconds;
+
+/// YES for a TOT, which also carries local time offset descriptors.
+-(BOOL)isTimeOffsetTable;
+-(NSDate * _Nonnull)utcDate;
+/// TOT only. Decoded on first access.
+-(NSArray<TSDescriptor*> * _Nullable)descriptors;
+
++(BOOL)isTimeTableId:(uint8_t)tableId;
+
+/// Returns nil if the section is too short or UTC_time is not a valid time.
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi;
+
+@end
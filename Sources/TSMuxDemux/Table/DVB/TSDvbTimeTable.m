@@ -0,0 +1,114 @@
+//
+//  TSDvbTimeTable.m
+//  TSMuxDemux
+//
+//  DVB Time and Date Table (EN 300 468 5.2.5) and Time Offset Table (5.2.6).
+//
+
+#import "TSDvbTimeTable.h"
+#import "../TSProgramSpecificInformationTable.h"
+#import "../../Descriptor/TSDescriptor.h"
+#import "../../TSConstants.h"
+#import "../../TSTimeUtil.h"
+#import "../../TSLog.h"
+#import <os/lock.h>
+
+#define DVB_UTC_TIME_LENGTH 5
+// UTC_time:5 + reserved/descriptors_loop_length:2
+#define TOT_DESCRIPTORS_OFFSET 7
+
+@implementation TSDvbTimeTable
+{
+    os_unfair_lock _lock;
+    BOOL _descriptorsDecoded;
+    NSArray<TSDescriptor*> *_descriptors;
+}
+
++(BOOL)isTimeTableId:(uint8_t)tableId
+{
+    return tableId == TABLE_ID_DVB_TDT || tableId == TABLE_ID_DVB_TOT;
+}
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi
+{
+    NSData *data = psi.sectionDataExcludingCrc;
+    uint8_t utcTime[DVB_UTC_TIME_LENGTH];
+    if (psi.tableId == TABLE_ID_DVB_TDT) {
+        if (data.length != DVB_UTC_TIME_LENGTH) {
+            TSLogWarn(@"TDT received with unexpected length %lu", (unsigned long)data.length);
+            return nil;
+        }
+        memcpy(utcTime, data.bytes, DVB_UTC_TIME_LENGTH);
+    } else {
+        if (data.length < TOT_DESCRIPTORS_OFFSET) {
+            TSLogWarn(@"TOT received PSI with insufficient data");
+            return nil;
+        }
+        memcpy(utcTime, data.bytes, DVB_UTC_TIME_LENGTH);
+    }
+
+    const int64_t unixSeconds = [TSTimeUtil unixSecondsFromDvbUtcTime:utcTime];
+    if (unixSeconds < 0) {
+        TSLogWarn(@"%@ received with invalid UTC_time", psi.tableId == TABLE_ID_DVB_TDT ? @"TDT" : @"TOT");
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _psi = psi;
+        _unixSeconds = unixSeconds;
+        _lock = OS_UNFAIR_LOCK_INIT;
+    }
+    return self;
+}
+
+-(BOOL)isTimeOffsetTable
+{
+    return self.psi.tableId == TABLE_ID_DVB_TOT;
+}
+
+-(NSDate * _Nonnull)utcDate
+{
+    return [NSDate dateWithTimeIntervalSince1970:self.unixSeconds];
+}
+
+-(NSArray<TSDescriptor*> * _Nullable)descriptors
+{
+    if (!self.isTimeOffsetTable) {
+        return nil;
+    }
+    os_unfair_lock_lock(&_lock);
+    if (!_descriptorsDecoded) {
+        NSData *data = self.psi.sectionDataExcludingCrc;
+        const uint8_t *bytes = data.bytes;
+        const uint16_t loopLength = ((bytes[5] & 0x0F) << 8) | bytes[6];
+        const NSUInteger length = MIN(loopLength, data.length - TOT_DESCRIPTORS_OFFSET);
+        if (length > 0) {
+            _descriptors = [TSDescriptor descriptorsFromLoopBytes:bytes + TOT_DESCRIPTORS_OFFSET length:length];
+        }
+        _descriptorsDecoded = YES;
+    }
+    NSArray<TSDescriptor*> *descriptors = _descriptors;
+    os_unfair_lock_unlock(&_lock);
+    return descriptors;
+}
+
+-(BOOL)isEqual:(id)object
+{
+    if (self == object) return YES;
+    if (![object isKindOfClass:[TSDvbTimeTable class]]) return NO;
+    TSDvbTimeTable *other = (TSDvbTimeTable *)object;
+    return self.psi.tableId == other.psi.tableId && [self.psi isEqual:other.psi] && self.psi.crc == other.psi.crc;
+}
+
+-(NSUInteger)hash
+{
+    return (NSUInteger)self.unixSeconds;
+}
+
+-(NSString*)description
+{
+    return [NSString stringWithFormat:@"{ %@ %@ }", self.isTimeOffsetTable ? @"TOT" : @"TDT", self.utcDate];
+}
+
+@end
@@ -0,0 +1,110 @@
+//
+//  TSScte35SpliceInfoSection.h
+//  TSMuxDemux
+//
+//  ANSI/SCTE 35 splice_info_section - Table ID 0xFC
+//  Digital program insertion cues, carried on the PIDs of stream type 0x86.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreMedia/CoreMedia.h>
+#import "../../Descriptor/SCTE35/TSScte35SegmentationDescriptor.h"
+
+@class TSProgramSpecificInformationTable;
+@class TSProgramTimeline;
+
+/// splice_command_type values (SCTE 35 Table 7)
+typedef NS_ENUM(uint8_t, TSScte35SpliceCommandType) {
+    TSScte35SpliceCommandTypeSpliceNull             = 0x00,
+    TSScte35SpliceCommandTypeSpliceSchedule         = 0x04,
+    TSScte35SpliceCommandTypeSpliceInsert           = 0x05,
+    TSScte35SpliceCommandTypeTimeSignal             = 0x06,
+    TSScte35SpliceCommandTypeBandwidthReservation   = 0x07,
+    TSScte35SpliceCommandTypePrivateCommand         = 0xFF,
+};
+
+/// splice_insert(): the start of a break (out of network) or the return from it (SCTE 35 9.7.3).
+@interface TSScte35SpliceInsert : NSObject
+
+@property(nonatomic, readonly) uint32_t spliceEventId;
+/// YES if a previously sent event with this id is cancelled; no other field is then set.
+@property(nonatomic, readonly) BOOL isCancel;
+@property(nonatomic, readonly) BOOL isOutOfNetwork;
+/// YES if the whole program splices at the section's `spliceTime`; otherwise each component
+/// in `componentTags` splices at its own time.
+@property(nonatomic, readonly) BOOL isProgramSplice;
+/// YES to splice at the nearest opportunity rather than at a splice time.
+@property(nonatomic, readonly) BOOL isSpliceImmediate;
+/// Component splice mode: the components, and the splice times of those that have one (33-bit
+/// 90 kHz PTS, pts_adjustment applied).
+@property(nonatomic, readonly, nonnull) NSArray<NSNumber*> *componentTags;
+@property(nonatomic, readonly, nonnull) NSDictionary<NSNumber*, NSNumber*> *componentSpliceTimes;
+/// Duration of the break (90 kHz), or kCMTimeInvalid if not signalled.
+@property(nonatomic, readonly) CMTime breakDuration;
+/// YES if the splicer returns to the network by itself once `breakDuration` has elapsed.
+@property(nonatomic, readonly) BOOL isAutoReturn;
+@property(nonatomic, readonly) uint16_t uniqueProgramId;
+@property(nonatomic, readonly) uint8_t availNum;
+@property(nonatomic, readonly) uint8_t availsExpected;
+
+@end
+
+/// An SCTE-35 cue. Single section, never aggregated; encoders repeat a cue a few times ahead of
+/// its splice time, and every repeat is delivered.
+///
+/// The commands of an encrypted section are not decoded: only the header fields are then set.
+@interface TSScte35SpliceInfoSection : NSObject
+
+@property(nonatomic, readonly, nonnull) TSProgramSpecificInformationTable *psi;
+@property(nonatomic, readonly) uint8_t protocolVersion;
+@property(nonatomic, readonly) BOOL isEncrypted;
+/// 33-bit offset added to every splice time, e.g. by a splicer that re-stamped the program.
+@property(nonatomic, readonly) uint64_t ptsAdjustment;
+@property(nonatomic, readonly) uint16_t tier;
+/// A TSScte35SpliceCommandType (or another value of SCTE 35 Table 7).
+@property(nonatomic, readonly) uint8_t spliceCommandType;
+/// The splice_insert() command, or nil for the other commands.
+@property(nonatomic, readonly, nullable) TSScte35SpliceInsert *spliceInsert;
+
+/// The splice time of a time_signal() or a program splice_insert(): pts_time plus pts_adjustment,
+/// modulo 2^33, at 90 kHz. kCMTimeInvalid for other commands and immediate splices.
+@property(nonatomic, readonly) CMTime spliceTime;
+/// `spliceTime` on the program's continuous timeline, comparable with the `timelinePts` of its
+/// access units. Equals `spliceTime` when the section was not decoded against a program timeline.
+@property(nonatomic, readonly) CMTime timelineSpliceTime;
+
+@property(nonatomic, readonly, nonnull) NSArray<TSScte35SegmentationDescriptor*> *segmentationDescriptors;
+
+#pragma mark Muxer
+
+/// A splice_info_section carrying `spliceCommand`, the bytes of a command of `spliceCommandType`
+/// (see makeSpliceInsert... and makeTimeSignal...), and `spliceDescriptors`, complete
+/// splice_descriptor()s or nil. Not encrypted, without pts_adjustment, tier 0xFFF.
+/// Returns nil if the section does not fit in 4096 bytes.
+-(instancetype _Nullable)initWithSpliceCommandType:(uint8_t)spliceCommandType
+                                     spliceCommand:(NSData * _Nonnull)spliceCommand
+                                 spliceDescriptors:(NSData * _Nullable)spliceDescriptors;
+
+/// splice_insert() of a program splice at `ptsTime` (33-bit, 90 kHz). The break duration (90 kHz)
+/// is only signalled when > 0.
++(NSData * _Nonnull)makeSpliceInsertWithEventId:(uint32_t)spliceEventId
+                                 isOutOfNetwork:(BOOL)isOutOfNetwork
+                                        ptsTime:(uint64_t)ptsTime
+                                  breakDuration:(uint64_t)breakDuration
+                                   isAutoReturn:(BOOL)isAutoReturn
+                                uniqueProgramId:(uint16_t)uniqueProgramId;
+
+/// time_signal() at `ptsTime` (33-bit, 90 kHz).
++(NSData * _Nonnull)makeTimeSignalWithPtsTime:(uint64_t)ptsTime;
+
+/// The section with pointer field and CRC, to packetize on the cue PID.
+-(NSData * _Nonnull)toTsPacketPayload;
+
+#pragma mark Demuxer
+
+/// `timeline` is the timeline of the program the cue PID belongs to, to place `timelineSpliceTime`
+/// on; it is not advanced. Returns nil if the section is truncated or not a splice_info_section.
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi
+                            timeline:(TSProgramTimeline * _Nullable)timeline;
+
+@end
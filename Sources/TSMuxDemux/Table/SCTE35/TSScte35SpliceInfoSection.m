@@ -0,0 +1,384 @@
+//
+//  TSScte35SpliceInfoSection.m
+//  TSMuxDemux
+//
+//  ANSI/SCTE 35 splice_info_section - Table ID 0xFC
+//
+
+#import "TSScte35SpliceInfoSection.h"
+#import "../TSProgramSpecificInformationTable.h"
+#import "../../TSConstants.h"
+#import "../../TSBitReader.h"
+#import "../../TSProgramTimeline.h"
+#import "../../TSLog.h"
+
+// splice_command_length of encoders that leave it to the splicer to parse the command
+#define SPLICE_COMMAND_LENGTH_UNKNOWN 0xFFF
+// Tier of cues that are not restricted to some splicers
+#define SPLICE_TIER_UNRESTRICTED 0xFFF
+// protocol_version .. splice_command_type, and descriptor_loop_length
+#define SPLICE_INFO_FIXED_SIZE (11 + 2)
+
+/// A 33-bit PTS field (pts_time, pts_adjustment, duration).
+static inline uint64_t readTimestamp33(TSBitReader *reader)
+{
+    const uint64_t high = TSBitReaderReadBits(reader, 1);
+    return (high << 32) | TSBitReaderReadBits(reader, 32);
+}
+
+/// splice_time(): the pts_time, or -1 if time_specified_flag is not set.
+static inline int64_t readSpliceTime(TSBitReader *reader)
+{
+    if (!TSBitReaderReadBits(reader, 1)) {
+        TSBitReaderSkipBits(reader, 7);
+        return -1;
+    }
+    TSBitReaderSkipBits(reader, 6);
+    return (int64_t)readTimestamp33(reader);
+}
+
+static inline uint64_t adjustedTime(int64_t ptsTime, uint64_t ptsAdjustment)
+{
+    return ((uint64_t)ptsTime + ptsAdjustment) & (TS_TIMESTAMP_WRAP - 1);
+}
+
+static inline void appendUInt16(NSMutableData *data, uint16_t value)
+{
+    const uint8_t bytes[] = { value >> 8, value & 0xFF };
+    [data appendBytes:bytes length:sizeof(bytes)];
+}
+
+static inline void appendUInt32(NSMutableData *data, uint32_t value)
+{
+    const uint8_t bytes[] = { value >> 24, (value >> 16) & 0xFF, (value >> 8) & 0xFF, value & 0xFF };
+    [data appendBytes:bytes length:sizeof(bytes)];
+}
+
+/// A 33-bit PTS field after 7 bits of `flags` (e.g. time_specified_flag and reserved bits).
+static inline void appendTimestamp33(NSMutableData *data, uint8_t flags, uint64_t timestamp)
+{
+    const uint8_t high = (flags & 0xFE) | ((timestamp >> 32) & 0x01);
+    [data appendBytes:&high length:1];
+    appendUInt32(data, (uint32_t)timestamp);
+}
+
+/// Commands whose length is known from their content.
+static inline BOOL isDecodedCommand(uint8_t spliceCommandType)
+{
+    return spliceCommandType == TSScte35SpliceCommandTypeSpliceNull
+        || spliceCommandType == TSScte35SpliceCommandTypeSpliceInsert
+        || spliceCommandType == TSScte35SpliceCommandTypeTimeSignal
+        || spliceCommandType == TSScte35SpliceCommandTypeBandwidthReservation;
+}
+
+#pragma mark - TSScte35SpliceInsert
+
+@implementation TSScte35SpliceInsert
+
+/// Reads splice_insert(). `programSpliceTime` is set to the adjusted program splice time, or -1.
+-(instancetype _Nullable)initWithReader:(TSBitReader *)reader
+                          ptsAdjustment:(uint64_t)ptsAdjustment
+                      programSpliceTime:(int64_t *)programSpliceTime
+{
+    self = [super init];
+    if (self) {
+        *programSpliceTime = -1;
+        _componentTags = @[];
+        _componentSpliceTimes = @{};
+        _breakDuration = kCMTimeInvalid;
+
+        _spliceEventId = TSBitReaderReadUInt32BE(reader);
+        _isCancel = TSBitReaderReadBits(reader, 1);
+        TSBitReaderSkipBits(reader, 7);
+        if (!_isCancel) {
+            _isOutOfNetwork = TSBitReaderReadBits(reader, 1);
+            _isProgramSplice = TSBitReaderReadBits(reader, 1);
+            const BOOL hasDuration = TSBitReaderReadBits(reader, 1);
+            _isSpliceImmediate = TSBitReaderReadBits(reader, 1);
+            TSBitReaderSkipBits(reader, 4);  // event_id_compliance_flag, reserved
+
+            if (_isProgramSplice && !_isSpliceImmediate) {
+                const int64_t spliceTime = readSpliceTime(reader);
+                if (spliceTime >= 0) {
+                    *programSpliceTime = (int64_t)adjustedTime(spliceTime, ptsAdjustment);
+                }
+            }
+            if (!_isProgramSplice) {
+                const uint8_t componentCount = TSBitReaderReadUInt8(reader);
+                NSMutableArray<NSNumber*> *tags = [NSMutableArray arrayWithCapacity:componentCount];
+                NSMutableDictionary<NSNumber*, NSNumber*> *times = [NSMutableDictionary dictionary];
+                for (uint8_t i = 0; i < componentCount && !reader->error; i++) {
+                    NSNumber *tag = @(TSBitReaderReadUInt8(reader));
+                    [tags addObject:tag];
+                    if (!_isSpliceImmediate) {
+                        const int64_t spliceTime = readSpliceTime(reader);
+                        if (spliceTime >= 0) {
+                            times[tag] = @(adjustedTime(spliceTime, ptsAdjustment));
+                        }
+                    }
+                }
+                _componentTags = tags;
+                _componentSpliceTimes = times;
+            }
+            if (hasDuration) {
+                _isAutoReturn = TSBitReaderReadBits(reader, 1);
+                TSBitReaderSkipBits(reader, 6);
+                _breakDuration = CMTimeMake((int64_t)readTimestamp33(reader), 90000);
+            }
+            _uniqueProgramId = TSBitReaderReadUInt16BE(reader);
+            _availNum = TSBitReaderReadUInt8(reader);
+            _availsExpected = TSBitReaderReadUInt8(reader);
+        }
+        if (reader->error) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+-(NSString*)description
+{
+    if (self.isCancel) {
+        return [NSString stringWithFormat:@"{ splice event %u cancelled }", self.spliceEventId];
+    }
+    return [NSString stringWithFormat:@"{ splice event %u, %@%@, break: %.3f s%@ }",
+            self.spliceEventId,
+            self.isOutOfNetwork ? @"out" : @"in",
+            self.isSpliceImmediate ? @" (immediate)" : @"",
+            CMTIME_IS_VALID(self.breakDuration) ? CMTimeGetSeconds(self.breakDuration) : 0.0,
+            self.isAutoReturn ? @" (auto return)" : @""];
+}
+
+@end
+
+#pragma mark - TSScte35SpliceInfoSection
+
+@implementation TSScte35SpliceInfoSection
+
+#pragma mark - Muxer
+
+-(instancetype _Nullable)initWithSpliceCommandType:(uint8_t)spliceCommandType
+                                     spliceCommand:(NSData * _Nonnull)spliceCommand
+                                 spliceDescriptors:(NSData * _Nullable)spliceDescriptors
+{
+    const NSUInteger sectionLength = SPLICE_INFO_FIXED_SIZE + spliceCommand.length + spliceDescriptors.length + PSI_CRC_LEN;
+    if (sectionLength > PSI_MAX_SECTION_LENGTH || spliceCommand.length >= SPLICE_COMMAND_LENGTH_UNKNOWN) {
+        TSLogWarn(@"SCTE-35: splice_info_section too long (%lu bytes)", (unsigned long)sectionLength);
+        return nil;
+    }
+
+    NSMutableData *sectionDataExcludingCrc = [NSMutableData dataWithCapacity:sectionLength - PSI_CRC_LEN];
+    // protocol_version = 0
+    const uint8_t protocolVersion = 0x00;
+    [sectionDataExcludingCrc appendBytes:&protocolVersion length:1];
+    // encrypted_packet = '0', encryption_algorithm = 0, pts_adjustment = 0
+    appendTimestamp33(sectionDataExcludingCrc, 0x00, 0);
+    // cw_index
+    const uint8_t cwIndex = 0x00;
+    [sectionDataExcludingCrc appendBytes:&cwIndex length:1];
+    // tier:12, splice_command_length:12
+    const uint16_t commandLength = (uint16_t)spliceCommand.length;
+    const uint8_t tierAndLength[] = {
+        SPLICE_TIER_UNRESTRICTED >> 4,
+        ((SPLICE_TIER_UNRESTRICTED & 0x0F) << 4) | ((commandLength >> 8) & 0x0F),
+        commandLength & 0xFF,
+    };
+    [sectionDataExcludingCrc appendBytes:tierAndLength length:sizeof(tierAndLength)];
+    [sectionDataExcludingCrc appendBytes:&spliceCommandType length:1];
+    [sectionDataExcludingCrc appendData:spliceCommand];
+    appendUInt16(sectionDataExcludingCrc, (uint16_t)spliceDescriptors.length);
+    if (spliceDescriptors) {
+        [sectionDataExcludingCrc appendData:spliceDescriptors];
+    }
+
+    // section_syntax_indicator = '0', private_indicator = '0', sap_type = '11' (not specified)
+    TSProgramSpecificInformationTable *psi = [[TSProgramSpecificInformationTable alloc]
+                                              initWithTableId:TABLE_ID_SCTE35_SPLICE_INFO
+                                              sectionSyntaxIndicator:0
+                                              reservedBit1:PSI_PRIVATE_BIT
+                                              reservedBits2:PSI_RESERVED_BITS
+                                              sectionLength:sectionLength
+                                              sectionDataExcludingCrc:sectionDataExcludingCrc
+                                              crc:0];
+    return [self initWithPSI:psi timeline:nil];
+}
+
++(NSData * _Nonnull)makeSpliceInsertWithEventId:(uint32_t)spliceEventId
+                                 isOutOfNetwork:(BOOL)isOutOfNetwork
+                                        ptsTime:(uint64_t)ptsTime
+                                  breakDuration:(uint64_t)breakDuration
+                                   isAutoReturn:(BOOL)isAutoReturn
+                                uniqueProgramId:(uint16_t)uniqueProgramId
+{
+    NSMutableData *command = [NSMutableData dataWithCapacity:20];
+    appendUInt32(command, spliceEventId);
+    // splice_event_cancel_indicator = '0', reserved = '1111111'
+    const uint8_t cancelByte = 0x7F;
+    [command appendBytes:&cancelByte length:1];
+    // out_of_network_indicator, program_splice_flag = '1', duration_flag, splice_immediate_flag = '0',
+    // event_id_compliance_flag = '1', reserved = '111'
+    const BOOL hasDuration = breakDuration > 0;
+    const uint8_t flags = (isOutOfNetwork ? 0x80 : 0x00) | 0x40 | (hasDuration ? 0x20 : 0x00) | 0x0F;
+    [command appendBytes:&flags length:1];
+    // splice_time(): time_specified_flag = '1', reserved = '111111'
+    appendTimestamp33(command, 0xFE, ptsTime & (TS_TIMESTAMP_WRAP - 1));
+    if (hasDuration) {
+        // break_duration(): auto_return, reserved = '111111'
+        appendTimestamp33(command, (isAutoReturn ? 0x80 : 0x00) | 0x7E, breakDuration & (TS_TIMESTAMP_WRAP - 1));
+    }
+    appendUInt16(command, uniqueProgramId);
+    // avail_num, avails_expected: not used
+    const uint8_t avails[] = { 0x00, 0x00 };
+    [command appendBytes:avails length:sizeof(avails)];
+    return command;
+}
+
++(NSData * _Nonnull)makeTimeSignalWithPtsTime:(uint64_t)ptsTime
+{
+    NSMutableData *command = [NSMutableData dataWithCapacity:5];
+    appendTimestamp33(command, 0xFE, ptsTime & (TS_TIMESTAMP_WRAP - 1));
+    return command;
+}
+
+-(NSData * _Nonnull)toTsPacketPayload
+{
+    return [self.psi toTsPacketPayload:self.psi.sectionDataExcludingCrc];
+}
+
+#pragma mark - Demuxer
+
+-(instancetype _Nullable)initWithPSI:(TSProgramSpecificInformationTable * _Nonnull)psi
+                            timeline:(TSProgramTimeline * _Nullable)timeline
+{
+    if (psi.tableId != TABLE_ID_SCTE35_SPLICE_INFO || !psi.sectionDataExcludingCrc) {
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _psi = psi;
+        _spliceTime = kCMTimeInvalid;
+        _timelineSpliceTime = kCMTimeInvalid;
+        _segmentationDescriptors = @[];
+
+        // sectionDataExcludingCrc layout (after section_length):
+        // protocol_version:8, encrypted_packet:1, encryption_algorithm:6, pts_adjustment:33,
+        // cw_index:8, tier:12, splice_command_length:12, splice_command_type:8, splice_command(),
+        // descriptor_loop_length:16, splice_descriptor()..., alignment_stuffing, E_CRC_32 if encrypted
+        TSBitReader reader = TSBitReaderMake(psi.sectionDataExcludingCrc);
+        _protocolVersion = TSBitReaderReadUInt8(&reader);
+        _isEncrypted = TSBitReaderReadBits(&reader, 1);
+        TSBitReaderSkipBits(&reader, 6);
+        _ptsAdjustment = readTimestamp33(&reader);
+        TSBitReaderSkip(&reader, 1);  // cw_index
+        _tier = TSBitReaderReadBits(&reader, 12);
+        const uint16_t commandLength = TSBitReaderReadBits(&reader, 12);
+        if (reader.error) {
+            TSLogWarn(@"SCTE-35: splice_info_section header truncated");
+            return nil;
+        }
+        if (_isEncrypted) {
+            // Everything from splice_command_type on is encrypted
+            return self;
+        }
+
+        _spliceCommandType = TSBitReaderReadUInt8(&reader);
+        int64_t spliceTime = -1;
+        if (commandLength == SPLICE_COMMAND_LENGTH_UNKNOWN) {
+            if (!isDecodedCommand(_spliceCommandType)) {
+                // Neither the command nor the descriptors after it can be located
+                return self;
+            }
+            spliceTime = [self readCommand:&reader];
+        } else {
+            TSBitReader commandReader = TSBitReaderSubReader(&reader, commandLength);
+            spliceTime = [self readCommand:&commandReader];
+            reader.error |= commandReader.error;
+        }
+        if (reader.error) {
+            TSLogWarn(@"SCTE-35: splice command 0x%02X truncated", _spliceCommandType);
+            return nil;
+        }
+        if (spliceTime >= 0) {
+            _spliceTime = CMTimeMake(spliceTime, 90000);
+            _timelineSpliceTime = timeline
+                ? CMTimeMake([timeline projectedValueForTimestamp:(uint64_t)spliceTime], 90000)
+                : _spliceTime;
+        }
+
+        const uint16_t descriptorLoopLength = TSBitReaderReadUInt16BE(&reader);
+        TSBitReader loopReader = TSBitReaderSubReader(&reader, descriptorLoopLength);
+        if (reader.error) {
+            TSLogWarn(@"SCTE-35: descriptor loop truncated");
+            return nil;
+        }
+        _segmentationDescriptors = [self readSegmentationDescriptors:&loopReader];
+    }
+    return self;
+}
+
+/// Reads the splice command of `spliceCommandType`. Returns the adjusted splice time, or -1.
+-(int64_t)readCommand:(TSBitReader *)reader
+{
+    switch (self.spliceCommandType) {
+        case TSScte35SpliceCommandTypeSpliceInsert: {
+            int64_t spliceTime = -1;
+            _spliceInsert = [[TSScte35SpliceInsert alloc] initWithReader:reader
+                                                           ptsAdjustment:self.ptsAdjustment
+                                                       programSpliceTime:&spliceTime];
+            if (!_spliceInsert) {
+                reader->error = YES;
+            }
+            return spliceTime;
+        }
+        case TSScte35SpliceCommandTypeTimeSignal: {
+            const int64_t spliceTime = readSpliceTime(reader);
+            return spliceTime >= 0 && !reader->error ? (int64_t)adjustedTime(spliceTime, self.ptsAdjustment) : -1;
+        }
+        default:
+            // splice_null() and bandwidth_reservation() are empty; splice_schedule() and
+            // private_command() are not decoded
+            return -1;
+    }
+}
+
+-(NSArray<TSScte35SegmentationDescriptor*> *)readSegmentationDescriptors:(TSBitReader *)reader
+{
+    NSMutableArray<TSScte35SegmentationDescriptor*> *descriptors = [NSMutableArray array];
+    while (TSBitReaderRemainingBytes(reader) >= 2) {
+        const uint8_t tag = TSBitReaderReadUInt8(reader);
+        const uint8_t length = TSBitReaderReadUInt8(reader);
+        TSBitReader descriptorReader = TSBitReaderSubReader(reader, length);
+        if (reader->error) {
+            TSLogWarn(@"SCTE-35: splice descriptor 0x%02X truncated", tag);
+            break;
+        }
+        if (tag == TSScte35SpliceDescriptorTagSegmentation) {
+            TSScte35SegmentationDescriptor *descriptor = [[TSScte35SegmentationDescriptor alloc]
+                                                          initWithBytes:descriptorReader.bytes
+                                                          length:descriptorReader.length];
+            if (descriptor) {
+                [descriptors addObject:descriptor];
+            }
+        }
+    }
+    return descriptors;
+}
+
+-(NSString*)description
+{
+    NSMutableString *description = [NSMutableString stringWithFormat:@"{ SCTE-35 command: 0x%02X", self.spliceCommandType];
+    if (CMTIME_IS_VALID(self.spliceTime)) {
+        [description appendFormat:@", time: %lld", self.spliceTime.value];
+    }
+    if (self.spliceInsert) {
+        [description appendFormat:@", %@", self.spliceInsert];
+    }
+    for (TSScte35SegmentationDescriptor *descriptor in self.segmentationDescriptors) {
+        [description appendFormat:@", %@", descriptor];
+    }
+    [description appendString:@" }"];
+    return description;
+}
+
+@end
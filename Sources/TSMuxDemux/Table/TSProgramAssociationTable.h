@@ -28,6 +28,10 @@ typedef Pid PmtPid;
 -(instancetype _Nullable)initWithTransportStreamId:(uint16_t)transportStreamId
                                         programmes:(NSDictionary<ProgramNumber, PmtPid> * _Nonnull)programmes;
 
+-(instancetype _Nullable)initWithTransportStreamId:(uint16_t)transportStreamId
+                                     versionNumber:(uint8_t)versionNumber
+                                        programmes:(NSDictionary<ProgramNumber, PmtPid> * _Nonnull)programmes;
+
 -(NSData* _Nonnull)toTsPacketPayload;
 
 #pragma mark Demuxer
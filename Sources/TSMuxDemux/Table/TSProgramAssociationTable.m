@@ -21,12 +21,19 @@
 
 -(instancetype _Nullable)initWithTransportStreamId:(uint16_t)transportStreamId
                                         programmes:(NSDictionary<ProgramNumber, PmtPid> * _Nonnull)programmes
+{
+    return [self initWithTransportStreamId:transportStreamId versionNumber:0 programmes:programmes];
+}
+
+-(instancetype _Nullable)initWithTransportStreamId:(uint16_t)transportStreamId
+                                     versionNumber:(uint8_t)versionNumber
+                                        programmes:(NSDictionary<ProgramNumber, PmtPid> * _Nonnull)programmes
 {
     self = [super init];
     if (self) {
         
         NSData *sectionDataExcludingCrc = [TSProgramAssociationTable makeSectionDataFromTransportStreamId:transportStreamId
-                                                                                            versionNumber:0
+                                                                                            versionNumber:versionNumber
                                                                                      currentNextIndicator:YES
                                                                                             sectionNumber:0
                                                                                         lastSectionNumber:0
@@ -13,6 +13,9 @@
 
 /// See "Rec. ITU-T H.222.0 (03/2017)"
 /// section "2.4.4.8 Program map table"         page 54
+///
+/// Descriptors and elementary streams are decoded on first access and memoised.
+/// Two tables are equal when their section bytes are.
 @interface TSProgramMapTable : NSObject
 
 @property(nonatomic, readonly) TSProgramSpecificInformationTable * _Nonnull psi;
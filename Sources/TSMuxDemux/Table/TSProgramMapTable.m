@@ -12,11 +12,19 @@
 #import "../Descriptor/TSRegistrationDescriptor.h"
 #import "../TSLog.h"
 #import "../TSBitReader.h"
+#import "TSSectionEntryIndex.h"
+#import <os/lock.h>
 
 #define ELEMENTARY_STREAM_BYTE_LENGTH 5
+// pcrPid:2 + programInfoLength:2 following the common section bytes
+#define PROGRAM_INFO_OFFSET 9
 
 @implementation TSProgramMapTable
 {
+    os_unfair_lock _lock;
+    BOOL _programDescriptorsDecoded;
+    NSArray<TSDescriptor*> *_programDescriptors;
+    TSSectionEntryIndex<TSElementaryStream*> *_streamIndex;
     NSSet<TSElementaryStream*> *_elementaryStreams;
 }
 
@@ -46,6 +54,7 @@
                 sectionLength:sectionDataExcludingCrc.length + PSI_CRC_LEN
                 sectionDataExcludingCrc:sectionDataExcludingCrc
                 crc:0];
+        _lock = OS_UNFAIR_LOCK_INIT;
     }
     return self;
 }
@@ -153,6 +162,7 @@
     self = [super init];
     if (self) {
         _psi = psi;
+        _lock = OS_UNFAIR_LOCK_INIT;
     }
     
     return self;
@@ -186,119 +196,105 @@
 
 -(NSArray<TSDescriptor*> * _Nullable)programDescriptors
 {
-    NSMutableArray<TSDescriptor*> *programDescriptors = [NSMutableArray array];
-    uint16_t programInfoLength = self.programInfoLength;
-    if (programInfoLength == 0) return programDescriptors;
-
-    NSUInteger dataLength = self.psi.sectionDataExcludingCrc.length;
-    if (9 + programInfoLength > dataLength) return programDescriptors;
-
-    TSBitReader reader = TSBitReaderMakeWithBytes(
-        (const uint8_t *)self.psi.sectionDataExcludingCrc.bytes + 9,
-        programInfoLength);
-
-    while (TSBitReaderRemainingBytes(&reader) >= 2) {
-        uint8_t descriptorTag = TSBitReaderReadUInt8(&reader);
-        uint8_t descriptorLength = TSBitReaderReadUInt8(&reader);
-
-        if (reader.error || TSBitReaderRemainingBytes(&reader) < descriptorLength) {
-            TSLogWarn(@"PMT: program descriptor truncated");
-            break;
-        }
-
-        NSData *descriptorPayload = descriptorLength > 0
-            ? TSBitReaderReadData(&reader, descriptorLength)
-            : nil;
-
-        TSDescriptor *programDescriptor = [TSDescriptor makeWithTag:descriptorTag
-                                                             length:descriptorLength
-                                                               data:descriptorPayload];
-        if (programDescriptor) {
-            [programDescriptors addObject:programDescriptor];
+    os_unfair_lock_lock(&_lock);
+    if (!_programDescriptorsDecoded) {
+        const uint16_t programInfoLength = self.programInfoLength;
+        if (programInfoLength > 0 && PROGRAM_INFO_OFFSET + programInfoLength <= self.psi.sectionDataExcludingCrc.length) {
+            _programDescriptors = [TSDescriptor descriptorsFromLoopBytes:(const uint8_t *)self.psi.sectionDataExcludingCrc.bytes + PROGRAM_INFO_OFFSET
+                                                                  length:programInfoLength];
+        } else {
+            _programDescriptors = @[];
         }
+        _programDescriptorsDecoded = YES;
     }
-
+    NSArray<TSDescriptor*> *programDescriptors = _programDescriptors;
+    os_unfair_lock_unlock(&_lock);
     return programDescriptors;
 }
 
--(TSElementaryStream* _Nullable)elementaryStreamWithPid:(uint16_t)pid
+-(TSSectionEntryIndex<TSElementaryStream*> *)streamIndex
 {
-    for (TSElementaryStream *es in self.elementaryStreams) {
-        if (es.pid == pid) return es;
+    os_unfair_lock_lock(&_lock);
+    if (!_streamIndex) {
+        _streamIndex = [TSProgramMapTable makeStreamIndexWithSectionData:self.psi.sectionDataExcludingCrc
+                                                          esDataStart:PROGRAM_INFO_OFFSET + self.programInfoLength];
     }
-    return nil;
+    TSSectionEntryIndex *streamIndex = _streamIndex;
+    os_unfair_lock_unlock(&_lock);
+    return streamIndex;
 }
 
--(NSSet<TSElementaryStream*> * _Nonnull)elementaryStreams
++(TSSectionEntryIndex<TSElementaryStream*> *)makeStreamIndexWithSectionData:(NSData *)data
+                                                                esDataStart:(NSUInteger)esDataStart
 {
-    if (_elementaryStreams) {
-        return _elementaryStreams;
-    }
-
-    NSMutableSet *result = [NSMutableSet set];
-    NSUInteger esDataStart = 9 + self.programInfoLength;
-    NSUInteger dataLength = self.psi.sectionDataExcludingCrc.length;
-
-    if (esDataStart >= dataLength) {
-        _elementaryStreams = result;
-        return _elementaryStreams;
-    }
-
-    TSBitReader reader = TSBitReaderMakeWithBytes(
-        (const uint8_t *)self.psi.sectionDataExcludingCrc.bytes + esDataStart,
-        dataLength - esDataStart);
+    NSMutableData *ranges = [NSMutableData data];
+    NSUInteger count = 0;
+    const uint8_t *bytes = data.bytes;
+    NSUInteger offset = esDataStart;
 
     // Each ES entry requires at minimum 5 bytes (1 stream_type + 2 PID + 2 ES_info_length)
-    while (TSBitReaderRemainingBytes(&reader) >= 5) {
-        // 8 bits: stream_type
-        const uint8_t esStreamType = TSBitReaderReadUInt8(&reader);
-        // 3 bits: reserved, 13 bits: elementary PID
-        TSBitReaderSkipBits(&reader, 3);
-        const uint16_t esPid = TSBitReaderReadBits(&reader, 13);
+    while (offset + ELEMENTARY_STREAM_BYTE_LENGTH <= data.length) {
         // 4 bits: reserved, 12 bits: ES_info_length
-        TSBitReaderSkipBits(&reader, 4);
-        const uint16_t esInfoLength = TSBitReaderReadBits(&reader, 12);
-
-        if (reader.error) {
-            TSLogWarn(@"PMT: read error while parsing ES entry for PID 0x%04X", esPid);
-            break;
+        const uint16_t esInfoLength = ((bytes[offset + 3] & 0x0F) << 8) | bytes[offset + 4];
+        NSRange range = NSMakeRange(offset, ELEMENTARY_STREAM_BYTE_LENGTH + esInfoLength);
+        if (NSMaxRange(range) > data.length) {
+            TSLogWarn(@"PMT: ES descriptors truncated for PID 0x%04X", ((bytes[offset + 1] & 0x1F) << 8) | bytes[offset + 2]);
+            range.length = data.length - offset;
         }
+        [ranges appendBytes:&range length:sizeof(range)];
+        count++;
+        offset = NSMaxRange(range);
+    }
+
+    return [[TSSectionEntryIndex alloc] initWithSectionData:data
+                                                     ranges:ranges.bytes
+                                                      count:count
+                                                    decoder:^id(NSData *sectionData, NSRange range) {
+        const uint8_t *entry = (const uint8_t *)sectionData.bytes + range.location;
+        // 8 bits: stream_type, 3 bits: reserved, 13 bits: elementary PID
+        const uint8_t esStreamType = entry[0];
+        const uint16_t esPid = ((entry[1] & 0x1F) << 8) | entry[2];
+        NSArray<TSDescriptor*> *esDescriptors = range.length > ELEMENTARY_STREAM_BYTE_LENGTH
+            ? [TSDescriptor descriptorsFromLoopBytes:entry + ELEMENTARY_STREAM_BYTE_LENGTH
+                                              length:range.length - ELEMENTARY_STREAM_BYTE_LENGTH]
+            : nil;
+        return [[TSElementaryStream alloc] initWithPid:esPid
+                                            streamType:esStreamType
+                                           descriptors:esDescriptors];
+    }];
+}
 
-        NSMutableArray<TSDescriptor*> *esDescriptors = nil;
-        if (esInfoLength > 0) {
-            esDescriptors = [NSMutableArray array];
-            TSBitReader descReader = TSBitReaderSubReader(&reader, esInfoLength);
-
-            while (TSBitReaderRemainingBytes(&descReader) >= 2) {
-                uint8_t descriptorTag = TSBitReaderReadUInt8(&descReader);
-                uint8_t descriptorLength = TSBitReaderReadUInt8(&descReader);
-
-                if (descReader.error || TSBitReaderRemainingBytes(&descReader) < descriptorLength) {
-                    TSLogWarn(@"PMT: ES descriptor truncated for PID 0x%04X", esPid);
-                    break;
-                }
-
-                NSData *descriptorPayload = descriptorLength > 0
-                    ? TSBitReaderReadData(&descReader, descriptorLength)
-                    : nil;
-
-                TSDescriptor *esDescriptor = [TSDescriptor makeWithTag:descriptorTag
-                                                                length:descriptorLength
-                                                                  data:descriptorPayload];
-                if (esDescriptor) {
-                    [esDescriptors addObject:esDescriptor];
-                }
-            }
+-(TSElementaryStream* _Nullable)elementaryStreamWithPid:(uint16_t)pid
+{
+    // Matched on the raw entries so that only the requested stream is decoded.
+    TSSectionEntryIndex<TSElementaryStream*> *streamIndex = self.streamIndex;
+    for (NSUInteger i = 0; i < streamIndex.count; ++i) {
+        const uint8_t *entry = [streamIndex bytesAtIndex:i];
+        if ((((entry[1] & 0x1F) << 8) | entry[2]) == pid) {
+            return [streamIndex objectAtIndex:i];
         }
+    }
+    return nil;
+}
 
-        TSElementaryStream *stream = [[TSElementaryStream alloc] initWithPid:esPid
-                                                                  streamType:esStreamType
-                                                                 descriptors:esDescriptors];
-        [result addObject:stream];
+-(NSSet<TSElementaryStream*> * _Nonnull)elementaryStreams
+{
+    TSSectionEntryIndex<TSElementaryStream*> *streamIndex = self.streamIndex;
+    os_unfair_lock_lock(&_lock);
+    NSSet<TSElementaryStream*> *elementaryStreams = _elementaryStreams;
+    os_unfair_lock_unlock(&_lock);
+    if (elementaryStreams) {
+        return elementaryStreams;
     }
 
-    _elementaryStreams = result;
-    return _elementaryStreams;
+    elementaryStreams = [NSSet setWithArray:[streamIndex allObjects]];
+    os_unfair_lock_lock(&_lock);
+    if (!_elementaryStreams) {
+        _elementaryStreams = elementaryStreams;
+    }
+    elementaryStreams = _elementaryStreams;
+    os_unfair_lock_unlock(&_lock);
+    return elementaryStreams;
 }
 
 #pragma mark - Overridden
@@ -316,14 +312,13 @@
 
 -(BOOL)isEqualToPmt:(TSProgramMapTable *)pmt
 {
-    return self.programNumber == pmt.programNumber
-    && self.psi.versionNumber == pmt.psi.versionNumber
-    && [self.elementaryStreams isEqual:pmt.elementaryStreams];
+    // The section bytes cover program number, version, PCR PID, descriptors and every stream.
+    return [self.psi.sectionDataExcludingCrc isEqualToData:pmt.psi.sectionDataExcludingCrc];
 }
 
 -(NSUInteger)hash
 {
-    return self.programNumber ^ (self.psi.versionNumber << 16) ^ self.elementaryStreams.hash;
+    return self.programNumber ^ (self.psi.versionNumber << 16) ^ self.psi.sectionDataExcludingCrc.hash;
 }
 
 -(NSString*)description
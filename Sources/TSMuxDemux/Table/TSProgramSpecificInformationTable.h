@@ -11,6 +11,8 @@
 #define PSI_PRIVATE_BIT 0x00
 #define PSI_RESERVED_BITS 0x03
 #define PSI_CRC_LEN 4
+/// Private sections (e.g. DVB SI, ATSC PSIP) may be up to 4096 bytes; PAT/PMT/CAT stay below 1024.
+#define PSI_MAX_SECTION_LENGTH 4093
 
 @interface TSProgramSpecificInformationTable : NSObject
 
@@ -20,7 +22,8 @@
 @property(nonatomic, readonly) uint8_t reservedBits2;
 
 /// The number of bytes of the section immediately following the section_length field, and including the CRC.
-/// The value in this field shall not exceed 1021 (0x3FD).
+/// The value in this field shall not exceed 1021 (0x3FD) for PAT/PMT/CAT, or 4093 (0xFFD) for private sections.
+/// For a table aggregated from several sections it is capped at 4093; use sectionDataExcludingCrc.length.
 @property(nonatomic, readonly) uint16_t sectionLength;
 /// 'sectionData' property is null in the muxer flow (since the PAT/PMT serialize and inject themselves as sectionData)
 /// 'sectionData' property is non-null in the demuxer flow (since the sectionData is received over the network)
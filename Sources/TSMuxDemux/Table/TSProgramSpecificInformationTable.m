@@ -33,11 +33,14 @@
     [data appendBytes:&_tableId length:1];
     
     // PSI byte 2:
-    // bit 1:           section syntax indicator = '1'
-    // bit 2:           constant = '0'
+    // bit 1:           section syntax indicator (PAT/PMT: '1', SCTE-35: '0')
+    // bit 2:           private bit = '0'
     // bit 3-4:         reserved = '11'
     // bit 5-8:         4 MSB of section length (a 12-bit field) specifying the number of bytes of the section starting immediately following the section_length field, and including the CRC
-    const uint8_t byte2 = 0x80 | 0x30 | ((sectionLength >> 8) & 0x0F);
+    const uint8_t byte2 = ((_sectionSyntaxIndicator & 0x01) << 7)
+        | ((_reservedBit1 & 0x01) << 6)
+        | ((_reservedBits2 & 0x03) << 4)
+        | ((sectionLength >> 8) & 0x0F);
     [data appendBytes:&byte2 length:1];
     
     // PSI byte 3:      8 LSB of section length
@@ -67,7 +70,7 @@
                                      crc:(uint32_t)crc
 {
     
-    if (sectionLength > 1021) {
+    if (sectionLength > PSI_MAX_SECTION_LENGTH) {
         TSLogWarnC(@"Invalid PSI section length: %u", sectionLength);
         return nil;
     }
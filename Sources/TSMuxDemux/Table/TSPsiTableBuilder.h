@@ -8,6 +8,7 @@
 
 #import <Foundation/Foundation.h>
 #import "../TSAccessUnit.h"
+#import "../TSContinuityState.h"
 @class TSPacket;
 @class TSPsiTableBuilder;
 @class TSProgramSpecificInformationTable;
@@ -27,9 +28,29 @@
 @property(nonatomic, readonly) uint8_t streamType;
 @property(nonatomic, readonly, nullable) NSArray<TSDescriptor*>* descriptors;
 
+/// If YES (the default), the sections of a multi-section table are collected and delivered as one
+/// aggregated table once all have arrived. Sub-tables (table_id + table_id_extension) are collected
+/// independently, so e.g. NIT actual and NIT other may be interleaved on one PID. If NO, every complete section is delivered as-is, which
+/// suits PIDs carrying many interleaved sub-tables (e.g. DVB EIT).
+@property(nonatomic) BOOL aggregatesSections;
+
+/// If YES, a section whose table_id, table_id_extension, section_number and version match one
+/// already delivered is skipped as soon as its header has been read, without collecting its
+/// payload. Only for tables whose content changes with the version (e.g. not the ATSC STT).
+/// Default NO. With aggregatesSections, sections count as delivered once their whole table has been.
+@property(nonatomic) BOOL skipsRepeatedSections;
+/// Sections skipped because of skipsRepeatedSections.
+@property(nonatomic, readonly) NSUInteger skippedSectionCount;
+
+/// Forgets the sections delivered so far, so that each is delivered again when it next repeats.
+-(void)forgetDeliveredSections;
+
 -(instancetype _Nonnull)initWithDelegate:(id<TSPsiTableBuilderDelegate> _Nullable)delegate
                                      pid:(uint16_t)pid;
 
+/// Checks the continuity counter against the last packet added.
 -(void)addTsPacket:(TSPacket* _Nonnull)tsPacket;
+/// Adds a packet whose continuity counter was already checked, e.g. by the demuxer for all PIDs at once.
+-(void)addTsPacket:(TSPacket* _Nonnull)tsPacket continuity:(TSContinuityVerdict)continuity;
 
 @end
@@ -8,21 +8,25 @@
 
 #import "TSPsiTableBuilder.h"
 #import "../TSPacket.h"
-#import "../TSContinuityChecker.h"
 #import "../TSLog.h"
 #import "../TSBitReader.h"
+#import "../TSConstants.h"
 #import "TSProgramSpecificInformationTable.h"
 #import <CoreMedia/CoreMedia.h>
 
 @interface TSPsiTableBuilder()
 
-@property(nonatomic, strong) TSContinuityChecker *ccChecker;
-
 /// Byte-level: accumulates one section spanning multiple TS packets (e.g. 400-byte PMT needs 3 packets)
 @property(nonatomic, strong) TSProgramSpecificInformationTable *sectionInProgress;
-/// Section-level: collects complete sections of one table (e.g. large SDT with lastSectionNumber=3)
-/// Key = section number.
-@property(nonatomic, strong) NSMutableDictionary<NSNumber*, TSProgramSpecificInformationTable*> *pendingSections;
+/// Section-level: collects complete sections of multi-section tables (e.g. large SDT with lastSectionNumber=3),
+/// per sub-table so that interleaved sub-tables (NIT actual and other) can be collected at the same time.
+/// Key = tableId << 16 | tableIdExtension, then section number.
+@property(nonatomic, strong) NSMutableDictionary<NSNumber*, NSMutableDictionary<NSNumber*, TSProgramSpecificInformationTable*>*> *pendingSections;
+
+/// Used with skipsRepeatedSections. Key = tableId << 24 | tableIdExtension << 8 | sectionNumber, value = version.
+@property(nonatomic, strong) NSMutableDictionary<NSNumber*, NSNumber*> *deliveredVersions;
+/// Bytes still to be discarded of a section being skipped.
+@property(nonatomic) NSUInteger bytesToSkip;
 
 @end
 
@@ -42,6 +46,9 @@
  -
  */
 @implementation TSPsiTableBuilder
+{
+    TSContinuityState _ccState;
+}
 
 -(instancetype _Nonnull)initWithDelegate:(id<TSPsiTableBuilderDelegate>)delegate
                                      pid:(uint16_t)pid
@@ -50,33 +57,65 @@
     if (self) {
         _delegate = delegate;
         _pid = pid;
-        _ccChecker = [[TSContinuityChecker alloc] init];
         _pendingSections = [NSMutableDictionary dictionary];
+        _aggregatesSections = YES;
+        _deliveredVersions = [NSMutableDictionary dictionary];
     }
     return self;
 }
 
+-(void)forgetDeliveredSections
+{
+    [self.deliveredVersions removeAllObjects];
+}
+
+static inline NSNumber *sectionKey(uint8_t tableId, const uint8_t *sectionDataExcludingCrc)
+{
+    const uint16_t tableIdExtension = (sectionDataExcludingCrc[0] << 8) | sectionDataExcludingCrc[1];
+    return @(((uint32_t)tableId << 24) | ((uint32_t)tableIdExtension << 8) | sectionDataExcludingCrc[3]);
+}
+
+/// Length of the CRC_32 ending a section. The DVB TDT (EN 300 468 5.2.5) is the one section without:
+/// its section_syntax_indicator is 0 and its 5 bytes after section_length are all UTC_time.
+static inline NSUInteger crcLengthOfSection(TSProgramSpecificInformationTable *section)
+{
+    return section.tableId == TABLE_ID_DVB_TDT ? 0 : PSI_CRC_LEN;
+}
+
+static inline NSNumber *subTableKey(TSProgramSpecificInformationTable *section)
+{
+    return @(((uint32_t)section.tableId << 16) | section.byte4And5);
+}
+
 -(void)addTsPacket:(TSPacket* _Nonnull)tsPacket
 {
     if (tsPacket.header.pid != self.pid) {
         TSLogWarn(@"PID mismatch (got %u, expected %u)", tsPacket.header.pid, self.pid);
         return;
     }
+    [self addTsPacket:tsPacket continuity:TSContinuityStateCheckPacket(&_ccState, tsPacket)];
+}
 
-    TSContinuityCheckResult ccResult = [self.ccChecker checkPacket:tsPacket];
+-(void)addTsPacket:(TSPacket* _Nonnull)tsPacket continuity:(TSContinuityVerdict)continuity
+{
+    if (tsPacket.header.pid != self.pid) {
+        TSLogWarn(@"PID mismatch (got %u, expected %u)", tsPacket.header.pid, self.pid);
+        return;
+    }
 
-    if (ccResult == TSContinuityCheckResultGap) {
+    if (continuity.result == TSContinuityCheckResultGap) {
         // Packets were lost - discard in-progress table and pending sections to avoid corrupted data
         if (self.sectionInProgress || self.pendingSections.count > 0) {
-            TSLogWarn(@"CC gap on PID 0x%04x (packets lost), discarding incomplete table 0x%02x and %lu pending sections",
+            TSLogWarn(@"CC gap on PID 0x%04x (packets lost), discarding incomplete table 0x%02x and %lu pending tables",
                   self.pid, self.sectionInProgress.tableId, (unsigned long)self.pendingSections.count);
         }
         self.sectionInProgress = nil;
         [self.pendingSections removeAllObjects];
+        self.bytesToSkip = 0;
         return;
     }
 
-    if (ccResult == TSContinuityCheckResultDuplicate) {
+    if (continuity.result == TSContinuityCheckResultDuplicate) {
         return;
     }
 
@@ -99,14 +138,18 @@
         }
 
         // If pointer_field > 0, bytes before pointer are continuation of previous section
-        if (pointerField > 0 && self.sectionInProgress) {
+        if (self.bytesToSkip > 0) {
+            // The skipped section ends within the pointer bytes
+            self.bytesToSkip = 0;
+        } else if (pointerField > 0 && self.sectionInProgress) {
             // Complete the in-progress section with continuation bytes
             NSData *continuationData = [tsPacket.payload subdataWithRange:NSMakeRange(offset, pointerField)];
             NSUInteger remainingBytesInTable = self.sectionInProgress.sectionLength - self.sectionInProgress.sectionDataExcludingCrc.length;
+            const NSUInteger crcLength = crcLengthOfSection(self.sectionInProgress);
 
-            if (remainingBytesInTable >= PSI_CRC_LEN && pointerField >= remainingBytesInTable) {
+            if (remainingBytesInTable >= crcLength && pointerField >= remainingBytesInTable) {
                 // Section completes within continuation bytes
-                NSUInteger dataBytesNeeded = remainingBytesInTable - PSI_CRC_LEN;
+                NSUInteger dataBytesNeeded = remainingBytesInTable - crcLength;
                 NSData *finalDataNoCrc = [continuationData subdataWithRange:NSMakeRange(0, dataBytesNeeded)];
 
                 NSMutableData *completeData = [NSMutableData dataWithData:self.sectionInProgress.sectionDataExcludingCrc];
@@ -114,13 +157,12 @@
                 self.sectionInProgress.sectionDataExcludingCrc = [NSData dataWithData:completeData];
 
                 // Read CRC
-                if (dataBytesNeeded + PSI_CRC_LEN <= pointerField) {
+                if (crcLength > 0) {
                     TSBitReader crcReader = TSBitReaderMakeWithBytes(
                         (const uint8_t *)continuationData.bytes + dataBytesNeeded, PSI_CRC_LEN);
                     self.sectionInProgress.crc = TSBitReaderReadUInt32BE(&crcReader);
-
-                    [self deliverCompletedSection:self.sectionInProgress];
                 }
+                [self deliverCompletedSection:self.sectionInProgress];
                 self.sectionInProgress = nil;
             } else {
                 // Not enough continuation bytes or invalid state - discard
@@ -137,6 +179,10 @@
 
         // Move offset past pointer_field bytes to start of new section
         offset += pointerField;
+    } else if (self.bytesToSkip > 0) {
+        // No section can start in a packet without PUSI
+        self.bytesToSkip -= MIN(self.bytesToSkip, tsPacket.payload.length);
+        return;
     } else if (!self.sectionInProgress) {
         TSLogDebug(@"Waiting for start of PSI PID 0x%04x (no section in progress)", self.pid);
         return;
@@ -153,6 +199,17 @@
         if (!table) {
             break;
         }
+
+        if (!self.sectionInProgress && [self isRepeatedSection:table payload:tsPacket.payload offset:offset]) {
+            _skippedSectionCount++;
+            const NSUInteger remainingBytesInPacket = tsPacket.payload.length - offset;
+            if (table.sectionLength > remainingBytesInPacket) {
+                self.bytesToSkip = table.sectionLength - remainingBytesInPacket;
+                break;
+            }
+            offset += table.sectionLength;
+            continue;
+        }
         
         const NSUInteger remainingBytesInPacket = tsPacket.payload.length - offset;
         if (remainingBytesInPacket == 0) {
@@ -163,11 +220,12 @@
         if (self.sectionInProgress) {
             remainingBytesInTable -= self.sectionInProgress.sectionDataExcludingCrc.length;
         }
-        
-        // Validate section_length is at least PSI_CRC_LEN to prevent unsigned underflow
-        if (remainingBytesInTable < PSI_CRC_LEN) {
-            TSLogError(@"Invalid PSI section_length %lu (less than CRC size %d)",
-                       (unsigned long)remainingBytesInTable, PSI_CRC_LEN);
+        const NSUInteger crcLength = crcLengthOfSection(table);
+
+        // Validate section_length is at least the CRC length to prevent unsigned underflow
+        if (remainingBytesInTable < crcLength) {
+            TSLogError(@"Invalid PSI section_length %lu (less than CRC size %lu)",
+                       (unsigned long)remainingBytesInTable, (unsigned long)crcLength);
             self.sectionInProgress = nil;
             break;
         }
@@ -175,7 +233,7 @@
         BOOL tableFitsInCurrentPacket = remainingBytesInTable <= remainingBytesInPacket;
         if (tableFitsInCurrentPacket) {
             NSData *readSectionDataNoCrc = [tsPacket.payload subdataWithRange:
-                                                        NSMakeRange(offset, remainingBytesInTable - PSI_CRC_LEN)];
+                                                        NSMakeRange(offset, remainingBytesInTable - crcLength)];
             offset+=readSectionDataNoCrc.length;
             
             // TODO: Performance improvement - use persistent mutable buffer instead of copying on each append
@@ -187,21 +245,23 @@
             }
             table.sectionDataExcludingCrc = sectionDataExcludingCrc;
 
-            if (offset + PSI_CRC_LEN > tsPacket.payload.length) {
-                TSLogWarn(@"PSI: insufficient bytes for CRC on PID 0x%04X", self.pid);
-                self.sectionInProgress = nil;
-                break;
-            }
-            TSBitReader crcReader = TSBitReaderMakeWithBytes(
-                (const uint8_t *)tsPacket.payload.bytes + offset, PSI_CRC_LEN);
-            uint32_t crc = TSBitReaderReadUInt32BE(&crcReader);
-            if (crcReader.error) {
-                TSLogWarn(@"PSI: failed to read CRC on PID 0x%04X", self.pid);
-                self.sectionInProgress = nil;
-                break;
+            if (crcLength > 0) {
+                if (offset + PSI_CRC_LEN > tsPacket.payload.length) {
+                    TSLogWarn(@"PSI: insufficient bytes for CRC on PID 0x%04X", self.pid);
+                    self.sectionInProgress = nil;
+                    break;
+                }
+                TSBitReader crcReader = TSBitReaderMakeWithBytes(
+                    (const uint8_t *)tsPacket.payload.bytes + offset, PSI_CRC_LEN);
+                uint32_t crc = TSBitReaderReadUInt32BE(&crcReader);
+                if (crcReader.error) {
+                    TSLogWarn(@"PSI: failed to read CRC on PID 0x%04X", self.pid);
+                    self.sectionInProgress = nil;
+                    break;
+                }
+                offset += PSI_CRC_LEN;
+                table.crc = crc;
             }
-            offset += PSI_CRC_LEN;
-            table.crc = crc;
 
             [self deliverCompletedSection:table];
             self.sectionInProgress = nil;
@@ -221,40 +281,73 @@
     } // end while / no more packet data
 }
 
+/// YES if the section starting at `offset` (just after section_length) was delivered before at the same
+/// version. Sections whose version byte is not in this packet are never considered repeated.
+-(BOOL)isRepeatedSection:(TSProgramSpecificInformationTable *)section payload:(NSData *)payload offset:(NSUInteger)offset
+{
+    // table_id_extension:2 + version/current_next:1 + section_number:1
+    if (!self.skipsRepeatedSections || offset + 4 > payload.length) {
+        return NO;
+    }
+    const uint8_t *bytes = (const uint8_t *)payload.bytes + offset;
+    NSNumber *deliveredVersion = self.deliveredVersions[sectionKey(section.tableId, bytes)];
+    return deliveredVersion && deliveredVersion.unsignedCharValue == ((bytes[2] >> 1) & 0x1F);
+}
+
+-(void)recordDeliveredSection:(TSProgramSpecificInformationTable *)section
+{
+    if (self.skipsRepeatedSections && section.sectionDataExcludingCrc.length >= 4) {
+        self.deliveredVersions[sectionKey(section.tableId, section.sectionDataExcludingCrc.bytes)] = @(section.versionNumber);
+    }
+}
+
 /// Handles completed section delivery, collecting multi-section tables until all sections received.
 -(void)deliverCompletedSection:(TSProgramSpecificInformationTable *)section
 {
     uint8_t sectionNumber = section.sectionNumber;
     uint8_t lastSectionNumber = section.lastSectionNumber;
 
-    if (sectionNumber == 0 && lastSectionNumber == 0) {
+    if (!self.aggregatesSections || (sectionNumber == 0 && lastSectionNumber == 0)) {
+        [self recordDeliveredSection:section];
         [self.delegate tableBuilder:self didBuildTable:section];
         return;
     }
 
-    // Multi-section table handling - check if this is a new table (different tableId or version)
-    TSProgramSpecificInformationTable *existingSection = self.pendingSections.allValues.firstObject;
+    // Multi-section table handling - check if this is a new version of the sub-table
+    NSNumber *key = subTableKey(section);
+    NSMutableDictionary<NSNumber*, TSProgramSpecificInformationTable*> *sections = self.pendingSections[key];
+    TSProgramSpecificInformationTable *existingSection = sections.allValues.firstObject;
     if (existingSection &&
-        (section.tableId != existingSection.tableId || section.versionNumber != existingSection.versionNumber)) {
+        (section.versionNumber != existingSection.versionNumber || lastSectionNumber != existingSection.lastSectionNumber)) {
         TSLogDebug(@"New table version on PID 0x%04x (tableId=0x%02x, version=%u), discarding %lu pending sections",
-              self.pid, section.tableId, section.versionNumber, (unsigned long)self.pendingSections.count);
-        [self.pendingSections removeAllObjects];
+              self.pid, section.tableId, section.versionNumber, (unsigned long)sections.count);
+        [sections removeAllObjects];
+    }
+    if (!sections) {
+        sections = [NSMutableDictionary dictionary];
+        self.pendingSections[key] = sections;
     }
 
-    self.pendingSections[@(sectionNumber)] = section;
+    sections[@(sectionNumber)] = section;
 
     // Check if we have all sections (0 through lastSectionNumber)
-    if (self.pendingSections.count == (NSUInteger)(lastSectionNumber + 1)) {
-        TSProgramSpecificInformationTable *aggregated = [self aggregatePendingSections];
-        [self.delegate tableBuilder:self didBuildTable:aggregated];
-        [self.pendingSections removeAllObjects];
+    if (sections.count == (NSUInteger)(lastSectionNumber + 1)) {
+        [self.pendingSections removeObjectForKey:key];
+        TSProgramSpecificInformationTable *aggregated = [self aggregateSections:sections];
+        if (aggregated) {
+            // Only now: a repeat of an already collected section must still complete the table.
+            for (TSProgramSpecificInformationTable *collected in sections.allValues) {
+                [self recordDeliveredSection:collected];
+            }
+            [self.delegate tableBuilder:self didBuildTable:aggregated];
+        }
     }
 }
 
-/// Aggregates all pending sections into a single table with combined payload data.
--(TSProgramSpecificInformationTable *)aggregatePendingSections
+/// Aggregates all sections of a sub-table into a single table with combined payload data.
+-(TSProgramSpecificInformationTable *)aggregateSections:(NSDictionary<NSNumber*, TSProgramSpecificInformationTable*> *)sections
 {
-    TSProgramSpecificInformationTable *section0 = self.pendingSections[@0];
+    TSProgramSpecificInformationTable *section0 = sections[@0];
 
     // sectionDataExcludingCrc layout:
     // Bytes 0-1: tableIdExtension
@@ -284,7 +377,7 @@
 
     // Concatenate table-specific payload from all sections in order
     for (uint8_t i = 0; i <= section0.lastSectionNumber; i++) {
-        TSProgramSpecificInformationTable *section = self.pendingSections[@(i)];
+        TSProgramSpecificInformationTable *section = sections[@(i)];
         if (section.sectionDataExcludingCrc.length > kHeaderSize) {
             NSUInteger payloadLength = section.sectionDataExcludingCrc.length - kHeaderSize;
             NSData *payload = [section.sectionDataExcludingCrc subdataWithRange:NSMakeRange(kHeaderSize, payloadLength)];
@@ -298,7 +391,7 @@
                                                      sectionSyntaxIndicator:section0.sectionSyntaxIndicator
                                                      reservedBit1:PSI_PRIVATE_BIT
                                                      reservedBits2:PSI_RESERVED_BITS
-                                                     sectionLength:(uint16_t)(aggregatedData.length + PSI_CRC_LEN)
+                                                     sectionLength:(uint16_t)MIN(aggregatedData.length + PSI_CRC_LEN, PSI_MAX_SECTION_LENGTH)
                                                      sectionDataExcludingCrc:aggregatedData
                                                      crc:0]; // CRC not meaningful for aggregated data
 
@@ -333,7 +426,8 @@
     (*ioOffset) += 3;
 
     const uint8_t sectionSyntaxIndicator = (byte2 & 0x80) >> 7;
-    const uint16_t sectionLength = ((byte2 & 0x03) << 8) | (uint16_t)byte3;
+    // 12 bits: MPEG PSI sections stay below 1024 bytes, but DVB SI sections (e.g. EIT) may use up to 4093.
+    const uint16_t sectionLength = ((byte2 & 0x0F) << 8) | (uint16_t)byte3;
 
     TSProgramSpecificInformationTable *section = [[TSProgramSpecificInformationTable alloc]
                                                   initWithTableId:tableId
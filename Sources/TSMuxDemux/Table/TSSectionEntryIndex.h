@@ -0,0 +1,38 @@
+//
+//  TSSectionEntryIndex.h
+//  TSMuxDemux
+//
+//  Decode-once index over the entry loop of a PSI section.
+//
+
+#import <Foundation/Foundation.h>
+
+/// Creates the entry object for the bytes at `range` of `sectionData`.
+typedef id _Nullable (^TSSectionEntryDecoder)(NSData * _Nonnull sectionData, NSRange range);
+
+/// Byte ranges of the entries in a section's entry loop (PMT streams, SDT services, VCT channels).
+///
+/// The ranges are found with one pass over the section. Entry objects are decoded the first time
+/// they are accessed and then memoised, so a table that is only compared, or looked up by a key
+/// read straight from the raw bytes, never decodes the entries it does not touch. Thread safe.
+@interface TSSectionEntryIndex<__covariant ObjectType> : NSObject
+
+@property(nonatomic, readonly, nonnull) NSData *sectionData;
+@property(nonatomic, readonly) NSUInteger count;
+
+/// @param ranges Byte ranges within `sectionData`, one per entry. Copied.
+/// @param decoder Must not capture the owning table (the index is retained by it).
+-(instancetype _Nonnull)initWithSectionData:(NSData * _Nonnull)sectionData
+                                     ranges:(const NSRange * _Nullable)ranges
+                                      count:(NSUInteger)count
+                                    decoder:(TSSectionEntryDecoder _Nonnull)decoder;
+
+-(NSRange)rangeAtIndex:(NSUInteger)index;
+/// Raw bytes of the entry at `index`, pointing into `sectionData`.
+-(const uint8_t * _Nonnull)bytesAtIndex:(NSUInteger)index;
+
+-(ObjectType _Nullable)objectAtIndex:(NSUInteger)index;
+/// All entries that decoded successfully, in section order.
+-(NSArray<ObjectType> * _Nonnull)allObjects;
+
+@end
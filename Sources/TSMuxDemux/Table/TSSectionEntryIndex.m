@@ -0,0 +1,119 @@
+//
+//  TSSectionEntryIndex.m
+//  TSMuxDemux
+//
+//  Decode-once index over the entry loop of a PSI section.
+//
+
+#import "TSSectionEntryIndex.h"
+#import <os/lock.h>
+
+/// Memoised for entries that failed to decode. Entries not decoded yet hold NSNull.
+static id failedEntryMarker(void)
+{
+    static id marker;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        marker = [[NSObject alloc] init];
+    });
+    return marker;
+}
+
+@implementation TSSectionEntryIndex
+{
+    NSRange *_ranges;
+    TSSectionEntryDecoder _decoder;
+    os_unfair_lock _lock;
+    NSMutableArray *_objects;
+    NSArray *_allObjects;
+}
+
+-(instancetype _Nonnull)initWithSectionData:(NSData * _Nonnull)sectionData
+                                     ranges:(const NSRange * _Nullable)ranges
+                                      count:(NSUInteger)count
+                                    decoder:(TSSectionEntryDecoder _Nonnull)decoder
+{
+    self = [super init];
+    if (self) {
+        _sectionData = sectionData;
+        _count = count;
+        _decoder = [decoder copy];
+        _lock = OS_UNFAIR_LOCK_INIT;
+        if (count > 0) {
+            _ranges = malloc(count * sizeof(NSRange));
+            memcpy(_ranges, ranges, count * sizeof(NSRange));
+        }
+        _objects = [NSMutableArray arrayWithCapacity:count];
+        NSNull *undecoded = [NSNull null];
+        for (NSUInteger i = 0; i < count; ++i) {
+            [_objects addObject:undecoded];
+        }
+    }
+    return self;
+}
+
+-(void)dealloc
+{
+    free(_ranges);
+}
+
+-(NSRange)rangeAtIndex:(NSUInteger)index
+{
+    NSParameterAssert(index < _count);
+    return _ranges[index];
+}
+
+-(const uint8_t * _Nonnull)bytesAtIndex:(NSUInteger)index
+{
+    NSParameterAssert(index < _count);
+    return (const uint8_t *)_sectionData.bytes + _ranges[index].location;
+}
+
+-(id _Nullable)objectAtIndex:(NSUInteger)index
+{
+    NSParameterAssert(index < _count);
+    os_unfair_lock_lock(&_lock);
+    id object = _objects[index];
+    os_unfair_lock_unlock(&_lock);
+    if (object == [NSNull null]) {
+        // Decoded outside the lock; if two threads race, the first result is kept.
+        id decoded = _decoder(_sectionData, _ranges[index]) ?: failedEntryMarker();
+
+        os_unfair_lock_lock(&_lock);
+        object = _objects[index];
+        if (object == [NSNull null]) {
+            _objects[index] = decoded;
+            object = decoded;
+        }
+        os_unfair_lock_unlock(&_lock);
+    }
+    return object == failedEntryMarker() ? nil : object;
+}
+
+-(NSArray * _Nonnull)allObjects
+{
+    os_unfair_lock_lock(&_lock);
+    NSArray *allObjects = _allObjects;
+    os_unfair_lock_unlock(&_lock);
+    if (allObjects) {
+        return allObjects;
+    }
+
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:_count];
+    for (NSUInteger i = 0; i < _count; ++i) {
+        id object = [self objectAtIndex:i];
+        if (object) {
+            [objects addObject:object];
+        }
+    }
+
+    os_unfair_lock_lock(&_lock);
+    if (!_allObjects) {
+        _allObjects = [objects copy];
+    }
+    allObjects = _allObjects;
+    os_unfair_lock_unlock(&_lock);
+    return allObjects;
+}
+
+@end
@@ -0,0 +1,144 @@
+//
+//  TSAssemblyLimitTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for per-PID and demuxer-wide limits on access unit buffering.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kTestPmtPid = 0x100;
+static const uint16_t kTestVideoPid = 0x101;
+static const uint16_t kTestAudioPid = 0x102;
+
+#pragma mark - Test Delegate
+
+@interface TSAssemblyLimitTestDelegate : NSObject <TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@end
+
+@implementation TSAssemblyLimitTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedAccessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSAssemblyLimitTests : XCTestCase
+@property (nonatomic, strong) TSAssemblyLimitTestDelegate *delegate;
+@property (nonatomic, strong) TSDemuxer *demuxer;
+@property (nonatomic, strong) TSElementaryStream *video;
+@property (nonatomic, strong) TSElementaryStream *audio;
+@end
+
+@implementation TSAssemblyLimitTests
+
+- (void)setUp {
+    [super setUp];
+    self.delegate = [[TSAssemblyLimitTestDelegate alloc] init];
+    self.demuxer = [[TSDemuxer alloc] initWithDelegate:self.delegate mode:TSDemuxerModeDVB];
+    self.video = [[TSElementaryStream alloc] initWithPid:kTestVideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    self.audio = [[TSElementaryStream alloc] initWithPid:kTestAudioPid streamType:kRawStreamTypeADTSAAC descriptors:nil];
+
+    NSMutableData *psi = [NSMutableData data];
+    [psi appendData:[TSTestUtils createPatDataWithPmtPid:kTestPmtPid]];
+    [psi appendData:[TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                                  pcrPid:kTestVideoPid
+                                                 streams:@[self.video, self.audio]
+                                           versionNumber:0
+                                       continuityCounter:0]];
+    [self.demuxer demux:psi dataArrivalHostTimeNanos:0];
+}
+
+- (void)feedTrack:(TSElementaryStream *)track size:(NSUInteger)size pts:(int64_t)pts {
+    NSMutableData *payload = [NSMutableData dataWithLength:size];
+    memset(payload.mutableBytes, 0xAB, size);
+    [self.demuxer demux:[TSTestUtils createPesDataWithTrack:track payload:payload pts:CMTimeMake(pts, 90000)]
+  dataArrivalHostTimeNanos:0];
+}
+
+- (void)test_perPidLimit_truncatesAndFlags {
+    self.demuxer.maxBufferedBytesPerPid = 1000;
+
+    [self feedTrack:self.video size:2000 pts:90000];
+    [self feedTrack:self.video size:300 pts:93600];
+    [self feedTrack:self.video size:300 pts:97200];
+
+    NSArray<TSAccessUnit *> *accessUnits = self.delegate.receivedAccessUnits;
+    XCTAssertEqual(accessUnits.count, (NSUInteger)2);
+    XCTAssertTrue(accessUnits[0].isTruncated);
+    XCTAssertLessThanOrEqual(accessUnits[0].compressedData.length, (NSUInteger)1000);
+    XCTAssertGreaterThan(accessUnits[0].compressedData.length, (NSUInteger)0);
+    XCTAssertEqual(accessUnits[0].pts.value, (int64_t)90000);
+
+    XCTAssertFalse(accessUnits[1].isTruncated);
+    XCTAssertEqual(accessUnits[1].compressedData.length, (NSUInteger)300);
+    XCTAssertEqual(accessUnits[1].pts.value, (int64_t)93600);
+}
+
+- (void)test_perPidLimit_dropPolicyDiscardsUntilPusi {
+    self.demuxer.maxBufferedBytesPerPid = 1000;
+    self.demuxer.overflowPolicy = TSAssemblyOverflowPolicyDrop;
+
+    [self feedTrack:self.video size:2000 pts:90000];
+    [self feedTrack:self.video size:300 pts:93600];
+    [self feedTrack:self.video size:300 pts:97200];
+
+    NSArray<TSAccessUnit *> *accessUnits = self.delegate.receivedAccessUnits;
+    XCTAssertEqual(accessUnits.count, (NSUInteger)1);
+    XCTAssertEqual(accessUnits[0].pts.value, (int64_t)93600);
+    XCTAssertEqual(accessUnits[0].compressedData.length, (NSUInteger)300);
+}
+
+- (void)test_sharedBudget_limitsAllPids {
+    self.demuxer.maxBufferedBytes = 1000;
+
+    // 800 bytes stay buffered on the video PID until its next PUSI
+    [self feedTrack:self.video size:800 pts:90000];
+    XCTAssertEqual(self.demuxer.bufferedBytes, (NSUInteger)800);
+    XCTAssertEqualObjects(self.demuxer.bufferedBytesByPid[@(kTestVideoPid)], @800);
+
+    // The audio access unit does not fit in the remaining 200 bytes
+    [self feedTrack:self.audio size:400 pts:90000];
+    XCTAssertEqual(self.delegate.receivedAccessUnits.count, (NSUInteger)1);
+    TSAccessUnit *audio = self.delegate.receivedAccessUnits.firstObject;
+    XCTAssertEqual(audio.pid, kTestAudioPid);
+    XCTAssertTrue(audio.isTruncated);
+    XCTAssertLessThan(audio.compressedData.length, (NSUInteger)400);
+
+    XCTAssertEqual(self.demuxer.bufferedBytes, (NSUInteger)800);
+    XCTAssertEqualObjects(self.demuxer.bufferedBytesByPid[@(kTestAudioPid)], @0);
+
+    // Delivering the video access unit frees its share of the budget
+    [self feedTrack:self.video size:100 pts:93600];
+    XCTAssertEqual(self.demuxer.bufferedBytes, (NSUInteger)100);
+    XCTAssertFalse(self.delegate.receivedAccessUnits.lastObject.isTruncated);
+    XCTAssertEqual(self.delegate.receivedAccessUnits.lastObject.compressedData.length, (NSUInteger)800);
+}
+
+- (void)test_noLimits_byDefault {
+    [self feedTrack:self.video size:100000 pts:90000];
+    [self feedTrack:self.video size:10 pts:93600];
+
+    XCTAssertEqual(self.delegate.receivedAccessUnits.count, (NSUInteger)1);
+    XCTAssertFalse(self.delegate.receivedAccessUnits[0].isTruncated);
+    XCTAssertEqual(self.delegate.receivedAccessUnits[0].compressedData.length, (NSUInteger)100000);
+}
+
+@end
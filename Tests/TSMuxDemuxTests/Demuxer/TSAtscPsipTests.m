@@ -0,0 +1,270 @@
+//
+//  TSAtscPsipTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for ATSC MGT-driven acquisition of EIT/ETT and STT time.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kEitPid = 0x1D00;
+static const uint16_t kEttPid = 0x1E00;
+
+#pragma mark - Test Delegate
+
+@interface TSAtscPsipTestDelegate : NSObject <TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSAtscMasterGuideTable *> *receivedMgts;
+@property (nonatomic, strong) NSMutableArray<TSAtscSystemTimeTable *> *receivedStts;
+@property (nonatomic, strong) NSMutableArray<TSAtscEventInformationTable *> *receivedEits;
+@property (nonatomic, strong) NSMutableArray<TSAtscExtendedTextTable *> *receivedEtts;
+@end
+
+@implementation TSAtscPsipTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedMgts = [NSMutableArray array];
+        _receivedStts = [NSMutableArray array];
+        _receivedEits = [NSMutableArray array];
+        _receivedEtts = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveMgt:(TSAtscMasterGuideTable *)mgt previousMgt:(TSAtscMasterGuideTable *)previousMgt {
+    [self.receivedMgts addObject:mgt];
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveStt:(TSAtscSystemTimeTable *)stt {
+    [self.receivedStts addObject:stt];
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveEit:(TSAtscEventInformationTable *)eit {
+    [self.receivedEits addObject:eit];
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveEtt:(TSAtscExtendedTextTable *)ett {
+    [self.receivedEtts addObject:ett];
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSAtscPsipTests : XCTestCase
+@property (nonatomic, strong) TSAtscPsipTestDelegate *delegate;
+@property (nonatomic, strong) TSDemuxer *demuxer;
+@end
+
+@implementation TSAtscPsipTests
+
+- (void)setUp {
+    [super setUp];
+    self.delegate = [[TSAtscPsipTestDelegate alloc] init];
+    self.demuxer = [[TSDemuxer alloc] initWithDelegate:self.delegate mode:TSDemuxerModeATSC];
+}
+
+#pragma mark - Helpers
+
+/// Section with the common header (table_id_extension, version, section 0/0) followed by `body`, plus a dummy CRC.
+- (NSData *)sectionWithTableId:(uint8_t)tableId
+              tableIdExtension:(uint16_t)tableIdExtension
+                       version:(uint8_t)version
+                          body:(NSData *)body {
+    const uint16_t sectionLength = (uint16_t)(5 + body.length + 4);
+    const uint8_t header[] = {
+        tableId, 0xF0 | (sectionLength >> 8), sectionLength & 0xFF,
+        tableIdExtension >> 8, tableIdExtension & 0xFF,
+        0xC1 | ((version & 0x1F) << 1), 0x00, 0x00
+    };
+    NSMutableData *section = [NSMutableData dataWithBytes:header length:sizeof(header)];
+    [section appendData:body];
+    const uint8_t crc[4] = { 0 };
+    [section appendBytes:crc length:sizeof(crc)];
+    return section;
+}
+
+- (NSData *)packetWithPid:(uint16_t)pid section:(NSData *)section cc:(uint8_t)cc {
+    NSMutableData *payload = [NSMutableData dataWithLength:1];  // pointer_field = 0
+    [payload appendData:section];
+    return [TSTestUtils createRawPacketDataWithPid:pid payload:payload pusi:YES continuityCounter:cc];
+}
+
+- (NSData *)mgtSectionWithVersion:(uint8_t)version eitVersion:(uint8_t)eitVersion {
+    const uint8_t body[] = {
+        0x00,                                   // protocol_version
+        0x00, 0x02,                             // tables_defined
+        0x01, 0x00, 0xE0 | (kEitPid >> 8), kEitPid & 0xFF, 0xE0 | eitVersion,
+        0x00, 0x00, 0x01, 0x00, 0xF0, 0x00,     // EIT-0, 256 bytes, no descriptors
+        0x02, 0x00, 0xE0 | (kEttPid >> 8), kEttPid & 0xFF, 0xE0,
+        0x00, 0x00, 0x00, 0x80, 0xF0, 0x00,     // ETT-0, 128 bytes, no descriptors
+        0xF0, 0x00                              // descriptors_length = 0
+    };
+    return [self sectionWithTableId:TABLE_ID_ATSC_MGT tableIdExtension:0 version:version
+                               body:[NSData dataWithBytes:body length:sizeof(body)]];
+}
+
+/// EIT instance for source 1 with a single event titled "News", padded with `paddingEvents` untitled events.
+- (NSData *)eitSectionWithVersion:(uint8_t)version paddingEvents:(uint8_t)paddingEvents {
+    NSMutableData *body = [NSMutableData data];
+    const uint8_t header[] = { 0x00, (uint8_t)(1 + paddingEvents) };  // protocol_version, num_events_in_section
+    [body appendBytes:header length:sizeof(header)];
+    const uint8_t event[] = {
+        0xC0, 0x07,                             // event_id = 7
+        0x3B, 0x9A, 0xCA, 0x00,                 // start_time = 1000000000 (GPS)
+        0xD0, 0x0E, 0x10,                       // ETM_location = 1, length_in_seconds = 3600
+        0x0C,                                   // title_length
+        0x01, 'e', 'n', 'g', 0x01,              // one string, one segment
+        0x00, 0x00, 0x04, 'N', 'e', 'w', 's',   // uncompressed, mode 0, 4 bytes
+        0xF0, 0x00                              // descriptors_length = 0
+    };
+    [body appendBytes:event length:sizeof(event)];
+    for (uint8_t i = 0; i < paddingEvents; i++) {
+        const uint8_t padding[] = { 0xC0, 8 + i, 0x3B, 0x9A, 0xCA, 0x00, 0xC0, 0x0E, 0x10, 0x00, 0xF0, 0x00 };
+        [body appendBytes:padding length:sizeof(padding)];
+    }
+    return [self sectionWithTableId:TABLE_ID_ATSC_EIT tableIdExtension:1 version:version body:body];
+}
+
+#pragma mark - Tables
+
+- (void)test_mgt_parsesTableEntries {
+    NSData *section = [self mgtSectionWithVersion:0 eitVersion:3];
+    [self.demuxer demux:[self packetWithPid:PID_ATSC_PSIP section:section cc:0] dataArrivalHostTimeNanos:0];
+
+    TSAtscMasterGuideTable *mgt = self.demuxer.atsc.mgt;
+    XCTAssertNotNil(mgt);
+    XCTAssertEqual(mgt.entries.count, (NSUInteger)2);
+
+    TSAtscMasterGuideTableEntry *eit0 = [mgt entryForTableType:TSAtscTableTypeEitFirst];
+    XCTAssertEqual(eit0.pid, kEitPid);
+    XCTAssertEqual(eit0.versionNumber, (uint8_t)3);
+    XCTAssertEqual(eit0.numberBytes, (uint32_t)256);
+    XCTAssertTrue(eit0.isEventOrTextTable);
+
+    NSSet *expectedPids = [NSSet setWithObjects:@(kEitPid), @(kEttPid), nil];
+    XCTAssertEqualObjects(mgt.eventAndTextTablePids, expectedPids);
+    XCTAssertEqual(self.delegate.receivedMgts.count, (NSUInteger)1);
+}
+
+- (void)test_stt_convertsGpsTimeToUtc {
+    const uint8_t body[] = {
+        0x00,                       // protocol_version
+        0x3B, 0x9A, 0xCA, 0x00,     // system_time = 1000000000
+        0x12,                       // GPS_UTC_offset = 18
+        0x80, 0x00                  // DS_status = 1
+    };
+    NSData *section = [self sectionWithTableId:TABLE_ID_ATSC_STT tableIdExtension:0 version:0
+                                          body:[NSData dataWithBytes:body length:sizeof(body)]];
+    [self.demuxer demux:[self packetWithPid:PID_ATSC_PSIP section:section cc:0] dataArrivalHostTimeNanos:0];
+
+    TSAtscSystemTimeTable *stt = self.demuxer.atsc.stt;
+    XCTAssertNotNil(stt);
+    XCTAssertEqual(stt.systemTime, (uint32_t)1000000000);
+    XCTAssertEqual(stt.gpsUtcOffset, (uint8_t)18);
+    XCTAssertTrue(stt.daylightSavingStatus);
+    XCTAssertEqual(stt.unixSeconds, (int64_t)(315964800 + 1000000000 - 18));
+    XCTAssertEqual(self.delegate.receivedStts.count, (NSUInteger)1);
+}
+
+#pragma mark - MGT-driven acquisition
+
+- (void)test_eitOnPidNotInMgt_isIgnored {
+    NSData *eit = [self eitSectionWithVersion:0 paddingEvents:0];
+    [self.demuxer demux:[self packetWithPid:kEitPid section:eit cc:0] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(self.delegate.receivedEits.count, (NSUInteger)0);
+
+    [self.demuxer demux:[self packetWithPid:PID_ATSC_PSIP section:[self mgtSectionWithVersion:0 eitVersion:0] cc:0]
+  dataArrivalHostTimeNanos:0];
+    [self.demuxer demux:[self packetWithPid:kEitPid + 1 section:eit cc:0] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(self.delegate.receivedEits.count, (NSUInteger)0);
+}
+
+- (void)test_eit_deliveredOncePerVersion {
+    [self.demuxer demux:[self packetWithPid:PID_ATSC_PSIP section:[self mgtSectionWithVersion:0 eitVersion:0] cc:0]
+  dataArrivalHostTimeNanos:0];
+
+    NSData *eitV0 = [self eitSectionWithVersion:0 paddingEvents:0];
+    for (uint8_t cc = 0; cc < 3; cc++) {
+        [self.demuxer demux:[self packetWithPid:kEitPid section:eitV0 cc:cc] dataArrivalHostTimeNanos:0];
+    }
+    XCTAssertEqual(self.delegate.receivedEits.count, (NSUInteger)1);
+
+    TSAtscEventInformationTable *eit = self.delegate.receivedEits.firstObject;
+    XCTAssertEqual(eit.sourceId, (uint16_t)1);
+    XCTAssertEqual(eit.eventCount, (NSUInteger)1);
+    TSAtscEvent *event = [eit eventAtIndex:0];
+    XCTAssertEqual(event.eventId, (uint16_t)7);
+    XCTAssertEqual(event.startTime, (uint32_t)1000000000);
+    XCTAssertEqual(event.lengthInSeconds, (uint32_t)3600);
+    XCTAssertEqual(event.etmLocation, (uint8_t)1);
+    XCTAssertEqualObjects(event.title, @"News");
+
+    // New MGT announcing EIT-0 version 1
+    [self.demuxer demux:[self packetWithPid:PID_ATSC_PSIP section:[self mgtSectionWithVersion:1 eitVersion:1] cc:1]
+  dataArrivalHostTimeNanos:0];
+    NSData *eitV1 = [self eitSectionWithVersion:1 paddingEvents:0];
+    [self.demuxer demux:[self packetWithPid:kEitPid section:eitV1 cc:3] dataArrivalHostTimeNanos:0];
+    [self.demuxer demux:[self packetWithPid:kEitPid section:eitV1 cc:4] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(self.delegate.receivedEits.count, (NSUInteger)2);
+    XCTAssertEqual(self.delegate.receivedEits.lastObject.psi.versionNumber, (uint8_t)1);
+}
+
+- (void)test_repeatedSectionSpanningPackets_isSkipped {
+    [self.demuxer demux:[self packetWithPid:PID_ATSC_PSIP section:[self mgtSectionWithVersion:0 eitVersion:0] cc:0]
+  dataArrivalHostTimeNanos:0];
+
+    // 24 + 20 * 12 bytes of events: the section spans two packets
+    NSData *section = [self eitSectionWithVersion:0 paddingEvents:20];
+    XCTAssertGreaterThan(section.length, (NSUInteger)183);
+    const NSUInteger firstLength = 183;
+
+    uint8_t cc = 0;
+    for (int repeat = 0; repeat < 3; repeat++) {
+        NSMutableData *first = [NSMutableData dataWithLength:1];
+        [first appendData:[section subdataWithRange:NSMakeRange(0, firstLength)]];
+        NSData *rest = [section subdataWithRange:NSMakeRange(firstLength, section.length - firstLength)];
+        [self.demuxer demux:[TSTestUtils createRawPacketDataWithPid:kEitPid payload:first pusi:YES continuityCounter:cc++]
+      dataArrivalHostTimeNanos:0];
+        [self.demuxer demux:[TSTestUtils createRawPacketDataWithPid:kEitPid payload:rest pusi:NO continuityCounter:cc++]
+      dataArrivalHostTimeNanos:0];
+    }
+    XCTAssertEqual(self.delegate.receivedEits.count, (NSUInteger)1);
+    XCTAssertEqual(self.delegate.receivedEits.firstObject.eventCount, (NSUInteger)21);
+
+    // A new section after the skipped ones is still assembled
+    [self.demuxer demux:[self packetWithPid:kEitPid section:[self eitSectionWithVersion:1 paddingEvents:0] cc:cc]
+  dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(self.delegate.receivedEits.count, (NSUInteger)2);
+}
+
+- (void)test_ett_decodesText {
+    [self.demuxer demux:[self packetWithPid:PID_ATSC_PSIP section:[self mgtSectionWithVersion:0 eitVersion:0] cc:0]
+  dataArrivalHostTimeNanos:0];
+
+    const uint8_t body[] = {
+        0x00,                                       // protocol_version
+        0x00, 0x01, 0x00, 0x1E,                     // ETM_id: source 1, event 7, event ETM
+        0x01, 'e', 'n', 'g', 0x01,
+        0x00, 0x00, 0x05, 'H', 'e', 'l', 'l', 'o'
+    };
+    NSData *section = [self sectionWithTableId:TABLE_ID_ATSC_ETT tableIdExtension:1 version:0
+                                          body:[NSData dataWithBytes:body length:sizeof(body)]];
+    [self.demuxer demux:[self packetWithPid:kEttPid section:section cc:0] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(self.delegate.receivedEtts.count, (NSUInteger)1);
+    TSAtscExtendedTextTable *ett = self.delegate.receivedEtts.firstObject;
+    XCTAssertTrue(ett.isEventText);
+    XCTAssertEqual(ett.sourceId, (uint16_t)1);
+    XCTAssertEqual(ett.eventId, (uint16_t)7);
+    XCTAssertEqualObjects(ett.text, @"Hello");
+}
+
+@end
@@ -514,4 +514,95 @@ static const uint16_t kTestVideoPid = 0x101;
                                 @"First packet should be accepted regardless of CC");
 }
 
+#pragma mark - Shared Verdict Tests
+
+- (void)test_builderAndStatistics_agreeOnDuplicateAndGap {
+    TSElementaryStream *track = [[TSElementaryStream alloc] initWithPid:kTestVideoPid
+                                                             streamType:kRawStreamTypeH264
+                                                            descriptors:nil];
+
+    uint8_t payload[] = {0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00};
+    NSData *videoPayload = [NSData dataWithBytes:payload length:sizeof(payload)];
+
+    // Acquire TR 101 290 sync with continuous single-packet PES
+    int64_t pts = 0;
+    for (int i = 0; i < 5; i++) {
+        [self.demuxer demux:[TSTestUtils createPesDataWithTrack:track payload:videoPayload pts:CMTimeMake(pts += 3000, 90000)]
+                 dataArrivalHostTimeNanos:0];
+    }
+    const uint64_t initialCcErrors = self.demuxer.statistics.prio1.ccError;
+    const NSUInteger initialAccessUnits = self.delegate.receivedAccessUnits.count;
+
+    // A single duplicate: skipped by the builder, not a CC error
+    track.continuityCounter = (track.continuityCounter - 1) & 0x0F;
+    [self.demuxer demux:[TSTestUtils createPesDataWithTrack:track payload:videoPayload pts:CMTimeMake(pts, 90000)]
+             dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(self.demuxer.statistics.prio1.ccError, initialCcErrors);
+    XCTAssertEqual(self.delegate.receivedAccessUnits.count, initialAccessUnits);
+
+    // A gap: counted once, and the access unit in progress is discarded
+    track.continuityCounter = (track.continuityCounter + 5) & 0x0F;
+    [self.demuxer demux:[TSTestUtils createPesDataWithTrack:track payload:videoPayload pts:CMTimeMake(pts += 3000, 90000)]
+             dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(self.demuxer.statistics.prio1.ccError, initialCcErrors + 1);
+
+    [self.demuxer demux:[TSTestUtils createPesDataWithTrack:track payload:videoPayload pts:CMTimeMake(pts += 3000, 90000)]
+             dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(self.delegate.receivedAccessUnits.count, initialAccessUnits,
+                   @"The access unit in progress at the gap and the gap packet itself should be dropped");
+    XCTAssertEqual(self.demuxer.statistics.prio1.ccError, initialCcErrors + 1);
+}
+
+- (void)test_reselectedPid_restartsContinuityCheck {
+    TSElementaryStream *track = [[TSElementaryStream alloc] initWithPid:kTestVideoPid
+                                                             streamType:kRawStreamTypeH264
+                                                            descriptors:nil];
+
+    uint8_t payload[] = {0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00};
+    NSData *videoPayload = [NSData dataWithBytes:payload length:sizeof(payload)];
+
+    int64_t pts = 0;
+    for (int i = 0; i < 5; i++) {
+        [self.demuxer demux:[TSTestUtils createPesDataWithTrack:track payload:videoPayload pts:CMTimeMake(pts += 3000, 90000)]
+                 dataArrivalHostTimeNanos:0];
+    }
+    const uint64_t initialCcErrors = self.demuxer.statistics.prio1.ccError;
+
+    // Packets of an unselected PID are dropped before the CC check
+    self.demuxer.esPidFilter = [NSSet setWithObject:@(kTestVideoPid + 1)];
+    for (int i = 0; i < 3; i++) {
+        [self.demuxer demux:[TSTestUtils createPesDataWithTrack:track payload:videoPayload pts:CMTimeMake(pts += 3000, 90000)]
+                 dataArrivalHostTimeNanos:0];
+    }
+
+    // Selected again: the CC jump over the dropped packets is not a gap
+    self.demuxer.esPidFilter = nil;
+    [self.delegate.receivedAccessUnits removeAllObjects];
+    for (int i = 0; i < 2; i++) {
+        [self.demuxer demux:[TSTestUtils createPesDataWithTrack:track payload:videoPayload pts:CMTimeMake(pts += 3000, 90000)]
+                 dataArrivalHostTimeNanos:0];
+    }
+    XCTAssertEqual(self.demuxer.statistics.prio1.ccError, initialCcErrors);
+    XCTAssertEqual(self.delegate.receivedAccessUnits.count, 1);
+}
+
+#pragma mark - Deprecated Checker
+
+- (void)test_deprecatedChecker_matchesContinuityState {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    TSContinuityChecker *checker = [[TSContinuityChecker alloc] init];
+#pragma clang diagnostic pop
+    NSData *payload = [NSData dataWithBytes:(const uint8_t[]){ 0x00 } length:1];
+    const uint8_t ccs[] = { 3, 4, 4, 6 };
+    const TSContinuityCheckResult expected[] = {
+        TSContinuityCheckResultOK, TSContinuityCheckResultOK, TSContinuityCheckResultDuplicate, TSContinuityCheckResultGap,
+    };
+    for (NSUInteger i = 0; i < sizeof(ccs); i++) {
+        NSData *data = [TSTestUtils createRawPacketDataWithPid:kTestVideoPid payload:payload pusi:NO continuityCounter:ccs[i]];
+        TSPacket *packet = [TSPacket packetsFromChunkedTsData:data packetSize:TS_PACKET_SIZE_188].firstObject;
+        XCTAssertEqual([checker checkPacket:packet], expected[i]);
+    }
+}
+
 @end
@@ -78,6 +78,67 @@ static const uint16_t kAudioPid2 = 0x202;
     XCTAssertEqual(demuxer.packetSize, (NSUInteger)TS_PACKET_SIZE_204);
 }
 
+- (void)test_detectPacketSize_ambiguousLength_bySyncBytes {
+    // 47 * 204 = 51 * 188: detected from the sync byte positions, not the length
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    NSData *chunk = [TSTestUtils createNullPackets:47 packetSize:TS_PACKET_SIZE_204];
+    [demuxer demux:chunk dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(demuxer.packetSize, (NSUInteger)TS_PACKET_SIZE_204);
+}
+
+/// 192-byte M2TS packets of the 188-byte packets in `tsData`, with the given arrival time stamps.
+- (NSData *)m2tsDataFromTsData:(NSData *)tsData arrivalTimestamps:(const uint32_t *)arrivalTimestamps {
+    NSMutableData *m2ts = [NSMutableData data];
+    for (NSUInteger i = 0; i * TS_PACKET_SIZE_188 < tsData.length; i++) {
+        const uint8_t header[4] = {
+            (uint8_t)(arrivalTimestamps[i] >> 24) & 0x3F,
+            (uint8_t)(arrivalTimestamps[i] >> 16),
+            (uint8_t)(arrivalTimestamps[i] >> 8),
+            (uint8_t)arrivalTimestamps[i],
+        };
+        [m2ts appendBytes:header length:sizeof(header)];
+        [m2ts appendBytes:(const uint8_t *)tsData.bytes + i * TS_PACKET_SIZE_188 length:TS_PACKET_SIZE_188];
+    }
+    return m2ts;
+}
+
+- (void)test_detectPacketSize_192_unwrapsArrivalTimestamps {
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    // The 30-bit, 27 MHz arrival time stamp wraps between the two packets
+    const uint32_t arrivalTimestamps[] = { 0x3FFFFF00, 0x00000100 };
+    NSMutableData *ts = [NSMutableData data];
+    [ts appendData:[TSTestUtils createPatDataWithPmtPid:kPmtPid1]];
+    [ts appendData:[TSTestUtils createPmtDataWithPmtPid:kPmtPid1 pcrPid:kVideoPid1 elementaryStreamPid:kVideoPid1 streamType:kRawStreamTypeH264]];
+    [demuxer demux:[self m2tsDataFromTsData:ts arrivalTimestamps:arrivalTimestamps] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(demuxer.packetSize, (NSUInteger)TS_PACKET_SIZE_192);
+    XCTAssertNotNil(demuxer.pat);
+    XCTAssertEqual(demuxer.pmts.count, (NSUInteger)1);
+    XCTAssertEqual(demuxer.arrivalTimeNanos, (uint64_t)(0x3FFFFF00ULL + 0x200) * 1000 / 27);
+
+    // Continues across calls
+    const uint32_t next[] = { 0x00000100 + 27000 };
+    NSData *nullPacket = [TSTestUtils createNullPackets:1 packetSize:TS_PACKET_SIZE_188];
+    [demuxer demux:[self m2tsDataFromTsData:nullPacket arrivalTimestamps:next] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(demuxer.arrivalTimeNanos, (uint64_t)(0x3FFFFF00ULL + 0x200 + 27000) * 1000 / 27);
+}
+
+- (void)test_detectPacketSize_redetectsWhenSyncIsLost {
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    [demuxer demux:[TSTestUtils createNullPackets:10 packetSize:TS_PACKET_SIZE_188] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(demuxer.packetSize, (NSUInteger)TS_PACKET_SIZE_188);
+
+    // The capture switches to 204-byte packets, in a chunk whose length is also a multiple of 188
+    [demuxer demux:[TSTestUtils createNullPackets:47 packetSize:TS_PACKET_SIZE_204] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(demuxer.packetSize, (NSUInteger)TS_PACKET_SIZE_204);
+
+    // A corrupted sync byte alone does not change the size
+    NSMutableData *corrupted = [[TSTestUtils createNullPackets:4 packetSize:TS_PACKET_SIZE_204] mutableCopy];
+    ((uint8_t *)corrupted.mutableBytes)[204] = 0x00;
+    [demuxer demux:corrupted dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(demuxer.packetSize, (NSUInteger)TS_PACKET_SIZE_204);
+}
+
 #pragma mark - Statistics Tests
 
 - (void)test_statistics_initiallyZero {
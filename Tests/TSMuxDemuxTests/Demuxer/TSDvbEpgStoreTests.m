@@ -0,0 +1,255 @@
+//
+//  TSDvbEpgStoreTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for DVB EIT parsing and the incremental EPG store.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+// 1993-10-13 (EN 300 468 Annex C example), MJD 0xC079
+static const int64_t kDay = 750470400;
+
+@interface TSDvbEpgTestDelegate : NSObject <TSDvbEpgStoreDelegate>
+@property(nonatomic) NSUInteger updateCount;
+@property(nonatomic) uint16_t lastServiceId;
+@end
+
+@implementation TSDvbEpgTestDelegate
+-(void)epgStore:(TSDvbEpgStore *)store didUpdateEventsForServiceId:(uint16_t)serviceId
+transportStreamId:(uint16_t)transportStreamId
+originalNetworkId:(uint16_t)originalNetworkId
+{
+    self.updateCount++;
+    self.lastServiceId = serviceId;
+}
+@end
+
+@interface TSDvbEpgStoreTests : XCTestCase
+@end
+
+@implementation TSDvbEpgStoreTests
+
+#pragma mark - Helpers
+
+static uint8_t bcd(int value)
+{
+    return (uint8_t)(((value / 10) << 4) | (value % 10));
+}
+
+/// Appends one event on 1993-10-13 with a short_event_descriptor ("eng") if `name` is set.
+- (void)appendEventTo:(NSMutableData *)data
+              eventId:(uint16_t)eventId
+                 hour:(int)hour
+               minute:(int)minute
+      durationMinutes:(int)durationMinutes
+                 name:(NSString *)name {
+    NSData *nameData = [name dataUsingEncoding:NSUTF8StringEncoding];
+    const uint16_t descriptorsLength = nameData ? (uint16_t)(2 + 5 + nameData.length) : 0;
+    const uint8_t header[] = {
+        eventId >> 8, eventId & 0xFF,
+        0xC0, 0x79, bcd(hour), bcd(minute), 0x00,                              // start_time
+        bcd(durationMinutes / 60), bcd(durationMinutes % 60), 0x00,           // duration
+        0x80 | (descriptorsLength >> 8), descriptorsLength & 0xFF             // running_status=4, free_CA=0
+    };
+    [data appendBytes:header length:sizeof(header)];
+    if (nameData) {
+        const uint8_t descriptor[] = { 0x4D, (uint8_t)(5 + nameData.length), 'e', 'n', 'g', (uint8_t)nameData.length };
+        [data appendBytes:descriptor length:sizeof(descriptor)];
+        [data appendData:nameData];
+        const uint8_t noText = 0;
+        [data appendBytes:&noText length:1];
+    }
+}
+
+- (NSMutableData *)eitSectionDataWithServiceId:(uint16_t)serviceId
+                                       version:(uint8_t)version
+                                 sectionNumber:(uint8_t)sectionNumber {
+    const uint8_t header[] = {
+        serviceId >> 8, serviceId & 0xFF,
+        0xC1 | ((version & 0x1F) << 1),  // reserved + version + current_next=1
+        sectionNumber, 0x01,             // section_number, last_section_number
+        0x00, 0x01,                      // transport_stream_id = 1
+        0x00, 0x02,                      // original_network_id = 2
+        0x01,                            // segment_last_section_number
+        0x4E                             // last_table_id
+    };
+    return [NSMutableData dataWithBytes:header length:sizeof(header)];
+}
+
+- (TSDvbEventInformationTable *)eitWithTableId:(uint8_t)tableId sectionData:(NSData *)sectionData {
+    TSProgramSpecificInformationTable *psi = [[TSProgramSpecificInformationTable alloc]
+                                              initWithTableId:tableId
+                                              sectionSyntaxIndicator:1
+                                              reservedBit1:1
+                                              reservedBits2:3
+                                              sectionLength:(uint16_t)(sectionData.length + 4)
+                                              sectionDataExcludingCrc:sectionData
+                                              crc:0];
+    return [[TSDvbEventInformationTable alloc] initWithPSI:psi];
+}
+
+- (NSDate *)dateAtHour:(int)hour minute:(int)minute {
+    return [NSDate dateWithTimeIntervalSince1970:kDay + hour * 3600 + minute * 60];
+}
+
+/// Schedule section (table 0x50) for service 100 with events every hour from 12:00.
+- (TSDvbEventInformationTable *)scheduleWithVersion:(uint8_t)version names:(NSArray<NSString*> *)names {
+    NSMutableData *data = [self eitSectionDataWithServiceId:100 version:version sectionNumber:0];
+    for (NSUInteger i = 0; i < names.count; i++) {
+        [self appendEventTo:data eventId:(uint16_t)(1 + i) hour:12 + (int)i minute:0 durationMinutes:60 name:names[i]];
+    }
+    return [self eitWithTableId:TABLE_ID_DVB_EIT_SCHEDULE_ACTUAL_TS_FIRST sectionData:data];
+}
+
+#pragma mark - Time
+
+- (void)test_dvbUtcTime_annexCExample {
+    const uint8_t utc[] = { 0xC0, 0x79, 0x12, 0x45, 0x00 };
+    XCTAssertEqual([TSTimeUtil unixSecondsFromDvbUtcTime:utc], (int64_t)750516300);
+
+    const uint8_t undefined[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    XCTAssertEqual([TSTimeUtil unixSecondsFromDvbUtcTime:undefined], (int64_t)-1);
+
+    const uint8_t duration[] = { 0x01, 0x45, 0x30 };
+    XCTAssertEqual([TSTimeUtil secondsFromDvbBcdTime:duration], (int32_t)6330);
+}
+
+#pragma mark - EIT section
+
+- (void)test_eit_parsesHeaderAndEvents {
+    NSMutableData *data = [self eitSectionDataWithServiceId:100 version:3 sectionNumber:1];
+    [self appendEventTo:data eventId:7 hour:12 minute:45 durationMinutes:90 name:@"News"];
+    TSDvbEventInformationTable *eit = [self eitWithTableId:TABLE_ID_DVB_EIT_PF_ACTUAL_TS sectionData:data];
+
+    XCTAssertEqual(eit.serviceId, (uint16_t)100);
+    XCTAssertEqual(eit.transportStreamId, (uint16_t)1);
+    XCTAssertEqual(eit.originalNetworkId, (uint16_t)2);
+    XCTAssertTrue(eit.isPresentFollowing);
+    XCTAssertTrue(eit.isActualTransportStream);
+    XCTAssertEqual(eit.entryCount, (NSUInteger)1);
+
+    TSDvbEventInformationEntry *entry = [eit entryAtIndex:0];
+    XCTAssertEqual(entry.eventId, (uint16_t)7);
+    XCTAssertEqual(entry.startTime, (int64_t)750516300);
+    XCTAssertEqual(entry.duration, (int32_t)5400);
+    XCTAssertEqual(entry.runningStatus, (uint8_t)4);
+
+    TSDvbShortEventDescriptor *shortEvent = (TSDvbShortEventDescriptor *)entry.descriptors.firstObject;
+    XCTAssertTrue([shortEvent isKindOfClass:[TSDvbShortEventDescriptor class]]);
+    XCTAssertEqualObjects(shortEvent.languageCode, @"eng");
+    XCTAssertEqualObjects([TSStringEncodingUtil dvbStringFromCharData:shortEvent.eventName], @"News");
+}
+
+#pragma mark - Store
+
+- (void)test_store_eventAtTime {
+    TSDvbEpgStore *store = [TSDvbEpgStore new];
+    XCTAssertTrue([store addSection:[self scheduleWithVersion:0 names:@[@"Noon", @"One", @"Two"]]]);
+    XCTAssertEqual(store.eventCount, (NSUInteger)3);
+
+    XCTAssertEqualObjects([store eventForServiceId:100 atDate:[self dateAtHour:13 minute:30]].name, @"One");
+    XCTAssertEqualObjects([store eventForServiceId:100 atDate:[self dateAtHour:14 minute:0]].name, @"Two");
+    XCTAssertNil([store eventForServiceId:100 atDate:[self dateAtHour:15 minute:0]]);
+    XCTAssertNil([store eventForServiceId:100 atDate:[self dateAtHour:11 minute:59]]);
+    XCTAssertNil([store eventForServiceId:101 atDate:[self dateAtHour:13 minute:0]]);
+
+    TSDvbEpgEvent *event = [store eventForOriginalNetworkId:2 transportStreamId:1 serviceId:100
+                                                     atDate:[self dateAtHour:12 minute:10]];
+    XCTAssertEqual(event.eventId, (uint16_t)1);
+    XCTAssertEqual(event.duration, 3600.0);
+    XCTAssertEqualObjects(event.languageCode, @"eng");
+    XCTAssertFalse(event.isPresentFollowing);
+
+    NSArray<TSDvbEpgEvent*> *range = [store eventsForServiceId:100
+                                                      fromDate:[self dateAtHour:12 minute:30]
+                                                        toDate:[self dateAtHour:14 minute:0]];
+    XCTAssertEqual(range.count, (NSUInteger)2);
+    XCTAssertEqualObjects(range[0].name, @"Noon");
+    XCTAssertEqualObjects(range[1].name, @"One");
+}
+
+- (void)test_store_skipsRepeatedSection {
+    TSDvbEpgStore *store = [TSDvbEpgStore new];
+    TSDvbEpgTestDelegate *delegate = [TSDvbEpgTestDelegate new];
+    store.delegate = delegate;
+
+    XCTAssertTrue([store addSection:[self scheduleWithVersion:0 names:@[@"Noon"]]]);
+    XCTAssertFalse([store addSection:[self scheduleWithVersion:0 names:@[@"Noon"]]]);
+    XCTAssertFalse([store addSection:[self scheduleWithVersion:0 names:@[@"Noon"]]]);
+
+    XCTAssertEqual(store.eventCount, (NSUInteger)1);
+    XCTAssertEqual(store.skippedSectionCount, (NSUInteger)2);
+    XCTAssertEqual(delegate.updateCount, (NSUInteger)1);
+    XCTAssertEqual(delegate.lastServiceId, (uint16_t)100);
+}
+
+- (void)test_store_versionChangeReplacesSubTable {
+    TSDvbEpgStore *store = [TSDvbEpgStore new];
+    [store addSection:[self scheduleWithVersion:0 names:@[@"Old noon", @"Old one"]]];
+    XCTAssertTrue([store addSection:[self scheduleWithVersion:1 names:@[@"New noon"]]]);
+
+    XCTAssertEqual(store.eventCount, (NSUInteger)1);
+    XCTAssertEqualObjects([store eventForServiceId:100 atDate:[self dateAtHour:12 minute:30]].name, @"New noon");
+    XCTAssertNil([store eventForServiceId:100 atDate:[self dateAtHour:13 minute:30]]);
+}
+
+- (void)test_store_presentFollowingWinsOverSchedule {
+    TSDvbEpgStore *store = [TSDvbEpgStore new];
+    [store addSection:[self scheduleWithVersion:0 names:@[@"Scheduled"]]];
+
+    NSMutableData *data = [self eitSectionDataWithServiceId:100 version:0 sectionNumber:0];
+    [self appendEventTo:data eventId:1 hour:12 minute:0 durationMinutes:75 name:@"Overrunning"];
+    [store addSection:[self eitWithTableId:TABLE_ID_DVB_EIT_PF_ACTUAL_TS sectionData:data]];
+
+    TSDvbEpgEvent *event = [store eventForServiceId:100 atDate:[self dateAtHour:12 minute:30]];
+    XCTAssertEqualObjects(event.name, @"Overrunning");
+    XCTAssertTrue(event.isPresentFollowing);
+
+    NSArray<TSDvbEpgEvent*> *range = [store eventsForServiceId:100
+                                                      fromDate:[self dateAtHour:12 minute:0]
+                                                        toDate:[self dateAtHour:13 minute:0]];
+    XCTAssertEqual(range.count, (NSUInteger)1);
+    XCTAssertEqualObjects(range.firstObject.name, @"Overrunning");
+}
+
+- (void)test_store_pruneDropsEndedEvents {
+    TSDvbEpgStore *store = [TSDvbEpgStore new];
+    [store addSection:[self scheduleWithVersion:0 names:@[@"Noon", @"One", @"Two"]]];
+
+    [store pruneEventsEndingBefore:[self dateAtHour:13 minute:30]];
+    XCTAssertEqual(store.eventCount, (NSUInteger)2);
+    XCTAssertNil([store eventForServiceId:100 atDate:[self dateAtHour:12 minute:30]]);
+    XCTAssertEqualObjects([store eventForServiceId:100 atDate:[self dateAtHour:14 minute:30]].name, @"Two");
+}
+
+#pragma mark - Demuxer
+
+- (void)test_demuxer_collectsEitFromPid0x12 {
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+
+    for (uint8_t sectionNumber = 0; sectionNumber < 2; sectionNumber++) {
+        NSMutableData *data = [self eitSectionDataWithServiceId:100 version:0 sectionNumber:sectionNumber];
+        [self appendEventTo:data eventId:(uint16_t)(10 + sectionNumber) hour:12 + sectionNumber minute:0
+            durationMinutes:60 name:sectionNumber == 0 ? @"Present" : @"Following"];
+
+        NSMutableData *payload = [NSMutableData data];
+        const uint16_t sectionLength = (uint16_t)(data.length + 4);
+        const uint8_t header[] = { 0x00, TABLE_ID_DVB_EIT_PF_ACTUAL_TS, 0xF0 | (sectionLength >> 8), sectionLength & 0xFF };
+        [payload appendBytes:header length:sizeof(header)];
+        [payload appendData:data];
+        const uint8_t crc[4] = { 0 };
+        [payload appendBytes:crc length:sizeof(crc)];
+
+        [demuxer demux:[TSTestUtils createRawPacketDataWithPid:PID_DVB_EIT_ST_CIT payload:payload pusi:YES continuityCounter:sectionNumber]
+  dataArrivalHostTimeNanos:0];
+    }
+
+    XCTAssertEqual(demuxer.dvb.epg.eventCount, (NSUInteger)2);
+    XCTAssertEqualObjects([demuxer.dvb.epg eventForServiceId:100 atDate:[self dateAtHour:12 minute:30]].name, @"Present");
+    XCTAssertEqualObjects([demuxer.dvb.epg eventForServiceId:100 atDate:[self dateAtHour:13 minute:30]].name, @"Following");
+}
+
+@end
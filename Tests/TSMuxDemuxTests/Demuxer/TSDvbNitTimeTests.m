@@ -0,0 +1,334 @@
+//
+//  TSDvbNitTimeTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for DVB NIT and TDT/TOT parsing, and the PCR-to-UTC clock they drive.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+// 1993-10-13 12:45:00 UTC, the example of EN 300 468 Annex C
+static const int64_t kTdtUnixSeconds = 750516300;
+static const uint8_t kTdtUtcTime[5] = { 0xC0, 0x79, 0x12, 0x45, 0x00 };
+
+#pragma mark - Test Delegate
+
+@interface TSDvbNitTimeTestDelegate : NSObject <TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSDvbNetworkInformationTable *> *receivedNits;
+@property (nonatomic, strong) NSMutableArray<TSDvbTimeTable *> *receivedTimeTables;
+@end
+
+@implementation TSDvbNitTimeTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedNits = [NSMutableArray array];
+        _receivedTimeTables = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveNit:(TSDvbNetworkInformationTable *)nit previousNit:(TSDvbNetworkInformationTable *)previousNit {
+    [self.receivedNits addObject:nit];
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveTimeTable:(TSDvbTimeTable *)timeTable {
+    [self.receivedTimeTables addObject:timeTable];
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSDvbNitTimeTests : XCTestCase
+@property (nonatomic, strong) TSDvbNitTimeTestDelegate *delegate;
+@property (nonatomic, strong) TSDemuxer *demuxer;
+@end
+
+@implementation TSDvbNitTimeTests
+
+- (void)setUp {
+    [super setUp];
+    self.delegate = [[TSDvbNitTimeTestDelegate alloc] init];
+    self.demuxer = [[TSDemuxer alloc] initWithDelegate:self.delegate mode:TSDemuxerModeDVB];
+}
+
+#pragma mark - Helpers
+
+- (NSData *)sectionWithTableId:(uint8_t)tableId
+              tableIdExtension:(uint16_t)tableIdExtension
+                       version:(uint8_t)version
+                 sectionNumber:(uint8_t)sectionNumber
+             lastSectionNumber:(uint8_t)lastSectionNumber
+                          body:(NSData *)body {
+    const uint16_t sectionLength = (uint16_t)(5 + body.length + 4);
+    const uint8_t header[] = {
+        tableId, 0xF0 | (sectionLength >> 8), sectionLength & 0xFF,
+        tableIdExtension >> 8, tableIdExtension & 0xFF,
+        0xC1 | ((version & 0x1F) << 1), sectionNumber, lastSectionNumber
+    };
+    NSMutableData *section = [NSMutableData dataWithBytes:header length:sizeof(header)];
+    [section appendData:body];
+    const uint8_t crc[4] = { 0 };
+    [section appendBytes:crc length:sizeof(crc)];
+    return section;
+}
+
+- (NSData *)packetWithPid:(uint16_t)pid section:(NSData *)section cc:(uint8_t)cc {
+    NSMutableData *payload = [NSMutableData dataWithLength:1];  // pointer_field = 0
+    [payload appendData:section];
+    return [TSTestUtils createRawPacketDataWithPid:pid payload:payload pusi:YES continuityCounter:cc];
+}
+
+/// NIT body: network descriptors, then one transport stream loop.
+- (NSData *)nitBodyWithNetworkDescriptors:(NSData *)networkDescriptors transportStreams:(NSData *)transportStreams {
+    NSMutableData *body = [NSMutableData data];
+    const uint8_t networkLength[] = { 0xF0 | (networkDescriptors.length >> 8), networkDescriptors.length & 0xFF };
+    [body appendBytes:networkLength length:sizeof(networkLength)];
+    [body appendData:networkDescriptors];
+    const uint8_t loopLength[] = { 0xF0 | (transportStreams.length >> 8), transportStreams.length & 0xFF };
+    [body appendBytes:loopLength length:sizeof(loopLength)];
+    [body appendData:transportStreams];
+    return body;
+}
+
+- (NSData *)transportStreamWithId:(uint16_t)tsId descriptors:(NSData *)descriptors {
+    NSMutableData *entry = [NSMutableData data];
+    const uint8_t header[] = {
+        tsId >> 8, tsId & 0xFF, 0x00, 0x22,     // original_network_id = 0x22
+        0xF0 | (descriptors.length >> 8), descriptors.length & 0xFF
+    };
+    [entry appendBytes:header length:sizeof(header)];
+    [entry appendData:descriptors];
+    return entry;
+}
+
+/// Two-section NIT of network 0x3001: "Test" with a terrestrial mux, then a cable mux.
+- (NSArray<NSData *> *)actualNitSectionsWithVersion:(uint8_t)version {
+    const uint8_t networkName[] = { 0x40, 0x04, 'T', 'e', 's', 't' };
+    const uint8_t terrestrialMux[] = {
+        0x41, 0x06, 0x00, 0x01, 0x01, 0x00, 0x02, 0x02,    // services 1 (TV) and 2 (radio)
+        0x5A, 0x0B, 0x02, 0xD3, 0x44, 0x40,                // 474 MHz
+        0x1F, 0x82, 0x12, 0xFF, 0xFF, 0xFF, 0xFF           // 8 MHz, 64-QAM, guard 1/8, 8k
+    };
+    const uint8_t cableMux[] = {
+        0x44, 0x0B, 0x03, 0x46, 0x00, 0x00,                // 346 MHz
+        0xFF, 0xF2, 0x03, 0x00, 0x69, 0x00, 0x03           // 64-QAM, 6.9 Msymbol/s
+    };
+    NSData *body0 = [self nitBodyWithNetworkDescriptors:[NSData dataWithBytes:networkName length:sizeof(networkName)]
+                                       transportStreams:[self transportStreamWithId:1
+                                                                        descriptors:[NSData dataWithBytes:terrestrialMux length:sizeof(terrestrialMux)]]];
+    NSData *body1 = [self nitBodyWithNetworkDescriptors:[NSData data]
+                                       transportStreams:[self transportStreamWithId:2
+                                                                        descriptors:[NSData dataWithBytes:cableMux length:sizeof(cableMux)]]];
+    return @[
+        [self sectionWithTableId:TABLE_ID_DVB_NIT_ACTUAL_NETWORK tableIdExtension:0x3001 version:version
+                   sectionNumber:0 lastSectionNumber:1 body:body0],
+        [self sectionWithTableId:TABLE_ID_DVB_NIT_ACTUAL_NETWORK tableIdExtension:0x3001 version:version
+                   sectionNumber:1 lastSectionNumber:1 body:body1],
+    ];
+}
+
+- (NSData *)otherNitSection {
+    NSData *body = [self nitBodyWithNetworkDescriptors:[NSData data]
+                                      transportStreams:[self transportStreamWithId:9 descriptors:[NSData data]]];
+    return [self sectionWithTableId:TABLE_ID_DVB_NIT_OTHER_NETWORK tableIdExtension:0x3002 version:0
+                      sectionNumber:0 lastSectionNumber:0 body:body];
+}
+
+- (NSData *)tdtPacketWithCc:(uint8_t)cc {
+    // section_syntax_indicator = 0, section_length = 5, no CRC
+    NSMutableData *payload = [NSMutableData dataWithBytes:(const uint8_t[]){ 0x00, 0x70, 0x70, 0x05 } length:4];
+    [payload appendBytes:kTdtUtcTime length:sizeof(kTdtUtcTime)];
+    return [TSTestUtils createRawPacketDataWithPid:PID_DVB_TDT_TOT_ST payload:payload pusi:YES continuityCounter:cc];
+}
+
+#pragma mark - NIT
+
+- (void)test_nit_aggregatesSectionsAndDecodesMuxes {
+    NSArray<NSData *> *sections = [self actualNitSectionsWithVersion:0];
+    [self.demuxer demux:[self packetWithPid:PID_DVB_NIT_ST section:sections[0] cc:0] dataArrivalHostTimeNanos:0];
+    XCTAssertNil(self.demuxer.dvb.nit, @"Not complete before the last section");
+    [self.demuxer demux:[self packetWithPid:PID_DVB_NIT_ST section:sections[1] cc:1] dataArrivalHostTimeNanos:0];
+
+    TSDvbNetworkInformationTable *nit = self.demuxer.dvb.nit;
+    XCTAssertNotNil(nit);
+    XCTAssertTrue(nit.isActualNetwork);
+    XCTAssertEqual(nit.networkId, (uint16_t)0x3001);
+    XCTAssertEqualObjects(nit.networkName, @"Test");
+    XCTAssertEqual(nit.transportStreamCount, (NSUInteger)2);
+
+    TSDvbNetworkTransportStream *terrestrial = [nit transportStreamWithId:1 originalNetworkId:0x22];
+    XCTAssertEqual(terrestrial.services.count, (NSUInteger)2);
+    XCTAssertEqual(terrestrial.services[1].serviceId, (uint16_t)2);
+    XCTAssertEqual(terrestrial.services[1].serviceType, (uint8_t)0x02);
+    TSDvbTerrestrialDeliverySystemDescriptor *dvbt = (TSDvbTerrestrialDeliverySystemDescriptor *)terrestrial.deliverySystem;
+    XCTAssertTrue([dvbt isKindOfClass:[TSDvbTerrestrialDeliverySystemDescriptor class]]);
+    XCTAssertEqual(dvbt.frequencyHz, (uint64_t)474000000);
+    XCTAssertEqual(dvbt.bandwidth, (uint8_t)0);
+    XCTAssertEqual(dvbt.constellation, (uint8_t)2);
+    XCTAssertEqual(dvbt.guardInterval, (uint8_t)2);
+    XCTAssertEqual(dvbt.transmissionMode, (uint8_t)1);
+
+    TSDvbCableDeliverySystemDescriptor *dvbc = (TSDvbCableDeliverySystemDescriptor *)[nit transportStreamWithId:2 originalNetworkId:0x22].deliverySystem;
+    XCTAssertTrue([dvbc isKindOfClass:[TSDvbCableDeliverySystemDescriptor class]]);
+    XCTAssertEqual(dvbc.frequencyHz, (uint64_t)346000000);
+    XCTAssertEqual(dvbc.symbolRate, (uint32_t)6900000);
+    XCTAssertEqual(dvbc.modulation, (uint8_t)3);
+    XCTAssertEqual(dvbc.fecOuter, (uint8_t)2);
+
+    XCTAssertNil([nit transportStreamWithId:3 originalNetworkId:0x22]);
+}
+
+- (void)test_nit_repeatsAreNotRedelivered_newVersionIs {
+    NSArray<NSData *> *v0 = [self actualNitSectionsWithVersion:0];
+    uint8_t cc = 0;
+    for (int repeat = 0; repeat < 3; repeat++) {
+        for (NSData *section in v0) {
+            [self.demuxer demux:[self packetWithPid:PID_DVB_NIT_ST section:section cc:cc++ & 0x0F] dataArrivalHostTimeNanos:0];
+        }
+    }
+    XCTAssertEqual(self.delegate.receivedNits.count, (NSUInteger)1);
+
+    for (NSData *section in [self actualNitSectionsWithVersion:1]) {
+        [self.demuxer demux:[self packetWithPid:PID_DVB_NIT_ST section:section cc:cc++ & 0x0F] dataArrivalHostTimeNanos:0];
+    }
+    XCTAssertEqual(self.delegate.receivedNits.count, (NSUInteger)2);
+    XCTAssertEqual(self.demuxer.dvb.nit.psi.versionNumber, (uint8_t)1);
+}
+
+- (void)test_nitOther_interleavedWithActual_bothComplete {
+    NSArray<NSData *> *actual = [self actualNitSectionsWithVersion:0];
+    [self.demuxer demux:[self packetWithPid:PID_DVB_NIT_ST section:actual[0] cc:0] dataArrivalHostTimeNanos:0];
+    [self.demuxer demux:[self packetWithPid:PID_DVB_NIT_ST section:[self otherNitSection] cc:1] dataArrivalHostTimeNanos:0];
+    [self.demuxer demux:[self packetWithPid:PID_DVB_NIT_ST section:actual[1] cc:2] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(self.demuxer.dvb.nit.transportStreamCount, (NSUInteger)2);
+    TSDvbNetworkInformationTable *other = self.demuxer.dvb.otherNetworkNits[@0x3002];
+    XCTAssertNotNil(other);
+    XCTAssertFalse(other.isActualNetwork);
+    XCTAssertEqual(other.transportStreams.firstObject.transportStreamId, (uint16_t)9);
+    XCTAssertEqual(self.delegate.receivedNits.count, (NSUInteger)2);
+}
+
+- (void)test_nit_onNetworkPidFromPat {
+    const uint16_t networkPid = 0x0020;
+    NSData *pat = [TSTestUtils createPatDataWithProgrammes:@{ @0: @(networkPid), @1: @0x0100 }
+                                             versionNumber:0
+                                         continuityCounter:0];
+    [self.demuxer demux:pat dataArrivalHostTimeNanos:0];
+
+    NSData *section = [self otherNitSection];
+    [self.demuxer demux:[self packetWithPid:networkPid section:section cc:0] dataArrivalHostTimeNanos:0];
+    XCTAssertNotNil(self.demuxer.dvb.otherNetworkNits[@0x3002]);
+}
+
+#pragma mark - TDT/TOT
+
+- (void)test_tdt_parsesUtcTime {
+    [self.demuxer demux:[self tdtPacketWithCc:0] dataArrivalHostTimeNanos:0];
+
+    TSDvbTimeTable *tdt = self.demuxer.dvb.timeTable;
+    XCTAssertNotNil(tdt);
+    XCTAssertFalse(tdt.isTimeOffsetTable);
+    XCTAssertEqual(tdt.unixSeconds, kTdtUnixSeconds);
+    XCTAssertNil(tdt.descriptors);
+    XCTAssertEqual(self.delegate.receivedTimeTables.count, (NSUInteger)1);
+}
+
+- (void)test_tot_parsesUtcTimeAndDescriptors {
+    const uint8_t localTimeOffset[] = {
+        0x58, 0x0D, 'S', 'W', 'E', 0x02, 0x01, 0x00,    // country SWE, region 0, +01:00
+        0xC0, 0x79, 0x12, 0x45, 0x00, 0x02, 0x00        // time_of_change, next offset +02:00
+    };
+    NSMutableData *payload = [NSMutableData dataWithLength:1];
+    const uint16_t sectionLength = 5 + 2 + sizeof(localTimeOffset) + 4;
+    const uint8_t header[] = { 0x73, 0x70 | (sectionLength >> 8), sectionLength & 0xFF };
+    [payload appendBytes:header length:sizeof(header)];
+    [payload appendBytes:kTdtUtcTime length:sizeof(kTdtUtcTime)];
+    const uint8_t loopLength[] = { 0xF0, sizeof(localTimeOffset) };
+    [payload appendBytes:loopLength length:sizeof(loopLength)];
+    [payload appendBytes:localTimeOffset length:sizeof(localTimeOffset)];
+    [payload appendBytes:(const uint8_t[]){ 0x12, 0x34, 0x56, 0x78 } length:4];
+    [self.demuxer demux:[TSTestUtils createRawPacketDataWithPid:PID_DVB_TDT_TOT_ST payload:payload pusi:YES continuityCounter:0] dataArrivalHostTimeNanos:0];
+
+    TSDvbTimeTable *tot = self.demuxer.dvb.timeTable;
+    XCTAssertNotNil(tot);
+    XCTAssertTrue(tot.isTimeOffsetTable);
+    XCTAssertEqual(tot.unixSeconds, kTdtUnixSeconds);
+    XCTAssertEqual(tot.descriptors.count, (NSUInteger)1);
+    XCTAssertEqual(tot.descriptors.firstObject.descriptorTag, (uint8_t)0x58);
+}
+
+#pragma mark - PCR to UTC
+
+- (void)test_clock_narrowsOffsetWithEachTimeTable {
+    TSPcrUtcClock *clock = [[TSPcrUtcClock alloc] initWithPcrPid:0x101];
+    XCTAssertFalse(clock.isValid);
+    XCTAssertTrue(isnan([clock unixSecondsForTimestamp:0]));
+
+    [clock addPcrBase:0 pcrExt:0 packetIndex:0 isDiscontinuous:NO];
+    [clock addPcrBase:90000 pcrExt:0 packetIndex:100 isDiscontinuous:NO];
+    [clock addUtcTime:1000 packetIndex:100];
+    XCTAssertTrue(clock.isValid);
+    XCTAssertEqualWithAccuracy(clock.uncertainty, 1.0, 1e-9);
+    // PCR 1 s was sent in [1000, 1001)
+    XCTAssertEqualWithAccuracy([clock unixSecondsForTimestamp:90000], 1000.5, 1e-6);
+
+    // PCR 1.3 s was sent in [1001, 1002): PCR 1 s was sent in [1000.7, 1001)
+    [clock addPcrBase:117000 pcrExt:0 packetIndex:130 isDiscontinuous:NO];
+    [clock addUtcTime:1001 packetIndex:130];
+    XCTAssertEqualWithAccuracy(clock.uncertainty, 0.3, 1e-6);
+    XCTAssertEqualWithAccuracy([clock unixSecondsForTimestamp:90000], 1000.85, 1e-6);
+    XCTAssertEqualWithAccuracy([clock unixSecondsForTimestamp:90000 + 90000 * 60], 1060.85, 1e-6);
+}
+
+- (void)test_clock_interpolatesPcrAtTimeTablePacket {
+    TSPcrUtcClock *clock = [[TSPcrUtcClock alloc] initWithPcrPid:0x101];
+    [clock addPcrBase:0 pcrExt:0 packetIndex:0 isDiscontinuous:NO];
+    [clock addPcrBase:90000 pcrExt:0 packetIndex:100 isDiscontinuous:NO];
+    // Half-way to the next PCR: PCR 1.5 s
+    [clock addUtcTime:2000 packetIndex:150];
+    XCTAssertEqualWithAccuracy([clock unixSecondsForTimestamp:135000], 2000.5, 1e-6);
+}
+
+- (void)test_clock_handlesWrapAndDiscontinuity {
+    const uint64_t wrap = 1ULL << 33;
+    TSPcrUtcClock *clock = [[TSPcrUtcClock alloc] initWithPcrPid:0x101];
+    [clock addPcrBase:wrap - 45000 pcrExt:0 packetIndex:0 isDiscontinuous:NO];
+    [clock addUtcTime:5000 packetIndex:0];
+    [clock addPcrBase:45000 pcrExt:0 packetIndex:100 isDiscontinuous:NO];
+    XCTAssertTrue(clock.isValid, @"Wrap is not a discontinuity");
+    XCTAssertEqualWithAccuracy([clock unixSecondsForTimestamp:wrap - 45000], 5000.5, 1e-6);
+    XCTAssertEqualWithAccuracy([clock unixSecondsForTimestamp:45000], 5001.5, 1e-6);
+
+    [clock addPcrBase:900000 pcrExt:0 packetIndex:200 isDiscontinuous:YES];
+    XCTAssertFalse(clock.isValid);
+    XCTAssertNil([clock utcDateForTime:CMTimeMake(900000, 90000)]);
+}
+
+- (void)test_demuxer_feedsProgramClockFromPcrAndTdt {
+    [self.demuxer demux:[TSTestUtils createPatDataWithPmtPid:0x100] dataArrivalHostTimeNanos:0];
+    XCTAssertNil([self.demuxer utcClockForProgram:1]);
+    [self.demuxer demux:[TSTestUtils createPmtDataWithPmtPid:0x100 pcrPid:0x101 elementaryStreamPid:0x101 streamType:0x1B] dataArrivalHostTimeNanos:0];
+
+    TSPcrUtcClock *clock = [self.demuxer utcClockForProgram:1];
+    XCTAssertNotNil(clock);
+    XCTAssertEqual(clock.pcrPid, (uint16_t)0x101);
+
+    [self.demuxer demux:[TSPacket pcrPacketDataWithPid:0x101 continuityCounter:0 pcrBase:900000 pcrExt:0] dataArrivalHostTimeNanos:0];
+    [self.demuxer demux:[self tdtPacketWithCc:0] dataArrivalHostTimeNanos:0];
+
+    XCTAssertTrue(clock.isValid);
+    NSDate *date = [clock utcDateForTime:CMTimeMake(900000 + 90000 * 60, 90000)];
+    XCTAssertEqualWithAccuracy(date.timeIntervalSince1970, kTdtUnixSeconds + 60.5, 1e-3);
+}
+
+@end
@@ -0,0 +1,185 @@
+//
+//  TSLazyTableDecodingTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for decode-once PMT/SDT/VCT entry access and raw-byte table equality.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+@interface TSLazyTableDecodingTests : XCTestCase
+@end
+
+@implementation TSLazyTableDecodingTests
+
+#pragma mark - Helpers
+
+- (TSProgramSpecificInformationTable *)psiWithTableId:(uint8_t)tableId sectionData:(NSData *)sectionData {
+    return [[TSProgramSpecificInformationTable alloc] initWithTableId:tableId
+                                               sectionSyntaxIndicator:1
+                                                         reservedBit1:1
+                                                        reservedBits2:3
+                                                        sectionLength:(uint16_t)(sectionData.length + 4)
+                                              sectionDataExcludingCrc:sectionData
+                                                                  crc:0];
+}
+
+/// SDT section with `count` services numbered from `firstServiceId`, each carrying a service descriptor.
+- (NSMutableData *)sdtSectionWithServiceCount:(NSUInteger)count firstServiceId:(uint16_t)firstServiceId {
+    const uint8_t header[] = {
+        0x00, 0x01,  // transport_stream_id = 1
+        0xC1,        // reserved + version 0 + current_next=1
+        0x00, 0x00,  // section_number, last_section_number
+        0x00, 0x02,  // original_network_id = 2
+        0xFF         // reserved_future_use
+    };
+    NSMutableData *data = [NSMutableData dataWithBytes:header length:sizeof(header)];
+    for (NSUInteger i = 0; i < count; ++i) {
+        const uint16_t serviceId = firstServiceId + i;
+        const uint8_t entry[] = {
+            serviceId >> 8, serviceId & 0xFF,
+            0xFD,        // reserved + EIT_schedule=0 + EIT_present_following=1
+            0x80, 0x0A,  // running_status=4, free_CA_mode=0, descriptors_loop_length=10
+            0x48, 0x08,  // service_descriptor, length 8
+            0x01,        // service_type = digital television
+            0x02, 'P', 'P',
+            0x03, 'S', 'V', 'C'
+        };
+        [data appendBytes:entry length:sizeof(entry)];
+    }
+    return data;
+}
+
+- (NSData *)pmtSectionWithPcrPid:(uint16_t)pcrPid {
+    const uint8_t section[] = {
+        0x00, 0x01,                                 // program_number = 1
+        0xC1,                                       // reserved + version 0 + current_next=1
+        0x00, 0x00,                                 // section_number, last_section_number
+        0xE0 | (pcrPid >> 8), pcrPid & 0xFF,        // reserved + PCR_PID
+        0xF0, 0x00,                                 // program_info_length = 0
+        0x1B, 0xE1, 0x01, 0xF0, 0x00,               // H.264 on 0x101, no descriptors
+        0x0F, 0xE1, 0x02, 0xF0, 0x06,               // AAC on 0x102, 6 bytes of descriptors
+        0x0A, 0x04, 'e', 'n', 'g', 0x00             // ISO 639 language descriptor
+    };
+    return [NSData dataWithBytes:section length:sizeof(section)];
+}
+
+#pragma mark - SDT
+
+- (void)test_sdt_entryLookupByServiceId {
+    TSDvbServiceDescriptionTable *sdt = [[TSDvbServiceDescriptionTable alloc]
+                                         initWithPSI:[self psiWithTableId:TABLE_ID_DVB_SDT_ACTUAL_TS
+                                                              sectionData:[self sdtSectionWithServiceCount:300 firstServiceId:1000]]];
+
+    XCTAssertEqual(sdt.entryCount, (NSUInteger)300);
+    TSDvbServiceDescriptionEntry *entry = [sdt entryWithServiceId:1150];
+    XCTAssertNotNil(entry);
+    XCTAssertEqual(entry.serviceId, (uint16_t)1150);
+    XCTAssertEqual(entry.runningStatus, (uint8_t)4);
+    XCTAssertTrue(entry.eitPresentFollowingFlag);
+    XCTAssertFalse(entry.eitScheduleFlag);
+    XCTAssertEqual(entry.descriptors.count, (NSUInteger)1);
+    XCTAssertTrue([entry.descriptors.firstObject isKindOfClass:[TSDvbServiceDescriptor class]]);
+    XCTAssertNil([sdt entryWithServiceId:999]);
+    XCTAssertNil([sdt entryAtIndex:300]);
+}
+
+- (void)test_sdt_entriesAreMemoised {
+    TSDvbServiceDescriptionTable *sdt = [[TSDvbServiceDescriptionTable alloc]
+                                         initWithPSI:[self psiWithTableId:TABLE_ID_DVB_SDT_ACTUAL_TS
+                                                              sectionData:[self sdtSectionWithServiceCount:3 firstServiceId:1]]];
+
+    TSDvbServiceDescriptionEntry *entry = [sdt entryAtIndex:1];
+    XCTAssertTrue(entry == [sdt entryWithServiceId:2]);
+    XCTAssertTrue(entry == sdt.entries[1]);
+    XCTAssertTrue(sdt.entries == sdt.entries);
+    XCTAssertTrue(entry.descriptors == entry.descriptors);
+}
+
+- (void)test_sdt_equalityByRawBytes {
+    NSMutableData *section = [self sdtSectionWithServiceCount:300 firstServiceId:1];
+    TSDvbServiceDescriptionTable *sdtA = [[TSDvbServiceDescriptionTable alloc]
+                                          initWithPSI:[self psiWithTableId:TABLE_ID_DVB_SDT_ACTUAL_TS sectionData:[section copy]]];
+    TSDvbServiceDescriptionTable *sdtB = [[TSDvbServiceDescriptionTable alloc]
+                                          initWithPSI:[self psiWithTableId:TABLE_ID_DVB_SDT_ACTUAL_TS sectionData:[section copy]]];
+    XCTAssertEqualObjects(sdtA, sdtB);
+    XCTAssertEqual(sdtA.hash, sdtB.hash);
+
+    // Change the service name of the last service
+    ((uint8_t *)section.mutableBytes)[section.length - 1] = 'X';
+    TSDvbServiceDescriptionTable *sdtC = [[TSDvbServiceDescriptionTable alloc]
+                                          initWithPSI:[self psiWithTableId:TABLE_ID_DVB_SDT_ACTUAL_TS sectionData:[section copy]]];
+    XCTAssertNotEqualObjects(sdtA, sdtC);
+    XCTAssertEqualObjects([sdtA entryAtIndex:0], [sdtC entryAtIndex:0]);
+    XCTAssertNotEqualObjects([sdtA entryAtIndex:299], [sdtC entryAtIndex:299]);
+}
+
+- (void)test_sdt_truncatedDescriptorsKeepEntry {
+    NSMutableData *section = [self sdtSectionWithServiceCount:2 firstServiceId:1];
+    [section setLength:section.length - 4];
+    TSDvbServiceDescriptionTable *sdt = [[TSDvbServiceDescriptionTable alloc]
+                                         initWithPSI:[self psiWithTableId:TABLE_ID_DVB_SDT_ACTUAL_TS sectionData:section]];
+
+    XCTAssertEqual(sdt.entryCount, (NSUInteger)2);
+    XCTAssertEqual([sdt entryAtIndex:1].serviceId, (uint16_t)2);
+    XCTAssertEqual([sdt entryAtIndex:1].descriptors.count, (NSUInteger)0);
+}
+
+#pragma mark - PMT
+
+- (void)test_pmt_streamLookupIsMemoised {
+    TSProgramMapTable *pmt = [[TSProgramMapTable alloc]
+                              initWithPSI:[self psiWithTableId:TABLE_ID_PMT sectionData:[self pmtSectionWithPcrPid:0x101]]];
+
+    TSElementaryStream *audio = [pmt elementaryStreamWithPid:0x102];
+    XCTAssertNotNil(audio);
+    XCTAssertEqual(audio.streamType, (uint8_t)0x0F);
+    XCTAssertEqual(audio.descriptors.count, (NSUInteger)1);
+    XCTAssertTrue(audio == [pmt elementaryStreamWithPid:0x102]);
+    XCTAssertTrue([pmt.elementaryStreams containsObject:audio]);
+    XCTAssertEqual(pmt.elementaryStreams.count, (NSUInteger)2);
+    XCTAssertNil([pmt elementaryStreamWithPid:0x103]);
+}
+
+- (void)test_pmt_equalityByRawBytes {
+    TSProgramMapTable *pmtA = [[TSProgramMapTable alloc]
+                               initWithPSI:[self psiWithTableId:TABLE_ID_PMT sectionData:[self pmtSectionWithPcrPid:0x101]]];
+    TSProgramMapTable *pmtB = [[TSProgramMapTable alloc]
+                               initWithPSI:[self psiWithTableId:TABLE_ID_PMT sectionData:[self pmtSectionWithPcrPid:0x101]]];
+    TSProgramMapTable *pmtC = [[TSProgramMapTable alloc]
+                               initWithPSI:[self psiWithTableId:TABLE_ID_PMT sectionData:[self pmtSectionWithPcrPid:0x102]]];
+
+    XCTAssertEqualObjects(pmtA, pmtB);
+    XCTAssertEqual(pmtA.hash, pmtB.hash);
+    // Same streams, different PCR PID
+    XCTAssertNotEqualObjects(pmtA, pmtC);
+}
+
+#pragma mark - VCT
+
+- (void)test_vct_channelForProgramNumber {
+    NSData *packet = [TSTestUtils createTvctDataWithTransportStreamId:1
+                                                          channelName:@"KABC"
+                                                         majorChannel:7
+                                                         minorChannel:1
+                                                        programNumber:3
+                                                        versionNumber:0
+                                                    continuityCounter:0];
+    // Section starts after the 4-byte header, pointer field and 3 bytes of table_id/section_length
+    const uint8_t *bytes = packet.bytes;
+    const uint16_t sectionLength = ((bytes[6] & 0x0F) << 8) | bytes[7];
+    NSData *section = [packet subdataWithRange:NSMakeRange(8, sectionLength - 4)];
+    TSAtscVirtualChannelTable *vct = [[TSAtscVirtualChannelTable alloc]
+                                      initWithPSI:[self psiWithTableId:TABLE_ID_ATSC_TVCT sectionData:section]];
+
+    XCTAssertEqual(vct.channelCount, (NSUInteger)1);
+    TSAtscVirtualChannel *channel = [vct channelForProgramNumber:3];
+    XCTAssertEqualObjects(channel.shortName, @"KABC");
+    XCTAssertTrue(channel == [vct channelAtIndex:0]);
+    XCTAssertTrue(channel == vct.channels.firstObject);
+    XCTAssertNil([vct channelForProgramNumber:4]);
+}
+
+@end
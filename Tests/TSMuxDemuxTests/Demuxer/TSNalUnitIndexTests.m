@@ -0,0 +1,189 @@
+//
+//  TSNalUnitIndexTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for H.264/HEVC NAL unit indexing during access unit assembly.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kTestPmtPid = 0x100;
+static const uint16_t kTestVideoPid = 0x101;
+
+#pragma mark - Test Delegate
+
+@interface TSNalIndexTestDelegate : NSObject <TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@end
+
+@implementation TSNalIndexTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedAccessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSNalUnitIndexTests : XCTestCase
+@end
+
+@implementation TSNalUnitIndexTests
+
+#pragma mark - Indexer
+
+- (void)test_h264_idrWithParameterSets {
+    // AUD, SPS, PPS, IDR slice - mixed 3 and 4 byte start codes
+    uint8_t bytes[] = {
+        0x00, 0x00, 0x00, 0x01, 0x09, 0xF0,
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x1E,
+        0x00, 0x00, 0x01, 0x68, 0xCE, 0x38, 0x80,
+        0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0x33
+    };
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+
+    TSNalUnitIndexer *indexer = [[TSNalUnitIndexer alloc] initWithCodec:TSNalUnitCodecH264];
+    TSNalUnitIndex *index = [indexer finishWithData:data];
+
+    XCTAssertEqual(index.count, (NSUInteger)4);
+    XCTAssertTrue(index.isKeyframe);
+    XCTAssertTrue(index.hasSps);
+    XCTAssertTrue(index.hasPps);
+    XCTAssertFalse(index.hasVps);
+
+    XCTAssertEqual([index entryAtIndex:0].type, 9);
+    XCTAssertEqual([index entryAtIndex:0].offset, (uint32_t)4);
+    // Trailing zero of the following 4-byte start code is not part of the NAL unit
+    XCTAssertEqual([index entryAtIndex:0].length, (uint32_t)2);
+    XCTAssertEqual([index entryAtIndex:1].type, 7);
+    XCTAssertEqual([index entryAtIndex:1].length, (uint32_t)4);
+    XCTAssertEqual([index entryAtIndex:2].type, 8);
+    XCTAssertEqual([index entryAtIndex:3].type, 5);
+    XCTAssertEqual([index entryAtIndex:3].offset, (uint32_t)24);
+    XCTAssertEqual([index entryAtIndex:3].length, (uint32_t)5);
+}
+
+- (void)test_h264_nonIdrSlice_notKeyframe {
+    uint8_t bytes[] = {0x00, 0x00, 0x01, 0x41, 0x9A, 0x02};
+    TSNalUnitIndexer *indexer = [[TSNalUnitIndexer alloc] initWithCodec:TSNalUnitCodecH264];
+    TSNalUnitIndex *index = [indexer finishWithData:[NSData dataWithBytes:bytes length:sizeof(bytes)]];
+
+    XCTAssertEqual(index.count, (NSUInteger)1);
+    XCTAssertEqual([index entryAtIndex:0].type, 1);
+    XCTAssertFalse(index.isKeyframe);
+}
+
+- (void)test_hevc_craWithParameterSets {
+    // VPS (32), SPS (33), PPS (34), CRA (21). HEVC type is bits 1-6 of the first header byte.
+    uint8_t bytes[] = {
+        0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0C,
+        0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01,
+        0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xC1,
+        0x00, 0x00, 0x00, 0x01, 0x2A, 0x01, 0xAF
+    };
+    TSNalUnitIndexer *indexer = [[TSNalUnitIndexer alloc] initWithCodec:TSNalUnitCodecH265];
+    TSNalUnitIndex *index = [indexer finishWithData:[NSData dataWithBytes:bytes length:sizeof(bytes)]];
+
+    XCTAssertEqual(index.count, (NSUInteger)4);
+    XCTAssertTrue(index.hasVps);
+    XCTAssertTrue(index.hasSps);
+    XCTAssertTrue(index.hasPps);
+    XCTAssertTrue(index.isKeyframe);
+    XCTAssertEqual([index entryAtIndex:3].type, 21);
+}
+
+- (void)test_incrementalScan_startCodeSplitAcrossAppends {
+    uint8_t bytes[] = {0x00, 0x00, 0x01, 0x41, 0xAA, 0xBB, 0x00, 0x00, 0x01, 0x65, 0xCC};
+    NSMutableData *data = [NSMutableData data];
+    TSNalUnitIndexer *indexer = [[TSNalUnitIndexer alloc] initWithCodec:TSNalUnitCodecH264];
+
+    // Feed one byte at a time so every start code and NAL header straddles an append
+    for (NSUInteger i = 0; i < sizeof(bytes); i++) {
+        [data appendBytes:bytes + i length:1];
+        [indexer scanData:data];
+    }
+    TSNalUnitIndex *index = [indexer finishWithData:data];
+
+    XCTAssertEqual(index.count, (NSUInteger)2);
+    XCTAssertEqual([index entryAtIndex:0].type, 1);
+    XCTAssertEqual([index entryAtIndex:0].length, (uint32_t)3);
+    XCTAssertEqual([index entryAtIndex:1].type, 5);
+    XCTAssertEqual([index entryAtIndex:1].offset, (uint32_t)9);
+    XCTAssertTrue(index.isKeyframe);
+}
+
+#pragma mark - Demuxer Integration
+
+- (TSDemuxer *)demuxerWithDelegate:(TSNalIndexTestDelegate *)delegate {
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    [demuxer demux:[TSTestUtils createPatDataWithPmtPid:kTestPmtPid] dataArrivalHostTimeNanos:0];
+    [demuxer demux:[TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                                 pcrPid:kTestVideoPid
+                                    elementaryStreamPid:kTestVideoPid
+                                             streamType:kRawStreamTypeH264]
+            dataArrivalHostTimeNanos:0];
+    return demuxer;
+}
+
+- (void)demuxFrames:(TSDemuxer *)demuxer {
+    TSElementaryStream *track = [[TSElementaryStream alloc] initWithPid:kTestVideoPid
+                                                            streamType:kRawStreamTypeH264
+                                                           descriptors:nil];
+    // Large IDR spanning several TS packets, followed by a P-frame to flush it
+    NSMutableData *idr = [NSMutableData dataWithLength:1000];
+    memset(idr.mutableBytes, 0xAB, idr.length);
+    uint8_t idrHeader[] = {0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x00, 0x01, 0x68, 0xCE, 0x00, 0x00, 0x01, 0x65};
+    memcpy(idr.mutableBytes, idrHeader, sizeof(idrHeader));
+    uint8_t pFrame[] = {0x00, 0x00, 0x01, 0x41, 0x9A};
+
+    [demuxer demux:[TSTestUtils createPesDataWithTrack:track payload:idr pts:CMTimeMake(3000, 90000)]
+            dataArrivalHostTimeNanos:0];
+    [demuxer demux:[TSTestUtils createPesDataWithTrack:track
+                                               payload:[NSData dataWithBytes:pFrame length:sizeof(pFrame)]
+                                                   pts:CMTimeMake(6000, 90000)]
+            dataArrivalHostTimeNanos:0];
+}
+
+- (void)test_demuxer_indexingEnabled_flagsKeyframe {
+    TSNalIndexTestDelegate *delegate = [[TSNalIndexTestDelegate alloc] init];
+    TSDemuxer *demuxer = [self demuxerWithDelegate:delegate];
+    demuxer.nalIndexingPids = [NSSet setWithObject:@(kTestVideoPid)];
+
+    [self demuxFrames:demuxer];
+
+    XCTAssertEqual(delegate.receivedAccessUnits.count, (NSUInteger)1);
+    TSAccessUnit *au = delegate.receivedAccessUnits.firstObject;
+    XCTAssertNotNil(au.nalUnitIndex);
+    XCTAssertEqual(au.nalUnitIndex.count, (NSUInteger)3);
+    XCTAssertTrue(au.nalUnitIndex.hasSps);
+    XCTAssertTrue(au.nalUnitIndex.hasPps);
+    XCTAssertTrue(au.isRandomAccessPoint, @"IDR should be flagged as RAP without adaptation field RAI");
+    XCTAssertEqual([au.nalUnitIndex entryAtIndex:2].length, (uint32_t)(1000 - 14));
+}
+
+- (void)test_demuxer_indexingDisabled_noIndex {
+    TSNalIndexTestDelegate *delegate = [[TSNalIndexTestDelegate alloc] init];
+    TSDemuxer *demuxer = [self demuxerWithDelegate:delegate];
+
+    [self demuxFrames:demuxer];
+
+    XCTAssertEqual(delegate.receivedAccessUnits.count, (NSUInteger)1);
+    XCTAssertNil(delegate.receivedAccessUnits.firstObject.nalUnitIndex);
+    XCTAssertFalse(delegate.receivedAccessUnits.firstObject.isRandomAccessPoint);
+}
+
+@end
@@ -2,10 +2,11 @@
 //  TSPacketFormatTests.m
 //  TSMuxDemuxTests
 //
-//  Tests for 188-byte and 204-byte TS packet parsing.
+//  Tests for 188-byte, 192-byte and 204-byte TS packet parsing.
 //
 
 #import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
 @import TSMuxDemux;
 
 @interface TSPacketFormatTests : XCTestCase
@@ -288,6 +289,55 @@
     XCTAssertEqual(packets[0].header.pid, (uint16_t)0x1FF);
 }
 
+#pragma mark - 192-byte Packet Format Tests
+
+- (void)test_packetsFromChunkedTsData_192Format_readsArrivalTimestamp {
+    const uint32_t arrivalTimestamps[] = { 0x3FFFFFF0, 0x00000010, 0x01234567 };
+    NSMutableData *chunk = [NSMutableData data];
+    for (NSUInteger i = 0; i < 3; i++) {
+        NSMutableData *packet = [NSMutableData dataWithLength:TS_PACKET_SIZE_192];
+        uint8_t *bytes = packet.mutableBytes;
+        // TP_extra_header: 2-bit copy permission indicator (set here), 30-bit arrival time stamp
+        bytes[0] = 0xC0 | (uint8_t)(arrivalTimestamps[i] >> 24);
+        bytes[1] = (uint8_t)(arrivalTimestamps[i] >> 16);
+        bytes[2] = (uint8_t)(arrivalTimestamps[i] >> 8);
+        bytes[3] = (uint8_t)arrivalTimestamps[i];
+        bytes[4] = TS_PACKET_HEADER_SYNC_BYTE;
+        bytes[5] = 0x00;
+        bytes[6] = (uint8_t)(i + 1);
+        bytes[7] = 0x10;
+        [chunk appendData:packet];
+    }
+
+    NSArray<TSPacket*> *packets = [TSPacket packetsFromChunkedTsData:chunk packetSize:TS_PACKET_SIZE_192];
+    XCTAssertEqual(packets.count, (NSUInteger)3);
+    for (NSUInteger i = 0; i < packets.count; i++) {
+        XCTAssertEqual(packets[i].header.pid, (uint16_t)(i + 1));
+        XCTAssertEqual(packets[i].arrivalTimestamp, arrivalTimestamps[i]);
+        XCTAssertEqual(packets[i].payload.length, (NSUInteger)184);
+    }
+    XCTAssertEqual(TSPacketDetectSize(chunk.bytes, chunk.length), (NSUInteger)TS_PACKET_SIZE_192);
+}
+
+- (void)test_detectSize_bySyncPeriodicity {
+    // 47 * 204 = 51 * 188: the length alone is ambiguous
+    NSData *bts = [TSTestUtils createNullPackets:47 packetSize:TS_PACKET_SIZE_204];
+    XCTAssertEqual(TSPacketDetectSize(bts.bytes, bts.length), (NSUInteger)TS_PACKET_SIZE_204);
+    NSData *ts = [TSTestUtils createNullPackets:51 packetSize:TS_PACKET_SIZE_188];
+    XCTAssertEqual(TSPacketDetectSize(ts.bytes, ts.length), (NSUInteger)TS_PACKET_SIZE_188);
+
+    // Tolerates a few corrupted sync bytes
+    NSMutableData *corrupted = [[TSTestUtils createNullPackets:8 packetSize:TS_PACKET_SIZE_204] mutableCopy];
+    ((uint8_t *)corrupted.mutableBytes)[3 * 204] = 0x00;
+    XCTAssertEqual(TSPacketDetectSize(corrupted.bytes, corrupted.length), (NSUInteger)TS_PACKET_SIZE_204);
+
+    // Undecided with a single packet, or without sync bytes
+    NSData *single = [TSTestUtils createNullPackets:1 packetSize:TS_PACKET_SIZE_188];
+    XCTAssertEqual(TSPacketDetectSize(single.bytes, single.length), (NSUInteger)0);
+    NSData *zeros = [NSMutableData dataWithLength:10 * TS_PACKET_SIZE_188];
+    XCTAssertEqual(TSPacketDetectSize(zeros.bytes, zeros.length), (NSUInteger)0);
+}
+
 - (void)test_packetsFromChunkedTsData_packetSizeMismatch {
     // Create 188-byte packets but try parsing as 204-byte
     NSMutableData *chunk = [NSMutableData dataWithLength:TS_PACKET_SIZE_188 * 2];
@@ -0,0 +1,236 @@
+//
+//  TSParallelFileDemuxerTests.m
+//  TSMuxDemuxTests
+//
+//  Tests that parallel range demuxing matches a serial TSDemuxer pass.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kTestPmtPid = 0x100;
+static const uint16_t kTestVideoPid = 0x101;
+static const uint16_t kTestAudioPid = 0x102;
+static const uint16_t kTestPcrPid = 0x110;
+static const int64_t kWrap = 1LL << 33;
+
+#pragma mark - Test Delegates
+
+@interface TSParallelFileDemuxerTestDelegate : NSObject <TSDemuxerDelegate, TSParallelFileDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@end
+
+@implementation TSParallelFileDemuxerTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedAccessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+- (void)parallelDemuxer:(TSParallelFileDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+- (NSArray<NSNumber *> *)ptsValuesForPid:(uint16_t)pid {
+    NSMutableArray<NSNumber *> *values = [NSMutableArray array];
+    for (TSAccessUnit *accessUnit in self.receivedAccessUnits) {
+        if (accessUnit.pid == pid) {
+            [values addObject:@(accessUnit.pts.value)];
+        }
+    }
+    return values;
+}
+
+- (NSArray<NSNumber *> *)timelinePtsValuesForPid:(uint16_t)pid {
+    NSMutableArray<NSNumber *> *values = [NSMutableArray array];
+    for (TSAccessUnit *accessUnit in self.receivedAccessUnits) {
+        if (accessUnit.pid == pid) {
+            [values addObject:@(accessUnit.timelinePts.value)];
+        }
+    }
+    return values;
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSParallelFileDemuxerTests : XCTestCase
+@property (nonatomic, strong) NSMutableData *stream;
+@property (nonatomic, copy) NSString *path;
+@end
+
+@implementation TSParallelFileDemuxerTests
+
+- (void)setUp {
+    [super setUp];
+    self.stream = [NSMutableData data];
+
+    TSElementaryStream *video = [[TSElementaryStream alloc] initWithPid:kTestVideoPid
+                                                             streamType:kRawStreamTypeH264
+                                                            descriptors:nil];
+    TSElementaryStream *audio = [[TSElementaryStream alloc] initWithPid:kTestAudioPid
+                                                             streamType:kRawStreamTypeADTSAAC
+                                                            descriptors:nil];
+    NSData *pat = [TSTestUtils createPatDataWithPmtPid:kTestPmtPid];
+    NSData *pmt = [TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                                pcrPid:kTestVideoPid
+                                               streams:@[video, audio]
+                                         versionNumber:0
+                                     continuityCounter:0];
+
+    // Multi-packet video frames interleaved with single-packet audio frames, so that range
+    // boundaries fall in the middle of access units on both PIDs.
+    int64_t pts = 90000;
+    for (int frame = 0; frame < 60; frame++) {
+        if (frame % 10 == 0) {
+            [self.stream appendData:pat];
+            [self.stream appendData:pmt];
+        }
+        NSMutableData *videoPayload = [NSMutableData dataWithLength:700 + (frame % 7) * 50];
+        memset(videoPayload.mutableBytes, frame, videoPayload.length);
+        [self.stream appendData:[TSTestUtils createPesDataWithTrack:video
+                                                            payload:videoPayload
+                                                                pts:CMTimeMake(pts, 90000)]];
+        NSMutableData *audioPayload = [NSMutableData dataWithLength:100];
+        memset(audioPayload.mutableBytes, frame, audioPayload.length);
+        [self.stream appendData:[TSTestUtils createPesDataWithTrack:audio
+                                                            payload:audioPayload
+                                                                pts:CMTimeMake(pts + 10, 90000)]];
+        pts += 3600;
+    }
+
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    XCTAssertTrue([self.stream writeToFile:self.path atomically:YES]);
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+    [super tearDown];
+}
+
+- (TSParallelFileDemuxerTestDelegate *)serialResult {
+    TSParallelFileDemuxerTestDelegate *delegate = [[TSParallelFileDemuxerTestDelegate alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    [demuxer demux:self.stream dataArrivalHostTimeNanos:0];
+    return delegate;
+}
+
+- (TSParallelFileDemuxerTestDelegate *)parallelResultWithRangeSize:(NSUInteger)rangeSize
+                                               maxConcurrentRanges:(NSUInteger)maxConcurrentRanges {
+    TSParallelFileDemuxerTestDelegate *delegate = [[TSParallelFileDemuxerTestDelegate alloc] init];
+    TSParallelFileDemuxer *demuxer = [[TSParallelFileDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    demuxer.rangeSize = rangeSize;
+    demuxer.maxConcurrentRanges = maxConcurrentRanges;
+    XCTAssertTrue([demuxer demuxFileAtPath:self.path index:nil]);
+    return delegate;
+}
+
+- (void)test_parallel_matchesSerialDemux {
+    TSParallelFileDemuxerTestDelegate *serial = [self serialResult];
+
+    // Range sizes that are not packet multiples are rounded down.
+    for (NSNumber *rangeSize in @[@(TS_PACKET_SIZE_188 * 7), @(TS_PACKET_SIZE_188 * 50 + 13), @(1 << 20)]) {
+        TSParallelFileDemuxerTestDelegate *parallel = [self parallelResultWithRangeSize:rangeSize.unsignedIntegerValue
+                                                                    maxConcurrentRanges:3];
+        XCTAssertEqualObjects([parallel ptsValuesForPid:kTestVideoPid], [serial ptsValuesForPid:kTestVideoPid],
+                              @"Video mismatch with range size %@", rangeSize);
+        XCTAssertEqualObjects([parallel ptsValuesForPid:kTestAudioPid], [serial ptsValuesForPid:kTestAudioPid],
+                              @"Audio mismatch with range size %@", rangeSize);
+    }
+}
+
+- (void)test_parallel_deliversCompleteAccessUnits {
+    TSParallelFileDemuxerTestDelegate *serial = [self serialResult];
+    TSParallelFileDemuxerTestDelegate *parallel = [self parallelResultWithRangeSize:TS_PACKET_SIZE_188 * 5
+                                                                maxConcurrentRanges:2];
+
+    XCTAssertEqual(parallel.receivedAccessUnits.count, serial.receivedAccessUnits.count);
+    NSMutableDictionary<NSNumber *, TSAccessUnit *> *serialByPts = [NSMutableDictionary dictionary];
+    for (TSAccessUnit *accessUnit in serial.receivedAccessUnits) {
+        serialByPts[@(accessUnit.pts.value)] = accessUnit;
+    }
+    for (TSAccessUnit *accessUnit in parallel.receivedAccessUnits) {
+        TSAccessUnit *expected = serialByPts[@(accessUnit.pts.value)];
+        XCTAssertNotNil(expected);
+        XCTAssertEqualObjects(accessUnit.compressedData, expected.compressedData);
+    }
+}
+
+- (void)test_parallel_timelineContinuesAcrossRanges {
+    // Six seconds of video with a PCR before each frame: the timestamps wrap after two seconds and
+    // jump ahead by a minute (a new epoch) after four, so both fall between PCR samples and ranges.
+    TSElementaryStream *video = [[TSElementaryStream alloc] initWithPid:kTestVideoPid
+                                                             streamType:kRawStreamTypeH264
+                                                            descriptors:nil];
+    NSData *pat = [TSTestUtils createPatDataWithPmtPid:kTestPmtPid];
+    NSData *pmt = [TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                                pcrPid:kTestPcrPid
+                                               streams:@[video]
+                                         versionNumber:0
+                                     continuityCounter:0];
+    NSMutableData *stream = [NSMutableData data];
+    int64_t pts = kWrap - 50 * 3600;
+    for (int frame = 0; frame < 150; frame++) {
+        if (frame == 100) {
+            pts += 60 * 90000;
+        }
+        if (frame % 10 == 0) {
+            [stream appendData:pat];
+            [stream appendData:pmt];
+        }
+        const uint64_t rawPts = (uint64_t)(pts % kWrap);
+        const uint64_t pcrBase = (uint64_t)((pts - 9000 + kWrap) % kWrap);
+        [stream appendData:[TSPacket pcrPacketDataWithPid:kTestPcrPid continuityCounter:0 pcrBase:pcrBase pcrExt:0]];
+        NSMutableData *payload = [NSMutableData dataWithLength:400];
+        memset(payload.mutableBytes, frame, payload.length);
+        [stream appendData:[TSTestUtils createPesDataWithTrack:video payload:payload pts:CMTimeMake(rawPts, 90000)]];
+        pts += 3600;
+    }
+    self.stream = stream;
+    XCTAssertTrue([self.stream writeToFile:self.path atomically:YES]);
+
+    TSParallelFileDemuxerTestDelegate *serial = [self serialResult];
+    NSArray<NSNumber *> *expected = [serial timelinePtsValuesForPid:kTestVideoPid];
+    XCTAssertEqual(expected.count, (NSUInteger)149);
+    XCTAssertGreaterThan(expected.lastObject.longLongValue, kWrap, @"The serial timeline continues past the wrap");
+    for (NSUInteger i = 1; i < expected.count; i++) {
+        XCTAssertGreaterThan(expected[i].longLongValue, expected[i - 1].longLongValue);
+    }
+
+    for (NSNumber *rangeSize in @[@(TS_PACKET_SIZE_188 * 7), @(TS_PACKET_SIZE_188 * 64)]) {
+        TSParallelFileDemuxerTestDelegate *parallel = [self parallelResultWithRangeSize:rangeSize.unsignedIntegerValue
+                                                                    maxConcurrentRanges:3];
+        XCTAssertEqualObjects([parallel timelinePtsValuesForPid:kTestVideoPid], expected,
+                              @"Timeline mismatch with range size %@", rangeSize);
+    }
+}
+
+- (void)test_parallel_respectsEsPidFilter {
+    TSParallelFileDemuxerTestDelegate *delegate = [[TSParallelFileDemuxerTestDelegate alloc] init];
+    TSParallelFileDemuxer *demuxer = [[TSParallelFileDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    demuxer.rangeSize = TS_PACKET_SIZE_188 * 20;
+    demuxer.esPidFilter = [NSSet setWithObject:@(kTestAudioPid)];
+    XCTAssertTrue([demuxer demuxFileAtPath:self.path index:nil]);
+
+    XCTAssertEqual([delegate ptsValuesForPid:kTestVideoPid].count, (NSUInteger)0);
+    XCTAssertEqual([delegate ptsValuesForPid:kTestAudioPid].count, (NSUInteger)59);
+}
+
+- (void)test_parallel_missingFileFails {
+    TSParallelFileDemuxer *demuxer = [[TSParallelFileDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    XCTAssertFalse([demuxer demuxFileAtPath:@"/nonexistent/file.ts" index:nil]);
+}
+
+@end
@@ -0,0 +1,148 @@
+//
+//  TSPcrClockRecoveryTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for recovering the program clock (PCR) against the arrival host time.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint64_t kHostStartNanos = 5000000000000ULL;
+// PCR every 40 ms
+static const uint64_t kPcrInterval90kHz = 3600;
+
+@interface TSPcrClockRecoveryTests : XCTestCase
+@end
+
+@implementation TSPcrClockRecoveryTests
+
+/// Feeds `count` PCRs starting at `pcrBase`, arriving at a host clock running `driftPpm` faster than
+/// the stream clock, with `noiseNanos` added to every other arrival and subtracted from the others.
+- (void)feed:(TSPcrClockRecovery *)recovery
+     pcrBase:(uint64_t)pcrBase
+       count:(NSUInteger)count
+    driftPpm:(double)driftPpm
+  noiseNanos:(int64_t)noiseNanos {
+    for (NSUInteger i = 0; i < count; i++) {
+        const double streamSeconds = (double)(i * kPcrInterval90kHz) / 90000.0;
+        const int64_t noise = (i % 2) ? noiseNanos : -noiseNanos;
+        const uint64_t host = kHostStartNanos + (uint64_t)llround(streamSeconds * (1.0 + driftPpm / 1e6) * 1e9) + noise;
+        [recovery addPcrBase:(pcrBase + i * kPcrInterval90kHz) & ((1ULL << 33) - 1)
+                      pcrExt:0
+            arrivalHostNanos:host
+             isDiscontinuous:NO];
+    }
+}
+
+- (void)test_recovery_estimatesDriftAndMapsTimestamps {
+    TSPcrClockRecovery *recovery = [[TSPcrClockRecovery alloc] initWithPcrPid:0x101 windowSize:512];
+    XCTAssertFalse(recovery.isLocked);
+    XCTAssertEqual([recovery hostTimeNanosForTimestamp:0], (uint64_t)0);
+
+    [self feed:recovery pcrBase:900000 count:100 driftPpm:50.0 noiseNanos:0];
+    XCTAssertTrue(recovery.isLocked);
+    XCTAssertEqual(recovery.sampleCount, (NSUInteger)100);
+    XCTAssertEqualWithAccuracy(recovery.driftPpm, 50.0, 0.01);
+    // Without noise, the transit time only changes by the drift: 2 µs per 40 ms
+    XCTAssertEqualWithAccuracy(recovery.jitterNanos, 2000.0, 10.0);
+    XCTAssertEqualWithAccuracy(recovery.residualNanos, 0.0, 1000.0);
+
+    // 60 s after the first PCR, with the drift
+    const uint64_t expected = kHostStartNanos + (uint64_t)llround(60.0 * (1.0 + 50e-6) * 1e9);
+    XCTAssertEqualWithAccuracy((double)[recovery hostTimeNanosForTimestamp:900000 + 90000 * 60], (double)expected, 1000.0);
+    XCTAssertEqualWithAccuracy((double)[recovery hostTimeNanosForTime:CMTimeMake(900000 + 90000 * 60, 90000)], (double)expected, 1000.0);
+}
+
+- (void)test_recovery_smoothsArrivalJitter {
+    TSPcrClockRecovery *recovery = [[TSPcrClockRecovery alloc] initWithPcrPid:0x101 windowSize:512];
+    // ±1 ms around the true arrival time
+    [self feed:recovery pcrBase:0 count:500 driftPpm:0.0 noiseNanos:1000000];
+
+    // Consecutive transit times differ by 2 ms
+    XCTAssertEqualWithAccuracy(recovery.jitterNanos, 2000000.0, 1000.0);
+    XCTAssertEqualWithAccuracy(recovery.residualNanos, 1000000.0, 1000.0);
+    XCTAssertEqualWithAccuracy(recovery.driftPpm, 0.0, 1.0);
+    // The mapping is on the line, not on the last (late) arrival
+    const double streamSeconds = (double)(499 * kPcrInterval90kHz) / 90000.0;
+    XCTAssertEqualWithAccuracy((double)[recovery hostTimeNanosForTimestamp:499 * kPcrInterval90kHz],
+                               (double)kHostStartNanos + streamSeconds * 1e9, 20000.0);
+}
+
+- (void)test_recovery_slidesWindowAcrossPcrWrap {
+    const uint64_t wrap = 1ULL << 33;
+    TSPcrClockRecovery *recovery = [[TSPcrClockRecovery alloc] initWithPcrPid:0x101 windowSize:32];
+    // 200 samples: the window slides and is rebased several times, and the PCR wraps half-way
+    [self feed:recovery pcrBase:wrap - 100 * kPcrInterval90kHz count:200 driftPpm:-30.0 noiseNanos:0];
+
+    XCTAssertTrue(recovery.isLocked);
+    XCTAssertEqual(recovery.sampleCount, (NSUInteger)32);
+    XCTAssertEqualWithAccuracy(recovery.driftPpm, -30.0, 0.05);
+    const double streamSeconds = (double)(199 * kPcrInterval90kHz) / 90000.0;
+    XCTAssertEqualWithAccuracy((double)[recovery hostTimeNanosForTimestamp:99 * kPcrInterval90kHz],
+                               (double)kHostStartNanos + streamSeconds * (1.0 - 30e-6) * 1e9, 1000.0);
+}
+
+- (void)test_recovery_restartsOnDiscontinuityAndStall {
+    TSPcrClockRecovery *recovery = [[TSPcrClockRecovery alloc] initWithPcrPid:0x101 windowSize:512];
+    [self feed:recovery pcrBase:0 count:50 driftPpm:0.0 noiseNanos:0];
+    XCTAssertTrue(recovery.isLocked);
+
+    [recovery addPcrBase:50 * kPcrInterval90kHz pcrExt:0 arrivalHostNanos:kHostStartNanos + 2000000000ULL isDiscontinuous:YES];
+    XCTAssertFalse(recovery.isLocked);
+    XCTAssertEqual(recovery.sampleCount, (NSUInteger)1);
+
+    // The input stalls for 5 s: the PCR is continuous, but the arrival is far off the line
+    [self feed:recovery pcrBase:0 count:50 driftPpm:0.0 noiseNanos:0];
+    XCTAssertTrue(recovery.isLocked);
+    [recovery addPcrBase:50 * kPcrInterval90kHz pcrExt:0 arrivalHostNanos:kHostStartNanos + 7000000000ULL isDiscontinuous:NO];
+    XCTAssertFalse(recovery.isLocked);
+    XCTAssertEqual(recovery.sampleCount, (NSUInteger)1);
+}
+
+- (void)test_recovery_rejectsTooSmallWindow {
+    XCTAssertThrows([[TSPcrClockRecovery alloc] initWithPcrPid:0x101 windowSize:1]);
+}
+
+- (void)test_demuxer_feedsClockRecoveryFromPcrArrival {
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    [demuxer demux:[TSTestUtils createPatDataWithPmtPid:0x100] dataArrivalHostTimeNanos:0];
+    XCTAssertNil([demuxer clockRecoveryForProgram:1]);
+    [demuxer demux:[TSTestUtils createPmtDataWithPmtPid:0x100 pcrPid:0x101 elementaryStreamPid:0x101 streamType:0x1B] dataArrivalHostTimeNanos:0];
+
+    TSPcrClockRecovery *recovery = [demuxer clockRecoveryForProgram:1];
+    XCTAssertNotNil(recovery);
+    XCTAssertEqual(recovery.pcrPid, (uint16_t)0x101);
+    XCTAssertEqual(recovery.windowSize, (NSUInteger)512);
+
+    for (NSUInteger i = 0; i < 20; i++) {
+        [demuxer demux:[TSPacket pcrPacketDataWithPid:0x101 continuityCounter:(uint8_t)(i & 0xF) pcrBase:i * kPcrInterval90kHz pcrExt:0] dataArrivalHostTimeNanos:kHostStartNanos + i * 40000000ULL];
+    }
+    XCTAssertTrue(recovery.isLocked);
+    XCTAssertEqualWithAccuracy(recovery.driftPpm, 0.0, 0.01);
+    XCTAssertEqualWithAccuracy((double)[recovery hostTimeNanosForTimestamp:90000], (double)kHostStartNanos + 1e9, 1000.0);
+
+    demuxer.clockRecoveryWindowSize = 64;
+    TSPcrClockRecovery *restarted = [demuxer clockRecoveryForProgram:1];
+    XCTAssertEqual(restarted.windowSize, (NSUInteger)64);
+    XCTAssertFalse(restarted.isLocked);
+    XCTAssertThrows(demuxer.clockRecoveryWindowSize = 1);
+}
+
+- (void)test_demuxer_feedsClockRecoveryFromFilteredOutPcrPid {
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    demuxer.esPidFilter = [NSSet setWithObject:@(0x102)];
+    [demuxer demux:[TSTestUtils createPatDataWithPmtPid:0x100] dataArrivalHostTimeNanos:0];
+    [demuxer demux:[TSTestUtils createPmtDataWithPmtPid:0x100 pcrPid:0x101 elementaryStreamPid:0x101 streamType:0x1B] dataArrivalHostTimeNanos:0];
+
+    TSPcrClockRecovery *recovery = [demuxer clockRecoveryForProgram:1];
+    for (NSUInteger i = 0; i < 20; i++) {
+        [demuxer demux:[TSPacket pcrPacketDataWithPid:0x101 continuityCounter:(uint8_t)(i & 0xF) pcrBase:i * kPcrInterval90kHz pcrExt:0] dataArrivalHostTimeNanos:kHostStartNanos + i * 40000000ULL];
+    }
+    XCTAssertTrue(recovery.isLocked, @"The PCR should be read even though its PID is filtered out");
+    XCTAssertEqualWithAccuracy((double)[recovery hostTimeNanosForTimestamp:90000], (double)kHostStartNanos + 1e9, 1000.0);
+    XCTAssertNil(demuxer.bufferedBytesByPid[@(0x101)], @"A filtered out PCR PID should only feed the clocks");
+}
+
+@end
@@ -79,4 +79,63 @@
     XCTAssertEqual(pesHeader.payloadOffset, 6);
 }
 
+#pragma mark - Struct Parser
+
+- (void)test_structParse_ptsAndDts_rawValues {
+    // Video PES with PTS=0x1_2345_6789 (33 bits) and DTS=900000
+    const uint64_t pts = 0x123456789ULL;
+    const uint64_t dts = 900000;
+    uint8_t pes[] = {
+        0x00, 0x00, 0x01, 0xE0, 0x00, 0x00,
+        0x84,                   // '10' marker, data_alignment_indicator=1
+        0xC0,                   // PTS_DTS_flags = 11
+        0x0A,                   // PES_header_data_length
+        (uint8_t)(0x31 | ((pts >> 29) & 0x0E)), (uint8_t)(pts >> 22), (uint8_t)(((pts >> 14) & 0xFE) | 1),
+        (uint8_t)(pts >> 7), (uint8_t)(((pts << 1) & 0xFE) | 1),
+        (uint8_t)(0x11 | ((dts >> 29) & 0x0E)), (uint8_t)(dts >> 22), (uint8_t)(((dts >> 14) & 0xFE) | 1),
+        (uint8_t)(dts >> 7), (uint8_t)(((dts << 1) & 0xFE) | 1),
+        0xAB, 0xCD
+    };
+
+    TSPesHeaderInfo info;
+    XCTAssertTrue(TSPesHeaderParse(pes, sizeof(pes), &info));
+    XCTAssertTrue(info.hasPts);
+    XCTAssertTrue(info.hasDts);
+    XCTAssertTrue(info.dataAlignment);
+    XCTAssertEqual(info.pts, pts);
+    XCTAssertEqual(info.dts, dts);
+    XCTAssertEqual(info.streamId, 0xE0);
+    XCTAssertEqual(info.payloadOffset, 19);
+
+    // Lazy CMTime conversion matches the raw value
+    CMTime ptsTime = TSPesHeaderInfoPtsTime(&info);
+    XCTAssertEqual(ptsTime.value, (int64_t)pts);
+    XCTAssertEqual(ptsTime.timescale, 90000);
+}
+
+- (void)test_structParse_invalidStartCode_fails {
+    uint8_t pes[] = {0x00, 0x00, 0x02, 0xE0, 0x00, 0x00, 0x80, 0x00, 0x00};
+    TSPesHeaderInfo info;
+    XCTAssertFalse(TSPesHeaderParse(pes, sizeof(pes), &info));
+}
+
+- (void)test_structParse_matchesObjectParser {
+    TSElementaryStream *track = [[TSElementaryStream alloc] initWithPid:0x100
+                                                            streamType:kRawStreamTypeH264
+                                                           descriptors:nil];
+    NSData *ts = [TSTestUtils createPesDataWithTrack:track
+                                            payload:[NSMutableData dataWithLength:32]
+                                                pts:CMTimeMake(123456, 90000)];
+    TSPacket *packet = [TSPacket packetsFromChunkedTsData:ts packetSize:TS_PACKET_SIZE_188].firstObject;
+
+    TSPesHeader *pesHeader = [TSPesHeader parseFromPacket:packet];
+    TSPesHeaderInfo info;
+    XCTAssertTrue(TSPesHeaderParse(packet.payload.bytes, packet.payload.length, &info));
+
+    XCTAssertNotNil(pesHeader);
+    XCTAssertEqual(info.pts, (uint64_t)123456);
+    XCTAssertEqual(pesHeader.payloadOffset, info.payloadOffset);
+    XCTAssertEqual(CMTimeCompare(pesHeader.pts, TSPesHeaderInfoPtsTime(&info)), 0);
+}
+
 @end
@@ -0,0 +1,200 @@
+//
+//  TSPidSubscriptionTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for per-PID subscriptions and header-level PID filtering.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kTestPmtPid = 0x100;
+static const uint16_t kTestVideoPid = 0x101;
+static const uint16_t kTestAudioPid = 0x102;
+
+#pragma mark - Test Delegate / Subscriber
+
+@interface TSPidSubscriptionTestReceiver : NSObject <TSDemuxerDelegate, TSDemuxerPidSubscriber>
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@end
+
+@implementation TSPidSubscriptionTestReceiver
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedAccessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+- (NSUInteger)countForPid:(uint16_t)pid {
+    NSUInteger count = 0;
+    for (TSAccessUnit *accessUnit in self.receivedAccessUnits) {
+        if (accessUnit.pid == pid) {
+            count++;
+        }
+    }
+    return count;
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSPidSubscriptionTests : XCTestCase
+@property (nonatomic, strong) NSData *psi;
+@property (nonatomic, strong) TSElementaryStream *video;
+@property (nonatomic, strong) TSElementaryStream *audio;
+@property (nonatomic) int64_t nextPts;
+@end
+
+@implementation TSPidSubscriptionTests
+
+- (void)setUp {
+    [super setUp];
+    self.video = [[TSElementaryStream alloc] initWithPid:kTestVideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    self.audio = [[TSElementaryStream alloc] initWithPid:kTestAudioPid streamType:kRawStreamTypeADTSAAC descriptors:nil];
+
+    NSMutableData *psi = [NSMutableData data];
+    [psi appendData:[TSTestUtils createPatDataWithPmtPid:kTestPmtPid]];
+    [psi appendData:[TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                                  pcrPid:kTestVideoPid
+                                                 streams:@[self.video, self.audio]
+                                           versionNumber:0
+                                       continuityCounter:0]];
+    self.psi = psi;
+    self.nextPts = 90000;
+}
+
+/// `count` frames on both PIDs. Only count - 1 per PID are delivered (the last one is pending).
+- (NSData *)framesWithCount:(NSUInteger)count {
+    NSMutableData *data = [NSMutableData data];
+    NSMutableData *payload = [NSMutableData dataWithLength:300];
+    for (NSUInteger i = 0; i < count; i++) {
+        CMTime pts = CMTimeMake(self.nextPts, 90000);
+        [data appendData:[TSTestUtils createPesDataWithTrack:self.video payload:payload pts:pts]];
+        [data appendData:[TSTestUtils createPesDataWithTrack:self.audio payload:payload pts:pts]];
+        self.nextPts += 3600;
+    }
+    return data;
+}
+
+- (void)test_subscription_withDelegate_delegateKeepsAllPids {
+    TSPidSubscriptionTestReceiver *delegate = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSPidSubscriptionTestReceiver *subscriber = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    [demuxer addSubscriber:subscriber forPid:kTestAudioPid];
+
+    [demuxer demux:self.psi dataArrivalHostTimeNanos:0];
+    [demuxer demux:[self framesWithCount:5] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual([subscriber countForPid:kTestAudioPid], (NSUInteger)4);
+    XCTAssertEqual([subscriber countForPid:kTestVideoPid], (NSUInteger)0);
+    XCTAssertEqual([delegate countForPid:kTestVideoPid], (NSUInteger)4, @"A subscription should not narrow the delegate's PIDs");
+    XCTAssertEqual([delegate countForPid:kTestAudioPid], (NSUInteger)4, @"Delegate receives every assembled access unit");
+}
+
+- (void)test_subscription_withoutDelegate_onlySubscribedPidIsProcessed {
+    TSPidSubscriptionTestReceiver *subscriber = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    [demuxer addSubscriber:subscriber forPid:kTestAudioPid];
+
+    [demuxer demux:self.psi dataArrivalHostTimeNanos:0];
+    [demuxer demux:[self framesWithCount:5] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual([subscriber countForPid:kTestAudioPid], (NSUInteger)4);
+    XCTAssertEqualObjects([NSSet setWithArray:demuxer.bufferedBytesByPid.allKeys], [NSSet setWithObject:@(kTestAudioPid)],
+                          @"Unsubscribed PID should be dropped when subscribers are the only consumers");
+}
+
+- (void)test_subscription_subscribersReceiveOwnPids {
+    TSPidSubscriptionTestReceiver *videoSubscriber = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSPidSubscriptionTestReceiver *audioSubscriber = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    [demuxer addSubscriber:videoSubscriber forPid:kTestVideoPid];
+    [demuxer addSubscriber:audioSubscriber forPid:kTestAudioPid];
+
+    [demuxer demux:self.psi dataArrivalHostTimeNanos:0];
+    [demuxer demux:[self framesWithCount:4] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(videoSubscriber.receivedAccessUnits.count, (NSUInteger)3);
+    XCTAssertEqual([videoSubscriber countForPid:kTestVideoPid], (NSUInteger)3);
+    XCTAssertEqual(audioSubscriber.receivedAccessUnits.count, (NSUInteger)3);
+    XCTAssertEqual([audioSubscriber countForPid:kTestAudioPid], (NSUInteger)3);
+}
+
+- (void)test_subscription_afterPmtCreatesBuilder {
+    TSPidSubscriptionTestReceiver *subscriber = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    demuxer.esPidFilter = [NSSet setWithObject:@(kTestVideoPid)];
+
+    [demuxer demux:self.psi dataArrivalHostTimeNanos:0];
+    [demuxer addSubscriber:subscriber forPid:kTestAudioPid];
+    [demuxer demux:[self framesWithCount:3] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual([subscriber countForPid:kTestAudioPid], (NSUInteger)2,
+                   @"Subscribing to a PID of an already received PMT should start assembling it");
+}
+
+- (void)test_subscription_filterAndSubscriptionsCombine {
+    TSPidSubscriptionTestReceiver *delegate = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSPidSubscriptionTestReceiver *subscriber = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    demuxer.esPidFilter = [NSSet setWithObject:@(kTestVideoPid)];
+    [demuxer addSubscriber:subscriber forPid:kTestAudioPid];
+
+    [demuxer demux:self.psi dataArrivalHostTimeNanos:0];
+    [demuxer demux:[self framesWithCount:3] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual([delegate countForPid:kTestVideoPid], (NSUInteger)2);
+    XCTAssertEqual([delegate countForPid:kTestAudioPid], (NSUInteger)2);
+    XCTAssertEqual([subscriber countForPid:kTestVideoPid], (NSUInteger)0);
+    XCTAssertEqual([subscriber countForPid:kTestAudioPid], (NSUInteger)2);
+}
+
+- (void)test_subscription_removeOrDelegateRestoresAllPids {
+    TSPidSubscriptionTestReceiver *subscriber = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    [demuxer addSubscriber:subscriber forPid:kTestAudioPid];
+    [demuxer demux:self.psi dataArrivalHostTimeNanos:0];
+    [demuxer demux:[self framesWithCount:2] dataArrivalHostTimeNanos:0];
+    XCTAssertNil(demuxer.bufferedBytesByPid[@(kTestVideoPid)]);
+
+    [demuxer removeSubscriber:subscriber];
+    [demuxer demux:[self framesWithCount:3] dataArrivalHostTimeNanos:0];
+    XCTAssertNotNil(demuxer.bufferedBytesByPid[@(kTestVideoPid)]);
+    XCTAssertEqual(subscriber.receivedAccessUnits.count, (NSUInteger)1, @"No deliveries after removal");
+
+    // Subscribed again: narrowed until a delegate is set
+    TSPidSubscriptionTestReceiver *delegate = [[TSPidSubscriptionTestReceiver alloc] init];
+    [demuxer addSubscriber:subscriber forPid:kTestAudioPid];
+    XCTAssertNil(demuxer.bufferedBytesByPid[@(kTestVideoPid)]);
+    demuxer.delegate = delegate;
+    [demuxer demux:[self framesWithCount:3] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual([delegate countForPid:kTestVideoPid], (NSUInteger)2);
+}
+
+- (void)test_filter_pmtPidInSameChunkAsPatIsNotDropped {
+    TSPidSubscriptionTestReceiver *delegate = [[TSPidSubscriptionTestReceiver alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    demuxer.esPidFilter = [NSSet setWithObject:@(kTestAudioPid)];
+
+    NSMutableData *stream = [NSMutableData dataWithData:self.psi];
+    [stream appendData:[self framesWithCount:3]];
+    [demuxer demux:stream dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(demuxer.pmts.count, (NSUInteger)1);
+    XCTAssertEqual([delegate countForPid:kTestAudioPid], (NSUInteger)2);
+    XCTAssertEqual([delegate countForPid:kTestVideoPid], (NSUInteger)0);
+}
+
+@end
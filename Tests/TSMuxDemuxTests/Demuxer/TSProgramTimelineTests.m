@@ -0,0 +1,149 @@
+//
+//  TSProgramTimelineTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for placing 33-bit PCR/PTS/DTS on a continuous 64-bit timeline per program.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kTestPmtPid = 0x100;
+static const uint16_t kTestVideoPid = 0x101;
+static const uint16_t kTestAudioPid = 0x102;
+static const uint16_t kTestPcrPid = 0x110;
+static const int64_t kWrap = 1LL << 33;
+
+#pragma mark - Test Delegate
+
+@interface TSProgramTimelineTestDelegate : NSObject <TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@end
+
+@implementation TSProgramTimelineTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedAccessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSProgramTimelineTests : XCTestCase
+@end
+
+@implementation TSProgramTimelineTests
+
+- (void)test_timestampsOnly_unwrapAcrossWrap {
+    TSProgramTimeline *timeline = [TSProgramTimeline new];
+    XCTAssertEqual([timeline timelineValueForTimestamp:kWrap - 6000 isDiscontinuous:NO], kWrap - 6000);
+    XCTAssertEqual([timeline timelineValueForTimestamp:kWrap - 3000 isDiscontinuous:NO], kWrap - 3000);
+    XCTAssertEqual([timeline timelineValueForTimestamp:0 isDiscontinuous:NO], kWrap);
+    // Reordered (B-frame) timestamp from before the wrap
+    XCTAssertEqual([timeline timelineValueForTimestamp:kWrap - 1500 isDiscontinuous:NO], kWrap - 1500);
+    XCTAssertEqual([timeline timelineValueForTimestamp:3000 isDiscontinuous:NO], kWrap + 3000);
+    XCTAssertFalse(timeline.hasPcr);
+    XCTAssertEqual(timeline.discontinuityCount, (NSUInteger)0);
+}
+
+- (void)test_timestampsOnly_jumpContinuesTimeline {
+    TSProgramTimeline *timeline = [TSProgramTimeline new];
+    [timeline timelineValueForTimestamp:90000 isDiscontinuous:NO];
+    [timeline timelineValueForTimestamp:93000 isDiscontinuous:NO];
+
+    // A 1 h jump: the new epoch continues one step after the last timestamp
+    XCTAssertEqual([timeline timelineValueForTimestamp:90000 * 3600 isDiscontinuous:NO], (int64_t)96000);
+    XCTAssertEqual([timeline timelineValueForTimestamp:90000 * 3600 + 3000 isDiscontinuous:NO], (int64_t)99000);
+    // Another stream still before the jump
+    XCTAssertEqual([timeline timelineValueForTimestamp:94000 isDiscontinuous:NO], (int64_t)94000);
+    XCTAssertEqual(timeline.discontinuityCount, (NSUInteger)1);
+
+    // A flagged jump back of 5 s also starts a new epoch
+    XCTAssertEqual([timeline timelineValueForTimestamp:90000 * 3595 isDiscontinuous:YES], (int64_t)102000);
+    XCTAssertEqual(timeline.discontinuityCount, (NSUInteger)2);
+}
+
+- (void)test_pcr_anchorsTimelineAndSplicesDiscontinuity {
+    TSProgramTimeline *timeline = [TSProgramTimeline new];
+    [timeline addPcrBase:kWrap - 90000 isDiscontinuous:NO];
+    [timeline addPcrBase:kWrap - 86400 isDiscontinuous:NO];
+    XCTAssertTrue(timeline.hasPcr);
+    // 1 s ahead of the PCR, after the wrap
+    XCTAssertEqual([timeline timelineValueForTimestamp:3600 isDiscontinuous:NO], kWrap + 3600);
+
+    [timeline addPcrBase:3600 isDiscontinuous:NO];
+    XCTAssertEqual([timeline timelineValueForTimestamp:7200 isDiscontinuous:NO], kWrap + 7200);
+
+    // Splice: the encoder restarts elsewhere, one PCR interval (1 s here) after the last PCR
+    const int64_t restart = 90000 * 1000;
+    [timeline addPcrBase:restart isDiscontinuous:YES];
+    XCTAssertEqual(timeline.discontinuityCount, (NSUInteger)1);
+    const int64_t epoch = kWrap + 3600 + 90000;
+    XCTAssertEqual([timeline timelineValueForTimestamp:restart + 45000 isDiscontinuous:NO], epoch + 45000);
+    // An access unit sent before the splice stays on the previous epoch
+    XCTAssertEqual([timeline timelineValueForTimestamp:10800 isDiscontinuous:NO], kWrap + 10800);
+
+    // A PCR jump without the indicator is a discontinuity too
+    [timeline addPcrBase:restart + 90000 * 600 isDiscontinuous:NO];
+    XCTAssertEqual(timeline.discontinuityCount, (NSUInteger)2);
+}
+
+- (void)test_demuxer_deliversContinuousTimestampsPerProgram {
+    TSProgramTimelineTestDelegate *delegate = [[TSProgramTimelineTestDelegate alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    TSElementaryStream *video = [[TSElementaryStream alloc] initWithPid:kTestVideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    TSElementaryStream *audio = [[TSElementaryStream alloc] initWithPid:kTestAudioPid streamType:kRawStreamTypeADTSAAC descriptors:nil];
+
+    NSMutableData *psi = [NSMutableData data];
+    [psi appendData:[TSTestUtils createPatDataWithPmtPid:kTestPmtPid]];
+    [psi appendData:[TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                                  pcrPid:kTestPcrPid
+                                                 streams:@[video, audio]
+                                           versionNumber:0
+                                       continuityCounter:0]];
+    [demuxer demux:psi dataArrivalHostTimeNanos:0];
+    TSProgramTimeline *timeline = [demuxer timelineForProgram:1];
+    XCTAssertNotNil(timeline);
+
+    [demuxer demux:[TSPacket pcrPacketDataWithPid:kTestPcrPid continuityCounter:0 pcrBase:kWrap - 9000 pcrExt:0] dataArrivalHostTimeNanos:0];
+    XCTAssertTrue(timeline.hasPcr);
+
+    NSData *payload = [NSMutableData dataWithLength:100];
+    const int64_t videoPts[] = { kWrap - 3600, 0, 3600, 7200 };
+    const int64_t audioPts[] = { kWrap - 1920, 1920, 5760 };
+    for (int i = 0; i < 4; i++) {
+        [demuxer demux:[TSTestUtils createPesDataWithTrack:video payload:payload pts:CMTimeMake(videoPts[i], 90000)] dataArrivalHostTimeNanos:0];
+        if (i < 3) {
+            [demuxer demux:[TSTestUtils createPesDataWithTrack:audio payload:payload pts:CMTimeMake(audioPts[i], 90000)] dataArrivalHostTimeNanos:0];
+        }
+    }
+
+    NSMutableArray<NSNumber *> *videoTimeline = [NSMutableArray array];
+    NSMutableArray<NSNumber *> *audioTimeline = [NSMutableArray array];
+    for (TSAccessUnit *au in delegate.receivedAccessUnits) {
+        XCTAssertEqual(au.timelinePts.timescale, (int32_t)90000);
+        XCTAssertFalse(CMTIME_IS_VALID(au.timelineDts));
+        [(au.pid == kTestVideoPid ? videoTimeline : audioTimeline) addObject:@(au.timelinePts.value)];
+    }
+    // The last access unit of each stream is still being collected
+    XCTAssertEqualObjects(videoTimeline, (@[@(kWrap - 3600), @(kWrap), @(kWrap + 3600)]));
+    XCTAssertEqualObjects(audioTimeline, (@[@(kWrap - 1920), @(kWrap + 1920)]));
+    // The raw PTS still wraps
+    XCTAssertEqual(delegate.receivedAccessUnits.lastObject.pid, kTestVideoPid);
+    XCTAssertEqual(delegate.receivedAccessUnits.lastObject.pts.value, (int64_t)3600);
+}
+
+@end
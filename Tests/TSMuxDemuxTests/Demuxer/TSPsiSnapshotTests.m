@@ -0,0 +1,188 @@
+//
+//  TSPsiSnapshotTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for exporting the PSI state of a demuxer and warm starting another one from it.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kTestPmtPid = 0x100;
+static const uint16_t kTestVideoPid = 0x101;
+static const uint16_t kTestAudioPid = 0x102;
+
+#pragma mark - Test Delegate
+
+@interface TSPsiSnapshotTestDelegate : NSObject <TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSProgramAssociationTable *> *receivedPats;
+@property (nonatomic, strong) NSMutableArray<TSProgramMapTable *> *receivedPmts;
+@property (nonatomic, strong) NSMutableArray<TSProgramMapTable *> *previousPmts;
+@property (nonatomic, strong) NSMutableArray<TSDvbServiceDescriptionTable *> *receivedSdts;
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@end
+
+@implementation TSPsiSnapshotTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedPats = [NSMutableArray array];
+        _receivedPmts = [NSMutableArray array];
+        _previousPmts = [NSMutableArray array];
+        _receivedSdts = [NSMutableArray array];
+        _receivedAccessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {
+    [self.receivedPats addObject:pat];
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {
+    [self.receivedPmts addObject:pmt];
+    if (previousPmt) {
+        [self.previousPmts addObject:previousPmt];
+    }
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveSdt:(TSDvbServiceDescriptionTable *)sdt previousSdt:(TSDvbServiceDescriptionTable *)previousSdt {
+    [self.receivedSdts addObject:sdt];
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSPsiSnapshotTests : XCTestCase
+@property (nonatomic, strong) TSElementaryStream *video;
+@property (nonatomic, strong) TSElementaryStream *audio;
+@end
+
+@implementation TSPsiSnapshotTests
+
+- (void)setUp {
+    [super setUp];
+    self.video = [[TSElementaryStream alloc] initWithPid:kTestVideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    self.audio = [[TSElementaryStream alloc] initWithPid:kTestAudioPid streamType:kRawStreamTypeADTSAAC descriptors:nil];
+}
+
+- (NSData *)psiData {
+    NSMutableData *psi = [NSMutableData data];
+    [psi appendData:[TSTestUtils createPatDataWithPmtPid:kTestPmtPid]];
+    [psi appendData:[TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                                  pcrPid:kTestVideoPid
+                                                 streams:@[self.video, self.audio]
+                                           versionNumber:0
+                                       continuityCounter:0]];
+    [psi appendData:[TSTestUtils createSdtDataWithTransportStreamId:1
+                                                  originalNetworkId:2
+                                                          serviceId:1
+                                                      versionNumber:0
+                                                  continuityCounter:0]];
+    return psi;
+}
+
+- (NSData *)videoData {
+    NSMutableData *payload = [NSMutableData dataWithLength:100];
+    NSMutableData *pes = [NSMutableData data];
+    [pes appendData:[TSTestUtils createPesDataWithTrack:self.video payload:payload pts:CMTimeMake(3600, 90000)]];
+    [pes appendData:[TSTestUtils createPesDataWithTrack:self.video payload:payload pts:CMTimeMake(7200, 90000)]];
+    return pes;
+}
+
+- (TSDemuxer *)demuxerWithPsi {
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    demuxer.nalIndexingPids = [NSSet setWithObject:@(kTestVideoPid)];
+    demuxer.maxBufferedBytesPerPid = 1 << 20;
+    demuxer.overflowPolicy = TSAssemblyOverflowPolicyDrop;
+    demuxer.clockRecoveryWindowSize = 64;
+    [demuxer demux:[self psiData] dataArrivalHostTimeNanos:0];
+    return demuxer;
+}
+
+- (void)test_restore_armsStreamBuildersFromFirstPacket {
+    NSData *snapshot = [[self demuxerWithPsi] psiSnapshot];
+
+    TSPsiSnapshotTestDelegate *delegate = [[TSPsiSnapshotTestDelegate alloc] init];
+    TSDemuxer *warm = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    XCTAssertTrue([warm restorePsiSnapshot:snapshot]);
+
+    XCTAssertEqual(delegate.receivedPats.count, (NSUInteger)1);
+    XCTAssertEqual(delegate.receivedPmts.count, (NSUInteger)1);
+    XCTAssertEqual(delegate.receivedSdts.count, (NSUInteger)1);
+    XCTAssertEqualObjects(warm.pat.programmes, (@{ @1: @(kTestPmtPid) }));
+    XCTAssertNotNil([warm.pmts[@1] elementaryStreamWithPid:kTestAudioPid]);
+    XCTAssertEqual(warm.dvb.sdt.originalNetworkId, (uint16_t)2);
+
+    // Configuration
+    XCTAssertEqualObjects(warm.nalIndexingPids, [NSSet setWithObject:@(kTestVideoPid)]);
+    XCTAssertNil(warm.esPidFilter);
+    XCTAssertEqual(warm.maxBufferedBytesPerPid, (NSUInteger)(1 << 20));
+    XCTAssertEqual(warm.overflowPolicy, TSAssemblyOverflowPolicyDrop);
+    XCTAssertEqual(warm.clockRecoveryWindowSize, (NSUInteger)64);
+
+    // Access units without waiting for the PSI (the second one is still being collected)
+    [warm demux:[self videoData] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(delegate.receivedAccessUnits.count, (NSUInteger)1);
+    XCTAssertEqual(delegate.receivedAccessUnits.firstObject.pts.value, (int64_t)3600);
+
+    // A cold demuxer discards them
+    TSPsiSnapshotTestDelegate *coldDelegate = [[TSPsiSnapshotTestDelegate alloc] init];
+    TSDemuxer *cold = [[TSDemuxer alloc] initWithDelegate:coldDelegate mode:TSDemuxerModeDVB];
+    [cold demux:[self videoData] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(coldDelegate.receivedAccessUnits.count, (NSUInteger)0);
+}
+
+- (void)test_restore_livePsiConfirmsOrReplacesTables {
+    TSPsiSnapshotTestDelegate *delegate = [[TSPsiSnapshotTestDelegate alloc] init];
+    TSDemuxer *warm = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    XCTAssertTrue([warm restorePsiSnapshot:[[self demuxerWithPsi] psiSnapshot]]);
+
+    // Identical live tables: no callbacks
+    [warm demux:[self psiData] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(delegate.receivedPats.count, (NSUInteger)1);
+    XCTAssertEqual(delegate.receivedPmts.count, (NSUInteger)1);
+    XCTAssertEqual(delegate.receivedSdts.count, (NSUInteger)1);
+
+    // A new version replaces the cached PMT
+    [warm demux:[TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                              pcrPid:kTestVideoPid
+                                             streams:@[self.video]
+                                       versionNumber:1
+                                   continuityCounter:1] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(delegate.receivedPmts.count, (NSUInteger)2);
+    XCTAssertEqual(delegate.previousPmts.count, (NSUInteger)1);
+    XCTAssertNotNil([delegate.previousPmts.firstObject elementaryStreamWithPid:kTestAudioPid]);
+    XCTAssertNil([warm.pmts[@1] elementaryStreamWithPid:kTestAudioPid]);
+}
+
+- (void)test_restore_rejectsMalformedOrOtherModeSnapshots {
+    NSData *snapshot = [[self demuxerWithPsi] psiSnapshot];
+
+    TSDemuxer *atsc = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeATSC];
+    XCTAssertFalse([atsc restorePsiSnapshot:snapshot]);
+    XCTAssertNil(atsc.pat);
+
+    TSDemuxer *dvb = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    XCTAssertFalse([dvb restorePsiSnapshot:[snapshot subdataWithRange:NSMakeRange(0, snapshot.length - 1)]]);
+    XCTAssertFalse([dvb restorePsiSnapshot:[NSData data]]);
+    XCTAssertNil(dvb.pat);
+    XCTAssertNil(dvb.nalIndexingPids);
+    XCTAssertEqual(dvb.pmts.count, (NSUInteger)0);
+}
+
+- (void)test_snapshot_roundTripsUnchanged {
+    NSData *snapshot = [[self demuxerWithPsi] psiSnapshot];
+    TSDemuxer *warm = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    XCTAssertTrue([warm restorePsiSnapshot:snapshot]);
+    XCTAssertEqualObjects([warm psiSnapshot], snapshot);
+}
+
+@end
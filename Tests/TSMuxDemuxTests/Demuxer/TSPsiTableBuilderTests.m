@@ -865,4 +865,25 @@
     XCTAssertEqual(self.receivedTables[0].versionNumber, 2, @"Should be the new version");
 }
 
+- (void)test_tdt_hasNoCrc_deliversAllUtcTimeBytes {
+    TSPsiTableBuilder *builder = [[TSPsiTableBuilder alloc] initWithDelegate:self pid:PID_DVB_TDT_TOT_ST];
+    builder.aggregatesSections = NO;
+
+    // Two TDTs back to back: the second only parses if the first consumed no CRC bytes
+    const uint8_t sections[] = {
+        0x00,                                       // pointer_field
+        0x70, 0x70, 0x05, 0xE8, 0xD1, 0x12, 0x34, 0x56,
+        0x70, 0x70, 0x05, 0xE8, 0xD1, 0x12, 0x34, 0x57,
+    };
+    NSData *payload = [NSData dataWithBytes:sections length:sizeof(sections)];
+    NSData *packetData = [TSTestUtils createRawPacketDataWithPid:PID_DVB_TDT_TOT_ST payload:payload pusi:YES continuityCounter:0];
+    [builder addTsPacket:[TSPacket packetsFromChunkedTsData:packetData packetSize:TS_PACKET_SIZE_188].firstObject];
+
+    XCTAssertEqual(self.receivedTables.count, 2);
+    const uint8_t expected[] = { 0xE8, 0xD1, 0x12, 0x34, 0x56 };
+    XCTAssertEqualObjects(self.receivedTables[0].sectionDataExcludingCrc, [NSData dataWithBytes:expected length:sizeof(expected)]);
+    XCTAssertEqual(self.receivedTables[0].crc, (uint32_t)0);
+    XCTAssertEqual(((const uint8_t *)self.receivedTables[1].sectionDataExcludingCrc.bytes)[4], 0x57);
+}
+
 @end
@@ -0,0 +1,203 @@
+//
+//  TSRandomAccessIndexTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for the random access index builder and seek support.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kTestPmtPid = 0x100;
+static const uint16_t kTestVideoPid = 0x101;
+
+#pragma mark - Test Delegate
+
+@interface TSRandomAccessIndexTestDelegate : NSObject <TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@end
+
+@implementation TSRandomAccessIndexTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedAccessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSRandomAccessIndexTests : XCTestCase
+@property (nonatomic, strong) NSMutableData *stream;
+@property (nonatomic, strong) NSMutableArray<NSNumber *> *idrOffsets;
+@end
+
+@implementation TSRandomAccessIndexTests
+
+- (NSData *)frameWithNalType:(uint8_t)nalType size:(NSUInteger)size {
+    NSMutableData *frame = [NSMutableData dataWithLength:size];
+    memset(frame.mutableBytes, 0xAB, size);
+    uint8_t header[] = {0x00, 0x00, 0x00, 0x01, 0x09, 0xF0, 0x00, 0x00, 0x00, 0x01, nalType};
+    memcpy(frame.mutableBytes, header, sizeof(header));
+    return frame;
+}
+
+- (void)setUp {
+    [super setUp];
+    self.stream = [NSMutableData data];
+    self.idrOffsets = [NSMutableArray array];
+
+    TSElementaryStream *video = [[TSElementaryStream alloc] initWithPid:kTestVideoPid
+                                                             streamType:kRawStreamTypeH264
+                                                            descriptors:nil];
+    NSData *pat = [TSTestUtils createPatDataWithPmtPid:kTestPmtPid];
+    NSData *pmt = [TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                                pcrPid:kTestVideoPid
+                                   elementaryStreamPid:kTestVideoPid
+                                            streamType:kRawStreamTypeH264];
+
+    // Three GOPs of IDR + 2 P-frames at 25 fps, with PSI repeated before each GOP.
+    int64_t pts = 90000;
+    for (int gop = 0; gop < 3; gop++) {
+        [self.stream appendData:pat];
+        [self.stream appendData:pmt];
+        for (int frame = 0; frame < 3; frame++) {
+            if (frame == 0) {
+                [self.idrOffsets addObject:@(self.stream.length)];
+            }
+            NSData *payload = [self frameWithNalType:(frame == 0 ? 0x65 : 0x41) size:600];
+            [self.stream appendData:[TSTestUtils createPesDataWithTrack:video
+                                                                payload:payload
+                                                                    pts:CMTimeMake(pts, 90000)]];
+            pts += 3600;
+        }
+    }
+}
+
+- (TSRandomAccessIndex *)buildIndex {
+    TSRandomAccessIndexBuilder *builder = [[TSRandomAccessIndexBuilder alloc] initWithMode:TSDemuxerModeDVB];
+    builder.pcrSampleIntervalMs = 0;
+    [builder addData:self.stream];
+    return [TSRandomAccessIndex indexWithData:[builder finish]];
+}
+
+- (void)test_index_recordsKeyframesWithoutRai {
+    TSRandomAccessIndex *index = [self buildIndex];
+    XCTAssertNotNil(index);
+    XCTAssertEqual(index.packetSize, (NSUInteger)TS_PACKET_SIZE_188);
+    XCTAssertEqual(index.indexedLength, (uint64_t)self.stream.length);
+
+    XCTAssertEqual([index rapCountForPid:kTestVideoPid], (NSUInteger)3, @"Only IDR frames are random access points");
+    const TSRandomAccessIndexRapEntry *raps = [index rapEntriesForPid:kTestVideoPid];
+    for (NSUInteger i = 0; i < 3; i++) {
+        XCTAssertEqual(raps[i].offset, self.idrOffsets[i].unsignedLongLongValue);
+        XCTAssertEqual(raps[i].pts, (uint64_t)(90000 + i * 3 * 3600));
+        XCTAssertTrue(raps[i].flags & TSRandomAccessPointFlagKeyframe);
+    }
+}
+
+- (void)test_index_psiVersionsRecordedOnce {
+    TSRandomAccessIndex *index = [self buildIndex];
+
+    // Repeated identical PAT/PMT are not new versions
+    XCTAssertEqual(index.psiCount, (NSUInteger)2);
+    XCTAssertEqual(index.psiEntries[0].pid, 0);
+    XCTAssertEqual(index.psiEntries[0].offset, (uint64_t)0);
+    XCTAssertEqual(index.psiEntries[1].pid, kTestPmtPid);
+    XCTAssertEqual(index.psiEntries[1].programNumber, 1);
+}
+
+- (void)test_index_roundTripsThroughFile {
+    TSRandomAccessIndexBuilder *builder = [[TSRandomAccessIndexBuilder alloc] initWithMode:TSDemuxerModeDVB];
+    [builder addData:self.stream];
+    NSData *indexData = [builder finish];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    XCTAssertTrue([indexData writeToFile:path atomically:YES]);
+    TSRandomAccessIndex *index = [TSRandomAccessIndex indexWithContentsOfFile:path];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+
+    XCTAssertNotNil(index);
+    XCTAssertEqual([index rapCountForPid:kTestVideoPid], (NSUInteger)3);
+}
+
+- (void)test_index_rejectsGarbage {
+    NSMutableData *garbage = [NSMutableData dataWithLength:64];
+    XCTAssertNil([TSRandomAccessIndex indexWithData:garbage]);
+}
+
+- (void)test_index_rejectsOtherByteOrder {
+    TSRandomAccessIndexBuilder *builder = [[TSRandomAccessIndexBuilder alloc] initWithMode:TSDemuxerModeDVB];
+    [builder addData:self.stream];
+    NSMutableData *indexData = [[builder finish] mutableCopy];
+    TSRandomAccessIndexHeader *header = indexData.mutableBytes;
+    XCTAssertEqual(header->byteOrderMark, TS_RANDOM_ACCESS_INDEX_BYTE_ORDER_MARK);
+
+    header->byteOrderMark = CFSwapInt32(header->byteOrderMark);
+    XCTAssertNil([TSRandomAccessIndex indexWithData:indexData]);
+}
+
+- (void)test_index_m2tsOffsetsIncludeArrivalTimestamps {
+    NSMutableData *m2ts = [NSMutableData data];
+    for (NSUInteger offset = 0; offset < self.stream.length; offset += TS_PACKET_SIZE_188) {
+        const uint32_t arrivalTimestamp = CFSwapInt32HostToBig((uint32_t)offset);
+        [m2ts appendBytes:&arrivalTimestamp length:sizeof(arrivalTimestamp)];
+        [m2ts appendBytes:(const uint8_t *)self.stream.bytes + offset length:TS_PACKET_SIZE_188];
+    }
+    TSRandomAccessIndexBuilder *builder = [[TSRandomAccessIndexBuilder alloc] initWithMode:TSDemuxerModeDVB];
+    [builder addData:m2ts];
+    TSRandomAccessIndex *index = [TSRandomAccessIndex indexWithData:[builder finish]];
+
+    XCTAssertEqual(index.packetSize, (NSUInteger)TS_PACKET_SIZE_192);
+    XCTAssertEqual(index.psiCount, (NSUInteger)2);
+    XCTAssertEqual([index rapCountForPid:kTestVideoPid], (NSUInteger)3);
+    const TSRandomAccessIndexRapEntry *raps = [index rapEntriesForPid:kTestVideoPid];
+    for (NSUInteger i = 0; i < 3; i++) {
+        XCTAssertEqual(raps[i].offset, self.idrOffsets[i].unsignedLongLongValue / TS_PACKET_SIZE_188 * TS_PACKET_SIZE_192);
+    }
+
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    const NSUInteger offset = [index seekDemuxer:demuxer fromData:m2ts pid:kTestVideoPid pts:90000 + 4 * 3600];
+    XCTAssertEqual(offset, (NSUInteger)raps[1].offset);
+    XCTAssertEqual(demuxer.pmts.count, (NSUInteger)1, @"PSI should be found behind the arrival time stamps");
+}
+
+- (void)test_seek_startsAtKeyframeWithWarmPsi {
+    TSRandomAccessIndex *index = [self buildIndex];
+
+    TSRandomAccessIndexTestDelegate *delegate = [[TSRandomAccessIndexTestDelegate alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+
+    // Seek to a P-frame in the second GOP - should land on the second IDR
+    const uint64_t targetPts = 90000 + 4 * 3600;
+    NSUInteger offset = [index seekDemuxer:demuxer fromData:self.stream pid:kTestVideoPid pts:targetPts];
+    XCTAssertEqual(offset, self.idrOffsets[1].unsignedIntegerValue);
+    XCTAssertNotNil(demuxer.pat, @"PAT should be restored before demuxing from the seek point");
+    XCTAssertEqual(demuxer.pmts.count, (NSUInteger)1);
+
+    NSData *remainder = [self.stream subdataWithRange:NSMakeRange(offset, self.stream.length - offset)];
+    [demuxer demux:remainder dataArrivalHostTimeNanos:0];
+
+    XCTAssertGreaterThan(delegate.receivedAccessUnits.count, (NSUInteger)0);
+    XCTAssertEqual(delegate.receivedAccessUnits.firstObject.pts.value, (int64_t)(90000 + 3 * 3600));
+}
+
+- (void)test_seek_unknownPid_notFound {
+    TSRandomAccessIndex *index = [self buildIndex];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    XCTAssertEqual([index seekDemuxer:demuxer fromData:self.stream pid:0x1234 pts:0], NSNotFound);
+}
+
+@end
@@ -0,0 +1,166 @@
+//
+//  TSReedSolomonTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for RS(204,188) error correction of 204-byte packets.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kTestPmtPid = 0x100;
+static const uint16_t kTestVideoPid = 0x101;
+
+#pragma mark - Test Delegate
+
+@interface TSReedSolomonTestDelegate : NSObject <TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@end
+
+@implementation TSReedSolomonTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedAccessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSReedSolomonTests : XCTestCase
+@end
+
+@implementation TSReedSolomonTests
+
+/// 204-byte packets with parity, from 188-byte packets.
+- (NSMutableData *)btsDataFromTsData:(NSData *)tsData {
+    NSMutableData *bts = [NSMutableData data];
+    for (NSUInteger offset = 0; offset < tsData.length; offset += TS_PACKET_SIZE_188) {
+        uint8_t packet[204] = { 0 };
+        memcpy(packet, (const uint8_t *)tsData.bytes + offset, TS_PACKET_SIZE_188);
+        TSReedSolomonEncode204(packet);
+        [bts appendBytes:packet length:sizeof(packet)];
+    }
+    return bts;
+}
+
+- (void)makePacket:(uint8_t *)packet {
+    packet[0] = TS_PACKET_HEADER_SYNC_BYTE;
+    packet[1] = 0x01;
+    packet[2] = 0x00;
+    packet[3] = 0x10;
+    for (NSUInteger k = 4; k < 188; k++) {
+        packet[k] = (uint8_t)(k * 7 + 3);
+    }
+    TSReedSolomonEncode204(packet);
+}
+
+- (void)test_decode_errorFreePacket {
+    uint8_t packet[204];
+    [self makePacket:packet];
+    XCTAssertFalse(TSReedSolomonHasErrors204(packet));
+    NSUInteger corrected = 99;
+    XCTAssertEqual(TSReedSolomonDecode204(packet, &corrected), TSReedSolomonResultNoErrors);
+    XCTAssertEqual(corrected, (NSUInteger)0);
+}
+
+- (void)test_decode_correctsUpToEightBytes {
+    uint8_t original[204];
+    [self makePacket:original];
+
+    // Header, payload and parity bytes
+    const NSUInteger positions[] = { 0, 1, 2, 50, 120, 187, 188, 203 };
+    for (NSUInteger count = 1; count <= 8; count++) {
+        uint8_t packet[204];
+        memcpy(packet, original, sizeof(packet));
+        for (NSUInteger i = 0; i < count; i++) {
+            packet[positions[i]] ^= (uint8_t)(0x11 * (i + 1));
+        }
+        XCTAssertTrue(TSReedSolomonHasErrors204(packet));
+        NSUInteger corrected = 0;
+        XCTAssertEqual(TSReedSolomonDecode204(packet, &corrected), TSReedSolomonResultCorrected);
+        XCTAssertEqual(corrected, count);
+        XCTAssertEqual(memcmp(packet, original, sizeof(packet)), 0);
+    }
+}
+
+- (void)test_decode_reportsUncorrectableAndLeavesPacket {
+    uint8_t packet[204];
+    [self makePacket:packet];
+    for (NSUInteger i = 0; i < 12; i++) {
+        packet[i * 17] ^= 0x5A;
+    }
+    uint8_t corrupted[204];
+    memcpy(corrupted, packet, sizeof(packet));
+
+    XCTAssertEqual(TSReedSolomonDecode204(packet, NULL), TSReedSolomonResultUncorrectable);
+    XCTAssertEqual(memcmp(packet, corrupted, sizeof(packet)), 0);
+}
+
+- (void)test_demuxer_correctsPacketsAndCountsStatistics {
+    TSElementaryStream *video = [[TSElementaryStream alloc] initWithPid:kTestVideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    NSMutableData *payload = [NSMutableData dataWithLength:100];
+    memset(payload.mutableBytes, 0xAB, payload.length);
+
+    NSMutableData *ts = [NSMutableData data];
+    [ts appendData:[TSTestUtils createPatDataWithPmtPid:kTestPmtPid]];
+    [ts appendData:[TSTestUtils createPmtDataWithPmtPid:kTestPmtPid pcrPid:kTestVideoPid elementaryStreamPid:kTestVideoPid streamType:kRawStreamTypeH264]];
+    [ts appendData:[TSTestUtils createPesDataWithTrack:video payload:payload pts:CMTimeMake(3600, 90000)]];
+    [ts appendData:[TSTestUtils createPesDataWithTrack:video payload:payload pts:CMTimeMake(7200, 90000)]];
+    [ts appendData:[TSTestUtils createPesDataWithTrack:video payload:payload pts:CMTimeMake(10800, 90000)]];
+    NSMutableData *bts = [self btsDataFromTsData:ts];
+    XCTAssertEqual(bts.length, (NSUInteger)(5 * TS_PACKET_SIZE_204));
+
+    uint8_t *bytes = bts.mutableBytes;
+    // PAT: the PID
+    bytes[2] ^= 0x40;
+    // First PES: header and payload
+    bytes[2 * 204 + 3] ^= 0xFF;
+    bytes[2 * 204 + 100] ^= 0x01;
+    bytes[2 * 204 + 150] ^= 0x80;
+    // Third PES: beyond repair
+    for (NSUInteger i = 0; i < 20; i++) {
+        bytes[4 * 204 + 10 + i] ^= 0xFF;
+    }
+
+    TSReedSolomonTestDelegate *delegate = [[TSReedSolomonTestDelegate alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    demuxer.reedSolomonCorrection = YES;
+    [demuxer demux:bts dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(demuxer.packetSize, (NSUInteger)TS_PACKET_SIZE_204);
+    XCTAssertNotNil(demuxer.pat);
+    XCTAssertEqual(demuxer.statistics.rsCorrectedPackets, (uint64_t)2);
+    XCTAssertEqual(demuxer.statistics.rsCorrectedBytes, (uint64_t)4);
+    XCTAssertEqual(demuxer.statistics.rsUncorrectablePackets, (uint64_t)1);
+
+    // The corrected access unit is intact (the second is still being collected)
+    XCTAssertEqual(delegate.receivedAccessUnits.count, (NSUInteger)1);
+    TSAccessUnit *first = delegate.receivedAccessUnits.firstObject;
+    XCTAssertEqual(first.pts.value, (int64_t)3600);
+    XCTAssertEqualObjects(first.compressedData, payload);
+}
+
+- (void)test_demuxer_ignoresParityByDefault {
+    NSMutableData *bts = [self btsDataFromTsData:[TSTestUtils createPatDataWithPmtPid:kTestPmtPid]];
+    ((uint8_t *)bts.mutableBytes)[2] ^= 0x40;
+
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    [demuxer demux:bts dataArrivalHostTimeNanos:0];
+    XCTAssertNil(demuxer.pat);
+    XCTAssertEqual(demuxer.statistics.rsCorrectedPackets, (uint64_t)0);
+}
+
+@end
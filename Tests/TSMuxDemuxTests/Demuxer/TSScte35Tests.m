@@ -0,0 +1,274 @@
+//
+//  TSScte35Tests.m
+//  TSMuxDemuxTests
+//
+//  Tests for demuxing SCTE-35 splice_info_sections: splice_insert, time_signal and segmentation descriptors.
+//
+
+#import <XCTest/XCTest.h>
+#import "../TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kTestPmtPid = 0x100;
+static const uint16_t kTestVideoPid = 0x101;
+static const uint16_t kTestCuePid = 0x1F0;
+static const int64_t kWrap = 1LL << 33;
+
+#pragma mark - Test Delegate
+
+@interface TSScte35TestDelegate : NSObject <TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableArray<TSScte35SpliceInfoSection *> *receivedSpliceInfos;
+@property (nonatomic, strong) NSMutableArray<NSNumber *> *receivedPids;
+@property (nonatomic, strong) NSMutableArray<NSNumber *> *receivedProgramNumbers;
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@end
+
+@implementation TSScte35TestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _receivedSpliceInfos = [NSMutableArray array];
+        _receivedPids = [NSMutableArray array];
+        _receivedProgramNumbers = [NSMutableArray array];
+        _receivedAccessUnits = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveSpliceInfo:(TSScte35SpliceInfoSection *)spliceInfo
+            pid:(uint16_t)pid
+  programNumber:(uint16_t)programNumber {
+    [self.receivedSpliceInfos addObject:spliceInfo];
+    [self.receivedPids addObject:@(pid)];
+    [self.receivedProgramNumbers addObject:@(programNumber)];
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSScte35Tests : XCTestCase
+@property (nonatomic, strong) TSScte35TestDelegate *delegate;
+@property (nonatomic, strong) TSDemuxer *demuxer;
+@property (nonatomic) uint8_t cueCc;
+@end
+
+@implementation TSScte35Tests
+
+- (void)setUp {
+    [super setUp];
+    self.delegate = [[TSScte35TestDelegate alloc] init];
+    self.demuxer = [[TSDemuxer alloc] initWithDelegate:self.delegate mode:TSDemuxerModeDVB];
+    self.cueCc = 0;
+}
+
+#pragma mark - Helpers
+
+- (NSData *)psiData {
+    TSElementaryStream *video = [[TSElementaryStream alloc] initWithPid:kTestVideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    TSElementaryStream *cue = [[TSElementaryStream alloc] initWithPid:kTestCuePid streamType:0x86 descriptors:nil];
+    NSMutableData *psi = [NSMutableData data];
+    [psi appendData:[TSTestUtils createPatDataWithPmtPid:kTestPmtPid]];
+    [psi appendData:[TSTestUtils createPmtDataWithPmtPid:kTestPmtPid
+                                                  pcrPid:kTestVideoPid
+                                                 streams:@[video, cue]
+                                           versionNumber:0
+                                       continuityCounter:0]];
+    return psi;
+}
+
+/// A 33-bit field preceded by the 7 bits of `prefix` (splice_time, break_duration).
+static void appendTimestamp(NSMutableData *data, uint8_t prefix, uint64_t timestamp) {
+    const uint8_t bytes[] = {
+        prefix | ((timestamp >> 32) & 0x01),
+        (timestamp >> 24) & 0xFF, (timestamp >> 16) & 0xFF, (timestamp >> 8) & 0xFF, timestamp & 0xFF
+    };
+    [data appendBytes:bytes length:sizeof(bytes)];
+}
+
+/// splice_info_section with a dummy CRC.
+- (NSData *)sectionWithPtsAdjustment:(uint64_t)ptsAdjustment
+                         commandType:(uint8_t)commandType
+                             command:(NSData *)command
+                         descriptors:(NSData *)descriptors {
+    NSMutableData *body = [NSMutableData data];
+    const uint8_t protocolVersion = 0;
+    [body appendBytes:&protocolVersion length:1];
+    appendTimestamp(body, 0x00, ptsAdjustment);  // not encrypted
+    const uint8_t commandHeader[] = {
+        0xFF,                                               // cw_index
+        0xFF, 0xF0 | (command.length >> 8), command.length & 0xFF,  // tier, splice_command_length
+        commandType
+    };
+    [body appendBytes:commandHeader length:sizeof(commandHeader)];
+    [body appendData:command];
+    const uint8_t loopLength[] = { descriptors.length >> 8, descriptors.length & 0xFF };
+    [body appendBytes:loopLength length:sizeof(loopLength)];
+    [body appendData:descriptors];
+
+    const uint16_t sectionLength = (uint16_t)(body.length + 4);
+    const uint8_t header[] = { 0xFC, 0x30 | (sectionLength >> 8), sectionLength & 0xFF };
+    NSMutableData *section = [NSMutableData dataWithBytes:header length:sizeof(header)];
+    [section appendData:body];
+    const uint8_t crc[4] = { 0 };
+    [section appendBytes:crc length:sizeof(crc)];
+    return section;
+}
+
+- (NSData *)cuePacketWithSection:(NSData *)section {
+    NSMutableData *payload = [NSMutableData dataWithLength:1];  // pointer_field = 0
+    [payload appendData:section];
+    return [TSTestUtils createRawPacketDataWithPid:kTestCuePid payload:payload pusi:YES continuityCounter:self.cueCc++];
+}
+
+/// Out of network, program splice at `ptsTime`, with a 30 s auto-return break.
+- (NSData *)spliceInsertWithEventId:(uint32_t)eventId ptsTime:(uint64_t)ptsTime {
+    NSMutableData *command = [NSMutableData data];
+    const uint8_t header[] = {
+        eventId >> 24, (eventId >> 16) & 0xFF, (eventId >> 8) & 0xFF, eventId & 0xFF,
+        0x7F,   // not cancelled
+        0xEF    // out_of_network, program_splice, duration, not immediate
+    };
+    [command appendBytes:header length:sizeof(header)];
+    appendTimestamp(command, 0xFE, ptsTime);
+    appendTimestamp(command, 0xFE, 30 * 90000);
+    const uint8_t trailer[] = { 0x12, 0x34, 0x01, 0x02 };  // unique_program_id, avail 1 of 2
+    [command appendBytes:trailer length:sizeof(trailer)];
+    return command;
+}
+
+#pragma mark - Tests
+
+- (void)test_spliceInsert_deliveredOnCompletionWithAdjustedUnwrappedTime {
+    [self.demuxer demux:[self psiData] dataArrivalHostTimeNanos:0];
+    [self.demuxer demux:[TSPacket pcrPacketDataWithPid:kTestVideoPid continuityCounter:0 pcrBase:kWrap - 90000 pcrExt:0] dataArrivalHostTimeNanos:0];
+
+    // Splice 2 s ahead of the PCR, i.e. after the wrap: 3 s + (2^33 - 1 s)
+    [self.demuxer demux:[self cuePacketWithSection:[self sectionWithPtsAdjustment:kWrap - 90000
+                                                                      commandType:TSScte35SpliceCommandTypeSpliceInsert
+                                                                          command:[self spliceInsertWithEventId:42 ptsTime:3 * 90000]
+                                                                      descriptors:[NSData data]]] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(self.delegate.receivedSpliceInfos.count, (NSUInteger)1);
+    XCTAssertEqualObjects(self.delegate.receivedPids.firstObject, @(kTestCuePid));
+    XCTAssertEqualObjects(self.delegate.receivedProgramNumbers.firstObject, @1);
+    TSScte35SpliceInfoSection *cue = self.delegate.receivedSpliceInfos.firstObject;
+    XCTAssertEqual(cue.spliceCommandType, TSScte35SpliceCommandTypeSpliceInsert);
+    XCTAssertEqual(cue.ptsAdjustment, (uint64_t)(kWrap - 90000));
+    XCTAssertEqual(cue.spliceTime.value, (int64_t)(2 * 90000));
+    XCTAssertEqual(cue.timelineSpliceTime.value, kWrap + 2 * 90000);
+    XCTAssertEqual(cue.timelineSpliceTime.timescale, (int32_t)90000);
+
+    TSScte35SpliceInsert *insert = cue.spliceInsert;
+    XCTAssertEqual(insert.spliceEventId, (uint32_t)42);
+    XCTAssertFalse(insert.isCancel);
+    XCTAssertTrue(insert.isOutOfNetwork);
+    XCTAssertTrue(insert.isProgramSplice);
+    XCTAssertFalse(insert.isSpliceImmediate);
+    XCTAssertTrue(insert.isAutoReturn);
+    XCTAssertEqual(insert.breakDuration.value, (int64_t)(30 * 90000));
+    XCTAssertEqual(insert.uniqueProgramId, (uint16_t)0x1234);
+    XCTAssertEqual(insert.availNum, (uint8_t)1);
+    XCTAssertEqual(insert.availsExpected, (uint8_t)2);
+
+    // Sections, not access units; each repeat is delivered
+    [self.demuxer demux:[self cuePacketWithSection:[self sectionWithPtsAdjustment:kWrap - 90000
+                                                                      commandType:TSScte35SpliceCommandTypeSpliceInsert
+                                                                          command:[self spliceInsertWithEventId:42 ptsTime:3 * 90000]
+                                                                      descriptors:[NSData data]]] dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(self.delegate.receivedSpliceInfos.count, (NSUInteger)2);
+    XCTAssertEqual(self.delegate.receivedAccessUnits.count, (NSUInteger)0);
+}
+
+- (void)test_timeSignal_decodesSegmentationDescriptors {
+    [self.demuxer demux:[self psiData] dataArrivalHostTimeNanos:0];
+
+    NSMutableData *command = [NSMutableData data];
+    appendTimestamp(command, 0xFE, 900000);
+
+    const uint8_t segmentation[] = {
+        0x02, 26, 'C', 'U', 'E', 'I',
+        0x00, 0x00, 0x00, 0x07,                 // segmentation_event_id
+        0x7F,                                   // not cancelled
+        0xD7,                                   // program, duration, restricted: web, archive, devices 3
+        0x00, 0x00, 0x29, 0x32, 0xE0,           // duration 2700000 (30 s)
+        0x09, 0x04, 'S', 'P', 'O', 'T',         // ADI UPID
+        0x34, 0x01, 0x01,                       // provider placement opportunity start, 1/1
+        0x01, 0x02                              // sub-segment 1/2
+    };
+    const uint8_t avail[] = { 0x00, 0x08, 'C', 'U', 'E', 'I', 0x00, 0x00, 0x00, 0x01 };
+    NSMutableData *descriptors = [NSMutableData dataWithBytes:avail length:sizeof(avail)];
+    [descriptors appendBytes:segmentation length:sizeof(segmentation)];
+
+    [self.demuxer demux:[self cuePacketWithSection:[self sectionWithPtsAdjustment:0
+                                                                      commandType:TSScte35SpliceCommandTypeTimeSignal
+                                                                          command:command
+                                                                      descriptors:descriptors]] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(self.delegate.receivedSpliceInfos.count, (NSUInteger)1);
+    TSScte35SpliceInfoSection *cue = self.delegate.receivedSpliceInfos.firstObject;
+    XCTAssertEqual(cue.spliceCommandType, TSScte35SpliceCommandTypeTimeSignal);
+    XCTAssertNil(cue.spliceInsert);
+    XCTAssertEqual(cue.spliceTime.value, (int64_t)900000);
+    // No PCR yet: the timeline has no anchor
+    XCTAssertEqual(cue.timelineSpliceTime.value, (int64_t)900000);
+
+    XCTAssertEqual(cue.segmentationDescriptors.count, (NSUInteger)1);
+    TSScte35SegmentationDescriptor *descriptor = cue.segmentationDescriptors.firstObject;
+    XCTAssertEqual(descriptor.segmentationEventId, (uint32_t)7);
+    XCTAssertTrue(descriptor.isProgramSegmentation);
+    XCTAssertEqual(descriptor.segmentationDuration.value, (int64_t)2700000);
+    XCTAssertFalse(descriptor.isDeliveryNotRestricted);
+    XCTAssertTrue(descriptor.webDeliveryAllowed);
+    XCTAssertFalse(descriptor.noRegionalBlackout);
+    XCTAssertTrue(descriptor.archiveAllowed);
+    XCTAssertEqual(descriptor.deviceRestrictions, (uint8_t)3);
+    XCTAssertEqual(descriptor.upidType, (uint8_t)0x09);
+    XCTAssertEqualObjects(descriptor.upid, [@"SPOT" dataUsingEncoding:NSASCIIStringEncoding]);
+    XCTAssertEqual(descriptor.segmentationTypeId, TSScte35SegmentationTypeProviderPlacementOpportunityStart);
+    XCTAssertEqual(descriptor.segmentNum, (uint8_t)1);
+    XCTAssertEqual(descriptor.segmentsExpected, (uint8_t)1);
+    XCTAssertEqual(descriptor.subSegmentNum, (uint8_t)1);
+    XCTAssertEqual(descriptor.subSegmentsExpected, (uint8_t)2);
+}
+
+- (void)test_cuePid_processedDespiteEsPidFilter {
+    self.demuxer.esPidFilter = [NSSet setWithObject:@(kTestVideoPid)];
+    [self.demuxer demux:[self psiData] dataArrivalHostTimeNanos:0];
+
+    const uint8_t cancel[] = { 0x00, 0x00, 0x00, 0x2A, 0xFF };
+    [self.demuxer demux:[self cuePacketWithSection:[self sectionWithPtsAdjustment:0
+                                                                      commandType:TSScte35SpliceCommandTypeSpliceInsert
+                                                                          command:[NSData dataWithBytes:cancel length:sizeof(cancel)]
+                                                                      descriptors:[NSData data]]] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(self.delegate.receivedSpliceInfos.count, (NSUInteger)1);
+    TSScte35SpliceInfoSection *cue = self.delegate.receivedSpliceInfos.firstObject;
+    XCTAssertTrue(cue.spliceInsert.isCancel);
+    XCTAssertEqual(cue.spliceInsert.spliceEventId, (uint32_t)42);
+    XCTAssertFalse(CMTIME_IS_VALID(cue.spliceTime));
+}
+
+- (void)test_truncatedCommand_isNotDelivered {
+    [self.demuxer demux:[self psiData] dataArrivalHostTimeNanos:0];
+
+    // splice_command_length claims more than the splice_insert carries
+    NSData *insert = [self spliceInsertWithEventId:1 ptsTime:0];
+    NSData *truncated = [insert subdataWithRange:NSMakeRange(0, insert.length - 6)];
+    [self.demuxer demux:[self cuePacketWithSection:[self sectionWithPtsAdjustment:0
+                                                                      commandType:TSScte35SpliceCommandTypeSpliceInsert
+                                                                          command:truncated
+                                                                      descriptors:[NSData data]]] dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(self.delegate.receivedSpliceInfos.count, (NSUInteger)0);
+}
+
+@end
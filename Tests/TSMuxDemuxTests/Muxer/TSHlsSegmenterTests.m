@@ -0,0 +1,305 @@
+//
+//  TSHlsSegmenterTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for HLS / LL-HLS segmentation of the muxer output.
+//
+
+#import <XCTest/XCTest.h>
+@import TSMuxDemux;
+
+static const uint16_t kPmtPid = 4096;
+static const uint16_t kVideoPid = 256;
+
+#pragma mark - Mock Delegate
+
+@interface TSHlsSegmenterTestDelegate : NSObject <TSHlsSegmenterDelegate>
+@property(nonatomic, readonly, nonnull) NSMutableArray<TSHlsSegment*> *completedSegments;
+@property(nonatomic, readonly, nonnull) NSMutableArray<TSHlsPartialSegment*> *completedParts;
+@property(nonatomic, readonly, nonnull) NSMutableArray<TSHlsSegment*> *removedSegments;
+@property(nonatomic, readonly, nonnull) NSMutableSet<NSString*> *publishedUris;
+@property(nonatomic, readonly, nonnull) NSMutableArray<NSString*> *playlists;
+/// URIs listed in a playlist before their segment or part was published.
+@property(nonatomic, readonly, nonnull) NSMutableArray<NSString*> *unpublishedUris;
+@end
+
+@implementation TSHlsSegmenterTestDelegate
+
+-(instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _completedSegments = [NSMutableArray array];
+        _completedParts = [NSMutableArray array];
+        _removedSegments = [NSMutableArray array];
+        _publishedUris = [NSMutableSet set];
+        _playlists = [NSMutableArray array];
+        _unpublishedUris = [NSMutableArray array];
+    }
+    return self;
+}
+
+-(void)segmenter:(TSHlsSegmenter *)segmenter didCompleteSegment:(TSHlsSegment *)segment
+{
+    [self.completedSegments addObject:segment];
+    [self.publishedUris addObject:segment.uri];
+}
+
+-(void)segmenter:(TSHlsSegmenter *)segmenter didCompletePartialSegment:(TSHlsPartialSegment *)part
+{
+    [self.completedParts addObject:part];
+    [self.publishedUris addObject:part.uri];
+}
+
+-(void)segmenter:(TSHlsSegmenter *)segmenter didRemoveSegment:(TSHlsSegment *)segment
+{
+    [self.removedSegments addObject:segment];
+}
+
+-(void)segmenter:(TSHlsSegmenter *)segmenter didUpdatePlaylist:(NSString *)playlist
+{
+    [self.playlists addObject:playlist];
+    for (NSString *line in [playlist componentsSeparatedByString:@"\n"]) {
+        NSString *uri = nil;
+        if (line.length > 0 && ![line hasPrefix:@"#"]) {
+            uri = line;
+        } else if ([line hasPrefix:@"#EXT-X-PART:"]) {
+            uri = [[line componentsSeparatedByString:@"URI=\""][1] componentsSeparatedByString:@"\""][0];
+        }
+        if (uri && ![self.publishedUris containsObject:uri]) {
+            [self.unpublishedUris addObject:uri];
+        }
+    }
+}
+
+@end
+
+#pragma mark - Helpers
+
+static TSMuxerSettings *makeMuxerSettings(void) {
+    TSMuxerSettings *settings = [[TSMuxerSettings alloc] init];
+    settings.pmtPid = kPmtPid;
+    settings.pcrPid = kVideoPid;
+    settings.videoPid = kVideoPid;
+    settings.audioPid = 257;
+    settings.psiIntervalMs = 250;
+    settings.pcrIntervalMs = 30;
+    return settings;
+}
+
+static TSHlsSegmenterSettings *makeSegmenterSettings(NSUInteger targetDurationMs,
+                                                     NSUInteger partTargetDurationMs,
+                                                     NSUInteger playlistLength) {
+    TSHlsSegmenterSettings *settings = [[TSHlsSegmenterSettings alloc] init];
+    settings.targetDurationMs = targetDurationMs;
+    settings.partTargetDurationMs = partTargetDurationMs;
+    settings.playlistLength = playlistLength;
+    return settings;
+}
+
+/// Muxes `count` video frames at 30 fps, with a random access point every `keyFrameInterval` frames.
+static void muxFrames(TSMuxer *muxer, uint64_t *clockNanos, NSUInteger count, NSUInteger keyFrameInterval) {
+    for (NSUInteger frame = 0; frame < count; frame++) {
+        NSMutableData *data = [NSMutableData dataWithLength:1000];
+        memset(data.mutableBytes, 0xAA, data.length);
+        [muxer enqueueAccessUnit:[[TSAccessUnit alloc] initWithPid:kVideoPid
+                                                               pts:CMTimeMake(frame * 3000, 90000)
+                                                               dts:kCMTimeInvalid
+                                                   isDiscontinuous:NO
+                                               isRandomAccessPoint:frame % keyFrameInterval == 0
+                                                        streamType:kRawStreamTypeH264
+                                                       descriptors:nil
+                                                    compressedData:data]];
+        [muxer tick];
+        *clockNanos += 33333333ULL;
+    }
+}
+
+#pragma mark - Tests
+
+@interface TSHlsSegmenterTests : XCTestCase
+@end
+
+@implementation TSHlsSegmenterTests
+
+- (void)test_segmentsAndPartsCutAtRandomAccessPoints {
+    TSHlsSegmenterTestDelegate *delegate = [[TSHlsSegmenterTestDelegate alloc] init];
+    TSMuxerSettings *muxerSettings = makeMuxerSettings();
+    TSHlsSegmenter *segmenter = [[TSHlsSegmenter alloc] initWithSettings:makeSegmenterSettings(2000, 500, 3)
+                                                           muxerSettings:muxerSettings
+                                                                delegate:delegate];
+    __block uint64_t clockNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:muxerSettings
+                                        wallClockNanos:^{ return clockNanos; }
+                                              delegate:segmenter];
+
+    muxFrames(muxer, &clockNanos, 210, 30);
+    [segmenter finish];
+
+    // Cut at the random access points of 2, 4 and 6 s; the last one ends with the stream
+    XCTAssertEqual(delegate.completedSegments.count, 4);
+    const double expectedDurations[] = { 2.0, 2.0, 2.0, 1.0 };
+    for (NSUInteger i = 0; i < delegate.completedSegments.count; i++) {
+        XCTAssertEqual(delegate.completedSegments[i].sequenceNumber, i);
+        XCTAssertEqualWithAccuracy(delegate.completedSegments[i].duration, expectedDurations[i], 0.001);
+    }
+    XCTAssertEqual(delegate.removedSegments.count, 1);
+    XCTAssertEqual(delegate.removedSegments.firstObject.sequenceNumber, 0);
+    XCTAssertEqual(segmenter.segments.count, 3);
+
+    for (TSHlsSegment *segment in segmenter.segments) {
+        const uint8_t *bytes = segment.data.bytes;
+        XCTAssertEqual(segment.data.length % TS_PACKET_SIZE_188, 0);
+        XCTAssertEqual(TSPacketHeaderPid(bytes), PID_PAT, @"A segment should start with the PAT");
+        XCTAssertEqual(TSPacketHeaderPid(bytes + TS_PACKET_SIZE_188), kPmtPid, @"followed by the PMT");
+        for (NSUInteger offset = 0; offset < segment.data.length; offset += TS_PACKET_SIZE_188) {
+            if (TSPacketHeaderPid(bytes + offset) == kVideoPid) {
+                TSPacket *packet = [TSPacket packetWithTsPacketBytes:bytes + offset];
+                XCTAssertTrue(packet.header.payloadUnitStartIndicator);
+                XCTAssertTrue(packet.adaptationField.randomAccessFlag, @"The first video packet should be a random access point");
+                break;
+            }
+        }
+
+        // 0.5 s parts, independent when starting at a random access point, together the whole segment
+        NSArray<TSHlsPartialSegment*> *parts = segment.parts;
+        XCTAssertEqual(parts.count, (NSUInteger)llround(segment.duration / 0.5));
+        NSMutableData *partData = [NSMutableData data];
+        for (TSHlsPartialSegment *part in parts) {
+            XCTAssertEqualWithAccuracy(part.duration, 0.5, 0.001);
+            XCTAssertEqual(part.isIndependent, part.index % 2 == 0);
+            [partData appendData:part.data];
+        }
+        XCTAssertEqualObjects(partData, segment.data);
+    }
+
+    // Segments and parts are published before the playlists listing them
+    XCTAssertEqual(delegate.unpublishedUris.count, 0, @"%@", delegate.unpublishedUris);
+    XCTAssertGreaterThan(delegate.playlists.count, delegate.completedSegments.count,
+                         @"Playlists should also be published for parts");
+
+    NSString *playlist = segmenter.playlist;
+    XCTAssertEqualObjects(playlist, delegate.playlists.lastObject);
+    XCTAssertTrue([playlist containsString:@"#EXT-X-TARGETDURATION:2\n"]);
+    XCTAssertTrue([playlist containsString:@"#EXT-X-PART-INF:PART-TARGET=0.500\n"]);
+    XCTAssertTrue([playlist containsString:@"#EXT-X-MEDIA-SEQUENCE:1\n"]);
+    XCTAssertTrue([playlist containsString:@"#EXT-X-INDEPENDENT-SEGMENTS\n"]);
+    XCTAssertTrue([playlist containsString:@"#EXT-X-PART:DURATION=0.500,URI=\"segment3.0.ts\",INDEPENDENT=YES\n"
+                                            "#EXT-X-PART:DURATION=0.500,URI=\"segment3.1.ts\"\n"
+                                            "#EXTINF:1.000,\nsegment3.ts\n"]);
+    XCTAssertFalse([playlist containsString:@"segment0.ts"]);
+    XCTAssertTrue([playlist hasSuffix:@"#EXT-X-ENDLIST\n"]);
+}
+
+- (void)test_keyFramesBeyondTargetDuration_segmentsCutEarly {
+    TSHlsSegmenterTestDelegate *delegate = [[TSHlsSegmenterTestDelegate alloc] init];
+    TSMuxerSettings *muxerSettings = makeMuxerSettings();
+    TSHlsSegmenter *segmenter = [[TSHlsSegmenter alloc] initWithSettings:makeSegmenterSettings(2000, 0, 3)
+                                                           muxerSettings:muxerSettings
+                                                                delegate:delegate];
+    __block uint64_t clockNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:muxerSettings
+                                        wallClockNanos:^{ return clockNanos; }
+                                              delegate:segmenter];
+
+    // A random access point every 3 s: cut before 2.5 s, then again at the next random access point
+    muxFrames(muxer, &clockNanos, 210, 90);
+    [segmenter finish];
+
+    XCTAssertEqual(delegate.completedSegments.count, 5);
+    const NSUInteger expectedFrames[] = { 74, 16, 74, 16, 30 };
+    const BOOL expectedIndependent[] = { YES, NO, YES, NO, YES };
+    for (NSUInteger i = 0; i < delegate.completedSegments.count; i++) {
+        TSHlsSegment *segment = delegate.completedSegments[i];
+        XCTAssertEqualWithAccuracy(segment.duration, expectedFrames[i] / 30.0, 0.001);
+        XCTAssertLessThanOrEqual(lround(segment.duration), 2, @"EXTINF rounded should not exceed EXT-X-TARGETDURATION");
+        XCTAssertEqual(segment.isIndependent, expectedIndependent[i]);
+    }
+
+    NSString *playlist = segmenter.playlist;
+    XCTAssertTrue([playlist containsString:@"#EXT-X-TARGETDURATION:2\n"]);
+    XCTAssertFalse([playlist containsString:@"#EXT-X-INDEPENDENT-SEGMENTS"],
+                   @"A segment listed does not start with a random access point");
+}
+
+- (void)test_directoryWriter_writesListedFiles {
+    NSURL *directory = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString]];
+    TSHlsDirectoryWriter *writer = [[TSHlsDirectoryWriter alloc] initWithDirectoryURL:directory playlistName:@"live.m3u8"];
+    TSMuxerSettings *muxerSettings = makeMuxerSettings();
+    TSHlsSegmenter *segmenter = [[TSHlsSegmenter alloc] initWithSettings:makeSegmenterSettings(1000, 0, 2)
+                                                           muxerSettings:muxerSettings
+                                                                delegate:writer];
+    __block uint64_t clockNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:muxerSettings
+                                        wallClockNanos:^{ return clockNanos; }
+                                              delegate:segmenter];
+
+    muxFrames(muxer, &clockNanos, 150, 30);
+    [segmenter finish];
+    [writer waitUntilWritten];
+
+    XCTAssertEqual(segmenter.segments.count, 2);
+    for (TSHlsSegment *segment in segmenter.segments) {
+        NSData *file = [NSData dataWithContentsOfURL:[directory URLByAppendingPathComponent:segment.uri]];
+        XCTAssertEqualObjects(file, segment.data);
+        XCTAssertEqual(segment.parts.count, 0);
+    }
+    // Removed from the playlist less than their duration plus the playlist's ago: still available
+    for (uint64_t removed = 0; removed < 3; removed++) {
+        NSString *name = [NSString stringWithFormat:@"segment%llu.ts", removed];
+        XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:[directory URLByAppendingPathComponent:name].path]);
+    }
+    NSString *playlist = [NSString stringWithContentsOfURL:[directory URLByAppendingPathComponent:@"live.m3u8"]
+                                                  encoding:NSUTF8StringEncoding
+                                                     error:nil];
+    XCTAssertEqualObjects(playlist, segmenter.playlist);
+    XCTAssertFalse([playlist containsString:@"#EXT-X-PART"]);
+
+    [[NSFileManager defaultManager] removeItemAtURL:directory error:nil];
+}
+
+- (void)test_directoryWriter_deletesRemovedFilesAfterAvailabilityWindow {
+    NSURL *directory = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString]];
+    TSHlsDirectoryWriter *writer = [[TSHlsDirectoryWriter alloc] initWithDirectoryURL:directory playlistName:@"live.m3u8"];
+    TSMuxerSettings *muxerSettings = makeMuxerSettings();
+    TSHlsSegmenter *segmenter = [[TSHlsSegmenter alloc] initWithSettings:makeSegmenterSettings(1000, 0, 2)
+                                                           muxerSettings:muxerSettings
+                                                                delegate:writer];
+    __block uint64_t clockNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:muxerSettings
+                                        wallClockNanos:^{ return clockNanos; }
+                                              delegate:segmenter];
+
+    // Ten 1 s segments: segment N slides out when segment N + 2 completes, at N + 3 s published,
+    // and must stay available for 1 s plus the 2 s of the playlist, until N + 6 s.
+    muxFrames(muxer, &clockNanos, 300, 30);
+    [segmenter finish];
+    [writer waitUntilWritten];
+
+    XCTAssertEqual(segmenter.segments.count, 2);
+    for (uint64_t removed = 0; removed < 8; removed++) {
+        NSString *name = [NSString stringWithFormat:@"segment%llu.ts", removed];
+        const BOOL exists = [[NSFileManager defaultManager] fileExistsAtPath:[directory URLByAppendingPathComponent:name].path];
+        if (removed < 4) {
+            XCTAssertFalse(exists, @"%@ expired", name);
+        } else if (removed > 4) {
+            XCTAssertTrue(exists, @"%@ still in its availability window", name);
+        }
+    }
+
+    [[NSFileManager defaultManager] removeItemAtURL:directory error:nil];
+}
+
+- (void)test_invalidSettings_raise {
+    XCTAssertThrows([[TSHlsSegmenter alloc] initWithSettings:makeSegmenterSettings(0, 0, 3)
+                                               muxerSettings:makeMuxerSettings()
+                                                    delegate:nil]);
+    XCTAssertThrows([[TSHlsSegmenter alloc] initWithSettings:makeSegmenterSettings(2000, 2000, 3)
+                                               muxerSettings:makeMuxerSettings()
+                                                    delegate:nil]);
+    XCTAssertThrows([[TSHlsSegmenter alloc] initWithSettings:makeSegmenterSettings(2000, 500, 0)
+                                               muxerSettings:makeMuxerSettings()
+                                                    delegate:nil]);
+}
+
+@end
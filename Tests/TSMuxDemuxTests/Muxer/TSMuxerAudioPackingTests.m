@@ -0,0 +1,175 @@
+//
+//  TSMuxerAudioPackingTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for packing several audio access units into one PES.
+//
+
+#import <XCTest/XCTest.h>
+@import TSMuxDemux;
+
+static const uint16_t kVideoPid = 256;
+static const uint16_t kAudioPid = 257;
+static const uint16_t kUnpackedAudioPid = 258;
+/// One AAC frame (1024 samples at 48 kHz) in 90 kHz ticks.
+static const int64_t kFrameTicks = 1920;
+
+#pragma mark - Mock Delegate
+
+@interface TSMuxerAudioPackingTestDelegate : NSObject <TSMuxerDelegate>
+@property(nonatomic, readonly, nonnull) NSMutableArray<NSData*> *packets;
+@end
+
+@implementation TSMuxerAudioPackingTestDelegate
+
+-(instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _packets = [NSMutableArray array];
+    }
+    return self;
+}
+
+-(void)muxer:(TSMuxer *)muxer didMuxTSPacketData:(NSData *)tsPacketData
+{
+    [self.packets addObject:tsPacketData];
+}
+
+@end
+
+#pragma mark - Helpers
+
+static TSAccessUnit *makeAudioAU(uint16_t pid, int64_t pts90kHz, NSUInteger payloadSize) {
+    NSMutableData *data = [NSMutableData dataWithLength:payloadSize];
+    memset(data.mutableBytes, 0xBB, payloadSize);
+    return [[TSAccessUnit alloc] initWithPid:pid
+                                         pts:CMTimeMake(pts90kHz, 90000)
+                                         dts:kCMTimeInvalid
+                             isDiscontinuous:NO
+                          isRandomAccessPoint:NO
+                                  streamType:kRawStreamTypeADTSAAC
+                                  descriptors:nil
+                              compressedData:data];
+}
+
+/// The PES packets started on a PID, as @[PTS, payload size] pairs.
+static NSArray<NSArray<NSNumber*>*> *extractPesPackets(NSArray<NSData*> *packets, uint16_t targetPid) {
+    NSMutableArray<NSArray<NSNumber*>*> *pes = [NSMutableArray array];
+    for (NSData *packet in packets) {
+        const uint8_t *bytes = packet.bytes;
+        const uint16_t pid = ((bytes[1] & 0x1F) << 8) | bytes[2];
+        const BOOL pusi = (bytes[1] & 0x40) != 0;
+        if (pid != targetPid || !pusi) continue;
+
+        const uint8_t adaptationControl = (bytes[3] & 0x30) >> 4;
+        const uint8_t *p = bytes + 4 + (adaptationControl == 0x03 ? 1 + bytes[4] : 0);
+        const NSUInteger pesLength = (p[4] << 8) | p[5];
+        const NSUInteger headerDataLength = p[8];
+        const uint64_t pts = ((uint64_t)(p[9] & 0x0E) << 29)
+                           | ((uint64_t)p[10] << 22)
+                           | ((uint64_t)(p[11] & 0xFE) << 14)
+                           | ((uint64_t)p[12] << 7)
+                           | (p[13] >> 1);
+        [pes addObject:@[@(pts), @(pesLength - 3 - headerDataLength)]];
+    }
+    return pes;
+}
+
+static TSMuxerSettings *makeSettings(TSAudioPackingPolicy *policy) {
+    TSMuxerSettings *settings = [[TSMuxerSettings alloc] init];
+    settings.pmtPid = 4096;
+    settings.pcrPid = kVideoPid;
+    settings.videoPid = kVideoPid;
+    settings.audioPid = kAudioPid;
+    settings.psiIntervalMs = 250;
+    settings.pcrIntervalMs = 30;
+    settings.audioPackingPolicies = @{ @(kAudioPid): policy };
+    return settings;
+}
+
+#pragma mark - Tests
+
+@interface TSMuxerAudioPackingTests : XCTestCase
+@end
+
+@implementation TSMuxerAudioPackingTests
+
+- (void)test_packsFramesUpToDuration_withFirstPts {
+    TSMuxerAudioPackingTestDelegate *delegate = [[TSMuxerAudioPackingTestDelegate alloc] init];
+    __block uint64_t mockTimeNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:makeSettings([TSAudioPackingPolicy policyWithMaxDurationMs:50 maxPayloadBytes:0])
+                                        wallClockNanos:^{ return mockTimeNanos; }
+                                              delegate:delegate];
+
+    // 0, 21.3 and 42.7 ms fit in 50 ms, 64 ms starts the next PES
+    for (int64_t i = 0; i < 4; i++) {
+        [muxer enqueueAccessUnit:makeAudioAU(kAudioPid, 90000 + i * kFrameTicks, 300)];
+    }
+    [muxer tick];
+    XCTAssertEqualObjects(extractPesPackets(delegate.packets, kAudioPid), (@[@[@0, @900]]));
+
+    // The last frame is held until 50 ms after it was enqueued
+    [delegate.packets removeAllObjects];
+    mockTimeNanos += 49000000ULL;
+    [muxer tick];
+    XCTAssertEqual(extractPesPackets(delegate.packets, kAudioPid).count, (NSUInteger)0);
+
+    mockTimeNanos += 1000000ULL;
+    [muxer tick];
+    XCTAssertEqualObjects(extractPesPackets(delegate.packets, kAudioPid), (@[@[@(3 * kFrameTicks), @300]]));
+}
+
+- (void)test_packsFramesUpToPayloadSize {
+    TSMuxerAudioPackingTestDelegate *delegate = [[TSMuxerAudioPackingTestDelegate alloc] init];
+    __block uint64_t mockTimeNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:makeSettings([TSAudioPackingPolicy policyWithMaxDurationMs:1000 maxPayloadBytes:700])
+                                        wallClockNanos:^{ return mockTimeNanos; }
+                                              delegate:delegate];
+
+    for (int64_t i = 0; i < 5; i++) {
+        [muxer enqueueAccessUnit:makeAudioAU(kAudioPid, 90000 + i * kFrameTicks, 300)];
+    }
+    [muxer tick];
+    XCTAssertEqualObjects(extractPesPackets(delegate.packets, kAudioPid),
+                          (@[@[@0, @600], @[@(2 * kFrameTicks), @600]]));
+}
+
+- (void)test_discontinuityAndOtherPids_areNotPacked {
+    TSMuxerAudioPackingTestDelegate *delegate = [[TSMuxerAudioPackingTestDelegate alloc] init];
+    __block uint64_t mockTimeNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:makeSettings([TSAudioPackingPolicy policyWithMaxDurationMs:100 maxPayloadBytes:0])
+                                        wallClockNanos:^{ return mockTimeNanos; }
+                                              delegate:delegate];
+
+    [muxer enqueueAccessUnit:makeAudioAU(kAudioPid, 90000, 300)];
+    [muxer enqueueAccessUnit:[[TSAccessUnit alloc] initWithPid:kAudioPid
+                                                           pts:CMTimeMake(90000 + kFrameTicks, 90000)
+                                                           dts:kCMTimeInvalid
+                                               isDiscontinuous:YES
+                                            isRandomAccessPoint:NO
+                                                    streamType:kRawStreamTypeADTSAAC
+                                                    descriptors:nil
+                                                compressedData:[NSMutableData dataWithLength:200]]];
+    [muxer enqueueAccessUnit:makeAudioAU(kUnpackedAudioPid, 90000, 300)];
+    [muxer enqueueAccessUnit:makeAudioAU(kUnpackedAudioPid, 90000 + kFrameTicks, 300)];
+    [muxer tick];
+
+    XCTAssertEqualObjects(extractPesPackets(delegate.packets, kAudioPid), (@[@[@0, @300]]));
+    XCTAssertEqualObjects(extractPesPackets(delegate.packets, kUnpackedAudioPid),
+                          (@[@[@0, @300], @[@(kFrameTicks), @300]]));
+}
+
+- (void)test_init_rejectsZeroDuration {
+    XCTAssertThrows([[TSMuxer alloc] initWithSettings:makeSettings([TSAudioPackingPolicy policyWithMaxDurationMs:0 maxPayloadBytes:0])
+                                       wallClockNanos:^{ return (uint64_t)0; }
+                                             delegate:nil]);
+}
+
+- (void)test_settings_copyPreservesPolicies {
+    TSMuxerSettings *copy = [makeSettings([TSAudioPackingPolicy policyWithMaxDurationMs:40 maxPayloadBytes:1500]) copy];
+    XCTAssertEqual(copy.audioPackingPolicies[@(kAudioPid)].maxDurationMs, (NSUInteger)40);
+    XCTAssertEqual(copy.audioPackingPolicies[@(kAudioPid)].maxPayloadBytes, (NSUInteger)1500);
+}
+
+@end
@@ -0,0 +1,195 @@
+//
+//  TSMuxerPacingTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for the CBR pacing thread.
+//
+
+#import <XCTest/XCTest.h>
+@import TSMuxDemux;
+
+#pragma mark - Simulated Time
+
+/// Simulated time of the pacing thread: advances by what the thread sleeps plus a fixed oversleep,
+/// and by a microsecond per reading so that spinning makes progress too.
+@interface TSPacingTestClock : NSObject
+@property(nonatomic) uint64_t oversleepNanos;
+-(uint64_t)read;
+-(uint64_t)peek;
+-(void)sleepNanos:(uint64_t)nanos;
+@end
+
+@implementation TSPacingTestClock
+{
+    uint64_t _nowNanos;
+}
+
+-(instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _nowNanos = 1000000000ULL;
+        _oversleepNanos = 100000;
+    }
+    return self;
+}
+
+-(uint64_t)read
+{
+    @synchronized (self) {
+        _nowNanos += 1000;
+        return _nowNanos;
+    }
+}
+
+-(uint64_t)peek
+{
+    @synchronized (self) {
+        return _nowNanos;
+    }
+}
+
+-(void)sleepNanos:(uint64_t)nanos
+{
+    @synchronized (self) {
+        _nowNanos += nanos + _oversleepNanos;
+    }
+}
+
+@end
+
+#pragma mark - Mock Delegate
+
+@interface TSMuxerPacingTestDelegate : NSObject <TSMuxerDelegate>
+@property(atomic) NSUInteger numPackets;
+@property(atomic) BOOL calledOnMainThread;
+@property(nonatomic, strong) TSPacingTestClock *clock;
+/// Simulated time at which each packet was sent, up to `packetLimit`.
+@property(nonatomic) uint64_t *sendTimes;
+@property(nonatomic) NSUInteger packetLimit;
+@property(nonatomic, strong) dispatch_semaphore_t reachedLimit;
+@end
+
+@implementation TSMuxerPacingTestDelegate
+
+-(instancetype)initWithClock:(TSPacingTestClock *)clock packetLimit:(NSUInteger)packetLimit
+{
+    self = [super init];
+    if (self) {
+        _clock = clock;
+        _packetLimit = packetLimit;
+        _sendTimes = calloc(packetLimit, sizeof(uint64_t));
+        _reachedLimit = dispatch_semaphore_create(0);
+    }
+    return self;
+}
+
+-(void)dealloc
+{
+    free(_sendTimes);
+}
+
+-(void)muxer:(TSMuxer *)muxer didMuxTSPacketData:(NSData *)tsPacketData
+{
+    const NSUInteger index = self.numPackets++;
+    if ([NSThread isMainThread]) {
+        self.calledOnMainThread = YES;
+    }
+    if (index < self.packetLimit) {
+        self.sendTimes[index] = [self.clock peek];
+        if (index + 1 == self.packetLimit) {
+            dispatch_semaphore_signal(self.reachedLimit);
+        }
+    }
+}
+
+@end
+
+#pragma mark - Helpers
+
+static TSMuxerSettings *makeSettings(NSUInteger targetBitrateKbps) {
+    TSMuxerSettings *settings = [[TSMuxerSettings alloc] init];
+    settings.pmtPid = 4096;
+    settings.pcrPid = 256;
+    settings.videoPid = 256;
+    settings.audioPid = 257;
+    settings.psiIntervalMs = 250;
+    settings.pcrIntervalMs = 30;
+    settings.targetBitrateKbps = targetBitrateKbps;
+    return settings;
+}
+
+static TSMuxer *makeSimulatedMuxer(NSUInteger targetBitrateKbps, TSPacingTestClock *clock, id<TSMuxerDelegate> delegate) {
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:makeSettings(targetBitrateKbps)
+                                        wallClockNanos:^{ return [clock read]; }
+                                              delegate:delegate];
+    muxer.pacingSleepNanos = ^(uint64_t nanos) { [clock sleepNanos:nanos]; };
+    return muxer;
+}
+
+#pragma mark - Tests
+
+@interface TSMuxerPacingTests : XCTestCase
+@end
+
+@implementation TSMuxerPacingTests
+
+- (void)test_pacing_sendsBatchesAtTargetBitrate {
+    // 7 packets are due every 5.264 ms at 2000 kbps: 700 packets take 526.4 ms of simulated time
+    const NSUInteger bitrateKbps = 2000;
+    const NSUInteger numPackets = 700;
+    TSPacingTestClock *clock = [[TSPacingTestClock alloc] init];
+    const uint64_t startNanos = [clock peek];
+    TSMuxerPacingTestDelegate *delegate = [[TSMuxerPacingTestDelegate alloc] initWithClock:clock packetLimit:numPackets];
+    TSMuxer *muxer = makeSimulatedMuxer(bitrateKbps, clock, delegate);
+
+    [muxer startPacingWithPacketsPerBatch:7];
+    XCTAssertTrue(muxer.isPacing);
+    XCTAssertEqual(dispatch_semaphore_wait(delegate.reachedLimit, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_SEC)), 0);
+    [muxer stopPacing];
+    XCTAssertFalse(muxer.isPacing);
+    XCTAssertFalse(delegate.calledOnMainThread);
+
+    // No packet leaves before it is due, nor later than one batch (with PSI, 8 packets) after
+    const double packetNanos = TS_PACKET_SIZE_188 * 8.0 * 1e6 / bitrateKbps;
+    for (NSUInteger i = 0; i < numPackets; i++) {
+        const double sentNanos = (double)(delegate.sendTimes[i] - startNanos);
+        XCTAssertGreaterThanOrEqual(sentNanos, (i + 1) * packetNanos, @"packet %lu", (unsigned long)i);
+        XCTAssertLessThanOrEqual(sentNanos, (i + 1 + 8) * packetNanos + 200000, @"packet %lu", (unsigned long)i);
+    }
+
+    TSMuxerPacingStatistics *stats = [muxer pacingStatistics];
+    XCTAssertEqual(stats.numPackets, (uint64_t)delegate.numPackets);
+    XCTAssertGreaterThanOrEqual(stats.numBatches, (uint64_t)(numPackets / 8));
+    XCTAssertGreaterThanOrEqual(stats.maxPacketsPerBatch, (NSUInteger)7);
+    // The spin adapts to the 100 us oversleep: only the first batches are late
+    XCTAssertLessThan(stats.meanLatenessNanos, 20000);
+    XCTAssertLessThan(stats.maxLatenessNanos, (uint64_t)100000);
+}
+
+- (void)test_pacing_stopsSendingAfterStop {
+    TSPacingTestClock *clock = [[TSPacingTestClock alloc] init];
+    TSMuxerPacingTestDelegate *delegate = [[TSMuxerPacingTestDelegate alloc] initWithClock:clock packetLimit:10];
+    TSMuxer *muxer = makeSimulatedMuxer(5000, clock, delegate);
+    [muxer startPacingWithPacketsPerBatch:1];
+    XCTAssertEqual(dispatch_semaphore_wait(delegate.reachedLimit, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_SEC)), 0);
+    [muxer stopPacing];
+
+    // The thread has exited: simulated time and the packet count stand still
+    const NSUInteger numPackets = delegate.numPackets;
+    const uint64_t stoppedNanos = [clock peek];
+    XCTAssertGreaterThanOrEqual(numPackets, (NSUInteger)10);
+    XCTAssertEqual(delegate.numPackets, numPackets);
+    XCTAssertEqual([clock peek], stoppedNanos);
+}
+
+- (void)test_pacing_rejectsVbrAndEmptyBatches {
+    TSMuxer *vbr = [[TSMuxer alloc] initWithSettings:makeSettings(0) wallClockNanos:^{ return (uint64_t)0; } delegate:nil];
+    XCTAssertThrows([vbr startPacingWithPacketsPerBatch:7]);
+
+    TSMuxer *cbr = [[TSMuxer alloc] initWithSettings:makeSettings(1000) wallClockNanos:^{ return (uint64_t)0; } delegate:nil];
+    XCTAssertThrows([cbr startPacingWithPacketsPerBatch:0]);
+    XCTAssertFalse(cbr.isPacing);
+}
+
+@end
@@ -0,0 +1,303 @@
+//
+//  TSMuxerSpliceTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for SCTE-35 cue insertion and splice point signaling in the muxer.
+//
+
+#import <XCTest/XCTest.h>
+@import TSMuxDemux;
+
+static const uint16_t kVideoPid = 256;
+static const uint16_t kAudioPid = 257;
+static const uint16_t kCuePid = 0x1F0;
+/// One frame at 29.97 fps in 90 kHz ticks.
+static const int64_t kFrameTicks = 3003;
+
+#pragma mark - Mock Delegate
+
+@interface TSMuxerSpliceTestDelegate : NSObject <TSMuxerDelegate, TSDemuxerDelegate>
+@property(nonatomic, readonly, nonnull) NSMutableArray<NSData*> *packets;
+@property(nonatomic, readonly, nonnull) NSMutableArray<TSScte35SpliceInfoSection*> *spliceInfos;
+@end
+
+@implementation TSMuxerSpliceTestDelegate
+
+-(instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _packets = [NSMutableArray array];
+        _spliceInfos = [NSMutableArray array];
+    }
+    return self;
+}
+
+-(void)muxer:(TSMuxer *)muxer didMuxTSPacketData:(NSData *)tsPacketData
+{
+    [self.packets addObject:tsPacketData];
+}
+
+-(void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {}
+-(void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+-(void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {}
+
+-(void)demuxer:(TSDemuxer *)demuxer didReceiveSpliceInfo:(TSScte35SpliceInfoSection *)spliceInfo
+           pid:(uint16_t)pid
+ programNumber:(uint16_t)programNumber
+{
+    [self.spliceInfos addObject:spliceInfo];
+}
+
+@end
+
+#pragma mark - Helpers
+
+static TSAccessUnit *makeVideoAU(int64_t pts90kHz, BOOL isRandomAccessPoint, NSUInteger payloadSize) {
+    NSMutableData *data = [NSMutableData dataWithLength:payloadSize];
+    memset(data.mutableBytes, 0xAA, payloadSize);
+    return [[TSAccessUnit alloc] initWithPid:kVideoPid
+                                         pts:CMTimeMake(pts90kHz, 90000)
+                                         dts:kCMTimeInvalid
+                             isDiscontinuous:NO
+                          isRandomAccessPoint:isRandomAccessPoint
+                                  streamType:kRawStreamTypeH264
+                                  descriptors:nil
+                              compressedData:data];
+}
+
+static TSMuxerSettings *makeSettings(void) {
+    TSMuxerSettings *settings = [[TSMuxerSettings alloc] init];
+    settings.pmtPid = 4096;
+    settings.pcrPid = kVideoPid;
+    settings.videoPid = kVideoPid;
+    settings.audioPid = kAudioPid;
+    settings.psiIntervalMs = 250;
+    settings.pcrIntervalMs = 30;
+    settings.scte35Pid = kCuePid;
+    return settings;
+}
+
+/// Indexes of the packets on a PID in the muxer output.
+static NSArray<NSNumber*> *packetIndexes(NSArray<NSData*> *packets, uint16_t pid, BOOL pusiOnly) {
+    NSMutableArray<NSNumber*> *indexes = [NSMutableArray array];
+    for (NSUInteger i = 0; i < packets.count; i++) {
+        const uint8_t *bytes = packets[i].bytes;
+        if (TSPacketHeaderPid(bytes) == pid && (!pusiOnly || (bytes[1] & 0x40))) {
+            [indexes addObject:@(i)];
+        }
+    }
+    return indexes;
+}
+
+static TSAdaptationField *adaptationField(NSData *packet) {
+    return [TSPacket packetWithTsPacketBytes:packet.bytes].adaptationField;
+}
+
+#pragma mark - Tests
+
+@interface TSMuxerSpliceTests : XCTestCase
+@end
+
+@implementation TSMuxerSpliceTests
+
+#pragma mark - Packetizer
+
+- (void)test_packetizePayload_codesSpliceCountdownInFirstAndLastPacket {
+    TSElementaryStream *track = [[TSElementaryStream alloc] initWithPid:kVideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    NSMutableArray<NSData*> *packets = [NSMutableArray array];
+    [TSPacket packetizePayload:[NSMutableData dataWithLength:400]
+                         track:track
+                       pcrBase:kNoPcr
+                        pcrExt:0
+             discontinuityFlag:NO
+              randomAccessFlag:YES
+    firstPacketSpliceCountdown:-1
+     lastPacketSpliceCountdown:0
+                onTsPacketData:^(NSData *tsPacketData, uint16_t pid, uint8_t cc) {
+        [packets addObject:tsPacketData];
+    }];
+
+    XCTAssertEqual(packets.count, (NSUInteger)3);
+    TSAdaptationField *first = adaptationField(packets[0]);
+    XCTAssertTrue(first.splicingPointFlag);
+    XCTAssertTrue(first.randomAccessFlag);
+    XCTAssertEqual(first.spliceCountdown, (int8_t)-1);
+    XCTAssertNil(adaptationField(packets[1]));
+    TSAdaptationField *last = adaptationField(packets.lastObject);
+    XCTAssertTrue(last.splicingPointFlag);
+    XCTAssertEqual(last.spliceCountdown, (int8_t)0);
+
+    NSUInteger payloadLength = 0;
+    for (NSData *packet in packets) {
+        XCTAssertEqual(packet.length, (NSUInteger)TS_PACKET_SIZE_188);
+        payloadLength += [TSPacket packetWithTsPacketBytes:packet.bytes].payload.length;
+    }
+    XCTAssertEqual(payloadLength, (NSUInteger)400);
+}
+
+- (void)test_packetizePayload_leavesRoomForLastPacketCountdown {
+    // 183 bytes would fit in one packet with a 1-byte adaptation field, but not next to a countdown
+    TSElementaryStream *track = [[TSElementaryStream alloc] initWithPid:kVideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    NSMutableArray<NSData*> *packetData = [NSMutableArray array];
+    [TSPacket packetizePayload:[NSMutableData dataWithLength:183]
+                         track:track
+                       pcrBase:kNoPcr
+                        pcrExt:0
+             discontinuityFlag:NO
+              randomAccessFlag:NO
+    firstPacketSpliceCountdown:kNoSpliceCountdown
+     lastPacketSpliceCountdown:0
+                onTsPacketData:^(NSData *tsPacketData, uint16_t pid, uint8_t cc) {
+        [packetData addObject:tsPacketData];
+    }];
+    NSMutableArray<TSPacket*> *packets = [NSMutableArray array];
+    for (NSData *data in packetData) {
+        [packets addObject:[TSPacket packetWithTsPacketBytes:data.bytes]];
+    }
+
+    XCTAssertEqual(packets.count, (NSUInteger)2);
+    XCTAssertFalse(packets[0].adaptationField.splicingPointFlag);
+    XCTAssertEqual(packets[0].payload.length, (NSUInteger)182);
+    XCTAssertTrue(packets[1].adaptationField.splicingPointFlag);
+    XCTAssertEqual(packets[1].adaptationField.spliceCountdown, (int8_t)0);
+    XCTAssertEqual(packets[1].payload.length, (NSUInteger)1);
+}
+
+#pragma mark - Muxer
+
+- (void)test_spliceInsert_marksSplicePointAndPrecedesIt {
+    TSMuxerSpliceTestDelegate *delegate = [[TSMuxerSpliceTestDelegate alloc] init];
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:makeSettings()
+                                        wallClockNanos:^{ return (uint64_t)1000000000ULL; }
+                                              delegate:delegate];
+
+    for (int64_t i = 0; i < 5; i++) {
+        [muxer enqueueAccessUnit:makeVideoAU(90000 + i * kFrameTicks, i == 0 || i == 3, 1000)];
+    }
+    [muxer scheduleSpliceInsertWithEventId:42
+                            isOutOfNetwork:YES
+                                spliceTime:CMTimeMake(90000 + 3 * kFrameTicks, 90000)
+                             breakDuration:CMTimeMake(30, 1)];
+    XCTAssertEqual(muxer.scheduledSpliceCueCount, (NSUInteger)1);
+    [muxer tick];
+    XCTAssertEqual(muxer.scheduledSpliceCueCount, (NSUInteger)0);
+
+    NSArray<NSNumber*> *auStarts = packetIndexes(delegate.packets, kVideoPid, YES);
+    XCTAssertEqual(auStarts.count, (NSUInteger)5);
+    NSArray<NSNumber*> *cuePackets = packetIndexes(delegate.packets, kCuePid, NO);
+    XCTAssertEqual(cuePackets.count, (NSUInteger)1);
+    XCTAssertLessThan(cuePackets[0].unsignedIntegerValue, auStarts[3].unsignedIntegerValue);
+
+    // Splice point: first packet of the 4th access unit, the packet before it on the PID ends the 3rd
+    TSAdaptationField *splicePoint = adaptationField(delegate.packets[auStarts[3].unsignedIntegerValue]);
+    XCTAssertTrue(splicePoint.splicingPointFlag);
+    XCTAssertEqual(splicePoint.spliceCountdown, (int8_t)-1);
+    NSArray<NSNumber*> *videoPackets = packetIndexes(delegate.packets, kVideoPid, NO);
+    const NSUInteger lastBefore = [videoPackets indexOfObject:auStarts[3]] - 1;
+    TSAdaptationField *beforeSplicePoint = adaptationField(delegate.packets[videoPackets[lastBefore].unsignedIntegerValue]);
+    XCTAssertTrue(beforeSplicePoint.splicingPointFlag);
+    XCTAssertEqual(beforeSplicePoint.spliceCountdown, (int8_t)0);
+
+    for (NSUInteger i = 0; i < 5; i++) {
+        if (i == 3) continue;
+        XCTAssertFalse(adaptationField(delegate.packets[auStarts[i].unsignedIntegerValue]).splicingPointFlag);
+    }
+
+    // The cue decodes with its times relative to the first access unit, like the PTS
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    for (NSData *packet in delegate.packets) {
+        [demuxer demux:packet dataArrivalHostTimeNanos:0];
+    }
+    XCTAssertEqual(delegate.spliceInfos.count, (NSUInteger)1);
+    TSScte35SpliceInfoSection *spliceInfo = delegate.spliceInfos.firstObject;
+    XCTAssertEqual(spliceInfo.spliceCommandType, (uint8_t)TSScte35SpliceCommandTypeSpliceInsert);
+    XCTAssertEqual(spliceInfo.spliceTime.value, 3 * kFrameTicks);
+    XCTAssertEqual(spliceInfo.spliceInsert.spliceEventId, (uint32_t)42);
+    XCTAssertTrue(spliceInfo.spliceInsert.isOutOfNetwork);
+    XCTAssertTrue(spliceInfo.spliceInsert.isProgramSplice);
+    XCTAssertTrue(spliceInfo.spliceInsert.isAutoReturn);
+    XCTAssertEqual(spliceInfo.spliceInsert.breakDuration.value, 30 * 90000);
+}
+
+- (void)test_spliceTimeWithoutRandomAccessPoint_splicesAtNextOne {
+    TSMuxerSpliceTestDelegate *delegate = [[TSMuxerSpliceTestDelegate alloc] init];
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:makeSettings()
+                                        wallClockNanos:^{ return (uint64_t)1000000000ULL; }
+                                              delegate:delegate];
+
+    for (int64_t i = 0; i < 6; i++) {
+        [muxer enqueueAccessUnit:makeVideoAU(90000 + i * kFrameTicks, i == 0 || i == 4, 200)];
+    }
+    [muxer scheduleTimeSignalAtTime:CMTimeMake(90000 + 3 * kFrameTicks, 90000) spliceDescriptors:nil];
+    [muxer tick];
+
+    NSArray<NSNumber*> *auStarts = packetIndexes(delegate.packets, kVideoPid, YES);
+    XCTAssertFalse(adaptationField(delegate.packets[auStarts[3].unsignedIntegerValue]).splicingPointFlag);
+    TSAdaptationField *splicePoint = adaptationField(delegate.packets[auStarts[4].unsignedIntegerValue]);
+    XCTAssertTrue(splicePoint.splicingPointFlag);
+    XCTAssertEqual(splicePoint.spliceCountdown, (int8_t)-1);
+    XCTAssertEqual(muxer.scheduledSpliceCueCount, (NSUInteger)0);
+}
+
+- (void)test_cbr_cuesRepeatWithinBitrate {
+    TSMuxerSettings *settings = makeSettings();
+    settings.targetBitrateKbps = 2000;
+    settings.scte35RepeatIntervalMs = 100;
+    TSMuxerSpliceTestDelegate *delegate = [[TSMuxerSpliceTestDelegate alloc] init];
+    __block uint64_t mockTimeNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:settings
+                                        wallClockNanos:^{ return mockTimeNanos; }
+                                              delegate:delegate];
+
+    [muxer enqueueAccessUnit:makeVideoAU(90000, YES, 1000)];
+    NSData *descriptor = [TSScte35SegmentationDescriptor makeDescriptorWithEventId:7
+                                                                segmentationTypeId:TSScte35SegmentationTypeProviderPlacementOpportunityStart
+                                                                          duration:30 * 90000
+                                                                          upidType:0x0F
+                                                                              upid:[@"ad" dataUsingEncoding:NSASCIIStringEncoding]
+                                                                        segmentNum:1
+                                                                  segmentsExpected:1];
+    [muxer scheduleTimeSignalAtTime:CMTimeMake(90000 + 10 * 90000, 90000) spliceDescriptors:descriptor];
+    [muxer tick];
+    for (int i = 0; i < 100; i++) {
+        mockTimeNanos += 10000000ULL;
+        [muxer tick];
+    }
+
+    // The cues take the place of null packets: the bitrate is unchanged
+    const double packetsPerSecond = 2000 * 1e3 / 8.0 / TS_PACKET_SIZE_188;
+    XCTAssertEqualWithAccuracy((double)delegate.packets.count, packetsPerSecond, 2.0);
+    const NSUInteger numCues = packetIndexes(delegate.packets, kCuePid, NO).count;
+    XCTAssertGreaterThanOrEqual(numCues, (NSUInteger)9);
+    XCTAssertLessThanOrEqual(numCues, (NSUInteger)11);
+    XCTAssertEqual(muxer.scheduledSpliceCueCount, (NSUInteger)1);
+
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    for (NSData *packet in delegate.packets) {
+        [demuxer demux:packet dataArrivalHostTimeNanos:0];
+    }
+    XCTAssertEqual(delegate.spliceInfos.count, numCues);
+    TSScte35SegmentationDescriptor *segmentation = delegate.spliceInfos.firstObject.segmentationDescriptors.firstObject;
+    XCTAssertEqual(segmentation.segmentationEventId, (uint32_t)7);
+    XCTAssertEqual(segmentation.segmentationTypeId, (uint8_t)TSScte35SegmentationTypeProviderPlacementOpportunityStart);
+    XCTAssertEqual(segmentation.segmentationDuration.value, 30 * 90000);
+    XCTAssertEqualObjects(segmentation.upid, [@"ad" dataUsingEncoding:NSASCIIStringEncoding]);
+    XCTAssertEqual(delegate.spliceInfos.firstObject.spliceTime.value, 10 * 90000);
+}
+
+- (void)test_scheduleWithoutCuePid_raises {
+    TSMuxerSettings *settings = makeSettings();
+    settings.scte35Pid = 0;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:settings
+                                        wallClockNanos:^{ return (uint64_t)0; }
+                                              delegate:nil];
+    XCTAssertThrows([muxer scheduleTimeSignalAtTime:CMTimeMake(90000, 90000) spliceDescriptors:nil]);
+
+    settings.scte35Pid = kVideoPid;
+    XCTAssertThrows([[TSMuxer alloc] initWithSettings:settings
+                                       wallClockNanos:^{ return (uint64_t)0; }
+                                             delegate:nil]);
+}
+
+@end
@@ -0,0 +1,142 @@
+//
+//  TSMuxerSubmissionTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for submitting access units to the muxer from several threads.
+//
+
+#import <XCTest/XCTest.h>
+@import TSMuxDemux;
+
+#pragma mark - Mock Delegate
+
+@interface TSMuxerSubmissionTestDelegate : NSObject <TSMuxerDelegate>
+@property(nonatomic, readonly, nonnull) NSMutableArray<NSData*> *packets;
+@end
+
+@implementation TSMuxerSubmissionTestDelegate
+
+-(instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _packets = [NSMutableArray array];
+    }
+    return self;
+}
+
+-(void)muxer:(TSMuxer *)muxer didMuxTSPacketData:(NSData *)tsPacketData
+{
+    [self.packets addObject:tsPacketData];
+}
+
+@end
+
+#pragma mark - Helpers
+
+static TSAccessUnit *makeAU(uint16_t pid, uint8_t streamType, int64_t pts90kHz) {
+    return [[TSAccessUnit alloc] initWithPid:pid
+                                         pts:CMTimeMake(pts90kHz, 90000)
+                                         dts:kCMTimeInvalid
+                             isDiscontinuous:NO
+                          isRandomAccessPoint:NO
+                                  streamType:streamType
+                                  descriptors:nil
+                              compressedData:[NSMutableData dataWithLength:100]];
+}
+
+/// PTS of the PES packets started on a PID.
+static NSArray<NSNumber*> *extractPts(NSArray<NSData*> *packets, uint16_t targetPid) {
+    NSMutableArray<NSNumber*> *ptsValues = [NSMutableArray array];
+    for (NSData *packet in packets) {
+        const uint8_t *bytes = packet.bytes;
+        const uint16_t pid = ((bytes[1] & 0x1F) << 8) | bytes[2];
+        if (pid != targetPid || !(bytes[1] & 0x40)) continue;
+
+        const uint8_t adaptationControl = (bytes[3] & 0x30) >> 4;
+        const uint8_t *p = bytes + 4 + (adaptationControl == 0x03 ? 1 + bytes[4] : 0);
+        const uint64_t pts = ((uint64_t)(p[9] & 0x0E) << 29)
+                           | ((uint64_t)p[10] << 22)
+                           | ((uint64_t)(p[11] & 0xFE) << 14)
+                           | ((uint64_t)p[12] << 7)
+                           | (p[13] >> 1);
+        [ptsValues addObject:@(pts)];
+    }
+    return ptsValues;
+}
+
+static TSMuxerSettings *makeSettings(void) {
+    TSMuxerSettings *settings = [[TSMuxerSettings alloc] init];
+    settings.pmtPid = 4096;
+    settings.pcrPid = 256;
+    settings.videoPid = 256;
+    settings.audioPid = 257;
+    settings.psiIntervalMs = 250;
+    settings.pcrIntervalMs = 30;
+    return settings;
+}
+
+#pragma mark - Tests
+
+@interface TSMuxerSubmissionTests : XCTestCase
+@end
+
+@implementation TSMuxerSubmissionTests
+
+- (void)test_submitFromManyThreads_tickDrainsAllInDtsOrder {
+    TSMuxerSubmissionTestDelegate *delegate = [[TSMuxerSubmissionTestDelegate alloc] init];
+    __block uint64_t mockTimeNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:makeSettings() wallClockNanos:^{ return mockTimeNanos; } delegate:delegate];
+
+    // One producer per PID, all pushing at once
+    const uint16_t pids[] = { 256, 257, 258, 259 };
+    const int64_t count = 500;
+    dispatch_apply(4, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        const uint8_t streamType = i == 0 ? kRawStreamTypeH264 : kRawStreamTypeADTSAAC;
+        for (int64_t n = 0; n < count; n++) {
+            [muxer submitAccessUnit:makeAU(pids[i], streamType, 90000 + n * 3000)];
+        }
+    });
+    XCTAssertEqual(muxer.submittedAccessUnitCount, (NSUInteger)(4 * count));
+    XCTAssertEqual(delegate.packets.count, (NSUInteger)0);
+
+    [muxer tick];
+    XCTAssertEqual(muxer.submittedAccessUnitCount, (NSUInteger)0);
+    XCTAssertEqual(muxer.queuedAccessUnitCount, (NSUInteger)0);
+    XCTAssertEqual(muxer.droppedAccessUnitCount, (uint64_t)0);
+
+    for (size_t i = 0; i < 4; i++) {
+        NSArray<NSNumber*> *ptsValues = extractPts(delegate.packets, pids[i]);
+        XCTAssertEqual(ptsValues.count, (NSUInteger)count);
+        for (NSUInteger n = 0; n < ptsValues.count; n++) {
+            XCTAssertEqual(ptsValues[n].longLongValue, (long long)(n * 3000));
+        }
+    }
+}
+
+- (void)test_submit_overflowDropsOldestAndCounts {
+    TSMuxerSubmissionTestDelegate *delegate = [[TSMuxerSubmissionTestDelegate alloc] init];
+    TSMuxerSettings *settings = makeSettings();
+    settings.maxNumQueuedAccessUnits = 10;
+    __block uint64_t mockTimeNanos = 1000000000ULL;
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:settings wallClockNanos:^{ return mockTimeNanos; } delegate:delegate];
+
+    for (int64_t n = 0; n < 25; n++) {
+        [muxer submitAccessUnit:makeAU(256, kRawStreamTypeH264, 90000 + n * 3000)];
+    }
+    [muxer tick];
+
+    XCTAssertEqual(muxer.droppedAccessUnitCount, (uint64_t)15);
+    NSArray<NSNumber*> *ptsValues = extractPts(delegate.packets, 256);
+    XCTAssertEqual(ptsValues.count, (NSUInteger)10);
+    // The newest are kept; the timestamps start at the first one muxed
+    XCTAssertEqual(ptsValues.lastObject.longLongValue, (long long)(9 * 3000));
+}
+
+- (void)test_submit_rejectsInvalidPid {
+    TSMuxer *muxer = [[TSMuxer alloc] initWithSettings:makeSettings() wallClockNanos:^{ return (uint64_t)0; } delegate:nil];
+    XCTAssertThrows([muxer submitAccessUnit:makeAU(4096, kRawStreamTypeH264, 0)]);
+    XCTAssertEqual(muxer.submittedAccessUnitCount, (NSUInteger)0);
+}
+
+@end
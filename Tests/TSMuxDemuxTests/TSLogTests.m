@@ -0,0 +1,88 @@
+//
+//  TSLogTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for asynchronous, rate limited logging.
+//
+
+#import <XCTest/XCTest.h>
+@import TSMuxDemux;
+
+@interface TSLogTests : XCTestCase
+@property (nonatomic, strong) NSMutableArray<NSString *> *messages;
+@end
+
+@implementation TSLogTests
+
+- (void)setUp {
+    [super setUp];
+    [TSLog flush];
+    self.messages = [NSMutableArray array];
+    NSMutableArray<NSString *> *messages = self.messages;
+    [TSLog setLogSinkBlock:^(TSLogLevel level, NSString *className, NSString *message, NSTimeInterval timestamp) {
+        if ([className isEqualToString:@"TSLogTests"]) {
+            @synchronized (messages) {
+                [messages addObject:message];
+            }
+        }
+    }];
+}
+
+- (void)tearDown {
+    [TSLog flush];
+    [TSLog setLogSinkBlock:nil];
+    [TSLog setRateLimitBurst:20 perSecond:10];
+    [TSLog setAsynchronous:YES];
+    [super tearDown];
+}
+
+- (void)test_async_formatsCopiedArguments {
+    NSMutableString *mutable = [NSMutableString stringWithString:@"obj"];
+    char buffer[8] = "cstr";
+    TSLogInfo(@"%d %5.2f %@ %s %*d %llx %hhu %zu %c %%", -3, 3.14159, mutable, buffer, 4, 7,
+              0xabcULL, (unsigned char)200, (size_t)42, 'z');
+    // Changing the arguments after the call does not change the message
+    [mutable setString:@"changed"];
+    buffer[0] = 'X';
+    [TSLog flush];
+
+    XCTAssertEqualObjects(self.messages, (@[@"-3  3.14 obj cstr    7 abc 200 42 z %"]));
+}
+
+- (void)test_async_fallsBackForPositionalArguments {
+    TSLogInfo(@"%2$@ %1$@", @"world", @"hello");
+    [TSLog flush];
+    XCTAssertEqualObjects(self.messages, (@[@"hello world"]));
+}
+
+- (void)test_sync_deliversOnCallingThread {
+    [TSLog setAsynchronous:NO];
+    TSLogInfo(@"now %d", 1);
+    XCTAssertEqualObjects(self.messages, (@[@"now 1"]));
+}
+
+- (void)test_rateLimit_suppressesAndSummarizesPerSite {
+    // Synchronous: no background drain, so the summary is printed by the flush and nothing else
+    [TSLog setAsynchronous:NO];
+    [TSLog setRateLimitBurst:3 perSecond:0.001];
+    for (int i = 0; i < 10; i++) {
+        TSLogInfo(@"burst %d", i);
+    }
+    // Another call site has its own bucket
+    TSLogInfo(@"other");
+    [TSLog flush];
+
+    XCTAssertEqualObjects(self.messages, (@[@"burst 0", @"burst 1", @"burst 2", @"other",
+                                            @"7 messages suppressed: \"burst %d\""]));
+}
+
+- (void)test_rateLimit_disabled {
+    [TSLog setRateLimitBurst:1 perSecond:0];
+    for (int i = 0; i < 5; i++) {
+        TSLogInfo(@"unlimited %d", i);
+    }
+    [TSLog flush];
+    XCTAssertEqual(self.messages.count, (NSUInteger)5);
+}
+
+@end
@@ -0,0 +1,282 @@
+//
+//  TSProgramExtractorTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for packet-level program extraction (MPTS to SPTS).
+//
+
+#import <XCTest/XCTest.h>
+#import "TSTestUtils.h"
+@import TSMuxDemux;
+
+static const uint16_t kProgram1PmtPid = 0x100;
+static const uint16_t kProgram1VideoPid = 0x101;
+static const uint16_t kProgram1AudioPid = 0x102;
+static const uint16_t kProgram2PmtPid = 0x200;
+static const uint16_t kProgram2VideoPid = 0x201;
+
+#pragma mark - Test Delegate
+
+@interface TSProgramExtractorTestDelegate : NSObject <TSProgramExtractorDelegate, TSDemuxerDelegate>
+@property (nonatomic, strong) NSMutableData *output;
+@property (nonatomic, strong) NSMutableArray<TSAccessUnit *> *receivedAccessUnits;
+@property (nonatomic, strong) NSMutableArray<TSProgramAssociationTable *> *receivedPats;
+@end
+
+@implementation TSProgramExtractorTestDelegate
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _output = [NSMutableData data];
+        _receivedAccessUnits = [NSMutableArray array];
+        _receivedPats = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)programExtractor:(TSProgramExtractor *)extractor didOutputTsPacketData:(NSData *)tsPacketData {
+    XCTAssertEqual(tsPacketData.length, (NSUInteger)TS_PACKET_SIZE_188);
+    [self.output appendData:tsPacketData];
+}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePat:(TSProgramAssociationTable *)pat previousPat:(TSProgramAssociationTable *)previousPat {
+    [self.receivedPats addObject:pat];
+}
+- (void)demuxer:(TSDemuxer *)demuxer didReceivePmt:(TSProgramMapTable *)pmt previousPmt:(TSProgramMapTable *)previousPmt {}
+
+- (void)demuxer:(TSDemuxer *)demuxer didReceiveAccessUnit:(TSAccessUnit *)accessUnit {
+    [self.receivedAccessUnits addObject:accessUnit];
+}
+
+- (NSSet<NSNumber *> *)outputPids {
+    NSMutableSet<NSNumber *> *pids = [NSMutableSet set];
+    const uint8_t *bytes = self.output.bytes;
+    for (NSUInteger offset = 0; offset < self.output.length; offset += TS_PACKET_SIZE_188) {
+        [pids addObject:@(((bytes[offset + 1] & 0x1F) << 8) | bytes[offset + 2])];
+    }
+    return pids;
+}
+
+@end
+
+#pragma mark - Tests
+
+@interface TSProgramExtractorTests : XCTestCase
+@property (nonatomic, strong) TSElementaryStream *video1;
+@property (nonatomic, strong) TSElementaryStream *audio1;
+@property (nonatomic, strong) TSElementaryStream *video2;
+@property (nonatomic) uint8_t psiCc;
+@property (nonatomic) int64_t nextPts;
+@end
+
+@implementation TSProgramExtractorTests
+
+- (void)setUp {
+    [super setUp];
+    self.video1 = [[TSElementaryStream alloc] initWithPid:kProgram1VideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    self.audio1 = [[TSElementaryStream alloc] initWithPid:kProgram1AudioPid streamType:kRawStreamTypeADTSAAC descriptors:nil];
+    self.video2 = [[TSElementaryStream alloc] initWithPid:kProgram2VideoPid streamType:kRawStreamTypeH264 descriptors:nil];
+    self.nextPts = 90000;
+}
+
+- (NSData *)psiWithProgrammes:(NSDictionary<NSNumber *, NSNumber *> *)programmes patVersion:(uint8_t)patVersion {
+    NSMutableData *psi = [NSMutableData data];
+    [psi appendData:[TSTestUtils createPatDataWithProgrammes:programmes versionNumber:patVersion continuityCounter:self.psiCc]];
+    [psi appendData:[TSTestUtils createPmtDataWithPmtPid:kProgram1PmtPid
+                                           programNumber:1
+                                                  pcrPid:kProgram1VideoPid
+                                                 streams:@[self.video1, self.audio1]
+                                           versionNumber:0
+                                       continuityCounter:self.psiCc]];
+    [psi appendData:[TSTestUtils createPmtDataWithPmtPid:kProgram2PmtPid
+                                           programNumber:2
+                                                  pcrPid:kProgram2VideoPid
+                                                 streams:@[self.video2]
+                                           versionNumber:0
+                                       continuityCounter:self.psiCc]];
+    self.psiCc = (self.psiCc + 1) % 16;
+    return psi;
+}
+
+- (NSData *)mptsWithFrameCount:(NSUInteger)count {
+    NSMutableData *stream = [NSMutableData data];
+    NSMutableData *payload = [NSMutableData dataWithLength:400];
+    for (NSUInteger i = 0; i < count; i++) {
+        if (i % 4 == 0) {
+            [stream appendData:[self psiWithProgrammes:@{@1: @(kProgram1PmtPid), @2: @(kProgram2PmtPid)} patVersion:0]];
+        }
+        memset(payload.mutableBytes, (int)i, payload.length);
+        CMTime pts = CMTimeMake(self.nextPts, 90000);
+        [stream appendData:[TSTestUtils createPesDataWithTrack:self.video1 payload:payload pts:pts]];
+        [stream appendData:[TSTestUtils createPesDataWithTrack:self.video2 payload:payload pts:pts]];
+        [stream appendData:[TSTestUtils createPesDataWithTrack:self.audio1 payload:payload pts:pts]];
+        [stream appendData:[TSTestUtils createNullPackets:1 packetSize:TS_PACKET_SIZE_188]];
+        self.nextPts += 3600;
+    }
+    return stream;
+}
+
+- (TSProgramExtractorTestDelegate *)demux:(NSData *)data {
+    TSProgramExtractorTestDelegate *delegate = [[TSProgramExtractorTestDelegate alloc] init];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+    [demuxer demux:data dataArrivalHostTimeNanos:0];
+    return delegate;
+}
+
+- (void)test_extract_forwardsSelectedProgramOnly {
+    NSData *mpts = [self mptsWithFrameCount:8];
+    TSProgramExtractorTestDelegate *delegate = [[TSProgramExtractorTestDelegate alloc] init];
+    TSProgramExtractor *extractor = [[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet setWithObject:@1]
+                                                                              pidRemap:nil
+                                                                              delegate:delegate];
+    [extractor extract:mpts];
+
+    NSSet *expectedPids = [NSSet setWithArray:@[@(PID_PAT), @(kProgram1PmtPid), @(kProgram1VideoPid), @(kProgram1AudioPid)]];
+    XCTAssertEqualObjects([delegate outputPids], expectedPids, @"Other programs and null packets should be dropped");
+
+    TSProgramExtractorTestDelegate *spts = [self demux:delegate.output];
+    XCTAssertEqual(spts.receivedPats.count, (NSUInteger)1);
+    XCTAssertEqualObjects(spts.receivedPats.firstObject.programmes, @{@1: @(kProgram1PmtPid)});
+
+    TSProgramExtractorTestDelegate *source = [self demux:mpts];
+    NSMutableArray<TSAccessUnit *> *expected = [NSMutableArray array];
+    for (TSAccessUnit *accessUnit in source.receivedAccessUnits) {
+        if (accessUnit.pid != kProgram2VideoPid) {
+            [expected addObject:accessUnit];
+        }
+    }
+    XCTAssertEqual(spts.receivedAccessUnits.count, expected.count);
+    for (NSUInteger i = 0; i < MIN(expected.count, spts.receivedAccessUnits.count); i++) {
+        XCTAssertEqual(spts.receivedAccessUnits[i].pid, expected[i].pid);
+        XCTAssertEqualObjects(spts.receivedAccessUnits[i].compressedData, expected[i].compressedData);
+    }
+    XCTAssertEqual([spts.receivedAccessUnits.firstObject pid], kProgram1VideoPid);
+}
+
+- (void)test_extract_elementaryStreamPacketsAreUntouched {
+    NSData *mpts = [self mptsWithFrameCount:4];
+    TSProgramExtractorTestDelegate *delegate = [[TSProgramExtractorTestDelegate alloc] init];
+    TSProgramExtractor *extractor = [[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet setWithObject:@1]
+                                                                              pidRemap:nil
+                                                                              delegate:delegate];
+    [extractor extract:mpts];
+
+    NSMutableData *sourceVideo = [NSMutableData data];
+    NSMutableData *outputVideo = [NSMutableData data];
+    for (NSData *data in @[mpts, delegate.output]) {
+        const uint8_t *bytes = data.bytes;
+        for (NSUInteger offset = 0; offset < data.length; offset += TS_PACKET_SIZE_188) {
+            if ((((bytes[offset + 1] & 0x1F) << 8) | bytes[offset + 2]) == kProgram1VideoPid) {
+                [(data == mpts ? sourceVideo : outputVideo) appendBytes:bytes + offset length:TS_PACKET_SIZE_188];
+            }
+        }
+    }
+    XCTAssertGreaterThan(sourceVideo.length, (NSUInteger)0);
+    XCTAssertEqualObjects(outputVideo, sourceVideo);
+}
+
+- (void)test_extract_m2tsInput_outputs188BytePackets {
+    NSData *mpts = [self mptsWithFrameCount:4];
+    // Same packets with a 4-byte TP_extra_header each
+    NSMutableData *m2ts = [NSMutableData data];
+    for (NSUInteger offset = 0; offset < mpts.length; offset += TS_PACKET_SIZE_188) {
+        const uint32_t arrivalTimestamp = CFSwapInt32HostToBig((uint32_t)offset);
+        [m2ts appendBytes:&arrivalTimestamp length:sizeof(arrivalTimestamp)];
+        [m2ts appendBytes:(const uint8_t *)mpts.bytes + offset length:TS_PACKET_SIZE_188];
+    }
+
+    NSMutableArray<NSData *> *outputs = [NSMutableArray array];
+    for (NSData *input in @[mpts, m2ts]) {
+        TSProgramExtractorTestDelegate *delegate = [[TSProgramExtractorTestDelegate alloc] init];
+        TSProgramExtractor *extractor = [[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet setWithObject:@1]
+                                                                                  pidRemap:nil
+                                                                                  delegate:delegate];
+        [extractor extract:input];
+        [outputs addObject:delegate.output];
+    }
+    XCTAssertGreaterThan(outputs[0].length, (NSUInteger)0);
+    XCTAssertEqualObjects(outputs[1], outputs[0]);
+}
+
+- (void)test_extract_remapsPids {
+    NSData *mpts = [self mptsWithFrameCount:5];
+    TSProgramExtractorTestDelegate *delegate = [[TSProgramExtractorTestDelegate alloc] init];
+    TSProgramExtractor *extractor = [[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet setWithObject:@1]
+                                                                              pidRemap:@{@(kProgram1PmtPid): @0x300,
+                                                                                         @(kProgram1VideoPid): @0x301}
+                                                                              delegate:delegate];
+    [extractor extract:mpts];
+
+    NSSet *expectedPids = [NSSet setWithArray:@[@(PID_PAT), @0x300, @0x301, @(kProgram1AudioPid)]];
+    XCTAssertEqualObjects([delegate outputPids], expectedPids);
+
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:nil mode:TSDemuxerModeDVB];
+    [demuxer demux:delegate.output dataArrivalHostTimeNanos:0];
+    XCTAssertEqualObjects(demuxer.pat.programmes, @{@1: @0x300});
+    TSProgramMapTable *pmt = demuxer.pmts[@1];
+    XCTAssertEqual(pmt.pcrPid, (uint16_t)0x301);
+    XCTAssertNotNil([pmt elementaryStreamWithPid:0x301]);
+    XCTAssertNotNil([pmt elementaryStreamWithPid:kProgram1AudioPid]);
+    XCTAssertEqual([pmt elementaryStreamWithPid:0x301].streamType, kRawStreamTypeH264);
+    XCTAssertEqual(demuxer.statistics.prio1.ccError, (uint64_t)0);
+}
+
+- (void)test_extract_patVersionFollowsOutputChanges {
+    TSProgramExtractorTestDelegate *delegate = [[TSProgramExtractorTestDelegate alloc] init];
+    TSProgramExtractor *extractor = [[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet setWithObject:@1]
+                                                                              pidRemap:nil
+                                                                              delegate:delegate];
+    TSDemuxer *demuxer = [[TSDemuxer alloc] initWithDelegate:delegate mode:TSDemuxerModeDVB];
+
+    [extractor extract:[self psiWithProgrammes:@{@1: @(kProgram1PmtPid), @2: @(kProgram2PmtPid)} patVersion:0]];
+    // Program 2 leaves the source PAT - the output PAT is unchanged
+    [extractor extract:[self psiWithProgrammes:@{@1: @(kProgram1PmtPid)} patVersion:1]];
+    [demuxer demux:delegate.output dataArrivalHostTimeNanos:0];
+    XCTAssertEqual(delegate.receivedPats.count, (NSUInteger)1);
+    XCTAssertEqual(demuxer.pat.psi.versionNumber, (uint8_t)0);
+
+    // Program 1 moves its PMT - the output PAT gets a new version
+    [delegate.output setLength:0];
+    NSMutableData *moved = [NSMutableData data];
+    [moved appendData:[TSTestUtils createPatDataWithProgrammes:@{@1: @0x110} versionNumber:2 continuityCounter:self.psiCc]];
+    [moved appendData:[TSTestUtils createPmtDataWithPmtPid:0x110
+                                             programNumber:1
+                                                    pcrPid:kProgram1VideoPid
+                                                   streams:@[self.video1]
+                                             versionNumber:1
+                                         continuityCounter:0]];
+    [extractor extract:moved];
+    [demuxer demux:delegate.output dataArrivalHostTimeNanos:0];
+
+    XCTAssertEqual(delegate.receivedPats.count, (NSUInteger)2);
+    XCTAssertEqual(demuxer.pat.psi.versionNumber, (uint8_t)1);
+    XCTAssertEqualObjects(demuxer.pat.programmes, @{@1: @0x110});
+    XCTAssertNotNil(demuxer.pmts[@1]);
+    XCTAssertNil([demuxer.pmts[@1] elementaryStreamWithPid:kProgram1AudioPid]);
+}
+
+- (void)test_extract_keepsNullPacketsWhenAsked {
+    TSProgramExtractorTestDelegate *delegate = [[TSProgramExtractorTestDelegate alloc] init];
+    TSProgramExtractor *extractor = [[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet setWithObject:@2]
+                                                                              pidRemap:nil
+                                                                              delegate:delegate];
+    extractor.removeNullPackets = NO;
+    [extractor extract:[self mptsWithFrameCount:2]];
+
+    NSSet *expectedPids = [NSSet setWithArray:@[@(PID_PAT), @(kProgram2PmtPid), @(kProgram2VideoPid), @(PID_NULL_PACKET)]];
+    XCTAssertEqualObjects([delegate outputPids], expectedPids);
+}
+
+- (void)test_extract_invalidSettingsThrow {
+    XCTAssertThrows([[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet set] pidRemap:nil delegate:nil]);
+    XCTAssertThrows([[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet setWithObject:@0] pidRemap:nil delegate:nil]);
+    XCTAssertThrows([[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet setWithObject:@1]
+                                                              pidRemap:@{@0x100: @(PID_PAT)}
+                                                              delegate:nil]);
+    XCTAssertThrows([[TSProgramExtractor alloc] initWithProgramNumbers:[NSSet setWithObject:@1]
+                                                              pidRemap:@{@0x100: @0x300, @0x101: @0x300}
+                                                              delegate:nil]);
+}
+
+@end
@@ -0,0 +1,81 @@
+//
+//  TSStartCodeScannerTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for the vectorised start code scanner.
+//
+
+#import <XCTest/XCTest.h>
+@import TSMuxDemux;
+
+@interface TSStartCodeScannerTests : XCTestCase
+@end
+
+@implementation TSStartCodeScannerTests
+
+/// Reference implementation used to validate the vectorised paths.
+static NSUInteger naiveFind(const uint8_t *bytes, NSUInteger length, NSUInteger from) {
+    for (NSUInteger i = from; i + 2 < length; i++) {
+        if (bytes[i] == 0 && bytes[i + 1] == 0 && bytes[i + 2] == 1) {
+            return i;
+        }
+    }
+    return NSNotFound;
+}
+
+- (void)test_emptyAndShortInput_notFound {
+    uint8_t bytes[] = {0x00, 0x00};
+    XCTAssertEqual(TSFindStartCode(bytes, 0), NSNotFound);
+    XCTAssertEqual(TSFindStartCode(bytes, 2), NSNotFound);
+}
+
+- (void)test_startCodeAtBeginning {
+    uint8_t bytes[] = {0x00, 0x00, 0x01, 0x09, 0xF0};
+    XCTAssertEqual(TSFindStartCode(bytes, sizeof(bytes)), (NSUInteger)0);
+}
+
+- (void)test_fourByteStartCode_reportedAtSecondZero {
+    uint8_t bytes[] = {0xAA, 0x00, 0x00, 0x00, 0x01, 0x67};
+    XCTAssertEqual(TSFindStartCode(bytes, sizeof(bytes)), (NSUInteger)2);
+}
+
+- (void)test_startCodeStraddlingVectorBoundary {
+    uint8_t bytes[64];
+    memset(bytes, 0xFF, sizeof(bytes));
+    bytes[15] = 0x00;
+    bytes[16] = 0x00;
+    bytes[17] = 0x01;
+    XCTAssertEqual(TSFindStartCode(bytes, sizeof(bytes)), (NSUInteger)15);
+}
+
+- (void)test_startCodeInTail {
+    uint8_t bytes[37];
+    memset(bytes, 0x42, sizeof(bytes));
+    bytes[34] = 0x00;
+    bytes[35] = 0x00;
+    bytes[36] = 0x01;
+    XCTAssertEqual(TSFindStartCode(bytes, sizeof(bytes)), (NSUInteger)34);
+}
+
+- (void)test_fromOffset_skipsEarlierStartCodes {
+    uint8_t bytes[] = {0x00, 0x00, 0x01, 0x65, 0x00, 0x00, 0x01, 0x41};
+    XCTAssertEqual(TSFindStartCodeFromOffset(bytes, sizeof(bytes), 1), (NSUInteger)4);
+    XCTAssertEqual(TSFindStartCodeFromOffset(bytes, sizeof(bytes), 5), NSNotFound);
+}
+
+- (void)test_randomData_matchesNaiveScan {
+    uint8_t bytes[512];
+    srand(7);
+    for (int iteration = 0; iteration < 2000; iteration++) {
+        const NSUInteger length = (NSUInteger)(rand() % sizeof(bytes));
+        for (NSUInteger i = 0; i < length; i++) {
+            // Bias towards 0x00/0x01 so start codes actually occur
+            const int r = rand() % 8;
+            bytes[i] = r < 3 ? 0x00 : (r < 5 ? 0x01 : (uint8_t)rand());
+        }
+        const NSUInteger from = length > 0 ? (NSUInteger)(rand() % length) : 0;
+        XCTAssertEqual(TSFindStartCodeFromOffset(bytes, length, from), naiveFind(bytes, length, from));
+    }
+}
+
+@end
@@ -0,0 +1,78 @@
+//
+//  TSStringEncodingUtilTests.m
+//  TSMuxDemuxTests
+//
+//  Tests for DVB text decoding and the string intern cache.
+//
+
+#import <XCTest/XCTest.h>
+@import TSMuxDemux;
+
+@interface TSStringEncodingUtilTests : XCTestCase
+@end
+
+@implementation TSStringEncodingUtilTests
+
+- (void)test_defaultTable_decodesAsUtf8 {
+    const uint8_t bytes[] = { 'S', 'V', 'T', '1' };
+    XCTAssertEqualObjects([TSStringEncodingUtil dvbStringFromBytes:bytes length:sizeof(bytes)], @"SVT1");
+}
+
+- (void)test_utf8Table_skipsSelectionByte {
+    const uint8_t bytes[] = { 0x15, 0xC3, 0xA5, 'k' };
+    XCTAssertEqualObjects([TSStringEncodingUtil dvbStringFromBytes:bytes length:sizeof(bytes)], @"åk");
+}
+
+- (void)test_dynamicallySelectedLatin1_skipsThreeBytes {
+    const uint8_t bytes[] = { 0x10, 0x00, 0x01, 0xE9, 't', 0xE9 };
+    XCTAssertEqualObjects([TSStringEncodingUtil dvbStringFromBytes:bytes length:sizeof(bytes)], @"été");
+}
+
+- (void)test_emptyInput_returnsEmptyString {
+    XCTAssertEqualObjects([TSStringEncodingUtil dvbStringFromBytes:NULL length:0], @"");
+    XCTAssertEqualObjects([TSStringEncodingUtil dvbStringFromCharData:nil], @"");
+    const uint8_t utf8Only[] = { 0x15 };
+    XCTAssertEqualObjects([TSStringEncodingUtil dvbStringFromBytes:utf8Only length:sizeof(utf8Only)], @"");
+}
+
+- (void)test_charDataAndBytes_decodeTheSame {
+    const uint8_t bytes[] = { 0x05, 'I', 's', 't', 'a', 'n', 'b', 'u', 'l' };
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+    XCTAssertEqualObjects([TSStringEncodingUtil dvbStringFromCharData:data],
+                          [TSStringEncodingUtil dvbStringFromBytes:bytes length:sizeof(bytes)]);
+}
+
+- (void)test_repeatedBytes_returnInternedString {
+    uint8_t bytes[] = { 0x15, 'N', 'e', 'w', 's', ' ', '2', '4' };
+    NSString *first = [TSStringEncodingUtil dvbStringFromBytes:bytes length:sizeof(bytes)];
+
+    // Same bytes at a different address
+    NSData *copy = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+    NSString *second = [TSStringEncodingUtil dvbStringFromCharData:copy];
+    XCTAssertTrue(first == second);
+
+    // Same text under a different character table selection is a different key
+    bytes[0] = 'X';
+    NSString *third = [TSStringEncodingUtil dvbStringFromBytes:bytes length:sizeof(bytes)];
+    XCTAssertEqualObjects(third, @"XNews 24");
+}
+
+- (void)test_concurrentLookups_returnEqualStrings {
+    dispatch_apply(64, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t iteration) {
+        for (int i = 0; i < 200; ++i) {
+            char text[32];
+            const int length = snprintf(text, sizeof(text), "Service %d", i);
+            NSString *string = [TSStringEncodingUtil dvbStringFromBytes:(const uint8_t *)text length:length];
+            XCTAssertEqualObjects(string, ([NSString stringWithFormat:@"Service %d", i]));
+        }
+    });
+}
+
+- (void)test_longInput_decodedWithoutCaching {
+    NSMutableData *data = [NSMutableData dataWithLength:1000];
+    memset(data.mutableBytes, 'a', data.length);
+    NSString *string = [TSStringEncodingUtil dvbStringFromCharData:data];
+    XCTAssertEqual(string.length, (NSUInteger)1000);
+}
+
+@end